@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+
+/// Benchmark function.
+typedef void (*BenchmarkFunction)();
+
+/// Registers a benchmark with the runner at static initialization.
+class BenchmarkRegistrar
+{
+public:
+    /// Register a benchmark of a suite. Suites are named after their source files.
+    BenchmarkRegistrar(char const* suite, char const* name, BenchmarkFunction function);
+};
+
+/// Time a case of the running benchmark. Run it until at least MinMeasureTime has passed, then print its
+/// fastest run and, if items is nonzero, the time per item.
+void Measure(char const* name, std::function<void()> const& function, unsigned items = 0);
+/// Keep a result alive so the work producing it is not optimized away.
+void KeepResult(uint64_t value);
+
+/// Shortest total time to run a case for, in seconds.
+static const double MinMeasureTime = 0.2;
+
+/// Define a benchmark of a suite. Its body sets up data and measures one or more cases.
+#define BENCHMARK(suite, name) \
+    static void suite##_##name(); \
+    static BenchmarkRegistrar suite##_##name##_registrar(#suite, #name, suite##_##name); \
+    static void suite##_##name()
@@ -0,0 +1,64 @@
+#include "Benchmark.h"
+#include "DescriptorAllocator.h"
+#include "NullDescriptorHeapFactory.h"
+
+#include <vector>
+
+
+/// Descriptors allocated per run.
+static const unsigned descriptorCount = 4096;
+/// Descriptors per table.
+static const unsigned tableSize = 8;
+
+BENCHMARK(DescriptorAllocatorBenchmark, StagingAllocateFree)
+{
+    NullDescriptorHeapFactory factory;
+    StagingDescriptorHeap heap(factory, DESCRIPTOR_HEAP_CBV_SRV_UAV);
+    std::vector<DescriptorAllocation> allocations(descriptorCount);
+
+    // Pages exist after the first run, so the free lists alone are timed
+    Measure("allocate and free", [&]()
+    {
+        for (DescriptorAllocation& allocation : allocations)
+            allocation = heap.Allocate();
+        for (DescriptorAllocation& allocation : allocations)
+            heap.Free(allocation);
+    }, descriptorCount);
+}
+
+BENCHMARK(DescriptorAllocatorBenchmark, CopyToTable)
+{
+    NullDescriptorHeapFactory factory;
+    DescriptorAllocator allocator;
+    allocator.Initialize(factory);
+
+    std::vector<DescriptorAllocation> allocations(descriptorCount);
+    for (DescriptorAllocation& allocation : allocations)
+        allocation = allocator.Allocate(DESCRIPTOR_HEAP_CBV_SRV_UAV);
+
+    // Tables of adjacent descriptors coalesce into one copied range, scattered ones copy a range each
+    std::vector<size_t> adjacent(descriptorCount);
+    std::vector<size_t> scattered(descriptorCount);
+    for (unsigned i = 0; i < descriptorCount; ++i)
+    {
+        adjacent[i] = allocations[i].cpu_;
+        scattered[i] = allocations[(i * 97) % descriptorCount].cpu_;
+    }
+
+    uint64_t fenceValue = 0;
+    for (std::vector<size_t> const* sources : { &adjacent, &scattered })
+    {
+        Measure(sources == &adjacent ? "adjacent tables" : "scattered tables", [&]()
+        {
+            allocator.BeginFrame(fenceValue);
+            for (unsigned i = 0; i < descriptorCount; i += tableSize)
+                KeepResult(allocator.CopyToTable(sources->data() + i, tableSize).gpu_);
+            allocator.EndFrame(++fenceValue);
+        }, descriptorCount / tableSize);
+        KeepResult(allocator.GetStats().ranges_);
+    }
+
+    for (DescriptorAllocation& allocation : allocations)
+        allocator.Free(DESCRIPTOR_HEAP_CBV_SRV_UAV, allocation);
+    allocator.Shutdown();
+}
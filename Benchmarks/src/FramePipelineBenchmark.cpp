@@ -0,0 +1,80 @@
+#include "Benchmark.h"
+#include "FramePipeline.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+
+/// Frames per run.
+static const unsigned frameCount = 256;
+
+/// Return a hash of some iterations of busy work, standing in for simulating or rendering a frame.
+static uint64_t Work(unsigned iterations)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned i = 0; i < iterations; ++i)
+        hash = (hash ^ i) * 1099511628211ull;
+    return hash;
+}
+
+/// Run frames with simulation and rendering taking some iterations of work each.
+static void MeasureFrames(char const* name, unsigned simulateWork, unsigned renderWork)
+{
+    FramePacket packet;
+    std::string serialName = std::string(name) + " serial";
+    Measure(serialName.c_str(), [&]()
+    {
+        for (unsigned i = 0; i < frameCount; ++i)
+        {
+            packet.frameNumber_ = Work(simulateWork);
+            KeepResult(Work(renderWork) + packet.frameNumber_);
+        }
+    }, frameCount);
+
+    // Packets are stamped with the time they are published, in seconds from the start
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    auto secondsSinceStart = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    double latencySum = 0.0;
+    double latencyMax = 0.0;
+    uint64_t latencyCount = 0;
+
+    // The simulation thread runs ahead into free packets between runs, which only hides its start
+    FramePipeline pipeline;
+    pipeline.Start([&](FramePacket& simulated)
+    {
+        simulated.frameNumber_ = Work(simulateWork);
+        simulated.time_ = secondsSinceStart();
+    });
+    std::string pipelinedName = std::string(name) + " pipelined";
+    Measure(pipelinedName.c_str(), [&]()
+    {
+        for (unsigned i = 0; i < frameCount; ++i)
+        {
+            FramePacket const* rendered = pipeline.AcquirePacket();
+            // Packets published before the run waited on the benchmark, not on rendering
+            if (i >= FramePipeline::PacketCount)
+            {
+                double latency = secondsSinceStart() - rendered->time_;
+                latencySum += latency;
+                latencyMax = latency > latencyMax ? latency : latencyMax;
+                ++latencyCount;
+            }
+            KeepResult(Work(renderWork) + rendered->frameNumber_);
+            pipeline.ReleasePacket(rendered);
+        }
+    }, frameCount);
+    pipeline.Stop();
+
+    // Time from the simulation publishing a packet to the render thread acquiring it
+    printf("%s packet latency: %.2f us average, %.2f us max\n", name, latencyCount ? latencySum * 1e6 / (double) latencyCount : 0.0,
+        latencyMax * 1e6);
+}
+
+BENCHMARK(FramePipelineBenchmark, Frames)
+{
+    // Empty frames leave only the cost of handing packets between the threads
+    MeasureFrames("empty", 0, 0);
+    MeasureFrames("balanced", 20000, 20000);
+    MeasureFrames("render bound", 5000, 20000);
+}
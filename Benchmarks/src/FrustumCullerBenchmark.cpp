@@ -0,0 +1,51 @@
+#include "Benchmark.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+
+/// Objects per run.
+static const unsigned objectCount = 65536;
+
+BENCHMARK(FrustumCullerBenchmark, Cull)
+{
+    // Boxes scattered around a camera at the origin looking down +z, so about a tenth are visible
+    std::mt19937 random(21);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 5.0f);
+    FrustumCuller culler;
+    culler.Resize(objectCount);
+    for (unsigned i = 0; i < objectCount; ++i)
+    {
+        culler.SetBounds(i, BoundingBox(Vector3(position(random), position(random), position(random)),
+            Vector3(extent(random), extent(random), extent(random))));
+    }
+    Matrix4 view = Matrix4::LookAt(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(view * Matrix4::Perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f));
+    std::vector<unsigned> visible;
+
+    Measure("scalar reference", [&]()
+    {
+        KeepResult(culler.CullReference(frustum, visible));
+    }, objectCount);
+    Measure("simd inline", [&]()
+    {
+        KeepResult(culler.Cull(frustum, visible));
+    }, objectCount);
+
+    // Batches of 8192 objects, eight jobs on three workers and the calling thread
+    JobSystem jobSystem(3);
+    culler.SetJobSystem(&jobSystem);
+    Measure("simd jobs", [&]()
+    {
+        KeepResult(culler.Cull(frustum, visible));
+    }, objectCount);
+    culler.SetJobSystem(nullptr);
+
+    CullStats const& stats = culler.GetStats();
+    printf("%u of %u visible, %u rejected by sphere, %u by box, %u jobs\n", stats.visible_, stats.objects_,
+        stats.sphereCulled_, stats.boxCulled_, stats.jobs_);
+}
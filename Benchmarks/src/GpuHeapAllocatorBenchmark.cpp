@@ -0,0 +1,85 @@
+#include "Benchmark.h"
+#include "GpuHeapAllocator.h"
+#include "NullGpuHeapFactory.h"
+#include "TlsfAllocator.h"
+
+#include <random>
+#include <vector>
+
+
+/// Allocations replaced per run.
+static const unsigned churnCount = 4096;
+/// Live allocations while churning.
+static const unsigned liveCount = 1024;
+
+/// Return random allocation sizes between 256 bytes and 1 MB, weighted towards small ones.
+static std::vector<uint64_t> MakeSizes(unsigned count)
+{
+    std::mt19937 random(8);
+    std::vector<uint64_t> sizes(count);
+    for (uint64_t& size : sizes)
+        size = (uint64_t) 256 << (random() % 13);
+    return sizes;
+}
+
+BENCHMARK(GpuHeapAllocatorBenchmark, TlsfChurn)
+{
+    std::vector<uint64_t> sizes = MakeSizes(churnCount);
+
+    // An empty range, then one whose free space is cut into thousands of holes: free lists keep both constant time
+    for (bool fragmented : { false, true })
+    {
+        TlsfAllocator allocator(1024ull * 1024 * 1024);
+        std::vector<TlsfAllocation> holes;
+        if (fragmented)
+        {
+            for (unsigned i = 0; i < 16384; ++i)
+                holes.push_back(allocator.Allocate(sizes[i % churnCount] / 2));
+            for (unsigned i = 0; i < holes.size(); i += 2)
+                allocator.Free(holes[i]);
+        }
+
+        std::vector<TlsfAllocation> live(liveCount);
+        for (unsigned i = 0; i < liveCount; ++i)
+            live[i] = allocator.Allocate(sizes[i]);
+
+        Measure(fragmented ? "fragmented" : "empty", [&]()
+        {
+            for (unsigned i = 0; i < churnCount; ++i)
+            {
+                TlsfAllocation& allocation = live[(i * 7) % liveCount];
+                allocator.Free(allocation);
+                allocation = allocator.Allocate(sizes[i]);
+            }
+        }, churnCount);
+        KeepResult(allocator.GetFreeRegionCount());
+    }
+}
+
+BENCHMARK(GpuHeapAllocatorBenchmark, PlacedChurn)
+{
+    NullGpuHeapFactory factory;
+    GpuHeapAllocator allocator;
+    allocator.Initialize(factory);
+    std::vector<uint64_t> sizes = MakeSizes(churnCount);
+
+    // Textures at the default 64 KB placement alignment, spread over heap blocks of the default size
+    std::vector<GpuAllocation> live(liveCount);
+    for (unsigned i = 0; i < liveCount; ++i)
+        live[i] = allocator.Allocate(GPU_HEAP_TEXTURES, sizes[i], 65536);
+
+    Measure("textures", [&]()
+    {
+        for (unsigned i = 0; i < churnCount; ++i)
+        {
+            GpuAllocation& allocation = live[(i * 7) % liveCount];
+            allocator.Free(allocation);
+            allocation = allocator.Allocate(GPU_HEAP_TEXTURES, sizes[i], 65536);
+        }
+    }, churnCount);
+    KeepResult(allocator.GetTotalStats().blocks_);
+
+    for (GpuAllocation& allocation : live)
+        allocator.Free(allocation);
+    allocator.Shutdown();
+}
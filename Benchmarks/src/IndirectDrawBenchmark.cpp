@@ -0,0 +1,100 @@
+#include "Benchmark.h"
+#include "IndirectDraw.h"
+#include "Matrix.h"
+#include "NullGraphicsBackend.h"
+#include "ObjectBuffer.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+
+/// Objects drawn per frame.
+static const unsigned objectCount = 16384;
+
+BENCHMARK(IndirectDrawBenchmark, Draws)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullCommandList commandList(backend);
+    std::vector<unsigned> objects(objectCount);
+    for (unsigned i = 0; i < objectCount; ++i)
+        objects[i] = i;
+
+    // Every object its own draw, binding its data first, as the render queue records them
+    Measure("draw per object", [&]()
+    {
+        commandList.Reset(0);
+        for (unsigned i = 0; i < objectCount; ++i)
+        {
+            commandList.SetDescriptorTable(0, 0x10000 + (uint64_t) i * sizeof(Matrix4));
+            commandList.DrawInstanced(36, 1, 0, 0);
+        }
+        commandList.Close();
+    }, objectCount);
+
+    IndirectDrawBatch batch;
+    IndirectDrawState state;
+    state.commandSignature_ = (CommandSignatureHandle) (uintptr_t) 0x100;
+    batch.SetState(state);
+    for (unsigned i = 0; i < objectCount; ++i)
+        batch.SetMesh(i, { 36, (i % 64) * 36, 0 });
+
+    // A frame of the backend brackets the build so the upload ring reclaims, the empty frame being its share
+    Measure("empty frame", [&]()
+    {
+        backend.Begin();
+        backend.End();
+    });
+    Measure("build and execute indirect", [&]()
+    {
+        backend.Begin();
+        commandList.Reset(0);
+        if (batch.Build(objects, backend.GetUploadRing()))
+            batch.Execute(commandList, 0x10000);
+        commandList.Close();
+        backend.End();
+    }, objectCount);
+    KeepResult(batch.GetDrawCount());
+}
+
+BENCHMARK(IndirectDrawBenchmark, PatchObjects)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullCommandList commandList(backend);
+    ObjectBuffer objectBuffer;
+    objectBuffer.Initialize(backend, sizeof(Matrix4));
+
+    Matrix4 transform;
+    backend.Begin();
+    for (unsigned i = 0; i < objectCount; ++i)
+        objectBuffer.Set(i, &transform);
+    commandList.Reset(0);
+    objectBuffer.Upload(commandList);
+    commandList.Close();
+    backend.End();
+
+    // Objects moving each frame, scattered over the buffer
+    std::mt19937 random(24);
+    for (unsigned divisor : { 100u, 10u, 1u })
+    {
+        std::vector<unsigned> changed(objectCount / divisor);
+        for (unsigned& index : changed)
+            index = random() % objectCount;
+
+        char const* name = divisor == 100 ? "1% changed" : divisor == 10 ? "10% changed" : "all changed";
+        Measure(name, [&]()
+        {
+            backend.Begin();
+            for (unsigned index : changed)
+                objectBuffer.Set(index, &transform);
+            commandList.Reset(0);
+            objectBuffer.Upload(commandList);
+            commandList.Close();
+            backend.End();
+        }, (unsigned) changed.size());
+        ObjectBufferStats const& stats = objectBuffer.GetStats();
+        printf("%u dirty objects, %u copies, %llu bytes%s\n", stats.dirtyObjects_, stats.copies_,
+            (unsigned long long) stats.bytes_, stats.fullUpload_ ? ", full upload" : "");
+    }
+    objectBuffer.Shutdown();
+}
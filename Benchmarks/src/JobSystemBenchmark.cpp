@@ -0,0 +1,105 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+
+/// Parent jobs per run.
+static const unsigned parentCount = 64;
+/// Child jobs per parent.
+static const unsigned childCount = 64;
+/// Iterations of work per child job.
+static const unsigned childWork = 2000;
+
+/// Do some arithmetic that the compiler cannot remove.
+static uint64_t Work(uint64_t seed)
+{
+    uint64_t value = seed;
+    for (unsigned i = 0; i < childWork; ++i)
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    return value;
+}
+
+/// Run the fan-out: parents spawn children with their own counter, wait for them and then combine their results.
+static uint64_t FanOut(JobSystem& jobSystem)
+{
+    uint64_t results[parentCount] = {};
+    JobCounter parents;
+    for (unsigned i = 0; i < parentCount; ++i)
+    {
+        jobSystem.Run([&jobSystem, &results, i]()
+        {
+            uint64_t childResults[childCount];
+            JobCounter children;
+            for (unsigned j = 0; j < childCount; ++j)
+                jobSystem.Run([&childResults, i, j]() { childResults[j] = Work(i * childCount + j); }, &children);
+            jobSystem.Wait(children);
+
+            uint64_t sum = 0;
+            for (unsigned j = 0; j < childCount; ++j)
+                sum += childResults[j];
+            results[i] = sum;
+        }, &parents);
+    }
+    jobSystem.Wait(parents);
+
+    uint64_t sum = 0;
+    for (unsigned i = 0; i < parentCount; ++i)
+        sum += results[i];
+    return sum;
+}
+
+BENCHMARK(JobSystemBenchmark, FanOut)
+{
+    // The same work without jobs, the reference for one thread
+    Measure("1 thread serial", [&]()
+    {
+        uint64_t sum = 0;
+        for (unsigned i = 0; i < parentCount * childCount; ++i)
+            sum += Work(i);
+        KeepResult(sum);
+    }, parentCount * childCount);
+
+    // A job system always has a worker, so the calling thread plus 1..cores - 1 workers
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 2u);
+    for (unsigned workers = 1; workers < cores; ++workers)
+    {
+        JobSystem jobSystem(workers);
+        uint64_t steals = jobSystem.GetStealCount();
+        unsigned runs = 0;
+        std::string name = std::to_string(workers + 1) + " threads";
+        Measure(name.c_str(), [&]()
+        {
+            KeepResult(FanOut(jobSystem));
+            ++runs;
+        }, parentCount * childCount);
+
+        printf("%u threads: %.1f steals per run\n", workers + 1, (double) (jobSystem.GetStealCount() - steals) / runs);
+    }
+}
+
+BENCHMARK(JobSystemBenchmark, ParallelFor)
+{
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 2u);
+    for (unsigned workers = 1; workers < cores; ++workers)
+    {
+        JobSystem jobSystem(workers);
+        std::string name = std::to_string(workers + 1) + " threads";
+        Measure(name.c_str(), [&]()
+        {
+            std::atomic<uint64_t> sum{};
+            jobSystem.ParallelFor(parentCount * childCount, childCount, [&sum](unsigned begin, unsigned end)
+            {
+                uint64_t batchSum = 0;
+                for (unsigned i = begin; i < end; ++i)
+                    batchSum += Work(i);
+                sum.fetch_add(batchSum, std::memory_order_relaxed);
+            });
+            KeepResult(sum.load());
+        }, parentCount * childCount);
+    }
+}
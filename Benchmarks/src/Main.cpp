@@ -0,0 +1,92 @@
+#include "Benchmark.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+/// Registered benchmark
+struct BenchmarkCase
+{
+    /// Suite
+    char const* suite_;
+    /// Name
+    char const* name_;
+    /// Function
+    BenchmarkFunction function_;
+};
+
+/// Return the registered benchmarks, constructed on first use as registrars run before main.
+static std::vector<BenchmarkCase>& GetBenchmarks()
+{
+    static std::vector<BenchmarkCase> benchmarks;
+    return benchmarks;
+}
+
+/// Name of the running benchmark
+static std::string running;
+/// Sink of kept results
+static volatile uint64_t keptResult;
+
+BenchmarkRegistrar::BenchmarkRegistrar(char const* suite, char const* name, BenchmarkFunction function)
+{
+    GetBenchmarks().push_back({ suite, name, function });
+}
+
+void Measure(char const* name, std::function<void()> const& function, unsigned items)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // The fastest run is the one least disturbed by the rest of the system
+    double fastest = 0.0;
+    double total = 0.0;
+    unsigned runs = 0;
+    while (runs < 3 || total < MinMeasureTime)
+    {
+        Clock::time_point start = Clock::now();
+        function();
+        double time = std::chrono::duration<double>(Clock::now() - start).count();
+        fastest = runs ? (time < fastest ? time : fastest) : time;
+        total += time;
+        ++runs;
+    }
+
+    std::string label = running + " " + name;
+    if (items)
+        printf("%-56s %12.2f us %10.2f ns/item\n", label.c_str(), fastest * 1e6, fastest * 1e9 / items);
+    else
+        printf("%-56s %12.2f us\n", label.c_str(), fastest * 1e6);
+    fflush(stdout);
+}
+
+void KeepResult(uint64_t value)
+{
+    keptResult = keptResult + value;
+}
+
+/// Run the benchmarks of the suites named on the command line, all without arguments.
+int main(int argc, char** argv)
+{
+#ifndef NDEBUG
+    printf("Assertions are enabled; time a Release build for representative numbers\n");
+#endif
+
+    unsigned run = 0;
+    for (BenchmarkCase const& benchmark : GetBenchmarks())
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            selected |= !strcmp(argv[i], benchmark.suite_);
+        if (!selected)
+            continue;
+
+        running = std::string(benchmark.suite_) + "." + benchmark.name_;
+        benchmark.function_();
+        ++run;
+    }
+
+    printf("%u benchmarks\n", run);
+    return run ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "OcclusionBuffer.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+
+/// Buildings per row of the city grid.
+static const unsigned buildingsX = 16;
+/// Rows of the city grid.
+static const unsigned buildingsZ = 8;
+/// Objects tested per run.
+static const unsigned objectCount = 65536;
+
+/// Add a box occluder, 12 triangles.
+static void AddBox(OcclusionBuffer& buffer, BoundingBox const& box)
+{
+    Vector3 min = box.GetMin();
+    Vector3 max = box.GetMax();
+    std::vector<Vector3> vertices;
+    for (unsigned i = 0; i < 8; ++i)
+        vertices.push_back(Vector3((i & 1) ? max.x_ : min.x_, (i & 2) ? max.y_ : min.y_, (i & 4) ? max.z_ : min.z_));
+
+    // Two triangles per face
+    std::vector<unsigned> indices{ 0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+        2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3 };
+    buffer.AddOccluder(vertices, indices);
+}
+
+/// Add a grid of buildings of varying height in front of a camera at the origin looking along +Z.
+static void AddCity(OcclusionBuffer& buffer)
+{
+    for (unsigned z = 0; z < buildingsZ; ++z)
+    {
+        for (unsigned x = 0; x < buildingsX; ++x)
+        {
+            float height = 4.0f + (float) ((x * 7 + z * 3) % 5) * 3.0f;
+            Vector3 center(((float) x - buildingsX * 0.5f + 0.5f) * 12.0f, height * 0.5f - 2.0f, 12.0f + (float) z * 12.0f);
+            AddBox(buffer, BoundingBox(center, Vector3(4.0f, height * 0.5f, 4.0f)));
+        }
+    }
+}
+
+/// Return the view-projection of the camera, matching the default buffer aspect.
+static Matrix4 GetViewProjection()
+{
+    Matrix4 view = Matrix4::LookAt(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+    return view * Matrix4::Perspective(1.2f, 2.0f, 0.1f, 500.0f);
+}
+
+BENCHMARK(OcclusionBufferBenchmark, Render)
+{
+    OcclusionBuffer buffer;
+    AddCity(buffer);
+    Matrix4 viewProjection = GetViewProjection();
+
+    // Rasterizing the occluders and building the pyramid, per frame
+    Measure("render inline", [&]()
+    {
+        buffer.Render(viewProjection);
+    }, buildingsX * buildingsZ);
+
+    // Tiles as jobs on three workers and the calling thread
+    JobSystem jobSystem(3);
+    buffer.SetJobSystem(&jobSystem);
+    Measure("render jobs", [&]()
+    {
+        buffer.Render(viewProjection);
+    }, buildingsX * buildingsZ);
+
+    OcclusionStats const& stats = buffer.GetStats();
+    printf("%u occluders, %u triangles, %u clipped, %ux%u buffer, %u levels\n", stats.occluders_, stats.triangles_,
+        stats.clippedTriangles_, buffer.GetWidth(), buffer.GetHeight(), buffer.GetLevelCount());
+}
+
+BENCHMARK(OcclusionBufferBenchmark, Cull)
+{
+    OcclusionBuffer buffer;
+    AddCity(buffer);
+    buffer.Render(GetViewProjection());
+
+    // Small props scattered through the city, in front of, between and behind the buildings
+    std::mt19937 random(22);
+    std::uniform_real_distribution<float> x(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> y(-2.0f, 8.0f);
+    std::uniform_real_distribution<float> z(1.0f, 120.0f);
+    std::uniform_real_distribution<float> extent(0.2f, 2.0f);
+    std::vector<BoundingBox> boxes(objectCount);
+    BoundsArray boundsArray;
+    boundsArray.Resize(objectCount);
+    std::vector<unsigned> ids(objectCount);
+    for (unsigned i = 0; i < objectCount; ++i)
+    {
+        boxes[i] = BoundingBox(Vector3(x(random), y(random), z(random)), Vector3(extent(random), extent(random), extent(random)));
+        boundsArray.Set(i, boxes[i]);
+        ids[i] = i;
+    }
+    std::vector<unsigned> visible;
+
+    // One box at a time, as a caller without the structure of arrays bounds would test them
+    Measure("scalar IsVisible", [&]()
+    {
+        visible.clear();
+        for (unsigned i = 0; i < objectCount; ++i)
+        {
+            if (buffer.IsVisible(boxes[i]))
+                visible.push_back(i);
+        }
+        KeepResult(visible.size());
+    }, objectCount);
+
+    Measure("batch Cull", [&]()
+    {
+        KeepResult(buffer.Cull(boundsArray, ids, visible));
+    }, objectCount);
+
+    // Statistics add up over the runs since the last render
+    printf("%u of %u visible\n", (unsigned) visible.size(), objectCount);
+}
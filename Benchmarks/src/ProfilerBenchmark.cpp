@@ -0,0 +1,79 @@
+#include "Benchmark.h"
+#include "Profiler.h"
+
+
+/// Zones per run.
+static const unsigned zoneCount = 4096;
+
+BENCHMARK(ProfilerBenchmark, ScopeOverhead)
+{
+    Profiler& profiler = Profiler::Get();
+    bool wasEnabled = profiler.IsEnabled();
+
+    // Each zone wraps the same trivial work, so the difference to the bare loop is the cost of a zone
+    Measure("no zone", [&]()
+    {
+        for (unsigned i = 0; i < zoneCount; ++i)
+            KeepResult(i);
+    }, zoneCount);
+
+    // A zone reads the time twice
+    Measure("read ticks", [&]()
+    {
+        for (unsigned i = 0; i < zoneCount; ++i)
+            KeepResult(Profiler::GetTicks());
+    }, zoneCount);
+
+    profiler.SetEnabled(false);
+    Measure("zone disabled", [&]()
+    {
+        for (unsigned i = 0; i < zoneCount; ++i)
+        {
+            PROFILE_SCOPE("Zone");
+            KeepResult(i);
+        }
+    }, zoneCount);
+
+    profiler.SetEnabled(true);
+    Measure("zone enabled", [&]()
+    {
+        for (unsigned i = 0; i < zoneCount; ++i)
+        {
+            PROFILE_SCOPE("Zone");
+            KeepResult(i);
+        }
+    }, zoneCount);
+
+    Measure("nested zones enabled", [&]()
+    {
+        for (unsigned i = 0; i < zoneCount / 4; ++i)
+        {
+            PROFILE_SCOPE("Outer");
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                PROFILE_SCOPE("Inner");
+                KeepResult(j);
+            }
+        }
+    }, zoneCount);
+
+    Measure("counter enabled", [&]()
+    {
+        for (unsigned i = 0; i < zoneCount; ++i)
+            PROFILE_COUNTER("Counter", i);
+    }, zoneCount);
+
+    // Collection runs once a frame, moving a frame's worth of events into the timeline
+    Measure("collect", [&]()
+    {
+        for (unsigned i = 0; i < zoneCount; ++i)
+        {
+            PROFILE_SCOPE("Zone");
+            KeepResult(i);
+        }
+        profiler.Collect();
+        profiler.ClearTimeline();
+    }, zoneCount);
+
+    profiler.SetEnabled(wasEnabled);
+}
@@ -0,0 +1,124 @@
+#include "Benchmark.h"
+#include "NullGraphicsBackend.h"
+#include "NullTransientResourceFactory.h"
+#include "RenderGraph.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+/// Passes of the chain.
+static const unsigned chainLength = 200;
+/// Branches of the wide graph.
+static const unsigned branchCount = 64;
+/// Passes per branch of the wide graph.
+static const unsigned branchLength = 4;
+
+/// Description of a render target.
+static TextureDesc MakeDesc(unsigned size)
+{
+    TextureDesc desc;
+    desc.width_ = size;
+    desc.height_ = size;
+    return desc;
+}
+
+/// Pass that records nothing.
+static void ExecuteNothing(RenderGraphContext&)
+{
+}
+
+/// Build a chain where each pass reads the texture of the one before, so only two textures are alive at a time.
+static void BuildChain(RenderGraph& graph)
+{
+    graph.Reset();
+    RenderGraphResource output = graph.Import("Output", (ResourceHandle) (uintptr_t) 0x100, RESOURCE_STATE_RENDER_TARGET);
+    RenderGraphResource previous = INVALID_RENDER_GRAPH_RESOURCE;
+    for (unsigned i = 0; i < chainLength; ++i)
+    {
+        graph.AddPass("Chain", [&](RenderGraphBuilder& builder)
+        {
+            if (previous != INVALID_RENDER_GRAPH_RESOURCE)
+                builder.Read(previous);
+            if (i + 1 < chainLength)
+                previous = builder.Write(builder.CreateTexture("Chain", MakeDesc(256u << (i % 3))));
+            else
+                builder.Write(output);
+        }, ExecuteNothing);
+    }
+}
+
+/// Build branches of passes whose ends a final pass reads. Every eighth branch is not read and culled, and
+/// textures of different sizes alias within and across branches.
+static void BuildWide(RenderGraph& graph)
+{
+    graph.Reset();
+    RenderGraphResource output = graph.Import("Output", (ResourceHandle) (uintptr_t) 0x100, RESOURCE_STATE_RENDER_TARGET);
+    std::vector<RenderGraphResource> ends;
+    for (unsigned i = 0; i < branchCount; ++i)
+    {
+        RenderGraphResource previous = INVALID_RENDER_GRAPH_RESOURCE;
+        for (unsigned j = 0; j < branchLength; ++j)
+        {
+            graph.AddPass("Branch", [&](RenderGraphBuilder& builder)
+            {
+                if (previous != INVALID_RENDER_GRAPH_RESOURCE)
+                    builder.Read(previous);
+                previous = builder.Write(builder.CreateTexture("Branch", MakeDesc(128u << ((i + j) % 4))));
+            }, ExecuteNothing);
+        }
+
+        if (i % 8 != 7)
+            ends.push_back(previous);
+    }
+
+    graph.AddPass("Resolve", [&](RenderGraphBuilder& builder)
+    {
+        for (RenderGraphResource end : ends)
+            builder.Read(end);
+        builder.Write(output);
+    }, ExecuteNothing);
+}
+
+/// Measure building and compiling a graph.
+static void MeasureGraph(char const* name, void (*build)(RenderGraph&), unsigned passCount)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullTransientResourceFactory factory(backend.GetStateRegistry());
+    RenderGraph graph;
+    build(graph);
+
+    std::string prefix(name);
+    Measure((prefix + " build").c_str(), [&]()
+    {
+        build(graph);
+    }, passCount);
+
+    // Compiling again recomputes everything, as the graph is rebuilt every frame
+    Measure((prefix + " compile").c_str(), [&]()
+    {
+        KeepResult(graph.Compile(factory));
+    }, passCount);
+
+    Measure((prefix + " build and compile").c_str(), [&]()
+    {
+        build(graph);
+        KeepResult(graph.Compile(factory));
+    }, passCount);
+
+    RenderGraphStats const& stats = graph.GetStats();
+    printf("%u passes, %u culled, %u barriers, %u aliasing barriers, %u textures, %llu KB heap for %llu KB\n", stats.passes_,
+        stats.culledPasses_, stats.barriers_, stats.aliasingBarriers_, stats.transientTextures_,
+        (unsigned long long) (stats.transientHeapSize_ >> 10), (unsigned long long) (stats.transientSize_ >> 10));
+}
+
+BENCHMARK(RenderGraphBenchmark, Chain)
+{
+    MeasureGraph("chain", BuildChain, chainLength);
+}
+
+BENCHMARK(RenderGraphBenchmark, Wide)
+{
+    MeasureGraph("wide", BuildWide, branchCount * branchLength + 1);
+}
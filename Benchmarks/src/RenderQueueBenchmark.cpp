@@ -0,0 +1,105 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "NullGraphicsBackend.h"
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+/// Draws per frame.
+static const unsigned drawCount = 16384;
+
+/// Fill a queue with draws over 16 pipelines and 64 materials at random depths. Return their keys.
+static std::vector<uint64_t> AddDraws(RenderQueue& queue)
+{
+    std::mt19937 random(23);
+    std::vector<uint64_t> keys(drawCount);
+    for (unsigned i = 0; i < drawCount; ++i)
+    {
+        unsigned pipeline = random() % 16;
+        unsigned material = random() % 64;
+        DrawPacket packet;
+        packet.pipelineState_ = (PipelineStateHandle) (uintptr_t) (0x1000 + pipeline * 0x100);
+        packet.descriptorTables_[0] = 0x10000 + material * 0x100;
+        packet.vertexBuffer_.gpuAddress_ = 0x100000 + (random() % 256) * 0x1000;
+        packet.vertexCount_ = 36;
+        keys[i] = RenderQueue::MakeSortKey(0, false, pipeline, material, (float) (random() % 1000) / 1000.0f);
+        queue.Add(keys[i], packet);
+    }
+    return keys;
+}
+
+BENCHMARK(RenderQueueBenchmark, Sort)
+{
+    RenderQueue queue;
+    std::vector<uint64_t> keys = AddDraws(queue);
+
+    // Both comparison sorts produce the same stable order as the radix sort
+    std::vector<std::pair<uint64_t, unsigned> > pairs(drawCount);
+    Measure("std::sort", [&]()
+    {
+        for (unsigned i = 0; i < drawCount; ++i)
+            pairs[i] = std::make_pair(keys[i], i);
+        std::sort(pairs.begin(), pairs.end());
+        KeepResult(pairs[0].second);
+    }, drawCount);
+
+    std::vector<unsigned> order(drawCount);
+    Measure("std::stable_sort", [&]()
+    {
+        for (unsigned i = 0; i < drawCount; ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&keys](unsigned lhs, unsigned rhs) { return keys[lhs] < keys[rhs]; });
+        KeepResult(order[0]);
+    }, drawCount);
+
+    Measure("radix sort", [&]()
+    {
+        queue.Sort();
+        KeepResult(queue.GetOrder()[0]);
+    }, drawCount);
+    printf("%u of 8 radix passes run\n", queue.GetStats().sortPasses_);
+}
+
+BENCHMARK(RenderQueueBenchmark, Submit)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    JobSystem jobSystem(3);
+    RenderQueue queue;
+    AddDraws(queue);
+    queue.Sort();
+
+    // A list per range, as the backend's per-thread pools hand out
+    std::vector<std::unique_ptr<NullCommandList> > commandLists;
+    for (unsigned i = 0; i < jobSystem.GetThreadCount(); ++i)
+        commandLists.emplace_back(new NullCommandList(backend));
+
+    Measure("one list", [&]()
+    {
+        commandLists[0]->Reset(0);
+        queue.Submit(*commandLists[0]);
+        commandLists[0]->Close();
+    }, drawCount);
+
+    queue.SetJobSystem(&jobSystem);
+    std::vector<CommandList*> recorded;
+    std::atomic<unsigned> acquired;
+    Measure("parallel lists", [&]()
+    {
+        acquired = 0;
+        queue.Submit([&]() -> CommandList*
+        {
+            NullCommandList* commandList = commandLists[acquired++].get();
+            commandList->Reset(0);
+            return commandList;
+        }, recorded);
+        for (CommandList* commandList : recorded)
+            commandList->Close();
+    }, drawCount);
+    KeepResult(queue.GetStats().commandLists_);
+}
@@ -0,0 +1,199 @@
+#include "Benchmark.h"
+#include "FrustumCuller.h"
+#include "Scene.h"
+#include "SceneSystems.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+/// Entities per scene.
+static const unsigned entityCount = 1u << 20;
+/// Entities created, destroyed or changed per run of the structural change cases.
+static const unsigned changeCount = 16384;
+/// Time step of a frame.
+static const float timeStep = 1.0f / 60.0f;
+
+/// Object with every component inline, the array of structures layout the scene replaces.
+struct SceneObject
+{
+    TransformComponent transform_;
+    MotionComponent motion_;
+    WorldTransformComponent worldTransform_;
+    RenderableComponent renderable_;
+    /// Name, the kind of cold data objects carry along
+    char name_[32];
+};
+
+/// Return the mask of the components of moving renderables.
+static ComponentMask GetMovingMask(SceneComponents const& components)
+{
+    return Scene::GetMask(components.transform_) | Scene::GetMask(components.motion_) |
+        Scene::GetMask(components.worldTransform_) | Scene::GetMask(components.renderable_);
+}
+
+/// Give moving entities random velocities.
+static void InitializeMotion(Scene& scene, SceneComponents const& components)
+{
+    std::mt19937 random(25);
+    std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+    SceneQuery query;
+    query.all_ = Scene::GetMask(components.motion_);
+    query.write_ = query.all_;
+    scene.ForEachChunk(query, [&](SceneChunk& chunk)
+    {
+        MotionComponent* motion = chunk.GetComponents<MotionComponent>(components.motion_);
+        for (unsigned i = 0; i < chunk.GetCount(); ++i)
+        {
+            motion[i].velocity_ = Vector3(velocity(random), velocity(random), velocity(random));
+            motion[i].angularVelocity_ = Vector3(velocity(random), velocity(random), velocity(random));
+        }
+    });
+}
+
+BENCHMARK(SceneBenchmark, Iterate)
+{
+    Scene scene;
+    SceneComponents components(scene);
+    std::vector<Entity> entities;
+    scene.CreateEntities(GetMovingMask(components), entityCount, &entities);
+    InitializeMotion(scene, components);
+
+    // Integrate positions, touching only the transform and motion arrays of each chunk
+    SceneQuery query;
+    query.all_ = Scene::GetMask(components.transform_) | Scene::GetMask(components.motion_);
+    query.write_ = Scene::GetMask(components.transform_);
+    Measure("chunks", [&]()
+    {
+        scene.ForEachChunk(query, [&](SceneChunk& chunk)
+        {
+            TransformComponent* transforms = chunk.GetComponents<TransformComponent>(components.transform_);
+            MotionComponent const* motion = chunk.GetComponents<MotionComponent>(components.motion_);
+            for (unsigned i = 0; i < chunk.GetCount(); ++i)
+                transforms[i].position_ = transforms[i].position_ + motion[i].velocity_ * timeStep;
+        });
+    }, entityCount);
+
+    Measure("lookup by handle", [&]()
+    {
+        for (Entity entity : entities)
+        {
+            TransformComponent* transform = scene.WriteComponent<TransformComponent>(entity, components.transform_);
+            MotionComponent const* motion = scene.GetComponent<MotionComponent>(entity, components.motion_);
+            transform->position_ = transform->position_ + motion->velocity_ * timeStep;
+        }
+    }, entityCount);
+
+    std::vector<SceneObject> objects(entityCount);
+    Measure("object array", [&]()
+    {
+        for (SceneObject& object : objects)
+            object.transform_.position_ = object.transform_.position_ + object.motion_.velocity_ * timeStep;
+    }, entityCount);
+
+    // Objects allocated one by one and visited in an order unrelated to their addresses
+    std::vector<std::unique_ptr<SceneObject> > heapObjects(entityCount);
+    for (std::unique_ptr<SceneObject>& object : heapObjects)
+        object.reset(new SceneObject());
+    std::shuffle(heapObjects.begin(), heapObjects.end(), std::mt19937(26));
+    Measure("heap objects", [&]()
+    {
+        for (std::unique_ptr<SceneObject>& object : heapObjects)
+            object->transform_.position_ = object->transform_.position_ + object->motion_.velocity_ * timeStep;
+    }, entityCount);
+
+    KeepResult((uint64_t) objects[0].transform_.position_.x_ + (uint64_t) heapObjects[0]->transform_.position_.x_);
+}
+
+BENCHMARK(SceneBenchmark, Frame)
+{
+    // All entities moving, then one in a hundred with the rest still and skipped by change detection
+    for (unsigned divisor : { 1u, 100u })
+    {
+        Scene scene;
+        SceneComponents components(scene);
+        ComponentMask moving = GetMovingMask(components);
+        scene.CreateEntities(moving, entityCount / divisor);
+        scene.CreateEntities(moving & ~Scene::GetMask(components.motion_), entityCount - entityCount / divisor);
+        InitializeMotion(scene, components);
+
+        FrustumCuller culler;
+        RenderableChanges changes;
+        uint32_t worldVersion = 0;
+        uint32_t renderableVersion = 0;
+        UpdateWorldTransforms(scene, components, worldVersion);
+        SyncRenderables(scene, components, renderableVersion, culler, changes);
+
+        Measure(divisor == 1 ? "all moving" : "1% moving", [&]()
+        {
+            UpdateMotion(scene, components, timeStep);
+            UpdateWorldTransforms(scene, components, worldVersion);
+            SyncRenderables(scene, components, renderableVersion, culler, changes);
+        }, entityCount);
+        KeepResult(changes.objects_.size());
+    }
+}
+
+BENCHMARK(SceneBenchmark, StructuralChange)
+{
+    // Creating into an empty scene, which allocates the archetype and its chunks as it goes
+    Measure("create batch", [&]()
+    {
+        Scene scene;
+        SceneComponents components(scene);
+        scene.CreateEntities(GetMovingMask(components), changeCount);
+        KeepResult(scene.GetEntityCount());
+    }, changeCount);
+
+    Measure("create one by one", [&]()
+    {
+        Scene scene;
+        SceneComponents components(scene);
+        ComponentMask moving = GetMovingMask(components);
+        for (unsigned i = 0; i < changeCount; ++i)
+            scene.CreateEntity(moving);
+        KeepResult(scene.GetEntityCount());
+    }, changeCount);
+
+    // In a full scene, still entities picked at random so every change moves another chunk's last row
+    Scene scene;
+    SceneComponents components(scene);
+    ComponentMask still = GetMovingMask(components) & ~Scene::GetMask(components.motion_);
+    std::vector<Entity> entities;
+    scene.CreateEntities(still, entityCount, &entities);
+    std::mt19937 random(27);
+    std::vector<unsigned> picks(changeCount);
+    for (unsigned& pick : picks)
+        pick = std::uniform_int_distribution<unsigned>(0, entityCount - 1)(random);
+    std::sort(picks.begin(), picks.end());
+    picks.erase(std::unique(picks.begin(), picks.end()), picks.end());
+    std::shuffle(picks.begin(), picks.end(), random);
+
+    // Each run destroys the picked entities and creates their replacements, reusing the freed indices
+    std::vector<Entity> created;
+    Measure("destroy and create", [&]()
+    {
+        for (unsigned pick : picks)
+            scene.DestroyEntity(entities[pick]);
+        scene.ClearDestroyedEntities();
+        created.clear();
+        scene.CreateEntities(still, (unsigned) picks.size(), &created);
+        for (unsigned i = 0; i < picks.size(); ++i)
+            entities[picks[i]] = created[i];
+    }, (unsigned) picks.size());
+
+    // Each run moves the picked entities to the moving archetype and back
+    Measure("add and remove component", [&]()
+    {
+        for (unsigned pick : picks)
+            scene.AddComponents(entities[pick], Scene::GetMask(components.motion_));
+        for (unsigned pick : picks)
+            scene.RemoveComponents(entities[pick], Scene::GetMask(components.motion_));
+    }, (unsigned) picks.size());
+
+    SceneStats stats = scene.GetStats();
+    printf("%u entities, %u archetypes, %u chunks\n", stats.entities_, stats.archetypes_, stats.chunks_);
+}
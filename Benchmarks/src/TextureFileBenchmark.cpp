@@ -0,0 +1,97 @@
+#include "Benchmark.h"
+#include "ByteStream.h"
+#include "MappedFile.h"
+#include "TextureFile.h"
+
+#include <cstdio>
+#include <vector>
+
+
+/// Width and height of the texture, rows deliberately not a multiple of the upload pitch alignment.
+static const unsigned textureSize = 2000;
+/// Name of the texture file written for the benchmark.
+static const char* fileName = "TextureFileBenchmark.dds";
+
+/// Return an RGBA8 DDS file with a full mip chain.
+static std::vector<uint8_t> MakeDds(unsigned size)
+{
+    std::vector<uint8_t> data;
+    ByteWriter writer(data);
+    uint32_t const header[] = { 0x20534444, 124, 0x20000, size, size, size * 4, 0, 0 };
+    for (uint32_t value : header)
+        writer.WriteU32(value);
+    for (unsigned i = 0; i < 11; ++i)
+        writer.WriteU32(0);
+    uint32_t const pixelFormat[] = { 32, 0x41, 0, 32, 0xff, 0xff00, 0xff0000, 0xff000000, 0, 0, 0, 0, 0 };
+    for (uint32_t value : pixelFormat)
+        writer.WriteU32(value);
+
+    unsigned mipCount = 0;
+    for (unsigned mip = size; ; mip = mip > 1 ? mip / 2 : 1)
+    {
+        data.resize(data.size() + (size_t) mip * mip * 4, (uint8_t) mip);
+        ++mipCount;
+        if (mip == 1)
+            break;
+    }
+    data[28] = (uint8_t) mipCount;
+    return data;
+}
+
+/// Copy every mip of a parsed file into upload memory.
+static void CopyMips(uint8_t const* fileData, TextureFileInfo const& info, std::vector<uint8_t>& upload)
+{
+    uint64_t offset = 0;
+    for (TextureMipInfo const& mip : info.mips_)
+    {
+        CopyTextureMip(fileData, mip, upload.data() + offset);
+        offset += (mip.GetUploadSize() + TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+    }
+}
+
+BENCHMARK(TextureFileBenchmark, LoadMips)
+{
+    std::vector<uint8_t> contents = MakeDds(textureSize);
+    FILE* file = fopen(fileName, "wb");
+    if (!file)
+        return;
+    fwrite(contents.data(), 1, contents.size(), file);
+    fclose(file);
+
+    TextureFileInfo info;
+    Measure("parse header", [&]()
+    {
+        KeepResult(ParseTextureFile(contents.data(), contents.size(), info));
+    });
+
+    uint64_t uploadSize = 0;
+    for (TextureMipInfo const& mip : info.mips_)
+        uploadSize += (mip.GetUploadSize() + TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+    std::vector<uint8_t> upload((size_t) uploadSize);
+    unsigned kilobytes = (unsigned) (contents.size() / 1024);
+
+    // The file was just written, so both read from the page cache and the difference is the intermediate copy.
+    // Time per item is per kilobyte of the file
+    std::vector<uint8_t> buffer;
+    Measure("read and copy", [&]()
+    {
+        FILE* input = fopen(fileName, "rb");
+        if (!input)
+            return;
+        buffer.resize(contents.size());
+        KeepResult(fread(buffer.data(), 1, buffer.size(), input));
+        fclose(input);
+        if (ParseTextureFile(buffer.data(), buffer.size(), info))
+            CopyMips(buffer.data(), info, upload);
+    }, kilobytes);
+
+    Measure("map and copy", [&]()
+    {
+        MappedFile mapped;
+        if (mapped.Open(fileName) && ParseTextureFile(mapped.GetData(), mapped.GetSize(), info))
+            CopyMips(mapped.GetData(), info, upload);
+    }, kilobytes);
+
+    KeepResult(upload[upload.size() / 2]);
+    remove(fileName);
+}
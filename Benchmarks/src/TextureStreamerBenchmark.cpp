@@ -0,0 +1,108 @@
+#include "Benchmark.h"
+#include "ByteStream.h"
+#include "NullTextureUploadSink.h"
+#include "NullUploadBufferFactory.h"
+#include "TextureStreamer.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+
+/// Textures streamed.
+static const unsigned textureCount = 2048;
+/// Textures whose priority changes per frame of the churn case.
+static const unsigned changedPerFrame = 32;
+
+/// Write a square RGBA8 DDS file with a full mip chain.
+static bool WriteDds(std::string const& fileName, unsigned size)
+{
+    std::vector<uint8_t> data;
+    ByteWriter writer(data);
+    uint32_t const header[] = { 0x20534444, 124, 0x20000, size, size, size * 4, 0, 0 };
+    for (uint32_t value : header)
+        writer.WriteU32(value);
+    for (unsigned i = 0; i < 11; ++i)
+        writer.WriteU32(0);
+    uint32_t const pixelFormat[] = { 32, 0x41, 0, 32, 0xff, 0xff00, 0xff0000, 0xff000000, 0, 0, 0, 0, 0 };
+    for (uint32_t value : pixelFormat)
+        writer.WriteU32(value);
+
+    unsigned mipCount = 0;
+    for (unsigned mip = size; ; mip /= 2)
+    {
+        data.resize(data.size() + (size_t) mip * mip * 4, (uint8_t) mip);
+        ++mipCount;
+        if (mip == 1)
+            break;
+    }
+    data[28] = (uint8_t) mipCount;
+    return WriteFileBytes(fileName, data.data(), data.size());
+}
+
+BENCHMARK(TextureStreamerBenchmark, Update)
+{
+    // Textures of four sizes share their files, each mapped once per texture
+    std::vector<std::string> fileNames;
+    for (unsigned size : { 128u, 256u, 512u, 1024u })
+    {
+        fileNames.push_back("TextureStreamerBenchmark" + std::to_string(size) + ".dds");
+        if (!WriteDds(fileNames.back(), size))
+            return;
+    }
+
+    // A manual queue completes copies at once, so only the streamer's own work is timed
+    NullTextureUploadSink sink(false);
+    NullUploadBufferFactory factory;
+    TextureStreamer streamer;
+    if (!streamer.Initialize(sink, factory))
+        return;
+
+    std::mt19937 random(18);
+    std::uniform_real_distribution<float> priority(0.1f, 10.0f);
+    uint64_t wantedSize = 0;
+    std::vector<unsigned> ids;
+    for (unsigned i = 0; i < textureCount; ++i)
+    {
+        ids.push_back(streamer.AddTexture(fileNames[i % fileNames.size()], priority(random)));
+        wantedSize += streamer.GetFileInfo(ids.back()).GetMipChainSize(0);
+    }
+
+    // A quarter of what the textures want fits, so most frames look for something to evict and fail
+    streamer.SetBudget(wantedSize / 4);
+    streamer.SetUploadLimit(16 * 1024 * 1024);
+    unsigned frames = 0;
+    while (!streamer.IsIdle() || !frames)
+    {
+        streamer.Update();
+        sink.GetQueue().ProcessCommands();
+        ++frames;
+    }
+    printf("%u frames to settle, %llu of %llu KB committed\n", frames, (unsigned long long) (streamer.GetCommittedSize() >> 10),
+        (unsigned long long) (wantedSize >> 10));
+
+    Measure("settled", [&]()
+    {
+        streamer.Update();
+        sink.GetQueue().ProcessCommands();
+    }, textureCount);
+
+    // Priorities change every frame, as when the camera moves, so loads and evictions keep going
+    TextureStreamerStats before = streamer.GetStats();
+    Measure("churn", [&]()
+    {
+        for (unsigned i = 0; i < changedPerFrame; ++i)
+            streamer.SetPriority(ids[random() % textureCount], priority(random));
+        streamer.Update();
+        sink.GetQueue().ProcessCommands();
+    }, textureCount);
+
+    TextureStreamerStats const& stats = streamer.GetStats();
+    printf("churn: %llu loads, %llu mips evicted, %llu postponed over budget\n", (unsigned long long) (stats.loads_ - before.loads_),
+        (unsigned long long) (stats.mipsEvicted_ - before.mipsEvicted_), (unsigned long long) (stats.overBudget_ - before.overBudget_));
+
+    streamer.Shutdown();
+    for (std::string const& fileName : fileNames)
+        remove(fileName.c_str());
+}
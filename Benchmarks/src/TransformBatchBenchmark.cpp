@@ -0,0 +1,223 @@
+#include "Benchmark.h"
+#include "Quaternion.h"
+#include "TransformBatch.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+
+/// Transforms per run.
+static const unsigned transformCount = 16384;
+
+/// Return random affine transforms.
+static std::vector<Matrix4> MakeTransforms(unsigned count, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    std::vector<Matrix4> transforms(count);
+    for (Matrix4& transform : transforms)
+    {
+        Vector3 axis = Vector3(position(random), position(random), position(random)).Normalized();
+        transform = Matrix4::FromTRS(Vector3(position(random), position(random), position(random)),
+            Quaternion::FromAxisAngle(axis, angle(random)), Vector3(scale(random), scale(random), scale(random)));
+    }
+    return transforms;
+}
+
+/// Return transforms in structure of arrays layout.
+static void CopyTransforms(std::vector<Matrix4> const& source, TransformArray& dest)
+{
+    dest.Resize((unsigned) source.size());
+    for (unsigned i = 0; i < source.size(); ++i)
+        dest.Set(i, source[i]);
+}
+
+/// Multiply the affine transform at an index of streams a by the one at an index of streams b into the streams
+/// of r, one float at a time. Each row is loaded before it is stored, so r may be a.
+static void MultiplyElements(float const* const* a, unsigned aIndex, float const* const* b, unsigned bIndex, float* const* r)
+{
+    float m[TransformArray::ElementCount];
+    for (unsigned e = 0; e < TransformArray::ElementCount; ++e)
+        m[e] = b[e][bIndex];
+
+    for (unsigned row = 0; row < 4; ++row)
+    {
+        float x = a[row * 3][aIndex];
+        float y = a[row * 3 + 1][aIndex];
+        float z = a[row * 3 + 2][aIndex];
+        // The implicit w of 1 in the translation row picks up the translation of b
+        for (unsigned col = 0; col < 3; ++col)
+            r[row * 3 + col][aIndex] = x * m[col] + y * m[3 + col] + z * m[6 + col] + (row == 3 ? m[9 + col] : 0.0f);
+    }
+}
+
+/// Scalar reference of the structure of arrays multiply, one transform at a time.
+static void MultiplyReference(TransformArray const& lhs, TransformArray const& rhs, TransformArray& dest, unsigned count)
+{
+    float const* a[TransformArray::ElementCount];
+    float const* b[TransformArray::ElementCount];
+    float* r[TransformArray::ElementCount];
+    lhs.GetStreams(a);
+    rhs.GetStreams(b);
+    dest.GetStreams(r);
+
+    for (unsigned i = 0; i < count; ++i)
+        MultiplyElements(a, i, b, i, r);
+}
+
+/// Scalar reference of the structure of arrays propagation, one transform at a time in depth order.
+static void PropagateReference(TransformArray const& local, int const* parents, unsigned count, TransformArray& world)
+{
+    float const* l[TransformArray::ElementCount];
+    float* w[TransformArray::ElementCount];
+    local.GetStreams(l);
+    world.GetStreams(w);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (parents[i] >= 0)
+            MultiplyElements(l, i, w, (unsigned) parents[i], w);
+        else
+        {
+            for (unsigned e = 0; e < TransformArray::ElementCount; ++e)
+                w[e][i] = l[e][i];
+        }
+    }
+}
+
+/// Scalar reference of the structure of arrays box transform, one box at a time.
+static void BoundsReference(BoundsArray const& local, TransformArray const& transforms, BoundsArray& dest, unsigned count)
+{
+    float const* b[BoundsArray::ElementCount];
+    float const* t[TransformArray::ElementCount];
+    float* r[BoundsArray::ElementCount];
+    local.GetStreams(b);
+    transforms.GetStreams(t);
+    dest.GetStreams(r);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        float m[TransformArray::ElementCount];
+        for (unsigned e = 0; e < TransformArray::ElementCount; ++e)
+            m[e] = t[e][i];
+        for (unsigned col = 0; col < 3; ++col)
+        {
+            r[col][i] = b[0][i] * m[col] + b[1][i] * m[3 + col] + b[2][i] * m[6 + col] + m[9 + col];
+            r[3 + col][i] = b[3][i] * std::fabs(m[col]) + b[4][i] * std::fabs(m[3 + col]) + b[5][i] * std::fabs(m[6 + col]);
+        }
+    }
+}
+
+BENCHMARK(TransformBatchBenchmark, Multiply)
+{
+    std::vector<Matrix4> lhs = MakeTransforms(transformCount, 1);
+    std::vector<Matrix4> rhs = MakeTransforms(transformCount, 2);
+    std::vector<Matrix4> dest(transformCount);
+    TransformArray lhsArray, rhsArray, destArray;
+    CopyTransforms(lhs, lhsArray);
+    CopyTransforms(rhs, rhsArray);
+    destArray.Resize(transformCount);
+
+    Measure("scalar reference", [&]()
+    {
+        MultiplyReference(lhsArray, rhsArray, destArray, transformCount);
+    }, transformCount);
+    Measure("array of structures", [&]()
+    {
+        MultiplyTransforms(lhs.data(), rhs.data(), dest.data(), transformCount);
+    }, transformCount);
+    Measure("structure of arrays", [&]()
+    {
+        MultiplyTransforms(lhsArray, rhsArray, destArray, 0, transformCount);
+    }, transformCount);
+    KeepResult((uint64_t) destArray.GetStream(0)[transformCount / 2] + (uint64_t) dest[transformCount / 2].rows_[0].x_);
+}
+
+/// Time propagating a hierarchy given its parents.
+static void MeasurePropagate(char const* name, std::vector<int> const& parents)
+{
+    std::vector<unsigned> order;
+    std::vector<int> sortedParents;
+    std::vector<unsigned> levelOffsets;
+    SortTransformHierarchy(parents.data(), transformCount, order, sortedParents, levelOffsets);
+
+    std::vector<Matrix4> local = MakeTransforms(transformCount, 4);
+    std::vector<Matrix4> world(transformCount);
+    std::vector<Matrix4> sortedLocal(transformCount);
+    for (unsigned i = 0; i < transformCount; ++i)
+        sortedLocal[i] = local[order[i]];
+    TransformArray localArray, worldArray;
+    CopyTransforms(sortedLocal, localArray);
+    worldArray.Resize(transformCount);
+
+    std::string referenceName = std::string(name) + " scalar reference";
+    Measure(referenceName.c_str(), [&]()
+    {
+        PropagateReference(localArray, sortedParents.data(), transformCount, worldArray);
+    }, transformCount);
+    std::string aosName = std::string(name) + " array of structures";
+    Measure(aosName.c_str(), [&]()
+    {
+        PropagateTransforms(local.data(), parents.data(), transformCount, world.data());
+    }, transformCount);
+    std::string soaName = std::string(name) + " structure of arrays";
+    Measure(soaName.c_str(), [&]()
+    {
+        PropagateTransforms(localArray, sortedParents.data(), levelOffsets.data(), (unsigned) levelOffsets.size() - 1, worldArray);
+    }, transformCount);
+    KeepResult((uint64_t) worldArray.GetStream(0)[transformCount / 2] + (uint64_t) world[transformCount / 2].rows_[0].x_);
+}
+
+BENCHMARK(TransformBatchBenchmark, Propagate)
+{
+    // 256 roots with 63 children each, the parents of a level gathered from a few cache lines
+    std::vector<int> parents(transformCount);
+    for (unsigned i = 0; i < transformCount; ++i)
+        parents[i] = i < 256 ? -1 : (int) ((i - 256) / 63);
+    MeasurePropagate("shallow", parents);
+
+    // Every non-root parented to a random earlier node, so each parent is gathered from anywhere
+    std::mt19937 random(3);
+    for (unsigned i = 256; i < transformCount; ++i)
+        parents[i] = (int) (random() % i);
+    MeasurePropagate("random", parents);
+}
+
+BENCHMARK(TransformBatchBenchmark, Bounds)
+{
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> extent(0.1f, 10.0f);
+    std::vector<BoundingBox> local(transformCount);
+    BoundsArray localArray, destArray;
+    localArray.Resize(transformCount);
+    destArray.Resize(transformCount);
+    for (unsigned i = 0; i < transformCount; ++i)
+    {
+        local[i] = BoundingBox(Vector3(extent(random), extent(random), extent(random)), Vector3(extent(random), extent(random), extent(random)));
+        localArray.Set(i, local[i]);
+    }
+
+    std::vector<Matrix4> transforms = MakeTransforms(transformCount, 6);
+    std::vector<BoundingBox> dest(transformCount);
+    TransformArray transformArray;
+    CopyTransforms(transforms, transformArray);
+
+    Measure("scalar reference", [&]()
+    {
+        BoundsReference(localArray, transformArray, destArray, transformCount);
+    }, transformCount);
+    Measure("array of structures", [&]()
+    {
+        TransformBounds(local.data(), transforms.data(), dest.data(), transformCount);
+    }, transformCount);
+    Measure("structure of arrays", [&]()
+    {
+        TransformBounds(localArray, transformArray, destArray, 0, transformCount);
+    }, transformCount);
+    KeepResult((uint64_t) destArray.GetStream(0)[transformCount / 2] + (uint64_t) dest[transformCount / 2].center_.x_);
+}
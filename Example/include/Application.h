@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "Common.h"
 
 
@@ -20,9 +22,16 @@ public:
     /// Cleanup 
     virtual void Stop() { }
 
+    /// Parse command line. Recognizes -headless, -pipelined, -frames <count>, -fps <limit>, -latency <frames>,
+    /// -trace <file>, -texture <file> (repeatable), -texturebudget <megabytes> and
+    /// -compileshaders <manifest> <cache directory>.
+    void ParseArguments(std::string const& commandLine);
     /// Initialize and run main loop, then return exit code.
     int Run();
 
+    /// Compile the shader permutations of a manifest into the cache without opening a window. Return exit code.
+    int CompileShaders();
+
     /// Show an error message
     void ErrorExit(std::string const& message = "");
 
@@ -31,4 +40,24 @@ private:
     std::shared_ptr<Graphics> graphics_;
     /// Application exit code
     int exitCode_;
+    /// Run on the headless null backend
+    bool headless_{};
+    /// Simulate on a thread of its own one frame ahead of rendering
+    bool pipelined_{};
+    /// Number of frames to run before exiting, 0 for no limit
+    uint64_t frameLimit_{};
+    /// Frame rate cap, 0 for none
+    unsigned frameRateLimit_{};
+    /// Presented frames the CPU may run ahead of, 0 for no bound
+    unsigned maxFrameLatency_{};
+    /// Shader manifest to compile offline instead of running
+    std::string shaderManifest_;
+    /// Shader cache directory
+    std::string shaderCacheDirectory_;
+    /// File to save a Chrome trace of the run to, empty for none
+    std::string traceFileName_;
+    /// Texture files to stream
+    std::vector<std::string> textureFileNames_;
+    /// Texture streaming budget in megabytes, 0 for none
+    uint64_t textureBudgetMB_{};
 };
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Matrix.h"
+#include "Vector.h"
+
+
+/// Axis-aligned bounding box as center and half extents, which transform without visiting the corners.
+struct BoundingBox
+{
+    /// Construct empty.
+    BoundingBox() = default;
+    /// Construct from center and half extents.
+    BoundingBox(Vector3 const& center, Vector3 const& extents) : center_(center), extents_(extents) {}
+
+    /// Return box spanning a minimum and maximum corner.
+    static BoundingBox FromMinMax(Vector3 const& min, Vector3 const& max) { return { (min + max) * 0.5f, (max - min) * 0.5f }; }
+
+    /// Return minimum corner.
+    Vector3 GetMin() const { return center_ - extents_; }
+    /// Return maximum corner.
+    Vector3 GetMax() const { return center_ + extents_; }
+    /// Return box also containing another.
+    BoundingBox Merged(BoundingBox const& rhs) const { return FromMinMax(GetMin().Min(rhs.GetMin()), GetMax().Max(rhs.GetMax())); }
+    /// Return the axis-aligned box of this box transformed by an affine matrix.
+    BoundingBox Transformed(Matrix4 const& transform) const;
+
+    /// Center
+    Vector3 center_;
+    /// Half extents
+    Vector3 extents_;
+};
+
+/// Bounding sphere.
+struct BoundingSphere
+{
+    /// Construct empty.
+    BoundingSphere() = default;
+    /// Construct from center and radius.
+    BoundingSphere(Vector3 const& center, float radius) : center_(center), radius_(radius) {}
+
+    /// Return sphere around a box.
+    static BoundingSphere FromBox(BoundingBox const& box) { return { box.center_, box.extents_.Length() }; }
+    /// Return the sphere transformed by an affine matrix, scaling the radius by its largest axis scale.
+    BoundingSphere Transformed(Matrix4 const& transform) const;
+
+    /// Center
+    Vector3 center_;
+    /// Radius
+    float radius_{};
+};
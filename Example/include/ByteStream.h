@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/// Writes fixed width little-endian fields regardless of the host.
+class ByteWriter
+{
+public:
+    /// Construct.
+    explicit ByteWriter(std::vector<uint8_t>& data) : data_(data) { }
+
+    /// Write a 32-bit value.
+    void WriteU32(uint32_t value)
+    {
+        for (unsigned i = 0; i < 4; ++i)
+            data_.push_back((uint8_t) (value >> (i * 8)));
+    }
+    /// Write a 64-bit value.
+    void WriteU64(uint64_t value)
+    {
+        for (unsigned i = 0; i < 8; ++i)
+            data_.push_back((uint8_t) (value >> (i * 8)));
+    }
+    /// Write a size prefixed byte range.
+    void WriteBytes(void const* bytes, size_t size)
+    {
+        WriteU32((uint32_t) size);
+        data_.insert(data_.end(), (uint8_t const*) bytes, (uint8_t const*) bytes + size);
+    }
+    /// Write a size prefixed string.
+    void WriteString(std::string const& value) { WriteBytes(value.data(), value.size()); }
+
+private:
+    /// Destination
+    std::vector<uint8_t>& data_;
+};
+
+/// Reads what ByteWriter wrote, failing instead of reading past the end.
+class ByteReader
+{
+public:
+    /// Construct.
+    ByteReader(uint8_t const* data, size_t size) : data_(data), size_(size) { }
+
+    /// Read a 32-bit value. Return false past the end.
+    bool ReadU32(uint32_t& value)
+    {
+        if (size_ - position_ < 4)
+            return false;
+        value = 0;
+        for (unsigned i = 0; i < 4; ++i)
+            value |= (uint32_t) data_[position_++] << (i * 8);
+        return true;
+    }
+    /// Read a 64-bit value. Return false past the end.
+    bool ReadU64(uint64_t& value)
+    {
+        if (size_ - position_ < 8)
+            return false;
+        value = 0;
+        for (unsigned i = 0; i < 8; ++i)
+            value |= (uint64_t) data_[position_++] << (i * 8);
+        return true;
+    }
+    /// Read a size prefixed byte range. Return false past the end.
+    bool ReadBytes(std::vector<uint8_t>& bytes)
+    {
+        uint32_t size;
+        if (!ReadU32(size) || size_ - position_ < size)
+            return false;
+        bytes.assign(data_ + position_, data_ + position_ + size);
+        position_ += size;
+        return true;
+    }
+
+    /// Return read position.
+    size_t GetPosition() const { return position_; }
+    /// Return whether everything has been read.
+    bool IsEnd() const { return position_ == size_; }
+
+private:
+    /// Source
+    uint8_t const* data_;
+    /// Source size
+    size_t size_;
+    /// Read position
+    size_t position_{};
+};
+
+/// Read a whole file. Return false if it cannot be opened.
+bool ReadFileBytes(std::string const& fileName, std::vector<uint8_t>& data);
+/// Write a whole file through a temporary file, so a crash mid-write never leaves a truncated file behind.
+bool WriteFileBytes(std::string const& fileName, void const* data, size_t size);
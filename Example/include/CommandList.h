@@ -0,0 +1,59 @@
+#pragma once
+
+#include "GraphicsDefs.h"
+#include "PipelineCache.h"
+#include "ResourceStateTracker.h"
+
+
+/// Command list recorded off the main thread. Lists are pooled per thread by the backend and reset to the
+/// allocator of the current frame slot when acquired. Their state tracker is deferred: the barriers that
+/// the first uses need are resolved against the registry when the list is submitted, so resource states
+/// must not change in the registry while lists record.
+class CommandList
+{
+public:
+    /// Construct.
+    explicit CommandList(ResourceStateRegistry& registry);
+    /// Destruct.
+    virtual ~CommandList();
+
+    /// Return state tracker.
+    ResourceStateTracker& GetStateTracker() { return stateTracker_; }
+    /// Record the batched barriers of the state tracker. Return number of barriers.
+    unsigned FlushBarriers() { return stateTracker_.FlushBarriers(*this); }
+
+    /// Reset on the allocator of a frame slot.
+    virtual void Reset(unsigned frameIndex) = 0;
+    /// Record resource barriers.
+    virtual void ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers) = 0;
+    /// Record default viewport and scissor.
+    virtual void SetDefaultViewport() = 0;
+    /// Record binding of a pipeline state and its root signature.
+    virtual void SetPipelineState(PipelineStateHandle state) = 0;
+    /// Record binding of a pipeline state alone, its root signature being bound with SetRootSignature.
+    virtual void SetPipelineStateObject(PipelineStateHandle state) = 0;
+    /// Record binding of a graphics root signature. Root arguments bound before are lost.
+    virtual void SetRootSignature(RootSignatureHandle rootSignature) = 0;
+    /// Record a descriptor table root argument by the GPU address of its first descriptor.
+    virtual void SetDescriptorTable(unsigned rootParameter, uint64_t gpuAddress) = 0;
+    /// Record binding of a vertex buffer to the first slot.
+    virtual void SetVertexBuffer(VertexBufferView const& view) = 0;
+    /// Record a non-indexed instanced draw of triangle lists.
+    virtual void DrawInstanced(unsigned vertexCount, unsigned instanceCount, unsigned firstVertex, unsigned firstInstance) = 0;
+    /// Record binding of an index buffer.
+    virtual void SetIndexBuffer(IndexBufferView const& view) = 0;
+    /// Record a shader resource view root argument by the GPU address of a buffer.
+    virtual void SetRootShaderResource(unsigned rootParameter, uint64_t gpuAddress) = 0;
+    /// Record a copy between buffers.
+    virtual void CopyBufferRegion(ResourceHandle dest, uint64_t destOffset, ResourceHandle source, uint64_t sourceOffset, uint64_t size) = 0;
+    /// Record draws whose arguments the GPU reads from a buffer laid out as a command signature describes.
+    virtual void ExecuteIndirect(CommandSignatureHandle signature, unsigned count, ResourceHandle argumentBuffer, uint64_t argumentOffset) = 0;
+    /// Record binding of the current back buffer and default depth stencil.
+    virtual void SetDefaultRenderTargets() = 0;
+    /// Close for submission.
+    virtual void Close() = 0;
+
+protected:
+    /// Deferred state tracker
+    ResourceStateTracker stateTracker_;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/// 128-bit content hash, the same on every host for the same bytes.
+struct ContentHash
+{
+    /// Test for equality.
+    bool operator ==(ContentHash const& rhs) const { return low_ == rhs.low_ && high_ == rhs.high_; }
+    /// Test for inequality.
+    bool operator !=(ContentHash const& rhs) const { return !(*this == rhs); }
+    /// Test for ordering.
+    bool operator <(ContentHash const& rhs) const { return high_ != rhs.high_ ? high_ < rhs.high_ : low_ < rhs.low_; }
+
+    /// Return as 32 hexadecimal digits.
+    std::string ToString() const;
+
+    /// Low 64 bits
+    uint64_t low_{};
+    /// High 64 bits
+    uint64_t high_{};
+};
+
+/// Hasher for unordered containers keyed by content hash.
+struct ContentHashHasher
+{
+    /// Return container hash.
+    size_t operator ()(ContentHash const& hash) const { return (size_t) (hash.low_ ^ hash.high_); }
+};
+
+/// Return MurmurHash3 x64 128 of bytes. Input is read as little-endian regardless of the host.
+ContentHash HashContent(void const* data, size_t size, uint64_t seed = 0);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <d3d12.h>
+#include <vector>
+
+#include "CommandList.h"
+#include "FramePacer.h"
+#include "GpuQueue.h"
+
+class GraphicsImpl;
+
+/// Pooled command list on a Direct3D12 device with an allocator per frame in flight, for the direct,
+/// compute or copy queue.
+class D3D12CommandList : public CommandList
+{
+public:
+    /// Construct.
+    explicit D3D12CommandList(GraphicsImpl& graphics, GpuQueueType type = GPU_QUEUE_DIRECT);
+    /// Destruct.
+    ~D3D12CommandList() override;
+
+    /// Create the allocators and the command list. Return false on failure.
+    bool Create();
+    /// Return native command list.
+    ID3D12GraphicsCommandList* GetCommandList() const { return commandList_; }
+
+    /// Reset on the allocator of a frame slot and bind the shader visible descriptor ring.
+    void Reset(unsigned frameIndex) override;
+    /// Record resource barriers.
+    void ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers) override;
+    /// Record default viewport and scissor.
+    void SetDefaultViewport() override;
+    /// Record binding of a pipeline state and its root signature.
+    void SetPipelineState(PipelineStateHandle state) override;
+    /// Record binding of a pipeline state alone.
+    void SetPipelineStateObject(PipelineStateHandle state) override;
+    /// Record binding of a graphics root signature.
+    void SetRootSignature(RootSignatureHandle rootSignature) override;
+    /// Record a descriptor table root argument.
+    void SetDescriptorTable(unsigned rootParameter, uint64_t gpuAddress) override;
+    /// Record binding of a vertex buffer to the first slot.
+    void SetVertexBuffer(VertexBufferView const& view) override;
+    /// Record a non-indexed instanced draw.
+    void DrawInstanced(unsigned vertexCount, unsigned instanceCount, unsigned firstVertex, unsigned firstInstance) override;
+    /// Record binding of an index buffer.
+    void SetIndexBuffer(IndexBufferView const& view) override;
+    /// Record a shader resource view root argument.
+    void SetRootShaderResource(unsigned rootParameter, uint64_t gpuAddress) override;
+    /// Record a copy between buffers.
+    void CopyBufferRegion(ResourceHandle dest, uint64_t destOffset, ResourceHandle source, uint64_t sourceOffset, uint64_t size) override;
+    /// Record indirect draws.
+    void ExecuteIndirect(CommandSignatureHandle signature, unsigned count, ResourceHandle argumentBuffer, uint64_t argumentOffset) override;
+    /// Record binding of the current back buffer and default depth stencil.
+    void SetDefaultRenderTargets() override;
+    /// Close for submission.
+    void Close() override;
+
+private:
+    /// Graphics implementation
+    GraphicsImpl& graphics_;
+    /// Queue type
+    GpuQueueType type_;
+    /// Command list
+    ID3D12GraphicsCommandList* commandList_{};
+    /// Command allocator per frame in flight
+    ID3D12CommandAllocator* commandAllocators_[FramePacer::MaxFramesInFlight] {};
+    /// Translated barriers of the last ResourceBarrier call
+    std::vector<D3D12_RESOURCE_BARRIER> barrierScratch_;
+};
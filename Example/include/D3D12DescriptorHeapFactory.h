@@ -0,0 +1,29 @@
+#pragma once
+
+#include <d3d12.h>
+#include <vector>
+
+#include "DescriptorAllocator.h"
+
+
+/// Descriptor heap factory on a Direct3D12 device.
+class D3D12DescriptorHeapFactory : public DescriptorHeapFactory
+{
+public:
+    /// Construct.
+    explicit D3D12DescriptorHeapFactory(ID3D12Device* device);
+
+    /// Create a heap.
+    bool CreateHeap(DescriptorHeapType type, unsigned capacity, bool shaderVisible, DescriptorHeapInfo& info) override;
+    /// Destroy a heap.
+    void DestroyHeap(DescriptorHeapInfo& info) override;
+    /// Copy source ranges into one contiguous destination range with a single CopyDescriptors call.
+    void CopyDescriptors(DescriptorHeapType type, size_t destStart, unsigned rangeCount,
+        size_t const* rangeStarts, unsigned const* rangeSizes) override;
+
+private:
+    /// Device
+    ID3D12Device* device_;
+    /// Source handles of the last copy
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> sourceHandles_;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include "GpuFence.h"
+
+
+/// Fence of a Direct3D12 command queue. Does not own the queue or the fence.
+class D3D12Fence : public GpuFence
+{
+public:
+    /// Construct.
+    explicit D3D12Fence(ID3D12CommandQueue* queue, ID3D12Fence* fence);
+
+    /// Enqueue a signal of value on the queue.
+    void Signal(uint64_t value) override;
+    /// Return the last value reached by the queue.
+    uint64_t GetCompletedValue() const override;
+    /// Set event once the queue has reached value.
+    void SetEventOnCompletion(uint64_t value, WaitEvent& event) override;
+
+private:
+    /// Command queue
+    ID3D12CommandQueue* queue_;
+    /// Fence
+    ID3D12Fence* fence_;
+};
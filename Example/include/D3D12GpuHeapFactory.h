@@ -0,0 +1,24 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include "GpuHeapAllocator.h"
+
+
+/// GPU heap factory on a Direct3D12 device. Heaps are in the default heap type and restricted to one
+/// category so they work on resource heap tier 1.
+class D3D12GpuHeapFactory : public GpuHeapFactory
+{
+public:
+    /// Construct.
+    explicit D3D12GpuHeapFactory(ID3D12Device* device);
+
+    /// Create a heap.
+    bool CreateHeap(GpuHeapCategory category, uint64_t size, GpuHeapInfo& info) override;
+    /// Release a heap.
+    void DestroyHeap(GpuHeapInfo& info) override;
+
+private:
+    /// Device
+    ID3D12Device* device_;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <d3d12.h>
+#include <vector>
+
+#include "GpuQueue.h"
+
+
+/// Direct3D12 command queue with a fence of its own. The queue is either created for its type or an
+/// existing one, so the direct queue can also be fenced separately from frame pacing.
+class D3D12GpuQueue : public GpuQueue
+{
+public:
+    /// Construct.
+    explicit D3D12GpuQueue(ID3D12Device* device);
+    /// Destruct.
+    ~D3D12GpuQueue() override;
+
+    /// Create a queue of a type and its fence. Return false on failure.
+    bool Create(GpuQueueType type);
+    /// Create a fence on an existing queue, which is not owned. Return false on failure.
+    bool Create(ID3D12CommandQueue* queue);
+    /// Return native queue.
+    ID3D12CommandQueue* GetCommandQueue() const { return queue_; }
+
+    /// Submit closed command lists with one call.
+    void ExecuteCommandLists(CommandList* const* commandLists, unsigned count) override;
+    /// Make the queue wait for another Direct3D12 queue's fence.
+    void Wait(GpuQueue& queue, uint64_t value) override;
+    /// Enqueue a signal of value on the queue.
+    void Signal(uint64_t value) override;
+    /// Return the last value reached by the queue.
+    uint64_t GetCompletedValue() const override;
+    /// Set event once the queue has reached value.
+    void SetEventOnCompletion(uint64_t value, WaitEvent& event) override;
+
+    /// Return native command list type of a queue type.
+    static D3D12_COMMAND_LIST_TYPE GetCommandListType(GpuQueueType type);
+
+private:
+    /// Create the fence.
+    bool CreateFence();
+
+    /// Device
+    ID3D12Device* device_;
+    /// Queue
+    ID3D12CommandQueue* queue_{};
+    /// Fence
+    ID3D12Fence* fence_{};
+    /// Queue owned flag
+    bool ownsQueue_{};
+    /// Native command lists of the last ExecuteCommandLists call
+    std::vector<ID3D12CommandList*> executeScratch_;
+};
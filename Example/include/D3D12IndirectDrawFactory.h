@@ -0,0 +1,27 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include "IndirectDraw.h"
+
+
+/// Indirect draw factory on a Direct3D12 device. Buffers are committed resources in the default heap.
+class D3D12IndirectDrawFactory : public IndirectDrawFactory
+{
+public:
+    /// Construct.
+    explicit D3D12IndirectDrawFactory(ID3D12Device* device);
+
+    /// Create a buffer.
+    bool CreateBuffer(uint64_t size, GpuBufferInfo& info) override;
+    /// Release a buffer.
+    void DestroyBuffer(GpuBufferInfo& info) override;
+    /// Create a command signature of a root constant and indexed draw arguments.
+    CommandSignatureHandle CreateCommandSignature(RootSignatureHandle rootSignature, unsigned objectIndexParameter) override;
+    /// Release a command signature.
+    void ReleaseCommandSignature(CommandSignatureHandle signature) override;
+
+private:
+    /// Device
+    ID3D12Device* device_;
+};
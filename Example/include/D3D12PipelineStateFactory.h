@@ -0,0 +1,40 @@
+#pragma once
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+
+#include "PipelineCache.h"
+
+
+/// Pipeline state factory on a Direct3D12 device. Cached blobs are the driver's cached pipeline states and
+/// the device identity combines the adapter and its driver version, since a driver update invalidates them.
+class D3D12PipelineStateFactory : public PipelineStateFactory
+{
+public:
+    /// Construct.
+    D3D12PipelineStateFactory(ID3D12Device* device, IDXGIFactory1* factory);
+
+    /// Return adapter and driver identity.
+    uint64_t GetDeviceId() const override { return deviceId_; }
+    /// Create a graphics pipeline state and its root signature.
+    PipelineStateHandle CreatePipelineState(PipelineDesc const& desc, void const* cachedBlob, size_t cachedBlobSize) override;
+    /// Return the driver's cached blob of a pipeline state.
+    bool GetCachedBlob(PipelineStateHandle state, std::vector<uint8_t>& blob) override;
+    /// Release a pipeline state and its root signature.
+    void ReleasePipelineState(PipelineStateHandle state) override;
+
+private:
+    /// Device
+    ID3D12Device* device_;
+    /// Adapter and driver identity
+    uint64_t deviceId_{};
+};
+
+/// Pipeline state with the root signature it was created with.
+struct D3D12PipelineState
+{
+    /// Pipeline state
+    ID3D12PipelineState* pipelineState_{};
+    /// Root signature, null if the vertex shader embeds it
+    ID3D12RootSignature* rootSignature_{};
+};
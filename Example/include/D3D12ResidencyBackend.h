@@ -0,0 +1,40 @@
+#pragma once
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <vector>
+
+#include "ResidencyManager.h"
+
+
+/// Residency backend on a Direct3D12 device. The budget is the local segment DXGI reports for the device's
+/// adapter, objects are ID3D12Pageable.
+class D3D12ResidencyBackend : public ResidencyBackend
+{
+public:
+    /// Construct.
+    explicit D3D12ResidencyBackend(ID3D12Device* device);
+    /// Destruct.
+    ~D3D12ResidencyBackend() override;
+
+    /// Find the adapter of the device. Return false if it can not report a budget.
+    bool Initialize(IDXGIFactory1* factory);
+
+    /// Query budget and usage of local video memory.
+    bool QueryVideoMemory(VideoMemoryInfo& info) override;
+    /// Make objects resident with one call.
+    bool MakeResident(ResidencyObject const* objects, unsigned count) override;
+    /// Evict objects with one call.
+    void Evict(ResidencyObject const* objects, unsigned count) override;
+
+private:
+    /// Collect the pageables of objects.
+    void GetPageables(ResidencyObject const* objects, unsigned count);
+
+    /// Device
+    ID3D12Device* device_;
+    /// Adapter of the device
+    IDXGIAdapter3* adapter_{};
+    /// Pageables of the last call
+    std::vector<ID3D12Pageable*> pageables_;
+};
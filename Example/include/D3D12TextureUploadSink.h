@@ -0,0 +1,47 @@
+#pragma once
+
+#include <d3d12.h>
+#include <unordered_map>
+
+#include "GpuHeapAllocator.h"
+#include "TextureStreamer.h"
+
+class D3D12CommandList;
+class GraphicsImpl;
+
+/// Texture upload sink on a Direct3D12 device. Textures are placed resources and copies are recorded on a
+/// copy command list of the frame, submitted to the copy queue through the scheduler. Textures stay in the
+/// common state between command lists, copy and shader reads promote them implicitly. Block compressed
+/// textures need first mips whose size is a multiple of the block size, as power of two textures have.
+class D3D12TextureUploadSink : public TextureUploadSink
+{
+public:
+    /// Construct.
+    explicit D3D12TextureUploadSink(GraphicsImpl& graphics);
+    /// Destruct.
+    ~D3D12TextureUploadSink() override;
+
+    /// Create a placed texture and record the copy of the mips shared with the old one.
+    ResourceHandle CreateTexture(TextureFileInfo const& info, unsigned firstMip, ResourceHandle oldTexture,
+        unsigned oldFirstMip) override;
+    /// Release a texture and its heap memory once the GPU is done with them.
+    void ReleaseTexture(ResourceHandle texture) override;
+    /// Record the copy of a mip from staging memory.
+    void UploadMip(ResourceHandle texture, TextureFileInfo const& info, unsigned firstMip, unsigned mip,
+        UploadAllocation const& staging) override;
+    /// Submit the copy command list to the copy queue.
+    uint64_t Submit() override;
+    /// Return the last value the copy queue has reached.
+    uint64_t GetCompletedValue() override;
+
+private:
+    /// Return the copy command list of the frame, acquiring it on first use. Null on failure.
+    ID3D12GraphicsCommandList* GetCommandList();
+
+    /// Graphics implementation
+    GraphicsImpl& graphics_;
+    /// Copy command list recording since the last submit
+    D3D12CommandList* commandList_{};
+    /// Heap memory of the textures
+    std::unordered_map<ID3D12Resource*, GpuAllocation> allocations_;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include "GpuProfiler.h"
+
+
+/// Timestamp query source on a Direct3D12 queue. Queries are written and resolved on the backend's command
+/// list into a buffer in the READBACK heap, which is mapped only for the range being read.
+class D3D12TimestampQuerySource : public TimestampQuerySource
+{
+public:
+    /// Construct.
+    D3D12TimestampQuerySource(ID3D12Device* device, ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* commandList);
+    /// Destruct.
+    ~D3D12TimestampQuerySource() override;
+
+    /// Create the timestamp query heap and readback buffer.
+    bool Initialize(unsigned queryCount) override;
+    /// Release them.
+    void Shutdown() override;
+    /// Return timestamp frequency of the queue.
+    uint64_t GetFrequency() const override;
+    /// Sample the queue timestamp and the CPU profiler ticks.
+    bool GetClockCalibration(uint64_t& gpuTimestamp, uint64_t& cpuTicks) override;
+    /// Record a timestamp query.
+    void EndQuery(unsigned index) override;
+    /// Record resolve of queries into the readback buffer.
+    void ResolveQueries(unsigned first, unsigned count) override;
+    /// Map and copy a range of the readback buffer.
+    bool ReadQueries(unsigned first, unsigned count, uint64_t* timestamps) override;
+
+private:
+    /// Device
+    ID3D12Device* device_;
+    /// Queue the command list is executed on
+    ID3D12CommandQueue* queue_;
+    /// Command list
+    ID3D12GraphicsCommandList* commandList_;
+    /// Timestamp query heap
+    ID3D12QueryHeap* queryHeap_{};
+    /// Readback buffer
+    ID3D12Resource* readbackBuffer_{};
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include "GpuHeapAllocator.h"
+#include "RenderGraph.h"
+
+class GraphicsImpl;
+
+/// Transient resource factory on a Direct3D12 device. The heap is a render target allocation of the
+/// heap sub-allocator and textures are placed resources in it.
+class D3D12TransientResourceFactory : public TransientResourceFactory
+{
+public:
+    /// Construct.
+    explicit D3D12TransientResourceFactory(GraphicsImpl& graphics);
+    /// Destruct.
+    ~D3D12TransientResourceFactory() override;
+
+    /// Return size and placement alignment of a texture.
+    void GetAllocationInfo(TextureDesc const& desc, uint64_t& size, uint64_t& alignment) override;
+
+protected:
+    /// Allocate the transient heap.
+    bool CreateHeap(uint64_t size) override;
+    /// Free the transient heap once the GPU is done with it.
+    void ReleaseHeap() override;
+    /// Create a placed texture.
+    ResourceHandle CreateTexture(TextureDesc const& desc, uint64_t offset, unsigned initialState) override;
+    /// Release a texture once the GPU is done with it.
+    void ReleaseTexture(ResourceHandle texture) override;
+
+private:
+    /// Graphics implementation
+    GraphicsImpl& graphics_;
+    /// Transient heap
+    GpuAllocation heap_;
+};
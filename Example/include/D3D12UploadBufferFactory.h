@@ -0,0 +1,24 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include "UploadRing.h"
+
+
+/// Upload buffer factory on a Direct3D12 device. Buffers are committed resources in the UPLOAD heap,
+/// mapped once at creation and kept mapped until destroyed.
+class D3D12UploadBufferFactory : public UploadBufferFactory
+{
+public:
+    /// Construct.
+    explicit D3D12UploadBufferFactory(ID3D12Device* device);
+
+    /// Create and map a buffer.
+    bool CreateBuffer(uint64_t size, UploadBufferInfo& info) override;
+    /// Unmap and release a buffer.
+    void DestroyBuffer(UploadBufferInfo& info) override;
+
+private:
+    /// Device
+    ID3D12Device* device_;
+};
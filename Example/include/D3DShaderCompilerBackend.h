@@ -0,0 +1,24 @@
+#pragma once
+
+#include <d3dcompiler.h>
+
+#include "ShaderCompiler.h"
+
+
+/// Shader compiler backend on D3DCompile. Sources arrive with their includes expanded, so no include
+/// handler is needed.
+class D3DShaderCompilerBackend : public ShaderCompilerBackend
+{
+public:
+    /// Construct with D3DCOMPILE flags.
+    explicit D3DShaderCompilerBackend(unsigned flags);
+
+    /// Return compiler version and flags.
+    uint64_t GetVersion() const override;
+    /// Compile with D3DCompile.
+    bool Compile(std::string const& source, ShaderCompileDesc const& desc, std::vector<uint8_t>& bytecode, std::string& messages) override;
+
+private:
+    /// D3DCOMPILE flags
+    unsigned flags_;
+};
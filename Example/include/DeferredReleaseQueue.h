@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+
+/// Queue of objects retired with the fence value of their last use, released in batches once the GPU has
+/// reached that value so destroying an object never stalls the frame.
+class DeferredReleaseQueue
+{
+public:
+    /// Function releasing a retired object.
+    typedef void (*ReleaseFunction)(void* object);
+
+    /// Construct.
+    explicit DeferredReleaseQueue();
+    /// Destruct. Releases all objects still pending.
+    ~DeferredReleaseQueue();
+
+    DeferredReleaseQueue(DeferredReleaseQueue const&) = delete;
+    DeferredReleaseQueue& operator =(DeferredReleaseQueue const&) = delete;
+
+    /// Retire an object that the GPU may use until fenceValue is reached.
+    void Retire(void* object, ReleaseFunction release, uint64_t fenceValue, uint64_t bytes = 0);
+    /// Release objects whose fence value has been reached. Return number released.
+    unsigned ReleaseCompleted(uint64_t completedValue);
+    /// Release all objects regardless of the fence. Only safe once the GPU is idle.
+    unsigned ReleaseAll();
+
+    /// Return number of objects pending.
+    unsigned GetPendingCount() const { return (unsigned) entries_.size(); }
+    /// Return bytes pending.
+    uint64_t GetPendingBytes() const { return pendingBytes_; }
+    /// Return number of objects released so far.
+    uint64_t GetReleasedCount() const { return releasedCount_; }
+    /// Return bytes released so far.
+    uint64_t GetReleasedBytes() const { return releasedBytes_; }
+
+private:
+    /// Retired object
+    struct Entry
+    {
+        /// Object
+        void* object_;
+        /// Release function
+        ReleaseFunction release_;
+        /// Fence value of the last use
+        uint64_t fenceValue_;
+        /// Size in bytes
+        uint64_t bytes_;
+    };
+
+    /// Release the front entry.
+    void ReleaseFront();
+
+    /// Retired objects in retire order
+    std::deque<Entry> entries_;
+    /// Bytes pending
+    uint64_t pendingBytes_{};
+    /// Objects released
+    uint64_t releasedCount_{};
+    /// Bytes released
+    uint64_t releasedBytes_{};
+};
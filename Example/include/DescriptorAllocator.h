@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+
+/// Descriptor heap types, numerically identical to D3D12_DESCRIPTOR_HEAP_TYPE.
+enum DescriptorHeapType
+{
+    DESCRIPTOR_HEAP_CBV_SRV_UAV = 0,
+    DESCRIPTOR_HEAP_SAMPLER,
+    DESCRIPTOR_HEAP_RTV,
+    DESCRIPTOR_HEAP_DSV,
+    MAX_DESCRIPTOR_HEAP_TYPES
+};
+
+/// Descriptor heap created by a factory.
+struct DescriptorHeapInfo
+{
+    /// Native heap, an ID3D12DescriptorHeap for the Direct3D12 factory
+    void* heap_{};
+    /// CPU address of the first descriptor
+    size_t cpuStart_{};
+    /// GPU address of the first descriptor, zero if not shader visible
+    uint64_t gpuStart_{};
+    /// Distance between descriptors
+    unsigned increment_{};
+    /// Number of descriptors
+    unsigned capacity_{};
+};
+
+/// Creates descriptor heaps and copies descriptors between them. Implemented on the Direct3D12 device
+/// and by a null factory that only hands out addresses.
+class DescriptorHeapFactory
+{
+public:
+    /// Destruct.
+    virtual ~DescriptorHeapFactory() = default;
+
+    /// Create a heap. Return false on failure.
+    virtual bool CreateHeap(DescriptorHeapType type, unsigned capacity, bool shaderVisible, DescriptorHeapInfo& info) = 0;
+    /// Destroy a heap.
+    virtual void DestroyHeap(DescriptorHeapInfo& info) = 0;
+    /// Copy source ranges into one contiguous destination range.
+    virtual void CopyDescriptors(DescriptorHeapType type, size_t destStart, unsigned rangeCount,
+        size_t const* rangeStarts, unsigned const* rangeSizes) = 0;
+};
+
+/// Long lived descriptor in a CPU only heap.
+struct DescriptorAllocation
+{
+    /// Return whether the allocation is valid.
+    bool IsValid() const { return page_ != ~0u; }
+
+    /// CPU address
+    size_t cpu_{};
+    /// Page index
+    unsigned page_{~0u};
+    /// Index in the page
+    unsigned index_{};
+};
+
+/// Contiguous range of shader visible descriptors, valid until the frame it was allocated in completes.
+struct DescriptorTable
+{
+    /// Return whether the table is valid.
+    bool IsValid() const { return cpu_ != 0; }
+
+    /// CPU address of the first descriptor
+    size_t cpu_{};
+    /// GPU address of the first descriptor
+    uint64_t gpu_{};
+    /// Number of descriptors
+    unsigned count_{};
+};
+
+/// Paged CPU only descriptor heap with an O(1) free list per page. Grows a page at a time and never shrinks.
+class StagingDescriptorHeap
+{
+public:
+    /// Construct.
+    explicit StagingDescriptorHeap(DescriptorHeapFactory& factory, DescriptorHeapType type, unsigned pageSize = 256);
+    /// Destruct.
+    ~StagingDescriptorHeap();
+
+    /// Allocate one descriptor. Return an invalid allocation if a page could not be created.
+    DescriptorAllocation Allocate();
+    /// Free a descriptor.
+    void Free(DescriptorAllocation& allocation);
+
+    /// Return number of allocated descriptors.
+    unsigned GetAllocatedCount() const { return allocatedCount_; }
+    /// Return number of pages.
+    unsigned GetPageCount() const { return (unsigned) pages_.size(); }
+    /// Return allocated share of the page capacity.
+    float GetUtilization() const;
+
+private:
+    /// Heap page
+    struct Page
+    {
+        /// Heap
+        DescriptorHeapInfo info_;
+        /// Free indices, used as a stack
+        std::vector<unsigned> freeIndices_;
+        /// Listed in the available pages flag
+        bool available_;
+    };
+
+    /// Create a page and list it as available. Return false on failure.
+    bool AddPage();
+
+    /// Factory
+    DescriptorHeapFactory& factory_;
+    /// Heap type
+    DescriptorHeapType type_;
+    /// Descriptors per page
+    unsigned pageSize_;
+    /// Pages
+    std::vector<Page> pages_;
+    /// Pages with free descriptors, used as a stack
+    std::vector<unsigned> availablePages_;
+    /// Number of allocated descriptors
+    unsigned allocatedCount_{};
+};
+
+/// Linear ring of shader visible descriptors. Each frame allocates from the head and the space is
+/// reclaimed once the GPU has passed the fence value the frame ended with.
+class DescriptorRing
+{
+public:
+    /// Construct.
+    explicit DescriptorRing(DescriptorHeapFactory& factory, DescriptorHeapType type, unsigned capacity);
+    /// Destruct.
+    ~DescriptorRing();
+
+    /// Return whether the heap was created.
+    bool IsValid() const { return info_.heap_ != nullptr; }
+    /// Allocate contiguous descriptors. Return an invalid table if the ring is full.
+    DescriptorTable Allocate(unsigned count);
+    /// Close the current frame, its space is reclaimed once fenceValue completes.
+    void EndFrame(uint64_t fenceValue);
+    /// Reclaim the space of completed frames.
+    void Reclaim(uint64_t completedValue);
+
+    /// Return heap.
+    DescriptorHeapInfo const& GetHeapInfo() const { return info_; }
+    /// Return number of descriptors in use, including space skipped when wrapping.
+    unsigned GetUsedCount() const { return usedCount_; }
+    /// Return highest number of descriptors in use.
+    unsigned GetPeakUsedCount() const { return peakUsedCount_; }
+    /// Return number of failed allocations.
+    unsigned GetOverflowCount() const { return overflowCount_; }
+
+private:
+    /// Space of an ended frame
+    struct FrameSpace
+    {
+        /// Fence value the frame ended with
+        uint64_t fenceValue_;
+        /// Descriptors used
+        unsigned count_;
+    };
+
+    /// Factory
+    DescriptorHeapFactory& factory_;
+    /// Heap
+    DescriptorHeapInfo info_;
+    /// Ended frames not completed yet
+    std::deque<FrameSpace> frames_;
+    /// Next free descriptor
+    unsigned head_{};
+    /// Descriptors in use
+    unsigned usedCount_{};
+    /// Descriptors used by the current frame
+    unsigned frameCount_{};
+    /// Peak descriptors in use
+    unsigned peakUsedCount_{};
+    /// Failed allocations
+    unsigned overflowCount_{};
+};
+
+/// Descriptor statistics of the allocator.
+struct DescriptorStats
+{
+    /// Tables copied into the shader visible ring
+    unsigned tables_{};
+    /// Descriptors copied
+    unsigned descriptors_{};
+    /// Source ranges after coalescing adjacent descriptors
+    unsigned ranges_{};
+};
+
+/// Descriptor allocation subsystem: CPU only staging heaps for every heap type and a shader visible
+/// ring that transient tables are copied into in bulk.
+class DescriptorAllocator
+{
+public:
+    /// Construct.
+    explicit DescriptorAllocator();
+    /// Destruct.
+    ~DescriptorAllocator();
+
+    /// Create the heaps. Return false on failure.
+    bool Initialize(DescriptorHeapFactory& factory, unsigned ringCapacity = 65536, unsigned pageSize = 256);
+    /// Destroy the heaps. Outstanding allocations become invalid.
+    void Shutdown();
+    /// Return whether initialized.
+    bool IsInitialized() const { return ring_ != nullptr; }
+
+    /// Allocate a long lived CPU only descriptor.
+    DescriptorAllocation Allocate(DescriptorHeapType type);
+    /// Free a long lived descriptor.
+    void Free(DescriptorHeapType type, DescriptorAllocation& allocation);
+    /// Copy CPU only descriptors into a new table in the shader visible ring.
+    DescriptorTable CopyToTable(size_t const* sources, unsigned count);
+
+    /// Reclaim ring space of completed frames.
+    void BeginFrame(uint64_t completedValue);
+    /// Close the frame in the ring.
+    void EndFrame(uint64_t fenceValue);
+
+    /// Return staging heap of a type.
+    StagingDescriptorHeap* GetStagingHeap(DescriptorHeapType type) const { return stagingHeaps_[type].get(); }
+    /// Return shader visible ring.
+    DescriptorRing* GetRing() const { return ring_.get(); }
+    /// Return statistics since the last BeginFrame.
+    DescriptorStats const& GetStats() const { return stats_; }
+
+private:
+    /// Factory
+    DescriptorHeapFactory* factory_{};
+    /// Staging heaps per type
+    std::unique_ptr<StagingDescriptorHeap> stagingHeaps_[MAX_DESCRIPTOR_HEAP_TYPES];
+    /// Shader visible CBV SRV UAV ring
+    std::unique_ptr<DescriptorRing> ring_;
+    /// Coalesced source range starts
+    std::vector<size_t> rangeStarts_;
+    /// Coalesced source range sizes
+    std::vector<unsigned> rangeSizes_;
+    /// Statistics
+    DescriptorStats stats_;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "GpuFence.h"
+#include "WaitEvent.h"
+
+
+/// Monotonic timeline of sync points on a queue fence. Pools the events used for blocking waits and runs
+/// callbacks once the GPU has passed the value they were registered for.
+class FenceTimeline
+{
+public:
+    /// Construct.
+    explicit FenceTimeline();
+    /// Destruct.
+    ~FenceTimeline();
+
+    /// Set the fence the timeline signals and waits on.
+    void SetFence(GpuFence* fence);
+    /// Return the fence.
+    GpuFence* GetFence() const { return fence_; }
+
+    /// Signal the next sync point after all previously submitted work and return it.
+    uint64_t Signal();
+    /// Return the last signaled sync point.
+    uint64_t GetLastSignaledValue() const { return lastSignaledValue_; }
+    /// Return the last sync point reached by the GPU.
+    uint64_t GetCompletedValue();
+    /// Return whether the GPU has reached value, without blocking.
+    bool IsComplete(uint64_t value);
+    /// Block until the GPU has reached value, then run due callbacks.
+    void Wait(uint64_t value);
+    /// Signal a sync point and wait for it.
+    void Flush();
+
+    /// Register a callback to run once the GPU has reached value. Runs from Poll or Wait on the calling thread.
+    void OnCompletion(uint64_t value, std::function<void()> callback);
+    /// Run callbacks whose value the GPU has reached. Return number of callbacks run.
+    unsigned Poll();
+    /// Return number of callbacks not run yet.
+    unsigned GetPendingCallbackCount() const;
+
+    /// Return number of waits that had to block.
+    uint64_t GetBlockingWaitCount() const { return blockingWaitCount_; }
+    /// Return total time spent blocked in Wait.
+    std::chrono::microseconds GetWaitTime() const { return std::chrono::microseconds(waitTime_.load()); }
+    /// Return number of wait events created, which stays at the peak number of concurrent waiters.
+    unsigned GetWaitEventCount() const { return waitEventCount_; }
+
+private:
+    /// Callback registered for a sync point
+    struct Callback
+    {
+        /// Sync point
+        uint64_t value_;
+        /// Function to run
+        std::function<void()> function_;
+    };
+
+    /// Take an event from the pool or create one.
+    std::unique_ptr<WaitEvent> AcquireWaitEvent();
+    /// Return an event to the pool.
+    void ReleaseWaitEvent(std::unique_ptr<WaitEvent> event);
+
+    /// Fence
+    GpuFence* fence_{};
+    /// Last signaled sync point
+    uint64_t lastSignaledValue_{};
+    /// Cached completed sync point, avoids querying the fence for values known to be complete
+    std::atomic<uint64_t> completedValue_{};
+    /// Lock for callbacks and the event pool
+    mutable std::mutex mutex_;
+    /// Pending callbacks ordered by sync point
+    std::deque<Callback> callbacks_;
+    /// Idle wait events
+    std::vector<std::unique_ptr<WaitEvent> > freeEvents_;
+    /// Number of wait events created
+    unsigned waitEventCount_{};
+    /// Number of blocking waits
+    std::atomic<uint64_t> blockingWaitCount_{};
+    /// Total blocked time in microseconds
+    std::atomic<int64_t> waitTime_{};
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include "FenceTimeline.h"
+
+
+/// Tracks the fence value of every frame slot so the CPU only waits for the slot it is about to reuse.
+class FramePacer
+{
+public:
+    /// Maximum number of frames the CPU may record ahead of the GPU.
+    static constexpr unsigned MaxFramesInFlight{3};
+
+    /// Construct.
+    explicit FramePacer(unsigned framesInFlight = 2);
+
+    /// Set number of frames in flight, clamped to [1, MaxFramesInFlight].
+    void SetFramesInFlight(unsigned count);
+    /// Return number of frames in flight.
+    unsigned GetFramesInFlight() const { return framesInFlight_; }
+
+    /// Wait until the GPU has finished with the next frame slot and return its index.
+    unsigned BeginFrame(FenceTimeline& timeline);
+    /// Remember the fence value signaled at the end of the current frame.
+    void EndFrame(uint64_t fenceValue);
+    /// Remember the fence value of work submitted from the current slot's allocator outside Begin and End.
+    void ExtendFrame(uint64_t fenceValue);
+    /// Wait until the GPU has finished all frames in flight.
+    void WaitIdle(FenceTimeline& timeline);
+
+    /// Return current frame slot index.
+    unsigned GetFrameIndex() const { return frameIndex_; }
+    /// Return number of frames ended so far.
+    uint64_t GetFrameNumber() const { return frameNumber_; }
+    /// Return fence value the given frame slot was last submitted with.
+    uint64_t GetFrameFenceValue(unsigned index) const { return frameFenceValues_[index]; }
+    /// Return number of BeginFrame calls that had to block on the GPU.
+    uint64_t GetStallCount() const { return stallCount_; }
+
+private:
+    /// Fence value per frame slot
+    uint64_t frameFenceValues_[MaxFramesInFlight]{};
+    /// Number of frames in flight
+    unsigned framesInFlight_{};
+    /// Current frame slot
+    unsigned frameIndex_{};
+    /// Number of ended frames
+    uint64_t frameNumber_{};
+    /// Number of blocking waits
+    uint64_t stallCount_{};
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "Matrix.h"
+#include "SceneSystems.h"
+#include "SpscQueue.h"
+#include "TransformBatch.h"
+#include "WaitEvent.h"
+
+
+/// Everything the render thread needs from the simulation for one frame. Written only by the simulation
+/// thread until published, then read only by the render thread until released.
+struct FramePacket
+{
+    /// Simulation frame number
+    uint64_t frameNumber_{};
+    /// Simulation time after the frame's steps in seconds
+    double time_{};
+    /// Interpolation factor between the previous and current simulation state
+    double interpolation_{};
+    /// Simulation steps run for the frame
+    unsigned steps_{};
+    /// Back buffer clear color
+    float clearColor_[4]{};
+    /// Camera view-projection
+    Matrix4 viewProjection_;
+    /// Indices of the objects visible to the camera in increasing order, capacity kept as packets recycle
+    std::vector<unsigned> visibleObjects_;
+    /// World space boxes of the visible objects in the same order, for occlusion culling on the render thread
+    BoundsArray visibleBounds_;
+    /// World transforms of the scene renderables that changed during the frame, for the object buffer
+    RenderableChanges changedRenderables_;
+};
+
+/// Runs the simulation on a thread of its own one frame ahead of rendering. The simulation thread fills
+/// free packets and publishes them, the render thread takes published packets in order and releases them
+/// when submitted. Packets circulate through two lock-free queues, so neither side takes a lock, and with
+/// three packets the simulation can fill one while one is rendered and one waits.
+class FramePipeline
+{
+public:
+    /// Number of packets
+    static constexpr unsigned PacketCount{3};
+    /// Simulation function filling a packet
+    typedef std::function<void(FramePacket&)> SimulateFunction;
+
+    /// Construct.
+    explicit FramePipeline();
+    /// Destruct. Stops the simulation thread.
+    ~FramePipeline();
+
+    /// Start the simulation thread.
+    void Start(SimulateFunction const& simulate);
+    /// Stop the simulation thread after the frame it is on and discard published packets.
+    void Stop();
+    /// Return whether the simulation thread runs.
+    bool IsRunning() const { return thread_.joinable(); }
+
+    /// Return the next published packet, blocking until there is one. Render thread only. Null once stopped.
+    FramePacket const* AcquirePacket();
+    /// Return a rendered packet for reuse. Render thread only.
+    void ReleasePacket(FramePacket const* packet);
+
+    /// Return number of times the simulation waited for a free packet, rendering being the bottleneck.
+    uint64_t GetSimulationWaitCount() const { return simulationWaits_.load(std::memory_order_relaxed); }
+    /// Return number of times rendering waited for a published packet, simulation being the bottleneck.
+    uint64_t GetRenderWaitCount() const { return renderWaits_; }
+
+private:
+    /// Simulation thread entry.
+    void ThreadFunction(SimulateFunction simulate);
+
+    /// Packets
+    FramePacket packets_[PacketCount];
+    /// Packets free for the simulation
+    SpscQueue<FramePacket*> freePackets_{4};
+    /// Packets published for rendering
+    SpscQueue<FramePacket*> readyPackets_{4};
+    /// Set when a packet is freed or on stop
+    WaitEvent freeEvent_;
+    /// Set when a packet is published or on stop
+    WaitEvent readyEvent_;
+    /// Simulation thread
+    std::thread thread_;
+    /// Stop flag
+    std::atomic<bool> stopping_{};
+    /// Simulation waits for a free packet
+    std::atomic<uint64_t> simulationWaits_{};
+    /// Render waits for a published packet
+    uint64_t renderWaits_{};
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+
+/// Time source of frame timing. The steady clock when running, a virtual clock when stepping timing logic
+/// deterministically.
+class FrameClock
+{
+public:
+    /// Destruct.
+    virtual ~FrameClock() = default;
+
+    /// Return current time in microseconds.
+    virtual int64_t GetMicroseconds() = 0;
+    /// Block until a time in microseconds.
+    virtual void SleepUntil(int64_t microseconds) = 0;
+};
+
+/// Frame clock on the steady clock. Sleeps coarsely and spins the last stretch, as the OS wakes late.
+class SteadyFrameClock : public FrameClock
+{
+public:
+    /// Time before the target spent spinning instead of sleeping, in microseconds
+    static constexpr int64_t SpinMargin{2000};
+
+    /// Return steady clock time.
+    int64_t GetMicroseconds() override;
+    /// Sleep and spin until a time.
+    void SleepUntil(int64_t microseconds) override;
+};
+
+/// Frame clock that only moves when advanced or slept on.
+class VirtualFrameClock : public FrameClock
+{
+public:
+    /// Return virtual time.
+    int64_t GetMicroseconds() override { return time_; }
+    /// Jump to a time if it is later.
+    void SleepUntil(int64_t microseconds) override;
+
+    /// Advance time.
+    void Advance(int64_t microseconds) { time_ += microseconds; }
+    /// Return number of sleeps that moved time.
+    uint64_t GetSleepCount() const { return sleepCount_; }
+    /// Return total time slept.
+    int64_t GetSleepTime() const { return sleepTime_; }
+
+private:
+    /// Current time
+    int64_t time_{};
+    /// Sleeps that moved time
+    uint64_t sleepCount_{};
+    /// Total time slept
+    int64_t sleepTime_{};
+};
+
+/// Fixed timestep frame timing. Real elapsed time goes into an accumulator that is consumed in whole
+/// simulation steps, so the simulation advances identically at any frame rate; the remainder is the
+/// interpolation factor between the last two simulation states for rendering. Optionally caps the frame
+/// rate by sleeping until the next frame is due.
+class FrameTimer
+{
+public:
+    /// Construct with a clock.
+    explicit FrameTimer(FrameClock& clock);
+
+    /// Set simulation timestep in microseconds.
+    void SetTimestep(int64_t microseconds);
+    /// Return simulation timestep in microseconds.
+    int64_t GetTimestep() const { return timestep_; }
+    /// Return simulation timestep in seconds.
+    double GetTimestepSeconds() const { return timestep_ * 1e-6; }
+    /// Set maximum simulation steps per frame. Time beyond them is dropped so a slow frame cannot make
+    /// the next one slower still.
+    void SetMaxSteps(unsigned steps);
+    /// Set frame rate cap, 0 for none.
+    void SetFrameRateLimit(unsigned framesPerSecond);
+    /// Return frame rate cap.
+    unsigned GetFrameRateLimit() const { return frameRateLimit_; }
+
+    /// Restart timing from now with an empty accumulator.
+    void Reset();
+    /// Wait for the frame rate cap, measure the frame and return number of simulation steps to run.
+    unsigned BeginFrame();
+
+    /// Return interpolation factor between the previous and current simulation state, in [0, 1).
+    double GetInterpolation() const { return (double) accumulator_ / (double) timestep_; }
+    /// Return real time of the last frame in microseconds.
+    int64_t GetFrameTime() const { return frameTime_; }
+    /// Return number of frames.
+    uint64_t GetFrameCount() const { return frameCount_; }
+    /// Return number of simulation steps.
+    uint64_t GetStepCount() const { return stepCount_; }
+    /// Return time dropped because frames needed more than the maximum steps, in microseconds.
+    int64_t GetDroppedTime() const { return droppedTime_; }
+
+private:
+    /// Clock
+    FrameClock& clock_;
+    /// Simulation timestep
+    int64_t timestep_{1000000 / 60};
+    /// Maximum simulation steps per frame
+    unsigned maxSteps_{8};
+    /// Frame rate cap
+    unsigned frameRateLimit_{};
+    /// Time of the last frame
+    int64_t lastTime_{};
+    /// Time the next frame is due under the cap
+    int64_t nextFrameTime_{};
+    /// Time not simulated yet
+    int64_t accumulator_{};
+    /// Real time of the last frame
+    int64_t frameTime_{};
+    /// Frames
+    uint64_t frameCount_{};
+    /// Simulation steps
+    uint64_t stepCount_{};
+    /// Dropped time
+    int64_t droppedTime_{};
+};
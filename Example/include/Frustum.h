@@ -0,0 +1,42 @@
+#pragma once
+
+#include "BoundingBox.h"
+#include "Matrix.h"
+#include "Vector.h"
+
+
+/// Plane of points p with normal_.Dot(p) + d_ == 0, the normal pointing to the positive half space.
+struct Plane
+{
+    /// Return signed distance of a point, in units of the normal length.
+    float Distance(Vector3 const& point) const { return normal_.Dot(point) + d_; }
+
+    /// Normal
+    Vector3 normal_;
+    /// Distance term
+    float d_{};
+};
+
+/// View frustum as six planes facing inwards: left, right, bottom, top, near and far.
+class Frustum
+{
+public:
+    /// Number of planes
+    static constexpr unsigned PlaneCount{6};
+
+    /// Construct the clip space volume of an identity view-projection.
+    Frustum() : Frustum(Matrix4()) {}
+    /// Construct from a view-projection matrix with a depth range of 0 to 1.
+    explicit Frustum(Matrix4 const& viewProjection);
+
+    /// Return whether a sphere is at least partially inside.
+    bool IsVisible(BoundingSphere const& sphere) const;
+    /// Return whether a box is at least partially inside, conservatively near the edges.
+    bool IsVisible(BoundingBox const& box) const;
+    /// Return a plane.
+    Plane const& GetPlane(unsigned index) const { return planes_[index]; }
+
+private:
+    /// Planes with unit normals
+    Plane planes_[PlaneCount];
+};
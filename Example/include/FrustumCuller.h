@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+
+#include "Frustum.h"
+#include "TransformBatch.h"
+
+
+class JobSystem;
+
+/// Visibility statistics of the last cull.
+struct CullStats
+{
+    /// Objects tested
+    unsigned objects_{};
+    /// Objects rejected by their sphere
+    unsigned sphereCulled_{};
+    /// Objects passing their sphere but rejected by their box
+    unsigned boxCulled_{};
+    /// Objects visible
+    unsigned visible_{};
+    /// Batches run as jobs, 0 when culled inline
+    unsigned jobs_{};
+};
+
+/// Frustum culling of objects by world space bounding spheres and boxes kept in structure of arrays
+/// layout. FloatN objects are tested per iteration: first their spheres against all planes, then the boxes
+/// of the lanes still visible. Batches run as jobs and write the indices of visible objects at their own
+/// offset of the output, which is compacted afterwards, so the list keeps index order without atomics.
+class FrustumCuller
+{
+public:
+    /// Default objects per job, a multiple of every lane width
+    static constexpr unsigned DefaultBatchSize{8192};
+
+    /// Construct.
+    explicit FrustumCuller();
+
+    /// Set job system to cull on, null to cull on the calling thread.
+    void SetJobSystem(JobSystem* jobSystem) { jobSystem_ = jobSystem; }
+    /// Set objects per job, rounded up to a multiple of 8.
+    void SetBatchSize(unsigned size) { batchSize_ = size ? (size + 7) & ~7u : DefaultBatchSize; }
+    /// Set number of objects, keeping the bounds of existing ones.
+    void Resize(unsigned count);
+    /// Return number of objects.
+    unsigned GetObjectCount() const { return spheres_.GetSize(); }
+    /// Set world space bounds of an object.
+    void SetBounds(unsigned index, BoundingSphere const& sphere, BoundingBox const& box);
+    /// Set world space bounds of an object by its box alone.
+    void SetBounds(unsigned index, BoundingBox const& box) { SetBounds(index, BoundingSphere::FromBox(box), box); }
+    /// Return spheres for batch kernels to write.
+    SphereArray& GetSpheres() { return spheres_; }
+    /// Return boxes for batch kernels to write.
+    BoundsArray& GetBoxes() { return boxes_; }
+
+    /// Fill the indices of objects at least partially inside a frustum in increasing order. Return their count.
+    unsigned Cull(Frustum const& frustum, std::vector<unsigned>& visible);
+    /// Cull one object at a time with the scalar Frustum tests, the reference Cull must agree with.
+    unsigned CullReference(Frustum const& frustum, std::vector<unsigned>& visible) const;
+    /// Copy the boxes of objects into dest in the order of their indices.
+    void GetBoxes(std::vector<unsigned> const& indices, BoundsArray& dest) const;
+    /// Return statistics of the last Cull.
+    CullStats const& GetStats() const { return stats_; }
+
+private:
+    /// Per-batch result
+    struct BatchResult
+    {
+        /// Visible objects, written from the batch's first index on
+        unsigned visible_;
+        /// Objects rejected by their sphere
+        unsigned sphereCulled_;
+        /// Objects rejected by their box
+        unsigned boxCulled_;
+    };
+
+    /// Cull objects [begin, end), writing visible indices from visible + begin on.
+    BatchResult CullRange(Frustum const& frustum, unsigned begin, unsigned end, unsigned* visible) const;
+
+    /// World space spheres
+    SphereArray spheres_;
+    /// World space boxes
+    BoundsArray boxes_;
+    /// Job system, null to cull inline
+    JobSystem* jobSystem_{};
+    /// Objects per job
+    unsigned batchSize_{DefaultBatchSize};
+    /// Results of the batches of the current cull
+    std::vector<BatchResult> batches_;
+    /// Statistics
+    CullStats stats_;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+#include "WaitEvent.h"
+
+
+/// Fence of a GPU queue. Implemented by the Direct3D12 queue and by the simulated queue.
+class GpuFence
+{
+public:
+    /// Destruct.
+    virtual ~GpuFence() = default;
+
+    /// Enqueue a signal of value on the queue, reached after all previously submitted work.
+    virtual void Signal(uint64_t value) = 0;
+    /// Return the last value reached by the queue.
+    virtual uint64_t GetCompletedValue() const = 0;
+    /// Set event once the queue has reached value, immediately if it already has.
+    virtual void SetEventOnCompletion(uint64_t value, WaitEvent& event) = 0;
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "TlsfAllocator.h"
+
+class ResidencyManager;
+
+
+/// Kinds of resources a heap may hold. Resource heap tier 1 hardware cannot mix them in one heap.
+enum GpuHeapCategory
+{
+    GPU_HEAP_BUFFERS = 0,
+    GPU_HEAP_TEXTURES,
+    GPU_HEAP_RENDER_TARGETS,
+    MAX_GPU_HEAP_CATEGORIES
+};
+
+/// Heap created by a factory.
+struct GpuHeapInfo
+{
+    /// Native heap, an ID3D12Heap for the Direct3D12 factory
+    void* heap_{};
+    /// Size in bytes
+    uint64_t size_{};
+};
+
+/// Creates GPU memory heaps. Implemented on the Direct3D12 device and by a null factory without memory.
+class GpuHeapFactory
+{
+public:
+    /// Destruct.
+    virtual ~GpuHeapFactory() = default;
+
+    /// Create a heap for a category of resources. Return false on failure.
+    virtual bool CreateHeap(GpuHeapCategory category, uint64_t size, GpuHeapInfo& info) = 0;
+    /// Destroy a heap.
+    virtual void DestroyHeap(GpuHeapInfo& info) = 0;
+};
+
+/// Placement of a resource in a heap.
+struct GpuAllocation
+{
+    /// Return whether the allocation is valid.
+    bool IsValid() const { return heap_ != nullptr; }
+
+    /// Native heap
+    void* heap_{};
+    /// Offset in the heap
+    uint64_t offset_{};
+    /// Size in bytes
+    uint64_t size_{};
+    /// Category
+    GpuHeapCategory category_{};
+    /// Heap block index in the category
+    unsigned block_{};
+    /// Range in the heap block
+    TlsfAllocation range_;
+};
+
+/// Memory statistics of heaps, for deciding when defragmentation would pay off.
+struct GpuHeapStats
+{
+    /// Return share of free bytes outside the largest free region of their block.
+    float GetFragmentation() const
+    {
+        uint64_t freeSize = reservedSize_ - allocatedSize_;
+        return freeSize ? (float) fragmentedSize_ / (float) freeSize : 0.0f;
+    }
+
+    /// Heap blocks
+    unsigned blocks_{};
+    /// Allocations
+    unsigned allocations_{};
+    /// Bytes in heap blocks
+    uint64_t reservedSize_{};
+    /// Bytes allocated
+    uint64_t allocatedSize_{};
+    /// Free regions
+    unsigned freeRegions_{};
+    /// Largest free region of any block
+    uint64_t largestFreeRegion_{};
+    /// Free bytes outside the largest free region of their block
+    uint64_t fragmentedSize_{};
+};
+
+/// Sub-allocates large GPU heaps per resource category so resources are placed in them instead of each
+/// getting an implicit heap of its own. Each heap block is managed by a TLSF allocator. Requests larger than
+/// the block size get a dedicated block, and empty blocks are destroyed unless they are the last of their category.
+/// Heap blocks are the unit of residency: render target heaps are pinned, the others may be evicted.
+class GpuHeapAllocator
+{
+public:
+    /// Construct.
+    explicit GpuHeapAllocator();
+    /// Destruct.
+    ~GpuHeapAllocator();
+
+    /// Set the factory and the size of new heap blocks.
+    void Initialize(GpuHeapFactory& factory, uint64_t blockSize = 64 * 1024 * 1024);
+    /// Destroy all heap blocks. Outstanding allocations become invalid.
+    void Shutdown();
+    /// Return whether initialized.
+    bool IsInitialized() const { return factory_ != nullptr; }
+    /// Set residency manager to track heap blocks in, null for none. Set before any block is created.
+    void SetResidencyManager(ResidencyManager* residency) { residency_ = residency; }
+
+    /// Allocate at a power of two alignment. Return an invalid allocation if no heap could be created.
+    GpuAllocation Allocate(GpuHeapCategory category, uint64_t size, uint64_t alignment);
+    /// Free an allocation. Resources placed in it must already be released.
+    void Free(GpuAllocation& allocation);
+
+    /// Return statistics of a category.
+    GpuHeapStats GetStats(GpuHeapCategory category) const;
+    /// Return statistics of all categories.
+    GpuHeapStats GetTotalStats() const;
+
+private:
+    /// Heap with its allocator
+    struct HeapBlock
+    {
+        /// Construct.
+        explicit HeapBlock(GpuHeapInfo const& info) : info_(info), allocator_(info.size_) { }
+
+        /// Heap
+        GpuHeapInfo info_;
+        /// Ranges in the heap
+        TlsfAllocator allocator_;
+    };
+
+    /// Add statistics of a category.
+    void AddStats(GpuHeapCategory category, GpuHeapStats& stats) const;
+
+    /// Destroy a heap block.
+    void DestroyBlock(HeapBlock& block);
+
+    /// Factory
+    GpuHeapFactory* factory_{};
+    /// Residency manager, null for none
+    ResidencyManager* residency_{};
+    /// Size of new heap blocks
+    uint64_t blockSize_{};
+    /// Heap blocks per category, destroyed blocks leave an empty slot for reuse
+    std::vector<std::unique_ptr<HeapBlock>> blocks_[MAX_GPU_HEAP_CATEGORIES];
+};
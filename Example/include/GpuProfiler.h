@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FramePacer.h"
+#include "Profiler.h"
+
+/// Writes GPU timestamps into a query heap and resolves them into a readback buffer of the same slot count.
+/// Implemented on a Direct3D12 timestamp query heap and by a null source with a simulated GPU clock.
+class TimestampQuerySource
+{
+public:
+    /// Destruct.
+    virtual ~TimestampQuerySource() = default;
+
+    /// Create the query heap and readback buffer. Return false on failure.
+    virtual bool Initialize(unsigned queryCount) = 0;
+    /// Destroy them. Only safe once the GPU is idle.
+    virtual void Shutdown() = 0;
+    /// Return GPU timestamp ticks per second.
+    virtual uint64_t GetFrequency() const = 0;
+    /// Sample the GPU timestamp and Profiler::GetTicks at the same moment. Return false on failure.
+    virtual bool GetClockCalibration(uint64_t& gpuTimestamp, uint64_t& cpuTicks) = 0;
+    /// Record a timestamp write into a query.
+    virtual void EndQuery(unsigned index) = 0;
+    /// Record the copy of queries into the same slots of the readback buffer.
+    virtual void ResolveQueries(unsigned first, unsigned count) = 0;
+    /// Read resolved timestamps. Only valid once the GPU has executed the resolve. Return false on failure.
+    virtual bool ReadQueries(unsigned first, unsigned count, uint64_t* timestamps) = 0;
+};
+
+/// GPU zone of a completed frame.
+struct GpuZoneTiming
+{
+    /// Name
+    std::string name_;
+    /// Start in microseconds of the CPU profiler timeline
+    double start_;
+    /// Duration in microseconds
+    double duration_;
+    /// Nesting depth
+    unsigned depth_;
+};
+
+/// GPU profiler statistics.
+struct GpuProfilerStats
+{
+    /// Frames read back
+    uint64_t framesRead_{};
+    /// Frames whose zones were dropped because their slot was still in flight
+    uint64_t framesDropped_{};
+    /// Zones dropped because a frame had more than the maximum
+    uint64_t zonesDropped_{};
+    /// Clock calibrations
+    uint64_t calibrations_{};
+};
+
+/// Hierarchical GPU timing without stalls. Zones write begin and end timestamps into the current frame's
+/// range of the query heap, which is resolved into the readback buffer at the end of the frame. A frame's
+/// results are read once the fence value it ended with has completed, so they appear a few frames late and
+/// the CPU never waits for them. Timestamps are converted to the CPU profiler timeline through periodic
+/// clock calibration so GPU zones line up with CPU zones in the same trace.
+class GpuProfiler
+{
+public:
+    /// Frames whose queries can be outstanding: those in flight and the one being recorded
+    static constexpr unsigned FrameCount{FramePacer::MaxFramesInFlight + 1};
+    /// Frames between clock calibrations
+    static constexpr unsigned CalibrationInterval{60};
+
+    /// Construct.
+    explicit GpuProfiler();
+    /// Destruct.
+    ~GpuProfiler();
+
+    /// Create queries for up to maxZones zones per frame. Return false on failure.
+    bool Initialize(TimestampQuerySource& source, unsigned maxZones = 256);
+    /// Release queries. Only safe once the GPU is idle.
+    void Shutdown();
+    /// Return whether initialized.
+    bool IsInitialized() const { return source_ != nullptr; }
+    /// Set CPU profiler that completed zones are added to on a GPU track, null for none.
+    void SetProfiler(Profiler* profiler);
+
+    /// Read back frames completed up to a fence value and start recording a new frame.
+    void BeginFrame(uint64_t completedValue);
+    /// Begin a zone nested in the open ones. Return zone index, or ~0u if the frame is full.
+    unsigned BeginZone(std::string const& name);
+    /// End a zone.
+    void EndZone(unsigned zone);
+    /// Resolve the frame's queries and close it. The frame is read once fenceValue completes.
+    void EndFrame(uint64_t fenceValue);
+
+    /// Return zones of the most recently read frame.
+    std::vector<GpuZoneTiming> const& GetLastFrameZones() const { return lastFrameZones_; }
+    /// Return number of frames ended but not read yet.
+    unsigned GetPendingFrameCount() const;
+    /// Return statistics.
+    GpuProfilerStats const& GetStats() const { return stats_; }
+
+    /// Convert a GPU timestamp to microseconds of the CPU profiler timeline.
+    double TimestampToMicroseconds(uint64_t timestamp) const;
+
+private:
+    /// Zone of a frame
+    struct Zone
+    {
+        /// Name
+        std::string name_;
+        /// Nesting depth
+        unsigned depth_;
+    };
+
+    /// Queries of one frame
+    struct Frame
+    {
+        /// Zones, allocated once so names reuse their capacity
+        std::vector<Zone> zones_;
+        /// Zones used
+        unsigned zoneCount_{};
+        /// Fence value the frame ended with
+        uint64_t fenceValue_{};
+        /// Ended and not read flag
+        bool pending_{};
+    };
+
+    /// Read a completed frame.
+    void ReadFrame(Frame& frame, unsigned slot);
+    /// Sample the GPU and CPU clocks.
+    void Calibrate();
+
+    /// Query source
+    TimestampQuerySource* source_{};
+    /// CPU profiler to add zones to
+    Profiler* profiler_{};
+    /// Track of GPU zones in the CPU profiler
+    unsigned track_{};
+    /// Frame slots, two queries per zone
+    Frame frames_[FrameCount];
+    /// Slot of the frame being recorded
+    unsigned current_{};
+    /// Frame being recorded has a free slot flag
+    bool recording_{};
+    /// Zones per frame
+    unsigned maxZones_{};
+    /// Open zones of the current frame
+    std::vector<unsigned> zoneStack_;
+    /// Timestamps scratch
+    std::vector<uint64_t> timestamps_;
+    /// Zones of the most recently read frame
+    std::vector<GpuZoneTiming> lastFrameZones_;
+    /// GPU timestamp frequency
+    uint64_t frequency_{};
+    /// GPU timestamp of the last calibration
+    uint64_t calibrationGpu_{};
+    /// CPU profiler time of the last calibration in microseconds
+    double calibrationCpu_{};
+    /// Frames since the last calibration
+    unsigned framesSinceCalibration_{};
+    /// Statistics
+    GpuProfilerStats stats_;
+};
+
+/// GPU zone timing its scope.
+class GpuProfileScope
+{
+public:
+    /// Begin a zone.
+    GpuProfileScope(GpuProfiler& profiler, std::string const& name)
+        : profiler_(profiler)
+        , zone_(profiler.IsInitialized() ? profiler.BeginZone(name) : ~0u)
+    {
+    }
+
+    /// End the zone.
+    ~GpuProfileScope()
+    {
+        if (zone_ != ~0u)
+            profiler_.EndZone(zone_);
+    }
+
+    GpuProfileScope(GpuProfileScope const&) = delete;
+    GpuProfileScope& operator =(GpuProfileScope const&) = delete;
+
+private:
+    /// Profiler
+    GpuProfiler& profiler_;
+    /// Zone index
+    unsigned zone_;
+};
+
+#ifndef DISABLE_PROFILER
+/// Time the GPU work recorded in the enclosing scope.
+#define PROFILE_GPU_SCOPE(profiler, name) GpuProfileScope PROFILER_CONCAT(gpuProfileScope, __LINE__)(profiler, name)
+#else
+#define PROFILE_GPU_SCOPE(profiler, name)
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include "GpuFence.h"
+
+class CommandList;
+
+/// Queue types of the submission scheduler.
+enum GpuQueueType : unsigned
+{
+    GPU_QUEUE_DIRECT = 0,
+    GPU_QUEUE_COMPUTE,
+    GPU_QUEUE_COPY,
+    MAX_GPU_QUEUES
+};
+
+/// Command queue with a fence of its own. Implemented on a Direct3D12 command queue and by the simulated queue.
+class GpuQueue : public GpuFence
+{
+public:
+    /// Submit closed command lists with one call.
+    virtual void ExecuteCommandLists(CommandList* const* commandLists, unsigned count) = 0;
+    /// Make the queue wait on the GPU, without blocking the CPU, until another queue's fence has reached value.
+    virtual void Wait(GpuQueue& queue, uint64_t value) = 0;
+};
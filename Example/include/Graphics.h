@@ -1,10 +1,14 @@
 #pragma once
 
+#if defined(_WIN32)
 #include <windows.h>
+#endif
 #include <memory>
 #include <string>
 
 #include "Common.h"
+#include "FramePipeline.h"
+#include "Matrix.h"
 
 
 struct WindowModeParams
@@ -23,7 +27,23 @@ struct WindowModeParams
     int refreshRate_{};
 };
 
+class CommandList;
+class FrameClock;
+class FrameTimer;
+class FrustumCuller;
+class GpuProfiler;
+class GraphicsBackend;
 class GraphicsImpl;
+class IndirectDrawBatch;
+class JobSystem;
+class ObjectBuffer;
+class OcclusionBuffer;
+class RenderGraph;
+class RenderQueue;
+class Scene;
+struct SceneComponents;
+class TextureStreamer;
+class TextureUploadSink;
 
 class Graphics
 {
@@ -34,42 +54,159 @@ public:
     virtual ~Graphics();
     /// Initialize
     bool Initialize();
+    /// Run without a window or device on the null backend, the only backend outside Windows. Must be called
+    /// before Initialize.
+    void SetHeadless(bool enable);
+    /// Return whether running on the null backend.
+    bool IsHeadless() const { return headless_; }
+    /// Return number of frames rendered.
+    uint64_t GetFrameNumber() const;
     /// Return whether exit has been requested.
     bool IsExiting();
-    /// Run one frame.
+    /// Run the simulation on a thread of its own one frame ahead of rendering. Must be called before Initialize.
+    void SetPipelined(bool enable);
+    /// Return whether simulation and rendering are pipelined.
+    bool IsPipelined() const { return pipelined_; }
+    /// Run one frame: handle all pending window messages, then simulate and render, or render the frame the
+    /// simulation thread has published when pipelined.
     void RunFrame();
-    /// Send frame update events.
-    void Update();
-    /// Render after frame update.
-    void Render();
+    /// Run the simulation steps due, cull against the camera and fill a frame packet. On the simulation
+    /// thread when pipelined.
+    void Simulate(FramePacket& packet);
+    /// Advance the simulation by one fixed timestep in seconds.
+    void Update(double timeStep);
+    /// Render a frame packet.
+    void Render(FramePacket const& packet);
     /// Close the graphics window and set the exit flag
     void Exit();
     
     // Set window title
     void SetWindowTitle(std::string const& title);
+#if defined(_WIN32)
     /// Set window mode
     bool SetWindowMode(int width, int height);
     /// Set window mode
     bool SetWindowMode(WindowModeParams const& mode);
+#endif
+    /// Set number of frames the CPU may record ahead of the GPU.
+    void SetFramesInFlight(unsigned count);
+    /// Set number of presented frames the CPU may run ahead of, 0 for no bound. Set before Initialize to
+    /// wait on the swap chain rather than the GPU.
+    void SetMaxFrameLatency(unsigned frames);
+    /// Return frame timer for the simulation timestep, interpolation and frame rate cap. Used by the simulation
+    /// thread when pipelined, so configure it before Initialize then.
+    FrameTimer& GetFrameTimer() { return *frameTimer_; }
+    /// Return job system for recording command lists and other frame work in parallel.
+    JobSystem& GetJobSystem() { return *jobSystem_; }
+    /// Return GPU timestamp profiler of the active backend.
+    GpuProfiler& GetGpuProfiler();
+    /// Return texture streamer, updated every rendered frame. Available after Initialize.
+    TextureStreamer& GetTextureStreamer() { return *textureStreamer_; }
+    /// Return render queue, sorted and submitted after the back buffer clear every rendered frame, then cleared.
+    /// Render state, so only fill it on the render thread.
+    RenderQueue& GetRenderQueue() { return *renderQueue_; }
+    /// Return frustum culler, whose world space bounds are culled against the camera every simulated frame.
+    /// Simulation state, so only touched from Update when pipelined. Once the scene has entities it owns the
+    /// culler, indexed by entity.
+    FrustumCuller& GetCuller() { return *culler_; }
+    /// Return occlusion buffer, whose occluders hide the visible objects from drawing every rendered frame.
+    /// Render state, so add occluders before Initialize when pipelined.
+    OcclusionBuffer& GetOcclusionBuffer() { return *occlusionBuffer_; }
+    /// Return object buffer of per-object shader data, a world transform each, whose changes are uploaded every
+    /// rendered frame. Render state. Available after Initialize.
+    ObjectBuffer& GetObjectBuffer() { return *objectBuffer_; }
+    /// Return indirect draws, built from the objects drawn and executed with one call every rendered frame
+    /// once their state is set. Render state.
+    IndirectDrawBatch& GetIndirectDraws() { return *indirectDraws_; }
+    /// Return scene, whose entities move and have their world transforms computed every simulation step, and
+    /// whose changed renderables are culled and patched into the object buffer every frame. Simulation state,
+    /// so only touched from Update when pipelined.
+    Scene& GetScene() { return *scene_; }
+    /// Return component ids of the scene systems.
+    SceneComponents const& GetSceneComponents() const { return *sceneComponents_; }
+    /// Set camera view and projection. Simulation state, so only set from Update when pipelined.
+    void SetCamera(Matrix4 const& view, Matrix4 const& projection);
 
 private:
+#if defined(_WIN32)
     /// Create the Direct3D12 device and swap chain.
     bool CreateDevice(int width, int height);
     /// Create window 
     HWND OpenWindow();
     /// Update swap chain size
     bool UpdateSwapChain();
+#endif
 
+    /// Job system, outlives the backends whose command lists its jobs record.
+    std::unique_ptr<JobSystem> jobSystem_;
+    /// Clock of frame timing.
+    std::unique_ptr<FrameClock> frameClock_;
+    /// Frame timing.
+    std::unique_ptr<FrameTimer> frameTimer_;
+#if defined(_WIN32)
     /// Implementation.
     std::shared_ptr<GraphicsImpl> impl_;
+#endif
+    /// Active backend, the implementation or the null backend when headless.
+    std::shared_ptr<GraphicsBackend> backend_;
+    /// Frame graph, rebuilt every frame.
+    std::unique_ptr<RenderGraph> renderGraph_;
+    /// Draws of the current frame.
+    std::unique_ptr<RenderQueue> renderQueue_;
+    /// Upload sink of the texture streamer on the active backend.
+    std::unique_ptr<TextureUploadSink> textureUploadSink_;
+    /// Texture streamer.
+    std::unique_ptr<TextureStreamer> textureStreamer_;
+    /// Entities.
+    std::unique_ptr<Scene> scene_;
+    /// Component ids of the scene systems.
+    std::unique_ptr<SceneComponents> sceneComponents_;
+    /// Scene version world transforms were last computed after.
+    uint32_t worldTransformVersion_{};
+    /// Scene version renderables were last synced to the culler after.
+    uint32_t renderableVersion_{};
+    /// Frustum culler.
+    std::unique_ptr<FrustumCuller> culler_;
+    /// Occlusion buffer.
+    std::unique_ptr<OcclusionBuffer> occlusionBuffer_;
+    /// Per-object shader data.
+    std::unique_ptr<ObjectBuffer> objectBuffer_;
+    /// Indirect draws of the objects.
+    std::unique_ptr<IndirectDrawBatch> indirectDraws_;
+    /// Indices of the objects drawn in the current rendered frame.
+    std::vector<unsigned> drawObjects_;
+    /// Command lists the draws of the current rendered frame recorded into.
+    std::vector<CommandList*> drawCommandLists_;
+    /// Camera view.
+    Matrix4 view_;
+    /// Camera projection.
+    Matrix4 projection_;
+    /// Simulation thread and frame packets when pipelined.
+    std::unique_ptr<FramePipeline> framePipeline_;
+    /// Frame packet when not pipelined.
+    FramePacket framePacket_;
+    /// Simulation frame number.
+    uint64_t simulationFrame_{};
+    /// Simulation time in seconds.
+    double simulationTime_{};
+    /// Pipelined flag.
+    bool pipelined_{};
     /// Window titile name
     std::string title_ { "D3D12 Example" };
+#if defined(_WIN32)
     /// Window instance
     HWND window_;
+#endif
     /// Initialized flag.
     bool initialized_;
     /// Exiting flag.
     bool exiting_;
+    /// Headless flag, always set where there is no Direct3D12.
+#if defined(_WIN32)
+    bool headless_{};
+#else
+    bool headless_{true};
+#endif
     
     /// sRGB conversion on write flag for the main window.
     bool sRGB_{};
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "CommandList.h"
+#include "DeferredReleaseQueue.h"
+#include "DescriptorAllocator.h"
+#include "FenceTimeline.h"
+#include "FramePacer.h"
+#include "GpuFence.h"
+#include "GpuHeapAllocator.h"
+#include "GpuProfiler.h"
+#include "GraphicsDefs.h"
+#include "IndirectDraw.h"
+#include "PipelineCache.h"
+#include "RenderGraph.h"
+#include "ResidencyManager.h"
+#include "ResourceStateTracker.h"
+#include "SubmissionScheduler.h"
+#include "UploadRing.h"
+
+
+/// Backend below GraphicsImpl. Owns the frame loop and leaves the recording primitives to the
+/// Direct3D12 implementation or to the headless null backend.
+class GraphicsBackend
+{
+public:
+    /// Initial size of the upload ring, it grows when a frame needs more
+    static constexpr uint64_t UploadRingSize{4 * 1024 * 1024};
+    /// Largest maximum frame latency, the same as DXGI's
+    static constexpr unsigned MaxFrameLatency{16};
+
+    /// Construct.
+    explicit GraphicsBackend();
+    /// Destruct.
+    virtual ~GraphicsBackend();
+
+    /// Begin a frame: wait for its slot, reset the command list and reclaim what completed frames used.
+    void Begin();
+    /// End render
+    void End();
+    /// Flush scheduled work, flush batched barriers, submit the command list followed by the queued command
+    /// lists in one call and commit the resource states they leave behind.
+    void Submit();
+    /// Flush command queue and the scheduled queues
+    void FlushCommandQueue();
+
+    /// Return scheduler of the direct, compute and copy queues.
+    SubmissionScheduler& GetScheduler() { return scheduler_; }
+    /// Make the command lists of the next Submit wait on the GPU for scheduled work.
+    void WaitForSubmission(GpuSubmission const& submission);
+
+    /// Set number of threads that acquire command lists, thread indices are those of the job system.
+    void SetCommandListThreads(unsigned count);
+    /// Return a command list for a queue type from the calling thread's pool, reset for the current frame.
+    /// Lists are reused from the next frame on, so acquire one per recording job rather than one per thread.
+    /// Compute and copy lists are submitted through the scheduler.
+    CommandList* AcquireCommandList(GpuQueueType type = GPU_QUEUE_DIRECT);
+    /// Queue a recorded command list for the next Submit. Queue order is submission order. Main thread only.
+    void QueueCommandList(CommandList* commandList);
+    /// Return number of pooled command lists.
+    unsigned GetCommandListCount() const;
+
+    /// Set number of frames the CPU may record ahead of the GPU.
+    void SetFramesInFlight(unsigned count);
+    /// Return number of frames in flight.
+    unsigned GetFramesInFlight() const { return framePacer_.GetFramesInFlight(); }
+    /// Set number of presented frames the CPU may run ahead of, 0 for no bound beyond frames in flight. Lower
+    /// values trade throughput for input latency.
+    void SetMaxFrameLatency(unsigned frames) { maxFrameLatency_ = frames < MaxFrameLatency ? frames : MaxFrameLatency; }
+    /// Return maximum frame latency.
+    unsigned GetMaxFrameLatency() const { return maxFrameLatency_; }
+    /// Return frame pacing.
+    FramePacer const& GetFramePacer() const { return framePacer_; }
+    /// Return fence timeline of the queue.
+    FenceTimeline& GetFenceTimeline() { return fenceTimeline_; }
+    /// Return queue of objects waiting for the GPU before release.
+    DeferredReleaseQueue const& GetReleaseQueue() const { return releaseQueue_; }
+    /// Release an object once the GPU has finished all work submitted so far and the current frame.
+    void DeferRelease(void* object, DeferredReleaseQueue::ReleaseFunction release, uint64_t bytes = 0);
+    /// Free a heap allocation once the GPU has finished all work submitted so far and the current frame.
+    void DeferFree(GpuAllocation& allocation);
+    /// Return resource states as of the last submitted command list.
+    ResourceStateRegistry& GetStateRegistry() { return stateRegistry_; }
+    /// Return state tracker of the command list.
+    ResourceStateTracker& GetStateTracker() { return stateTracker_; }
+    /// Return descriptor allocator.
+    DescriptorAllocator& GetDescriptorAllocator() { return descriptorAllocator_; }
+    /// Return per-frame upload ring.
+    UploadRing& GetUploadRing() { return uploadRing_; }
+    /// Return factory of upload buffers.
+    UploadBufferFactory& GetUploadBufferFactory() { return *uploadBufferFactory_; }
+    /// Return pipeline state cache.
+    PipelineCache& GetPipelineCache() { return pipelineCache_; }
+    /// Return heap sub-allocator for placed resources.
+    GpuHeapAllocator& GetHeapAllocator() { return heapAllocator_; }
+    /// Return residency manager of the heaps, not initialized when the backend has no residency backend.
+    ResidencyManager& GetResidencyManager() { return residency_; }
+    /// Record that work of the current frame on any queue uses a placed resource, so its heap is resident when
+    /// the work is submitted and not evicted before the frame completes.
+    void MarkUsed(GpuAllocation const& allocation);
+    /// Return factory of render graph transient textures.
+    TransientResourceFactory& GetTransientResourceFactory() { return *transientResourceFactory_; }
+    /// Return factory of GPU buffers and indirect draw command signatures.
+    IndirectDrawFactory& GetIndirectDrawFactory() { return *indirectDrawFactory_; }
+    /// Return GPU timestamp profiler, not initialized when the backend has no query source.
+    GpuProfiler& GetGpuProfiler() { return gpuProfiler_; }
+    /// Return barrier statistics of the last frame.
+    ResourceBarrierStats const& GetFrameBarrierStats() const { return frameBarrierStats_; }
+
+    /// Return queue fence.
+    virtual GpuFence& GetQueueFence() = 0;
+    /// Reset the command list on the allocator of a frame slot.
+    virtual void ResetCommandList(unsigned frameIndex) = 0;
+    /// Record resource barriers.
+    virtual void ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers) = 0;
+    /// Record default viewport and scissor.
+    virtual void SetDefaultViewport() = 0;
+    /// Record binding of a pipeline state and its root signature.
+    virtual void SetPipelineState(PipelineStateHandle state) = 0;
+    /// Record clear of the current back buffer.
+    virtual void ClearRenderTarget(float const color[4]) = 0;
+    /// Record clear of the default depth stencil.
+    virtual void ClearDepthStencil(float depth, unsigned char stencil) = 0;
+    /// Record binding of the current back buffer and default depth stencil.
+    virtual void SetDefaultRenderTargets() = 0;
+    /// Create a pooled command list for a queue type. Called from the thread that acquires it.
+    virtual CommandList* CreateCommandList(GpuQueueType type) = 0;
+    /// Close the command list and submit it followed by closed pooled command lists with one call.
+    virtual void ExecuteCommandLists(CommandList* const* commandLists, unsigned count) = 0;
+    /// Present and advance the back buffer.
+    virtual void Present() = 0;
+    /// Return current back buffer.
+    virtual ResourceHandle GetBackBuffer() const = 0;
+
+protected:
+    /// Block until at most the maximum frame latency of frames are queued. Waits for the GPU to finish the
+    /// frame that many frames back, a backend whose swap chain can signal when it takes a frame waits on that.
+    /// Called every frame, also without a bound.
+    virtual void WaitForFrameLatency();
+
+    /// Command lists of one thread per queue type. Padded rather than aligned so threads do not share cache
+    /// lines, as containers only honor over-alignment from C++17 on
+    struct CommandListPool
+    {
+        /// Command lists
+        std::vector<std::unique_ptr<CommandList>> commandLists_[MAX_GPU_QUEUES];
+        /// Command lists acquired this frame
+        unsigned used_[MAX_GPU_QUEUES]{};
+        /// Padding up to the next pool
+        char padding_[64];
+    };
+
+    /// Fence timeline of the queue
+    FenceTimeline fenceTimeline_;
+    /// Objects waiting for the GPU before release
+    DeferredReleaseQueue releaseQueue_;
+    /// Resource states as of the last submitted command list
+    ResourceStateRegistry stateRegistry_;
+    /// State tracker of the command list
+    ResourceStateTracker stateTracker_{stateRegistry_};
+    /// Barrier statistics of the last frame
+    ResourceBarrierStats frameBarrierStats_;
+    /// Descriptor heap factory, outlives the allocator
+    std::unique_ptr<DescriptorHeapFactory> descriptorHeapFactory_;
+    /// Descriptor allocator
+    DescriptorAllocator descriptorAllocator_;
+    /// Upload buffer factory, outlives the ring
+    std::unique_ptr<UploadBufferFactory> uploadBufferFactory_;
+    /// Per-frame upload ring
+    UploadRing uploadRing_;
+    /// Pipeline state factory, outlives the cache
+    std::unique_ptr<PipelineStateFactory> pipelineStateFactory_;
+    /// Pipeline state cache
+    PipelineCache pipelineCache_;
+    /// Residency backend, outlives the residency manager
+    std::unique_ptr<ResidencyBackend> residencyBackend_;
+    /// Residency manager of the heaps, outlives the heap allocator
+    ResidencyManager residency_;
+    /// GPU heap factory, outlives the heap allocator
+    std::unique_ptr<GpuHeapFactory> heapFactory_;
+    /// Heap sub-allocator for placed resources
+    GpuHeapAllocator heapAllocator_;
+    /// Factory of render graph transient textures
+    std::unique_ptr<TransientResourceFactory> transientResourceFactory_;
+    /// Factory of GPU buffers and indirect draw command signatures
+    std::unique_ptr<IndirectDrawFactory> indirectDrawFactory_;
+    /// Timestamp query source, outlives the GPU profiler
+    std::unique_ptr<TimestampQuerySource> timestampQuerySource_;
+    /// GPU timestamp profiler
+    GpuProfiler gpuProfiler_;
+    /// Command list pools per thread
+    std::vector<CommandListPool> commandListPools_{1};
+    /// Command lists queued for the next Submit
+    std::vector<CommandList*> queuedCommandLists_;
+    /// Command lists of the last Submit in submission order
+    std::vector<CommandList*> submitCommandLists_;
+    /// Barriers the first uses of a queued command list need
+    std::vector<ResourceBarrierDesc> pendingBarriers_;
+    /// Frame pacing
+    FramePacer framePacer_;
+    /// Scheduler of the direct, compute and copy queues
+    SubmissionScheduler scheduler_;
+    /// Scheduled work the command lists of the next Submit wait for
+    std::vector<GpuSubmission> submissionWaits_;
+    /// Maximum frame latency, 0 for none
+    unsigned maxFrameLatency_{};
+    /// Fence values of the last presented frames, oldest first
+    std::deque<uint64_t> presentFenceValues_;
+};
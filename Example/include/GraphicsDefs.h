@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+
+
+/// Opaque resource handle. An ID3D12Resource pointer for the Direct3D12 backend.
+typedef void* ResourceHandle;
+/// Native command signature of indirect draws. An ID3D12CommandSignature pointer for the Direct3D12 backend.
+typedef void* CommandSignatureHandle;
+
+/// Resource states, numerically identical to D3D12_RESOURCE_STATES.
+enum ResourceState : unsigned
+{
+    RESOURCE_STATE_COMMON = 0,
+    RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+    RESOURCE_STATE_INDEX_BUFFER = 0x2,
+    RESOURCE_STATE_RENDER_TARGET = 0x4,
+    RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+    RESOURCE_STATE_DEPTH_WRITE = 0x10,
+    RESOURCE_STATE_DEPTH_READ = 0x20,
+    RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+    RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+    RESOURCE_STATE_STREAM_OUT = 0x100,
+    RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+    RESOURCE_STATE_COPY_DEST = 0x400,
+    RESOURCE_STATE_COPY_SOURCE = 0x800,
+    RESOURCE_STATE_RESOLVE_DEST = 0x1000,
+    RESOURCE_STATE_RESOLVE_SOURCE = 0x2000,
+    RESOURCE_STATE_GENERIC_READ = 0x1 | 0x2 | 0x40 | 0x80 | 0x200 | 0x800,
+    RESOURCE_STATE_PRESENT = 0,
+};
+
+/// States that write to a resource and can not be combined with other states.
+static const unsigned RESOURCE_STATE_WRITE_MASK = RESOURCE_STATE_RENDER_TARGET | RESOURCE_STATE_UNORDERED_ACCESS |
+    RESOURCE_STATE_DEPTH_WRITE | RESOURCE_STATE_STREAM_OUT | RESOURCE_STATE_COPY_DEST | RESOURCE_STATE_RESOLVE_DEST;
+
+/// Resource barrier flags, numerically identical to D3D12_RESOURCE_BARRIER_FLAGS.
+enum ResourceBarrierFlags : unsigned
+{
+    RESOURCE_BARRIER_FLAG_NONE = 0,
+    RESOURCE_BARRIER_FLAG_BEGIN_ONLY = 0x1,
+    RESOURCE_BARRIER_FLAG_END_ONLY = 0x2,
+};
+
+/// Resource barrier types, numerically identical to D3D12_RESOURCE_BARRIER_TYPE.
+enum ResourceBarrierType : unsigned
+{
+    RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+    RESOURCE_BARRIER_TYPE_ALIASING = 1,
+};
+
+/// Subresource index addressing every subresource, identical to D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES.
+static const unsigned ALL_SUBRESOURCES = 0xffffffff;
+
+/// Resource transition or aliasing barrier.
+struct ResourceBarrierDesc
+{
+    /// Barrier type
+    unsigned type_{RESOURCE_BARRIER_TYPE_TRANSITION};
+    /// Resource, the one becoming active for an aliasing barrier
+    ResourceHandle resource_{};
+    /// Resource whose memory is taken over by an aliasing barrier, null for any
+    ResourceHandle aliasBefore_{};
+    /// State before the barrier
+    unsigned before_{};
+    /// State after the barrier
+    unsigned after_{};
+    /// Subresource index
+    unsigned subresource_{ALL_SUBRESOURCES};
+    /// Split barrier flags
+    unsigned flags_{RESOURCE_BARRIER_FLAG_NONE};
+};
+
+/// Vertex buffer binding, identical in layout to D3D12_VERTEX_BUFFER_VIEW.
+struct VertexBufferView
+{
+    /// Test for equality.
+    bool operator ==(VertexBufferView const& rhs) const { return gpuAddress_ == rhs.gpuAddress_ && size_ == rhs.size_ && stride_ == rhs.stride_; }
+    /// Test for inequality.
+    bool operator !=(VertexBufferView const& rhs) const { return !(*this == rhs); }
+
+    /// GPU virtual address, zero for none
+    uint64_t gpuAddress_{};
+    /// Size in bytes
+    unsigned size_{};
+    /// Distance between vertices in bytes
+    unsigned stride_{};
+};
+
+/// Index buffer binding, identical in layout to D3D12_INDEX_BUFFER_VIEW.
+struct IndexBufferView
+{
+    /// Test for equality.
+    bool operator ==(IndexBufferView const& rhs) const { return gpuAddress_ == rhs.gpuAddress_ && size_ == rhs.size_ && format_ == rhs.format_; }
+    /// Test for inequality.
+    bool operator !=(IndexBufferView const& rhs) const { return !(*this == rhs); }
+
+    /// GPU virtual address, zero for none
+    uint64_t gpuAddress_{};
+    /// Size in bytes
+    unsigned size_{};
+    /// Index format, numerically a DXGI_FORMAT, R32_UINT by default
+    unsigned format_{42};
+};
@@ -2,32 +2,66 @@
 
 #include <d3d12.h>
 #include <dxgi1_6.h>
+#include <memory>
+#include <vector>
+
+#include "D3D12Fence.h"
+#include "D3D12GpuQueue.h"
+#include "GraphicsBackend.h"
 
 #define D3D_SAFE_RELEASE(p) if (p) { ((IUnknown*) p)->Release(); p = nullptr; }
 
-class GraphicsImpl
+class GraphicsImpl : public GraphicsBackend
 {
+    friend class D3D12CommandList;
     friend class Graphics;
 
 public:
     /// Construct.
     explicit GraphicsImpl();
     /// Destructor
-    ~GraphicsImpl();
+    ~GraphicsImpl() override;
 
     /// Return D3D12 device.
     ID3D12Device* GetDevice() const { return device_;}
     /// Return D3D12 command list.
     ID3D12GraphicsCommandList* GetCommandList() const { return commandList_; }
-    /// Flush command queue
-    void FlushCommandQueue();
-    /// Submit command list
-    void ExecuteCommandList();
-    /// Begin render
-    void Begin();
-    /// End render
-    void End();
+    /// Release a resource once the GPU is done with it.
+    void DeferRelease(ID3D12Resource* resource);
+    using GraphicsBackend::DeferRelease;
+    /// Create a resource placed in a sub-allocated heap. Return null on failure.
+    ID3D12Resource* CreatePlacedResource(D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+        D3D12_CLEAR_VALUE const* clearValue, GpuAllocation& allocation);
+
+    /// Return queue fence.
+    GpuFence& GetQueueFence() override { return *queueFence_; }
+    /// Reset the command list on the allocator of a frame slot.
+    void ResetCommandList(unsigned frameIndex) override;
+    /// Record resource barriers.
+    void ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers) override;
+    /// Record default viewport and scissor.
+    void SetDefaultViewport() override;
+    /// Record binding of a pipeline state and its root signature.
+    void SetPipelineState(PipelineStateHandle state) override;
+    /// Record clear of the current back buffer.
+    void ClearRenderTarget(float const color[4]) override;
+    /// Record clear of the default depth stencil.
+    void ClearDepthStencil(float depth, unsigned char stencil) override;
+    /// Record binding of the current back buffer and default depth stencil.
+    void SetDefaultRenderTargets() override;
+    /// Create a pooled command list for a queue type.
+    CommandList* CreateCommandList(GpuQueueType type) override;
+    /// Close the command list and submit it followed by the pooled command lists.
+    void ExecuteCommandLists(CommandList* const* commandLists, unsigned count) override;
+    /// Present and advance the back buffer.
+    void Present() override;
+    /// Return current back buffer.
+    ResourceHandle GetBackBuffer() const override { return CurrentBackBuffer(); }
     
+protected:
+    /// Wait on the swap chain's frame latency object, or on the queue fence without one.
+    void WaitForFrameLatency() override;
+
 private:
     /// Back buffer count
     static constexpr unsigned SwapChainBufferCount{2};
@@ -36,7 +70,7 @@ private:
 
     /// Create D3D12 command objects
     bool CreateCommandObjects();
-    /// Create D3D12 descriptor heap
+    /// Create descriptor allocator and the default views
     bool CreateDescriptorHeap();
 
     /// Create render target views
@@ -62,43 +96,54 @@ private:
     ID3D12Device* device_{};
     /// Swap chain.
     IDXGISwapChain* swapChain_{};
+    /// Swap chain interface for frame latency, only when created with a waitable object.
+    IDXGISwapChain2* swapChain2_{};
+    /// Signaled when the swap chain can take another frame within the maximum latency.
+    HANDLE frameLatencyWaitableObject_{};
+    /// Maximum frame latency set on the swap chain.
+    unsigned swapChainFrameLatency_{};
     
     /// Back buffers
     ID3D12Resource* defaultRenderTargets_[SwapChainBufferCount] {};
     /// Depth stencil buffer
     ID3D12Resource* defaultDepthStencil_{};
+    /// Depth stencil buffer placement
+    GpuAllocation defaultDepthStencilAllocation_;
 
     /// Command queue
     ID3D12CommandQueue* commandQueue_{};
     /// Graphics Command list
     ID3D12GraphicsCommandList* commandList_{};
-    /// Command allocator
-    ID3D12CommandAllocator* commandAllocator_{};
+    /// Command allocator per frame in flight
+    ID3D12CommandAllocator* commandAllocators_[FramePacer::MaxFramesInFlight] {};
     
     /// Fence
     ID3D12Fence* fence_{};
-    /// Current Fence value
-    unsigned fenceValue_{};
+    /// Command queue fence used by frame pacing
+    std::unique_ptr<D3D12Fence> queueFence_;
+    /// Scheduled queues, the direct one with a fence of its own on the command queue
+    std::unique_ptr<D3D12GpuQueue> scheduledQueues_[MAX_GPU_QUEUES];
 
-    /// RTV descriptor heap
-    ID3D12DescriptorHeap* renderTargetViewHeap_{};
-    /// DSV descriptor heap
-    ID3D12DescriptorHeap* depthStencilViewHeap_;
-
-    /// RTV descriptor size
-    unsigned renderTargetViewSize_{};
-    /// DSV descriptor size
-    unsigned depthStencilViewSize_{};
-    /// CBV SRV UAV descriptor size
-    unsigned bufferViewSize_{};
+    /// Back buffer render target views
+    DescriptorAllocation renderTargetViews_[SwapChainBufferCount];
+    /// Depth stencil view
+    DescriptorAllocation depthStencilView_;
 
     /// Current backbuffer index
     unsigned currentBackBufferIndex_{};
     
+    /// Translated barriers of the last ResourceBarrier call
+    std::vector<D3D12_RESOURCE_BARRIER> barrierScratch_;
+
     /// Viewport
     D3D12_VIEWPORT viewport_{}; 
     D3D12_RECT scissor_{};
 
+    /// Native command lists of the last ExecuteCommandLists call
+    std::vector<ID3D12CommandList*> executeScratch_;
+
+    /// Translate a batch of barriers.
+    static void TranslateBarriers(unsigned count, ResourceBarrierDesc const* barriers, std::vector<D3D12_RESOURCE_BARRIER>& dest);
     /// Return a resource transition barrier
     static D3D12_RESOURCE_BARRIER Transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after, 
         unsigned subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE);
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "GraphicsDefs.h"
+#include "PipelineCache.h"
+#include "UploadRing.h"
+
+
+class CommandList;
+
+/// Arguments of one indirect object draw: the object index as a root constant, which shaders look the object
+/// data up with, followed by the arguments of DrawIndexedInstanced in the layout of
+/// D3D12_DRAW_INDEXED_ARGUMENTS.
+struct IndirectDrawArguments
+{
+    /// Object index
+    uint32_t objectIndex_;
+    /// Indices per instance
+    uint32_t indexCount_;
+    /// Instances
+    uint32_t instanceCount_;
+    /// First index
+    uint32_t firstIndex_;
+    /// Value added to the indices
+    int32_t baseVertex_;
+    /// First instance
+    uint32_t firstInstance_;
+};
+
+static_assert(sizeof(IndirectDrawArguments) == 24, "Indirect draw arguments must match the command signature stride");
+
+/// Buffer in GPU memory created by a factory.
+struct GpuBufferInfo
+{
+    /// Native buffer, an ID3D12Resource for the Direct3D12 factory
+    void* resource_{};
+    /// GPU virtual address
+    uint64_t gpu_{};
+    /// Size in bytes
+    uint64_t size_{};
+};
+
+/// Creates GPU buffers and the command signature of indirect object draws. Implemented on the Direct3D12
+/// device and by a null factory backed by system memory.
+class IndirectDrawFactory
+{
+public:
+    /// Destruct.
+    virtual ~IndirectDrawFactory() = default;
+
+    /// Create a buffer in the default heap in the common state. Return false on failure.
+    virtual bool CreateBuffer(uint64_t size, GpuBufferInfo& info) = 0;
+    /// Destroy a buffer.
+    virtual void DestroyBuffer(GpuBufferInfo& info) = 0;
+    /// Create the command signature of IndirectDrawArguments for a root signature, the object index going to
+    /// a 32-bit root constant parameter. Return null on failure.
+    virtual CommandSignatureHandle CreateCommandSignature(RootSignatureHandle rootSignature, unsigned objectIndexParameter) = 0;
+    /// Release a command signature.
+    virtual void ReleaseCommandSignature(CommandSignatureHandle signature) = 0;
+};
+
+/// Index range of an object's mesh.
+struct IndirectMesh
+{
+    /// Indices, zero for an object that is not drawn
+    unsigned indexCount_{};
+    /// First index
+    unsigned firstIndex_{};
+    /// Value added to the indices
+    int baseVertex_{};
+};
+
+/// State every draw of a batch shares.
+struct IndirectDrawState
+{
+    /// Pipeline state
+    PipelineStateHandle pipelineState_{};
+    /// Root signature the command signature was created for
+    RootSignatureHandle rootSignature_{};
+    /// Command signature of IndirectDrawArguments
+    CommandSignatureHandle commandSignature_{};
+    /// Index buffer of all meshes
+    IndexBufferView indexBuffer_;
+    /// Root parameter of the object data shader resource view
+    unsigned objectDataParameter_{};
+};
+
+/// Objects drawn with a single ExecuteIndirect. Building packs one argument record per drawn object into the
+/// upload ring, so thousands of draws cost the CPU a few stores each and one call instead of a call each.
+/// Upload memory stays in the generic read state, which includes the indirect argument state, so the
+/// arguments need no barrier.
+class IndirectDrawBatch
+{
+public:
+    /// Construct.
+    explicit IndirectDrawBatch();
+
+    /// Set shared state. The batch is drawn once a command signature is set.
+    void SetState(IndirectDrawState const& state) { state_ = state; }
+    /// Return shared state.
+    IndirectDrawState const& GetState() const { return state_; }
+    /// Set the mesh of an object.
+    void SetMesh(unsigned objectIndex, IndirectMesh const& mesh);
+    /// Return mesh of an object, empty if not set.
+    IndirectMesh GetMesh(unsigned objectIndex) const { return objectIndex < meshes_.size() ? meshes_[objectIndex] : IndirectMesh(); }
+    /// Return whether there is anything to draw.
+    bool IsDrawable() const { return state_.commandSignature_ && !meshes_.empty(); }
+
+    /// Pack the arguments of objects in order into upload memory, skipping those without a mesh. Return false
+    /// if the ring could not allocate.
+    bool Build(std::vector<unsigned> const& objects, UploadRing& ring);
+    /// Record the shared state and the built draws. The object data must be in a shader resource state.
+    void Execute(CommandList& commandList, uint64_t objectData) const;
+
+    /// Return number of draws built.
+    unsigned GetDrawCount() const { return drawCount_; }
+    /// Return upload memory of the built arguments.
+    UploadAllocation const& GetArguments() const { return arguments_; }
+
+private:
+    /// Shared state
+    IndirectDrawState state_;
+    /// Meshes by object index
+    std::vector<IndirectMesh> meshes_;
+    /// Built arguments
+    UploadAllocation arguments_;
+    /// Draws built
+    unsigned drawCount_{};
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/// Number of unfinished jobs a thread can wait on. Jobs spawning children with their own counter and
+/// waiting on it form parent/child dependencies.
+class JobCounter
+{
+    friend class JobSystem;
+
+public:
+    /// Return whether all jobs have finished.
+    bool IsDone() const { return count_.load(std::memory_order_acquire) == 0; }
+
+private:
+    /// Unfinished jobs
+    std::atomic<unsigned> count_{0};
+};
+
+/// Work-stealing job scheduler. Every thread owns a deque: it pushes and pops its own jobs at the back and
+/// idle threads steal from the front of the others. The constructing thread is thread 0 and runs jobs
+/// while it waits on a counter instead of blocking.
+class JobSystem
+{
+public:
+    /// Job function.
+    typedef std::function<void()> JobFunction;
+
+    /// Construct with a number of worker threads besides the calling thread, 0 for one less than the cores.
+    explicit JobSystem(unsigned workerCount = 0);
+    /// Destruct. Waits for the workers to finish their current job.
+    ~JobSystem();
+
+    JobSystem(JobSystem const&) = delete;
+    JobSystem& operator =(JobSystem const&) = delete;
+
+    /// Queue a job on the calling thread's deque. The counter, if any, is decremented once it has run.
+    void Run(JobFunction function, JobCounter* counter = nullptr);
+    /// Run jobs until the counter reaches zero.
+    void Wait(JobCounter& counter);
+    /// Split [0, count) into batches, run them as jobs and wait for all of them.
+    void ParallelFor(unsigned count, unsigned batchSize, std::function<void(unsigned begin, unsigned end)> const& function);
+
+    /// Return number of threads including the constructing thread.
+    unsigned GetThreadCount() const { return (unsigned) queues_.size(); }
+    /// Return index of the calling thread, 0 for threads that are not workers.
+    static unsigned GetThreadIndex();
+    /// Return number of jobs taken from another thread's deque.
+    uint64_t GetStealCount() const { return stealCount_.load(std::memory_order_relaxed); }
+
+private:
+    /// Queued job
+    struct Job
+    {
+        /// Function
+        JobFunction function_;
+        /// Counter to decrement, may be null
+        JobCounter* counter_;
+    };
+
+    /// Deque of one thread. Padded rather than aligned so threads do not share cache lines, as operator
+    /// new only honors over-alignment from C++17 on
+    struct ThreadQueue
+    {
+        /// Lock
+        std::mutex mutex_;
+        /// Jobs, the owner works at the back and thieves at the front
+        std::deque<Job> jobs_;
+        /// Padding up to the next allocation
+        char padding_[64];
+    };
+
+    /// Take a job from the own deque or steal one. Return false if there was none.
+    bool TakeJob(unsigned threadIndex, Job& job);
+    /// Run one job if there is any. Return false if there was none.
+    bool RunOne(unsigned threadIndex);
+    /// Worker thread loop.
+    void WorkerLoop(unsigned threadIndex);
+
+    /// Deques per thread
+    std::vector<std::unique_ptr<ThreadQueue>> queues_;
+    /// Worker threads
+    std::vector<std::thread> workers_;
+    /// Lock for sleeping workers
+    std::mutex sleepMutex_;
+    /// Wakes sleeping workers
+    std::condition_variable wakeCondition_;
+    /// Jobs queued and not taken yet
+    std::atomic<unsigned> queuedCount_{0};
+    /// Number of steals
+    std::atomic<uint64_t> stealCount_{0};
+    /// Stop flag
+    std::atomic<bool> stopping_{false};
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+
+/// Read-only memory mapping of a whole file. Pages are read in by the OS on first touch, so whichever
+/// thread reads the data does the I/O and nothing is copied into an intermediate buffer.
+class MappedFile
+{
+public:
+    /// Construct.
+    explicit MappedFile();
+    /// Destruct.
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator =(MappedFile const&) = delete;
+
+    /// Map a file. Return false if it cannot be opened or is empty.
+    bool Open(std::string const& fileName);
+    /// Unmap.
+    void Close();
+
+    /// Return whether mapped.
+    bool IsOpen() const { return data_ != nullptr; }
+    /// Return mapped data.
+    uint8_t const* GetData() const { return data_; }
+    /// Return size in bytes.
+    uint64_t GetSize() const { return size_; }
+
+private:
+    /// Mapped data
+    uint8_t const* data_{};
+    /// Size in bytes
+    uint64_t size_{};
+#if defined(_WIN32)
+    /// Mapping handle
+    void* mapping_{};
+#endif
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Quaternion.h"
+#include "Vector.h"
+
+
+/// 4x4 matrix in row-major order transforming row vectors, as in HLSL mul(v, M) and DirectXMath: a * b
+/// applies a first, and translation is in the last row.
+struct alignas(16) Matrix4
+{
+    /// Construct identity.
+    Matrix4() = default;
+    /// Construct from rows.
+    Matrix4(Vector4 const& r0, Vector4 const& r1, Vector4 const& r2, Vector4 const& r3) : rows_{ r0, r1, r2, r3 } {}
+
+    /// Return translation.
+    static Matrix4 Translation(Vector3 const& translation);
+    /// Return scaling.
+    static Matrix4 Scaling(Vector3 const& scale);
+    /// Return rotation.
+    static Matrix4 Rotation(Quaternion const& rotation);
+    /// Return scaling, then rotation, then translation.
+    static Matrix4 FromTRS(Vector3 const& translation, Quaternion const& rotation, Vector3 const& scale);
+    /// Return left-handed view matrix of a camera at eye looking at a point.
+    static Matrix4 LookAt(Vector3 const& eye, Vector3 const& at, Vector3 const& up);
+    /// Return left-handed perspective projection to a depth of 0 at the near and 1 at the far plane.
+    static Matrix4 Perspective(float fovY, float aspect, float nearZ, float farZ);
+
+    /// Return product, this transform followed by rhs.
+    Matrix4 operator *(Matrix4 const& rhs) const
+    {
+        Float4 r0 = rhs.rows_[0].Load();
+        Float4 r1 = rhs.rows_[1].Load();
+        Float4 r2 = rhs.rows_[2].Load();
+        Float4 r3 = rhs.rows_[3].Load();
+
+        // Each row of the product is the row of this matrix transformed by rhs
+        Matrix4 ret;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            Float4 row = rows_[i].Load();
+            Float4 sum = SplatX(row) * r0;
+            sum = MulAdd(SplatY(row), r1, sum);
+            sum = MulAdd(SplatZ(row), r2, sum);
+            sum = MulAdd(SplatW(row), r3, sum);
+            ret.rows_[i] = Vector4(sum);
+        }
+        return ret;
+    }
+    bool operator ==(Matrix4 const& rhs) const
+    {
+        return rows_[0] == rhs.rows_[0] && rows_[1] == rhs.rows_[1] && rows_[2] == rhs.rows_[2] && rows_[3] == rhs.rows_[3];
+    }
+    bool operator !=(Matrix4 const& rhs) const { return !(*this == rhs); }
+
+    /// Return a row vector transformed.
+    Vector4 Transform(Vector4 const& v) const
+    {
+        Float4 a = v.Load();
+        Float4 sum = SplatX(a) * rows_[0].Load();
+        sum = MulAdd(SplatY(a), rows_[1].Load(), sum);
+        sum = MulAdd(SplatZ(a), rows_[2].Load(), sum);
+        sum = MulAdd(SplatW(a), rows_[3].Load(), sum);
+        return Vector4(sum);
+    }
+    /// Return a point transformed, without the perspective divide.
+    Vector3 TransformPoint(Vector3 const& v) const { return Transform(Vector4(v, 1.0f)).ToVector3(); }
+    /// Return a direction transformed, ignoring translation.
+    Vector3 TransformVector(Vector3 const& v) const { return Transform(Vector4(v, 0.0f)).ToVector3(); }
+    /// Return translation.
+    Vector3 GetTranslation() const { return rows_[3].ToVector3(); }
+
+    /// Return transpose.
+    Matrix4 Transposed() const;
+    /// Return inverse, or identity for a singular matrix.
+    Matrix4 Inverse() const;
+
+    /// Rows
+    Vector4 rows_[4]{ { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } };
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "DescriptorAllocator.h"
+
+
+/// Descriptor heap factory without a device. Heaps are disjoint address ranges and copies are only counted.
+class NullDescriptorHeapFactory : public DescriptorHeapFactory
+{
+public:
+    /// Construct.
+    explicit NullDescriptorHeapFactory(unsigned increment = 32);
+
+    /// Create a heap.
+    bool CreateHeap(DescriptorHeapType type, unsigned capacity, bool shaderVisible, DescriptorHeapInfo& info) override;
+    /// Destroy a heap.
+    void DestroyHeap(DescriptorHeapInfo& info) override;
+    /// Count copied descriptors.
+    void CopyDescriptors(DescriptorHeapType type, size_t destStart, unsigned rangeCount,
+        size_t const* rangeStarts, unsigned const* rangeSizes) override;
+
+    /// Return number of live heaps.
+    unsigned GetHeapCount() const { return heapCount_; }
+    /// Return number of CopyDescriptors calls.
+    uint64_t GetCopyCount() const { return copyCount_; }
+    /// Return number of copied descriptors.
+    uint64_t GetCopiedDescriptorCount() const { return copiedDescriptorCount_; }
+
+private:
+    /// Distance between descriptors
+    unsigned increment_;
+    /// Next free address, starts above zero so valid handles are never null
+    size_t nextAddress_;
+    /// Live heaps
+    unsigned heapCount_{};
+    /// CopyDescriptors calls
+    uint64_t copyCount_{};
+    /// Copied descriptors
+    uint64_t copiedDescriptorCount_{};
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#include "GpuHeapAllocator.h"
+
+
+/// GPU heap factory without a device. Heaps are placeholders that only count memory.
+class NullGpuHeapFactory : public GpuHeapFactory
+{
+public:
+    /// Create a heap.
+    bool CreateHeap(GpuHeapCategory category, uint64_t size, GpuHeapInfo& info) override;
+    /// Destroy a heap.
+    void DestroyHeap(GpuHeapInfo& info) override;
+
+    /// Return number of live heaps.
+    unsigned GetHeapCount() const { return heapCount_; }
+    /// Return bytes in live heaps.
+    uint64_t GetHeapBytes() const { return heapBytes_; }
+
+private:
+    /// Next placeholder heap, never null
+    size_t nextHeap_{1};
+    /// Live heaps
+    unsigned heapCount_{};
+    /// Bytes in live heaps
+    uint64_t heapBytes_{};
+};
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "GraphicsBackend.h"
+#include "NullDescriptorHeapFactory.h"
+#include "NullGpuHeapFactory.h"
+#include "NullIndirectDrawFactory.h"
+#include "NullPipelineStateFactory.h"
+#include "NullResidencyBackend.h"
+#include "NullTimestampQuerySource.h"
+#include "NullTransientResourceFactory.h"
+#include "NullUploadBufferFactory.h"
+#include "SimulatedQueue.h"
+
+
+/// Type of a recorded backend call.
+enum RecordedCommandType
+{
+    RECORD_RESET_COMMAND_LIST = 0,
+    RECORD_RESOURCE_BARRIER,
+    RECORD_SET_VIEWPORT,
+    RECORD_SET_PIPELINE_STATE,
+    RECORD_CLEAR_RENDER_TARGET,
+    RECORD_CLEAR_DEPTH_STENCIL,
+    RECORD_SET_RENDER_TARGETS,
+    RECORD_SET_ROOT_SIGNATURE,
+    RECORD_SET_DESCRIPTOR_TABLE,
+    RECORD_SET_VERTEX_BUFFER,
+    RECORD_DRAW,
+    RECORD_SET_INDEX_BUFFER,
+    RECORD_SET_ROOT_SHADER_RESOURCE,
+    RECORD_COPY_BUFFER,
+    RECORD_EXECUTE_INDIRECT,
+    RECORD_EXECUTE_COMMAND_LIST,
+    RECORD_PRESENT,
+    RECORD_SIGNAL,
+    MAX_RECORDED_COMMAND_TYPES
+};
+
+/// Recorded backend call.
+struct RecordedCommand
+{
+    /// Call type
+    RecordedCommandType type_;
+    /// Frame slot for command list resets, fence value for signals, back buffer index for presents, number
+    /// of command lists for executes, pipeline state for pipeline bindings, root signature, descriptor table
+    /// or vertex, index or shader resource buffer address for those bindings, vertex count for draws, bytes for
+    /// buffer copies, draw count for indirect draws
+    uint64_t value_;
+    /// Barrier for resource barriers, one record per barrier
+    ResourceBarrierDesc barrier_;
+};
+
+class NullGraphicsBackend;
+
+/// Pooled command list of the null backend. Records into a stream of its own that is appended to the
+/// backend stream when submitted.
+class NullCommandList : public CommandList
+{
+public:
+    /// Construct.
+    explicit NullCommandList(NullGraphicsBackend& backend);
+
+    /// Record a reset.
+    void Reset(unsigned frameIndex) override;
+    /// Record resource barriers.
+    void ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers) override;
+    /// Record default viewport and scissor.
+    void SetDefaultViewport() override;
+    /// Record binding of a pipeline state.
+    void SetPipelineState(PipelineStateHandle state) override;
+    /// Record binding of a pipeline state alone.
+    void SetPipelineStateObject(PipelineStateHandle state) override;
+    /// Record binding of a root signature.
+    void SetRootSignature(RootSignatureHandle rootSignature) override;
+    /// Record a descriptor table root argument.
+    void SetDescriptorTable(unsigned rootParameter, uint64_t gpuAddress) override;
+    /// Record binding of a vertex buffer.
+    void SetVertexBuffer(VertexBufferView const& view) override;
+    /// Record a draw.
+    void DrawInstanced(unsigned vertexCount, unsigned instanceCount, unsigned firstVertex, unsigned firstInstance) override;
+    /// Record binding of an index buffer.
+    void SetIndexBuffer(IndexBufferView const& view) override;
+    /// Record a shader resource view root argument.
+    void SetRootShaderResource(unsigned rootParameter, uint64_t gpuAddress) override;
+    /// Record a copy between buffers and copy at once, null backend buffers being system memory.
+    void CopyBufferRegion(ResourceHandle dest, uint64_t destOffset, ResourceHandle source, uint64_t sourceOffset, uint64_t size) override;
+    /// Record indirect draws.
+    void ExecuteIndirect(CommandSignatureHandle signature, unsigned count, ResourceHandle argumentBuffer, uint64_t argumentOffset) override;
+    /// Record binding of the current back buffer and default depth stencil.
+    void SetDefaultRenderTargets() override;
+    /// Close for submission.
+    void Close() override;
+
+    /// Return recorded calls since the last reset.
+    std::vector<RecordedCommand> const& GetRecordedCommands() const { return commands_; }
+    /// Return whether closed.
+    bool IsClosed() const { return !open_; }
+
+private:
+    /// Append a call to the stream.
+    void Record(RecordedCommandType type, uint64_t value = 0, ResourceBarrierDesc const* barrier = nullptr);
+
+    /// Owner
+    NullGraphicsBackend& backend_;
+    /// Recorded calls
+    std::vector<RecordedCommand> commands_;
+    /// Open flag
+    bool open_{};
+};
+
+/// Headless backend without a device or window. Records every call into an inspectable stream and
+/// completes submitted command lists on a simulated queue.
+class NullGraphicsBackend : public GraphicsBackend
+{
+    friend class NullCommandList;
+
+public:
+    /// Construct.
+    explicit NullGraphicsBackend(int width, int height, bool threadedQueue = true);
+    /// Destruct.
+    ~NullGraphicsBackend() override;
+
+    /// Return queue fence.
+    GpuFence& GetQueueFence() override { return fence_; }
+    /// Record a command list reset.
+    void ResetCommandList(unsigned frameIndex) override;
+    /// Record resource barriers.
+    void ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers) override;
+    /// Record default viewport and scissor.
+    void SetDefaultViewport() override;
+    /// Record binding of a pipeline state.
+    void SetPipelineState(PipelineStateHandle state) override;
+    /// Record clear of the current back buffer.
+    void ClearRenderTarget(float const color[4]) override;
+    /// Record clear of the default depth stencil.
+    void ClearDepthStencil(float depth, unsigned char stencil) override;
+    /// Record binding of the current back buffer and default depth stencil.
+    void SetDefaultRenderTargets() override;
+    /// Create a pooled command list. All queue types record the same way.
+    CommandList* CreateCommandList(GpuQueueType type) override;
+    /// Append the streams of the command lists and submit simulated GPU work for them.
+    void ExecuteCommandLists(CommandList* const* commandLists, unsigned count) override;
+    /// Record present and advance the back buffer.
+    void Present() override;
+    /// Return current back buffer.
+    ResourceHandle GetBackBuffer() const override { return (ResourceHandle) &backBuffers_[currentBackBufferIndex_]; }
+
+    /// Set simulated GPU time of each submitted command list.
+    void SetGpuTime(std::chrono::microseconds gpuTime) { gpuTime_ = gpuTime; }
+    /// Enable or disable recording into the stream. Counters are always updated.
+    void SetRecording(bool enable) { recording_ = enable; }
+    /// Return recorded calls.
+    std::vector<RecordedCommand> const& GetRecordedCommands() const { return commands_; }
+    /// Return number of calls of a type since construction or the last clear.
+    uint64_t GetCommandCount(RecordedCommandType type) const { return commandCounts_[type]; }
+    /// Clear recorded calls and counters.
+    void ClearRecording();
+    /// Return simulated queue.
+    SimulatedQueue& GetQueue() { return queue_; }
+    /// Return simulated queue the scheduler uses for a queue type. The direct one is a second fence on the
+    /// frame queue.
+    SimulatedQueue& GetScheduledQueue(GpuQueueType type) { return *scheduledQueues_[type]; }
+    /// Return descriptor heap factory.
+    NullDescriptorHeapFactory& GetDescriptorHeapFactory() { return *(NullDescriptorHeapFactory*) descriptorHeapFactory_.get(); }
+    /// Return upload buffer factory.
+    NullUploadBufferFactory& GetUploadBufferFactory() { return *(NullUploadBufferFactory*) uploadBufferFactory_.get(); }
+    /// Return pipeline state factory.
+    NullPipelineStateFactory& GetPipelineStateFactory() { return *(NullPipelineStateFactory*) pipelineStateFactory_.get(); }
+    /// Return GPU heap factory.
+    NullGpuHeapFactory& GetHeapFactory() { return *(NullGpuHeapFactory*) heapFactory_.get(); }
+    /// Return residency backend with its simulated budget.
+    NullResidencyBackend& GetResidencyBackend() { return *(NullResidencyBackend*) residencyBackend_.get(); }
+    /// Return timestamp query source.
+    NullTimestampQuerySource& GetTimestampQuerySource() { return *(NullTimestampQuerySource*) timestampQuerySource_.get(); }
+    /// Return indirect draw factory.
+    NullIndirectDrawFactory& GetNullIndirectDrawFactory() { return *(NullIndirectDrawFactory*) indirectDrawFactory_.get(); }
+    /// Return transient texture factory.
+    NullTransientResourceFactory& GetNullTransientResourceFactory() { return *(NullTransientResourceFactory*) transientResourceFactory_.get(); }
+    /// Return back buffer width.
+    int GetWidth() const { return width_; }
+    /// Return back buffer height.
+    int GetHeight() const { return height_; }
+
+private:
+    /// Fence that records signals before forwarding them to the simulated queue.
+    class RecordingFence : public GpuFence
+    {
+    public:
+        /// Construct.
+        explicit RecordingFence(NullGraphicsBackend& backend) : backend_(backend) { }
+
+        /// Record and enqueue a signal.
+        void Signal(uint64_t value) override;
+        /// Return the last value reached by the simulated queue.
+        uint64_t GetCompletedValue() const override { return backend_.queue_.GetCompletedValue(); }
+        /// Set event once the simulated queue has reached value.
+        void SetEventOnCompletion(uint64_t value, WaitEvent& event) override { backend_.queue_.SetEventOnCompletion(value, event); }
+
+    private:
+        /// Owner
+        NullGraphicsBackend& backend_;
+    };
+
+    /// Append a call to the stream.
+    void Record(RecordedCommandType type, uint64_t value = 0, ResourceBarrierDesc const* barrier = nullptr);
+
+    /// Back buffer count
+    static constexpr unsigned SwapChainBufferCount{2};
+
+    /// Simulated queue
+    SimulatedQueue queue_;
+    /// Recording fence
+    RecordingFence fence_;
+    /// Scheduled direct queue, a second fence on the simulated queue
+    SimulatedQueue directQueue_;
+    /// Scheduled compute queue
+    SimulatedQueue computeQueue_;
+    /// Scheduled copy queue
+    SimulatedQueue copyQueue_;
+    /// Scheduled queues by type
+    SimulatedQueue* scheduledQueues_[MAX_GPU_QUEUES];
+    /// Recorded calls
+    std::vector<RecordedCommand> commands_;
+    /// Call counts per type
+    uint64_t commandCounts_[MAX_RECORDED_COMMAND_TYPES]{};
+    /// Stand-in back buffers, only their addresses are used as handles
+    char backBuffers_[SwapChainBufferCount]{};
+    /// Current backbuffer index
+    unsigned currentBackBufferIndex_{};
+    /// Simulated GPU time per command list
+    std::chrono::microseconds gpuTime_{};
+    /// Back buffer width
+    int width_;
+    /// Back buffer height
+    int height_;
+    /// Recording flag
+    bool recording_{true};
+    /// Command list open flag
+    bool commandListOpen_{};
+};
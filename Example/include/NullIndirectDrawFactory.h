@@ -0,0 +1,34 @@
+#pragma once
+
+#include "IndirectDraw.h"
+
+
+/// Indirect draw factory without a device. Buffers are system memory and GPU addresses mirror the CPU ones,
+/// so their contents can be checked after the null command lists copy into them.
+class NullIndirectDrawFactory : public IndirectDrawFactory
+{
+public:
+    /// Create a zeroed buffer.
+    bool CreateBuffer(uint64_t size, GpuBufferInfo& info) override;
+    /// Destroy a buffer.
+    void DestroyBuffer(GpuBufferInfo& info) override;
+    /// Create a placeholder command signature.
+    CommandSignatureHandle CreateCommandSignature(RootSignatureHandle rootSignature, unsigned objectIndexParameter) override;
+    /// Release a placeholder command signature.
+    void ReleaseCommandSignature(CommandSignatureHandle signature) override;
+
+    /// Return number of live buffers.
+    unsigned GetBufferCount() const { return bufferCount_; }
+    /// Return bytes in live buffers.
+    uint64_t GetBufferBytes() const { return bufferBytes_; }
+    /// Return number of live command signatures.
+    unsigned GetCommandSignatureCount() const { return commandSignatureCount_; }
+
+private:
+    /// Live buffers
+    unsigned bufferCount_{};
+    /// Bytes in live buffers
+    uint64_t bufferBytes_{};
+    /// Live command signatures
+    unsigned commandSignatureCount_{};
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "PipelineCache.h"
+
+
+/// Pipeline state factory without a device. Compiling sleeps for a configurable time and cached blobs
+/// hold the description hash and device identity, so a blob of another description or device is rejected
+/// like a driver would.
+class NullPipelineStateFactory : public PipelineStateFactory
+{
+public:
+    /// Return device identity.
+    uint64_t GetDeviceId() const override { return deviceId_; }
+    /// Create a pipeline state.
+    PipelineStateHandle CreatePipelineState(PipelineDesc const& desc, void const* cachedBlob, size_t cachedBlobSize) override;
+    /// Return the cached blob of a pipeline state.
+    bool GetCachedBlob(PipelineStateHandle state, std::vector<uint8_t>& blob) override;
+    /// Release a pipeline state.
+    void ReleasePipelineState(PipelineStateHandle state) override;
+
+    /// Set device identity.
+    void SetDeviceId(uint64_t deviceId) { deviceId_ = deviceId; }
+    /// Set simulated time of a compile from scratch. Creating from a cached blob is free.
+    void SetCompileTime(std::chrono::microseconds compileTime) { compileTime_ = compileTime; }
+    /// Return number of compiles from scratch.
+    unsigned GetCompileCount() const { return compileCount_; }
+    /// Return number of pipeline states created from a cached blob.
+    unsigned GetCachedCreateCount() const { return cachedCreateCount_; }
+    /// Return number of live pipeline states.
+    unsigned GetPipelineStateCount() const { return pipelineStateCount_; }
+
+private:
+    /// Placeholder pipeline state
+    struct NullPipelineState
+    {
+        /// Description hash
+        ContentHash hash_;
+    };
+
+    /// Device identity
+    uint64_t deviceId_{1};
+    /// Simulated compile time
+    std::chrono::microseconds compileTime_{};
+    /// Compiles from scratch
+    std::atomic<unsigned> compileCount_{};
+    /// Pipeline states created from a cached blob
+    std::atomic<unsigned> cachedCreateCount_{};
+    /// Live pipeline states
+    std::atomic<unsigned> pipelineStateCount_{};
+};
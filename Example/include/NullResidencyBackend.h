@@ -0,0 +1,38 @@
+#pragma once
+
+#include "NullGpuHeapFactory.h"
+#include "ResidencyManager.h"
+
+
+/// Residency backend without a device. The budget is set by hand and usage is that of the heaps of a null
+/// heap factory, or set by hand without one, less what is evicted.
+class NullResidencyBackend : public ResidencyBackend
+{
+public:
+    /// Construct with the heap factory whose heaps make up usage, or none.
+    explicit NullResidencyBackend(NullGpuHeapFactory const* heapFactory = nullptr);
+
+    /// Return the simulated budget and usage.
+    bool QueryVideoMemory(VideoMemoryInfo& info) override;
+    /// Count objects back into usage.
+    bool MakeResident(ResidencyObject const* objects, unsigned count) override;
+    /// Count objects out of usage.
+    void Evict(ResidencyObject const* objects, unsigned count) override;
+
+    /// Set budget.
+    void SetBudget(uint64_t bytes) { budget_ = bytes; }
+    /// Set usage before evictions, when there is no heap factory.
+    void SetUsage(uint64_t bytes) { usage_ = bytes; }
+    /// Return bytes evicted and not made resident again.
+    uint64_t GetEvictedBytes() const { return evictedBytes_; }
+
+private:
+    /// Heap factory, null for usage set by hand
+    NullGpuHeapFactory const* heapFactory_;
+    /// Budget, unlimited by default
+    uint64_t budget_{~0ull};
+    /// Usage before evictions without a heap factory
+    uint64_t usage_{};
+    /// Bytes evicted
+    uint64_t evictedBytes_{};
+};
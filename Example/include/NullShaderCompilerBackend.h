@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "ShaderCompiler.h"
+
+
+/// Shader compiler backend without a compiler. Bytecode is a header followed by the hash of the source and
+/// permutation, and sources containing #error fail, so the cache and dependency tracking can run anywhere.
+class NullShaderCompilerBackend : public ShaderCompilerBackend
+{
+public:
+    /// Return version.
+    uint64_t GetVersion() const override { return version_; }
+    /// Produce stub bytecode.
+    bool Compile(std::string const& source, ShaderCompileDesc const& desc, std::vector<uint8_t>& bytecode, std::string& messages) override;
+
+    /// Set version, changing it invalidates cached bytecode.
+    void SetVersion(uint64_t version) { version_ = version; }
+    /// Set simulated compile time.
+    void SetCompileTime(std::chrono::microseconds compileTime) { compileTime_ = compileTime; }
+    /// Return number of compiles.
+    unsigned GetCompileCount() const { return compileCount_; }
+
+private:
+    /// Version
+    uint64_t version_{1};
+    /// Simulated compile time
+    std::chrono::microseconds compileTime_{};
+    /// Compiles
+    std::atomic<unsigned> compileCount_{};
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+
+#include "SimulatedQueue.h"
+#include "TextureStreamer.h"
+
+
+/// Texture upload sink without a device. Textures are placeholder handles and copies are simulated work
+/// on a queue of their own taking the time their bytes need at the set bandwidth.
+class NullTextureUploadSink : public TextureUploadSink
+{
+public:
+    /// Construct. A threaded queue completes copies in the background, a manual one only when processed.
+    explicit NullTextureUploadSink(bool threaded = true);
+
+    /// Create a placeholder texture and count the copy of the mips shared with the old one.
+    ResourceHandle CreateTexture(TextureFileInfo const& info, unsigned firstMip, ResourceHandle oldTexture,
+        unsigned oldFirstMip) override;
+    /// Release a placeholder texture.
+    void ReleaseTexture(ResourceHandle texture) override;
+    /// Count the copy of a mip.
+    void UploadMip(ResourceHandle texture, TextureFileInfo const& info, unsigned firstMip, unsigned mip,
+        UploadAllocation const& staging) override;
+    /// Submit the counted copies as simulated work followed by a signal.
+    uint64_t Submit() override;
+    /// Return the last value the queue has reached.
+    uint64_t GetCompletedValue() override { return queue_.GetCompletedValue(); }
+
+    /// Set copy bandwidth in bytes per microsecond.
+    void SetBandwidth(uint64_t bytesPerMicrosecond) { bandwidth_ = bytesPerMicrosecond ? bytesPerMicrosecond : 1; }
+    /// Return simulated copy queue.
+    SimulatedQueue& GetQueue() { return queue_; }
+    /// Return number of live textures.
+    unsigned GetTextureCount() const { return (unsigned) textures_.size(); }
+    /// Return bytes of live textures.
+    uint64_t GetTextureBytes() const { return textureBytes_; }
+    /// Return number of textures created so far.
+    uint64_t GetCreatedTextureCount() const { return createdTextureCount_; }
+    /// Return number of mips uploaded so far.
+    uint64_t GetUploadedMipCount() const { return uploadedMipCount_; }
+    /// Return bytes copied so far, uploads and copies between textures.
+    uint64_t GetCopiedBytes() const { return copiedBytes_; }
+
+private:
+    /// Simulated copy queue
+    SimulatedQueue queue_;
+    /// Bytes of live textures by handle
+    std::unordered_map<ResourceHandle, uint64_t> textures_;
+    /// Next placeholder handle, never null
+    size_t nextHandle_{0x1000};
+    /// Copy bandwidth in bytes per microsecond, 8GB/s by default
+    uint64_t bandwidth_{8 * 1024};
+    /// Bytes copied since the last submit
+    uint64_t pendingBytes_{};
+    /// Last signaled value
+    uint64_t lastValue_{};
+    /// Bytes of live textures
+    uint64_t textureBytes_{};
+    /// Textures created so far
+    uint64_t createdTextureCount_{};
+    /// Mips uploaded so far
+    uint64_t uploadedMipCount_{};
+    /// Bytes copied so far
+    uint64_t copiedBytes_{};
+};
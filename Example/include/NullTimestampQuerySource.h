@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include "GpuProfiler.h"
+
+
+/// Timestamp query source without a device. Queries take a simulated GPU clock when recorded and resolves
+/// copy them at once, so readback bookkeeping can be checked without a GPU. The clock follows the steady
+/// clock from an unrelated epoch, or only moves when advanced manually.
+class NullTimestampQuerySource : public TimestampQuerySource
+{
+public:
+    /// Construct with GPU timestamp ticks per second.
+    explicit NullTimestampQuerySource(uint64_t frequency = 1000000000);
+
+    /// Allocate queries and readback slots.
+    bool Initialize(unsigned queryCount) override;
+    /// Free them.
+    void Shutdown() override;
+    /// Return GPU timestamp ticks per second.
+    uint64_t GetFrequency() const override { return frequency_; }
+    /// Sample the simulated GPU clock and the CPU profiler ticks.
+    bool GetClockCalibration(uint64_t& gpuTimestamp, uint64_t& cpuTicks) override;
+    /// Write the simulated GPU clock into a query.
+    void EndQuery(unsigned index) override;
+    /// Copy queries into the readback slots.
+    void ResolveQueries(unsigned first, unsigned count) override;
+    /// Copy readback slots.
+    bool ReadQueries(unsigned first, unsigned count, uint64_t* timestamps) override;
+
+    /// Stop the clock so it only moves in AdvanceClock, or let it follow the steady clock again.
+    void SetManualClock(bool enable);
+    /// Advance the manual clock.
+    void AdvanceClock(uint64_t ticks) { manualTimestamp_ += ticks; }
+    /// Return current simulated GPU timestamp.
+    uint64_t GetTimestamp() const;
+
+    /// Return number of queries.
+    unsigned GetQueryCount() const { return (unsigned) queries_.size(); }
+    /// Return number of EndQuery calls.
+    uint64_t GetEndQueryCount() const { return endQueryCount_; }
+    /// Return number of queries resolved.
+    uint64_t GetResolvedQueryCount() const { return resolvedQueryCount_; }
+    /// Return number of queries read.
+    uint64_t GetReadQueryCount() const { return readQueryCount_; }
+
+private:
+    /// Ticks per second
+    uint64_t frequency_;
+    /// Query heap
+    std::vector<uint64_t> queries_;
+    /// Readback buffer
+    std::vector<uint64_t> readback_;
+    /// Manual clock value
+    uint64_t manualTimestamp_{};
+    /// Manual clock flag
+    bool manualClock_{};
+    /// EndQuery calls
+    uint64_t endQueryCount_{};
+    /// Queries resolved
+    uint64_t resolvedQueryCount_{};
+    /// Queries read
+    uint64_t readQueryCount_{};
+};
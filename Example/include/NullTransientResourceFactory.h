@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+#include "RenderGraph.h"
+
+
+/// Transient resource factory without a device. Sizes assume four bytes per sample and textures are
+/// placeholder handles.
+class NullTransientResourceFactory : public TransientResourceFactory
+{
+public:
+    /// Construct.
+    explicit NullTransientResourceFactory(ResourceStateRegistry& registry);
+    /// Destruct.
+    ~NullTransientResourceFactory() override;
+
+    /// Return size and placement alignment of a texture.
+    void GetAllocationInfo(TextureDesc const& desc, uint64_t& size, uint64_t& alignment) override;
+
+    /// Return number of textures created so far.
+    uint64_t GetCreatedTextureCount() const { return createdTextureCount_; }
+
+protected:
+    /// Create the transient heap.
+    bool CreateHeap(uint64_t /*size*/) override { return true; }
+    /// Release the transient heap.
+    void ReleaseHeap() override { }
+    /// Create a placeholder texture.
+    ResourceHandle CreateTexture(TextureDesc const& desc, uint64_t offset, unsigned initialState) override;
+    /// Release a placeholder texture.
+    void ReleaseTexture(ResourceHandle /*texture*/) override { }
+
+private:
+    /// Next placeholder handle, never null
+    size_t nextHandle_{0x1000};
+    /// Textures created so far
+    uint64_t createdTextureCount_{};
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "UploadRing.h"
+
+
+/// Upload buffer factory without a device. Buffers are system memory aligned for constant buffers, and resources
+/// and GPU addresses are the CPU memory, so null command lists copy from them directly.
+class NullUploadBufferFactory : public UploadBufferFactory
+{
+public:
+    /// Create a buffer.
+    bool CreateBuffer(uint64_t size, UploadBufferInfo& info) override;
+    /// Destroy a buffer.
+    void DestroyBuffer(UploadBufferInfo& info) override;
+
+    /// Return number of live buffers.
+    unsigned GetBufferCount() const { return bufferCount_; }
+    /// Return bytes in live buffers.
+    uint64_t GetBufferBytes() const { return bufferBytes_; }
+
+private:
+    /// Live buffers
+    unsigned bufferCount_{};
+    /// Bytes in live buffers
+    uint64_t bufferBytes_{};
+};
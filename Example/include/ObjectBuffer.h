@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "IndirectDraw.h"
+
+
+class CommandList;
+class GraphicsBackend;
+
+/// Statistics of the last object buffer upload.
+struct ObjectBufferStats
+{
+    /// Objects set since the upload before
+    unsigned dirtyObjects_{};
+    /// Copies recorded
+    unsigned copies_{};
+    /// Bytes copied, including clean objects between dirty ones
+    uint64_t bytes_{};
+    /// Whether all objects were copied
+    bool fullUpload_{};
+};
+
+/// Per-object shader data of a fixed stride in a GPU buffer, indexed by object, with a copy on the CPU.
+/// Setting an object marks it dirty and uploading copies only the dirty objects: they are taken in index
+/// order and coalesced into runs, bridging a few clean objects rather than starting another copy, and all
+/// objects are copied at once when the runs would cost about as much or the buffer grew. Growing doubles
+/// the buffer and retires the old one through the release queue of the backend.
+class ObjectBuffer
+{
+public:
+    /// Clean objects a run bridges rather than end and start another copy
+    static constexpr unsigned MaxRunGap{4};
+    /// Bytes a copy is taken to cost beyond the bytes it copies, when weighing copying everything instead
+    static constexpr unsigned CopyCost{1024};
+    /// Objects per dirty object below which dirty objects are sorted rather than found by scanning the flags
+    static constexpr unsigned ScanRatio{32};
+    /// Initial capacity in objects
+    static constexpr unsigned InitialCapacity{1024};
+    /// State the buffer rests in between uploads
+    static constexpr unsigned ShaderResourceState{RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE};
+
+    /// Construct.
+    explicit ObjectBuffer();
+    /// Destruct.
+    ~ObjectBuffer();
+
+    ObjectBuffer(ObjectBuffer const&) = delete;
+    ObjectBuffer& operator =(ObjectBuffer const&) = delete;
+
+    /// Set the backend and the bytes per object, a multiple of 4. Return false if invalid.
+    bool Initialize(GraphicsBackend& backend, unsigned stride);
+    /// Destroy the buffer. Only safe once the GPU is idle.
+    void Shutdown();
+    /// Return whether initialized.
+    bool IsInitialized() const { return backend_ != nullptr; }
+
+    /// Set data of an object, adding objects up to it as zeros.
+    void Set(unsigned index, void const* data);
+    /// Return data of an object.
+    void const* Get(unsigned index) const { return data_.data() + (size_t) index * stride_; }
+    /// Return number of objects.
+    unsigned GetObjectCount() const { return objectCount_; }
+    /// Return whether objects changed since the last upload.
+    bool IsDirty() const { return !dirty_.empty(); }
+
+    /// Copy the dirty objects through the upload ring into the buffer, creating or growing it first if needed,
+    /// and leave it in the shader resource state. Return false if a buffer or upload memory could not be
+    /// allocated, the objects stay dirty then.
+    bool Upload(CommandList& commandList);
+
+    /// Return buffer, null until the first upload.
+    ResourceHandle GetResource() const { return buffer_.resource_; }
+    /// Return GPU virtual address of the first object.
+    uint64_t GetGpuAddress() const { return buffer_.gpu_; }
+    /// Return bytes per object.
+    unsigned GetStride() const { return stride_; }
+    /// Return statistics of the last upload.
+    ObjectBufferStats const& GetStats() const { return stats_; }
+
+private:
+    /// Run of objects copied together
+    struct Run
+    {
+        /// First object
+        unsigned first_;
+        /// Objects
+        unsigned count_;
+    };
+
+    /// Add a dirty object to the runs, in increasing order.
+    void AddToRuns(unsigned index);
+    /// Replace the buffer with one of at least size bytes. Return false on failure.
+    bool Grow(uint64_t size);
+
+    /// Backend
+    GraphicsBackend* backend_{};
+    /// Buffer
+    GpuBufferInfo buffer_;
+    /// Object data on the CPU
+    std::vector<uint8_t> data_;
+    /// Dirty flag per object
+    std::vector<uint8_t> dirtyFlags_;
+    /// Indices of the dirty objects in the order set
+    std::vector<unsigned> dirty_;
+    /// Runs of the current upload
+    std::vector<Run> runs_;
+    /// Bytes per object
+    unsigned stride_{};
+    /// Objects
+    unsigned objectCount_{};
+    /// Whether the next upload copies all objects
+    bool uploadAll_{};
+    /// Statistics
+    ObjectBufferStats stats_;
+};
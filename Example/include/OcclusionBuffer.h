@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+
+#include "BoundingBox.h"
+#include "Matrix.h"
+#include "TransformBatch.h"
+
+
+class JobSystem;
+
+/// Occlusion statistics of the last frame.
+struct OcclusionStats
+{
+    /// Occluders inside the frustum
+    unsigned occluders_{};
+    /// Triangles set up for rasterization, after clipping
+    unsigned triangles_{};
+    /// Triangles split by the near plane
+    unsigned clippedTriangles_{};
+    /// Objects tested
+    unsigned tested_{};
+    /// Objects found hidden
+    unsigned occluded_{};
+};
+
+/// Occlusion culling on the CPU. Static occluder meshes are rasterized into a low resolution depth buffer,
+/// which is reduced into a hierarchical-Z pyramid keeping the furthest depth of each texel's children. A box
+/// is hidden when its nearest point is behind the furthest depth of the pyramid texels covering its screen
+/// rectangle, on the level where that rectangle spans at most 2x2 texels.
+///
+/// Triangles are clipped to the near plane, set up once and binned into square tiles. Tiles rasterize and
+/// reduce their part of the pyramid as jobs, FloatN pixels per iteration, so no two jobs write the same
+/// pixel. Pixels are covered when their center is inside a triangle, and depth follows Direct3D with 0 at
+/// the near and 1 at the far plane, so partially covered pixels stay far and the test is conservative.
+class OcclusionBuffer
+{
+public:
+    /// Width and height of a tile, a multiple of every lane width
+    static constexpr unsigned TileSize{32};
+    /// Default width
+    static constexpr unsigned DefaultWidth{256};
+    /// Default height
+    static constexpr unsigned DefaultHeight{128};
+
+    /// Construct with the default size.
+    explicit OcclusionBuffer();
+
+    /// Set size, powers of two of at least a tile. Return false if invalid.
+    bool SetSize(unsigned width, unsigned height);
+    /// Set job system to rasterize tiles on, null to rasterize on the calling thread.
+    void SetJobSystem(JobSystem* jobSystem) { jobSystem_ = jobSystem; }
+    /// Add a static occluder mesh in world space. Return its id.
+    unsigned AddOccluder(std::vector<Vector3> vertices, std::vector<unsigned> indices);
+    /// Remove all occluders.
+    void RemoveOccluders() { occluders_.clear(); }
+    /// Return number of occluders.
+    unsigned GetOccluderCount() const { return (unsigned) occluders_.size(); }
+
+    /// Rasterize the occluders seen from a view-projection and build the pyramid.
+    void Render(Matrix4 const& viewProjection);
+    /// Return whether a world space box may be visible.
+    bool IsVisible(BoundingBox const& box) const;
+    /// Test boxes FloatN at a time and fill the ids of those that may be visible, the id of box i being
+    /// ids[i]. Return their count.
+    unsigned Cull(BoundsArray const& boxes, std::vector<unsigned> const& ids, std::vector<unsigned>& visible);
+
+    /// Return width.
+    unsigned GetWidth() const { return width_; }
+    /// Return height.
+    unsigned GetHeight() const { return height_; }
+    /// Return number of pyramid levels, level 0 being the depth buffer.
+    unsigned GetLevelCount() const { return (unsigned) levelOffsets_.size(); }
+    /// Return depth of a pyramid level, rows of GetWidth() >> level texels.
+    float const* GetDepth(unsigned level) const { return depth_.data() + levelOffsets_[level]; }
+    /// Return statistics of the last frame.
+    OcclusionStats const& GetStats() const { return stats_; }
+
+private:
+    /// Static occluder
+    struct Occluder
+    {
+        /// World space vertices
+        std::vector<Vector3> vertices_;
+        /// Triangle list indices
+        std::vector<unsigned> indices_;
+        /// World space bounds
+        BoundingBox bounds_;
+    };
+
+    /// Triangle set up for rasterization. Edge functions and depth are planes A * x + B * y + C of pixel
+    /// coordinates relative to the minimum pixel bounds, so that they stay precise far from the origin.
+    struct RasterTriangle
+    {
+        /// Edge functions, positive inside
+        float edges_[3][3];
+        /// Depth plane
+        float depth_[3];
+        /// Pixel bounds, inclusive
+        int minX_, minY_, maxX_, maxY_;
+    };
+
+    /// Clip a triangle in clip space to the near plane and set up the result.
+    void SetupTriangle(Vector4 const* clip);
+    /// Set up a triangle in screen space and bin it into the tiles it overlaps.
+    void BinTriangle(Vector3 const& v0, Vector3 const& v1, Vector3 const& v2);
+    /// Rasterize the triangles binned into a tile and reduce its part of the pyramid.
+    void RasterizeTile(unsigned tile);
+    /// Reduce a rectangle of a pyramid level, in texels of that level, from the level above.
+    void Downsample(unsigned level, unsigned x0, unsigned y0, unsigned x1, unsigned y1);
+    /// Return whether a rectangle in normalized device coordinates with a nearest depth may be visible.
+    bool IsRectVisible(float minX, float minY, float maxX, float maxY, float minZ) const;
+
+    /// Width
+    unsigned width_{};
+    /// Height
+    unsigned height_{};
+    /// Tiles per row
+    unsigned tilesX_{};
+    /// Depth of all pyramid levels
+    std::vector<float> depth_;
+    /// Offsets of the pyramid levels
+    std::vector<unsigned> levelOffsets_;
+    /// Occluders
+    std::vector<Occluder> occluders_;
+    /// Clip space vertices of the occluder being set up
+    std::vector<Vector4> clipVertices_;
+    /// Triangles of the current frame
+    std::vector<RasterTriangle> triangles_;
+    /// Triangles binned per tile
+    std::vector<std::vector<unsigned>> bins_;
+    /// View-projection of the current frame
+    Matrix4 viewProjection_;
+    /// Job system, null to rasterize inline
+    JobSystem* jobSystem_{};
+    /// Statistics
+    OcclusionStats stats_;
+};
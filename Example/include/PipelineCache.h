@@ -0,0 +1,209 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ContentHash.h"
+#include "JobSystem.h"
+
+
+/// Native pipeline state created by a factory.
+typedef void* PipelineStateHandle;
+/// Native root signature. An ID3D12RootSignature pointer for the Direct3D12 backend.
+typedef void* RootSignatureHandle;
+
+/// Maximum number of simultaneous render targets of a pipeline.
+static const unsigned MAX_PIPELINE_RENDER_TARGETS = 8;
+
+/// Blend modes of a pipeline.
+enum PipelineBlendMode : unsigned
+{
+    PIPELINE_BLEND_REPLACE = 0,
+    PIPELINE_BLEND_ALPHA,
+    PIPELINE_BLEND_ADD,
+    PIPELINE_BLEND_PREMULTIPLIED_ALPHA,
+    MAX_PIPELINE_BLEND_MODES
+};
+
+/// Vertex input element.
+struct PipelineVertexElement
+{
+    /// Semantic name
+    std::string semantic_;
+    /// Semantic index
+    unsigned semanticIndex_{};
+    /// Format, numerically a DXGI_FORMAT
+    unsigned format_{};
+    /// Vertex buffer slot
+    unsigned inputSlot_{};
+    /// Byte offset in the vertex
+    unsigned offset_{};
+};
+
+/// Full description of a graphics pipeline. Shader bytecode is copied in so the description can be
+/// compiled on another thread after the caller's buffers are gone. Enumerations are numerically the
+/// Direct3D12 values.
+struct PipelineDesc
+{
+    /// Serialized root signature, empty if the vertex shader embeds one
+    std::vector<uint8_t> rootSignature_;
+    /// Vertex shader bytecode
+    std::vector<uint8_t> vertexShader_;
+    /// Pixel shader bytecode, empty for depth only pipelines
+    std::vector<uint8_t> pixelShader_;
+    /// Vertex input layout
+    std::vector<PipelineVertexElement> inputLayout_;
+    /// Render target formats
+    unsigned renderTargetFormats_[MAX_PIPELINE_RENDER_TARGETS]{};
+    /// Number of render targets
+    unsigned renderTargetCount_{};
+    /// Depth stencil format, 0 for none
+    unsigned depthStencilFormat_{};
+    /// Samples per pixel
+    unsigned sampleCount_{1};
+    /// Primitive topology type
+    unsigned primitiveTopologyType_{3};
+    /// Blend mode of all render targets
+    PipelineBlendMode blendMode_{PIPELINE_BLEND_REPLACE};
+    /// Fill mode
+    unsigned fillMode_{3};
+    /// Cull mode
+    unsigned cullMode_{3};
+    /// Depth comparison function
+    unsigned depthFunc_{4};
+    /// Depth test flag
+    bool depthTest_{true};
+    /// Depth write flag
+    bool depthWrite_{true};
+};
+
+/// Creates native pipeline states. Implemented on the Direct3D12 device and by a null factory without
+/// a device. CreatePipelineState is called from job threads and must be thread-safe.
+class PipelineStateFactory
+{
+public:
+    /// Destruct.
+    virtual ~PipelineStateFactory() = default;
+
+    /// Return identity of the device and driver. Cached blobs of another identity are discarded.
+    virtual uint64_t GetDeviceId() const = 0;
+    /// Create a pipeline state, starting from a cached blob if not null. Return null on failure.
+    virtual PipelineStateHandle CreatePipelineState(PipelineDesc const& desc, void const* cachedBlob, size_t cachedBlobSize) = 0;
+    /// Return the cached blob of a pipeline state. Return false if there is none.
+    virtual bool GetCachedBlob(PipelineStateHandle state, std::vector<uint8_t>& blob) = 0;
+    /// Release a pipeline state.
+    virtual void ReleasePipelineState(PipelineStateHandle state) = 0;
+};
+
+/// Pipeline cache statistics.
+struct PipelineCacheStats
+{
+    /// Requests
+    unsigned requests_{};
+    /// Requests answered by an existing pipeline
+    unsigned deduplicated_{};
+    /// Pipelines compiled from scratch
+    unsigned compiled_{};
+    /// Pipelines created from a blob of an earlier run
+    unsigned warmStarted_{};
+    /// Pipelines that failed to compile
+    unsigned failed_{};
+};
+
+/// Pipeline states keyed by a stable 128-bit hash of their full description. Identical requests share one
+/// pipeline, new ones compile on job threads when a job system is set, and the cached blobs are saved to
+/// and loaded from a file so later runs skip compilation. The hash covers a fixed little-endian
+/// serialization of the description, so it does not depend on padding, pointers or the compiler.
+class PipelineCache
+{
+public:
+    /// Pipeline identifier.
+    typedef unsigned PipelineId;
+
+    /// Invalid pipeline identifier.
+    static const PipelineId InvalidPipeline = ~0u;
+
+    /// Construct.
+    explicit PipelineCache();
+    /// Destruct.
+    ~PipelineCache();
+
+    /// Set the factory and optionally the job system to compile on.
+    void Initialize(PipelineStateFactory& factory, JobSystem* jobSystem = nullptr);
+    /// Wait for compiles in progress and release all pipeline states.
+    void Shutdown();
+    /// Return whether initialized.
+    bool IsInitialized() const { return factory_ != nullptr; }
+    /// Set the job system to compile on, null to compile on the requesting thread.
+    void SetJobSystem(JobSystem* jobSystem);
+
+    /// Request a pipeline. Identical descriptions return the same identifier. Thread-safe.
+    PipelineId Request(PipelineDesc const& desc);
+    /// Return pipeline state, null while it is compiling or if it failed.
+    PipelineStateHandle GetPipelineState(PipelineId id) const;
+    /// Return pipeline state, helping with compile jobs until it is ready. Null if it failed.
+    PipelineStateHandle WaitPipelineState(PipelineId id);
+    /// Return whether a pipeline has finished compiling, successfully or not.
+    bool IsReady(PipelineId id) const;
+    /// Wait for all compiles in progress.
+    void WaitAll();
+
+    /// Load cached blobs from a file. Return false if it is missing, corrupt or from another device.
+    bool Load(std::string const& fileName);
+    /// Save the cached blobs of all pipelines, including those loaded but not requested this run.
+    bool Save(std::string const& fileName);
+    /// Read cached blobs from memory. Return false if corrupt or from another device.
+    bool Deserialize(uint8_t const* data, size_t size);
+    /// Write cached blobs to memory.
+    void Serialize(std::vector<uint8_t>& data);
+
+    /// Return number of pipelines.
+    unsigned GetPipelineCount() const;
+    /// Return number of cached blobs, loaded or taken from compiled pipelines.
+    unsigned GetCachedBlobCount() const;
+    /// Return statistics.
+    PipelineCacheStats GetStats() const;
+
+    /// Return stable hash of a pipeline description.
+    static ContentHash HashDesc(PipelineDesc const& desc);
+
+private:
+    /// Pipeline
+    struct Pipeline
+    {
+        /// Description hash
+        ContentHash hash_;
+        /// Description, kept until compiled
+        PipelineDesc desc_;
+        /// Native pipeline state
+        std::atomic<PipelineStateHandle> state_{};
+        /// Finished flag
+        std::atomic<bool> ready_{};
+    };
+
+    /// Compile a pipeline.
+    void Compile(Pipeline& pipeline);
+
+    /// Factory
+    PipelineStateFactory* factory_{};
+    /// Job system to compile on
+    JobSystem* jobSystem_{};
+    /// Compile jobs in progress
+    JobCounter compileCounter_;
+    /// Lock for the maps, pipelines and statistics
+    mutable std::mutex mutex_;
+    /// Pipelines, a deque so references stay valid while compiling
+    std::deque<Pipeline> pipelines_;
+    /// Pipeline identifiers by hash
+    std::unordered_map<ContentHash, PipelineId, ContentHashHasher> pipelineIds_;
+    /// Cached blobs by hash
+    std::unordered_map<ContentHash, std::vector<uint8_t>, ContentHashHasher> cachedBlobs_;
+    /// Statistics
+    PipelineCacheStats stats_;
+};
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+
+/// Type of a profiler event.
+enum ProfilerEventType : uint32_t
+{
+    PROFILER_EVENT_ZONE = 0,
+    PROFILER_EVENT_COUNTER,
+    PROFILER_EVENT_FRAME,
+};
+
+/// Profiler event as stored in a thread buffer. Names must outlive the profiler, string literals in practice.
+struct ProfilerEvent
+{
+    /// Start time in ticks
+    uint64_t start_;
+    /// End time in ticks for zones, value for counters, frame number for frames
+    uint64_t value_;
+    /// Name
+    char const* name_;
+    /// Type
+    ProfilerEventType type_;
+    /// Nesting depth for zones
+    uint32_t depth_;
+};
+
+/// Event of a profiler timeline, converted to microseconds since the profiler started.
+struct ProfilerTimelineEvent
+{
+    /// Name
+    std::string name_;
+    /// Track, a thread or a GPU queue
+    unsigned track_;
+    /// Type
+    ProfilerEventType type_;
+    /// Start in microseconds
+    double start_;
+    /// Duration in microseconds for zones
+    double duration_;
+    /// Value for counters, frame number for frames
+    double value_;
+    /// Nesting depth for zones
+    unsigned depth_;
+};
+
+/// Events of one thread. Written only by its thread without locks; the collecting thread reads behind the
+/// write index and discards events the writer may have overwritten meanwhile.
+class ProfilerThreadBuffer
+{
+public:
+    /// Construct with a power of two capacity.
+    ProfilerThreadBuffer(std::string const& name, unsigned track, unsigned capacity);
+
+    /// Append an event, overwriting the oldest when full. Owning thread only.
+    void Write(ProfilerEvent const& event)
+    {
+        uint64_t index = writeIndex_.load(std::memory_order_relaxed);
+        events_[index & mask_] = event;
+        writeIndex_.store(index + 1, std::memory_order_release);
+    }
+    /// Copy events written since the last read. Return number of events lost to overwriting.
+    uint64_t Read(std::vector<ProfilerEvent>& events);
+
+    /// Set thread name. Called under the profiler lock.
+    void SetName(std::string const& name) { name_ = name; }
+    /// Return thread name. Called under the profiler lock.
+    std::string const& GetName() const { return name_; }
+    /// Return track index.
+    unsigned GetTrack() const { return track_; }
+
+    /// Current zone nesting depth, owning thread only
+    uint32_t depth_{};
+
+private:
+    /// Thread name
+    std::string name_;
+    /// Track index
+    unsigned track_;
+    /// Events, a ring
+    std::vector<ProfilerEvent> events_;
+    /// Index mask
+    uint64_t mask_;
+    /// Events written
+    std::atomic<uint64_t> writeIndex_{0};
+    /// Events read, collecting thread only
+    uint64_t readIndex_{};
+};
+
+/// Low overhead CPU profiler. Scoped zones read the time stamp counter and append to a ring buffer of the
+/// calling thread, so recording takes no locks. Collect moves the events into a timeline in microseconds that
+/// can be exported in the Chrome trace event format, which Perfetto and chrome://tracing open.
+class Profiler
+{
+public:
+    /// Construct.
+    explicit Profiler();
+
+    /// Return the global profiler used by the PROFILE macros.
+    static Profiler& Get();
+    /// Return current time in ticks.
+    static uint64_t GetTicks()
+    {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (uint64_t) std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    /// Enable or disable recording.
+    void SetEnabled(bool enable) { enabled_.store(enable, std::memory_order_relaxed); }
+    /// Return whether recording.
+    bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+    /// Set name of the calling thread's track.
+    void SetThreadName(std::string const& name);
+    /// Set capacity of thread buffers created from now on, rounded up to a power of two.
+    void SetThreadBufferCapacity(unsigned capacity);
+    /// Return buffer of the calling thread, creating it on first use.
+    ProfilerThreadBuffer& GetThreadBuffer();
+
+    /// Record a counter value.
+    void Counter(char const* name, int64_t value);
+    /// Record the start of a frame.
+    void Frame(uint64_t frameNumber);
+
+    /// Add a track that is not a CPU thread, for example a GPU queue. Return track index.
+    unsigned AddTrack(std::string const& name);
+    /// Add a zone timed elsewhere, in microseconds of the timeline.
+    void AddTimelineZone(unsigned track, std::string const& name, double start, double duration, unsigned depth);
+
+    /// Move the events of all threads into the timeline.
+    void Collect();
+    /// Clear the timeline.
+    void ClearTimeline();
+    /// Return the timeline.
+    std::vector<ProfilerTimelineEvent> const& GetTimeline() const { return timeline_; }
+    /// Return track names.
+    std::vector<std::string> GetTrackNames() const;
+    /// Return number of events lost because a thread buffer was full before collection.
+    uint64_t GetLostEventCount() const { return lostEvents_; }
+
+    /// Convert ticks to microseconds since the profiler started.
+    double TicksToMicroseconds(uint64_t ticks) const;
+    /// Return ticks per microsecond, measured against the steady clock.
+    double GetTicksPerMicrosecond() const;
+
+    /// Write the timeline in the Chrome trace event format.
+    void WriteChromeTrace(std::string& json) const;
+    /// Save the timeline in the Chrome trace event format. Return false on failure.
+    bool SaveChromeTrace(std::string const& fileName) const;
+
+private:
+    /// Ticks when constructed
+    uint64_t startTicks_;
+    /// Steady clock when constructed, in nanoseconds
+    int64_t startNanoseconds_;
+    /// Recording flag
+    std::atomic<bool> enabled_{true};
+    /// Capacity of new thread buffers
+    unsigned threadBufferCapacity_{1u << 16};
+    /// Lock for thread buffers, tracks and the timeline
+    mutable std::mutex mutex_;
+    /// Thread buffers
+    std::vector<std::unique_ptr<ProfilerThreadBuffer>> threadBuffers_;
+    /// Names of tracks that are not CPU threads
+    std::vector<std::pair<unsigned, std::string>> extraTracks_;
+    /// Number of tracks
+    unsigned trackCount_{};
+    /// Collected events
+    std::vector<ProfilerTimelineEvent> timeline_;
+    /// Scratch for collection
+    std::vector<ProfilerEvent> collectScratch_;
+    /// Events lost to full buffers
+    uint64_t lostEvents_{};
+};
+
+/// Zone timing its scope.
+class ProfilerScope
+{
+public:
+    /// Begin a zone.
+    explicit ProfilerScope(char const* name)
+    {
+        Profiler& profiler = Profiler::Get();
+        if (!profiler.IsEnabled())
+            return;
+
+        buffer_ = &profiler.GetThreadBuffer();
+        name_ = name;
+        depth_ = buffer_->depth_++;
+        start_ = Profiler::GetTicks();
+    }
+
+    /// End the zone.
+    ~ProfilerScope()
+    {
+        if (!buffer_)
+            return;
+
+        uint64_t end = Profiler::GetTicks();
+        buffer_->depth_ = depth_;
+        buffer_->Write({ start_, end, name_, PROFILER_EVENT_ZONE, depth_ });
+    }
+
+    ProfilerScope(ProfilerScope const&) = delete;
+    ProfilerScope& operator =(ProfilerScope const&) = delete;
+
+private:
+    /// Thread buffer, null when disabled
+    ProfilerThreadBuffer* buffer_{};
+    /// Name
+    char const* name_{};
+    /// Start ticks
+    uint64_t start_{};
+    /// Nesting depth
+    uint32_t depth_{};
+};
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+#ifndef DISABLE_PROFILER
+/// Time the enclosing scope.
+#define PROFILE_SCOPE(name) ProfilerScope PROFILER_CONCAT(profilerScope, __LINE__)(name)
+/// Record a counter value.
+#define PROFILE_COUNTER(name, value) Profiler::Get().Counter(name, (int64_t) (value))
+/// Mark the start of a frame.
+#define PROFILE_FRAME(frameNumber) Profiler::Get().Frame(frameNumber)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNTER(name, value)
+#define PROFILE_FRAME(frameNumber)
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cmath>
+
+#include "Vector.h"
+
+
+/// Rotation quaternion.
+struct alignas(16) Quaternion
+{
+    /// Construct identity.
+    Quaternion() = default;
+    /// Construct from components.
+    Quaternion(float x, float y, float z, float w) : x_(x), y_(y), z_(z), w_(w) {}
+
+    /// Return rotation around a unit axis by an angle in radians.
+    static Quaternion FromAxisAngle(Vector3 const& axis, float angle)
+    {
+        float s = std::sin(angle * 0.5f);
+        return { axis.x_ * s, axis.y_ * s, axis.z_ * s, std::cos(angle * 0.5f) };
+    }
+
+    /// Return rotation by rhs followed by this one.
+    Quaternion operator *(Quaternion const& rhs) const
+    {
+        return {
+            w_ * rhs.x_ + x_ * rhs.w_ + y_ * rhs.z_ - z_ * rhs.y_,
+            w_ * rhs.y_ - x_ * rhs.z_ + y_ * rhs.w_ + z_ * rhs.x_,
+            w_ * rhs.z_ + x_ * rhs.y_ - y_ * rhs.x_ + z_ * rhs.w_,
+            w_ * rhs.w_ - x_ * rhs.x_ - y_ * rhs.y_ - z_ * rhs.z_
+        };
+    }
+    bool operator ==(Quaternion const& rhs) const { return x_ == rhs.x_ && y_ == rhs.y_ && z_ == rhs.z_ && w_ == rhs.w_; }
+    bool operator !=(Quaternion const& rhs) const { return !(*this == rhs); }
+
+    /// Return dot product.
+    float Dot(Quaternion const& rhs) const { return Dot4(Float4::Load(&x_), Float4::Load(&rhs.x_)); }
+    /// Return inverse of a unit quaternion.
+    Quaternion Conjugate() const { return { -x_, -y_, -z_, w_ }; }
+    /// Return unit quaternion.
+    Quaternion Normalized() const
+    {
+        float length = std::sqrt(Dot(*this));
+        if (length <= 0.0f)
+            return Quaternion();
+        Quaternion ret;
+        Store(&ret.x_, Float4::Load(&x_) * Float4::Splat(1.0f / length));
+        return ret;
+    }
+    /// Return a vector rotated.
+    Vector3 Rotate(Vector3 const& v) const
+    {
+        // v + 2w(q x v) + 2q x (q x v)
+        Vector3 q(x_, y_, z_);
+        Vector3 t = q.Cross(v) * 2.0f;
+        return v + t * w_ + q.Cross(t);
+    }
+
+    /// Return normalized linear interpolation, taking the shorter arc.
+    Quaternion Nlerp(Quaternion const& rhs, float t) const
+    {
+        Float4 a = Float4::Load(&x_);
+        Float4 b = Float4::Load(&rhs.x_) * Float4::Splat(Dot(rhs) < 0.0f ? -1.0f : 1.0f);
+        Quaternion ret;
+        Store(&ret.x_, MulAdd(b - a, Float4::Splat(t), a));
+        return ret.Normalized();
+    }
+    /// Return spherical linear interpolation, taking the shorter arc.
+    Quaternion Slerp(Quaternion const& rhs, float t) const
+    {
+        float cosAngle = Dot(rhs);
+        float sign = cosAngle < 0.0f ? -1.0f : 1.0f;
+        cosAngle *= sign;
+        // Nearly parallel quaternions divide by a vanishing sine
+        if (cosAngle > 0.9995f)
+            return Nlerp(rhs, t);
+
+        float angle = std::acos(cosAngle);
+        float invSin = 1.0f / std::sin(angle);
+        float a = std::sin((1.0f - t) * angle) * invSin;
+        float b = std::sin(t * angle) * invSin * sign;
+        Quaternion ret;
+        Store(&ret.x_, MulAdd(Float4::Load(&rhs.x_), Float4::Splat(b), Float4::Load(&x_) * Float4::Splat(a)));
+        return ret;
+    }
+
+    float x_{};
+    float y_{};
+    float z_{};
+    float w_{1.0f};
+};
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "GraphicsDefs.h"
+
+
+class GraphicsBackend;
+class RenderGraph;
+class ResourceStateRegistry;
+
+/// Handle of a resource in a render graph.
+typedef unsigned RenderGraphResource;
+
+/// Invalid render graph resource.
+static const RenderGraphResource INVALID_RENDER_GRAPH_RESOURCE = ~0u;
+
+/// Usage flags of a transient texture.
+enum TextureUsageFlags : unsigned
+{
+    TEXTURE_USAGE_RENDER_TARGET = 0x1,
+    TEXTURE_USAGE_DEPTH_STENCIL = 0x2,
+    TEXTURE_USAGE_UNORDERED_ACCESS = 0x4,
+};
+
+/// Description of a transient texture.
+struct TextureDesc
+{
+    /// Return whether two descriptions create identical textures.
+    bool operator ==(TextureDesc const& rhs) const
+    {
+        return width_ == rhs.width_ && height_ == rhs.height_ && format_ == rhs.format_ &&
+            sampleCount_ == rhs.sampleCount_ && usage_ == rhs.usage_;
+    }
+
+    /// Width
+    unsigned width_{};
+    /// Height
+    unsigned height_{};
+    /// Format, numerically a DXGI_FORMAT
+    unsigned format_{};
+    /// Samples per pixel
+    unsigned sampleCount_{1};
+    /// Usage flags, render target or depth stencil is required so textures can share one heap
+    unsigned usage_{TEXTURE_USAGE_RENDER_TARGET};
+};
+
+/// Creates the textures of a render graph in a transient heap that they alias and caches them across
+/// frames. Implemented on the Direct3D12 device and by a null factory that only hands out handles.
+class TransientResourceFactory
+{
+public:
+    /// Construct.
+    explicit TransientResourceFactory(ResourceStateRegistry& registry);
+    /// Destruct.
+    virtual ~TransientResourceFactory();
+
+    /// Make sure the transient heap holds size bytes. Textures not acquired in the previous frame are released.
+    void BeginFrame(uint64_t heapSize);
+    /// Return a texture placed at offset in the transient heap, created in initialState if not cached.
+    ResourceHandle AcquireTexture(TextureDesc const& desc, uint64_t offset, unsigned initialState);
+    /// Release all textures and the heap.
+    void ReleaseAll();
+
+    /// Return number of cached textures.
+    unsigned GetTextureCount() const { return (unsigned) textures_.size(); }
+    /// Return size of the transient heap.
+    uint64_t GetHeapSize() const { return heapSize_; }
+
+    /// Return size and placement alignment of a texture.
+    virtual void GetAllocationInfo(TextureDesc const& desc, uint64_t& size, uint64_t& alignment) = 0;
+
+protected:
+    /// Create the transient heap. Return false on failure.
+    virtual bool CreateHeap(uint64_t size) = 0;
+    /// Release the transient heap once the GPU is done with it.
+    virtual void ReleaseHeap() = 0;
+    /// Create a texture at offset in the heap. Return null on failure.
+    virtual ResourceHandle CreateTexture(TextureDesc const& desc, uint64_t offset, unsigned initialState) = 0;
+    /// Release a texture once the GPU is done with it.
+    virtual void ReleaseTexture(ResourceHandle texture) = 0;
+
+private:
+    /// Cached texture
+    struct Texture
+    {
+        /// Description
+        TextureDesc desc_;
+        /// Offset in the heap
+        uint64_t offset_;
+        /// Native texture
+        ResourceHandle handle_;
+        /// Last frame it was acquired in
+        uint64_t frame_;
+    };
+
+    /// Release one cached texture.
+    void ReleaseCachedTexture(unsigned index);
+
+    /// Resource states
+    ResourceStateRegistry& registry_;
+    /// Cached textures
+    std::vector<Texture> textures_;
+    /// Size of the transient heap
+    uint64_t heapSize_{};
+    /// Frame number
+    uint64_t frame_{};
+};
+
+/// Declares the resource accesses of a pass while it is added to the graph.
+class RenderGraphBuilder
+{
+public:
+    /// Construct.
+    RenderGraphBuilder(RenderGraph& graph, unsigned pass) : graph_(graph), pass_(pass) { }
+
+    /// Create a transient texture. Its memory may be shared with textures whose lifetimes do not overlap, so
+    /// the first pass writing it must clear or fully overwrite it.
+    RenderGraphResource CreateTexture(std::string const& name, TextureDesc const& desc);
+    /// Read a resource in a state.
+    RenderGraphResource Read(RenderGraphResource resource, unsigned state = RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    /// Write a resource in a state.
+    RenderGraphResource Write(RenderGraphResource resource, unsigned state = RESOURCE_STATE_RENDER_TARGET);
+    /// Keep the pass even if nothing reads what it writes.
+    void SetSideEffect();
+
+private:
+    /// Graph
+    RenderGraph& graph_;
+    /// Pass index
+    unsigned pass_;
+};
+
+/// Resources and backend available to a pass while it executes.
+class RenderGraphContext
+{
+public:
+    /// Construct.
+    RenderGraphContext(RenderGraph const& graph, GraphicsBackend& backend) : graph_(graph), backend_(backend) { }
+
+    /// Return backend to record into.
+    GraphicsBackend& GetBackend() const { return backend_; }
+    /// Return native resource.
+    ResourceHandle GetResource(RenderGraphResource resource) const;
+
+private:
+    /// Graph
+    RenderGraph const& graph_;
+    /// Backend
+    GraphicsBackend& backend_;
+};
+
+/// Statistics of the last compile.
+struct RenderGraphStats
+{
+    /// Passes added
+    unsigned passes_{};
+    /// Passes culled because nothing used their output
+    unsigned culledPasses_{};
+    /// Transition barriers
+    unsigned barriers_{};
+    /// Aliasing barriers
+    unsigned aliasingBarriers_{};
+    /// Transient textures
+    unsigned transientTextures_{};
+    /// Bytes the transient textures would need without aliasing
+    uint64_t transientSize_{};
+    /// Size of the transient heap
+    uint64_t transientHeapSize_{};
+};
+
+/// Frame graph of passes that declare the resources they read and write. Compiling culls passes whose
+/// output is never used, orders the remaining ones, computes the barriers between them and places
+/// transient textures with disjoint lifetimes at overlapping offsets of one heap. Rebuilt every frame.
+class RenderGraph
+{
+    friend class RenderGraphBuilder;
+    friend class RenderGraphContext;
+
+public:
+    /// Function declaring the accesses of a pass.
+    typedef std::function<void(RenderGraphBuilder&)> SetupFunction;
+    /// Function recording a pass.
+    typedef std::function<void(RenderGraphContext&)> ExecuteFunction;
+
+    /// Construct.
+    explicit RenderGraph();
+
+    /// Remove all passes and resources.
+    void Reset();
+    /// Import a resource owned outside the graph in its current state. Passes writing it are never culled.
+    RenderGraphResource Import(std::string const& name, ResourceHandle handle, unsigned state);
+    /// Add a pass. Setup runs immediately, execute runs during Execute unless the pass is culled.
+    void AddPass(std::string const& name, SetupFunction const& setup, ExecuteFunction const& execute);
+
+    /// Cull, order and place resources. Return false if the passes have a cyclic dependency.
+    bool Compile(TransientResourceFactory& factory);
+    /// Acquire transient textures and record the passes with their barriers.
+    void Execute(GraphicsBackend& backend, TransientResourceFactory& factory);
+
+    /// Return compiled pass order as pass indices.
+    std::vector<unsigned> const& GetPassOrder() const { return order_; }
+    /// Return name of a pass.
+    std::string const& GetPassName(unsigned pass) const { return passes_[pass].name_; }
+    /// Return offset of a transient texture in the transient heap.
+    uint64_t GetTransientOffset(RenderGraphResource resource) const { return resources_[resource].offset_; }
+    /// Return statistics of the last compile.
+    RenderGraphStats const& GetStats() const { return stats_; }
+
+private:
+    /// Resource access of a pass
+    struct Access
+    {
+        /// Resource
+        RenderGraphResource resource_;
+        /// Required state
+        unsigned state_;
+    };
+
+    /// Barrier before a pass
+    struct Barrier
+    {
+        /// Resource
+        RenderGraphResource resource_;
+        /// State after the barrier
+        unsigned state_;
+        /// Aliasing barrier flag
+        bool aliasing_;
+    };
+
+    /// Pass
+    struct Pass
+    {
+        /// Name
+        std::string name_;
+        /// Recording function
+        ExecuteFunction execute_;
+        /// Reads
+        std::vector<Access> reads_;
+        /// Writes
+        std::vector<Access> writes_;
+        /// Passes that must run before, for reading what they write or writing what they read
+        std::vector<unsigned> dependencies_;
+        /// Passes whose output this pass uses
+        std::vector<unsigned> producers_;
+        /// Barriers before the pass
+        std::vector<Barrier> barriers_;
+        /// Never culled flag
+        bool sideEffect_;
+        /// Kept by culling flag
+        bool alive_;
+    };
+
+    /// Resource
+    struct Resource
+    {
+        /// Name
+        std::string name_;
+        /// Description of a transient texture
+        TextureDesc desc_;
+        /// Native resource, set at execute for transient textures
+        ResourceHandle handle_;
+        /// State when imported, state of the first use for transient textures
+        unsigned initialState_;
+        /// Transient flag
+        bool transient_;
+        /// First use in the pass order
+        unsigned firstUse_;
+        /// Last use in the pass order
+        unsigned lastUse_;
+        /// Size in the transient heap
+        uint64_t size_;
+        /// Placement alignment
+        uint64_t alignment_;
+        /// Offset in the transient heap
+        uint64_t offset_;
+    };
+
+    /// Find passes whose output is used.
+    void CullPasses();
+    /// Order the live passes. Return false on a cycle.
+    bool OrderPasses();
+    /// Place transient textures in the transient heap.
+    void PlaceTransientResources(TransientResourceFactory& factory);
+    /// Compute the barriers before each pass.
+    void ComputeBarriers();
+    /// Return whether a pass writes a resource.
+    static bool IsWritten(Pass const& pass, RenderGraphResource resource);
+    /// Return combined state of the reads of a resource from an order position until the next write.
+    unsigned GetCombinedReadState(RenderGraphResource resource, unsigned position) const;
+
+    /// Passes in declaration order
+    std::vector<Pass> passes_;
+    /// Resources
+    std::vector<Resource> resources_;
+    /// Live passes in execution order
+    std::vector<unsigned> order_;
+    /// Transient textures sorted for placement
+    std::vector<RenderGraphResource> placement_;
+    /// Size of the transient heap
+    uint64_t heapSize_{};
+    /// Statistics
+    RenderGraphStats stats_;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "GraphicsDefs.h"
+#include "PipelineCache.h"
+
+
+class CommandList;
+class JobSystem;
+
+/// Everything a draw binds and its arguments.
+struct DrawPacket
+{
+    /// Descriptor tables per draw, bound to root parameters 0 and up
+    static constexpr unsigned MaxDescriptorTables{4};
+
+    /// Pipeline state
+    PipelineStateHandle pipelineState_{};
+    /// Root signature, null if the pipeline state embeds it
+    RootSignatureHandle rootSignature_{};
+    /// GPU addresses of the descriptor tables, zero for parameters the draw does not use
+    uint64_t descriptorTables_[MaxDescriptorTables]{};
+    /// Vertex buffer, a zero address for none
+    VertexBufferView vertexBuffer_;
+    /// Vertices per instance
+    unsigned vertexCount_{};
+    /// Instances
+    unsigned instanceCount_{1};
+    /// First vertex
+    unsigned firstVertex_{};
+    /// First instance
+    unsigned firstInstance_{};
+};
+
+/// State changes of the last submit, recorded and skipped as redundant.
+struct RenderQueueStats
+{
+    /// Draws recorded
+    unsigned draws_{};
+    /// Radix sort passes run, digits all keys share are skipped
+    unsigned sortPasses_{};
+    /// Sort jobs per pass, 0 when sorted inline
+    unsigned sortJobs_{};
+    /// Command lists the draws were recorded into
+    unsigned commandLists_{};
+    /// Pipeline states bound
+    unsigned pipelineStates_{};
+    /// Pipeline state bindings skipped
+    unsigned pipelineStatesSkipped_{};
+    /// Root signatures bound
+    unsigned rootSignatures_{};
+    /// Root signature bindings skipped
+    unsigned rootSignaturesSkipped_{};
+    /// Descriptor tables bound
+    unsigned descriptorTables_{};
+    /// Descriptor table bindings skipped
+    unsigned descriptorTablesSkipped_{};
+    /// Vertex buffers bound
+    unsigned vertexBuffers_{};
+    /// Vertex buffer bindings skipped
+    unsigned vertexBuffersSkipped_{};
+};
+
+/// Queue of draw packets sorted by 64-bit keys before submission. Keys order draws by pass, then opaque
+/// draws by pipeline, material and depth front to back so that neighbors share state, and translucent draws
+/// by depth back to front for blending. Sorting is a least significant digit radix sort of eight 8-bit
+/// digits, stable, with all digit histograms counted in one read and digits that every key shares skipped.
+/// Chunks of the keys count and scatter as jobs, each chunk scattering to offsets of its own within every
+/// bucket, and count again before every pass but the first as scattering moves keys between chunks.
+/// Submitting records the draws in key order and skips bindings of state that is already bound, optionally
+/// splitting them into ranges that record into command lists of their own as jobs.
+class RenderQueue
+{
+public:
+    /// Function returning a command list set up for recording draws, or null on failure.
+    typedef std::function<CommandList*()> AcquireFunction;
+
+    /// Pass bits at the top of a key
+    static constexpr unsigned PassBits{6};
+    /// Pipeline bits
+    static constexpr unsigned PipelineBits{14};
+    /// Material bits
+    static constexpr unsigned MaterialBits{16};
+    /// Depth bits
+    static constexpr unsigned DepthBits{24};
+    /// Fewest keys per sort job
+    static constexpr unsigned MinSortBatchSize{8192};
+    /// Fewest draws per recording job
+    static constexpr unsigned MinSubmitBatchSize{1024};
+
+    /// Construct.
+    explicit RenderQueue();
+
+    /// Make a sort key. Pass, pipeline and material are small indices the caller assigns, masked to their
+    /// bits, and depth is normalized to [0, 1]. The lowest 3 bits are left zero.
+    static uint64_t MakeSortKey(unsigned pass, bool translucent, unsigned pipeline, unsigned material, float depth);
+
+    /// Set job system to sort on, null to sort on the calling thread.
+    void SetJobSystem(JobSystem* jobSystem) { jobSystem_ = jobSystem; }
+    /// Remove all draws, keeping capacity.
+    void Clear();
+    /// Add a draw.
+    void Add(uint64_t sortKey, DrawPacket const& packet);
+    /// Return number of draws.
+    unsigned GetDrawCount() const { return (unsigned) keys_.size(); }
+
+    /// Sort the draws by key. Draws of equal keys keep the order they were added in.
+    void Sort();
+    /// Return draw indices in key order, valid after Sort until the queue changes.
+    std::vector<unsigned> const& GetOrder() const { return order_; }
+    /// Record the sorted draws into a command list, skipping redundant bindings.
+    void Submit(CommandList& commandList);
+    /// Record the sorted draws in ranges of at least MinSubmitBatchSize draws, at most one per thread of the
+    /// job system, each as a job into a command list from acquire called on the recording thread. Fill the
+    /// lists in draw order, leaving out ranges whose acquire failed, and always at least one.
+    void Submit(AcquireFunction const& acquire, std::vector<CommandList*>& commandLists);
+    /// Record sorted draws [begin, end) into a command list, as the first draws on it. Ranges may record
+    /// into lists of their own in parallel. Return their statistics.
+    RenderQueueStats Submit(CommandList& commandList, unsigned begin, unsigned end) const;
+    /// Return statistics of the last Sort and Submit.
+    RenderQueueStats const& GetStats() const { return stats_; }
+
+private:
+    /// Count all digits of keys [begin, end) into a chunk's histograms and set their initial order.
+    void CountChunk(unsigned chunk, unsigned begin, unsigned end);
+    /// Count one digit of keys [begin, end) of the current order into a chunk's histogram.
+    void CountDigit(unsigned chunk, unsigned digit, unsigned begin, unsigned end);
+    /// Scatter keys [begin, end) of the current source by a digit to the chunk's bucket offsets.
+    void ScatterChunk(unsigned chunk, unsigned digit, unsigned begin, unsigned end);
+    /// Run a function on every chunk, as jobs if there are several.
+    template <class Function> void ForEachChunk(unsigned count, Function const& function);
+
+    /// Sort keys in the order added
+    std::vector<uint64_t> keys_;
+    /// Draw packets in the order added
+    std::vector<DrawPacket> packets_;
+    /// Keys in the current order
+    std::vector<uint64_t> sortedKeys_;
+    /// Draw indices in the current order
+    std::vector<unsigned> order_;
+    /// Scatter destination of the keys
+    std::vector<uint64_t> tempKeys_;
+    /// Scatter destination of the draw indices
+    std::vector<unsigned> tempOrder_;
+    /// Histograms of every digit per chunk, then bucket offsets of the current digit
+    std::vector<unsigned> histograms_;
+    /// Statistics per recorded range
+    std::vector<RenderQueueStats> rangeStats_;
+    /// Keys per chunk
+    unsigned chunkSize_{};
+    /// Job system, null to sort inline
+    JobSystem* jobSystem_{};
+    /// Statistics
+    RenderQueueStats stats_;
+};
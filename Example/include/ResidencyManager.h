@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+
+/// Pageable GPU memory object with its size.
+struct ResidencyObject
+{
+    /// Native object, an ID3D12Pageable for the Direct3D12 backend
+    void* object_;
+    /// Size in bytes
+    uint64_t size_;
+};
+
+/// Video memory budget of the process, as DXGI_QUERY_VIDEO_MEMORY_INFO reports it.
+struct VideoMemoryInfo
+{
+    /// Bytes the process may use without the OS paging its memory out
+    uint64_t budget_{};
+    /// Bytes the process uses
+    uint64_t usage_{};
+};
+
+/// Queries the video memory budget and changes the residency of pageable objects. Implemented on DXGI and
+/// the Direct3D12 device and by a null backend with a simulated budget.
+class ResidencyBackend
+{
+public:
+    /// Destruct.
+    virtual ~ResidencyBackend() = default;
+
+    /// Query budget and usage of local video memory. Return false on failure.
+    virtual bool QueryVideoMemory(VideoMemoryInfo& info) = 0;
+    /// Make objects resident with one call, blocking until they are. Return false on failure.
+    virtual bool MakeResident(ResidencyObject const* objects, unsigned count) = 0;
+    /// Evict objects with one call.
+    virtual void Evict(ResidencyObject const* objects, unsigned count) = 0;
+};
+
+/// Residency statistics.
+struct ResidencyStats
+{
+    /// Return usage relative to the budget, above 1 when over budget.
+    float GetPressure() const { return budget_ ? (float) usage_ / (float) budget_ : 0.0f; }
+
+    /// Budget as of the last commit
+    uint64_t budget_{};
+    /// Usage as of the last commit
+    uint64_t usage_{};
+    /// Bytes of tracked objects
+    uint64_t trackedSize_{};
+    /// Bytes of tracked objects that are resident
+    uint64_t residentSize_{};
+    /// Objects evicted so far
+    uint64_t evictedObjects_{};
+    /// Bytes evicted so far
+    uint64_t evictedSize_{};
+    /// Objects made resident again so far
+    uint64_t madeResidentObjects_{};
+    /// Bytes made resident again so far
+    uint64_t madeResidentSize_{};
+    /// Evict calls so far
+    uint64_t evictCalls_{};
+    /// MakeResident calls so far
+    uint64_t makeResidentCalls_{};
+    /// Commits that stayed over the target because the GPU still used everything evictable
+    uint64_t overBudgetCommits_{};
+};
+
+/// Keeps usage of video memory within the budget. Tracked objects are kept in least recently used order
+/// by the value of their last use, a fence value or frame number. Each Commit first makes resident what was
+/// used while evicted, then, when usage is above the target share of the budget, evicts the least recently
+/// used objects the GPU has finished with, all in one call each. Pinned objects are never evicted.
+class ResidencyManager
+{
+public:
+    /// Default share of the budget to stay within, leaving headroom for allocations between commits
+    static constexpr float DefaultBudgetTarget{0.9f};
+
+    /// Construct.
+    explicit ResidencyManager();
+    /// Destruct.
+    ~ResidencyManager();
+
+    /// Set the backend.
+    void Initialize(ResidencyBackend& backend);
+    /// Forget all objects.
+    void Shutdown();
+    /// Return whether initialized.
+    bool IsInitialized() const { return backend_ != nullptr; }
+    /// Set share of the budget to stay within.
+    void SetBudgetTarget(float target) { budgetTarget_ = target; }
+
+    /// Track a resident object. A pinned one is never evicted.
+    void Track(void* object, uint64_t size, bool pinned = false);
+    /// Stop tracking an object before it is destroyed.
+    void Untrack(void* object);
+    /// Record a use of an object by GPU work that completes at a value. An evicted object is made resident
+    /// by the next Commit, which must come before the work is submitted.
+    void MarkUsed(void* object, uint64_t value);
+    /// Make resident what was used while evicted, then evict down to the target share of the budget what the
+    /// GPU has finished with as of completedValue. Return false if objects could not be made resident.
+    bool Commit(uint64_t completedValue);
+
+    /// Return whether an object is resident.
+    bool IsResident(void* object) const;
+    /// Return number of tracked objects.
+    unsigned GetObjectCount() const { return (unsigned) objects_.size(); }
+    /// Return statistics.
+    ResidencyStats const& GetStats() const { return stats_; }
+
+private:
+    /// Tracked object
+    struct Entry
+    {
+        /// Object and size
+        ResidencyObject object_;
+        /// Value of the last use
+        uint64_t lastUse_;
+        /// Resident flag
+        bool resident_;
+        /// Pinned flag
+        bool pinned_;
+        /// Queued for MakeResident flag
+        bool pending_;
+    };
+
+    /// Backend
+    ResidencyBackend* backend_{};
+    /// Objects least recently used first
+    std::list<Entry> lru_;
+    /// Objects by native object
+    std::unordered_map<void*, std::list<Entry>::iterator> objects_;
+    /// Evicted objects used since the last commit
+    std::vector<void*> pending_;
+    /// Scratch of the objects of a MakeResident or Evict call
+    std::vector<ResidencyObject> batch_;
+    /// Share of the budget to stay within
+    float budgetTarget_{DefaultBudgetTarget};
+    /// Statistics
+    ResidencyStats stats_;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "GraphicsDefs.h"
+
+class CommandList;
+class GraphicsBackend;
+
+
+/// Tracked states of the subresources of one resource. Stored as one state while all subresources agree.
+struct ResourceStates
+{
+    /// State of a subresource not known yet by a deferred tracker.
+    static const unsigned UnknownState = 0xffffffff;
+
+    /// Return state of a subresource.
+    unsigned Get(unsigned subresource) const { return subresourceStates_.empty() ? state_ : subresourceStates_[subresource]; }
+    /// Set state of a subresource or of all subresources.
+    void Set(unsigned subresource, unsigned state);
+    /// Return whether all subresources share one state.
+    bool IsUniform() const { return subresourceStates_.empty(); }
+
+    /// Number of subresources
+    unsigned subresourceCount_{1};
+    /// State shared by all subresources
+    unsigned state_{RESOURCE_STATE_COMMON};
+    /// Per subresource states, empty while uniform
+    std::vector<unsigned> subresourceStates_;
+};
+
+/// States of all resources as of the last submitted command list.
+class ResourceStateRegistry
+{
+public:
+    /// Construct.
+    explicit ResourceStateRegistry();
+
+    /// Start tracking a resource.
+    void RegisterResource(ResourceHandle resource, unsigned subresourceCount, unsigned initialState);
+    /// Stop tracking a resource.
+    void UnregisterResource(ResourceHandle resource);
+    /// Return states of a resource or null if not tracked.
+    ResourceStates const* GetStates(ResourceHandle resource) const;
+    /// Return states of a resource, registering it in the common state if not tracked.
+    ResourceStates& GetOrAddStates(ResourceHandle resource, unsigned subresourceCount);
+    /// Return number of tracked resources.
+    unsigned GetResourceCount() const { return (unsigned) states_.size(); }
+
+private:
+    /// States per resource
+    std::unordered_map<ResourceHandle, ResourceStates> states_;
+};
+
+/// Barrier statistics of a tracker.
+struct ResourceBarrierStats
+{
+    /// Barriers emitted
+    unsigned barriers_{};
+    /// ResourceBarrier calls
+    unsigned batches_{};
+    /// Transitions dropped because the resource already was in a compatible state
+    unsigned redundant_{};
+    /// Transitions folded into a barrier of the same batch
+    unsigned merged_{};
+};
+
+/// Tracks resource states while a command list is recorded and batches the transitions it needs.
+/// An immediate tracker starts from the registry states, which is only valid when lists are recorded
+/// in submission order. A deferred tracker records the first use of every subresource and leaves
+/// the matching barriers to ResolvePendingBarriers at submission.
+class ResourceStateTracker
+{
+public:
+    /// Construct.
+    explicit ResourceStateTracker(ResourceStateRegistry& registry, bool deferred = false);
+
+    /// Forget local states before recording a new command list.
+    void Reset();
+    /// Transition a subresource or all subresources. Redundant transitions are dropped.
+    void Transition(ResourceHandle resource, unsigned after, unsigned subresource = ALL_SUBRESOURCES);
+    /// Begin a split transition, the resource must not be used until EndTransition.
+    void BeginTransition(ResourceHandle resource, unsigned after, unsigned subresource = ALL_SUBRESOURCES);
+    /// End a split transition started with BeginTransition.
+    void EndTransition(ResourceHandle resource, unsigned subresource = ALL_SUBRESOURCES);
+    /// Activate a resource whose memory overlaps a resource used earlier. Before may be null when unknown.
+    void AliasingBarrier(ResourceHandle before, ResourceHandle after);
+    /// Record the batched barriers with one ResourceBarrier call. Return number of barriers.
+    unsigned FlushBarriers(GraphicsBackend& backend);
+    /// Record the batched barriers into a pooled command list. Return number of barriers.
+    unsigned FlushBarriers(CommandList& commandList);
+    /// Return barriers not flushed yet.
+    std::vector<ResourceBarrierDesc> const& GetBarriers() const { return barriers_; }
+
+    /// Append the barriers the first uses of a deferred tracker need against the registry states.
+    void ResolvePendingBarriers(std::vector<ResourceBarrierDesc>& barriers) const;
+    /// Write the final local states into the registry once the command list is submitted.
+    void Commit();
+
+    /// Return statistics since the last ResetStats.
+    ResourceBarrierStats const& GetStats() const { return stats_; }
+    /// Reset statistics.
+    void ResetStats() { stats_ = ResourceBarrierStats(); }
+
+private:
+    /// First use of a subresource in a deferred tracker
+    struct PendingTransition
+    {
+        /// Resource
+        ResourceHandle resource_;
+        /// Subresource
+        unsigned subresource_;
+        /// State required by the first use
+        unsigned state_;
+    };
+
+    /// Split transition in progress
+    struct SplitTransition
+    {
+        /// Resource
+        ResourceHandle resource_;
+        /// Subresource
+        unsigned subresource_;
+        /// State after the transition
+        unsigned after_;
+    };
+
+    /// Return local states of a resource, adding them on first use.
+    ResourceStates& GetLocalStates(ResourceHandle resource);
+    /// Transition one subresource, or all subresources when uniform.
+    void TransitionSubresource(ResourceHandle resource, ResourceStates& states, unsigned after, unsigned subresource);
+    /// Add a barrier, folding it into an earlier barrier of the batch when possible.
+    void AddBarrier(ResourceHandle resource, unsigned subresource, unsigned before, unsigned after);
+
+    /// Registry
+    ResourceStateRegistry& registry_;
+    /// Local states of the resources used by the command list
+    std::unordered_map<ResourceHandle, ResourceStates> localStates_;
+    /// Barriers not flushed yet
+    std::vector<ResourceBarrierDesc> barriers_;
+    /// First uses of a deferred tracker
+    std::vector<PendingTransition> pending_;
+    /// Split transitions in progress
+    std::vector<SplitTransition> splits_;
+    /// Statistics
+    ResourceBarrierStats stats_;
+    /// Deferred flag
+    bool deferred_;
+};
+
+/// Return whether a resource in state before can be used in state after without a barrier.
+bool IsResourceStateCompatible(unsigned before, unsigned after);
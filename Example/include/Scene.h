@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+
+class JobSystem;
+class Scene;
+struct SceneArchetype;
+
+/// Most component types of a scene.
+static const unsigned MAX_SCENE_COMPONENTS = 64;
+
+/// Index of a component type registered with a scene.
+typedef unsigned ComponentId;
+/// Set of component types, bit i standing for component i.
+typedef uint64_t ComponentMask;
+
+/// Entity handle. The index is a slot kept for the entity's lifetime and reused after it is destroyed, which
+/// makes it suitable for indexing per-object arrays, and the generation tells reuses apart.
+struct Entity
+{
+    /// Test for equality.
+    bool operator ==(Entity const& rhs) const { return index_ == rhs.index_ && generation_ == rhs.generation_; }
+    /// Test for inequality.
+    bool operator !=(Entity const& rhs) const { return !(*this == rhs); }
+
+    /// Slot index
+    unsigned index_{};
+    /// Generation of the slot, zero for no entity
+    unsigned generation_{};
+};
+
+/// Fixed size block holding entities of one archetype: their handles followed by one contiguous array per
+/// component, each element i belonging to entity i. Every chunk of an archetype but the last is full.
+class SceneChunk
+{
+    friend class Scene;
+
+public:
+    /// Return number of entities.
+    unsigned GetCount() const { return count_; }
+    /// Return entity handles.
+    Entity const* GetEntities() const { return (Entity const*) data_; }
+    /// Return array of a component, null if the archetype does not have it.
+    void* GetComponents(ComponentId id) const;
+    /// Return array of a component as its type, null if the archetype does not have it.
+    template <class T> T* GetComponents(ComponentId id) const { return (T*) GetComponents(id); }
+    /// Return the version a component array was last written in.
+    uint32_t GetVersion(ComponentId id) const { return versions_[id]; }
+    /// Return whether a component array was written after a version.
+    bool HasChanged(ComponentId id, uint32_t version) const { return versions_[id] > version; }
+
+private:
+    /// Archetype
+    SceneArchetype* archetype_{};
+    /// Storage, over-allocated for alignment
+    std::unique_ptr<uint8_t[]> storage_;
+    /// Start of the entities, cache line aligned within the storage
+    uint8_t* data_{};
+    /// Version each component array was last written in
+    uint32_t versions_[MAX_SCENE_COMPONENTS]{};
+    /// Entities
+    unsigned count_{};
+};
+
+/// Chunk selection of a query.
+struct SceneQuery
+{
+    /// Components a chunk must have
+    ComponentMask all_{};
+    /// Components a chunk must not have
+    ComponentMask none_{};
+    /// Components the query writes, stamped with the current version in every chunk it visits
+    ComponentMask write_{};
+    /// Components of which one must have been written after changedSince_ for a chunk to be visited, zero
+    /// to visit every matching chunk
+    ComponentMask changed_{};
+    /// Version of the change filter
+    uint32_t changedSince_{};
+};
+
+/// Statistics of a scene.
+struct SceneStats
+{
+    /// Live entities
+    unsigned entities_{};
+    /// Archetypes
+    unsigned archetypes_{};
+    /// Chunks
+    unsigned chunks_{};
+};
+
+/// Entities grouped by archetype, the set of component types they have. Each archetype stores its entities
+/// in fixed size chunks with one contiguous array per component, so systems stream through exactly the
+/// components they use. Queries visit only the chunks of matching archetypes, and can run their chunks as
+/// jobs. Destroying an entity or changing its components moves the last entity of the archetype into its
+/// place, keeping chunks dense, and never changes entity indices.
+///
+/// Every chunk keeps the version each of its component arrays was last written in. Writes through a query
+/// or WriteComponent stamp the current version, as do structural changes, and a query can skip chunks
+/// whose components did not change after a version. A consumer remembers the version AdvanceVersion
+/// returned after it last ran and asks for changes after it, so work that depends on a component is only
+/// redone for the chunks where it changed.
+class Scene
+{
+public:
+    /// Bytes per chunk
+    static constexpr unsigned ChunkSize{16 * 1024};
+    /// Function run on a chunk
+    typedef std::function<void(SceneChunk& chunk)> ChunkFunction;
+
+    /// Construct.
+    explicit Scene();
+    /// Destruct.
+    ~Scene();
+
+    Scene(Scene const&) = delete;
+    Scene& operator =(Scene const&) = delete;
+
+    /// Return the mask of a component.
+    static ComponentMask GetMask(ComponentId id) { return 1ull << id; }
+
+    /// Register a component type of trivially copyable data, zero for a new entity. Return its id.
+    ComponentId RegisterComponent(std::string const& name, unsigned size, unsigned alignment);
+    /// Register a component type. Return its id.
+    template <class T> ComponentId RegisterComponent(std::string const& name)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Components are moved between chunks by copying bytes");
+        return RegisterComponent(name, sizeof(T), alignof(T));
+    }
+    /// Return number of component types.
+    unsigned GetComponentCount() const { return (unsigned) componentTypes_.size(); }
+    /// Return name of a component type.
+    std::string const& GetComponentName(ComponentId id) const { return componentTypes_[id].name_; }
+
+    /// Set job system to run parallel queries on, null to run them on the calling thread.
+    void SetJobSystem(JobSystem* jobSystem) { jobSystem_ = jobSystem; }
+    /// Return job system, null if queries run inline.
+    JobSystem* GetJobSystem() const { return jobSystem_; }
+
+    /// Create an entity with components.
+    Entity CreateEntity(ComponentMask components);
+    /// Create entities with components, filling whole chunks at a time. Append their handles if entities is not null.
+    void CreateEntities(ComponentMask components, unsigned count, std::vector<Entity>* entities = nullptr);
+    /// Destroy an entity. Return false if it is not alive.
+    bool DestroyEntity(Entity entity);
+    /// Return whether an entity is alive.
+    bool IsAlive(Entity entity) const
+    {
+        return entity.index_ < records_.size() && records_[entity.index_].generation_ == entity.generation_ && records_[entity.index_].chunk_;
+    }
+    /// Add components to an entity, zero initialized. Return false if it is not alive.
+    bool AddComponents(Entity entity, ComponentMask components);
+    /// Remove components from an entity. Return false if it is not alive.
+    bool RemoveComponents(Entity entity, ComponentMask components);
+    /// Return components of an entity, zero if it is not alive.
+    ComponentMask GetComponents(Entity entity) const;
+    /// Return a component of an entity to read, null if the entity is not alive or lacks it.
+    void const* GetComponent(Entity entity, ComponentId id) const;
+    /// Return a component of an entity to write, null if the entity is not alive or lacks it. Stamps the
+    /// component array of its chunk with the current version.
+    void* WriteComponent(Entity entity, ComponentId id);
+    /// Return a component of an entity to read as its type.
+    template <class T> T const* GetComponent(Entity entity, ComponentId id) const { return (T const*) GetComponent(entity, id); }
+    /// Return a component of an entity to write as its type.
+    template <class T> T* WriteComponent(Entity entity, ComponentId id) { return (T*) WriteComponent(entity, id); }
+
+    /// Return number of live entities.
+    unsigned GetEntityCount() const { return entityCount_; }
+    /// Return one past the largest entity index ever used, the size of arrays indexed by entity.
+    unsigned GetEntitySlotCount() const { return (unsigned) records_.size(); }
+    /// Return indices of the entities destroyed since the last clear, for consumers mirroring entities by index.
+    std::vector<unsigned> const& GetDestroyedEntities() const { return destroyed_; }
+    /// Forget the destroyed entities.
+    void ClearDestroyedEntities() { destroyed_.clear(); }
+
+    /// Return the version writes are stamped with.
+    uint32_t GetVersion() const { return version_; }
+    /// Start a new version and return the previous one, which consumers pass as changedSince_ next time.
+    uint32_t AdvanceVersion() { return version_++; }
+
+    /// Fill the chunks a query visits, stamping the versions of the components it writes.
+    void GetChunks(SceneQuery const& query, std::vector<SceneChunk*>& chunks);
+    /// Run a function on the chunks a query visits, in order.
+    void ForEachChunk(SceneQuery const& query, ChunkFunction const& function);
+    /// Run a function on the chunks a query visits as jobs. The function may only write the components
+    /// of its own chunk.
+    void ParallelForEachChunk(SceneQuery const& query, ChunkFunction const& function);
+    /// Return number of entities a query visits, without stamping versions.
+    unsigned GetEntityCount(SceneQuery const& query) const;
+    /// Return statistics.
+    SceneStats GetStats() const;
+
+private:
+    /// Component type
+    struct ComponentType
+    {
+        /// Name
+        std::string name_;
+        /// Size in bytes
+        unsigned size_;
+        /// Alignment in bytes
+        unsigned alignment_;
+    };
+
+    /// Location of an entity
+    struct EntityRecord
+    {
+        /// Chunk, null when the slot is free
+        SceneChunk* chunk_;
+        /// Position in the chunk
+        unsigned row_;
+        /// Generation, incremented when destroyed
+        unsigned generation_;
+    };
+
+    /// Return the archetype of a set of components, creating it if needed.
+    SceneArchetype& GetArchetype(ComponentMask components);
+    /// Return a chunk of an archetype with room for another entity.
+    SceneChunk& GetFreeChunk(SceneArchetype& archetype);
+    /// Append a zeroed entity to an archetype. Return its chunk and set its row.
+    SceneChunk& AppendEntity(SceneArchetype& archetype, Entity entity, unsigned& row);
+    /// Move the last entity of an archetype into a row, or drop it if it is that row, releasing emptied chunks.
+    void RemoveRow(SceneChunk& chunk, unsigned row);
+    /// Return a free entity slot.
+    Entity AllocateEntity();
+    /// Return whether a chunk matches the change filter of a query.
+    static bool IsChanged(SceneChunk const& chunk, SceneQuery const& query);
+
+    /// Component types
+    std::vector<ComponentType> componentTypes_;
+    /// Archetypes
+    std::vector<std::unique_ptr<SceneArchetype>> archetypes_;
+    /// Archetype index by components
+    std::unordered_map<ComponentMask, unsigned> archetypeIndices_;
+    /// Entity locations by index
+    std::vector<EntityRecord> records_;
+    /// Free entity indices
+    std::vector<unsigned> freeIndices_;
+    /// Entities destroyed since the last clear
+    std::vector<unsigned> destroyed_;
+    /// Job system, null to run queries inline
+    JobSystem* jobSystem_{};
+    /// Live entities
+    unsigned entityCount_{};
+    /// Current version, starting above the zero of never written
+    uint32_t version_{1};
+};
+
+/// Entities of one set of components.
+struct SceneArchetype
+{
+    /// Components
+    ComponentMask mask_{};
+    /// Component ids in increasing order
+    std::vector<ComponentId> components_;
+    /// Byte offset of each component array in a chunk, by component id
+    unsigned offsets_[MAX_SCENE_COMPONENTS]{};
+    /// Entities per chunk
+    unsigned capacity_{};
+    /// Chunks, all full but the last
+    std::vector<std::unique_ptr<SceneChunk>> chunks_;
+};
+
+inline void* SceneChunk::GetComponents(ComponentId id) const
+{
+    return (archetype_->mask_ & Scene::GetMask(id)) ? data_ + archetype_->offsets_[id] : nullptr;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "Scene.h"
+
+
+class FrustumCuller;
+
+/// Local transform.
+struct TransformComponent
+{
+    /// Position
+    Vector3 position_;
+    /// Rotation
+    Quaternion rotation_;
+    /// Scale
+    Vector3 scale_{1.0f, 1.0f, 1.0f};
+};
+
+/// Linear and angular velocity.
+struct MotionComponent
+{
+    /// Velocity in units per second
+    Vector3 velocity_;
+    /// Rotation axis scaled by radians per second
+    Vector3 angularVelocity_;
+};
+
+/// World transform computed from the transform.
+struct WorldTransformComponent
+{
+    /// World transform
+    Matrix4 world_;
+};
+
+/// Drawn object, indexed by entity in the culler and the object buffer.
+struct RenderableComponent
+{
+    /// Local space bounds
+    BoundingBox bounds_;
+};
+
+/// Component ids of the scene systems.
+struct SceneComponents
+{
+    /// Register the components with a scene.
+    explicit SceneComponents(Scene& scene);
+
+    /// Transform
+    ComponentId transform_;
+    /// Motion
+    ComponentId motion_;
+    /// World transform
+    ComponentId worldTransform_;
+    /// Renderable
+    ComponentId renderable_;
+};
+
+/// World transforms and bounds of renderables that changed, in entity order within their chunks.
+struct RenderableChanges
+{
+    /// Entity indices
+    std::vector<unsigned> objects_;
+    /// World transforms
+    std::vector<Matrix4> transforms_;
+};
+
+/// Integrate the motion of entities into their transforms, chunks in parallel.
+void UpdateMotion(Scene& scene, SceneComponents const& components, float timeStep);
+/// Compute world transforms of entities whose transforms changed since lastVersion, chunks in parallel,
+/// and advance lastVersion.
+void UpdateWorldTransforms(Scene& scene, SceneComponents const& components, uint32_t& lastVersion);
+/// Bring a culler up to date with the renderables whose world transforms changed since lastVersion, hide
+/// the entities destroyed since then and advance lastVersion. Fill the changed world transforms by entity for
+/// the object buffer.
+void SyncRenderables(Scene& scene, SceneComponents const& components, uint32_t& lastVersion, FrustumCuller& culler,
+    RenderableChanges& changes);
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ContentHash.h"
+
+class JobSystem;
+
+/// Preprocessor define of a shader permutation.
+struct ShaderDefine
+{
+    /// Name
+    std::string name_;
+    /// Value
+    std::string value_;
+};
+
+/// Shader permutation to compile.
+struct ShaderCompileDesc
+{
+    /// Source file
+    std::string fileName_;
+    /// Entry point
+    std::string entryPoint_;
+    /// Target profile, for example vs_5_1
+    std::string profile_;
+    /// Defines, their order does not matter
+    std::vector<ShaderDefine> defines_;
+};
+
+/// Result of compiling a shader permutation.
+struct ShaderCompileResult
+{
+    /// Bytecode
+    std::vector<uint8_t> bytecode_;
+    /// Compiler or preprocessor messages
+    std::string messages_;
+    /// Source file followed by every file it includes
+    std::vector<std::string> dependencies_;
+    /// Hash of source, includes, defines, entry point, profile and compiler version
+    ContentHash hash_;
+    /// Success flag
+    bool success_{};
+    /// Taken from the cache instead of compiled flag
+    bool cached_{};
+};
+
+/// Compiles preprocessed HLSL. Implemented on D3DCompile and by a stub without a compiler. Compile is
+/// called from job threads and must be thread-safe.
+class ShaderCompilerBackend
+{
+public:
+    /// Destruct.
+    virtual ~ShaderCompilerBackend() = default;
+
+    /// Return version of the compiler and its flags. Bytecode of another version is not reused.
+    virtual uint64_t GetVersion() const = 0;
+    /// Compile source with all includes expanded. Return false on failure with the reason in messages.
+    virtual bool Compile(std::string const& source, ShaderCompileDesc const& desc, std::vector<uint8_t>& bytecode, std::string& messages) = 0;
+};
+
+/// Shader compiler statistics.
+struct ShaderCompilerStats
+{
+    /// Permutations requested
+    unsigned requests_{};
+    /// Permutations compiled
+    unsigned compiled_{};
+    /// Permutations found in the in-memory cache
+    unsigned memoryHits_{};
+    /// Permutations found in the on-disk cache
+    unsigned diskHits_{};
+    /// Permutations that failed to preprocess or compile
+    unsigned failed_{};
+};
+
+/// Shader build service. Expands includes itself so the hash covers every input: the contents of the source
+/// and all included files, the sorted defines, the entry point, the profile and the compiler version.
+/// Bytecode is stored in a content-addressed cache directory under that hash, so unchanged permutations are
+/// read back instead of recompiled, and permutations are compiled in parallel on a job system.
+class ShaderCompiler
+{
+public:
+    /// Construct with a compiler backend and a cache directory, empty for no on-disk cache.
+    ShaderCompiler(ShaderCompilerBackend& backend, std::string const& cacheDirectory);
+
+    /// Add a directory searched for includes not found next to the including file.
+    void AddIncludeDirectory(std::string const& directory);
+    /// Forget file contents read so far, so changed files are read again.
+    void ClearFileCache();
+
+    /// Compile one permutation or take it from the cache. Return success.
+    bool Compile(ShaderCompileDesc const& desc, ShaderCompileResult& result);
+    /// Compile permutations in parallel, or serially without a job system. Return number of failures.
+    unsigned CompileAll(std::vector<ShaderCompileDesc> const& descs, std::vector<ShaderCompileResult>& results, JobSystem* jobSystem = nullptr);
+
+    /// Read the permutations of an offline build manifest. Each line is a source file, entry point, profile and
+    /// optional NAME=VALUE defines separated by whitespace, # starts a comment. Return false if it cannot be read
+    /// or a line is incomplete.
+    static bool ReadManifest(std::string const& manifestFileName, std::vector<ShaderCompileDesc>& descs, std::string& messages);
+
+    /// Expand includes of a permutation's source. Return false if a file cannot be read.
+    bool Preprocess(ShaderCompileDesc const& desc, std::string& source, std::vector<std::string>& dependencies, std::string& messages);
+    /// Return hash of preprocessed source and the rest of the permutation.
+    ContentHash HashPermutation(std::string const& source, ShaderCompileDesc const& desc) const;
+    /// Return path of the cache file of a hash.
+    std::string GetCacheFileName(ContentHash const& hash) const;
+
+    /// Return statistics.
+    ShaderCompilerStats GetStats() const;
+
+private:
+    /// Read a file through the file cache. Return false if it cannot be read.
+    bool ReadSource(std::string const& fileName, std::string& contents);
+    /// Append a file with its includes expanded. Return false if a file cannot be read.
+    bool ExpandIncludes(std::string const& fileName, std::string& source, std::vector<std::string>& dependencies,
+        std::unordered_set<std::string>& onceFiles, std::string& messages, unsigned depth);
+    /// Find an included file next to the including file or in the include directories. Return empty if not found.
+    std::string ResolveInclude(std::string const& name, std::string const& includingFile);
+    /// Read bytecode from the on-disk cache. Return false if missing or corrupt.
+    bool ReadCache(ContentHash const& hash, std::vector<uint8_t>& bytecode) const;
+    /// Write bytecode to the on-disk cache.
+    void WriteCache(ContentHash const& hash, std::vector<uint8_t> const& bytecode) const;
+
+    /// Compiler backend
+    ShaderCompilerBackend& backend_;
+    /// Cache directory, empty for none
+    std::string cacheDirectory_;
+    /// Include directories
+    std::vector<std::string> includeDirectories_;
+    /// Lock for the file cache, bytecode, permutations in progress and statistics
+    mutable std::mutex mutex_;
+    /// Signals a permutation in progress has finished
+    std::condition_variable compiledCondition_;
+    /// Readable flag and contents by path
+    std::unordered_map<std::string, std::pair<bool, std::string>> files_;
+    /// Bytecode by hash
+    std::unordered_map<ContentHash, std::vector<uint8_t>, ContentHashHasher> bytecode_;
+    /// Hashes being compiled, so identical permutations are compiled once
+    std::unordered_set<ContentHash, ContentHashHasher> inProgress_;
+    /// Statistics
+    ShaderCompilerStats stats_;
+};
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cmath>
+
+// The backend is selected at compile time from the instruction sets the compiler targets. AVX2 (/arch:AVX2,
+// -mavx2) runs batch kernels 8 lanes wide and single vectors on SSE4.1, SSE4.1 (/arch:AVX, -msse4.1) runs
+// both 4 lanes wide and anything else falls back to scalar code. Define MATH_SCALAR to force the fallback.
+#if !defined(MATH_SCALAR) && defined(__AVX2__)
+#define MATH_AVX2
+#define MATH_SSE4
+#elif !defined(MATH_SCALAR) && (defined(__SSE4_1__) || defined(__AVX__))
+#define MATH_SSE4
+#endif
+
+#if defined(MATH_AVX2) && (defined(__FMA__) || defined(_MSC_VER))
+#define MATH_FMA
+#endif
+
+#if defined(MATH_AVX2)
+#include <immintrin.h>
+#elif defined(MATH_SSE4)
+#include <smmintrin.h>
+#endif
+
+
+/// Four floats in a SIMD register, or in an array for the scalar fallback.
+struct Float4
+{
+    /// Number of lanes
+    static constexpr unsigned Width{4};
+
+    /// Load from unaligned memory.
+    static Float4 Load(float const* src);
+    /// Load one float into all lanes.
+    static Float4 Splat(float x);
+    /// Load from base at the float indices of each lane.
+    static Float4 Gather(float const* base, int const* indices);
+    /// Construct from lanes.
+    static Float4 Set(float x, float y, float z, float w);
+
+#ifdef MATH_SSE4
+    __m128 v_;
+#else
+    float v_[4];
+#endif
+};
+
+/// One float, the lane type of the scalar fallback and of the remainder of batch loops.
+struct Float1
+{
+    /// Number of lanes
+    static constexpr unsigned Width{1};
+
+    /// Load from memory.
+    static Float1 Load(float const* src) { return { *src }; }
+    /// Load a float.
+    static Float1 Splat(float x) { return { x }; }
+    /// Load from base at a float index.
+    static Float1 Gather(float const* base, int const* indices) { return { base[*indices] }; }
+
+    float v_;
+};
+
+inline void Store(float* dest, Float1 a) { *dest = a.v_; }
+inline Float1 operator +(Float1 a, Float1 b) { return { a.v_ + b.v_ }; }
+inline Float1 operator -(Float1 a, Float1 b) { return { a.v_ - b.v_ }; }
+inline Float1 operator *(Float1 a, Float1 b) { return { a.v_ * b.v_ }; }
+inline Float1 operator /(Float1 a, Float1 b) { return { a.v_ / b.v_ }; }
+inline Float1 MulAdd(Float1 a, Float1 b, Float1 c) { return { a.v_ * b.v_ + c.v_ }; }
+inline Float1 Min(Float1 a, Float1 b) { return { a.v_ < b.v_ ? a.v_ : b.v_ }; }
+inline Float1 Max(Float1 a, Float1 b) { return { a.v_ > b.v_ ? a.v_ : b.v_ }; }
+inline Float1 Abs(Float1 a) { return { std::fabs(a.v_) }; }
+inline Float1 Sqrt(Float1 a) { return { std::sqrt(a.v_) }; }
+inline unsigned GreaterMask(Float1 a, Float1 b) { return a.v_ > b.v_ ? 1u : 0u; }
+inline Float1 SelectNegative(Float1 a, Float1 b, Float1 sign) { return std::signbit(sign.v_) ? b : a; }
+
+#ifdef MATH_SSE4
+
+inline Float4 Float4::Load(float const* src) { return { _mm_loadu_ps(src) }; }
+inline Float4 Float4::Splat(float x) { return { _mm_set1_ps(x) }; }
+inline Float4 Float4::Gather(float const* base, int const* indices)
+{
+    return { _mm_setr_ps(base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]]) };
+}
+inline Float4 Float4::Set(float x, float y, float z, float w) { return { _mm_setr_ps(x, y, z, w) }; }
+
+inline void Store(float* dest, Float4 a) { _mm_storeu_ps(dest, a.v_); }
+inline Float4 operator +(Float4 a, Float4 b) { return { _mm_add_ps(a.v_, b.v_) }; }
+inline Float4 operator -(Float4 a, Float4 b) { return { _mm_sub_ps(a.v_, b.v_) }; }
+inline Float4 operator *(Float4 a, Float4 b) { return { _mm_mul_ps(a.v_, b.v_) }; }
+inline Float4 operator /(Float4 a, Float4 b) { return { _mm_div_ps(a.v_, b.v_) }; }
+#ifdef MATH_FMA
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return { _mm_fmadd_ps(a.v_, b.v_, c.v_) }; }
+#else
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return { _mm_add_ps(_mm_mul_ps(a.v_, b.v_), c.v_) }; }
+#endif
+inline Float4 Min(Float4 a, Float4 b) { return { _mm_min_ps(a.v_, b.v_) }; }
+inline Float4 Max(Float4 a, Float4 b) { return { _mm_max_ps(a.v_, b.v_) }; }
+inline Float4 Abs(Float4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v_) }; }
+inline Float4 Sqrt(Float4 a) { return { _mm_sqrt_ps(a.v_) }; }
+inline unsigned GreaterMask(Float4 a, Float4 b) { return (unsigned) _mm_movemask_ps(_mm_cmpgt_ps(a.v_, b.v_)); }
+inline Float4 SelectNegative(Float4 a, Float4 b, Float4 sign) { return { _mm_blendv_ps(a.v_, b.v_, sign.v_) }; }
+inline Float4 SplatX(Float4 a) { return { _mm_shuffle_ps(a.v_, a.v_, _MM_SHUFFLE(0, 0, 0, 0)) }; }
+inline Float4 SplatY(Float4 a) { return { _mm_shuffle_ps(a.v_, a.v_, _MM_SHUFFLE(1, 1, 1, 1)) }; }
+inline Float4 SplatZ(Float4 a) { return { _mm_shuffle_ps(a.v_, a.v_, _MM_SHUFFLE(2, 2, 2, 2)) }; }
+inline Float4 SplatW(Float4 a) { return { _mm_shuffle_ps(a.v_, a.v_, _MM_SHUFFLE(3, 3, 3, 3)) }; }
+inline float GetX(Float4 a) { return _mm_cvtss_f32(a.v_); }
+inline float Dot3(Float4 a, Float4 b) { return _mm_cvtss_f32(_mm_dp_ps(a.v_, b.v_, 0x71)); }
+inline float Dot4(Float4 a, Float4 b) { return _mm_cvtss_f32(_mm_dp_ps(a.v_, b.v_, 0xf1)); }
+
+#else
+
+inline Float4 Float4::Load(float const* src) { return { { src[0], src[1], src[2], src[3] } }; }
+inline Float4 Float4::Splat(float x) { return { { x, x, x, x } }; }
+inline Float4 Float4::Gather(float const* base, int const* indices)
+{
+    return { { base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]] } };
+}
+inline Float4 Float4::Set(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+
+inline void Store(float* dest, Float4 a) { for (unsigned i = 0; i < 4; ++i) dest[i] = a.v_[i]; }
+inline Float4 operator +(Float4 a, Float4 b) { return { { a.v_[0] + b.v_[0], a.v_[1] + b.v_[1], a.v_[2] + b.v_[2], a.v_[3] + b.v_[3] } }; }
+inline Float4 operator -(Float4 a, Float4 b) { return { { a.v_[0] - b.v_[0], a.v_[1] - b.v_[1], a.v_[2] - b.v_[2], a.v_[3] - b.v_[3] } }; }
+inline Float4 operator *(Float4 a, Float4 b) { return { { a.v_[0] * b.v_[0], a.v_[1] * b.v_[1], a.v_[2] * b.v_[2], a.v_[3] * b.v_[3] } }; }
+inline Float4 operator /(Float4 a, Float4 b) { return { { a.v_[0] / b.v_[0], a.v_[1] / b.v_[1], a.v_[2] / b.v_[2], a.v_[3] / b.v_[3] } }; }
+inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return a * b + c; }
+inline Float4 Min(Float4 a, Float4 b)
+{
+    Float4 r;
+    for (unsigned i = 0; i < 4; ++i)
+        r.v_[i] = a.v_[i] < b.v_[i] ? a.v_[i] : b.v_[i];
+    return r;
+}
+inline Float4 Max(Float4 a, Float4 b)
+{
+    Float4 r;
+    for (unsigned i = 0; i < 4; ++i)
+        r.v_[i] = a.v_[i] > b.v_[i] ? a.v_[i] : b.v_[i];
+    return r;
+}
+inline Float4 Abs(Float4 a) { return { { std::fabs(a.v_[0]), std::fabs(a.v_[1]), std::fabs(a.v_[2]), std::fabs(a.v_[3]) } }; }
+inline Float4 Sqrt(Float4 a) { return { { std::sqrt(a.v_[0]), std::sqrt(a.v_[1]), std::sqrt(a.v_[2]), std::sqrt(a.v_[3]) } }; }
+inline unsigned GreaterMask(Float4 a, Float4 b)
+{
+    unsigned mask = 0;
+    for (unsigned i = 0; i < 4; ++i)
+        mask |= a.v_[i] > b.v_[i] ? 1u << i : 0u;
+    return mask;
+}
+inline Float4 SelectNegative(Float4 a, Float4 b, Float4 sign)
+{
+    Float4 r;
+    for (unsigned i = 0; i < 4; ++i)
+        r.v_[i] = std::signbit(sign.v_[i]) ? b.v_[i] : a.v_[i];
+    return r;
+}
+inline Float4 SplatX(Float4 a) { return Float4::Splat(a.v_[0]); }
+inline Float4 SplatY(Float4 a) { return Float4::Splat(a.v_[1]); }
+inline Float4 SplatZ(Float4 a) { return Float4::Splat(a.v_[2]); }
+inline Float4 SplatW(Float4 a) { return Float4::Splat(a.v_[3]); }
+inline float GetX(Float4 a) { return a.v_[0]; }
+inline float Dot3(Float4 a, Float4 b) { return a.v_[0] * b.v_[0] + a.v_[1] * b.v_[1] + a.v_[2] * b.v_[2]; }
+inline float Dot4(Float4 a, Float4 b) { return a.v_[0] * b.v_[0] + a.v_[1] * b.v_[1] + a.v_[2] * b.v_[2] + a.v_[3] * b.v_[3]; }
+
+#endif
+
+#ifdef MATH_AVX2
+
+/// Eight floats in an AVX register.
+struct Float8
+{
+    /// Number of lanes
+    static constexpr unsigned Width{8};
+
+    /// Load from unaligned memory.
+    static Float8 Load(float const* src) { return { _mm256_loadu_ps(src) }; }
+    /// Load one float into all lanes.
+    static Float8 Splat(float x) { return { _mm256_set1_ps(x) }; }
+    /// Load from base at the float indices of each lane.
+    static Float8 Gather(float const* base, int const* indices)
+    {
+        return { _mm256_i32gather_ps(base, _mm256_loadu_si256((__m256i const*) indices), 4) };
+    }
+
+    __m256 v_;
+};
+
+inline void Store(float* dest, Float8 a) { _mm256_storeu_ps(dest, a.v_); }
+inline Float8 operator +(Float8 a, Float8 b) { return { _mm256_add_ps(a.v_, b.v_) }; }
+inline Float8 operator -(Float8 a, Float8 b) { return { _mm256_sub_ps(a.v_, b.v_) }; }
+inline Float8 operator *(Float8 a, Float8 b) { return { _mm256_mul_ps(a.v_, b.v_) }; }
+inline Float8 operator /(Float8 a, Float8 b) { return { _mm256_div_ps(a.v_, b.v_) }; }
+#ifdef MATH_FMA
+inline Float8 MulAdd(Float8 a, Float8 b, Float8 c) { return { _mm256_fmadd_ps(a.v_, b.v_, c.v_) }; }
+#else
+inline Float8 MulAdd(Float8 a, Float8 b, Float8 c) { return { _mm256_add_ps(_mm256_mul_ps(a.v_, b.v_), c.v_) }; }
+#endif
+inline Float8 Min(Float8 a, Float8 b) { return { _mm256_min_ps(a.v_, b.v_) }; }
+inline Float8 Max(Float8 a, Float8 b) { return { _mm256_max_ps(a.v_, b.v_) }; }
+inline Float8 Abs(Float8 a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v_) }; }
+inline Float8 Sqrt(Float8 a) { return { _mm256_sqrt_ps(a.v_) }; }
+inline unsigned GreaterMask(Float8 a, Float8 b) { return (unsigned) _mm256_movemask_ps(_mm256_cmp_ps(a.v_, b.v_, _CMP_GT_OQ)); }
+inline Float8 SelectNegative(Float8 a, Float8 b, Float8 sign) { return { _mm256_blendv_ps(a.v_, b.v_, sign.v_) }; }
+
+/// Lane type of batch kernels
+typedef Float8 FloatN;
+
+#elif defined(MATH_SSE4)
+
+/// Lane type of batch kernels
+typedef Float4 FloatN;
+
+#else
+
+/// Lane type of batch kernels
+typedef Float1 FloatN;
+
+#endif
+
+/// Run a kernel over [first, first + count), FloatN lanes at a time and the remainder one at a time. The
+/// kernel is called with the index and a value of the lane type to instantiate it with, a generic lambda
+/// taking (unsigned i, auto lane) is written once for both.
+template <class Kernel> inline void ForEachLanes(unsigned first, unsigned count, Kernel const& kernel)
+{
+    unsigned end = first + count;
+    unsigned i = first;
+    for (; i + FloatN::Width <= end; i += FloatN::Width)
+        kernel(i, FloatN());
+    for (; i < end; ++i)
+        kernel(i, Float1());
+}
+
+/// Return name of the compiled backend.
+inline char const* GetMathBackendName()
+{
+#if defined(MATH_AVX2)
+    return "AVX2";
+#elif defined(MATH_SSE4)
+    return "SSE4.1";
+#else
+    return "Scalar";
+#endif
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "GpuQueue.h"
+
+
+/// Software GPU queue. Executes simulated work in submission order and advances its fence, either on
+/// a worker thread that sleeps for the work duration or manually so pacing logic can be stepped deterministically.
+/// Also keeps a simulated timeline on which work takes its duration and a wait ends when the awaited signal
+/// was reached, so the overlap of several queues can be measured without depending on the host's cores.
+class SimulatedQueue : public GpuQueue
+{
+public:
+    /// Signal times kept for GetSignalTime
+    static constexpr unsigned SignalTimeHistory{1024};
+
+    /// Construct. A threaded queue executes work in the background, a manual one only in ProcessCommands or when waited on.
+    explicit SimulatedQueue(bool threaded = true);
+    /// Construct a second fence on another queue. Work and waits go to that queue in order with its own,
+    /// signals reach this fence.
+    explicit SimulatedQueue(SimulatedQueue& queue);
+    /// Destruct.
+    ~SimulatedQueue() override;
+
+    /// Submit simulated GPU work taking the given duration.
+    void Execute(std::chrono::microseconds gpuTime);
+    /// Submit simulated GPU work taking the command list time per list.
+    void ExecuteCommandLists(CommandList* const* commandLists, unsigned count) override;
+    /// Enqueue a wait for another simulated queue's fence.
+    void Wait(GpuQueue& queue, uint64_t value) override;
+    /// Enqueue a fence signal.
+    void Signal(uint64_t value) override;
+    /// Return the last value reached by the queue.
+    uint64_t GetCompletedValue() const override;
+    /// Set event once the queue has reached value. A manual queue executes commands up to value first.
+    void SetEventOnCompletion(uint64_t value, WaitEvent& event) override;
+
+    /// Set simulated GPU time of each command list.
+    void SetCommandListTime(std::chrono::microseconds time) { commandListTime_ = time; }
+    /// Execute up to count pending commands on the calling thread. Manual queue only. Stops at a wait for a
+    /// value that can not be reached yet. Return number executed.
+    unsigned ProcessCommands(unsigned count = ~0u);
+    /// Return number of commands not executed yet.
+    unsigned GetPendingCommandCount() const;
+    /// Return total simulated GPU busy time.
+    std::chrono::microseconds GetBusyTime() const { return std::chrono::microseconds(root_->busyTime_.load()); }
+    /// Return the end of the last executed command on the simulated timeline.
+    std::chrono::microseconds GetTimelineTime() const { return std::chrono::microseconds(root_->timelineTime_.load()); }
+    /// Return the simulated timeline time the fence reached value at, zero if it has not or the value is too old.
+    std::chrono::microseconds GetSignalTime(uint64_t value) const;
+
+private:
+    /// Simulated queue command
+    struct Command
+    {
+        /// Work duration, zero for a fence signal or wait
+        std::chrono::microseconds gpuTime_;
+        /// Fence value to reach, zero for work
+        uint64_t signalValue_;
+        /// Fence to signal
+        SimulatedQueue* signalFence_;
+        /// Fence to wait for, null for none
+        SimulatedQueue* waitFence_;
+        /// Fence value to wait for
+        uint64_t waitValue_;
+    };
+
+    /// Event waiting for a fence value
+    struct Waiter
+    {
+        /// Fence value
+        uint64_t value_;
+        /// Event to set
+        WaitEvent* event_;
+    };
+
+    /// Append a command and wake the worker.
+    void Push(Command const& command);
+    /// Execute one command.
+    void RunCommand(Command const& command);
+    /// Advance the fence and release its waiters.
+    void CompleteSignal(uint64_t value, int64_t time);
+    /// Run the queue the fence is on until it reaches value. Manual queue only. Return whether reached.
+    bool DriveTo(uint64_t value);
+    /// Worker thread entry.
+    void ThreadFunction();
+
+    /// Queue executing the commands, this one unless a second fence
+    SimulatedQueue* root_;
+    /// Worker thread, not running for a manual queue
+    std::thread thread_;
+    /// Lock for pending commands, waiters and signal times
+    mutable std::mutex mutex_;
+    /// Wakes the worker when commands are pending
+    std::condition_variable commandCondition_;
+    /// Pending commands
+    std::deque<Command> commands_;
+    /// Events waiting for the fence
+    std::vector<Waiter> waiters_;
+    /// Recent fence values with the timeline time they were reached at
+    std::deque<std::pair<uint64_t, int64_t>> signalTimes_;
+    /// Last reached fence value
+    std::atomic<uint64_t> completedValue_{};
+    /// Total busy time in microseconds
+    std::atomic<int64_t> busyTime_{};
+    /// Simulated timeline time in microseconds
+    std::atomic<int64_t> timelineTime_{};
+    /// Simulated time per command list
+    std::chrono::microseconds commandListTime_{};
+    /// Threaded flag
+    bool threaded_;
+    /// Worker exit flag
+    bool exiting_{};
+};
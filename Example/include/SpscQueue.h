@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+
+/// Bounded lock-free queue for one producer and one consumer thread. Each side owns one index and only
+/// reads the other's, so push and pop are a load and a store each without locks or compare-exchange.
+template <class T> class SpscQueue
+{
+public:
+    /// Construct with a power of two capacity.
+    explicit SpscQueue(size_t capacity)
+        : items_(capacity)
+        , mask_(capacity - 1)
+    {
+        assert(capacity && (capacity & (capacity - 1)) == 0);
+    }
+
+    /// Append an item. Producer only. Return false if full.
+    bool Push(T const& item)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_)
+            return false;
+
+        items_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Remove the oldest item. Consumer only. Return false if empty.
+    bool Pop(T& item)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+
+        item = items_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Return number of items. Exact only on a thread that is the sole user.
+    size_t GetSize() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+    /// Return capacity.
+    size_t GetCapacity() const { return mask_ + 1; }
+
+private:
+    /// Items, a ring
+    std::vector<T> items_;
+    /// Index mask
+    size_t mask_;
+    /// Next item to pop, written by the consumer
+    std::atomic<size_t> head_{0};
+    /// Padding so the indices do not share a cache line
+    char padding_[64];
+    /// Next item to push, written by the producer
+    std::atomic<size_t> tail_{0};
+};
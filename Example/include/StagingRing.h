@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "UploadRing.h"
+
+
+/// Fixed size ring of upload memory for transfers that finish out of order, like texture mips decoded on
+/// job threads. Each allocation is retired with the fence value of the copy that reads it once that copy
+/// is submitted; space is reclaimed from the oldest allocation on as soon as it and the ones before it
+/// have completed. The ring never grows, a full ring fails allocations until space is reclaimed.
+class StagingRing
+{
+public:
+    /// Construct.
+    explicit StagingRing();
+    /// Destruct.
+    ~StagingRing();
+
+    /// Create the buffer. Return false on failure.
+    bool Initialize(UploadBufferFactory& factory, uint64_t size);
+    /// Destroy the buffer. Only safe once the GPU is idle.
+    void Shutdown();
+    /// Return whether initialized.
+    bool IsInitialized() const { return buffer_.resource_ != nullptr; }
+
+    /// Allocate size bytes at a power of two alignment. Return an invalid allocation if the ring is full.
+    UploadAllocation Allocate(uint64_t size, uint64_t alignment = 16);
+    /// Free an allocation once the GPU has reached a fence value.
+    void Retire(UploadAllocation const& allocation, uint64_t fenceValue);
+    /// Reclaim space of retired allocations the GPU has finished with.
+    void Reclaim(uint64_t completedValue);
+
+    /// Return size of the buffer.
+    uint64_t GetSize() const { return buffer_.size_; }
+    /// Return bytes in use, including padding and space skipped when wrapping.
+    uint64_t GetUsedSize() const { return usedSize_; }
+    /// Return number of allocations not reclaimed yet.
+    unsigned GetAllocationCount() const { return (unsigned) allocations_.size(); }
+
+private:
+    /// Allocation not reclaimed yet
+    struct Span
+    {
+        /// Offset in the buffer
+        uint64_t offset_;
+        /// Bytes taken including padding and skipped space before it
+        uint64_t size_;
+        /// Fence value, zero until retired
+        uint64_t fenceValue_;
+    };
+
+    /// Factory
+    UploadBufferFactory* factory_{};
+    /// Buffer
+    UploadBufferInfo buffer_;
+    /// Allocations oldest first
+    std::deque<Span> allocations_;
+    /// Next free byte
+    uint64_t head_{};
+    /// Bytes in use
+    uint64_t usedSize_{};
+};
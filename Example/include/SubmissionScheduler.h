@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "FenceTimeline.h"
+#include "FramePacer.h"
+#include "GpuQueue.h"
+
+
+/// Work submitted to a queue, complete once the queue's fence reaches the value.
+struct GpuSubmission
+{
+    /// Queue
+    GpuQueueType queue_{GPU_QUEUE_DIRECT};
+    /// Fence value of the queue
+    uint64_t value_{};
+
+    /// Return whether refers to a submission.
+    bool IsValid() const { return value_ != 0; }
+};
+
+/// Submission scheduler statistics.
+struct SubmissionSchedulerStats
+{
+    /// Submit calls
+    uint64_t submissions_{};
+    /// Batches executed, one ExecuteCommandLists and signal each
+    uint64_t batches_{};
+    /// Cross-queue waits inserted
+    uint64_t waits_{};
+    /// Dependencies that needed no wait, being on the same queue, already waited for or already complete
+    uint64_t waitsSkipped_{};
+};
+
+/// Schedules command lists on the direct, compute and copy queues. Work is submitted tagged with a queue and
+/// the submissions it depends on, and batched per queue until Flush: consecutive submissions to a queue go
+/// out with one ExecuteCommandLists and one signal. A dependency on another queue becomes a GPU wait on
+/// that queue's fence in front of the batch, unless the queue already waited for that value or more. A
+/// submission that needs a new wait starts a new batch so the work before it is not held back. Batches are
+/// executed in the order they were started, which is always after the batches they wait for.
+///
+/// Each queue has a fence of its own that only the scheduler signals. Command lists are submitted as they
+/// are: they must be closed and record their own barriers, their state trackers are not resolved.
+class SubmissionScheduler
+{
+public:
+    /// Construct.
+    explicit SubmissionScheduler();
+    /// Destruct.
+    ~SubmissionScheduler();
+
+    /// Set the queue of a type, null to remove it. Only while nothing is pending.
+    void SetQueue(GpuQueueType type, GpuQueue* queue);
+    /// Return the queue of a type.
+    GpuQueue* GetQueue(GpuQueueType type) const { return queues_[type]; }
+    /// Return the fence timeline of a queue.
+    FenceTimeline& GetTimeline(GpuQueueType type) { return timelines_[type]; }
+
+    /// Add command lists to the batch of a queue, to run after the given submissions. Return the submission.
+    GpuSubmission Submit(GpuQueueType type, CommandList* const* commandLists, unsigned count,
+        GpuSubmission const* dependencies = nullptr, unsigned dependencyCount = 0);
+    /// Execute the pending batches.
+    void Flush();
+    /// Make a queue wait on the GPU for a submission before any work submitted to it from now on, flushing
+    /// if the submission is still pending. For work submitted past the scheduler, like the frame's command lists.
+    void QueueWait(GpuQueueType type, GpuSubmission const& submission);
+
+    /// Return whether the GPU has finished a submission.
+    bool IsComplete(GpuSubmission const& submission);
+    /// Block until the GPU has finished a submission, flushing if it is still pending.
+    void WaitForCompletion(GpuSubmission const& submission);
+    /// Flush and remember the last value of every queue for a frame slot.
+    void EndFrame(unsigned frameIndex);
+    /// Wait until the GPU has finished the work of every queue the frame slot last ended with, so command
+    /// lists that used the slot's allocators can be reset.
+    void BeginFrame(unsigned frameIndex);
+    /// Flush and wait until every queue is idle.
+    void WaitIdle();
+
+    /// Return number of batches pending.
+    unsigned GetPendingBatchCount() const { return batchCount_; }
+    /// Return statistics.
+    SubmissionSchedulerStats const& GetStats() const { return stats_; }
+
+private:
+    /// Command lists submitted to a queue with one call
+    struct Batch
+    {
+        /// Queue
+        GpuQueueType queue_;
+        /// Fence value signaled after the command lists
+        uint64_t value_;
+        /// Fence value of each queue to wait for first, zero for none
+        uint64_t waits_[MAX_GPU_QUEUES];
+        /// Command lists
+        std::vector<CommandList*> commandLists_;
+    };
+
+    /// Start a batch on a queue. Return its index.
+    unsigned BeginBatch(GpuQueueType type);
+    /// Return whether a queue needs to wait for a submission.
+    bool NeedsWait(GpuQueueType type, GpuSubmission const& submission);
+
+    /// Queues
+    GpuQueue* queues_[MAX_GPU_QUEUES]{};
+    /// Fence timelines of the queues
+    FenceTimeline timelines_[MAX_GPU_QUEUES];
+    /// Last fence value given out per queue, including pending batches
+    uint64_t lastValues_[MAX_GPU_QUEUES]{};
+    /// Highest fence value of each queue each queue waits for, including pending batches
+    uint64_t waitedValues_[MAX_GPU_QUEUES][MAX_GPU_QUEUES]{};
+    /// Batches in start order, allocated once so command list vectors keep their capacity
+    std::vector<Batch> batches_;
+    /// Batches pending
+    unsigned batchCount_{};
+    /// Pending batch taking submissions per queue, ~0u for none
+    unsigned openBatches_[MAX_GPU_QUEUES];
+    /// Last fence value of every queue per frame slot
+    uint64_t frameValues_[FramePacer::MaxFramesInFlight][MAX_GPU_QUEUES]{};
+    /// Statistics
+    SubmissionSchedulerStats stats_;
+};
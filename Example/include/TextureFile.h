@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+/// Row pitch alignment of texture upload data, identical to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT.
+static const uint64_t TEXTURE_DATA_PITCH_ALIGNMENT = 256;
+/// Offset alignment of texture upload data, identical to D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+static const uint64_t TEXTURE_DATA_PLACEMENT_ALIGNMENT = 512;
+
+/// Mip level of a texture file.
+struct TextureMipInfo
+{
+    /// Offset of the data in the file
+    uint64_t offset_{};
+    /// Size of the data in bytes
+    uint64_t size_{};
+    /// Width in pixels
+    unsigned width_{};
+    /// Height in pixels
+    unsigned height_{};
+    /// Bytes per row of pixels or blocks, tightly packed
+    unsigned rowSize_{};
+    /// Rows of pixels or blocks
+    unsigned rowCount_{};
+
+    /// Return row pitch of the upload data.
+    uint64_t GetUploadRowPitch() const { return (rowSize_ + TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(TEXTURE_DATA_PITCH_ALIGNMENT - 1); }
+    /// Return size of the upload data.
+    uint64_t GetUploadSize() const { return GetUploadRowPitch() * rowCount_; }
+};
+
+/// 2D texture stored in a DDS or KTX2 file, mip 0 being the largest.
+struct TextureFileInfo
+{
+    /// Width of mip 0
+    unsigned width_{};
+    /// Height of mip 0
+    unsigned height_{};
+    /// Format, numerically a DXGI_FORMAT
+    unsigned format_{};
+    /// Block width and height in pixels, 1 for uncompressed formats
+    unsigned blockSize_{1};
+    /// Mip levels
+    std::vector<TextureMipInfo> mips_;
+
+    /// Return number of mip levels.
+    unsigned GetMipCount() const { return (unsigned) mips_.size(); }
+    /// Return bytes of mips [firstMip, mip count).
+    uint64_t GetMipChainSize(unsigned firstMip) const;
+};
+
+/// Parse the header of a DDS or KTX2 file in memory and locate its mips. Supports single 2D textures in
+/// RGBA8, BGRA8 and the BC formats up to 16384 pixels wide and high; KTX2 files must not be supercompressed.
+/// Return false otherwise, if the header is truncated, if it has more mips than a full chain or if the mips
+/// do not fit in the data.
+bool ParseTextureFile(uint8_t const* data, uint64_t size, TextureFileInfo& info);
+/// Copy a mip from file data into upload memory with the aligned row pitch.
+void CopyTextureMip(uint8_t const* fileData, TextureMipInfo const& mip, uint8_t* dest);
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GraphicsDefs.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "StagingRing.h"
+#include "TextureFile.h"
+
+
+/// Destination of streamed mips. Owns the GPU textures and records the copies into them, on the Direct3D12
+/// copy queue or into a null sink that only models the transfer time.
+class TextureUploadSink
+{
+public:
+    /// Destruct.
+    virtual ~TextureUploadSink() = default;
+
+    /// Create a texture holding mips [firstMip, mip count) of a file. When an old texture holding mips from
+    /// oldFirstMip on is given, record the copy of the mips both hold. Return null on failure.
+    virtual ResourceHandle CreateTexture(TextureFileInfo const& info, unsigned firstMip, ResourceHandle oldTexture,
+        unsigned oldFirstMip) = 0;
+    /// Release a texture once the GPU has finished with it.
+    virtual void ReleaseTexture(ResourceHandle texture) = 0;
+    /// Record the copy of a mip laid out by CopyTextureMip in staging memory into a texture whose first mip is firstMip.
+    virtual void UploadMip(ResourceHandle texture, TextureFileInfo const& info, unsigned firstMip, unsigned mip,
+        UploadAllocation const& staging) = 0;
+    /// Submit the recorded copies, if any. Return a fence value reached once they complete.
+    virtual uint64_t Submit() = 0;
+    /// Return the last fence value the copies have reached.
+    virtual uint64_t GetCompletedValue() = 0;
+};
+
+/// Texture streaming statistics.
+struct TextureStreamerStats
+{
+    /// Loads completed
+    uint64_t loads_{};
+    /// Mips uploaded
+    uint64_t mipsLoaded_{};
+    /// File bytes decoded
+    uint64_t bytesRead_{};
+    /// Staging bytes uploaded including row padding
+    uint64_t bytesUploaded_{};
+    /// Mips evicted to stay within the budget
+    uint64_t mipsEvicted_{};
+    /// Loads postponed because the staging ring was full
+    uint64_t stagingFull_{};
+    /// Loads postponed because nothing could be evicted for them
+    uint64_t overBudget_{};
+};
+
+/// Streams the mips of memory-mapped DDS and KTX2 files into GPU textures. Loads start from the smallest
+/// mips: the first load of a texture brings in its mip tail, every later one the next larger mip, so
+/// something is resident early and detail follows as bandwidth allows. Mips are copied from the mapped
+/// file into a staging ring on job threads and uploaded by the sink once decoded. A load goes into a new
+/// texture that also receives the mips already resident, and replaces the old one once the GPU has finished
+/// the copies, so rendering never waits for them. A budget caps the bytes of resident mips; when a load does
+/// not fit, the largest mips of lower priority textures are evicted the same way. Main thread only.
+class TextureStreamer
+{
+public:
+    /// Bytes of the mip tail loaded with the first load of a texture
+    static constexpr uint64_t MipTailSize{64 * 1024};
+    /// Default size of the staging ring
+    static constexpr uint64_t DefaultStagingSize{32 * 1024 * 1024};
+
+    /// Construct.
+    explicit TextureStreamer();
+    /// Destruct. Waits for decode jobs.
+    ~TextureStreamer();
+
+    /// Create the staging ring. Return false on failure.
+    bool Initialize(TextureUploadSink& sink, UploadBufferFactory& factory, uint64_t stagingSize = DefaultStagingSize);
+    /// Wait for decode jobs, release all textures and destroy the staging ring. Only safe once the GPU is idle.
+    void Shutdown();
+    /// Set job system to decode on, null to decode on the main thread.
+    void SetJobSystem(JobSystem* jobSystem) { jobSystem_ = jobSystem; }
+    /// Set budget of resident bytes.
+    void SetBudget(uint64_t bytes) { budget_ = bytes; }
+    /// Return budget of resident bytes.
+    uint64_t GetBudget() const { return budget_; }
+    /// Set bytes of loads started per Update, at least one load starts regardless.
+    void SetUploadLimit(uint64_t bytes) { uploadLimit_ = bytes; }
+
+    /// Map a texture file and queue its mip tail. Return an id, or ~0u if the file can not be mapped or parsed.
+    unsigned AddTexture(std::string const& fileName, float priority = 1.0f);
+    /// Release a texture once its load in flight, if any, has finished.
+    void RemoveTexture(unsigned id);
+    /// Set priority, higher priorities load first and evict last.
+    void SetPriority(unsigned id, float priority);
+    /// Set the largest mip worth loading, larger resident mips are evicted.
+    void SetWantedMip(unsigned id, unsigned mip);
+    /// Finish completed loads, record uploads of decoded mips, evict and start new loads. Call once per frame.
+    void Update();
+
+    /// Return texture, null until its mip tail has been uploaded. Its mip 0 is mip GetFirstMip of the file.
+    ResourceHandle GetTexture(unsigned id) const;
+    /// Return first resident mip, the mip count when none.
+    unsigned GetFirstMip(unsigned id) const;
+    /// Return file info.
+    TextureFileInfo const& GetFileInfo(unsigned id) const;
+    /// Return bytes of mips held by textures or being loaded into them.
+    uint64_t GetCommittedSize() const { return committedSize_; }
+    /// Return whether the last Update had no load in flight and none to start.
+    bool IsIdle() const { return idle_; }
+    /// Return statistics.
+    TextureStreamerStats const& GetStats() const { return stats_; }
+    /// Return staging ring.
+    StagingRing const& GetStagingRing() const { return staging_; }
+
+private:
+    /// Replacement of a texture in flight, with mips to upload or with mips evicted
+    struct Load
+    {
+        /// First mip of the new texture
+        unsigned firstMip_;
+        /// Mip after the last one uploaded, firstMip_ when evicting
+        unsigned endMip_;
+        /// New texture, null until recorded
+        ResourceHandle texture_{};
+        /// Staging memory of the mips, each at an aligned offset
+        UploadAllocation staging_;
+        /// Set by the decode job once the staging memory is filled
+        std::atomic<bool> decoded_{};
+        /// Fence value of the upload, zero until recorded
+        uint64_t fenceValue_{};
+    };
+
+    /// Streamed texture
+    struct Texture
+    {
+        /// Mapped file
+        MappedFile file_;
+        /// File info
+        TextureFileInfo info_;
+        /// Texture, null when nothing is resident
+        ResourceHandle texture_{};
+        /// First resident mip, the mip count when none
+        unsigned firstMip_{};
+        /// First mip of the mip tail
+        unsigned tailMip_{};
+        /// Largest mip worth loading
+        unsigned wantedMip_{};
+        /// Priority
+        float priority_{1.0f};
+        /// Load in flight
+        std::unique_ptr<Load> load_;
+        /// Removal requested, released once no load is in flight
+        bool removed_{};
+    };
+
+    /// Start a load of mips [firstMip, endMip) and decode them. Return false if staging memory is lacking.
+    bool StartLoad(Texture& texture, unsigned firstMip, unsigned endMip);
+    /// Create the new texture of a decoded load and record its copies. Return false on failure.
+    bool RecordLoad(Texture& texture);
+    /// Evict the mips of a texture before a mip, recording the copy of the mips kept. Return false on failure.
+    bool Evict(Texture& texture, unsigned firstMip);
+    /// Evict mips of textures below a priority until bytes more fit the budget. Return whether they fit.
+    bool EvictFor(uint64_t bytes, float priority);
+    /// Release a removed texture and free its slot.
+    void Release(unsigned id);
+
+    /// Upload sink
+    TextureUploadSink* sink_{};
+    /// Job system, null to decode inline
+    JobSystem* jobSystem_{};
+    /// Counter of decode jobs
+    JobCounter decodeCounter_;
+    /// Staging ring
+    StagingRing staging_;
+    /// Textures by id, null for free slots
+    std::vector<std::unique_ptr<Texture>> textures_;
+    /// Free ids
+    std::vector<unsigned> freeIds_;
+    /// Loads recorded in the current Update
+    std::vector<Load*> recorded_;
+    /// Staging memory of loads dropped in the current Update
+    std::vector<UploadAllocation> dropped_;
+    /// Candidate textures of the current Update
+    std::vector<unsigned> candidates_;
+    /// Budget of resident bytes
+    uint64_t budget_{~0ull};
+    /// Bytes of loads started per Update
+    uint64_t uploadLimit_{~0ull};
+    /// Bytes held by textures or being loaded into them
+    uint64_t committedSize_{};
+    /// Statistics
+    TextureStreamerStats stats_;
+    /// Idle flag
+    bool idle_{true};
+};
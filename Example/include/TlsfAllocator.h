@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+/// Range allocated from a TLSF allocator.
+struct TlsfAllocation
+{
+    /// Return whether the allocation is valid.
+    bool IsValid() const { return block_ != ~0u; }
+
+    /// Offset from the start of the range
+    uint64_t offset_{};
+    /// Size in bytes, rounded up to the minimum block size
+    uint64_t size_{};
+    /// Block index
+    unsigned block_{~0u};
+};
+
+/// Two-level segregated fit allocator of offsets in a fixed range. Allocation and free are O(1): free blocks
+/// are binned by size class in bitmap indexed lists and neighbours are merged on free. Only offsets are
+/// managed, so the range can be GPU memory that the CPU never touches.
+class TlsfAllocator
+{
+public:
+    /// Smallest block and alignment granularity
+    static constexpr uint64_t MinBlockSize{256};
+
+    /// Construct with the size of the range.
+    explicit TlsfAllocator(uint64_t size);
+
+    /// Allocate size bytes at a power of two alignment. Return an invalid allocation if no free block fits.
+    TlsfAllocation Allocate(uint64_t size, uint64_t alignment = MinBlockSize);
+    /// Free an allocation.
+    void Free(TlsfAllocation& allocation);
+
+    /// Return size of the range.
+    uint64_t GetSize() const { return size_; }
+    /// Return allocated bytes.
+    uint64_t GetAllocatedSize() const { return allocatedSize_; }
+    /// Return free bytes.
+    uint64_t GetFreeSize() const { return size_ - allocatedSize_; }
+    /// Return number of allocations.
+    unsigned GetAllocationCount() const { return allocationCount_; }
+    /// Return whether nothing is allocated.
+    bool IsEmpty() const { return allocationCount_ == 0; }
+    /// Return number of free blocks.
+    unsigned GetFreeRegionCount() const { return freeRegionCount_; }
+    /// Return size of the largest free block.
+    uint64_t GetLargestFreeRegion() const;
+    /// Return share of free bytes outside the largest free block, zero when free space is contiguous.
+    float GetFragmentation() const;
+
+private:
+    /// Second level subdivisions as a power of two
+    static constexpr unsigned SecondLevelBits{4};
+    /// Second level subdivisions per first level
+    static constexpr unsigned SecondLevelCount{1u << SecondLevelBits};
+    /// First levels, one per power of two
+    static constexpr unsigned FirstLevelCount{64};
+    /// Null block index
+    static constexpr unsigned InvalidBlock{~0u};
+
+    /// Physical block, free or allocated
+    struct Block
+    {
+        /// Offset in the range
+        uint64_t offset_;
+        /// Size in bytes
+        uint64_t size_;
+        /// Previous block in address order
+        unsigned prevPhysical_;
+        /// Next block in address order
+        unsigned nextPhysical_;
+        /// Previous block in the free list
+        unsigned prevFree_;
+        /// Next block in the free list
+        unsigned nextFree_;
+        /// Free flag
+        bool free_;
+    };
+
+    /// Return size class of a size.
+    static void Mapping(uint64_t size, unsigned& firstLevel, unsigned& secondLevel);
+    /// Return first free block of the class of size or any larger class.
+    unsigned FindFreeBlock(unsigned firstLevel, unsigned secondLevel) const;
+    /// Return first free block of the class of size or larger that fits at the alignment, checking each block.
+    unsigned FindFittingBlock(uint64_t size, uint64_t alignment) const;
+    /// Link a free block into its list.
+    void InsertFreeBlock(unsigned index);
+    /// Unlink a free block from its list.
+    void RemoveFreeBlock(unsigned index);
+    /// Split size bytes off the front of a block, the rest becomes a new free block. Return the new block.
+    unsigned SplitBlock(unsigned index, uint64_t size);
+    /// Merge a block into the one before it and recycle it.
+    void MergeBlock(unsigned previous, unsigned index);
+    /// Return a recycled or new block index.
+    unsigned NewBlock();
+
+    /// Blocks
+    std::vector<Block> blocks_;
+    /// Recycled block indices
+    std::vector<unsigned> unusedBlocks_;
+    /// Free list heads per size class
+    unsigned freeLists_[FirstLevelCount][SecondLevelCount];
+    /// First levels with free blocks
+    uint64_t firstLevelBitmap_{};
+    /// Second level classes with free blocks per first level
+    uint32_t secondLevelBitmaps_[FirstLevelCount]{};
+    /// Size of the range
+    uint64_t size_;
+    /// Allocated bytes
+    uint64_t allocatedSize_{};
+    /// Number of allocations
+    unsigned allocationCount_{};
+    /// Number of free blocks
+    unsigned freeRegionCount_{};
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+
+#include "BoundingBox.h"
+#include "Matrix.h"
+
+
+/// Streams of floats of equal length, the structure of arrays storage of batch kernels. Each stream holds
+/// one element of every item, so kernels load as many items per instruction as the backend has lanes.
+class FloatStreams
+{
+public:
+    /// Construct with the number of streams.
+    explicit FloatStreams(unsigned streamCount);
+    /// Prevent copy, the streams point into the storage.
+    FloatStreams(FloatStreams const&) = delete;
+    FloatStreams& operator =(FloatStreams const&) = delete;
+    /// Move.
+    FloatStreams(FloatStreams&&) = default;
+    FloatStreams& operator =(FloatStreams&&) = default;
+
+    /// Set number of items, keeping the existing ones.
+    void Resize(unsigned size);
+    /// Return number of items.
+    unsigned GetSize() const { return size_; }
+    /// Return number of streams.
+    unsigned GetStreamCount() const { return streamCount_; }
+    /// Return a stream.
+    float* GetStream(unsigned stream) { return streams_ + (size_t) stream * capacity_; }
+    /// Return a stream.
+    float const* GetStream(unsigned stream) const { return streams_ + (size_t) stream * capacity_; }
+    /// Fill all streams, so that kernels look them up once.
+    void GetStreams(float** streams)
+    {
+        for (unsigned i = 0; i < streamCount_; ++i)
+            streams[i] = GetStream(i);
+    }
+    /// Fill all streams, so that kernels look them up once.
+    void GetStreams(float const** streams) const
+    {
+        for (unsigned i = 0; i < streamCount_; ++i)
+            streams[i] = GetStream(i);
+    }
+
+private:
+    /// Storage of the streams
+    std::vector<float> data_;
+    /// First stream, aligned to 32 bytes within the storage
+    float* streams_{};
+    /// Number of streams
+    unsigned streamCount_;
+    /// Number of items
+    unsigned size_{};
+    /// Items a stream has room for
+    unsigned capacity_{};
+};
+
+/// Affine transforms in structure of arrays layout: twelve streams holding the first three columns of the
+/// rows of a Matrix4, element row * 3 + column. The fourth column is implicitly 0, 0, 0, 1.
+class TransformArray : public FloatStreams
+{
+public:
+    /// Number of streams
+    static constexpr unsigned ElementCount{12};
+
+    /// Construct.
+    explicit TransformArray() : FloatStreams(ElementCount) {}
+
+    /// Set a transform.
+    void Set(unsigned index, Matrix4 const& transform);
+    /// Return a transform.
+    Matrix4 Get(unsigned index) const;
+};
+
+/// Bounding boxes in structure of arrays layout: six streams, center x, y and z then extents x, y and z.
+class BoundsArray : public FloatStreams
+{
+public:
+    /// Number of streams
+    static constexpr unsigned ElementCount{6};
+
+    /// Construct.
+    explicit BoundsArray() : FloatStreams(ElementCount) {}
+
+    /// Set a box.
+    void Set(unsigned index, BoundingBox const& box);
+    /// Return a box.
+    BoundingBox Get(unsigned index) const;
+};
+
+/// Bounding spheres in structure of arrays layout: four streams, center x, y and z then radius.
+class SphereArray : public FloatStreams
+{
+public:
+    /// Number of streams
+    static constexpr unsigned ElementCount{4};
+
+    /// Construct.
+    explicit SphereArray() : FloatStreams(ElementCount) {}
+
+    /// Set a sphere.
+    void Set(unsigned index, BoundingSphere const& sphere);
+    /// Return a sphere.
+    BoundingSphere Get(unsigned index) const;
+};
+
+/// Multiply transforms [first, first + count) of lhs by those of rhs into dest, which may be either.
+void MultiplyTransforms(TransformArray const& lhs, TransformArray const& rhs, TransformArray& dest, unsigned first, unsigned count);
+/// Multiply count transforms of lhs by those of rhs into dest, the array of structures counterpart.
+void MultiplyTransforms(Matrix4 const* lhs, Matrix4 const* rhs, Matrix4* dest, unsigned count);
+
+/// Order a transform hierarchy by depth for PropagateTransforms. Fill the node of each position, the parent
+/// position of each position, -1 for roots, and the first position of each depth level plus the end.
+void SortTransformHierarchy(int const* parents, unsigned count, std::vector<unsigned>& order, std::vector<int>& sortedParents,
+    std::vector<unsigned>& levelOffsets);
+/// Compute world transforms as local transforms followed by the world transform of the parent. Nodes are
+/// ordered by depth as SortTransformHierarchy does: level l spans [levelOffsets[l], levelOffsets[l + 1]),
+/// level 0 holds the roots and every parent is on an earlier level, so a level is transformed lanes at a
+/// time with its parents gathered.
+void PropagateTransforms(TransformArray const& local, int const* parents, unsigned const* levelOffsets, unsigned levelCount,
+    TransformArray& world);
+/// Compute world transforms of count nodes whose parents precede them, the array of structures counterpart.
+void PropagateTransforms(Matrix4 const* local, int const* parents, unsigned count, Matrix4* world);
+
+/// Transform boxes [first, first + count) by the transforms at the same index into dest.
+void TransformBounds(BoundsArray const& local, TransformArray const& transforms, BoundsArray& dest, unsigned first, unsigned count);
+/// Transform count boxes by the transforms at the same index, the array of structures counterpart.
+void TransformBounds(BoundingBox const* local, Matrix4 const* transforms, BoundingBox* dest, unsigned count);
+/// Transform spheres [first, first + count) by the transforms at the same index into dest, scaling radii by
+/// the largest axis scale.
+void TransformBounds(SphereArray const& local, TransformArray const& transforms, SphereArray& dest, unsigned first, unsigned count);
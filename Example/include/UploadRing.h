@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+
+/// Alignment of constant buffer views, identical to D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT.
+static const uint64_t CONSTANT_BUFFER_ALIGNMENT = 256;
+
+/// Persistently mapped upload buffer created by a factory.
+struct UploadBufferInfo
+{
+    /// Native buffer, an ID3D12Resource for the Direct3D12 factory
+    void* resource_{};
+    /// Mapped CPU address
+    uint8_t* cpu_{};
+    /// GPU virtual address
+    uint64_t gpu_{};
+    /// Size in bytes
+    uint64_t size_{};
+};
+
+/// Creates persistently mapped upload buffers. Implemented on the Direct3D12 device and by a null
+/// factory backed by system memory.
+class UploadBufferFactory
+{
+public:
+    /// Destruct.
+    virtual ~UploadBufferFactory() = default;
+
+    /// Create and map a buffer. Return false on failure.
+    virtual bool CreateBuffer(uint64_t size, UploadBufferInfo& info) = 0;
+    /// Unmap and destroy a buffer.
+    virtual void DestroyBuffer(UploadBufferInfo& info) = 0;
+};
+
+/// Sub-allocation of the upload ring, valid until the frame it was allocated in completes.
+struct UploadAllocation
+{
+    /// Return whether the allocation is valid.
+    bool IsValid() const { return cpu_ != nullptr; }
+
+    /// Mapped CPU address
+    uint8_t* cpu_{};
+    /// GPU virtual address
+    uint64_t gpu_{};
+    /// Buffer
+    void* resource_{};
+    /// Offset in the buffer
+    uint64_t offset_{};
+    /// Size in bytes
+    uint64_t size_{};
+};
+
+/// Ring of per-frame upload memory for constants and dynamic geometry in one persistently mapped buffer.
+/// A frame's space is reclaimed once the GPU has passed the fence value it ended with. When the ring is
+/// full a buffer twice the size replaces it and the old one is destroyed once its last frame completes.
+class UploadRing
+{
+public:
+    /// Construct.
+    explicit UploadRing();
+    /// Destruct.
+    ~UploadRing();
+
+    /// Create the buffer. Return false on failure.
+    bool Initialize(UploadBufferFactory& factory, uint64_t size);
+    /// Destroy all buffers. Only safe once the GPU is idle.
+    void Shutdown();
+    /// Return whether initialized.
+    bool IsInitialized() const { return current_.resource_ != nullptr; }
+
+    /// Allocate size bytes at a power of two alignment. Return an invalid allocation if the ring could not grow.
+    UploadAllocation Allocate(uint64_t size, uint64_t alignment = 16);
+    /// Allocate constant buffer data.
+    UploadAllocation AllocateConstants(uint64_t size) { return Allocate(size, CONSTANT_BUFFER_ALIGNMENT); }
+    /// Allocate and copy data.
+    UploadAllocation Upload(void const* data, uint64_t size, uint64_t alignment = 16);
+
+    /// Reclaim space and buffers of completed frames.
+    void BeginFrame(uint64_t completedValue);
+    /// Close the current frame.
+    void EndFrame(uint64_t fenceValue);
+
+    /// Return size of the current buffer.
+    uint64_t GetSize() const { return current_.size_; }
+    /// Return bytes in use in the current buffer, including padding and space skipped when wrapping.
+    uint64_t GetUsedSize() const { return usedSize_; }
+    /// Return bytes allocated by the current frame, including padding.
+    uint64_t GetFrameSize() const { return frameSize_; }
+    /// Return number of times the ring grew.
+    unsigned GetGrowCount() const { return growCount_; }
+    /// Return number of replaced buffers not destroyed yet.
+    unsigned GetRetiredBufferCount() const { return (unsigned) retired_.size(); }
+
+private:
+    /// Space of an ended frame
+    struct FrameSpace
+    {
+        /// Fence value the frame ended with
+        uint64_t fenceValue_;
+        /// Bytes used
+        uint64_t size_;
+    };
+
+    /// Replaced buffer
+    struct RetiredBuffer
+    {
+        /// Buffer
+        UploadBufferInfo info_;
+        /// Fence value of its last frame, zero until that frame ends
+        uint64_t fenceValue_;
+    };
+
+    /// Replace the buffer with a larger one that fits at least size bytes. Return false on failure.
+    bool Grow(uint64_t size);
+
+    /// Factory
+    UploadBufferFactory* factory_{};
+    /// Current buffer
+    UploadBufferInfo current_;
+    /// Ended frames in the current buffer not completed yet
+    std::deque<FrameSpace> frames_;
+    /// Replaced buffers
+    std::vector<RetiredBuffer> retired_;
+    /// Next free byte
+    uint64_t head_{};
+    /// Bytes in use
+    uint64_t usedSize_{};
+    /// Bytes used by the current frame
+    uint64_t frameSize_{};
+    /// Number of grows
+    unsigned growCount_{};
+};
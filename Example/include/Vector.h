@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cmath>
+
+#include "SimdMath.h"
+
+
+/// Three-component vector, the storage type of positions, directions and scales.
+struct Vector3
+{
+    /// Construct zero.
+    Vector3() = default;
+    /// Construct from components.
+    Vector3(float x, float y, float z) : x_(x), y_(y), z_(z) {}
+
+    Vector3 operator +(Vector3 const& rhs) const { return { x_ + rhs.x_, y_ + rhs.y_, z_ + rhs.z_ }; }
+    Vector3 operator -(Vector3 const& rhs) const { return { x_ - rhs.x_, y_ - rhs.y_, z_ - rhs.z_ }; }
+    Vector3 operator -() const { return { -x_, -y_, -z_ }; }
+    Vector3 operator *(Vector3 const& rhs) const { return { x_ * rhs.x_, y_ * rhs.y_, z_ * rhs.z_ }; }
+    Vector3 operator *(float rhs) const { return { x_ * rhs, y_ * rhs, z_ * rhs }; }
+    Vector3& operator +=(Vector3 const& rhs) { return *this = *this + rhs; }
+    Vector3& operator -=(Vector3 const& rhs) { return *this = *this - rhs; }
+    Vector3& operator *=(float rhs) { return *this = *this * rhs; }
+    bool operator ==(Vector3 const& rhs) const { return x_ == rhs.x_ && y_ == rhs.y_ && z_ == rhs.z_; }
+    bool operator !=(Vector3 const& rhs) const { return !(*this == rhs); }
+
+    /// Return dot product.
+    float Dot(Vector3 const& rhs) const { return x_ * rhs.x_ + y_ * rhs.y_ + z_ * rhs.z_; }
+    /// Return cross product.
+    Vector3 Cross(Vector3 const& rhs) const
+    {
+        return { y_ * rhs.z_ - z_ * rhs.y_, z_ * rhs.x_ - x_ * rhs.z_, x_ * rhs.y_ - y_ * rhs.x_ };
+    }
+    /// Return length.
+    float Length() const { return std::sqrt(Dot(*this)); }
+    /// Return unit vector, or zero for a zero vector.
+    Vector3 Normalized() const
+    {
+        float length = Length();
+        return length > 0.0f ? *this * (1.0f / length) : Vector3();
+    }
+    /// Return component-wise absolute value.
+    Vector3 Abs() const { return { std::fabs(x_), std::fabs(y_), std::fabs(z_) }; }
+    /// Return component-wise minimum.
+    Vector3 Min(Vector3 const& rhs) const
+    {
+        return { x_ < rhs.x_ ? x_ : rhs.x_, y_ < rhs.y_ ? y_ : rhs.y_, z_ < rhs.z_ ? z_ : rhs.z_ };
+    }
+    /// Return component-wise maximum.
+    Vector3 Max(Vector3 const& rhs) const
+    {
+        return { x_ > rhs.x_ ? x_ : rhs.x_, y_ > rhs.y_ ? y_ : rhs.y_, z_ > rhs.z_ ? z_ : rhs.z_ };
+    }
+
+    float x_{};
+    float y_{};
+    float z_{};
+};
+
+/// Four-component vector operated on as a Float4.
+struct alignas(16) Vector4
+{
+    /// Construct zero.
+    Vector4() = default;
+    /// Construct from components.
+    Vector4(float x, float y, float z, float w) : x_(x), y_(y), z_(z), w_(w) {}
+    /// Construct from a three-component vector and w.
+    Vector4(Vector3 const& v, float w) : x_(v.x_), y_(v.y_), z_(v.z_), w_(w) {}
+    /// Construct from a Float4.
+    explicit Vector4(Float4 v) { Store(&x_, v); }
+
+    /// Return as a Float4.
+    Float4 Load() const { return Float4::Load(&x_); }
+    /// Return xyz.
+    Vector3 ToVector3() const { return { x_, y_, z_ }; }
+
+    Vector4 operator +(Vector4 const& rhs) const { return Vector4(Load() + rhs.Load()); }
+    Vector4 operator -(Vector4 const& rhs) const { return Vector4(Load() - rhs.Load()); }
+    Vector4 operator *(Vector4 const& rhs) const { return Vector4(Load() * rhs.Load()); }
+    Vector4 operator *(float rhs) const { return Vector4(Load() * Float4::Splat(rhs)); }
+    bool operator ==(Vector4 const& rhs) const { return x_ == rhs.x_ && y_ == rhs.y_ && z_ == rhs.z_ && w_ == rhs.w_; }
+    bool operator !=(Vector4 const& rhs) const { return !(*this == rhs); }
+
+    /// Return dot product.
+    float Dot(Vector4 const& rhs) const { return Dot4(Load(), rhs.Load()); }
+
+    float x_{};
+    float y_{};
+    float z_{};
+    float w_{};
+};
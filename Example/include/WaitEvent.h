@@ -0,0 +1,43 @@
+#pragma once
+
+#if !defined(_WIN32)
+#include <condition_variable>
+#include <mutex>
+#endif
+
+
+/// Auto-reset event a thread can block on until another thread or a fence sets it. A Win32 event on Windows.
+class WaitEvent
+{
+public:
+    /// Construct.
+    explicit WaitEvent();
+    /// Destruct.
+    ~WaitEvent();
+
+    WaitEvent(WaitEvent const&) = delete;
+    WaitEvent& operator =(WaitEvent const&) = delete;
+
+    /// Set the event, releasing one waiter.
+    void Set();
+    /// Block until the event is set, then reset it.
+    void Wait();
+
+#if defined(_WIN32)
+    /// Return Win32 event handle.
+    void* GetHandle() const { return handle_; }
+#endif
+
+private:
+#if defined(_WIN32)
+    /// Win32 event handle
+    void* handle_;
+#else
+    /// Lock for the signaled flag
+    std::mutex mutex_;
+    /// Wakes the waiter
+    std::condition_variable condition_;
+    /// Signaled flag
+    bool signaled_{};
+#endif
+};
@@ -1,10 +1,27 @@
 #include "Application.h"
+#include "FrameTimer.h"
+#include "GpuProfiler.h"
 #include "Graphics.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "ShaderCompiler.h"
+#include "TextureStreamer.h"
+
+#include <chrono>
+#include <sstream>
+
+#if defined(_WIN32)
+#include "D3DShaderCompilerBackend.h"
+#endif
 
 
 void ErrorDialog(const std::string& title, const std::string& message)
 {
+#if defined(_WIN32)
     MessageBox(NULL, message.c_str(), title.c_str(), MB_ICONERROR);
+#else
+    LOGERROR("%s: %s\n", title.c_str(), message.c_str());
+#endif
 }
 
 Application::Application()
@@ -15,32 +32,137 @@ Application::Application()
 
 Application::~Application() = default;
 
+void Application::ParseArguments(std::string const& commandLine)
+{
+    std::istringstream stream(commandLine);
+    std::string argument;
+
+    while (stream >> argument)
+    {
+        if (argument == "-headless")
+            headless_ = true;
+        else if (argument == "-frames")
+            stream >> frameLimit_;
+        else if (argument == "-compileshaders")
+            stream >> shaderManifest_ >> shaderCacheDirectory_;
+        else if (argument == "-trace")
+            stream >> traceFileName_;
+        else if (argument == "-pipelined")
+            pipelined_ = true;
+        else if (argument == "-fps")
+            stream >> frameRateLimit_;
+        else if (argument == "-latency")
+            stream >> maxFrameLatency_;
+        else if (argument == "-texture")
+        {
+            std::string fileName;
+            stream >> fileName;
+            textureFileNames_.push_back(fileName);
+        }
+        else if (argument == "-texturebudget")
+            stream >> textureBudgetMB_;
+    }
+}
+
 int Application::Run()
 {
+    if (!shaderManifest_.empty())
+        return CompileShaders();
+
     Setup();
     if (exitCode_)
         return exitCode_;
 
+    graphics_->SetHeadless(headless_);
+    graphics_->SetPipelined(pipelined_);
+    graphics_->SetMaxFrameLatency(maxFrameLatency_);
+    graphics_->GetFrameTimer().SetFrameRateLimit(frameRateLimit_);
+
     if (!graphics_->Initialize())
     {
         ErrorExit();
         return exitCode_;
     }
 
+    // GPU zones go into the trace on a track of their own
+    if (!traceFileName_.empty())
+        graphics_->GetGpuProfiler().SetProfiler(&Profiler::Get());
+
+    TextureStreamer& textureStreamer = graphics_->GetTextureStreamer();
+    if (textureBudgetMB_)
+        textureStreamer.SetBudget(textureBudgetMB_ * 1024 * 1024);
+    for (std::string const& fileName : textureFileNames_)
+    {
+        if (textureStreamer.AddTexture(fileName) == ~0u)
+            LOGERROR("Failed to stream texture %s\n", fileName.c_str());
+    }
+
     Start();
     if (exitCode_)
         return exitCode_;
 
+    auto startTime = std::chrono::steady_clock::now();
+
     while (!graphics_->IsExiting())
     {
         graphics_->RunFrame();
+
+        // Collect every frame so the thread buffers never wrap
+        if (!traceFileName_.empty())
+            Profiler::Get().Collect();
+
+        if (frameLimit_ && graphics_->GetFrameNumber() >= frameLimit_)
+            graphics_->Exit();
+    }
+
+    if (headless_)
+    {
+        // Without a GPU the frame time is the CPU cost of the frame loop
+        auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime);
+        uint64_t frames = graphics_->GetFrameNumber();
+        LOGINFO("%llu frames, %.3f us per frame\n", (unsigned long long) frames, frames ? elapsed.count() / frames : 0.0);
     }
 
+    if (!traceFileName_.empty() && !Profiler::Get().SaveChromeTrace(traceFileName_))
+        LOGERROR("Failed to save trace %s\n", traceFileName_.c_str());
+
     Stop();
 
     return exitCode_;
 }
 
+int Application::CompileShaders()
+{
+#if defined(_WIN32)
+    std::vector<ShaderCompileDesc> descs;
+    std::string messages;
+    if (!ShaderCompiler::ReadManifest(shaderManifest_, descs, messages))
+    {
+        LOGERROR("%s", messages.c_str());
+        return EXIT_FAILURE;
+    }
+
+    D3DShaderCompilerBackend backend(D3DCOMPILE_OPTIMIZATION_LEVEL3);
+    ShaderCompiler compiler(backend, shaderCacheDirectory_);
+
+    std::vector<ShaderCompileResult> results;
+    unsigned failures = compiler.CompileAll(descs, results, &graphics_->GetJobSystem());
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        if (!results[i].success_)
+            LOGERROR("%s %s %s failed:\n%s", descs[i].fileName_.c_str(), descs[i].entryPoint_.c_str(), descs[i].profile_.c_str(), results[i].messages_.c_str());
+    }
+
+    ShaderCompilerStats stats = compiler.GetStats();
+    LOGINFO("%u shaders, %u compiled, %u cached, %u failed\n", stats.requests_, stats.compiled_, stats.memoryHits_ + stats.diskHits_, stats.failed_);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+#else
+    LOGERROR("Compiling shaders needs the D3D compiler.\n");
+    return EXIT_FAILURE;
+#endif
+}
+
 void Application::ErrorExit(std::string const& message)
 {
     graphics_->Exit();
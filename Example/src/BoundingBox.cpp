@@ -0,0 +1,26 @@
+#include "BoundingBox.h"
+
+#include <cmath>
+
+
+BoundingBox BoundingBox::Transformed(Matrix4 const& transform) const
+{
+    // The extents along each world axis are the sums of the absolute projections of the local extents
+    Float4 extents = Abs(transform.rows_[0].Load()) * Float4::Splat(extents_.x_);
+    extents = MulAdd(Abs(transform.rows_[1].Load()), Float4::Splat(extents_.y_), extents);
+    extents = MulAdd(Abs(transform.rows_[2].Load()), Float4::Splat(extents_.z_), extents);
+
+    return { transform.TransformPoint(center_), Vector4(extents).ToVector3() };
+}
+
+BoundingSphere BoundingSphere::Transformed(Matrix4 const& transform) const
+{
+    float scale = 0.0f;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        float axisScale = transform.rows_[i].ToVector3().Length();
+        scale = axisScale > scale ? axisScale : scale;
+    }
+
+    return { transform.TransformPoint(center_), radius_ * scale };
+}
@@ -0,0 +1,41 @@
+#include "ByteStream.h"
+
+#include <cstdio>
+
+
+bool ReadFileBytes(std::string const& fileName, std::vector<uint8_t>& data)
+{
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (!file)
+        return false;
+
+    data.clear();
+    uint8_t buffer[65536];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof buffer, file)) > 0)
+        data.insert(data.end(), buffer, buffer + read);
+
+    bool success = !ferror(file);
+    fclose(file);
+    return success;
+}
+
+bool WriteFileBytes(std::string const& fileName, void const* data, size_t size)
+{
+    std::string tempName = fileName + ".tmp";
+    FILE* file = fopen(tempName.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool written = fwrite(data, 1, size, file) == size;
+    written = fclose(file) == 0 && written;
+    if (!written)
+    {
+        remove(tempName.c_str());
+        return false;
+    }
+
+    // Rename does not replace an existing file on Windows
+    remove(fileName.c_str());
+    return rename(tempName.c_str(), fileName.c_str()) == 0;
+}
@@ -0,0 +1,9 @@
+#include "CommandList.h"
+
+
+CommandList::CommandList(ResourceStateRegistry& registry)
+    : stateTracker_(registry, true)
+{
+}
+
+CommandList::~CommandList() = default;
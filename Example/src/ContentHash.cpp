@@ -0,0 +1,89 @@
+#include "ContentHash.h"
+
+
+static inline uint64_t RotateLeft(uint64_t value, unsigned bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t Mix(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+static inline uint64_t ReadLittleEndian64(uint8_t const* bytes, size_t count)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < count; ++i)
+        value |= (uint64_t) bytes[i] << (i * 8);
+    return value;
+}
+
+ContentHash HashContent(void const* data, size_t size, uint64_t seed)
+{
+    // MurmurHash3 x64 128, reading bytes explicitly little-endian so the result is the same on every host
+    const uint64_t c1 = 0x87c37b91114253d5ull;
+    const uint64_t c2 = 0x4cf5ad432745937full;
+
+    uint8_t const* bytes = (uint8_t const*) data;
+    size_t blocks = size / 16;
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        uint64_t k1 = ReadLittleEndian64(bytes + i * 16, 8);
+        uint64_t k2 = ReadLittleEndian64(bytes + i * 16 + 8, 8);
+
+        k1 *= c1; k1 = RotateLeft(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = RotateLeft(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = RotateLeft(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = RotateLeft(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    uint8_t const* tail = bytes + blocks * 16;
+    size_t tailSize = size & 15;
+    uint64_t k1 = ReadLittleEndian64(tail, tailSize < 8 ? tailSize : 8);
+    uint64_t k2 = tailSize > 8 ? ReadLittleEndian64(tail + 8, tailSize - 8) : 0;
+
+    if (tailSize > 8)
+    {
+        k2 *= c2; k2 = RotateLeft(k2, 33); k2 *= c1; h2 ^= k2;
+    }
+    if (tailSize)
+    {
+        k1 *= c1; k1 = RotateLeft(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= (uint64_t) size;
+    h2 ^= (uint64_t) size;
+    h1 += h2;
+    h2 += h1;
+    h1 = Mix(h1);
+    h2 = Mix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    ContentHash hash;
+    hash.low_ = h1;
+    hash.high_ = h2;
+    return hash;
+}
+
+std::string ContentHash::ToString() const
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string result(32, '0');
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        result[15 - i] = digits[(high_ >> (i * 4)) & 15];
+        result[31 - i] = digits[(low_ >> (i * 4)) & 15];
+    }
+    return result;
+}
@@ -0,0 +1,155 @@
+#include "D3D12CommandList.h"
+#include "D3D12GpuQueue.h"
+#include "D3D12PipelineStateFactory.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+D3D12CommandList::D3D12CommandList(GraphicsImpl& graphics, GpuQueueType type)
+    : CommandList(graphics.GetStateRegistry())
+    , graphics_(graphics)
+    , type_(type)
+{
+}
+
+D3D12CommandList::~D3D12CommandList()
+{
+    D3D_SAFE_RELEASE(commandList_);
+    for (unsigned i = 0; i < FramePacer::MaxFramesInFlight; ++i)
+        D3D_SAFE_RELEASE(commandAllocators_[i]);
+}
+
+bool D3D12CommandList::Create()
+{
+    ID3D12Device* device = graphics_.GetDevice();
+    D3D12_COMMAND_LIST_TYPE type = D3D12GpuQueue::GetCommandListType(type_);
+
+    for (unsigned i = 0; i < FramePacer::MaxFramesInFlight; ++i)
+    {
+        HRESULT hr = device->CreateCommandAllocator(type, IID_PPV_ARGS(&commandAllocators_[i]));
+        if (FAILED(hr))
+        {
+            D3D_SAFE_RELEASE(commandAllocators_[i]);
+            LOGERROR("Failed to create D3D12 command allocator. (HRESULT %x)", hr);
+            return false;
+        }
+    }
+
+    HRESULT hr = device->CreateCommandList(0, type,
+        commandAllocators_[0], nullptr, IID_PPV_ARGS(&commandList_));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(commandList_);
+        LOGERROR("Failed to create D3D12 command list. (HRESULT %x)", hr);
+        return false;
+    }
+
+    commandList_->Close();
+    return true;
+}
+
+void D3D12CommandList::Reset(unsigned frameIndex)
+{
+    commandAllocators_[frameIndex]->Reset();
+    commandList_->Reset(commandAllocators_[frameIndex], nullptr);
+
+    // Copy lists can not bind descriptor heaps
+    if (type_ == GPU_QUEUE_COPY)
+        return;
+
+    ID3D12DescriptorHeap* heaps[] = { (ID3D12DescriptorHeap*) graphics_.GetDescriptorAllocator().GetRing()->GetHeapInfo().heap_ };
+    commandList_->SetDescriptorHeaps(_countof(heaps), heaps);
+
+    // Every pipeline draws triangle lists
+    if (type_ == GPU_QUEUE_DIRECT)
+        commandList_->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+void D3D12CommandList::ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers)
+{
+    GraphicsImpl::TranslateBarriers(count, barriers, barrierScratch_);
+    commandList_->ResourceBarrier(count, barrierScratch_.data());
+}
+
+void D3D12CommandList::SetDefaultViewport()
+{
+    commandList_->RSSetViewports(1, &graphics_.viewport_);
+    commandList_->RSSetScissorRects(1, &graphics_.scissor_);
+}
+
+void D3D12CommandList::SetPipelineState(PipelineStateHandle state)
+{
+    D3D12PipelineState* d3dState = (D3D12PipelineState*) state;
+    commandList_->SetPipelineState(d3dState->pipelineState_);
+    if (d3dState->rootSignature_)
+        commandList_->SetGraphicsRootSignature(d3dState->rootSignature_);
+}
+
+void D3D12CommandList::SetPipelineStateObject(PipelineStateHandle state)
+{
+    commandList_->SetPipelineState(((D3D12PipelineState*) state)->pipelineState_);
+}
+
+void D3D12CommandList::SetRootSignature(RootSignatureHandle rootSignature)
+{
+    commandList_->SetGraphicsRootSignature((ID3D12RootSignature*) rootSignature);
+}
+
+void D3D12CommandList::SetDescriptorTable(unsigned rootParameter, uint64_t gpuAddress)
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE handle;
+    handle.ptr = gpuAddress;
+    commandList_->SetGraphicsRootDescriptorTable(rootParameter, handle);
+}
+
+void D3D12CommandList::SetVertexBuffer(VertexBufferView const& view)
+{
+    D3D12_VERTEX_BUFFER_VIEW d3dView;
+    d3dView.BufferLocation = view.gpuAddress_;
+    d3dView.SizeInBytes = view.size_;
+    d3dView.StrideInBytes = view.stride_;
+    commandList_->IASetVertexBuffers(0, 1, &d3dView);
+}
+
+void D3D12CommandList::DrawInstanced(unsigned vertexCount, unsigned instanceCount, unsigned firstVertex, unsigned firstInstance)
+{
+    commandList_->DrawInstanced(vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+void D3D12CommandList::SetIndexBuffer(IndexBufferView const& view)
+{
+    D3D12_INDEX_BUFFER_VIEW d3dView;
+    d3dView.BufferLocation = view.gpuAddress_;
+    d3dView.SizeInBytes = view.size_;
+    d3dView.Format = (DXGI_FORMAT) view.format_;
+    commandList_->IASetIndexBuffer(&d3dView);
+}
+
+void D3D12CommandList::SetRootShaderResource(unsigned rootParameter, uint64_t gpuAddress)
+{
+    commandList_->SetGraphicsRootShaderResourceView(rootParameter, gpuAddress);
+}
+
+void D3D12CommandList::CopyBufferRegion(ResourceHandle dest, uint64_t destOffset, ResourceHandle source, uint64_t sourceOffset, uint64_t size)
+{
+    commandList_->CopyBufferRegion((ID3D12Resource*) dest, destOffset, (ID3D12Resource*) source, sourceOffset, size);
+}
+
+void D3D12CommandList::ExecuteIndirect(CommandSignatureHandle signature, unsigned count, ResourceHandle argumentBuffer, uint64_t argumentOffset)
+{
+    commandList_->ExecuteIndirect((ID3D12CommandSignature*) signature, count, (ID3D12Resource*) argumentBuffer, argumentOffset, nullptr, 0);
+}
+
+void D3D12CommandList::SetDefaultRenderTargets()
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = graphics_.CurrentBackBufferView();
+    D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = graphics_.DepthStencilView();
+    commandList_->OMSetRenderTargets(1, &renderTargetView, true, &depthStencilView);
+}
+
+void D3D12CommandList::Close()
+{
+    HRESULT hr = commandList_->Close();
+    if (FAILED(hr))
+        LOGERROR("Failed to close D3D12 command list. (HRESULT %x)", hr);
+}
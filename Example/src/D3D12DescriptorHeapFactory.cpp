@@ -0,0 +1,60 @@
+
+#include "D3D12DescriptorHeapFactory.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+D3D12DescriptorHeapFactory::D3D12DescriptorHeapFactory(ID3D12Device* device)
+    : device_(device)
+{
+}
+
+bool D3D12DescriptorHeapFactory::CreateHeap(DescriptorHeapType type, unsigned capacity, bool shaderVisible, DescriptorHeapInfo& info)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc;
+    heapDesc.NumDescriptors = capacity;
+    heapDesc.Type = (D3D12_DESCRIPTOR_HEAP_TYPE) type;
+    heapDesc.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    heapDesc.NodeMask = 0;
+
+    ID3D12DescriptorHeap* heap = nullptr;
+    HRESULT hr = device_->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(heap);
+        LOGERROR("Create descriptor heap failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    info.heap_ = heap;
+    info.cpuStart_ = heap->GetCPUDescriptorHandleForHeapStart().ptr;
+    info.gpuStart_ = shaderVisible ? heap->GetGPUDescriptorHandleForHeapStart().ptr : 0;
+    info.increment_ = device_->GetDescriptorHandleIncrementSize(heapDesc.Type);
+    info.capacity_ = capacity;
+    return true;
+}
+
+void D3D12DescriptorHeapFactory::DestroyHeap(DescriptorHeapInfo& info)
+{
+    ID3D12DescriptorHeap* heap = (ID3D12DescriptorHeap*) info.heap_;
+    D3D_SAFE_RELEASE(heap);
+    info = DescriptorHeapInfo();
+}
+
+void D3D12DescriptorHeapFactory::CopyDescriptors(DescriptorHeapType type, size_t destStart, unsigned rangeCount,
+    size_t const* rangeStarts, unsigned const* rangeSizes)
+{
+    unsigned destSize = 0;
+    sourceHandles_.resize(rangeCount);
+    for (unsigned i = 0; i < rangeCount; ++i)
+    {
+        sourceHandles_[i].ptr = rangeStarts[i];
+        destSize += rangeSizes[i];
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE destHandle;
+    destHandle.ptr = destStart;
+
+    device_->CopyDescriptors(1, &destHandle, &destSize, rangeCount, sourceHandles_.data(), rangeSizes,
+        (D3D12_DESCRIPTOR_HEAP_TYPE) type);
+}
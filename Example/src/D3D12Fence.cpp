@@ -0,0 +1,33 @@
+
+#include "D3D12Fence.h"
+#include "Common.h"
+
+
+D3D12Fence::D3D12Fence(ID3D12CommandQueue* queue, ID3D12Fence* fence)
+    : queue_(queue)
+    , fence_(fence)
+{
+}
+
+void D3D12Fence::Signal(uint64_t value)
+{
+    HRESULT hr = queue_->Signal(fence_, value);
+    if (FAILED(hr))
+        LOGERROR("Failed to signal D3D12 fence. (HRESULT %x)", hr);
+}
+
+uint64_t D3D12Fence::GetCompletedValue() const
+{
+    return fence_->GetCompletedValue();
+}
+
+void D3D12Fence::SetEventOnCompletion(uint64_t value, WaitEvent& event)
+{
+    HRESULT hr = fence_->SetEventOnCompletion(value, (HANDLE) event.GetHandle());
+    if (FAILED(hr))
+    {
+        // Do not leave the waiter blocked forever
+        LOGERROR("Failed to set D3D12 fence event. (HRESULT %x)", hr);
+        event.Set();
+    }
+}
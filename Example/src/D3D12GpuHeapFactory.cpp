@@ -0,0 +1,54 @@
+
+#include "D3D12GpuHeapFactory.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+static D3D12_HEAP_FLAGS const heapFlags[] =
+{
+    D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+    D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+    D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+};
+
+D3D12GpuHeapFactory::D3D12GpuHeapFactory(ID3D12Device* device)
+    : device_(device)
+{
+}
+
+bool D3D12GpuHeapFactory::CreateHeap(GpuHeapCategory category, uint64_t size, GpuHeapInfo& info)
+{
+    // Render targets may be multisampled, which needs the larger placement alignment
+    uint64_t alignment = category == GPU_HEAP_RENDER_TARGETS ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT :
+        D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+    D3D12_HEAP_DESC heapDesc;
+    heapDesc.SizeInBytes = (size + alignment - 1) & ~(alignment - 1);
+    heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    heapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapDesc.Properties.CreationNodeMask = 1;
+    heapDesc.Properties.VisibleNodeMask = 1;
+    heapDesc.Alignment = alignment;
+    heapDesc.Flags = heapFlags[category];
+
+    ID3D12Heap* heap = nullptr;
+    HRESULT hr = device_->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(heap);
+        LOGERROR("Create GPU heap failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    info.heap_ = heap;
+    info.size_ = heapDesc.SizeInBytes;
+    return true;
+}
+
+void D3D12GpuHeapFactory::DestroyHeap(GpuHeapInfo& info)
+{
+    ID3D12Heap* heap = (ID3D12Heap*) info.heap_;
+    D3D_SAFE_RELEASE(heap);
+    info = GpuHeapInfo();
+}
@@ -0,0 +1,108 @@
+#include "D3D12GpuQueue.h"
+#include "D3D12CommandList.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+D3D12GpuQueue::D3D12GpuQueue(ID3D12Device* device)
+    : device_(device)
+{
+}
+
+D3D12GpuQueue::~D3D12GpuQueue()
+{
+    D3D_SAFE_RELEASE(fence_);
+    if (ownsQueue_)
+        D3D_SAFE_RELEASE(queue_);
+}
+
+bool D3D12GpuQueue::Create(GpuQueueType type)
+{
+    D3D12_COMMAND_QUEUE_DESC queueDesc;
+    ZeroMemory(&queueDesc, sizeof(queueDesc));
+    queueDesc.Type = GetCommandListType(type);
+    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+
+    HRESULT hr = device_->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&queue_));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(queue_);
+        LOGERROR("Failed to create D3D12 command queue. (HRESULT %x)", hr);
+        return false;
+    }
+
+    ownsQueue_ = true;
+    return CreateFence();
+}
+
+bool D3D12GpuQueue::Create(ID3D12CommandQueue* queue)
+{
+    queue_ = queue;
+    ownsQueue_ = false;
+    return CreateFence();
+}
+
+bool D3D12GpuQueue::CreateFence()
+{
+    HRESULT hr = device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(fence_);
+        LOGERROR("Failed to create D3D12 fence. (HRESULT %x)", hr);
+        return false;
+    }
+
+    return true;
+}
+
+void D3D12GpuQueue::ExecuteCommandLists(CommandList* const* commandLists, unsigned count)
+{
+    executeScratch_.resize(count);
+    for (unsigned i = 0; i < count; ++i)
+        executeScratch_[i] = static_cast<D3D12CommandList*>(commandLists[i])->GetCommandList();
+
+    queue_->ExecuteCommandLists((UINT) count, executeScratch_.data());
+}
+
+void D3D12GpuQueue::Wait(GpuQueue& queue, uint64_t value)
+{
+    HRESULT hr = queue_->Wait(static_cast<D3D12GpuQueue&>(queue).fence_, value);
+    if (FAILED(hr))
+        LOGERROR("Failed to wait for D3D12 fence. (HRESULT %x)", hr);
+}
+
+void D3D12GpuQueue::Signal(uint64_t value)
+{
+    HRESULT hr = queue_->Signal(fence_, value);
+    if (FAILED(hr))
+        LOGERROR("Failed to signal D3D12 fence. (HRESULT %x)", hr);
+}
+
+uint64_t D3D12GpuQueue::GetCompletedValue() const
+{
+    return fence_->GetCompletedValue();
+}
+
+void D3D12GpuQueue::SetEventOnCompletion(uint64_t value, WaitEvent& event)
+{
+    HRESULT hr = fence_->SetEventOnCompletion(value, (HANDLE) event.GetHandle());
+    if (FAILED(hr))
+    {
+        // Do not leave the waiter blocked forever
+        LOGERROR("Failed to set D3D12 fence event. (HRESULT %x)", hr);
+        event.Set();
+    }
+}
+
+D3D12_COMMAND_LIST_TYPE D3D12GpuQueue::GetCommandListType(GpuQueueType type)
+{
+    switch (type)
+    {
+    case GPU_QUEUE_COMPUTE:
+        return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+    case GPU_QUEUE_COPY:
+        return D3D12_COMMAND_LIST_TYPE_COPY;
+    default:
+        return D3D12_COMMAND_LIST_TYPE_DIRECT;
+    }
+}
@@ -0,0 +1,88 @@
+#include "D3D12IndirectDrawFactory.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+D3D12IndirectDrawFactory::D3D12IndirectDrawFactory(ID3D12Device* device)
+    : device_(device)
+{
+}
+
+bool D3D12IndirectDrawFactory::CreateBuffer(uint64_t size, GpuBufferInfo& info)
+{
+    D3D12_HEAP_PROPERTIES heapProperties;
+    heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapProperties.CreationNodeMask = 1;
+    heapProperties.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC resourceDesc;
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    resourceDesc.Alignment = 0;
+    resourceDesc.Width = size;
+    resourceDesc.Height = 1;
+    resourceDesc.DepthOrArraySize = 1;
+    resourceDesc.MipLevels = 1;
+    resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+    resourceDesc.SampleDesc.Count = 1;
+    resourceDesc.SampleDesc.Quality = 0;
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    ID3D12Resource* buffer = nullptr;
+    HRESULT hr = device_->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&buffer));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(buffer);
+        LOGERROR("Create GPU buffer failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    info.resource_ = buffer;
+    info.gpu_ = buffer->GetGPUVirtualAddress();
+    info.size_ = size;
+    return true;
+}
+
+void D3D12IndirectDrawFactory::DestroyBuffer(GpuBufferInfo& info)
+{
+    ID3D12Resource* buffer = (ID3D12Resource*) info.resource_;
+    D3D_SAFE_RELEASE(buffer);
+    info = GpuBufferInfo();
+}
+
+CommandSignatureHandle D3D12IndirectDrawFactory::CreateCommandSignature(RootSignatureHandle rootSignature, unsigned objectIndexParameter)
+{
+    // The object index is a root constant, so a signature changing root arguments needs the root signature
+    D3D12_INDIRECT_ARGUMENT_DESC arguments[2];
+    arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+    arguments[0].Constant.RootParameterIndex = objectIndexParameter;
+    arguments[0].Constant.DestOffsetIn32BitValues = 0;
+    arguments[0].Constant.Num32BitValuesToSet = 1;
+    arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+    D3D12_COMMAND_SIGNATURE_DESC signatureDesc;
+    signatureDesc.ByteStride = sizeof(IndirectDrawArguments);
+    signatureDesc.NumArgumentDescs = _countof(arguments);
+    signatureDesc.pArgumentDescs = arguments;
+    signatureDesc.NodeMask = 0;
+
+    ID3D12CommandSignature* signature = nullptr;
+    HRESULT hr = device_->CreateCommandSignature(&signatureDesc, (ID3D12RootSignature*) rootSignature, IID_PPV_ARGS(&signature));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(signature);
+        LOGERROR("Create command signature failed. (HRESULT %x)", hr);
+        return nullptr;
+    }
+
+    return signature;
+}
+
+void D3D12IndirectDrawFactory::ReleaseCommandSignature(CommandSignatureHandle signature)
+{
+    ID3D12CommandSignature* d3dSignature = (ID3D12CommandSignature*) signature;
+    D3D_SAFE_RELEASE(d3dSignature);
+}
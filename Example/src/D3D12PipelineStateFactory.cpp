@@ -0,0 +1,155 @@
+#include "D3D12PipelineStateFactory.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+static D3D12_RENDER_TARGET_BLEND_DESC GetBlendDesc(PipelineBlendMode mode)
+{
+    D3D12_RENDER_TARGET_BLEND_DESC desc;
+    desc.BlendEnable = mode != PIPELINE_BLEND_REPLACE;
+    desc.LogicOpEnable = false;
+    desc.SrcBlend = D3D12_BLEND_ONE;
+    desc.DestBlend = D3D12_BLEND_ZERO;
+    desc.BlendOp = D3D12_BLEND_OP_ADD;
+    desc.SrcBlendAlpha = D3D12_BLEND_ONE;
+    desc.DestBlendAlpha = D3D12_BLEND_ZERO;
+    desc.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+    desc.LogicOp = D3D12_LOGIC_OP_NOOP;
+    desc.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+
+    switch (mode)
+    {
+    case PIPELINE_BLEND_ALPHA:
+        desc.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        desc.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+        desc.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+        break;
+
+    case PIPELINE_BLEND_ADD:
+        desc.DestBlend = D3D12_BLEND_ONE;
+        desc.DestBlendAlpha = D3D12_BLEND_ONE;
+        break;
+
+    case PIPELINE_BLEND_PREMULTIPLIED_ALPHA:
+        desc.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+        desc.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+        break;
+
+    default:
+        break;
+    }
+
+    return desc;
+}
+
+D3D12PipelineStateFactory::D3D12PipelineStateFactory(ID3D12Device* device, IDXGIFactory1* factory)
+    : device_(device)
+{
+    // Cached blobs are only valid for the same adapter and driver version
+    IDXGIFactory4* factory4 = nullptr;
+    IDXGIAdapter1* adapter = nullptr;
+    if (SUCCEEDED(factory->QueryInterface(IID_PPV_ARGS(&factory4))) &&
+        SUCCEEDED(factory4->EnumAdapterByLuid(device_->GetAdapterLuid(), IID_PPV_ARGS(&adapter))))
+    {
+        DXGI_ADAPTER_DESC1 adapterDesc;
+        LARGE_INTEGER driverVersion{};
+        adapter->GetDesc1(&adapterDesc);
+        adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion);
+
+        uint64_t identity[] = { adapterDesc.VendorId, adapterDesc.DeviceId, adapterDesc.SubSysId, (uint64_t) driverVersion.QuadPart };
+        deviceId_ = HashContent(identity, sizeof identity).low_;
+    }
+
+    D3D_SAFE_RELEASE(adapter);
+    D3D_SAFE_RELEASE(factory4);
+}
+
+PipelineStateHandle D3D12PipelineStateFactory::CreatePipelineState(PipelineDesc const& desc, void const* cachedBlob, size_t cachedBlobSize)
+{
+    D3D12PipelineState* state = new D3D12PipelineState();
+
+    if (!desc.rootSignature_.empty())
+    {
+        HRESULT hr = device_->CreateRootSignature(0, desc.rootSignature_.data(), desc.rootSignature_.size(), IID_PPV_ARGS(&state->rootSignature_));
+        if (FAILED(hr))
+        {
+            LOGERROR("Create root signature failed. (HRESULT %x)", hr);
+            delete state;
+            return nullptr;
+        }
+    }
+
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements(desc.inputLayout_.size());
+    for (size_t i = 0; i < inputElements.size(); ++i)
+    {
+        PipelineVertexElement const& element = desc.inputLayout_[i];
+        inputElements[i].SemanticName = element.semantic_.c_str();
+        inputElements[i].SemanticIndex = element.semanticIndex_;
+        inputElements[i].Format = (DXGI_FORMAT) element.format_;
+        inputElements[i].InputSlot = element.inputSlot_;
+        inputElements[i].AlignedByteOffset = element.offset_;
+        inputElements[i].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+        inputElements[i].InstanceDataStepRate = 0;
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
+    ZeroMemory(&psoDesc, sizeof(psoDesc));
+    psoDesc.pRootSignature = state->rootSignature_;
+    psoDesc.VS = { desc.vertexShader_.data(), desc.vertexShader_.size() };
+    psoDesc.PS = { desc.pixelShader_.data(), desc.pixelShader_.size() };
+    psoDesc.BlendState.RenderTarget[0] = GetBlendDesc(desc.blendMode_);
+    for (unsigned i = 1; i < MAX_PIPELINE_RENDER_TARGETS; ++i)
+        psoDesc.BlendState.RenderTarget[i] = psoDesc.BlendState.RenderTarget[0];
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.RasterizerState.FillMode = (D3D12_FILL_MODE) desc.fillMode_;
+    psoDesc.RasterizerState.CullMode = (D3D12_CULL_MODE) desc.cullMode_;
+    psoDesc.RasterizerState.DepthClipEnable = true;
+    psoDesc.RasterizerState.MultisampleEnable = desc.sampleCount_ > 1;
+    psoDesc.DepthStencilState.DepthEnable = desc.depthTest_;
+    psoDesc.DepthStencilState.DepthWriteMask = desc.depthWrite_ ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+    psoDesc.DepthStencilState.DepthFunc = (D3D12_COMPARISON_FUNC) desc.depthFunc_;
+    psoDesc.InputLayout = { inputElements.data(), (UINT) inputElements.size() };
+    psoDesc.PrimitiveTopologyType = (D3D12_PRIMITIVE_TOPOLOGY_TYPE) desc.primitiveTopologyType_;
+    psoDesc.NumRenderTargets = desc.renderTargetCount_;
+    for (unsigned i = 0; i < desc.renderTargetCount_ && i < MAX_PIPELINE_RENDER_TARGETS; ++i)
+        psoDesc.RTVFormats[i] = (DXGI_FORMAT) desc.renderTargetFormats_[i];
+    psoDesc.DSVFormat = (DXGI_FORMAT) desc.depthStencilFormat_;
+    psoDesc.SampleDesc.Count = desc.sampleCount_;
+    psoDesc.CachedPSO = { cachedBlob, cachedBlobSize };
+
+    HRESULT hr = device_->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&state->pipelineState_));
+    if (FAILED(hr))
+    {
+        // A stale cached blob is expected after a driver update, the cache retries without it
+        if (!cachedBlob)
+            LOGERROR("Create pipeline state failed. (HRESULT %x)", hr);
+        ReleasePipelineState(state);
+        return nullptr;
+    }
+
+    return state;
+}
+
+bool D3D12PipelineStateFactory::GetCachedBlob(PipelineStateHandle state, std::vector<uint8_t>& blob)
+{
+    ID3DBlob* cachedBlob = nullptr;
+    HRESULT hr = ((D3D12PipelineState*) state)->pipelineState_->GetCachedBlob(&cachedBlob);
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(cachedBlob);
+        return false;
+    }
+
+    uint8_t const* data = (uint8_t const*) cachedBlob->GetBufferPointer();
+    blob.assign(data, data + cachedBlob->GetBufferSize());
+    D3D_SAFE_RELEASE(cachedBlob);
+    return true;
+}
+
+void D3D12PipelineStateFactory::ReleasePipelineState(PipelineStateHandle state)
+{
+    D3D12PipelineState* d3dState = (D3D12PipelineState*) state;
+    D3D_SAFE_RELEASE(d3dState->pipelineState_);
+    D3D_SAFE_RELEASE(d3dState->rootSignature_);
+    delete d3dState;
+}
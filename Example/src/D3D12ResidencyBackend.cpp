@@ -0,0 +1,79 @@
+#include "D3D12ResidencyBackend.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+D3D12ResidencyBackend::D3D12ResidencyBackend(ID3D12Device* device)
+    : device_(device)
+{
+}
+
+D3D12ResidencyBackend::~D3D12ResidencyBackend()
+{
+    D3D_SAFE_RELEASE(adapter_);
+}
+
+bool D3D12ResidencyBackend::Initialize(IDXGIFactory1* factory)
+{
+    IDXGIFactory4* factory4 = nullptr;
+    HRESULT hr = factory->QueryInterface(IID_PPV_ARGS(&factory4));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(factory4);
+        return false;
+    }
+
+    hr = factory4->EnumAdapterByLuid(device_->GetAdapterLuid(), IID_PPV_ARGS(&adapter_));
+    D3D_SAFE_RELEASE(factory4);
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(adapter_);
+        LOGERROR("Find adapter of the device failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    return true;
+}
+
+bool D3D12ResidencyBackend::QueryVideoMemory(VideoMemoryInfo& info)
+{
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo;
+    HRESULT hr = adapter_->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo);
+    if (FAILED(hr))
+    {
+        LOGERROR("Query video memory info failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    info.budget_ = memoryInfo.Budget;
+    info.usage_ = memoryInfo.CurrentUsage;
+    return true;
+}
+
+bool D3D12ResidencyBackend::MakeResident(ResidencyObject const* objects, unsigned count)
+{
+    GetPageables(objects, count);
+    HRESULT hr = device_->MakeResident(count, pageables_.data());
+    if (FAILED(hr))
+    {
+        LOGERROR("Make resident failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    return true;
+}
+
+void D3D12ResidencyBackend::Evict(ResidencyObject const* objects, unsigned count)
+{
+    GetPageables(objects, count);
+    HRESULT hr = device_->Evict(count, pageables_.data());
+    if (FAILED(hr))
+        LOGERROR("Evict failed. (HRESULT %x)", hr);
+}
+
+void D3D12ResidencyBackend::GetPageables(ResidencyObject const* objects, unsigned count)
+{
+    pageables_.resize(count);
+    for (unsigned i = 0; i < count; ++i)
+        pageables_[i] = (ID3D12Pageable*) objects[i].object_;
+}
@@ -0,0 +1,144 @@
+#include "D3D12TextureUploadSink.h"
+#include "D3D12CommandList.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+#include <algorithm>
+
+
+D3D12TextureUploadSink::D3D12TextureUploadSink(GraphicsImpl& graphics)
+    : graphics_(graphics)
+{
+}
+
+D3D12TextureUploadSink::~D3D12TextureUploadSink()
+{
+    for (auto& pair : allocations_)
+    {
+        graphics_.DeferRelease(pair.first);
+        graphics_.DeferFree(pair.second);
+    }
+}
+
+ResourceHandle D3D12TextureUploadSink::CreateTexture(TextureFileInfo const& info, unsigned firstMip,
+    ResourceHandle oldTexture, unsigned oldFirstMip)
+{
+    ID3D12GraphicsCommandList* commandList = GetCommandList();
+    if (!commandList)
+        return nullptr;
+
+    TextureMipInfo const& mip = info.mips_[firstMip];
+    D3D12_RESOURCE_DESC desc;
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Alignment = 0;
+    desc.Width = mip.width_;
+    desc.Height = mip.height_;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = (UINT16) (info.GetMipCount() - firstMip);
+    desc.Format = (DXGI_FORMAT) info.format_;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    GpuAllocation allocation;
+    ID3D12Resource* texture = graphics_.CreatePlacedResource(desc, D3D12_RESOURCE_STATE_COMMON, nullptr, allocation);
+    if (!texture)
+    {
+        LOGERROR("Create streamed texture failed.");
+        return nullptr;
+    }
+    allocations_[texture] = allocation;
+    graphics_.MarkUsed(allocation);
+
+    if (oldTexture)
+    {
+        auto it = allocations_.find((ID3D12Resource*) oldTexture);
+        if (it != allocations_.end())
+            graphics_.MarkUsed(it->second);
+
+        for (unsigned i = std::max(firstMip, oldFirstMip); i < info.GetMipCount(); ++i)
+        {
+            D3D12_TEXTURE_COPY_LOCATION dest;
+            dest.pResource = texture;
+            dest.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            dest.SubresourceIndex = i - firstMip;
+
+            D3D12_TEXTURE_COPY_LOCATION source;
+            source.pResource = (ID3D12Resource*) oldTexture;
+            source.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            source.SubresourceIndex = i - oldFirstMip;
+
+            commandList->CopyTextureRegion(&dest, 0, 0, 0, &source, nullptr);
+        }
+    }
+
+    return texture;
+}
+
+void D3D12TextureUploadSink::ReleaseTexture(ResourceHandle texture)
+{
+    auto it = allocations_.find((ID3D12Resource*) texture);
+    if (it == allocations_.end())
+        return;
+
+    graphics_.DeferRelease(it->first);
+    graphics_.DeferFree(it->second);
+    allocations_.erase(it);
+}
+
+void D3D12TextureUploadSink::UploadMip(ResourceHandle texture, TextureFileInfo const& info, unsigned firstMip,
+    unsigned mip, UploadAllocation const& staging)
+{
+    ID3D12GraphicsCommandList* commandList = GetCommandList();
+    if (!commandList)
+        return;
+
+    auto it = allocations_.find((ID3D12Resource*) texture);
+    if (it != allocations_.end())
+        graphics_.MarkUsed(it->second);
+
+    // Footprints of block compressed mips cover whole blocks
+    TextureMipInfo const& mipInfo = info.mips_[mip];
+    D3D12_TEXTURE_COPY_LOCATION source;
+    source.pResource = (ID3D12Resource*) staging.resource_;
+    source.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    source.PlacedFootprint.Offset = staging.offset_;
+    source.PlacedFootprint.Footprint.Format = (DXGI_FORMAT) info.format_;
+    source.PlacedFootprint.Footprint.Width = (mipInfo.width_ + info.blockSize_ - 1) / info.blockSize_ * info.blockSize_;
+    source.PlacedFootprint.Footprint.Height = mipInfo.rowCount_ * info.blockSize_;
+    source.PlacedFootprint.Footprint.Depth = 1;
+    source.PlacedFootprint.Footprint.RowPitch = (UINT) mipInfo.GetUploadRowPitch();
+
+    D3D12_TEXTURE_COPY_LOCATION dest;
+    dest.pResource = (ID3D12Resource*) texture;
+    dest.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    dest.SubresourceIndex = mip - firstMip;
+
+    commandList->CopyTextureRegion(&dest, 0, 0, 0, &source, nullptr);
+}
+
+uint64_t D3D12TextureUploadSink::Submit()
+{
+    CommandList* commandList = commandList_;
+    unsigned count = commandList ? 1 : 0;
+    if (commandList)
+        commandList->Close();
+    commandList_ = nullptr;
+
+    // Rendering only uses textures once their copies have completed, so the frame does not wait for them
+    return graphics_.GetScheduler().Submit(GPU_QUEUE_COPY, &commandList, count).value_;
+}
+
+uint64_t D3D12TextureUploadSink::GetCompletedValue()
+{
+    return graphics_.GetScheduler().GetTimeline(GPU_QUEUE_COPY).GetCompletedValue();
+}
+
+ID3D12GraphicsCommandList* D3D12TextureUploadSink::GetCommandList()
+{
+    if (!commandList_)
+        commandList_ = (D3D12CommandList*) graphics_.AcquireCommandList(GPU_QUEUE_COPY);
+
+    return commandList_ ? commandList_->GetCommandList() : nullptr;
+}
@@ -0,0 +1,127 @@
+#include "D3D12TimestampQuerySource.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+D3D12TimestampQuerySource::D3D12TimestampQuerySource(ID3D12Device* device, ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* commandList)
+    : device_(device)
+    , queue_(queue)
+    , commandList_(commandList)
+{
+}
+
+D3D12TimestampQuerySource::~D3D12TimestampQuerySource()
+{
+    Shutdown();
+}
+
+bool D3D12TimestampQuerySource::Initialize(unsigned queryCount)
+{
+    D3D12_QUERY_HEAP_DESC queryHeapDesc;
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = queryCount;
+    queryHeapDesc.NodeMask = 0;
+
+    HRESULT hr = device_->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&queryHeap_));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(queryHeap_);
+        LOGERROR("Create timestamp query heap failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    D3D12_HEAP_PROPERTIES heapProperties;
+    heapProperties.Type = D3D12_HEAP_TYPE_READBACK;
+    heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapProperties.CreationNodeMask = 1;
+    heapProperties.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC resourceDesc;
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    resourceDesc.Alignment = 0;
+    resourceDesc.Width = (uint64_t) queryCount * sizeof(uint64_t);
+    resourceDesc.Height = 1;
+    resourceDesc.DepthOrArraySize = 1;
+    resourceDesc.MipLevels = 1;
+    resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+    resourceDesc.SampleDesc.Count = 1;
+    resourceDesc.SampleDesc.Quality = 0;
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    hr = device_->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&readbackBuffer_));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(readbackBuffer_);
+        D3D_SAFE_RELEASE(queryHeap_);
+        LOGERROR("Create timestamp readback buffer failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    return true;
+}
+
+void D3D12TimestampQuerySource::Shutdown()
+{
+    D3D_SAFE_RELEASE(readbackBuffer_);
+    D3D_SAFE_RELEASE(queryHeap_);
+}
+
+uint64_t D3D12TimestampQuerySource::GetFrequency() const
+{
+    UINT64 frequency = 0;
+    if (FAILED(queue_->GetTimestampFrequency(&frequency)) || !frequency)
+        return 1;
+    return frequency;
+}
+
+bool D3D12TimestampQuerySource::GetClockCalibration(uint64_t& gpuTimestamp, uint64_t& cpuTicks)
+{
+    // The calibration's CPU time is a performance counter value, bracket the call with profiler ticks
+    // instead and take the middle, which is off by at most half the call's duration
+    UINT64 gpu, cpu;
+    uint64_t before = Profiler::GetTicks();
+    HRESULT hr = queue_->GetClockCalibration(&gpu, &cpu);
+    uint64_t after = Profiler::GetTicks();
+    if (FAILED(hr))
+    {
+        LOGERROR("Get clock calibration failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    gpuTimestamp = gpu;
+    cpuTicks = before + (after - before) / 2;
+    return true;
+}
+
+void D3D12TimestampQuerySource::EndQuery(unsigned index)
+{
+    commandList_->EndQuery(queryHeap_, D3D12_QUERY_TYPE_TIMESTAMP, index);
+}
+
+void D3D12TimestampQuerySource::ResolveQueries(unsigned first, unsigned count)
+{
+    commandList_->ResolveQueryData(queryHeap_, D3D12_QUERY_TYPE_TIMESTAMP, first, count, readbackBuffer_,
+        (uint64_t) first * sizeof(uint64_t));
+}
+
+bool D3D12TimestampQuerySource::ReadQueries(unsigned first, unsigned count, uint64_t* timestamps)
+{
+    // Map only the range read, the CPU writes nothing back
+    D3D12_RANGE readRange = { first * sizeof(uint64_t), (first + count) * sizeof(uint64_t) };
+    void* data = nullptr;
+    HRESULT hr = readbackBuffer_->Map(0, &readRange, &data);
+    if (FAILED(hr))
+    {
+        LOGERROR("Map timestamp readback buffer failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    memcpy(timestamps, (uint8_t*) data + readRange.Begin, count * sizeof(uint64_t));
+
+    D3D12_RANGE writtenRange = { 0, 0 };
+    readbackBuffer_->Unmap(0, &writtenRange);
+    return true;
+}
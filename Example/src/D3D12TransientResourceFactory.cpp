@@ -0,0 +1,93 @@
+
+#include "D3D12TransientResourceFactory.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+static D3D12_RESOURCE_DESC GetResourceDesc(TextureDesc const& desc)
+{
+    D3D12_RESOURCE_DESC resourceDesc;
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    resourceDesc.Alignment = 0;
+    resourceDesc.Width = desc.width_;
+    resourceDesc.Height = desc.height_;
+    resourceDesc.DepthOrArraySize = 1;
+    resourceDesc.MipLevels = 1;
+    resourceDesc.Format = (DXGI_FORMAT) desc.format_;
+    resourceDesc.SampleDesc.Count = desc.sampleCount_;
+    resourceDesc.SampleDesc.Quality = 0;
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    if (desc.usage_ & TEXTURE_USAGE_RENDER_TARGET)
+        resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    if (desc.usage_ & TEXTURE_USAGE_DEPTH_STENCIL)
+        resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+    if (desc.usage_ & TEXTURE_USAGE_UNORDERED_ACCESS)
+        resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    return resourceDesc;
+}
+
+D3D12TransientResourceFactory::D3D12TransientResourceFactory(GraphicsImpl& graphics)
+    : TransientResourceFactory(graphics.GetStateRegistry())
+    , graphics_(graphics)
+{
+}
+
+D3D12TransientResourceFactory::~D3D12TransientResourceFactory()
+{
+    ReleaseAll();
+}
+
+void D3D12TransientResourceFactory::GetAllocationInfo(TextureDesc const& desc, uint64_t& size, uint64_t& alignment)
+{
+    D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(desc);
+    D3D12_RESOURCE_ALLOCATION_INFO info = graphics_.GetDevice()->GetResourceAllocationInfo(0, 1, &resourceDesc);
+
+    size = info.SizeInBytes;
+    alignment = info.Alignment;
+}
+
+bool D3D12TransientResourceFactory::CreateHeap(uint64_t size)
+{
+    heap_ = graphics_.GetHeapAllocator().Allocate(GPU_HEAP_RENDER_TARGETS, size,
+        D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+    if (!heap_.IsValid())
+    {
+        LOGERROR("Create transient heap failed.");
+        return false;
+    }
+
+    return true;
+}
+
+void D3D12TransientResourceFactory::ReleaseHeap()
+{
+    graphics_.DeferFree(heap_);
+}
+
+ResourceHandle D3D12TransientResourceFactory::CreateTexture(TextureDesc const& desc, uint64_t offset, unsigned initialState)
+{
+    if (!heap_.IsValid())
+        return nullptr;
+
+    D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(desc);
+
+    ID3D12Resource* texture = nullptr;
+    HRESULT hr = graphics_.GetDevice()->CreatePlacedResource((ID3D12Heap*) heap_.heap_, heap_.offset_ + offset,
+        &resourceDesc, (D3D12_RESOURCE_STATES) initialState, nullptr, IID_PPV_ARGS(&texture));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(texture);
+        LOGERROR("Create transient texture failed. (HRESULT %x)", hr);
+        return nullptr;
+    }
+
+    return texture;
+}
+
+void D3D12TransientResourceFactory::ReleaseTexture(ResourceHandle texture)
+{
+    graphics_.DeferRelease((ID3D12Resource*) texture);
+}
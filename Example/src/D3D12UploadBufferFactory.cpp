@@ -0,0 +1,69 @@
+
+#include "D3D12UploadBufferFactory.h"
+#include "GraphicsImpl.h"
+#include "Common.h"
+
+
+D3D12UploadBufferFactory::D3D12UploadBufferFactory(ID3D12Device* device)
+    : device_(device)
+{
+}
+
+bool D3D12UploadBufferFactory::CreateBuffer(uint64_t size, UploadBufferInfo& info)
+{
+    D3D12_HEAP_PROPERTIES heapProperties;
+    heapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
+    heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapProperties.CreationNodeMask = 1;
+    heapProperties.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC resourceDesc;
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    resourceDesc.Alignment = 0;
+    resourceDesc.Width = size;
+    resourceDesc.Height = 1;
+    resourceDesc.DepthOrArraySize = 1;
+    resourceDesc.MipLevels = 1;
+    resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+    resourceDesc.SampleDesc.Count = 1;
+    resourceDesc.SampleDesc.Quality = 0;
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    ID3D12Resource* buffer = nullptr;
+    HRESULT hr = device_->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&buffer));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(buffer);
+        LOGERROR("Create upload buffer failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    // The CPU never reads back, an empty read range avoids the cost of making the memory coherent
+    D3D12_RANGE readRange = { 0, 0 };
+    void* data = nullptr;
+    hr = buffer->Map(0, &readRange, &data);
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(buffer);
+        LOGERROR("Map upload buffer failed. (HRESULT %x)", hr);
+        return false;
+    }
+
+    info.resource_ = buffer;
+    info.cpu_ = (uint8_t*) data;
+    info.gpu_ = buffer->GetGPUVirtualAddress();
+    info.size_ = size;
+    return true;
+}
+
+void D3D12UploadBufferFactory::DestroyBuffer(UploadBufferInfo& info)
+{
+    ID3D12Resource* buffer = (ID3D12Resource*) info.resource_;
+    if (buffer)
+        buffer->Unmap(0, nullptr);
+    D3D_SAFE_RELEASE(buffer);
+    info = UploadBufferInfo();
+}
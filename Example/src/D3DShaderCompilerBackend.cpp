@@ -0,0 +1,39 @@
+#include "D3DShaderCompilerBackend.h"
+#include "GraphicsImpl.h"
+
+
+D3DShaderCompilerBackend::D3DShaderCompilerBackend(unsigned flags)
+    : flags_(flags)
+{
+}
+
+uint64_t D3DShaderCompilerBackend::GetVersion() const
+{
+    return ((uint64_t) D3D_COMPILER_VERSION << 32) | flags_;
+}
+
+bool D3DShaderCompilerBackend::Compile(std::string const& source, ShaderCompileDesc const& desc, std::vector<uint8_t>& bytecode, std::string& messages)
+{
+    std::vector<D3D_SHADER_MACRO> macros;
+    for (ShaderDefine const& define : desc.defines_)
+        macros.push_back({ define.name_.c_str(), define.value_.c_str() });
+    macros.push_back({ nullptr, nullptr });
+
+    ID3DBlob* code = nullptr;
+    ID3DBlob* errors = nullptr;
+    HRESULT hr = D3DCompile(source.data(), source.size(), desc.fileName_.c_str(), macros.data(), nullptr,
+        desc.entryPoint_.c_str(), desc.profile_.c_str(), flags_, 0, &code, &errors);
+
+    if (errors)
+        messages += (char const*) errors->GetBufferPointer();
+
+    if (SUCCEEDED(hr))
+    {
+        uint8_t const* data = (uint8_t const*) code->GetBufferPointer();
+        bytecode.assign(data, data + code->GetBufferSize());
+    }
+
+    D3D_SAFE_RELEASE(code);
+    D3D_SAFE_RELEASE(errors);
+    return SUCCEEDED(hr);
+}
@@ -0,0 +1,56 @@
+
+#include "DeferredReleaseQueue.h"
+
+
+DeferredReleaseQueue::DeferredReleaseQueue() = default;
+
+DeferredReleaseQueue::~DeferredReleaseQueue()
+{
+    ReleaseAll();
+}
+
+void DeferredReleaseQueue::Retire(void* object, ReleaseFunction release, uint64_t fenceValue, uint64_t bytes)
+{
+    if (!object)
+        return;
+
+    entries_.push_back({ object, release, fenceValue, bytes });
+    pendingBytes_ += bytes;
+}
+
+unsigned DeferredReleaseQueue::ReleaseCompleted(uint64_t completedValue)
+{
+    // Fence values are retired in increasing order, an out of order entry is held back by the ones before it
+    unsigned released = 0;
+    while (!entries_.empty() && entries_.front().fenceValue_ <= completedValue)
+    {
+        ReleaseFront();
+        ++released;
+    }
+
+    return released;
+}
+
+unsigned DeferredReleaseQueue::ReleaseAll()
+{
+    unsigned released = 0;
+    while (!entries_.empty())
+    {
+        ReleaseFront();
+        ++released;
+    }
+
+    return released;
+}
+
+void DeferredReleaseQueue::ReleaseFront()
+{
+    Entry entry = entries_.front();
+    entries_.pop_front();
+
+    pendingBytes_ -= entry.bytes_;
+    ++releasedCount_;
+    releasedBytes_ += entry.bytes_;
+
+    entry.release_(entry.object_);
+}
@@ -0,0 +1,232 @@
+
+#include "DescriptorAllocator.h"
+
+#include <cassert>
+
+
+StagingDescriptorHeap::StagingDescriptorHeap(DescriptorHeapFactory& factory, DescriptorHeapType type, unsigned pageSize)
+    : factory_(factory)
+    , type_(type)
+    , pageSize_(pageSize)
+{
+}
+
+StagingDescriptorHeap::~StagingDescriptorHeap()
+{
+    for (Page& page : pages_)
+        factory_.DestroyHeap(page.info_);
+}
+
+DescriptorAllocation StagingDescriptorHeap::Allocate()
+{
+    DescriptorAllocation allocation;
+
+    if (availablePages_.empty() && !AddPage())
+        return allocation;
+
+    unsigned pageIndex = availablePages_.back();
+    Page& page = pages_[pageIndex];
+
+    allocation.page_ = pageIndex;
+    allocation.index_ = page.freeIndices_.back();
+    allocation.cpu_ = page.info_.cpuStart_ + (size_t) allocation.index_ * page.info_.increment_;
+    page.freeIndices_.pop_back();
+
+    if (page.freeIndices_.empty())
+    {
+        page.available_ = false;
+        availablePages_.pop_back();
+    }
+
+    ++allocatedCount_;
+    return allocation;
+}
+
+void StagingDescriptorHeap::Free(DescriptorAllocation& allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    assert(allocation.page_ < pages_.size());
+
+    Page& page = pages_[allocation.page_];
+    page.freeIndices_.push_back(allocation.index_);
+
+    if (!page.available_)
+    {
+        page.available_ = true;
+        availablePages_.push_back(allocation.page_);
+    }
+
+    --allocatedCount_;
+    allocation = DescriptorAllocation();
+}
+
+float StagingDescriptorHeap::GetUtilization() const
+{
+    return pages_.empty() ? 0.0f : (float) allocatedCount_ / ((float) pages_.size() * pageSize_);
+}
+
+bool StagingDescriptorHeap::AddPage()
+{
+    Page page;
+    if (!factory_.CreateHeap(type_, pageSize_, false, page.info_))
+        return false;
+
+    // Push indices in reverse so a fresh page hands out ascending addresses
+    page.freeIndices_.reserve(pageSize_);
+    for (unsigned i = pageSize_; i-- > 0;)
+        page.freeIndices_.push_back(i);
+    page.available_ = true;
+
+    availablePages_.push_back((unsigned) pages_.size());
+    pages_.push_back(std::move(page));
+    return true;
+}
+
+DescriptorRing::DescriptorRing(DescriptorHeapFactory& factory, DescriptorHeapType type, unsigned capacity)
+    : factory_(factory)
+{
+    if (!factory_.CreateHeap(type, capacity, true, info_))
+        info_ = DescriptorHeapInfo();
+}
+
+DescriptorRing::~DescriptorRing()
+{
+    if (IsValid())
+        factory_.DestroyHeap(info_);
+}
+
+DescriptorTable DescriptorRing::Allocate(unsigned count)
+{
+    DescriptorTable table;
+    unsigned capacity = info_.capacity_;
+
+    if (!count || count > capacity)
+    {
+        ++overflowCount_;
+        return table;
+    }
+
+    // Tables must be contiguous, so skip the tail end of the heap when the table does not fit before it
+    unsigned skipped = head_ + count > capacity ? capacity - head_ : 0;
+    if (usedCount_ + skipped + count > capacity)
+    {
+        ++overflowCount_;
+        return table;
+    }
+
+    if (skipped)
+        head_ = 0;
+
+    table.cpu_ = info_.cpuStart_ + (size_t) head_ * info_.increment_;
+    table.gpu_ = info_.gpuStart_ + (uint64_t) head_ * info_.increment_;
+    table.count_ = count;
+
+    head_ = (head_ + count) % capacity;
+    usedCount_ += skipped + count;
+    frameCount_ += skipped + count;
+    if (usedCount_ > peakUsedCount_)
+        peakUsedCount_ = usedCount_;
+
+    return table;
+}
+
+void DescriptorRing::EndFrame(uint64_t fenceValue)
+{
+    if (frameCount_)
+        frames_.push_back({ fenceValue, frameCount_ });
+    frameCount_ = 0;
+}
+
+void DescriptorRing::Reclaim(uint64_t completedValue)
+{
+    while (!frames_.empty() && frames_.front().fenceValue_ <= completedValue)
+    {
+        usedCount_ -= frames_.front().count_;
+        frames_.pop_front();
+    }
+}
+
+DescriptorAllocator::DescriptorAllocator() = default;
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+    Shutdown();
+}
+
+bool DescriptorAllocator::Initialize(DescriptorHeapFactory& factory, unsigned ringCapacity, unsigned pageSize)
+{
+    factory_ = &factory;
+
+    for (unsigned i = 0; i < MAX_DESCRIPTOR_HEAP_TYPES; ++i)
+        stagingHeaps_[i].reset(new StagingDescriptorHeap(factory, (DescriptorHeapType) i, pageSize));
+
+    ring_.reset(new DescriptorRing(factory, DESCRIPTOR_HEAP_CBV_SRV_UAV, ringCapacity));
+    if (!ring_->IsValid())
+    {
+        ring_.reset();
+        return false;
+    }
+
+    return true;
+}
+
+void DescriptorAllocator::Shutdown()
+{
+    ring_.reset();
+    for (unsigned i = 0; i < MAX_DESCRIPTOR_HEAP_TYPES; ++i)
+        stagingHeaps_[i].reset();
+}
+
+DescriptorAllocation DescriptorAllocator::Allocate(DescriptorHeapType type)
+{
+    return stagingHeaps_[type]->Allocate();
+}
+
+void DescriptorAllocator::Free(DescriptorHeapType type, DescriptorAllocation& allocation)
+{
+    stagingHeaps_[type]->Free(allocation);
+}
+
+DescriptorTable DescriptorAllocator::CopyToTable(size_t const* sources, unsigned count)
+{
+    DescriptorTable table = ring_->Allocate(count);
+    if (!table.IsValid())
+        return table;
+
+    // Coalesce adjacent sources so views allocated together are copied as one range
+    unsigned increment = ring_->GetHeapInfo().increment_;
+    rangeStarts_.clear();
+    rangeSizes_.clear();
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (!rangeStarts_.empty() && rangeStarts_.back() + (size_t) rangeSizes_.back() * increment == sources[i])
+            ++rangeSizes_.back();
+        else
+        {
+            rangeStarts_.push_back(sources[i]);
+            rangeSizes_.push_back(1);
+        }
+    }
+
+    factory_->CopyDescriptors(DESCRIPTOR_HEAP_CBV_SRV_UAV, table.cpu_, (unsigned) rangeStarts_.size(),
+        rangeStarts_.data(), rangeSizes_.data());
+
+    ++stats_.tables_;
+    stats_.descriptors_ += count;
+    stats_.ranges_ += (unsigned) rangeStarts_.size();
+    return table;
+}
+
+void DescriptorAllocator::BeginFrame(uint64_t completedValue)
+{
+    ring_->Reclaim(completedValue);
+    stats_ = DescriptorStats();
+}
+
+void DescriptorAllocator::EndFrame(uint64_t fenceValue)
+{
+    ring_->EndFrame(fenceValue);
+}
@@ -0,0 +1,138 @@
+
+#include "FenceTimeline.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+FenceTimeline::FenceTimeline() = default;
+
+FenceTimeline::~FenceTimeline() = default;
+
+void FenceTimeline::SetFence(GpuFence* fence)
+{
+    fence_ = fence;
+    completedValue_ = fence_ ? fence_->GetCompletedValue() : 0;
+    if (completedValue_ > lastSignaledValue_)
+        lastSignaledValue_ = completedValue_;
+}
+
+uint64_t FenceTimeline::Signal()
+{
+    assert(fence_);
+
+    ++lastSignaledValue_;
+    fence_->Signal(lastSignaledValue_);
+    return lastSignaledValue_;
+}
+
+uint64_t FenceTimeline::GetCompletedValue()
+{
+    uint64_t value = fence_->GetCompletedValue();
+
+    // Only ever move the cache forward, a concurrent caller may have stored a newer value
+    uint64_t cached = completedValue_.load();
+    while (value > cached && !completedValue_.compare_exchange_weak(cached, value))
+        ;
+
+    return value > cached ? value : cached;
+}
+
+bool FenceTimeline::IsComplete(uint64_t value)
+{
+    if (value <= completedValue_.load())
+        return true;
+
+    return value <= GetCompletedValue();
+}
+
+void FenceTimeline::Wait(uint64_t value)
+{
+    assert(value <= lastSignaledValue_);
+
+    if (!IsComplete(value))
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        std::unique_ptr<WaitEvent> event = AcquireWaitEvent();
+        fence_->SetEventOnCompletion(value, *event);
+        event->Wait();
+        ReleaseWaitEvent(std::move(event));
+
+        GetCompletedValue();
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        waitTime_ += std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        ++blockingWaitCount_;
+    }
+
+    Poll();
+}
+
+void FenceTimeline::Flush()
+{
+    Wait(Signal());
+}
+
+void FenceTimeline::OnCompletion(uint64_t value, std::function<void()> callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Sync points are mostly registered in increasing order, so this is usually an append
+    auto it = std::upper_bound(callbacks_.begin(), callbacks_.end(), value,
+        [](uint64_t lhs, Callback const& rhs) { return lhs < rhs.value_; });
+    callbacks_.insert(it, Callback{ value, std::move(callback) });
+}
+
+unsigned FenceTimeline::Poll()
+{
+    std::vector<std::function<void()> > ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (callbacks_.empty())
+            return 0;
+
+        uint64_t completed = completedValue_.load();
+        if (callbacks_.front().value_ > completed)
+            completed = GetCompletedValue();
+
+        while (!callbacks_.empty() && callbacks_.front().value_ <= completed)
+        {
+            ready.push_back(std::move(callbacks_.front().function_));
+            callbacks_.pop_front();
+        }
+    }
+
+    // Run outside the lock so callbacks may register further callbacks
+    for (auto& function : ready)
+        function();
+
+    return (unsigned) ready.size();
+}
+
+unsigned FenceTimeline::GetPendingCallbackCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (unsigned) callbacks_.size();
+}
+
+std::unique_ptr<WaitEvent> FenceTimeline::AcquireWaitEvent()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (freeEvents_.empty())
+    {
+        ++waitEventCount_;
+        return std::unique_ptr<WaitEvent>(new WaitEvent());
+    }
+
+    std::unique_ptr<WaitEvent> event = std::move(freeEvents_.back());
+    freeEvents_.pop_back();
+    return event;
+}
+
+void FenceTimeline::ReleaseWaitEvent(std::unique_ptr<WaitEvent> event)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    freeEvents_.push_back(std::move(event));
+}
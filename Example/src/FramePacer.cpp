@@ -0,0 +1,66 @@
+
+#include "FramePacer.h"
+
+
+FramePacer::FramePacer(unsigned framesInFlight)
+{
+    SetFramesInFlight(framesInFlight);
+}
+
+void FramePacer::SetFramesInFlight(unsigned count)
+{
+    if (count < 1)
+        count = 1;
+    if (count > MaxFramesInFlight)
+        count = MaxFramesInFlight;
+
+    // Slot mapping changes with the count, so every slot conservatively waits for the newest submitted frame
+    uint64_t lastValue = 0;
+    for (unsigned i = 0; i < MaxFramesInFlight; ++i)
+    {
+        if (frameFenceValues_[i] > lastValue)
+            lastValue = frameFenceValues_[i];
+    }
+
+    for (unsigned i = 0; i < MaxFramesInFlight; ++i)
+        frameFenceValues_[i] = lastValue;
+
+    framesInFlight_ = count;
+}
+
+unsigned FramePacer::BeginFrame(FenceTimeline& timeline)
+{
+    frameIndex_ = (unsigned) (frameNumber_ % framesInFlight_);
+
+    uint64_t waitValue = frameFenceValues_[frameIndex_];
+    if (!timeline.IsComplete(waitValue))
+    {
+        ++stallCount_;
+        timeline.Wait(waitValue);
+    }
+
+    return frameIndex_;
+}
+
+void FramePacer::EndFrame(uint64_t fenceValue)
+{
+    frameFenceValues_[frameIndex_] = fenceValue;
+    ++frameNumber_;
+}
+
+void FramePacer::ExtendFrame(uint64_t fenceValue)
+{
+    frameFenceValues_[frameIndex_] = fenceValue;
+}
+
+void FramePacer::WaitIdle(FenceTimeline& timeline)
+{
+    uint64_t lastValue = 0;
+    for (unsigned i = 0; i < MaxFramesInFlight; ++i)
+    {
+        if (frameFenceValues_[i] > lastValue)
+            lastValue = frameFenceValues_[i];
+    }
+
+    timeline.Wait(lastValue);
+}
@@ -0,0 +1,88 @@
+#include "FramePipeline.h"
+#include "Profiler.h"
+
+#include <cassert>
+
+
+FramePipeline::FramePipeline() = default;
+
+FramePipeline::~FramePipeline()
+{
+    Stop();
+}
+
+void FramePipeline::Start(SimulateFunction const& simulate)
+{
+    assert(!IsRunning());
+
+    stopping_ = false;
+    for (FramePacket& packet : packets_)
+        freePackets_.Push(&packet);
+
+    thread_ = std::thread(&FramePipeline::ThreadFunction, this, simulate);
+}
+
+void FramePipeline::Stop()
+{
+    if (!IsRunning())
+        return;
+
+    stopping_ = true;
+    freeEvent_.Set();
+    thread_.join();
+
+    // Both queues are single-threaded again
+    FramePacket* packet;
+    while (freePackets_.Pop(packet))
+        ;
+    while (readyPackets_.Pop(packet))
+        ;
+}
+
+FramePacket const* FramePipeline::AcquirePacket()
+{
+    FramePacket* packet;
+    while (!readyPackets_.Pop(packet))
+    {
+        if (!IsRunning())
+            return nullptr;
+
+        ++renderWaits_;
+        readyEvent_.Wait();
+    }
+
+    return packet;
+}
+
+void FramePipeline::ReleasePacket(FramePacket const* packet)
+{
+    freePackets_.Push(const_cast<FramePacket*>(packet));
+    freeEvent_.Set();
+}
+
+void FramePipeline::ThreadFunction(SimulateFunction simulate)
+{
+    Profiler::Get().SetThreadName("Simulation");
+
+    for (;;)
+    {
+        FramePacket* packet;
+        while (!freePackets_.Pop(packet))
+        {
+            if (stopping_)
+                return;
+
+            simulationWaits_.fetch_add(1, std::memory_order_relaxed);
+            freeEvent_.Wait();
+        }
+
+        if (stopping_)
+            return;
+
+        simulate(*packet);
+
+        // Never full, there are fewer packets than slots
+        readyPackets_.Push(packet);
+        readyEvent_.Set();
+    }
+}
@@ -0,0 +1,97 @@
+#include "FrameTimer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+
+int64_t SteadyFrameClock::GetMicroseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SteadyFrameClock::SleepUntil(int64_t microseconds)
+{
+    int64_t remaining = microseconds - GetMicroseconds();
+    if (remaining > SpinMargin)
+        std::this_thread::sleep_for(std::chrono::microseconds(remaining - SpinMargin));
+
+    while (GetMicroseconds() < microseconds)
+        std::this_thread::yield();
+}
+
+void VirtualFrameClock::SleepUntil(int64_t microseconds)
+{
+    if (microseconds <= time_)
+        return;
+
+    sleepTime_ += microseconds - time_;
+    ++sleepCount_;
+    time_ = microseconds;
+}
+
+FrameTimer::FrameTimer(FrameClock& clock)
+    : clock_(clock)
+{
+    Reset();
+}
+
+void FrameTimer::SetTimestep(int64_t microseconds)
+{
+    assert(microseconds > 0);
+    timestep_ = microseconds;
+    accumulator_ = std::min(accumulator_, timestep_ - 1);
+}
+
+void FrameTimer::SetMaxSteps(unsigned steps)
+{
+    maxSteps_ = std::max(steps, 1u);
+}
+
+void FrameTimer::SetFrameRateLimit(unsigned framesPerSecond)
+{
+    frameRateLimit_ = framesPerSecond;
+    nextFrameTime_ = clock_.GetMicroseconds();
+}
+
+void FrameTimer::Reset()
+{
+    lastTime_ = clock_.GetMicroseconds();
+    nextFrameTime_ = lastTime_;
+    accumulator_ = 0;
+}
+
+unsigned FrameTimer::BeginFrame()
+{
+    int64_t now = clock_.GetMicroseconds();
+
+    if (frameRateLimit_)
+    {
+        int64_t interval = 1000000 / frameRateLimit_;
+        if (now < nextFrameTime_)
+        {
+            clock_.SleepUntil(nextFrameTime_);
+            now = clock_.GetMicroseconds();
+        }
+
+        // Keep the cadence across small overshoots, restart it after a long frame instead of catching up
+        nextFrameTime_ = now - nextFrameTime_ < interval ? nextFrameTime_ + interval : now + interval;
+    }
+
+    frameTime_ = now - lastTime_;
+    lastTime_ = now;
+    accumulator_ += frameTime_;
+    ++frameCount_;
+
+    int64_t steps = accumulator_ / timestep_;
+    accumulator_ -= steps * timestep_;
+    if (steps > maxSteps_)
+    {
+        droppedTime_ += (steps - maxSteps_) * timestep_;
+        steps = maxSteps_;
+    }
+
+    stepCount_ += steps;
+    return (unsigned) steps;
+}
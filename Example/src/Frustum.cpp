@@ -0,0 +1,43 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+
+Frustum::Frustum(Matrix4 const& viewProjection)
+{
+    // A point is inside when its clip coordinates satisfy -w <= x <= w, -w <= y <= w and 0 <= z <= w. With
+    // row vectors the clip coordinates are dot products with the columns of the matrix.
+    Matrix4 columns = viewProjection.Transposed();
+    Vector4 x = columns.rows_[0], y = columns.rows_[1], z = columns.rows_[2], w = columns.rows_[3];
+    Vector4 planes[PlaneCount] = { w + x, w - x, w + y, w - y, z, w - z };
+
+    for (unsigned i = 0; i < PlaneCount; ++i)
+    {
+        Vector3 normal = planes[i].ToVector3();
+        float length = normal.Length();
+        float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        planes_[i].normal_ = normal * scale;
+        planes_[i].d_ = planes[i].w_ * scale;
+    }
+}
+
+bool Frustum::IsVisible(BoundingSphere const& sphere) const
+{
+    for (Plane const& plane : planes_)
+    {
+        if (plane.Distance(sphere.center_) <= -sphere.radius_)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::IsVisible(BoundingBox const& box) const
+{
+    // The box reaches furthest along a normal by its extents projected on the absolute normal
+    for (Plane const& plane : planes_)
+    {
+        if (plane.Distance(box.center_) + plane.normal_.Abs().Dot(box.extents_) <= 0.0f)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,162 @@
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+
+#include <cassert>
+#include <cstring>
+
+
+/// Return number of set bits of a lane mask.
+static unsigned CountLanes(unsigned mask)
+{
+    unsigned count = 0;
+    for (; mask; mask &= mask - 1)
+        ++count;
+    return count;
+}
+
+FrustumCuller::FrustumCuller() = default;
+
+void FrustumCuller::Resize(unsigned count)
+{
+    spheres_.Resize(count);
+    boxes_.Resize(count);
+}
+
+void FrustumCuller::SetBounds(unsigned index, BoundingSphere const& sphere, BoundingBox const& box)
+{
+    spheres_.Set(index, sphere);
+    boxes_.Set(index, box);
+}
+
+unsigned FrustumCuller::Cull(Frustum const& frustum, std::vector<unsigned>& visible)
+{
+    unsigned count = GetObjectCount();
+    visible.resize(count);
+    stats_ = CullStats();
+    stats_.objects_ = count;
+
+    unsigned batchCount = (count + batchSize_ - 1) / batchSize_;
+    batches_.resize(batchCount);
+    if (!jobSystem_ || batchCount <= 1)
+    {
+        if (count)
+            batches_[0] = CullRange(frustum, 0, count, visible.data());
+    }
+    else
+    {
+        jobSystem_->ParallelFor(count, batchSize_, [&](unsigned begin, unsigned end)
+        {
+            batches_[begin / batchSize_] = CullRange(frustum, begin, end, visible.data());
+        });
+        stats_.jobs_ = batchCount;
+    }
+
+    // Batches wrote from their first index on, move them together
+    unsigned visibleCount = 0;
+    for (unsigned i = 0; i < batchCount; ++i)
+    {
+        BatchResult const& batch = batches_[i];
+        if (visibleCount != i * batchSize_)
+            memmove(visible.data() + visibleCount, visible.data() + i * batchSize_, batch.visible_ * sizeof(unsigned));
+        visibleCount += batch.visible_;
+        stats_.sphereCulled_ += batch.sphereCulled_;
+        stats_.boxCulled_ += batch.boxCulled_;
+    }
+
+    visible.resize(visibleCount);
+    stats_.visible_ = visibleCount;
+    return visibleCount;
+}
+
+unsigned FrustumCuller::CullReference(Frustum const& frustum, std::vector<unsigned>& visible) const
+{
+    visible.clear();
+    for (unsigned i = 0; i < GetObjectCount(); ++i)
+    {
+        if (frustum.IsVisible(spheres_.Get(i)) && frustum.IsVisible(boxes_.Get(i)))
+            visible.push_back(i);
+    }
+    return (unsigned) visible.size();
+}
+
+void FrustumCuller::GetBoxes(std::vector<unsigned> const& indices, BoundsArray& dest) const
+{
+    unsigned count = (unsigned) indices.size();
+    dest.Resize(count);
+    for (unsigned s = 0; s < BoundsArray::ElementCount; ++s)
+    {
+        float const* src = boxes_.GetStream(s);
+        float* out = dest.GetStream(s);
+        for (unsigned i = 0; i < count; ++i)
+            out[i] = src[indices[i]];
+    }
+}
+
+FrustumCuller::BatchResult FrustumCuller::CullRange(Frustum const& frustum, unsigned begin, unsigned end, unsigned* visible) const
+{
+    // Planes as streams of components to splat from, the absolute normals project box extents
+    float nx[Frustum::PlaneCount], ny[Frustum::PlaneCount], nz[Frustum::PlaneCount], nd[Frustum::PlaneCount];
+    float ax[Frustum::PlaneCount], ay[Frustum::PlaneCount], az[Frustum::PlaneCount];
+    for (unsigned p = 0; p < Frustum::PlaneCount; ++p)
+    {
+        Plane const& plane = frustum.GetPlane(p);
+        nx[p] = plane.normal_.x_;
+        ny[p] = plane.normal_.y_;
+        nz[p] = plane.normal_.z_;
+        nd[p] = plane.d_;
+        ax[p] = std::fabs(nx[p]);
+        ay[p] = std::fabs(ny[p]);
+        az[p] = std::fabs(nz[p]);
+    }
+
+    float const* s[SphereArray::ElementCount];
+    float const* b[BoundsArray::ElementCount];
+    spheres_.GetStreams(s);
+    boxes_.GetStreams(b);
+
+    BatchResult result{};
+    unsigned* dest = visible + begin;
+    ForEachLanes(begin, end - begin, [&](unsigned i, auto lane)
+    {
+        typedef decltype(lane) F;
+        unsigned const allLanes = (1u << F::Width) - 1;
+
+        // A sphere is outside when its center is further than its radius behind any plane
+        F x = F::Load(s[0] + i), y = F::Load(s[1] + i), z = F::Load(s[2] + i);
+        F negRadius = F::Splat(0.0f) - F::Load(s[3] + i);
+        unsigned mask = allLanes;
+        for (unsigned p = 0; p < Frustum::PlaneCount; ++p)
+        {
+            F distance = MulAdd(x, F::Splat(nx[p]), MulAdd(y, F::Splat(ny[p]), MulAdd(z, F::Splat(nz[p]), F::Splat(nd[p]))));
+            mask &= GreaterMask(distance, negRadius);
+        }
+        unsigned sphereMask = mask;
+
+        // A box is outside when even its corner furthest along a normal is behind the plane
+        if (mask)
+        {
+            x = F::Load(b[0] + i);
+            y = F::Load(b[1] + i);
+            z = F::Load(b[2] + i);
+            F ex = F::Load(b[3] + i), ey = F::Load(b[4] + i), ez = F::Load(b[5] + i);
+            for (unsigned p = 0; p < Frustum::PlaneCount && mask; ++p)
+            {
+                F distance = MulAdd(x, F::Splat(nx[p]), MulAdd(y, F::Splat(ny[p]), MulAdd(z, F::Splat(nz[p]), F::Splat(nd[p]))));
+                F reach = MulAdd(ex, F::Splat(ax[p]), MulAdd(ey, F::Splat(ay[p]), ez * F::Splat(az[p])));
+                mask &= GreaterMask(distance + reach, F::Splat(0.0f));
+            }
+        }
+
+        // Write every lane and advance past the visible ones only, which stays within [begin, end)
+        for (unsigned l = 0; l < F::Width; ++l)
+        {
+            dest[result.visible_] = i + l;
+            result.visible_ += (mask >> l) & 1;
+        }
+        unsigned sphereVisible = CountLanes(sphereMask);
+        result.sphereCulled_ += F::Width - sphereVisible;
+        result.boxCulled_ += sphereVisible - CountLanes(mask);
+    });
+
+    return result;
+}
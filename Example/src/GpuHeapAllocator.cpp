@@ -0,0 +1,162 @@
+
+#include "GpuHeapAllocator.h"
+#include "ResidencyManager.h"
+
+#include <cassert>
+
+
+GpuHeapAllocator::GpuHeapAllocator() = default;
+
+GpuHeapAllocator::~GpuHeapAllocator()
+{
+    Shutdown();
+}
+
+void GpuHeapAllocator::Initialize(GpuHeapFactory& factory, uint64_t blockSize)
+{
+    factory_ = &factory;
+    blockSize_ = blockSize;
+}
+
+void GpuHeapAllocator::Shutdown()
+{
+    for (unsigned i = 0; i < MAX_GPU_HEAP_CATEGORIES; ++i)
+    {
+        for (auto& block : blocks_[i])
+        {
+            if (block)
+                DestroyBlock(*block);
+        }
+        blocks_[i].clear();
+    }
+}
+
+GpuAllocation GpuHeapAllocator::Allocate(GpuHeapCategory category, uint64_t size, uint64_t alignment)
+{
+    GpuAllocation allocation;
+    auto& blocks = blocks_[category];
+
+    allocation.category_ = category;
+
+    for (unsigned i = 0; i < blocks.size(); ++i)
+    {
+        if (!blocks[i])
+            continue;
+
+        allocation.range_ = blocks[i]->allocator_.Allocate(size, alignment);
+        if (allocation.range_.IsValid())
+        {
+            allocation.block_ = i;
+            break;
+        }
+    }
+
+    if (!allocation.range_.IsValid())
+    {
+        // Heaps are aligned at least as much as any placed resource, so a block of size bytes always fits it
+        // once rounded up to the granularity of the allocator, which would otherwise truncate the heap
+        GpuHeapInfo info;
+        uint64_t heapSize = size > blockSize_ ? size : blockSize_;
+        heapSize = (heapSize + TlsfAllocator::MinBlockSize - 1) & ~(TlsfAllocator::MinBlockSize - 1);
+        if (!factory_->CreateHeap(category, heapSize, info))
+            return allocation;
+        if (residency_)
+            residency_->Track(info.heap_, info.size_, category == GPU_HEAP_RENDER_TARGETS);
+
+        unsigned index = 0;
+        while (index < blocks.size() && blocks[index])
+            ++index;
+        if (index == blocks.size())
+            blocks.emplace_back();
+
+        blocks[index].reset(new HeapBlock(info));
+        allocation.block_ = index;
+        allocation.range_ = blocks[index]->allocator_.Allocate(size, alignment);
+        if (!allocation.range_.IsValid())
+        {
+            // Nothing fits even a new heap, as for a zero size or a factory that created less than asked for
+            DestroyBlock(*blocks[index]);
+            blocks[index].reset();
+            return GpuAllocation();
+        }
+    }
+
+    allocation.heap_ = blocks[allocation.block_]->info_.heap_;
+    allocation.offset_ = allocation.range_.offset_;
+    allocation.size_ = allocation.range_.size_;
+    return allocation;
+}
+
+void GpuHeapAllocator::Free(GpuAllocation& allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    auto& blocks = blocks_[allocation.category_];
+    assert(allocation.block_ < blocks.size() && blocks[allocation.block_]);
+
+    std::unique_ptr<HeapBlock>& block = blocks[allocation.block_];
+    block->allocator_.Free(allocation.range_);
+
+    if (block->allocator_.IsEmpty())
+    {
+        // Keep one heap per category so steady churn does not keep creating and destroying heaps
+        unsigned liveBlocks = 0;
+        for (auto& other : blocks)
+        {
+            if (other)
+                ++liveBlocks;
+        }
+
+        if (liveBlocks > 1)
+        {
+            DestroyBlock(*block);
+            block.reset();
+        }
+    }
+
+    allocation = GpuAllocation();
+}
+
+GpuHeapStats GpuHeapAllocator::GetStats(GpuHeapCategory category) const
+{
+    GpuHeapStats stats;
+    AddStats(category, stats);
+    return stats;
+}
+
+GpuHeapStats GpuHeapAllocator::GetTotalStats() const
+{
+    GpuHeapStats stats;
+    for (unsigned i = 0; i < MAX_GPU_HEAP_CATEGORIES; ++i)
+        AddStats((GpuHeapCategory) i, stats);
+    return stats;
+}
+
+void GpuHeapAllocator::AddStats(GpuHeapCategory category, GpuHeapStats& stats) const
+{
+    for (auto& block : blocks_[category])
+    {
+        if (!block)
+            continue;
+
+        TlsfAllocator const& allocator = block->allocator_;
+        uint64_t largest = allocator.GetLargestFreeRegion();
+
+        ++stats.blocks_;
+        stats.allocations_ += allocator.GetAllocationCount();
+        stats.reservedSize_ += allocator.GetSize();
+        stats.allocatedSize_ += allocator.GetAllocatedSize();
+        stats.freeRegions_ += allocator.GetFreeRegionCount();
+        stats.fragmentedSize_ += allocator.GetFreeSize() - largest;
+        if (largest > stats.largestFreeRegion_)
+            stats.largestFreeRegion_ = largest;
+    }
+}
+
+void GpuHeapAllocator::DestroyBlock(HeapBlock& block)
+{
+    if (residency_)
+        residency_->Untrack(block.info_.heap_);
+    factory_->DestroyHeap(block.info_);
+}
@@ -0,0 +1,199 @@
+#include "GpuProfiler.h"
+
+#include <cassert>
+
+
+GpuProfiler::GpuProfiler() = default;
+
+GpuProfiler::~GpuProfiler()
+{
+    Shutdown();
+}
+
+bool GpuProfiler::Initialize(TimestampQuerySource& source, unsigned maxZones)
+{
+    assert(!source_);
+    assert(maxZones);
+
+    if (!source.Initialize(FrameCount * maxZones * 2))
+        return false;
+
+    source_ = &source;
+    maxZones_ = maxZones;
+    frequency_ = source.GetFrequency();
+    timestamps_.resize(maxZones * 2);
+    for (Frame& frame : frames_)
+        frame.zones_.resize(maxZones);
+
+    Calibrate();
+    return true;
+}
+
+void GpuProfiler::Shutdown()
+{
+    if (!source_)
+        return;
+
+    source_->Shutdown();
+    source_ = nullptr;
+
+    for (Frame& frame : frames_)
+        frame = Frame();
+    zoneStack_.clear();
+    lastFrameZones_.clear();
+    current_ = 0;
+    recording_ = false;
+}
+
+void GpuProfiler::SetProfiler(Profiler* profiler)
+{
+    profiler_ = profiler;
+    if (profiler_)
+        track_ = profiler_->AddTrack("GPU");
+}
+
+void GpuProfiler::BeginFrame(uint64_t completedValue)
+{
+    assert(source_);
+
+    if (++framesSinceCalibration_ >= CalibrationInterval)
+        Calibrate();
+
+    // Oldest first, the slot about to be recorded held the oldest frame
+    for (unsigned i = 0; i < FrameCount; ++i)
+    {
+        unsigned slot = (current_ + i) % FrameCount;
+        Frame& frame = frames_[slot];
+        if (frame.pending_ && frame.fenceValue_ <= completedValue)
+            ReadFrame(frame, slot);
+    }
+
+    // The slot's last frame is still in flight when more frames are queued than the ring has room for
+    Frame& frame = frames_[current_];
+    recording_ = !frame.pending_;
+    if (recording_)
+        frame.zoneCount_ = 0;
+    zoneStack_.clear();
+}
+
+unsigned GpuProfiler::BeginZone(std::string const& name)
+{
+    assert(source_);
+
+    if (!recording_)
+        return ~0u;
+
+    Frame& frame = frames_[current_];
+    if (frame.zoneCount_ >= maxZones_)
+    {
+        ++stats_.zonesDropped_;
+        return ~0u;
+    }
+
+    unsigned zone = frame.zoneCount_++;
+    frame.zones_[zone].name_ = name;
+    frame.zones_[zone].depth_ = (unsigned) zoneStack_.size();
+    zoneStack_.push_back(zone);
+
+    source_->EndQuery((current_ * maxZones_ + zone) * 2);
+    return zone;
+}
+
+void GpuProfiler::EndZone(unsigned zone)
+{
+    assert(source_);
+
+    if (zone == ~0u || zoneStack_.empty())
+        return;
+
+    // Zones end in reverse order, ending an outer zone also ends the ones left open inside it
+    while (!zoneStack_.empty())
+    {
+        unsigned open = zoneStack_.back();
+        zoneStack_.pop_back();
+        source_->EndQuery((current_ * maxZones_ + open) * 2 + 1);
+        if (open == zone)
+            break;
+    }
+}
+
+void GpuProfiler::EndFrame(uint64_t fenceValue)
+{
+    assert(source_);
+
+    Frame& frame = frames_[current_];
+    if (!recording_)
+    {
+        ++stats_.framesDropped_;
+        return;
+    }
+
+    while (!zoneStack_.empty())
+        EndZone(zoneStack_.front());
+
+    if (frame.zoneCount_)
+        source_->ResolveQueries(current_ * maxZones_ * 2, frame.zoneCount_ * 2);
+
+    frame.fenceValue_ = fenceValue;
+    frame.pending_ = true;
+    recording_ = false;
+    current_ = (current_ + 1) % FrameCount;
+}
+
+unsigned GpuProfiler::GetPendingFrameCount() const
+{
+    unsigned count = 0;
+    for (Frame const& frame : frames_)
+    {
+        if (frame.pending_)
+            ++count;
+    }
+    return count;
+}
+
+double GpuProfiler::TimestampToMicroseconds(uint64_t timestamp) const
+{
+    return calibrationCpu_ + (double) (int64_t) (timestamp - calibrationGpu_) * 1e6 / (double) frequency_;
+}
+
+void GpuProfiler::ReadFrame(Frame& frame, unsigned slot)
+{
+    frame.pending_ = false;
+    ++stats_.framesRead_;
+    lastFrameZones_.clear();
+
+    unsigned count = frame.zoneCount_;
+    if (!count || !source_->ReadQueries(slot * maxZones_ * 2, count * 2, timestamps_.data()))
+        return;
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        Zone const& zone = frame.zones_[i];
+        uint64_t begin = timestamps_[i * 2];
+        uint64_t end = timestamps_[i * 2 + 1];
+
+        GpuZoneTiming timing;
+        timing.name_ = zone.name_;
+        timing.start_ = TimestampToMicroseconds(begin);
+        timing.duration_ = end > begin ? (double) (end - begin) * 1e6 / (double) frequency_ : 0.0;
+        timing.depth_ = zone.depth_;
+        lastFrameZones_.push_back(timing);
+
+        if (profiler_)
+            profiler_->AddTimelineZone(track_, timing.name_, timing.start_, timing.duration_, timing.depth_);
+    }
+}
+
+void GpuProfiler::Calibrate()
+{
+    framesSinceCalibration_ = 0;
+
+    uint64_t gpuTimestamp, cpuTicks;
+    if (!source_->GetClockCalibration(gpuTimestamp, cpuTicks))
+        return;
+
+    Profiler& profiler = profiler_ ? *profiler_ : Profiler::Get();
+    calibrationGpu_ = gpuTimestamp;
+    calibrationCpu_ = profiler.TicksToMicroseconds(cpuTicks);
+    ++stats_.calibrations_;
+}
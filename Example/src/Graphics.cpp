@@ -1,22 +1,84 @@
 
 #include "Graphics.h"
+#include "FrameTimer.h"
+#include "FrustumCuller.h"
+#include "IndirectDraw.h"
+#include "JobSystem.h"
+#include "NullGraphicsBackend.h"
+#include "NullTextureUploadSink.h"
+#include "ObjectBuffer.h"
+#include "OcclusionBuffer.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "RenderQueue.h"
+#include "Scene.h"
+#include "SceneSystems.h"
+#include "TextureStreamer.h"
+
+#if defined(_WIN32)
+#include "D3D12TextureUploadSink.h"
 #include "GraphicsImpl.h"
+#endif
 
 
 static Graphics* gInstance = nullptr;
 
+/// File of the pipeline cache between runs.
+static const char* PipelineCacheFileName = "PipelineCache.bin";
+
+#if defined(_WIN32)
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+#endif
 
 Graphics::Graphics()
-    : impl_(new GraphicsImpl)
+    : jobSystem_(new JobSystem())
+    , frameClock_(new SteadyFrameClock())
+    , frameTimer_(new FrameTimer(*frameClock_))
+#if defined(_WIN32)
+    , impl_(new GraphicsImpl)
+    , backend_(impl_)
+#else
+    , backend_(new NullGraphicsBackend(0, 0))
+#endif
+    , renderGraph_(new RenderGraph())
+    , renderQueue_(new RenderQueue())
+    , textureStreamer_(new TextureStreamer())
+    , scene_(new Scene())
+    , sceneComponents_(new SceneComponents(*scene_))
+    , culler_(new FrustumCuller())
+    , occlusionBuffer_(new OcclusionBuffer())
+    , objectBuffer_(new ObjectBuffer())
+    , indirectDraws_(new IndirectDrawBatch())
+    , framePipeline_(new FramePipeline())
+#if defined(_WIN32)
     , window_(nullptr)
+#endif
     , initialized_(false)
     , exiting_(false)
 {
     gInstance = this;
+
+    Profiler::Get().SetThreadName("Main");
+
+    backend_->SetCommandListThreads(jobSystem_->GetThreadCount());
+    scene_->SetJobSystem(jobSystem_.get());
+    culler_->SetJobSystem(jobSystem_.get());
+    occlusionBuffer_->SetJobSystem(jobSystem_.get());
+    renderQueue_->SetJobSystem(jobSystem_.get());
 }
 
-Graphics::~Graphics() = default;
+Graphics::~Graphics()
+{
+    framePipeline_->Stop();
+
+    // The staging ring goes away with the streamer, the copies reading it must have completed
+    if (initialized_)
+        backend_->FlushCommandQueue();
+    textureStreamer_->Shutdown();
+
+    if (initialized_ && !headless_)
+        backend_->GetPipelineCache().Save(PipelineCacheFileName);
+}
 
 bool Graphics::Initialize()
 {
@@ -25,13 +87,86 @@ bool Graphics::Initialize()
     mode.height_ = 750;
     mode.resizable_ = false;
 
-    if (!SetWindowMode(mode))
+    if (headless_)
+    {
+        modeParams_ = mode;
+        std::shared_ptr<GraphicsBackend> settings = backend_;
+        backend_ = std::make_shared<NullGraphicsBackend>(mode.width_, mode.height_);
+        backend_->SetFramesInFlight(settings->GetFramesInFlight());
+        backend_->SetMaxFrameLatency(settings->GetMaxFrameLatency());
+        backend_->SetCommandListThreads(jobSystem_->GetThreadCount());
+    }
+#if defined(_WIN32)
+    else if (!SetWindowMode(mode))
+        return false;
+#else
+    else
+    {
+        LOGERROR("Rendering to a window needs Direct3D12, run headless.\n");
+        return false;
+    }
+#endif
+
+    // Compile pipelines off the main thread and start from the blobs of the last run
+    PipelineCache& pipelineCache = backend_->GetPipelineCache();
+    pipelineCache.SetJobSystem(jobSystem_.get());
+    if (!headless_ && !pipelineCache.Load(PipelineCacheFileName))
+        LOGINFO("No valid pipeline cache, pipelines compile from scratch.\n");
+
+    // Stream textures through the copy queue, or a simulated one when headless
+#if defined(_WIN32)
+    if (!headless_)
+        textureUploadSink_.reset(new D3D12TextureUploadSink(*impl_));
+    else
+#endif
+        textureUploadSink_.reset(new NullTextureUploadSink());
+    textureStreamer_->SetJobSystem(jobSystem_.get());
+    if (!textureStreamer_->Initialize(*textureUploadSink_, backend_->GetUploadBufferFactory()))
+    {
+        LOGERROR("Create texture staging ring failed.");
         return false;
+    }
+
+    objectBuffer_->Initialize(*backend_, sizeof(Matrix4));
+
+    // Default camera looking at the origin, unless one was set
+    if (projection_ == Matrix4())
+    {
+        view_ = Matrix4::LookAt(Vector3(0.0f, 10.0f, -30.0f), Vector3(), Vector3(0.0f, 1.0f, 0.0f));
+        projection_ = Matrix4::Perspective(1.0f, (float) modeParams_.width_ / (float) modeParams_.height_, 0.1f, 1000.0f);
+    }
+
+    // Initialization is not simulation time
+    frameTimer_->Reset();
+    if (pipelined_)
+        framePipeline_->Start([this](FramePacket& packet) { Simulate(packet); });
 
     initialized_ = true;
     return true;
 }
 
+void Graphics::SetHeadless(bool enable)
+{
+    assert(!initialized_);
+    headless_ = enable;
+}
+
+void Graphics::SetPipelined(bool enable)
+{
+    assert(!initialized_);
+    pipelined_ = enable;
+}
+
+uint64_t Graphics::GetFrameNumber() const
+{
+    return backend_->GetFramePacer().GetFrameNumber();
+}
+
+GpuProfiler& Graphics::GetGpuProfiler()
+{
+    return backend_->GetGpuProfiler();
+}
+
 bool Graphics::IsExiting()
 {
     return exiting_;
@@ -43,36 +178,211 @@ void Graphics::RunFrame()
 
     if (exiting_) return;
 
-    MSG msg;
-    ZeroMemory(&msg, sizeof(MSG));
+    PROFILE_FRAME(GetFrameNumber());
+    PROFILE_SCOPE("RunFrame");
 
-    if (PeekMessage(&msg,0 , 0, 0, PM_REMOVE))
+#if defined(_WIN32)
+    // Handle every pending message, one per frame lets input queue up behind slow frames
+    if (!headless_)
     {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+        MSG msg;
+        while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
+        {
+            if (msg.message == WM_QUIT)
+            {
+                exiting_ = true;
+                return;
+            }
+
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
     }
+#endif
 
-    if (msg.message == WM_QUIT)
+    if (!pipelined_)
     {
-        exiting_ = true;
+        Simulate(framePacket_);
+        Render(framePacket_);
         return;
     }
 
-    Update();
+    // The simulation thread is already working on the frame after this one
+    FramePacket const* packet;
+    {
+        PROFILE_SCOPE("WaitForSimulation");
+        packet = framePipeline_->AcquirePacket();
+    }
+    if (packet)
+    {
+        Render(*packet);
+        framePipeline_->ReleasePacket(packet);
+    }
+}
+
+void Graphics::Simulate(FramePacket& packet)
+{
+    PROFILE_SCOPE("Simulate");
+
+    unsigned steps = frameTimer_->BeginFrame();
+    for (unsigned i = 0; i < steps; ++i)
+        Update(frameTimer_->GetTimestepSeconds());
+
+    packet.frameNumber_ = simulationFrame_++;
+    packet.time_ = simulationTime_;
+    packet.interpolation_ = frameTimer_->GetInterpolation();
+    packet.steps_ = steps;
+    packet.clearColor_[0] = 0.2f;
+    packet.clearColor_[1] = 0.3f;
+    packet.clearColor_[2] = 0.7f;
+    packet.clearColor_[3] = 1.0f;
+    packet.viewProjection_ = view_ * projection_;
+
+    // Renderables that moved update their culling bounds and go to the object buffer with the packet
+    if (scene_->GetEntitySlotCount())
+        SyncRenderables(*scene_, *sceneComponents_, renderableVersion_, *culler_, packet.changedRenderables_);
+    else
+    {
+        packet.changedRenderables_.objects_.clear();
+        packet.changedRenderables_.transforms_.clear();
+    }
+    PROFILE_COUNTER("ChangedRenderables", packet.changedRenderables_.objects_.size());
 
-    Render();
+    {
+        PROFILE_SCOPE("Cull");
+        culler_->Cull(Frustum(packet.viewProjection_), packet.visibleObjects_);
+        culler_->GetBoxes(packet.visibleObjects_, packet.visibleBounds_);
+    }
+    PROFILE_COUNTER("VisibleObjects", packet.visibleObjects_.size());
 }
 
-void Graphics::Update()
+void Graphics::Update(double timeStep)
 {
+    PROFILE_SCOPE("Update");
 
+    UpdateMotion(*scene_, *sceneComponents_, (float) timeStep);
+    UpdateWorldTransforms(*scene_, *sceneComponents_, worldTransformVersion_);
+
+    simulationTime_ += timeStep;
 }
 
-void Graphics::Render()
+void Graphics::SetCamera(Matrix4 const& view, Matrix4 const& projection)
 {
-    impl_->Begin();
-    
-    impl_->End();
+    view_ = view;
+    projection_ = projection;
+}
+
+void Graphics::Render(FramePacket const& packet)
+{
+    PROFILE_SCOPE("Render");
+
+    backend_->Begin();
+
+    // Copies go on the copy queue alongside the frame, finished ones swap in their textures
+    textureStreamer_->Update();
+
+    // Objects behind the occluders need not be drawn
+    if (occlusionBuffer_->GetOccluderCount())
+    {
+        PROFILE_SCOPE("Occlusion");
+        occlusionBuffer_->Render(packet.viewProjection_);
+        occlusionBuffer_->Cull(packet.visibleBounds_, packet.visibleObjects_, drawObjects_);
+    }
+    else
+        drawObjects_ = packet.visibleObjects_;
+    PROFILE_COUNTER("DrawnObjects", drawObjects_.size());
+
+    // Changed objects patch the object buffer on a list that runs before the draws
+    RenderableChanges const& changes = packet.changedRenderables_;
+    for (size_t i = 0; i < changes.objects_.size(); ++i)
+        objectBuffer_->Set(changes.objects_[i], &changes.transforms_[i]);
+    if (objectBuffer_->IsDirty())
+    {
+        CommandList* commandList = backend_->AcquireCommandList();
+        if (commandList)
+        {
+            objectBuffer_->Upload(*commandList);
+            backend_->QueueCommandList(commandList);
+            PROFILE_COUNTER("ObjectBytesUploaded", objectBuffer_->GetStats().bytes_);
+        }
+    }
+
+    // The objects drawn become indirect arguments for a single call
+    IndirectDrawBatch& indirectDraws = *indirectDraws_;
+    bool drawIndirect = indirectDraws.IsDrawable() && objectBuffer_->GetResource() &&
+        indirectDraws.Build(drawObjects_, backend_->GetUploadRing()) && indirectDraws.GetDrawCount();
+
+    RenderGraph& graph = *renderGraph_;
+    graph.Reset();
+
+    RenderGraphResource backBuffer = graph.Import("BackBuffer", backend_->GetBackBuffer(), RESOURCE_STATE_PRESENT);
+
+    graph.AddPass("Clear",
+        [&](RenderGraphBuilder& builder)
+        {
+            builder.Write(backBuffer, RESOURCE_STATE_RENDER_TARGET);
+        },
+        [&](RenderGraphContext& context)
+        {
+            GraphicsBackend& backend = context.GetBackend();
+            backend.SetDefaultViewport();
+
+            backend.ClearRenderTarget(packet.clearColor_);
+            backend.ClearDepthStencil(1.0f, 0);
+
+            backend.SetDefaultRenderTargets();
+        });
+
+    // Draws record into lists of their own in parallel, which run after the main one in draw order
+    RenderQueue& queue = *renderQueue_;
+    if (queue.GetDrawCount() || drawIndirect)
+    {
+        queue.Sort();
+        graph.AddPass("Draw",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Write(backBuffer, RESOURCE_STATE_RENDER_TARGET);
+            },
+            [&](RenderGraphContext& context)
+            {
+                GraphicsBackend& backend = context.GetBackend();
+                ResourceHandle target = context.GetResource(backBuffer);
+                queue.Submit([&]() -> CommandList*
+                {
+                    CommandList* commandList = backend.AcquireCommandList();
+                    if (commandList)
+                    {
+                        commandList->GetStateTracker().Transition(target, RESOURCE_STATE_RENDER_TARGET);
+                        commandList->SetDefaultViewport();
+                        commandList->SetDefaultRenderTargets();
+                    }
+                    return commandList;
+                }, drawCommandLists_);
+                if (drawCommandLists_.empty())
+                    return;
+
+                if (drawIndirect)
+                {
+                    CommandList* commandList = drawCommandLists_.back();
+                    commandList->GetStateTracker().Transition(objectBuffer_->GetResource(), ObjectBuffer::ShaderResourceState);
+                    commandList->FlushBarriers();
+                    indirectDraws.Execute(*commandList, objectBuffer_->GetGpuAddress());
+                }
+                for (CommandList* commandList : drawCommandLists_)
+                    backend.QueueCommandList(commandList);
+                PROFILE_COUNTER("IndirectDraws", indirectDraws.GetDrawCount());
+                PROFILE_COUNTER("Draws", queue.GetStats().draws_);
+                PROFILE_COUNTER("PipelineStatesSkipped", queue.GetStats().pipelineStatesSkipped_);
+                PROFILE_COUNTER("DrawCommandLists", queue.GetStats().commandLists_);
+            });
+    }
+
+    TransientResourceFactory& factory = backend_->GetTransientResourceFactory();
+    if (graph.Compile(factory))
+        graph.Execute(*backend_, factory);
+
+    backend_->End();
+    queue.Clear();
 }
 
 void Graphics::Exit()
@@ -84,12 +394,15 @@ void Graphics::SetWindowTitle(std::string const& title)
 {
     title_ = title;
 
+#if defined(_WIN32)
     if (window_)
     {
         SetWindowText(window_, title_.c_str());
     }
+#endif
 }
 
+#if defined(_WIN32)
 bool Graphics::SetWindowMode(int width, int height)
 {
     WindowModeParams params;
@@ -111,7 +424,19 @@ bool Graphics::SetWindowMode(WindowModeParams const& mode)
 
     return CreateDevice(modeParams_.width_, modeParams_.height_);
 }
+#endif
 
+void Graphics::SetFramesInFlight(unsigned count)
+{
+    backend_->SetFramesInFlight(count);
+}
+
+void Graphics::SetMaxFrameLatency(unsigned frames)
+{
+    backend_->SetMaxFrameLatency(frames);
+}
+
+#if defined(_WIN32)
 HWND Graphics::OpenWindow()
 {
     const char* title = title_.c_str();
@@ -199,8 +524,8 @@ bool Graphics::CreateDevice(int width, int height)
 
 bool Graphics::UpdateSwapChain()
 {
-    impl_->FlushCommandQueue();
-    impl_->commandList_->Reset(impl_->commandAllocator_, nullptr);
+    // No flush, resources being replaced are released once frames in flight are done with them
+    impl_->commandList_->Reset(impl_->commandAllocators_[impl_->GetFramePacer().GetFrameIndex()], nullptr);
     
     DXGI_FORMAT backBufferFormat = sRGB_ ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
     unsigned sampleCount = modeParams_.multiSample_;
@@ -223,6 +548,11 @@ bool Graphics::UpdateSwapChain()
         swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
         swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
 
+        // A waitable swap chain must be waited on every frame, so only with a latency bound
+        unsigned maxFrameLatency = impl_->GetMaxFrameLatency();
+        if (maxFrameLatency)
+            swapChainDesc.Flags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+
         HRESULT hr = impl_->factory_->CreateSwapChain(impl_->commandQueue_, &swapChainDesc, &impl_->swapChain_);
         if (FAILED(hr))
         {
@@ -230,6 +560,14 @@ bool Graphics::UpdateSwapChain()
             LOGERROR("Failed to create D3D11 swap chain. (HRESULT %x)", hr);
             return false;
         }
+
+        // Without IDXGISwapChain2 the latency bound falls back to waiting on the queue fence
+        if (maxFrameLatency && SUCCEEDED(impl_->swapChain_->QueryInterface(IID_PPV_ARGS(&impl_->swapChain2_))))
+        {
+            impl_->swapChain2_->SetMaximumFrameLatency(maxFrameLatency);
+            impl_->swapChainFrameLatency_ = maxFrameLatency;
+            impl_->frameLatencyWaitableObject_ = impl_->swapChain2_->GetFrameLatencyWaitableObject();
+        }
     }    
 
     // Reset render target views
@@ -265,4 +603,5 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
     }
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,269 @@
+
+#include "GraphicsBackend.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <cassert>
+
+
+/// Heap allocation waiting for the GPU before it is freed.
+struct DeferredGpuAllocation
+{
+    /// Allocator
+    GpuHeapAllocator* allocator_;
+    /// Allocation
+    GpuAllocation allocation_;
+};
+
+static void FreeGpuAllocation(void* object)
+{
+    DeferredGpuAllocation* deferred = (DeferredGpuAllocation*) object;
+    deferred->allocator_->Free(deferred->allocation_);
+    delete deferred;
+}
+
+GraphicsBackend::GraphicsBackend() = default;
+
+GraphicsBackend::~GraphicsBackend()
+{
+    // Retired heap allocations refer to the heap allocator, which is destroyed before the queue
+    releaseQueue_.ReleaseAll();
+}
+
+void GraphicsBackend::Begin()
+{
+    PROFILE_SCOPE("Begin");
+
+    // Bound the frames queued for display before the CPU starts on another one
+    {
+        PROFILE_SCOPE("WaitForFrameLatency");
+        WaitForFrameLatency();
+    }
+
+    // Wait only for the frame that last used this slot, then recycle its allocator
+    unsigned frameIndex;
+    {
+        PROFILE_SCOPE("WaitForFrame");
+        frameIndex = framePacer_.BeginFrame(fenceTimeline_);
+        scheduler_.BeginFrame(frameIndex);
+    }
+    ResetCommandList(frameIndex);
+
+    // Run work deferred until earlier frames completed
+    fenceTimeline_.Poll();
+    releaseQueue_.ReleaseCompleted(fenceTimeline_.GetCompletedValue());
+    if (descriptorAllocator_.IsInitialized())
+        descriptorAllocator_.BeginFrame(fenceTimeline_.GetCompletedValue());
+    if (uploadRing_.IsInitialized())
+        uploadRing_.BeginFrame(fenceTimeline_.GetCompletedValue());
+
+    // Read GPU timings of completed frames and time this one
+    if (gpuProfiler_.IsInitialized())
+    {
+        gpuProfiler_.BeginFrame(fenceTimeline_.GetCompletedValue());
+        gpuProfiler_.BeginZone("Frame");
+    }
+
+    // Pooled command lists are reset on this slot's allocators when acquired again
+    for (CommandListPool& pool : commandListPools_)
+    {
+        for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+            pool.used_[i] = 0;
+    }
+
+    stateTracker_.ResetStats();
+}
+
+void GraphicsBackend::End()
+{
+    PROFILE_SCOPE("End");
+
+    // Queued lists run after the main list, so the present transition then goes into the last of them
+    if (queuedCommandLists_.empty())
+        stateTracker_.Transition(GetBackBuffer(), RESOURCE_STATE_PRESENT);
+    else
+        queuedCommandLists_.back()->GetStateTracker().Transition(GetBackBuffer(), RESOURCE_STATE_PRESENT);
+
+    // Resolve into the main command list, the frame is read once the signal below completes
+    if (gpuProfiler_.IsInitialized())
+        gpuProfiler_.EndFrame(fenceTimeline_.GetLastSignaledValue() + 1);
+
+    Submit();
+    frameBarrierStats_ = stateTracker_.GetStats();
+    PROFILE_COUNTER("Barriers", frameBarrierStats_.barriers_);
+
+    {
+        PROFILE_SCOPE("Present");
+        Present();
+    }
+
+    // Mark the end of the frame instead of waiting for it, the slot is waited on when it comes around again
+    uint64_t fenceValue = fenceTimeline_.Signal();
+    scheduler_.EndFrame(framePacer_.GetFrameIndex());
+    framePacer_.EndFrame(fenceValue);
+    presentFenceValues_.push_back(fenceValue);
+    if (presentFenceValues_.size() > MaxFrameLatency)
+        presentFenceValues_.pop_front();
+    if (descriptorAllocator_.IsInitialized())
+        descriptorAllocator_.EndFrame(fenceValue);
+    if (uploadRing_.IsInitialized())
+        uploadRing_.EndFrame(fenceValue);
+}
+
+void GraphicsBackend::Submit()
+{
+    PROFILE_SCOPE("Submit");
+
+    // Heaps used while evicted must be resident before any queue runs the work using them. Uses are frame
+    // numbers, as Begin has waited for every queue to finish the frame the slot was last used by
+    if (residency_.IsInitialized())
+    {
+        uint64_t frame = framePacer_.GetFrameNumber() + 1;
+        uint64_t framesInFlight = framePacer_.GetFramesInFlight();
+        residency_.Commit(frame > framesInFlight ? frame - framesInFlight : 0);
+
+        ResidencyStats const& stats = residency_.GetStats();
+        PROFILE_COUNTER("VideoMemoryUsage", stats.usage_);
+        PROFILE_COUNTER("VideoMemoryBudget", stats.budget_);
+    }
+
+    // Scheduled work goes first, then the frame's lists wait for what they depend on
+    scheduler_.Flush();
+    for (GpuSubmission const& submission : submissionWaits_)
+        scheduler_.QueueWait(GPU_QUEUE_DIRECT, submission);
+    submissionWaits_.clear();
+
+    stateTracker_.FlushBarriers(*this);
+    stateTracker_.Commit();
+    stateTracker_.Reset();
+
+    // Resolve each queued list against the states the lists before it leave behind. The barriers its first
+    // uses need are recorded at the end of the previous list, which stays open until then.
+    submitCommandLists_.clear();
+    CommandList* previous = nullptr;
+    for (CommandList* commandList : queuedCommandLists_)
+    {
+        ResourceStateTracker& tracker = commandList->GetStateTracker();
+        tracker.FlushBarriers(*commandList);
+
+        pendingBarriers_.clear();
+        tracker.ResolvePendingBarriers(pendingBarriers_);
+        if (!pendingBarriers_.empty())
+        {
+            if (previous)
+                previous->ResourceBarrier((unsigned) pendingBarriers_.size(), pendingBarriers_.data());
+            else
+                ResourceBarrier((unsigned) pendingBarriers_.size(), pendingBarriers_.data());
+        }
+
+        if (previous)
+        {
+            previous->Close();
+            submitCommandLists_.push_back(previous);
+        }
+
+        tracker.Commit();
+        tracker.Reset();
+        previous = commandList;
+    }
+
+    if (previous)
+    {
+        previous->Close();
+        submitCommandLists_.push_back(previous);
+    }
+    queuedCommandLists_.clear();
+
+    ExecuteCommandLists(submitCommandLists_.data(), (unsigned) submitCommandLists_.size());
+}
+
+void GraphicsBackend::WaitForFrameLatency()
+{
+    // Covers the GPU work of the frames, not how long they then wait for display
+    if (maxFrameLatency_ && presentFenceValues_.size() >= maxFrameLatency_)
+        fenceTimeline_.Wait(presentFenceValues_[presentFenceValues_.size() - maxFrameLatency_]);
+}
+
+void GraphicsBackend::FlushCommandQueue()
+{
+    PROFILE_SCOPE("FlushCommandQueue");
+    scheduler_.WaitIdle();
+    fenceTimeline_.Flush();
+}
+
+void GraphicsBackend::WaitForSubmission(GpuSubmission const& submission)
+{
+    if (submission.IsValid())
+        submissionWaits_.push_back(submission);
+}
+
+void GraphicsBackend::DeferRelease(void* object, DeferredReleaseQueue::ReleaseFunction release, uint64_t bytes)
+{
+    // The next sync point is signaled after everything recorded or submitted until now
+    releaseQueue_.Retire(object, release, fenceTimeline_.GetLastSignaledValue() + 1, bytes);
+}
+
+void GraphicsBackend::DeferFree(GpuAllocation& allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    DeferRelease(new DeferredGpuAllocation{ &heapAllocator_, allocation }, FreeGpuAllocation);
+    allocation = GpuAllocation();
+}
+
+void GraphicsBackend::MarkUsed(GpuAllocation const& allocation)
+{
+    if (allocation.IsValid())
+        residency_.MarkUsed(allocation.heap_, framePacer_.GetFrameNumber() + 1);
+}
+
+void GraphicsBackend::SetCommandListThreads(unsigned count)
+{
+    assert(count);
+    assert(queuedCommandLists_.empty());
+
+    commandListPools_.resize(count);
+}
+
+CommandList* GraphicsBackend::AcquireCommandList(GpuQueueType type)
+{
+    unsigned threadIndex = JobSystem::GetThreadIndex();
+    assert(threadIndex < commandListPools_.size());
+
+    CommandListPool& pool = commandListPools_[threadIndex];
+    std::vector<std::unique_ptr<CommandList>>& commandLists = pool.commandLists_[type];
+    if (pool.used_[type] == commandLists.size())
+    {
+        CommandList* commandList = CreateCommandList(type);
+        if (!commandList)
+            return nullptr;
+        commandLists.emplace_back(commandList);
+    }
+
+    CommandList* commandList = commandLists[pool.used_[type]++].get();
+    commandList->Reset(framePacer_.GetFrameIndex());
+    return commandList;
+}
+
+void GraphicsBackend::QueueCommandList(CommandList* commandList)
+{
+    if (commandList)
+        queuedCommandLists_.push_back(commandList);
+}
+
+unsigned GraphicsBackend::GetCommandListCount() const
+{
+    unsigned count = 0;
+    for (CommandListPool const& pool : commandListPools_)
+    {
+        for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+            count += (unsigned) pool.commandLists_[i].size();
+    }
+    return count;
+}
+
+void GraphicsBackend::SetFramesInFlight(unsigned count)
+{
+    framePacer_.SetFramesInFlight(count);
+}
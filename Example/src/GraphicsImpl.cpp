@@ -1,37 +1,67 @@
 
 #include "GraphicsImpl.h"
+#include "D3D12CommandList.h"
+#include "D3D12DescriptorHeapFactory.h"
+#include "D3D12GpuHeapFactory.h"
+#include "D3D12IndirectDrawFactory.h"
+#include "D3D12PipelineStateFactory.h"
+#include "D3D12ResidencyBackend.h"
+#include "D3D12TimestampQuerySource.h"
+#include "D3D12TransientResourceFactory.h"
+#include "D3D12UploadBufferFactory.h"
 #include "Common.h"
 
 
+static void ReleaseObject(void* object)
+{
+    ((IUnknown*) object)->Release();
+}
+
 GraphicsImpl::GraphicsImpl() = default;
 
 GraphicsImpl::~GraphicsImpl()
 {
+    // Resources may still be used by frames in flight
+    if (queueFence_)
+        FlushCommandQueue();
+
+    transientResourceFactory_.reset();
+    gpuProfiler_.Shutdown();
+    releaseQueue_.ReleaseAll();
+    commandListPools_.clear();
+    pipelineCache_.Shutdown();
+
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+    {
+        scheduler_.SetQueue((GpuQueueType) i, nullptr);
+        scheduledQueues_[i].reset();
+    }
+
     for (unsigned i = 0; i < SwapChainBufferCount; ++i)
         D3D_SAFE_RELEASE(defaultRenderTargets_[i]);
 
     D3D_SAFE_RELEASE(defaultDepthStencil_);
+    heapAllocator_.Shutdown();
 
     D3D_SAFE_RELEASE(fence_);
 
-    D3D_SAFE_RELEASE(renderTargetViewHeap_);
-    D3D_SAFE_RELEASE(depthStencilViewHeap_);
+    descriptorAllocator_.Shutdown();
+    uploadRing_.Shutdown();
 
     D3D_SAFE_RELEASE(commandList_);
-    D3D_SAFE_RELEASE(commandAllocator_);
+    for (unsigned i = 0; i < FramePacer::MaxFramesInFlight; ++i)
+        D3D_SAFE_RELEASE(commandAllocators_[i]);
     D3D_SAFE_RELEASE(commandQueue_);
 
+    if (frameLatencyWaitableObject_)
+        CloseHandle(frameLatencyWaitableObject_);
+    D3D_SAFE_RELEASE(swapChain2_);
     D3D_SAFE_RELEASE(swapChain_);
     D3D_SAFE_RELEASE(device_);
 }
 
 bool GraphicsImpl::CreateCommandObjects()
 {
-    // Get descriptor size 
-    renderTargetViewSize_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    depthStencilViewSize_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
-    bufferViewSize_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    
     // Create fence
     HRESULT hr = device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
     if (FAILED(hr))
@@ -54,18 +84,37 @@ bool GraphicsImpl::CreateCommandObjects()
         return false;
     }
 
-    // Create command allocator
-    hr = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator_));
-    if (FAILED(hr))
+    queueFence_ = std::make_unique<D3D12Fence>(commandQueue_, fence_);
+    fenceTimeline_.SetFence(queueFence_.get());
+
+    // Create the compute and copy queues, uploads and async compute overlap rendering on them
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
     {
-        D3D_SAFE_RELEASE(commandAllocator_);
-        LOGERROR("Failed to create D3D12 command allocator. (HRESULT %x)", hr);
-        return false;
+        GpuQueueType type = (GpuQueueType) i;
+        scheduledQueues_[i].reset(new D3D12GpuQueue(device_));
+        if (type == GPU_QUEUE_DIRECT ? !scheduledQueues_[i]->Create(commandQueue_) : !scheduledQueues_[i]->Create(type))
+        {
+            scheduledQueues_[i].reset();
+            return false;
+        }
+        scheduler_.SetQueue(type, scheduledQueues_[i].get());
+    }
+
+    // Create one command allocator per frame in flight, an allocator can only be reset once the GPU is done with it
+    for (unsigned i = 0; i < FramePacer::MaxFramesInFlight; ++i)
+    {
+        hr = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocators_[i]));
+        if (FAILED(hr))
+        {
+            D3D_SAFE_RELEASE(commandAllocators_[i]);
+            LOGERROR("Failed to create D3D12 command allocator. (HRESULT %x)", hr);
+            return false;
+        }
     }
 
     // Create command list
     hr = device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, 
-        commandAllocator_, nullptr, IID_PPV_ARGS(&commandList_));
+        commandAllocators_[0], nullptr, IID_PPV_ARGS(&commandList_));
     if (FAILED(hr))
     {
         D3D_SAFE_RELEASE(commandList_);
@@ -75,36 +124,68 @@ bool GraphicsImpl::CreateCommandObjects()
 
     commandList_->Close();
 
+    // Create the pipeline cache, compiles may run on job threads
+    if (!pipelineCache_.IsInitialized())
+    {
+        pipelineStateFactory_.reset(new D3D12PipelineStateFactory(device_, factory_));
+        pipelineCache_.Initialize(*pipelineStateFactory_);
+    }
+
+    // Keep heaps within the video memory budget where DXGI reports one
+    D3D12ResidencyBackend* residencyBackend = new D3D12ResidencyBackend(device_);
+    residencyBackend_.reset(residencyBackend);
+    if (residencyBackend->Initialize(factory_))
+    {
+        residency_.Initialize(*residencyBackend_);
+        heapAllocator_.SetResidencyManager(&residency_);
+    }
+    else
+        LOGINFO("No video memory budget, heaps stay resident.\n");
+
+    // Create the heap sub-allocator for placed resources
+    heapFactory_.reset(new D3D12GpuHeapFactory(device_));
+    heapAllocator_.Initialize(*heapFactory_);
+    transientResourceFactory_.reset(new D3D12TransientResourceFactory(*this));
+    indirectDrawFactory_.reset(new D3D12IndirectDrawFactory(device_));
+
+    // Create the upload ring for per-frame constants and dynamic geometry
+    uploadBufferFactory_.reset(new D3D12UploadBufferFactory(device_));
+    if (!uploadRing_.Initialize(*uploadBufferFactory_, UploadRingSize))
+    {
+        LOGERROR("Failed to create upload ring.");
+        return false;
+    }
+
+    // Create timestamp queries for GPU profiling, rendering goes on without them
+    if (!gpuProfiler_.IsInitialized())
+    {
+        timestampQuerySource_.reset(new D3D12TimestampQuerySource(device_, commandQueue_, commandList_));
+        if (!gpuProfiler_.Initialize(*timestampQuerySource_))
+            LOGERROR("Failed to create GPU timestamp queries.");
+    }
+
     return true;
 }
 
 bool GraphicsImpl::CreateDescriptorHeap()
 {
-    D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc;
-    rtvHeapDesc.NumDescriptors = SwapChainBufferCount;
-    rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-    rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    rtvHeapDesc.NodeMask = 0;
+    if (descriptorAllocator_.IsInitialized())
+        return true;
 
-    HRESULT hr = device_->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&renderTargetViewHeap_));
-    if (FAILED(hr))
+    descriptorHeapFactory_.reset(new D3D12DescriptorHeapFactory(device_));
+    if (!descriptorAllocator_.Initialize(*descriptorHeapFactory_))
     {
-        D3D_SAFE_RELEASE(renderTargetViewHeap_);
-        LOGERROR("Create RTV descriptor heap failed. (HRESULT %x)", hr);
+        LOGERROR("Create shader visible descriptor heap failed.");
         return false;
     }
 
-    D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc;
-    dsvHeapDesc.NumDescriptors = 1;
-    dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-    dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    dsvHeapDesc.NodeMask = 0;
+    for (unsigned i = 0; i < SwapChainBufferCount; ++i)
+        renderTargetViews_[i] = descriptorAllocator_.Allocate(DESCRIPTOR_HEAP_RTV);
+    depthStencilView_ = descriptorAllocator_.Allocate(DESCRIPTOR_HEAP_DSV);
 
-    hr = device_->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&depthStencilViewHeap_));
-    if (FAILED(hr))
+    if (!renderTargetViews_[SwapChainBufferCount - 1].IsValid() || !depthStencilView_.IsValid())
     {
-        D3D_SAFE_RELEASE(depthStencilViewHeap_);
-        LOGERROR("Create DSV descriptor heap failed. (HRESULT %x)", hr);
+        LOGERROR("Create RTV and DSV descriptor heaps failed.");
         return false;
     }
 
@@ -113,18 +194,21 @@ bool GraphicsImpl::CreateDescriptorHeap()
 
 bool GraphicsImpl::ResetRenderTargetViews()
 {
-    /// Release previous resource
+    /// Release previous resource once frames in flight are done with it
     for (int i = 0; i < GraphicsImpl::SwapChainBufferCount; ++i)
-        D3D_SAFE_RELEASE(defaultRenderTargets_[i]);
+    {
+        DeferRelease(defaultRenderTargets_[i]);
+        defaultRenderTargets_[i] = nullptr;
+    }
     
-    D3D12_CPU_DESCRIPTOR_HANDLE handle = renderTargetViewHeap_->GetCPUDescriptorHandleForHeapStart();
-
     for (unsigned i = 0; i < SwapChainBufferCount; ++i)
     {    
+        D3D12_CPU_DESCRIPTOR_HANDLE handle;
+        handle.ptr = renderTargetViews_[i].cpu_;
+
         swapChain_->GetBuffer(i, IID_PPV_ARGS(&defaultRenderTargets_[i]));
         device_->CreateRenderTargetView(defaultRenderTargets_[i], nullptr, handle);
-
-        handle.ptr += renderTargetViewSize_;
+        stateRegistry_.RegisterResource(defaultRenderTargets_[i], 1, RESOURCE_STATE_PRESENT);
     }
 
     return true;
@@ -132,7 +216,9 @@ bool GraphicsImpl::ResetRenderTargetViews()
 
 bool GraphicsImpl::ResetDepthStencilView(int width, int height, unsigned sampleCount, unsigned sampleQuality)
 {
-    D3D_SAFE_RELEASE(defaultDepthStencil_);
+    DeferRelease(defaultDepthStencil_);
+    DeferFree(defaultDepthStencilAllocation_);
+    defaultDepthStencil_ = nullptr;
 
     D3D12_RESOURCE_DESC depthStencilDesc;
     depthStencilDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -151,20 +237,12 @@ bool GraphicsImpl::ResetDepthStencilView(int width, int height, unsigned sampleC
     optClear.Format = DepthStencilFormat;
     optClear.DepthStencil.Depth = 1.0f;
     optClear.DepthStencil.Stencil = 0;
-    
-    D3D12_HEAP_PROPERTIES heapProperty;
-    heapProperty.Type = D3D12_HEAP_TYPE_DEFAULT;
-    heapProperty.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-    heapProperty.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-    heapProperty.CreationNodeMask = 1;
-    heapProperty.VisibleNodeMask = 1;
-
-    HRESULT hr = device_->CreateCommittedResource(&heapProperty, D3D12_HEAP_FLAG_NONE, &depthStencilDesc, 
-        D3D12_RESOURCE_STATE_COMMON, &optClear, IID_PPV_ARGS(&defaultDepthStencil_));
-    if (FAILED(hr))
+
+    defaultDepthStencil_ = CreatePlacedResource(depthStencilDesc, D3D12_RESOURCE_STATE_COMMON, &optClear,
+        defaultDepthStencilAllocation_);
+    if (!defaultDepthStencil_)
     {
-        D3D_SAFE_RELEASE(defaultDepthStencil_);
-        LOGERROR("Create default depth setncil buffer failed. (HRESULT %x)", hr);
+        LOGERROR("Create default depth setncil buffer failed.");
         return false;
     }
 
@@ -177,15 +255,68 @@ bool GraphicsImpl::ResetDepthStencilView(int width, int height, unsigned sampleC
     device_->CreateDepthStencilView(defaultDepthStencil_, &dsvDesc, DepthStencilView());
 
     // Transition resource state from common to depth buffer
-    commandList_->ResourceBarrier(1, &Transition(defaultDepthStencil_, 
-        D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_DEPTH_WRITE));
+    stateRegistry_.RegisterResource(defaultDepthStencil_, 1, RESOURCE_STATE_COMMON);
+    stateTracker_.Transition(defaultDepthStencil_, RESOURCE_STATE_DEPTH_WRITE);
 
-    ExecuteCommandList();
-    FlushCommandQueue();
+    // Submit without waiting, the frame slot whose allocator recorded the barrier waits for it before reuse
+    Submit();
+    framePacer_.ExtendFrame(fenceTimeline_.Signal());
 
     return true;
 }
 
+void GraphicsImpl::DeferRelease(ID3D12Resource* resource)
+{
+    if (!resource)
+        return;
+
+    stateRegistry_.UnregisterResource(resource);
+
+    D3D12_RESOURCE_DESC desc = resource->GetDesc();
+    D3D12_RESOURCE_ALLOCATION_INFO info = device_->GetResourceAllocationInfo(0, 1, &desc);
+
+    GraphicsBackend::DeferRelease(resource, ReleaseObject, info.SizeInBytes);
+}
+
+ID3D12Resource* GraphicsImpl::CreatePlacedResource(D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+    D3D12_CLEAR_VALUE const* clearValue, GpuAllocation& allocation)
+{
+    GpuHeapCategory category = GPU_HEAP_TEXTURES;
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        category = GPU_HEAP_BUFFERS;
+    else if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+        category = GPU_HEAP_RENDER_TARGETS;
+
+    // Small textures may be placed at 4KB instead of 64KB, the device reports whether this one qualifies
+    D3D12_RESOURCE_ALLOCATION_INFO info;
+    if (category == GPU_HEAP_TEXTURES && desc.SampleDesc.Count == 1)
+    {
+        desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        info = device_->GetResourceAllocationInfo(0, 1, &desc);
+        if (info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+            desc.Alignment = 0;
+    }
+    if (!desc.Alignment)
+        info = device_->GetResourceAllocationInfo(0, 1, &desc);
+
+    allocation = heapAllocator_.Allocate(category, info.SizeInBytes, info.Alignment);
+    if (!allocation.IsValid())
+        return nullptr;
+
+    ID3D12Resource* resource = nullptr;
+    HRESULT hr = device_->CreatePlacedResource((ID3D12Heap*) allocation.heap_, allocation.offset_, &desc,
+        initialState, clearValue, IID_PPV_ARGS(&resource));
+    if (FAILED(hr))
+    {
+        D3D_SAFE_RELEASE(resource);
+        heapAllocator_.Free(allocation);
+        LOGERROR("Create placed resource failed. (HRESULT %x)", hr);
+        return nullptr;
+    }
+
+    return resource;
+}
+
 unsigned GraphicsImpl::GetMultiSampleQuality(DXGI_FORMAT format, unsigned sampleCount) const
 {
     if (sampleCount < 2)
@@ -203,15 +334,18 @@ unsigned GraphicsImpl::GetMultiSampleQuality(DXGI_FORMAT format, unsigned sample
 
 D3D12_CPU_DESCRIPTOR_HANDLE GraphicsImpl::CurrentBackBufferView() const
 {
-    D3D12_CPU_DESCRIPTOR_HANDLE handle = renderTargetViewHeap_->GetCPUDescriptorHandleForHeapStart();
-    handle.ptr += currentBackBufferIndex_ * renderTargetViewSize_;
+    D3D12_CPU_DESCRIPTOR_HANDLE handle;
+    handle.ptr = renderTargetViews_[currentBackBufferIndex_].cpu_;
 
     return handle;
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE GraphicsImpl::DepthStencilView() const
 {
-    return depthStencilViewHeap_->GetCPUDescriptorHandleForHeapStart();
+    D3D12_CPU_DESCRIPTOR_HANDLE handle;
+    handle.ptr = depthStencilView_.cpu_;
+
+    return handle;
 }
 
 ID3D12Resource* GraphicsImpl::CurrentBackBuffer() const
@@ -247,23 +381,16 @@ void GraphicsImpl::ResetViewport(int width, int height)
     scissor_ = { 0, 0, width, height };
 }
 
-void GraphicsImpl::FlushCommandQueue()
+CommandList* GraphicsImpl::CreateCommandList(GpuQueueType type)
 {
-    ++fenceValue_;
-    commandQueue_->Signal(fence_, fenceValue_);
-
-    // Wait GPu completed
-    if (fence_->GetCompletedValue() < fenceValue_)
-    {
-        HANDLE event = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
-        fence_->SetEventOnCompletion(fenceValue_, event);
+    std::unique_ptr<D3D12CommandList> commandList(new D3D12CommandList(*this, type));
+    if (!commandList->Create())
+        return nullptr;
 
-        WaitForSingleObject(event, INFINITE);
-        CloseHandle(event);
-    }
+    return commandList.release();
 }
 
-void GraphicsImpl::ExecuteCommandList()
+void GraphicsImpl::ExecuteCommandLists(CommandList* const* commandLists, unsigned count)
 {
     HRESULT hr = commandList_->Close();
     if (FAILED(hr))
@@ -272,41 +399,102 @@ void GraphicsImpl::ExecuteCommandList()
         return;
     }
 
-    ID3D12CommandList* commandLists[] = { commandList_ };
-    commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
+    // One call for all lists, each ExecuteCommandLists has a fixed cost on the queue
+    executeScratch_.resize(count + 1);
+    executeScratch_[0] = commandList_;
+    for (unsigned i = 0; i < count; ++i)
+        executeScratch_[i + 1] = static_cast<D3D12CommandList*>(commandLists[i])->GetCommandList();
+
+    commandQueue_->ExecuteCommandLists((UINT) executeScratch_.size(), executeScratch_.data());
 }
 
-void GraphicsImpl::Begin()
+void GraphicsImpl::ResetCommandList(unsigned frameIndex)
 {
-    commandAllocator_->Reset();
-    commandList_->Reset(commandAllocator_, nullptr);
+    commandAllocators_[frameIndex]->Reset();
+    commandList_->Reset(commandAllocators_[frameIndex], nullptr);
 
-    commandList_->ResourceBarrier(1, &Transition(
-        CurrentBackBuffer(), 
-        D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET)
-    );
+    // Bind the shader visible ring so transient descriptor tables can be used anywhere in the frame
+    ID3D12DescriptorHeap* heaps[] = { (ID3D12DescriptorHeap*) descriptorAllocator_.GetRing()->GetHeapInfo().heap_ };
+    commandList_->SetDescriptorHeaps(_countof(heaps), heaps);
+}
+
+void GraphicsImpl::ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers)
+{
+    // Translate the whole batch so it is recorded with a single call
+    TranslateBarriers(count, barriers, barrierScratch_);
+    commandList_->ResourceBarrier(count, barrierScratch_.data());
+}
+
+void GraphicsImpl::TranslateBarriers(unsigned count, ResourceBarrierDesc const* barriers, std::vector<D3D12_RESOURCE_BARRIER>& dest)
+{
+    dest.resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (barriers[i].type_ == RESOURCE_BARRIER_TYPE_ALIASING)
+        {
+            D3D12_RESOURCE_BARRIER& barrier = dest[i];
+            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            barrier.Aliasing.pResourceBefore = (ID3D12Resource*) barriers[i].aliasBefore_;
+            barrier.Aliasing.pResourceAfter = (ID3D12Resource*) barriers[i].resource_;
+            continue;
+        }
+
+        dest[i] = Transition((ID3D12Resource*) barriers[i].resource_, (D3D12_RESOURCE_STATES) barriers[i].before_,
+            (D3D12_RESOURCE_STATES) barriers[i].after_, barriers[i].subresource_, (D3D12_RESOURCE_BARRIER_FLAGS) barriers[i].flags_);
+    }
+}
 
+void GraphicsImpl::SetDefaultViewport()
+{
     commandList_->RSSetViewports(1, &viewport_);
     commandList_->RSSetScissorRects(1, &scissor_);
+}
+
+void GraphicsImpl::SetPipelineState(PipelineStateHandle state)
+{
+    D3D12PipelineState* d3dState = (D3D12PipelineState*) state;
+    commandList_->SetPipelineState(d3dState->pipelineState_);
+    if (d3dState->rootSignature_)
+        commandList_->SetGraphicsRootSignature(d3dState->rootSignature_);
+}
 
-    float clearColor[4] = {0.2f, 0.3f, 0.7f, 1.0f};
-    commandList_->ClearRenderTargetView(CurrentBackBufferView(), clearColor, 0, nullptr);
-    commandList_->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+void GraphicsImpl::ClearRenderTarget(float const color[4])
+{
+    commandList_->ClearRenderTargetView(CurrentBackBufferView(), color, 0, nullptr);
+}
 
+void GraphicsImpl::ClearDepthStencil(float depth, unsigned char stencil)
+{
+    commandList_->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, depth, stencil, 0, nullptr);
+}
+
+void GraphicsImpl::SetDefaultRenderTargets()
+{
     commandList_->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
 }
 
-void GraphicsImpl::End()
+void GraphicsImpl::WaitForFrameLatency()
 {
-    commandList_->ResourceBarrier(1, &Transition(
-        CurrentBackBuffer(),
-        D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT)
-    );
+    if (!frameLatencyWaitableObject_)
+    {
+        GraphicsBackend::WaitForFrameLatency();
+        return;
+    }
 
-    ExecuteCommandList();
+    // The swap chain keeps its bound when the latency is set to 0, it must be waited on regardless
+    if (maxFrameLatency_ && swapChainFrameLatency_ != maxFrameLatency_)
+    {
+        swapChain2_->SetMaximumFrameLatency(maxFrameLatency_);
+        swapChainFrameLatency_ = maxFrameLatency_;
+    }
+
+    // Bounded so a lost device or a minimized window cannot hang the frame loop
+    WaitForSingleObjectEx(frameLatencyWaitableObject_, 1000, TRUE);
+}
 
+void GraphicsImpl::Present()
+{
     swapChain_->Present(0, 0);
     currentBackBufferIndex_ = (currentBackBufferIndex_ + 1) % SwapChainBufferCount;
-
-    FlushCommandQueue();
 }
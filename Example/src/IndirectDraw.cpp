@@ -0,0 +1,63 @@
+#include "IndirectDraw.h"
+#include "CommandList.h"
+#include "Profiler.h"
+
+
+IndirectDrawBatch::IndirectDrawBatch() = default;
+
+void IndirectDrawBatch::SetMesh(unsigned objectIndex, IndirectMesh const& mesh)
+{
+    if (objectIndex >= meshes_.size())
+        meshes_.resize(objectIndex + 1);
+    meshes_[objectIndex] = mesh;
+}
+
+bool IndirectDrawBatch::Build(std::vector<unsigned> const& objects, UploadRing& ring)
+{
+    PROFILE_SCOPE("BuildIndirectDraws");
+
+    arguments_ = UploadAllocation();
+    drawCount_ = 0;
+    if (objects.empty())
+        return true;
+
+    arguments_ = ring.Allocate(objects.size() * sizeof(IndirectDrawArguments));
+    if (!arguments_.IsValid())
+        return false;
+
+    // Upload memory is write-combined, so records are written whole and in order and never read back
+    IndirectDrawArguments* dest = (IndirectDrawArguments*) arguments_.cpu_;
+    IndirectMesh const* meshes = meshes_.data();
+    unsigned meshCount = (unsigned) meshes_.size();
+    unsigned count = 0;
+    for (unsigned object : objects)
+    {
+        if (object >= meshCount || !meshes[object].indexCount_)
+            continue;
+
+        IndirectMesh const& mesh = meshes[object];
+        IndirectDrawArguments arguments;
+        arguments.objectIndex_ = object;
+        arguments.indexCount_ = mesh.indexCount_;
+        arguments.instanceCount_ = 1;
+        arguments.firstIndex_ = mesh.firstIndex_;
+        arguments.baseVertex_ = mesh.baseVertex_;
+        arguments.firstInstance_ = 0;
+        dest[count++] = arguments;
+    }
+
+    drawCount_ = count;
+    return true;
+}
+
+void IndirectDrawBatch::Execute(CommandList& commandList, uint64_t objectData) const
+{
+    if (!drawCount_ || !state_.commandSignature_)
+        return;
+
+    commandList.SetRootSignature(state_.rootSignature_);
+    commandList.SetPipelineStateObject(state_.pipelineState_);
+    commandList.SetRootShaderResource(state_.objectDataParameter_, objectData);
+    commandList.SetIndexBuffer(state_.indexBuffer_);
+    commandList.ExecuteIndirect(state_.commandSignature_, drawCount_, arguments_.resource_, arguments_.offset_);
+}
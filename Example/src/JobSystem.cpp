@@ -0,0 +1,151 @@
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+
+static thread_local unsigned threadIndex = 0;
+
+JobSystem::JobSystem(unsigned workerCount)
+{
+    if (!workerCount)
+    {
+        unsigned cores = std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    for (unsigned i = 0; i <= workerCount; ++i)
+        queues_.emplace_back(new ThreadQueue());
+
+    for (unsigned i = 1; i <= workerCount; ++i)
+        workers_.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeCondition_.notify_all();
+
+    for (std::thread& worker : workers_)
+        worker.join();
+}
+
+void JobSystem::Run(JobFunction function, JobCounter* counter)
+{
+    if (counter)
+        counter->count_.fetch_add(1, std::memory_order_relaxed);
+
+    unsigned index = threadIndex < queues_.size() ? threadIndex : 0;
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex_);
+        queues_[index]->jobs_.push_back({ std::move(function), counter });
+    }
+
+    // Taking the lock orders the increment before a worker's check, so the wakeup cannot be missed
+    queuedCount_.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wakeCondition_.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    unsigned index = threadIndex < queues_.size() ? threadIndex : 0;
+
+    while (!counter.IsDone())
+    {
+        if (!RunOne(index))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::ParallelFor(unsigned count, unsigned batchSize, std::function<void(unsigned begin, unsigned end)> const& function)
+{
+    if (!batchSize)
+        batchSize = 1;
+
+    JobCounter counter;
+    for (unsigned begin = 0; begin < count; begin += batchSize)
+    {
+        unsigned end = begin + batchSize < count ? begin + batchSize : count;
+        Run([&function, begin, end]() { function(begin, end); }, &counter);
+    }
+
+    Wait(counter);
+}
+
+unsigned JobSystem::GetThreadIndex()
+{
+    return threadIndex;
+}
+
+bool JobSystem::TakeJob(unsigned index, Job& job)
+{
+    // Newest own job first, it is the most likely to still be in cache
+    {
+        ThreadQueue& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        if (!queue.jobs_.empty())
+        {
+            job = std::move(queue.jobs_.back());
+            queue.jobs_.pop_back();
+            return true;
+        }
+    }
+
+    // Oldest job of another thread, usually the root of the largest remaining subtree
+    unsigned count = (unsigned) queues_.size();
+    for (unsigned i = 1; i < count; ++i)
+    {
+        ThreadQueue& queue = *queues_[(index + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        if (!queue.jobs_.empty())
+        {
+            job = std::move(queue.jobs_.front());
+            queue.jobs_.pop_front();
+            stealCount_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool JobSystem::RunOne(unsigned index)
+{
+    if (!queuedCount_.load(std::memory_order_acquire))
+        return false;
+
+    Job job;
+    if (!TakeJob(index, job))
+        return false;
+
+    queuedCount_.fetch_sub(1, std::memory_order_relaxed);
+    {
+        PROFILE_SCOPE("Job");
+        job.function_();
+    }
+
+    if (job.counter_)
+        job.counter_->count_.fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
+
+void JobSystem::WorkerLoop(unsigned index)
+{
+    threadIndex = index;
+    Profiler::Get().SetThreadName("Worker " + std::to_string(index));
+
+    while (!stopping_)
+    {
+        if (RunOne(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wakeCondition_.wait(lock, [this]() { return stopping_ || queuedCount_.load(std::memory_order_acquire) > 0; });
+    }
+}
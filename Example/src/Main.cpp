@@ -1,16 +1,31 @@
+#if defined(_WIN32)
 #include <crtdbg.h>
 #include <windows.h>
+#endif
 #include "Application.h"
 
 
+#if defined(_WIN32)
 int WINAPI WinMain(HINSTANCE hPrevInstance, HINSTANCE hInstance, PSTR pCmdLine, int nCmdLine)
 {
 #if defined(_DEBUG)
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
-    
+
     std::shared_ptr<Application> application(new Application);
-    application->Run();
+    application->ParseArguments(pCmdLine);
+    return application->Run();
+}
+#else
+int main(int argc, char** argv)
+{
+    // Without Direct3D12 the application runs headless, e.g. "-frames 1000" for a fixed number of frames
+    std::string commandLine("-headless");
+    for (int i = 1; i < argc; ++i)
+        commandLine += std::string(" ") + argv[i];
 
-    return 0;
-}
\ No newline at end of file
+    std::shared_ptr<Application> application(new Application);
+    application->ParseArguments(commandLine);
+    return application->Run();
+}
+#endif
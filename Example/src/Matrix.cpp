@@ -0,0 +1,119 @@
+#include "Matrix.h"
+
+#include <cmath>
+
+
+Matrix4 Matrix4::Translation(Vector3 const& translation)
+{
+    Matrix4 ret;
+    ret.rows_[3] = Vector4(translation, 1.0f);
+    return ret;
+}
+
+Matrix4 Matrix4::Scaling(Vector3 const& scale)
+{
+    Matrix4 ret;
+    ret.rows_[0].x_ = scale.x_;
+    ret.rows_[1].y_ = scale.y_;
+    ret.rows_[2].z_ = scale.z_;
+    return ret;
+}
+
+Matrix4 Matrix4::Rotation(Quaternion const& q)
+{
+    return FromTRS(Vector3(), q, Vector3(1.0f, 1.0f, 1.0f));
+}
+
+Matrix4 Matrix4::FromTRS(Vector3 const& translation, Quaternion const& q, Vector3 const& scale)
+{
+    float xx = q.x_ * q.x_, yy = q.y_ * q.y_, zz = q.z_ * q.z_;
+    float xy = q.x_ * q.y_, xz = q.x_ * q.z_, yz = q.y_ * q.z_;
+    float wx = q.w_ * q.x_, wy = q.w_ * q.y_, wz = q.w_ * q.z_;
+
+    // Scaling first scales the rows of the rotation
+    return Matrix4(
+        Vector4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x_,
+        Vector4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y_,
+        Vector4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z_,
+        Vector4(translation, 1.0f));
+}
+
+Matrix4 Matrix4::LookAt(Vector3 const& eye, Vector3 const& at, Vector3 const& up)
+{
+    Vector3 z = (at - eye).Normalized();
+    Vector3 x = up.Cross(z).Normalized();
+    Vector3 y = z.Cross(x);
+
+    return Matrix4(
+        Vector4(x.x_, y.x_, z.x_, 0.0f),
+        Vector4(x.y_, y.y_, z.y_, 0.0f),
+        Vector4(x.z_, y.z_, z.z_, 0.0f),
+        Vector4(-x.Dot(eye), -y.Dot(eye), -z.Dot(eye), 1.0f));
+}
+
+Matrix4 Matrix4::Perspective(float fovY, float aspect, float nearZ, float farZ)
+{
+    float height = 1.0f / std::tan(fovY * 0.5f);
+    float range = farZ / (farZ - nearZ);
+
+    return Matrix4(
+        Vector4(height / aspect, 0.0f, 0.0f, 0.0f),
+        Vector4(0.0f, height, 0.0f, 0.0f),
+        Vector4(0.0f, 0.0f, range, 1.0f),
+        Vector4(0.0f, 0.0f, -range * nearZ, 0.0f));
+}
+
+Matrix4 Matrix4::Transposed() const
+{
+    Matrix4 const& m = *this;
+    return Matrix4(
+        Vector4(m.rows_[0].x_, m.rows_[1].x_, m.rows_[2].x_, m.rows_[3].x_),
+        Vector4(m.rows_[0].y_, m.rows_[1].y_, m.rows_[2].y_, m.rows_[3].y_),
+        Vector4(m.rows_[0].z_, m.rows_[1].z_, m.rows_[2].z_, m.rows_[3].z_),
+        Vector4(m.rows_[0].w_, m.rows_[1].w_, m.rows_[2].w_, m.rows_[3].w_));
+}
+
+Matrix4 Matrix4::Inverse() const
+{
+    float const* m = &rows_[0].x_;
+    float inv[16];
+
+    // Cofactors, from the 2x2 minors of the lower and upper halves
+    float s0 = m[0] * m[5] - m[4] * m[1];
+    float s1 = m[0] * m[6] - m[4] * m[2];
+    float s2 = m[0] * m[7] - m[4] * m[3];
+    float s3 = m[1] * m[6] - m[5] * m[2];
+    float s4 = m[1] * m[7] - m[5] * m[3];
+    float s5 = m[2] * m[7] - m[6] * m[3];
+    float c5 = m[10] * m[15] - m[14] * m[11];
+    float c4 = m[9] * m[15] - m[13] * m[11];
+    float c3 = m[9] * m[14] - m[13] * m[10];
+    float c2 = m[8] * m[15] - m[12] * m[11];
+    float c1 = m[8] * m[14] - m[12] * m[10];
+    float c0 = m[8] * m[13] - m[12] * m[9];
+
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0.0f)
+        return Matrix4();
+    float invDet = 1.0f / det;
+
+    inv[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * invDet;
+    inv[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * invDet;
+    inv[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * invDet;
+    inv[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * invDet;
+    inv[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * invDet;
+    inv[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * invDet;
+    inv[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * invDet;
+    inv[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * invDet;
+    inv[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * invDet;
+    inv[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * invDet;
+    inv[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * invDet;
+    inv[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * invDet;
+    inv[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * invDet;
+    inv[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * invDet;
+    inv[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * invDet;
+    inv[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * invDet;
+
+    return Matrix4(Vector4(inv[0], inv[1], inv[2], inv[3]), Vector4(inv[4], inv[5], inv[6], inv[7]),
+        Vector4(inv[8], inv[9], inv[10], inv[11]), Vector4(inv[12], inv[13], inv[14], inv[15]));
+}
@@ -0,0 +1,37 @@
+
+#include "NullDescriptorHeapFactory.h"
+
+
+NullDescriptorHeapFactory::NullDescriptorHeapFactory(unsigned increment)
+    : increment_(increment)
+    , nextAddress_(0x10000)
+{
+}
+
+bool NullDescriptorHeapFactory::CreateHeap(DescriptorHeapType /*type*/, unsigned capacity, bool shaderVisible, DescriptorHeapInfo& info)
+{
+    info.heap_ = (void*) nextAddress_;
+    info.cpuStart_ = nextAddress_;
+    info.gpuStart_ = shaderVisible ? (uint64_t) nextAddress_ : 0;
+    info.increment_ = increment_;
+    info.capacity_ = capacity;
+
+    // Leave a gap between heaps so ranges of different heaps are never adjacent
+    nextAddress_ += ((size_t) capacity + 1) * increment_;
+    ++heapCount_;
+    return true;
+}
+
+void NullDescriptorHeapFactory::DestroyHeap(DescriptorHeapInfo& info)
+{
+    info = DescriptorHeapInfo();
+    --heapCount_;
+}
+
+void NullDescriptorHeapFactory::CopyDescriptors(DescriptorHeapType /*type*/, size_t /*destStart*/, unsigned rangeCount,
+    size_t const* /*rangeStarts*/, unsigned const* rangeSizes)
+{
+    ++copyCount_;
+    for (unsigned i = 0; i < rangeCount; ++i)
+        copiedDescriptorCount_ += rangeSizes[i];
+}
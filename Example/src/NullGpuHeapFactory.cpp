@@ -0,0 +1,20 @@
+
+#include "NullGpuHeapFactory.h"
+
+
+bool NullGpuHeapFactory::CreateHeap(GpuHeapCategory /*category*/, uint64_t size, GpuHeapInfo& info)
+{
+    info.heap_ = (void*) nextHeap_++;
+    info.size_ = size;
+
+    ++heapCount_;
+    heapBytes_ += size;
+    return true;
+}
+
+void NullGpuHeapFactory::DestroyHeap(GpuHeapInfo& info)
+{
+    --heapCount_;
+    heapBytes_ -= info.size_;
+    info = GpuHeapInfo();
+}
@@ -0,0 +1,275 @@
+
+#include "NullGraphicsBackend.h"
+
+#include <cassert>
+#include <cstring>
+
+
+void NullGraphicsBackend::RecordingFence::Signal(uint64_t value)
+{
+    backend_.Record(RECORD_SIGNAL, value);
+    backend_.queue_.Signal(value);
+}
+
+NullCommandList::NullCommandList(NullGraphicsBackend& backend)
+    : CommandList(backend.stateRegistry_)
+    , backend_(backend)
+{
+}
+
+void NullCommandList::Reset(unsigned frameIndex)
+{
+    assert(!open_);
+    assert(frameIndex < backend_.framePacer_.GetFramesInFlight());
+
+    commands_.clear();
+    open_ = true;
+    Record(RECORD_RESET_COMMAND_LIST, frameIndex);
+}
+
+void NullCommandList::ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers)
+{
+    assert(open_);
+
+    for (unsigned i = 0; i < count; ++i)
+        Record(RECORD_RESOURCE_BARRIER, 0, &barriers[i]);
+}
+
+void NullCommandList::SetDefaultViewport()
+{
+    assert(open_);
+    Record(RECORD_SET_VIEWPORT);
+}
+
+void NullCommandList::SetPipelineState(PipelineStateHandle state)
+{
+    assert(open_);
+    Record(RECORD_SET_PIPELINE_STATE, (uint64_t) state);
+}
+
+void NullCommandList::SetPipelineStateObject(PipelineStateHandle state)
+{
+    assert(open_);
+    Record(RECORD_SET_PIPELINE_STATE, (uint64_t) state);
+}
+
+void NullCommandList::SetRootSignature(RootSignatureHandle rootSignature)
+{
+    assert(open_);
+    Record(RECORD_SET_ROOT_SIGNATURE, (uint64_t) rootSignature);
+}
+
+void NullCommandList::SetDescriptorTable(unsigned /*rootParameter*/, uint64_t gpuAddress)
+{
+    assert(open_);
+    Record(RECORD_SET_DESCRIPTOR_TABLE, gpuAddress);
+}
+
+void NullCommandList::SetVertexBuffer(VertexBufferView const& view)
+{
+    assert(open_);
+    Record(RECORD_SET_VERTEX_BUFFER, view.gpuAddress_);
+}
+
+void NullCommandList::DrawInstanced(unsigned vertexCount, unsigned /*instanceCount*/, unsigned /*firstVertex*/, unsigned /*firstInstance*/)
+{
+    assert(open_);
+    Record(RECORD_DRAW, vertexCount);
+}
+
+void NullCommandList::SetIndexBuffer(IndexBufferView const& view)
+{
+    assert(open_);
+    Record(RECORD_SET_INDEX_BUFFER, view.gpuAddress_);
+}
+
+void NullCommandList::SetRootShaderResource(unsigned /*rootParameter*/, uint64_t gpuAddress)
+{
+    assert(open_);
+    Record(RECORD_SET_ROOT_SHADER_RESOURCE, gpuAddress);
+}
+
+void NullCommandList::CopyBufferRegion(ResourceHandle dest, uint64_t destOffset, ResourceHandle source, uint64_t sourceOffset, uint64_t size)
+{
+    assert(open_);
+    Record(RECORD_COPY_BUFFER, size);
+
+    // Buffers of the null factories are their memory. Copying when recorded rather than when executed is
+    // only wrong if the source changes in between, which upload memory of the frame does not
+    memcpy((uint8_t*) dest + destOffset, (uint8_t const*) source + sourceOffset, (size_t) size);
+}
+
+void NullCommandList::ExecuteIndirect(CommandSignatureHandle /*signature*/, unsigned count, ResourceHandle /*argumentBuffer*/, uint64_t /*argumentOffset*/)
+{
+    assert(open_);
+    Record(RECORD_EXECUTE_INDIRECT, count);
+}
+
+void NullCommandList::SetDefaultRenderTargets()
+{
+    assert(open_);
+    Record(RECORD_SET_RENDER_TARGETS, backend_.currentBackBufferIndex_);
+}
+
+void NullCommandList::Close()
+{
+    assert(open_);
+    open_ = false;
+}
+
+void NullCommandList::Record(RecordedCommandType type, uint64_t value, ResourceBarrierDesc const* barrier)
+{
+    RecordedCommand command;
+    command.type_ = type;
+    command.value_ = value;
+    if (barrier)
+        command.barrier_ = *barrier;
+
+    commands_.push_back(command);
+}
+
+NullGraphicsBackend::NullGraphicsBackend(int width, int height, bool threadedQueue)
+    : queue_(threadedQueue)
+    , fence_(*this)
+    , directQueue_(queue_)
+    , computeQueue_(threadedQueue)
+    , copyQueue_(threadedQueue)
+    , scheduledQueues_{ &directQueue_, &computeQueue_, &copyQueue_ }
+    , width_(width)
+    , height_(height)
+{
+    fenceTimeline_.SetFence(&fence_);
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+        scheduler_.SetQueue((GpuQueueType) i, scheduledQueues_[i]);
+
+    for (unsigned i = 0; i < SwapChainBufferCount; ++i)
+        stateRegistry_.RegisterResource(&backBuffers_[i], 1, RESOURCE_STATE_PRESENT);
+
+    descriptorHeapFactory_.reset(new NullDescriptorHeapFactory());
+    descriptorAllocator_.Initialize(*descriptorHeapFactory_);
+
+    uploadBufferFactory_.reset(new NullUploadBufferFactory());
+    uploadRing_.Initialize(*uploadBufferFactory_, UploadRingSize);
+
+    pipelineStateFactory_.reset(new NullPipelineStateFactory());
+    pipelineCache_.Initialize(*pipelineStateFactory_);
+
+    heapFactory_.reset(new NullGpuHeapFactory());
+    heapAllocator_.Initialize(*heapFactory_);
+
+    residencyBackend_.reset(new NullResidencyBackend(&GetHeapFactory()));
+    residency_.Initialize(*residencyBackend_);
+    heapAllocator_.SetResidencyManager(&residency_);
+
+    transientResourceFactory_.reset(new NullTransientResourceFactory(stateRegistry_));
+    indirectDrawFactory_.reset(new NullIndirectDrawFactory());
+
+    timestampQuerySource_.reset(new NullTimestampQuerySource());
+    gpuProfiler_.Initialize(*timestampQuerySource_);
+}
+
+NullGraphicsBackend::~NullGraphicsBackend()
+{
+    // Let the simulated queue drain before it stops
+    FlushCommandQueue();
+    pipelineCache_.Shutdown();
+}
+
+void NullGraphicsBackend::ResetCommandList(unsigned frameIndex)
+{
+    assert(!commandListOpen_);
+    assert(frameIndex < framePacer_.GetFramesInFlight());
+
+    commandListOpen_ = true;
+    Record(RECORD_RESET_COMMAND_LIST, frameIndex);
+}
+
+void NullGraphicsBackend::ResourceBarrier(unsigned count, ResourceBarrierDesc const* barriers)
+{
+    assert(commandListOpen_);
+
+    for (unsigned i = 0; i < count; ++i)
+        Record(RECORD_RESOURCE_BARRIER, 0, &barriers[i]);
+}
+
+void NullGraphicsBackend::SetDefaultViewport()
+{
+    assert(commandListOpen_);
+    Record(RECORD_SET_VIEWPORT);
+}
+
+void NullGraphicsBackend::SetPipelineState(PipelineStateHandle state)
+{
+    assert(commandListOpen_);
+    Record(RECORD_SET_PIPELINE_STATE, (uint64_t) state);
+}
+
+void NullGraphicsBackend::ClearRenderTarget(float const /*color*/[4])
+{
+    assert(commandListOpen_);
+    Record(RECORD_CLEAR_RENDER_TARGET, currentBackBufferIndex_);
+}
+
+void NullGraphicsBackend::ClearDepthStencil(float /*depth*/, unsigned char /*stencil*/)
+{
+    assert(commandListOpen_);
+    Record(RECORD_CLEAR_DEPTH_STENCIL);
+}
+
+void NullGraphicsBackend::SetDefaultRenderTargets()
+{
+    assert(commandListOpen_);
+    Record(RECORD_SET_RENDER_TARGETS, currentBackBufferIndex_);
+}
+
+CommandList* NullGraphicsBackend::CreateCommandList(GpuQueueType /*type*/)
+{
+    return new NullCommandList(*this);
+}
+
+void NullGraphicsBackend::ExecuteCommandLists(CommandList* const* commandLists, unsigned count)
+{
+    assert(commandListOpen_);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        NullCommandList* commandList = static_cast<NullCommandList*>(commandLists[i]);
+        assert(commandList->IsClosed());
+
+        for (RecordedCommand const& command : commandList->GetRecordedCommands())
+            Record(command.type_, command.value_, &command.barrier_);
+    }
+
+    commandListOpen_ = false;
+    Record(RECORD_EXECUTE_COMMAND_LIST, count + 1);
+    queue_.Execute(gpuTime_);
+}
+
+void NullGraphicsBackend::Present()
+{
+    Record(RECORD_PRESENT, currentBackBufferIndex_);
+    currentBackBufferIndex_ = (currentBackBufferIndex_ + 1) % SwapChainBufferCount;
+}
+
+void NullGraphicsBackend::ClearRecording()
+{
+    commands_.clear();
+    for (unsigned i = 0; i < MAX_RECORDED_COMMAND_TYPES; ++i)
+        commandCounts_[i] = 0;
+}
+
+void NullGraphicsBackend::Record(RecordedCommandType type, uint64_t value, ResourceBarrierDesc const* barrier)
+{
+    ++commandCounts_[type];
+
+    if (!recording_)
+        return;
+
+    RecordedCommand command;
+    command.type_ = type;
+    command.value_ = value;
+    if (barrier)
+        command.barrier_ = *barrier;
+
+    commands_.push_back(command);
+}
@@ -0,0 +1,52 @@
+#include "NullIndirectDrawFactory.h"
+
+#include <new>
+
+
+/// Placeholder command signature.
+struct NullCommandSignature
+{
+    /// Root signature
+    RootSignatureHandle rootSignature_;
+    /// Root parameter of the object index
+    unsigned objectIndexParameter_;
+};
+
+bool NullIndirectDrawFactory::CreateBuffer(uint64_t size, GpuBufferInfo& info)
+{
+    uint8_t* memory = new (std::nothrow) uint8_t[(size_t) size]();
+    if (!memory)
+        return false;
+
+    info.resource_ = memory;
+    info.gpu_ = (uint64_t) (size_t) memory;
+    info.size_ = size;
+
+    ++bufferCount_;
+    bufferBytes_ += size;
+    return true;
+}
+
+void NullIndirectDrawFactory::DestroyBuffer(GpuBufferInfo& info)
+{
+    --bufferCount_;
+    bufferBytes_ -= info.size_;
+
+    delete[] (uint8_t*) info.resource_;
+    info = GpuBufferInfo();
+}
+
+CommandSignatureHandle NullIndirectDrawFactory::CreateCommandSignature(RootSignatureHandle rootSignature, unsigned objectIndexParameter)
+{
+    ++commandSignatureCount_;
+    return new NullCommandSignature{ rootSignature, objectIndexParameter };
+}
+
+void NullIndirectDrawFactory::ReleaseCommandSignature(CommandSignatureHandle signature)
+{
+    if (!signature)
+        return;
+
+    --commandSignatureCount_;
+    delete (NullCommandSignature*) signature;
+}
@@ -0,0 +1,49 @@
+#include "NullPipelineStateFactory.h"
+
+#include <cstring>
+#include <thread>
+
+
+PipelineStateHandle NullPipelineStateFactory::CreatePipelineState(PipelineDesc const& desc, void const* cachedBlob, size_t cachedBlobSize)
+{
+    NullPipelineState* state = new NullPipelineState();
+    state->hash_ = PipelineCache::HashDesc(desc);
+
+    if (cachedBlob)
+    {
+        std::vector<uint8_t> expected;
+        GetCachedBlob(state, expected);
+        if (cachedBlobSize != expected.size() || memcmp(cachedBlob, expected.data(), cachedBlobSize) != 0)
+        {
+            delete state;
+            return nullptr;
+        }
+
+        ++cachedCreateCount_;
+    }
+    else
+    {
+        if (compileTime_.count())
+            std::this_thread::sleep_for(compileTime_);
+        ++compileCount_;
+    }
+
+    ++pipelineStateCount_;
+    return state;
+}
+
+bool NullPipelineStateFactory::GetCachedBlob(PipelineStateHandle state, std::vector<uint8_t>& blob)
+{
+    NullPipelineState const* nullState = (NullPipelineState const*) state;
+    uint64_t values[] = { nullState->hash_.low_, nullState->hash_.high_, deviceId_ };
+
+    blob.resize(sizeof values);
+    memcpy(blob.data(), values, sizeof values);
+    return true;
+}
+
+void NullPipelineStateFactory::ReleasePipelineState(PipelineStateHandle state)
+{
+    delete (NullPipelineState*) state;
+    --pipelineStateCount_;
+}
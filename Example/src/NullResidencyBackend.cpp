@@ -0,0 +1,28 @@
+#include "NullResidencyBackend.h"
+
+
+NullResidencyBackend::NullResidencyBackend(NullGpuHeapFactory const* heapFactory)
+    : heapFactory_(heapFactory)
+{
+}
+
+bool NullResidencyBackend::QueryVideoMemory(VideoMemoryInfo& info)
+{
+    uint64_t usage = heapFactory_ ? heapFactory_->GetHeapBytes() : usage_;
+    info.budget_ = budget_;
+    info.usage_ = usage > evictedBytes_ ? usage - evictedBytes_ : 0;
+    return true;
+}
+
+bool NullResidencyBackend::MakeResident(ResidencyObject const* objects, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        evictedBytes_ -= objects[i].size_;
+    return true;
+}
+
+void NullResidencyBackend::Evict(ResidencyObject const* objects, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        evictedBytes_ += objects[i].size_;
+}
@@ -0,0 +1,30 @@
+#include "NullShaderCompilerBackend.h"
+#include "ByteStream.h"
+
+#include <thread>
+
+
+bool NullShaderCompilerBackend::Compile(std::string const& source, ShaderCompileDesc const& desc, std::vector<uint8_t>& bytecode, std::string& messages)
+{
+    ++compileCount_;
+    if (compileTime_.count())
+        std::this_thread::sleep_for(compileTime_);
+
+    size_t error = source.find("#error");
+    if (error != std::string::npos)
+    {
+        messages += source.substr(error, source.find('\n', error) - error) + "\n";
+        return false;
+    }
+
+    ContentHash hash = HashContent(source.data(), source.size());
+
+    bytecode.clear();
+    ByteWriter writer(bytecode);
+    writer.WriteU32(0x4c4c554e);
+    writer.WriteString(desc.entryPoint_);
+    writer.WriteString(desc.profile_);
+    writer.WriteU64(hash.low_);
+    writer.WriteU64(hash.high_);
+    return true;
+}
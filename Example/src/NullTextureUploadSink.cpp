@@ -0,0 +1,58 @@
+#include "NullTextureUploadSink.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+NullTextureUploadSink::NullTextureUploadSink(bool threaded)
+    : queue_(threaded)
+{
+}
+
+ResourceHandle NullTextureUploadSink::CreateTexture(TextureFileInfo const& info, unsigned firstMip,
+    ResourceHandle oldTexture, unsigned oldFirstMip)
+{
+    if (oldTexture)
+        pendingBytes_ += info.GetMipChainSize(std::max(firstMip, oldFirstMip));
+
+    ResourceHandle texture = (ResourceHandle) nextHandle_++;
+    uint64_t bytes = info.GetMipChainSize(firstMip);
+    textures_[texture] = bytes;
+    textureBytes_ += bytes;
+    ++createdTextureCount_;
+    return texture;
+}
+
+void NullTextureUploadSink::ReleaseTexture(ResourceHandle texture)
+{
+    auto it = textures_.find(texture);
+    assert(it != textures_.end());
+    if (it == textures_.end())
+        return;
+
+    textureBytes_ -= it->second;
+    textures_.erase(it);
+}
+
+void NullTextureUploadSink::UploadMip(ResourceHandle texture, TextureFileInfo const& info, unsigned firstMip,
+    unsigned mip, UploadAllocation const& staging)
+{
+    (void) texture;
+    (void) info;
+    (void) firstMip;
+    (void) mip;
+    assert(textures_.count(texture) && mip >= firstMip && staging.size_ == info.mips_[mip].GetUploadSize());
+    pendingBytes_ += staging.size_;
+    ++uploadedMipCount_;
+}
+
+uint64_t NullTextureUploadSink::Submit()
+{
+    if (pendingBytes_)
+        queue_.Execute(std::chrono::microseconds((pendingBytes_ + bandwidth_ - 1) / bandwidth_));
+    copiedBytes_ += pendingBytes_;
+    pendingBytes_ = 0;
+
+    queue_.Signal(++lastValue_);
+    return lastValue_;
+}
@@ -0,0 +1,77 @@
+#include "NullTimestampQuerySource.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+
+/// Epoch of the simulated GPU clock in seconds before the steady clock's, so it never matches the CPU's.
+static const uint64_t GpuClockEpoch = 1000;
+
+NullTimestampQuerySource::NullTimestampQuerySource(uint64_t frequency)
+    : frequency_(frequency)
+{
+    assert(frequency_);
+}
+
+bool NullTimestampQuerySource::Initialize(unsigned queryCount)
+{
+    queries_.assign(queryCount, 0);
+    readback_.assign(queryCount, 0);
+    return true;
+}
+
+void NullTimestampQuerySource::Shutdown()
+{
+    queries_.clear();
+    readback_.clear();
+}
+
+bool NullTimestampQuerySource::GetClockCalibration(uint64_t& gpuTimestamp, uint64_t& cpuTicks)
+{
+    gpuTimestamp = GetTimestamp();
+    cpuTicks = Profiler::GetTicks();
+    return true;
+}
+
+void NullTimestampQuerySource::EndQuery(unsigned index)
+{
+    assert(index < queries_.size());
+
+    queries_[index] = GetTimestamp();
+    ++endQueryCount_;
+}
+
+void NullTimestampQuerySource::ResolveQueries(unsigned first, unsigned count)
+{
+    assert(first + count <= queries_.size());
+
+    memcpy(&readback_[first], &queries_[first], count * sizeof(uint64_t));
+    resolvedQueryCount_ += count;
+}
+
+bool NullTimestampQuerySource::ReadQueries(unsigned first, unsigned count, uint64_t* timestamps)
+{
+    if (first + count > readback_.size())
+        return false;
+
+    memcpy(timestamps, &readback_[first], count * sizeof(uint64_t));
+    readQueryCount_ += count;
+    return true;
+}
+
+void NullTimestampQuerySource::SetManualClock(bool enable)
+{
+    if (enable && !manualClock_)
+        manualTimestamp_ = GetTimestamp();
+    manualClock_ = enable;
+}
+
+uint64_t NullTimestampQuerySource::GetTimestamp() const
+{
+    if (manualClock_)
+        return manualTimestamp_;
+
+    uint64_t nanoseconds = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    return (nanoseconds / 1000000000 + GpuClockEpoch) * frequency_ + nanoseconds % 1000000000 * frequency_ / 1000000000;
+}
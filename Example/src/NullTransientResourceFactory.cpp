@@ -0,0 +1,27 @@
+
+#include "NullTransientResourceFactory.h"
+
+
+NullTransientResourceFactory::NullTransientResourceFactory(ResourceStateRegistry& registry)
+    : TransientResourceFactory(registry)
+{
+}
+
+NullTransientResourceFactory::~NullTransientResourceFactory()
+{
+    ReleaseAll();
+}
+
+void NullTransientResourceFactory::GetAllocationInfo(TextureDesc const& desc, uint64_t& size, uint64_t& alignment)
+{
+    // Same placement alignments as Direct3D12 so aliasing behaves alike
+    alignment = desc.sampleCount_ > 1 ? 4 * 1024 * 1024 : 64 * 1024;
+    size = (uint64_t) desc.width_ * desc.height_ * desc.sampleCount_ * 4;
+    size = (size + alignment - 1) & ~(alignment - 1);
+}
+
+ResourceHandle NullTransientResourceFactory::CreateTexture(TextureDesc const& /*desc*/, uint64_t /*offset*/, unsigned /*initialState*/)
+{
+    ++createdTextureCount_;
+    return (ResourceHandle) nextHandle_++;
+}
@@ -0,0 +1,36 @@
+
+#include "NullUploadBufferFactory.h"
+
+#include <new>
+
+
+bool NullUploadBufferFactory::CreateBuffer(uint64_t size, UploadBufferInfo& info)
+{
+    // Device buffers start at a placement boundary, so over-allocate to align offsets the way the GPU would.
+    // The resource is the aligned memory too, as null command lists copy from it; the allocation is kept in
+    // front of it
+    uint8_t* memory = new (std::nothrow) uint8_t[(size_t) (size + sizeof(uint8_t*) + CONSTANT_BUFFER_ALIGNMENT - 1)];
+    if (!memory)
+        return false;
+
+    uint8_t* aligned = (uint8_t*) (((size_t) memory + sizeof(uint8_t*) + CONSTANT_BUFFER_ALIGNMENT - 1) &
+        ~(size_t) (CONSTANT_BUFFER_ALIGNMENT - 1));
+    ((uint8_t**) aligned)[-1] = memory;
+    info.resource_ = aligned;
+    info.cpu_ = aligned;
+    info.gpu_ = (uint64_t) (size_t) aligned;
+    info.size_ = size;
+
+    ++bufferCount_;
+    bufferBytes_ += size;
+    return true;
+}
+
+void NullUploadBufferFactory::DestroyBuffer(UploadBufferInfo& info)
+{
+    --bufferCount_;
+    bufferBytes_ -= info.size_;
+
+    delete[] ((uint8_t**) info.resource_)[-1];
+    info = UploadBufferInfo();
+}
@@ -0,0 +1,192 @@
+#include "ObjectBuffer.h"
+#include "CommandList.h"
+#include "GraphicsBackend.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+
+/// Buffer waiting for the GPU before it is destroyed.
+struct RetiredObjectBuffer
+{
+    /// Factory
+    IndirectDrawFactory* factory_;
+    /// Buffer
+    GpuBufferInfo buffer_;
+};
+
+static void DestroyRetiredObjectBuffer(void* object)
+{
+    RetiredObjectBuffer* retired = (RetiredObjectBuffer*) object;
+    retired->factory_->DestroyBuffer(retired->buffer_);
+    delete retired;
+}
+
+ObjectBuffer::ObjectBuffer() = default;
+
+ObjectBuffer::~ObjectBuffer()
+{
+    Shutdown();
+}
+
+bool ObjectBuffer::Initialize(GraphicsBackend& backend, unsigned stride)
+{
+    if (!stride || stride % 4)
+        return false;
+
+    Shutdown();
+    backend_ = &backend;
+    stride_ = stride;
+    return true;
+}
+
+void ObjectBuffer::Shutdown()
+{
+    if (buffer_.resource_)
+    {
+        backend_->GetStateRegistry().UnregisterResource(buffer_.resource_);
+        backend_->GetIndirectDrawFactory().DestroyBuffer(buffer_);
+    }
+
+    backend_ = nullptr;
+    data_.clear();
+    dirtyFlags_.clear();
+    dirty_.clear();
+    objectCount_ = 0;
+}
+
+void ObjectBuffer::Set(unsigned index, void const* data)
+{
+    assert(IsInitialized());
+
+    if (index >= objectCount_)
+    {
+        // Objects added in between are zeros, and dirty so the GPU sees the same
+        for (unsigned i = objectCount_; i < index; ++i)
+            dirty_.push_back(i);
+        objectCount_ = index + 1;
+        data_.resize((size_t) objectCount_ * stride_);
+        dirtyFlags_.resize(objectCount_, 1);
+        dirtyFlags_[index] = 0;
+    }
+
+    memcpy(data_.data() + (size_t) index * stride_, data, stride_);
+    if (!dirtyFlags_[index])
+    {
+        dirtyFlags_[index] = 1;
+        dirty_.push_back(index);
+    }
+}
+
+bool ObjectBuffer::Upload(CommandList& commandList)
+{
+    PROFILE_SCOPE("UploadObjects");
+
+    assert(IsInitialized());
+    stats_ = ObjectBufferStats();
+    if (dirty_.empty())
+        return true;
+
+    // A new buffer needs every object, also when its first upload failed
+    uint64_t size = (uint64_t) objectCount_ * stride_;
+    if (size > buffer_.size_ && !Grow(size))
+        return false;
+
+    stats_.dirtyObjects_ = (unsigned) dirty_.size();
+    runs_.clear();
+    uint64_t bytes = 0;
+    if (!uploadAll_)
+    {
+        // Few dirty objects are sorted, many are found faster by scanning the flags in order
+        if (dirty_.size() * ScanRatio < objectCount_)
+        {
+            std::sort(dirty_.begin(), dirty_.end());
+            for (unsigned index : dirty_)
+                AddToRuns(index);
+        }
+        else
+        {
+            for (unsigned index = 0; index < objectCount_; ++index)
+            {
+                if (dirtyFlags_[index])
+                    AddToRuns(index);
+            }
+        }
+
+        for (Run const& run : runs_)
+            bytes += (uint64_t) run.count_ * stride_;
+    }
+
+    // Copying everything at once is cheaper when the runs cover most of the buffer or are many
+    if (uploadAll_ || bytes + runs_.size() * CopyCost >= size)
+    {
+        runs_.clear();
+        runs_.push_back({ 0, objectCount_ });
+        bytes = size;
+        stats_.fullUpload_ = true;
+    }
+
+    UploadAllocation upload = backend_->GetUploadRing().Allocate(bytes);
+    if (!upload.IsValid())
+        return false;
+
+    ResourceStateTracker& tracker = commandList.GetStateTracker();
+    tracker.Transition(buffer_.resource_, RESOURCE_STATE_COPY_DEST);
+    commandList.FlushBarriers();
+
+    uint64_t offset = 0;
+    for (Run const& run : runs_)
+    {
+        uint64_t runOffset = (uint64_t) run.first_ * stride_;
+        uint64_t runBytes = (uint64_t) run.count_ * stride_;
+        memcpy(upload.cpu_ + offset, data_.data() + runOffset, (size_t) runBytes);
+        commandList.CopyBufferRegion(buffer_.resource_, runOffset, upload.resource_, upload.offset_ + offset, runBytes);
+        offset += runBytes;
+    }
+
+    tracker.Transition(buffer_.resource_, ShaderResourceState);
+    commandList.FlushBarriers();
+
+    for (unsigned index : dirty_)
+        dirtyFlags_[index] = 0;
+    dirty_.clear();
+    uploadAll_ = false;
+
+    stats_.copies_ = (unsigned) runs_.size();
+    stats_.bytes_ = bytes;
+    return true;
+}
+
+void ObjectBuffer::AddToRuns(unsigned index)
+{
+    if (!runs_.empty() && index - (runs_.back().first_ + runs_.back().count_) <= MaxRunGap)
+        runs_.back().count_ = index - runs_.back().first_ + 1;
+    else
+        runs_.push_back({ index, 1 });
+}
+
+bool ObjectBuffer::Grow(uint64_t size)
+{
+    uint64_t newSize = buffer_.size_ ? buffer_.size_ : (uint64_t) InitialCapacity * stride_;
+    while (newSize < size)
+        newSize *= 2;
+
+    IndirectDrawFactory& factory = backend_->GetIndirectDrawFactory();
+    GpuBufferInfo buffer;
+    if (!factory.CreateBuffer(newSize, buffer))
+        return false;
+
+    // Frames in flight may still read the old buffer
+    if (buffer_.resource_)
+    {
+        backend_->GetStateRegistry().UnregisterResource(buffer_.resource_);
+        backend_->DeferRelease(new RetiredObjectBuffer{ &factory, buffer_ }, DestroyRetiredObjectBuffer, buffer_.size_);
+    }
+
+    buffer_ = buffer;
+    uploadAll_ = true;
+    backend_->GetStateRegistry().RegisterResource(buffer_.resource_, 1, RESOURCE_STATE_COMMON);
+    return true;
+}
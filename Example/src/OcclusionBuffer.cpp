@@ -0,0 +1,396 @@
+#include "OcclusionBuffer.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+/// Pixel center offsets of the lanes of a row
+alignas(32) static float const laneOffsets[8]{ 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f };
+/// Pyramid levels a tile reduces itself, until its texels shrink to one
+static constexpr unsigned tileLevels{5};
+/// Smallest w of a box corner to project, nearer boxes are visible
+static constexpr float minW{1.0e-5f};
+
+static_assert(OcclusionBuffer::TileSize >> tileLevels == 1, "Tile levels must reduce a tile to one texel");
+
+/// Return whether a size is a power of two.
+static bool IsPowerOfTwo(unsigned x)
+{
+    return x && !(x & (x - 1));
+}
+
+OcclusionBuffer::OcclusionBuffer()
+{
+    SetSize(DefaultWidth, DefaultHeight);
+}
+
+bool OcclusionBuffer::SetSize(unsigned width, unsigned height)
+{
+    if (!IsPowerOfTwo(width) || !IsPowerOfTwo(height) || width < TileSize || height < TileSize)
+        return false;
+
+    width_ = width;
+    height_ = height;
+    tilesX_ = width / TileSize;
+
+    levelOffsets_.clear();
+    unsigned size = 0;
+    for (unsigned w = width, h = height; w && h; w >>= 1, h >>= 1)
+    {
+        levelOffsets_.push_back(size);
+        size += w * h;
+    }
+    depth_.assign(size, 1.0f);
+    bins_.resize(tilesX_ * (height / TileSize));
+    return true;
+}
+
+unsigned OcclusionBuffer::AddOccluder(std::vector<Vector3> vertices, std::vector<unsigned> indices)
+{
+    Occluder occluder;
+    if (!vertices.empty())
+    {
+        Vector3 min = vertices[0], max = vertices[0];
+        for (Vector3 const& v : vertices)
+        {
+            min = min.Min(v);
+            max = max.Max(v);
+        }
+        occluder.bounds_ = BoundingBox::FromMinMax(min, max);
+    }
+    occluder.vertices_ = std::move(vertices);
+    occluder.indices_ = std::move(indices);
+    occluders_.push_back(std::move(occluder));
+    return (unsigned) occluders_.size() - 1;
+}
+
+void OcclusionBuffer::Render(Matrix4 const& viewProjection)
+{
+    viewProjection_ = viewProjection;
+    stats_ = OcclusionStats();
+    triangles_.clear();
+    for (std::vector<unsigned>& bin : bins_)
+        bin.clear();
+
+    // Set up and bin on the calling thread, the triangles of a frame are few
+    Frustum frustum(viewProjection);
+    for (Occluder const& occluder : occluders_)
+    {
+        if (occluder.vertices_.empty() || !frustum.IsVisible(occluder.bounds_))
+            continue;
+        ++stats_.occluders_;
+
+        clipVertices_.resize(occluder.vertices_.size());
+        for (size_t i = 0; i < occluder.vertices_.size(); ++i)
+            clipVertices_[i] = viewProjection.Transform(Vector4(occluder.vertices_[i], 1.0f));
+
+        for (size_t i = 0; i + 2 < occluder.indices_.size(); i += 3)
+        {
+            Vector4 clip[3];
+            for (unsigned j = 0; j < 3; ++j)
+                clip[j] = clipVertices_[occluder.indices_[i + j]];
+            SetupTriangle(clip);
+        }
+    }
+    stats_.triangles_ = (unsigned) triangles_.size();
+
+    unsigned tileCount = (unsigned) bins_.size();
+    if (jobSystem_ && tileCount > 1)
+    {
+        jobSystem_->ParallelFor(tileCount, 1, [this](unsigned begin, unsigned end)
+        {
+            for (unsigned tile = begin; tile < end; ++tile)
+                RasterizeTile(tile);
+        });
+    }
+    else
+    {
+        for (unsigned tile = 0; tile < tileCount; ++tile)
+            RasterizeTile(tile);
+    }
+
+    // Levels coarser than a tile span several tiles
+    for (unsigned level = tileLevels + 1; level < GetLevelCount(); ++level)
+        Downsample(level, 0, 0, width_ >> level, height_ >> level);
+}
+
+bool OcclusionBuffer::IsVisible(BoundingBox const& box) const
+{
+    float minX = INFINITY, minY = INFINITY, minZ = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        Vector3 corner = box.center_ + box.extents_ * Vector3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+        Vector4 clip = viewProjection_.Transform(Vector4(corner, 1.0f));
+        if (!(clip.w_ > minW))
+            return true;
+
+        float x = clip.x_ / clip.w_, y = clip.y_ / clip.w_, z = clip.z_ / clip.w_;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        minZ = std::min(minZ, z);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+    return IsRectVisible(minX, minY, maxX, maxY, minZ);
+}
+
+unsigned OcclusionBuffer::Cull(BoundsArray const& boxes, std::vector<unsigned> const& ids, std::vector<unsigned>& visible)
+{
+    visible.clear();
+    unsigned count = boxes.GetSize();
+    stats_.tested_ += count;
+
+    float const* b[BoundsArray::ElementCount];
+    boxes.GetStreams(b);
+    Vector4 const* m = viewProjection_.rows_;
+
+    ForEachLanes(0, count, [&](unsigned i, auto lane)
+    {
+        typedef decltype(lane) F;
+
+        // Clip space center and the half edges of the box along each axis
+        F cx = F::Load(b[0] + i), cy = F::Load(b[1] + i), cz = F::Load(b[2] + i);
+        F ex = F::Load(b[3] + i), ey = F::Load(b[4] + i), ez = F::Load(b[5] + i);
+        F center[4], axisX[4], axisY[4], axisZ[4];
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            F m0 = F::Splat((&m[0].x_)[j]), m1 = F::Splat((&m[1].x_)[j]), m2 = F::Splat((&m[2].x_)[j]);
+            center[j] = MulAdd(cx, m0, MulAdd(cy, m1, MulAdd(cz, m2, F::Splat((&m[3].x_)[j]))));
+            axisX[j] = ex * m0;
+            axisY[j] = ey * m1;
+            axisZ[j] = ez * m2;
+        }
+
+        // Project the corners, the near plane case is left to the per-lane test
+        F minX = F::Splat(INFINITY), minY = minX, minZ = minX, minWs = minX;
+        F maxX = F::Splat(-INFINITY), maxY = maxX;
+        for (unsigned k = 0; k < 8; ++k)
+        {
+            F corner[4];
+            for (unsigned j = 0; j < 4; ++j)
+            {
+                F c = k & 1 ? center[j] + axisX[j] : center[j] - axisX[j];
+                c = k & 2 ? c + axisY[j] : c - axisY[j];
+                corner[j] = k & 4 ? c + axisZ[j] : c - axisZ[j];
+            }
+            F invW = F::Splat(1.0f) / corner[3];
+            F x = corner[0] * invW, y = corner[1] * invW, z = corner[2] * invW;
+            minX = Min(minX, x);
+            minY = Min(minY, y);
+            minZ = Min(minZ, z);
+            maxX = Max(maxX, x);
+            maxY = Max(maxY, y);
+            minWs = Min(minWs, corner[3]);
+        }
+
+        alignas(32) float rect[6][F::Width];
+        Store(rect[0], minX);
+        Store(rect[1], minY);
+        Store(rect[2], maxX);
+        Store(rect[3], maxY);
+        Store(rect[4], minZ);
+        Store(rect[5], minWs);
+        for (unsigned l = 0; l < F::Width; ++l)
+        {
+            if (!(rect[5][l] > minW) || IsRectVisible(rect[0][l], rect[1][l], rect[2][l], rect[3][l], rect[4][l]))
+                visible.push_back(ids[i + l]);
+        }
+    });
+
+    stats_.occluded_ += count - (unsigned) visible.size();
+    return (unsigned) visible.size();
+}
+
+void OcclusionBuffer::SetupTriangle(Vector4 const* clip)
+{
+    // Reject triangles wholly outside a side or the far plane
+    unsigned outside[5]{};
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        Vector4 const& v = clip[i];
+        outside[0] += v.x_ > v.w_;
+        outside[1] += v.x_ < -v.w_;
+        outside[2] += v.y_ > v.w_;
+        outside[3] += v.y_ < -v.w_;
+        outside[4] += v.z_ > v.w_;
+    }
+    for (unsigned count : outside)
+    {
+        if (count == 3)
+            return;
+    }
+
+    // Clip to the near plane z >= 0, one vertex in front splits the triangle into a quad
+    Vector4 polygon[4];
+    unsigned vertexCount = 0;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        Vector4 const& a = clip[i];
+        Vector4 const& b = clip[(i + 1) % 3];
+        bool aInside = a.z_ >= 0.0f, bInside = b.z_ >= 0.0f;
+        if (aInside)
+            polygon[vertexCount++] = a;
+        if (aInside != bInside)
+        {
+            float t = a.z_ / (a.z_ - b.z_);
+            polygon[vertexCount++] = a + (b - a) * Vector4(t, t, t, t);
+        }
+    }
+    if (vertexCount < 3)
+        return;
+    if (vertexCount == 4 || polygon[0].z_ != clip[0].z_ || polygon[1].z_ != clip[1].z_ || polygon[2].z_ != clip[2].z_)
+        ++stats_.clippedTriangles_;
+
+    Vector3 screen[4];
+    for (unsigned i = 0; i < vertexCount; ++i)
+    {
+        Vector4 const& v = polygon[i];
+        // Only a degenerate projection puts vertices past the near plane at w <= 0, drop those
+        if (!(v.w_ > 0.0f))
+            return;
+        float invW = 1.0f / v.w_;
+        screen[i] = Vector3((v.x_ * invW * 0.5f + 0.5f) * width_, (0.5f - v.y_ * invW * 0.5f) * height_, v.z_ * invW);
+    }
+    for (unsigned i = 1; i + 1 < vertexCount; ++i)
+        BinTriangle(screen[0], screen[i], screen[i + 1]);
+}
+
+void OcclusionBuffer::BinTriangle(Vector3 const& v0, Vector3 const& v1, Vector3 const& v2)
+{
+    // Set up in double, edge functions of far off vertices cancel out at the pixels
+    double x[3]{ v0.x_, v1.x_, v2.x_ }, y[3]{ v0.y_, v1.y_, v2.y_ }, z[3]{ v0.z_, v1.z_, v2.z_ };
+    double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (area == 0.0 || !std::isfinite(area))
+        return;
+    // Both windings are drawn, occluders need not be closed
+    if (area < 0.0)
+    {
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    // Pixel centers in bounds, clamped in float before conversion as vertices may be far off screen
+    double minX = std::max(std::min({ x[0], x[1], x[2] }), 0.0), maxX = std::min(std::max({ x[0], x[1], x[2] }), (double) width_);
+    double minY = std::max(std::min({ y[0], y[1], y[2] }), 0.0), maxY = std::min(std::max({ y[0], y[1], y[2] }), (double) height_);
+    RasterTriangle triangle;
+    triangle.minX_ = (int) std::floor(minX);
+    triangle.minY_ = (int) std::floor(minY);
+    triangle.maxX_ = std::min((int) std::floor(maxX), (int) width_ - 1);
+    triangle.maxY_ = std::min((int) std::floor(maxY), (int) height_ - 1);
+    if (triangle.minX_ > triangle.maxX_ || triangle.minY_ > triangle.maxY_)
+        return;
+
+    // Edge i is opposite vertex i, relative to the minimum pixel bounds
+    double originX = triangle.minX_, originY = triangle.minY_;
+    double edges[3][3];
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        unsigned a = (i + 1) % 3, b = (i + 2) % 3;
+        edges[i][0] = y[a] - y[b];
+        edges[i][1] = x[b] - x[a];
+        edges[i][2] = edges[i][0] * (originX - x[a]) + edges[i][1] * (originY - y[a]);
+        for (unsigned j = 0; j < 3; ++j)
+            triangle.edges_[i][j] = (float) edges[i][j];
+    }
+    // Depth interpolates by the barycentrics of vertices 1 and 2, which are edges 1 and 2 over the area
+    double dz1 = (z[1] - z[0]) / area, dz2 = (z[2] - z[0]) / area;
+    triangle.depth_[0] = (float) (edges[1][0] * dz1 + edges[2][0] * dz2);
+    triangle.depth_[1] = (float) (edges[1][1] * dz1 + edges[2][1] * dz2);
+    triangle.depth_[2] = (float) (z[0] + edges[1][2] * dz1 + edges[2][2] * dz2);
+
+    unsigned index = (unsigned) triangles_.size();
+    triangles_.push_back(triangle);
+    for (int ty = triangle.minY_ / (int) TileSize; ty <= triangle.maxY_ / (int) TileSize; ++ty)
+    {
+        for (int tx = triangle.minX_ / (int) TileSize; tx <= triangle.maxX_ / (int) TileSize; ++tx)
+            bins_[ty * tilesX_ + tx].push_back(index);
+    }
+}
+
+void OcclusionBuffer::RasterizeTile(unsigned tile)
+{
+    int tileX = (int) (tile % tilesX_ * TileSize), tileY = (int) (tile / tilesX_ * TileSize);
+    float* depth = depth_.data();
+    for (int y = tileY; y < tileY + (int) TileSize; ++y)
+        std::fill(depth + y * width_ + tileX, depth + y * width_ + tileX + TileSize, 1.0f);
+
+    typedef FloatN F;
+    F offsets = F::Load(laneOffsets);
+    for (unsigned index : bins_[tile])
+    {
+        RasterTriangle const& triangle = triangles_[index];
+        // Whole lanes from an aligned start, the tile being a multiple of the lane width
+        int x0 = std::max(triangle.minX_, tileX) & ~(int) (F::Width - 1), x1 = std::min(triangle.maxX_, tileX + (int) TileSize - 1);
+        int y0 = std::max(triangle.minY_, tileY), y1 = std::min(triangle.maxY_, tileY + (int) TileSize - 1);
+
+        float const(*e)[3] = triangle.edges_;
+        float const* d = triangle.depth_;
+        F a0 = F::Splat(e[0][0]), a1 = F::Splat(e[1][0]), a2 = F::Splat(e[2][0]), az = F::Splat(d[0]);
+        for (int y = y0; y <= y1; ++y)
+        {
+            float py = (float) (y - triangle.minY_) + 0.5f;
+            F r0 = F::Splat(e[0][1] * py + e[0][2]), r1 = F::Splat(e[1][1] * py + e[1][2]), r2 = F::Splat(e[2][1] * py + e[2][2]);
+            F rz = F::Splat(d[1] * py + d[2]);
+            float* row = depth + y * width_;
+            for (int x = x0; x <= x1; x += F::Width)
+            {
+                F px = F::Splat((float) (x - triangle.minX_)) + offsets;
+                F e0 = MulAdd(a0, px, r0), e1 = MulAdd(a1, px, r1), e2 = MulAdd(a2, px, r2);
+                F z = MulAdd(az, px, rz);
+                F current = F::Load(row + x);
+                // Outside pixels have a negative edge function, whose sign bit keeps their depth
+                Store(row + x, SelectNegative(Min(current, z), current, Min(e0, Min(e1, e2))));
+            }
+        }
+    }
+
+    for (unsigned level = 1; level <= tileLevels && level < GetLevelCount(); ++level)
+    {
+        Downsample(level, (unsigned) tileX >> level, (unsigned) tileY >> level, (unsigned) (tileX + TileSize) >> level,
+            (unsigned) (tileY + TileSize) >> level);
+    }
+}
+
+void OcclusionBuffer::Downsample(unsigned level, unsigned x0, unsigned y0, unsigned x1, unsigned y1)
+{
+    float const* src = GetDepth(level - 1);
+    float* dest = depth_.data() + levelOffsets_[level];
+    unsigned srcWidth = width_ >> (level - 1), destWidth = width_ >> level;
+    for (unsigned y = y0; y < y1; ++y)
+    {
+        float const* row0 = src + 2 * y * srcWidth;
+        float const* row1 = row0 + srcWidth;
+        for (unsigned x = x0; x < x1; ++x)
+            dest[y * destWidth + x] = std::max(std::max(row0[2 * x], row0[2 * x + 1]), std::max(row1[2 * x], row1[2 * x + 1]));
+    }
+}
+
+bool OcclusionBuffer::IsRectVisible(float minX, float minY, float maxX, float maxY, float minZ) const
+{
+    // Pixels covered, y growing down
+    float left = (minX * 0.5f + 0.5f) * width_, right = (maxX * 0.5f + 0.5f) * width_;
+    float top = (0.5f - maxY * 0.5f) * height_, bottom = (0.5f - minY * 0.5f) * height_;
+    // Off screen is the frustum culler's call, and NaNs fail every comparison
+    if (!(right >= 0.0f && bottom >= 0.0f && left < width_ && top < height_))
+        return true;
+
+    unsigned x0 = (unsigned) std::max(left, 0.0f), y0 = (unsigned) std::max(top, 0.0f);
+    unsigned x1 = (unsigned) std::min(right, width_ - 1.0f), y1 = (unsigned) std::min(bottom, height_ - 1.0f);
+    unsigned level = 0;
+    while (level + 1 < GetLevelCount() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+        ++level;
+
+    float const* depth = GetDepth(level);
+    unsigned levelWidth = width_ >> level;
+    float maxDepth = 0.0f;
+    for (unsigned y = y0 >> level; y <= y1 >> level; ++y)
+    {
+        for (unsigned x = x0 >> level; x <= x1 >> level; ++x)
+            maxDepth = std::max(maxDepth, depth[y * levelWidth + x]);
+    }
+    return !(minZ > maxDepth);
+}
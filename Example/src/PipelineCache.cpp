@@ -0,0 +1,292 @@
+#include "PipelineCache.h"
+#include "ByteStream.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+/// File identifier, "PSOC" little-endian.
+static const uint32_t PipelineCacheMagic = 0x434f5350;
+/// File format version, bump when the layout or the description serialization changes.
+static const uint32_t PipelineCacheVersion = 1;
+
+ContentHash PipelineCache::HashDesc(PipelineDesc const& desc)
+{
+    // Field by field so padding, pointers and vector capacities never reach the hash
+    std::vector<uint8_t> data;
+    data.reserve(desc.rootSignature_.size() + desc.vertexShader_.size() + desc.pixelShader_.size() + 256);
+
+    ByteWriter writer(data);
+    writer.WriteBytes(desc.rootSignature_.data(), desc.rootSignature_.size());
+    writer.WriteBytes(desc.vertexShader_.data(), desc.vertexShader_.size());
+    writer.WriteBytes(desc.pixelShader_.data(), desc.pixelShader_.size());
+
+    writer.WriteU32((uint32_t) desc.inputLayout_.size());
+    for (PipelineVertexElement const& element : desc.inputLayout_)
+    {
+        writer.WriteBytes(element.semantic_.data(), element.semantic_.size());
+        writer.WriteU32(element.semanticIndex_);
+        writer.WriteU32(element.format_);
+        writer.WriteU32(element.inputSlot_);
+        writer.WriteU32(element.offset_);
+    }
+
+    // Formats past the render target count are ignored when creating, so they must not split the cache
+    writer.WriteU32(desc.renderTargetCount_);
+    for (unsigned i = 0; i < desc.renderTargetCount_ && i < MAX_PIPELINE_RENDER_TARGETS; ++i)
+        writer.WriteU32(desc.renderTargetFormats_[i]);
+
+    writer.WriteU32(desc.depthStencilFormat_);
+    writer.WriteU32(desc.sampleCount_);
+    writer.WriteU32(desc.primitiveTopologyType_);
+    writer.WriteU32(desc.blendMode_);
+    writer.WriteU32(desc.fillMode_);
+    writer.WriteU32(desc.cullMode_);
+    writer.WriteU32(desc.depthFunc_);
+    writer.WriteU32((desc.depthTest_ ? 1u : 0u) | (desc.depthWrite_ ? 2u : 0u));
+
+    return HashContent(data.data(), data.size());
+}
+
+PipelineCache::PipelineCache() = default;
+
+PipelineCache::~PipelineCache()
+{
+    Shutdown();
+}
+
+void PipelineCache::Initialize(PipelineStateFactory& factory, JobSystem* jobSystem)
+{
+    assert(!factory_);
+
+    factory_ = &factory;
+    jobSystem_ = jobSystem;
+}
+
+void PipelineCache::Shutdown()
+{
+    if (!factory_)
+        return;
+
+    WaitAll();
+
+    for (Pipeline& pipeline : pipelines_)
+    {
+        if (pipeline.state_)
+            factory_->ReleasePipelineState(pipeline.state_);
+    }
+
+    pipelines_.clear();
+    pipelineIds_.clear();
+    cachedBlobs_.clear();
+    stats_ = PipelineCacheStats();
+    factory_ = nullptr;
+    jobSystem_ = nullptr;
+}
+
+void PipelineCache::SetJobSystem(JobSystem* jobSystem)
+{
+    WaitAll();
+    jobSystem_ = jobSystem;
+}
+
+PipelineCache::PipelineId PipelineCache::Request(PipelineDesc const& desc)
+{
+    assert(factory_);
+
+    ContentHash hash = HashDesc(desc);
+    Pipeline* pipeline;
+    PipelineId id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.requests_;
+
+        auto it = pipelineIds_.find(hash);
+        if (it != pipelineIds_.end())
+        {
+            ++stats_.deduplicated_;
+            return it->second;
+        }
+
+        id = (PipelineId) pipelines_.size();
+        pipelines_.emplace_back();
+        pipeline = &pipelines_.back();
+        pipeline->hash_ = hash;
+        pipeline->desc_ = desc;
+        pipelineIds_[hash] = id;
+    }
+
+    if (jobSystem_)
+        jobSystem_->Run([this, pipeline]() { Compile(*pipeline); }, &compileCounter_);
+    else
+        Compile(*pipeline);
+
+    return id;
+}
+
+PipelineStateHandle PipelineCache::GetPipelineState(PipelineId id) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return id < pipelines_.size() ? pipelines_[id].state_.load(std::memory_order_acquire) : nullptr;
+}
+
+PipelineStateHandle PipelineCache::WaitPipelineState(PipelineId id)
+{
+    if (!IsReady(id) && jobSystem_)
+        jobSystem_->Wait(compileCounter_);
+
+    return GetPipelineState(id);
+}
+
+bool PipelineCache::IsReady(PipelineId id) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return id < pipelines_.size() && pipelines_[id].ready_.load(std::memory_order_acquire);
+}
+
+void PipelineCache::WaitAll()
+{
+    if (jobSystem_)
+        jobSystem_->Wait(compileCounter_);
+}
+
+bool PipelineCache::Load(std::string const& fileName)
+{
+    std::vector<uint8_t> data;
+    return ReadFileBytes(fileName, data) && Deserialize(data.data(), data.size());
+}
+
+bool PipelineCache::Save(std::string const& fileName)
+{
+    std::vector<uint8_t> data;
+    Serialize(data);
+    return WriteFileBytes(fileName, data.data(), data.size());
+}
+
+bool PipelineCache::Deserialize(uint8_t const* data, size_t size)
+{
+    assert(factory_);
+
+    // The checksum covers everything before it
+    if (size < 8)
+        return false;
+    ContentHash checksum = HashContent(data, size - 8);
+    ByteReader checksumReader(data + size - 8, 8);
+    uint64_t storedChecksum;
+    if (!checksumReader.ReadU64(storedChecksum) || storedChecksum != checksum.low_)
+        return false;
+
+    ByteReader reader(data, size - 8);
+    uint32_t magic, version, count;
+    uint64_t deviceId;
+    if (!reader.ReadU32(magic) || magic != PipelineCacheMagic || !reader.ReadU32(version) || version != PipelineCacheVersion ||
+        !reader.ReadU64(deviceId) || deviceId != factory_->GetDeviceId() || !reader.ReadU32(count) || count > size / 20)
+        return false;
+
+    std::vector<std::pair<ContentHash, std::vector<uint8_t>>> entries(count);
+    for (auto& entry : entries)
+    {
+        if (!reader.ReadU64(entry.first.low_) || !reader.ReadU64(entry.first.high_) || !reader.ReadBytes(entry.second))
+            return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries)
+        cachedBlobs_.emplace(entry.first, std::move(entry.second));
+
+    return true;
+}
+
+void PipelineCache::Serialize(std::vector<uint8_t>& data)
+{
+    assert(factory_);
+
+    WaitAll();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Blobs of this run replace loaded ones, the driver may have recompiled them
+    std::vector<uint8_t> blob;
+    for (Pipeline const& pipeline : pipelines_)
+    {
+        if (pipeline.state_ && factory_->GetCachedBlob(pipeline.state_, blob))
+            cachedBlobs_[pipeline.hash_] = blob;
+    }
+
+    // Sorted so the same pipelines always produce the same file
+    std::vector<std::pair<ContentHash, std::vector<uint8_t> const*>> entries;
+    entries.reserve(cachedBlobs_.size());
+    for (auto const& pair : cachedBlobs_)
+        entries.emplace_back(pair.first, &pair.second);
+    std::sort(entries.begin(), entries.end(), [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+
+    data.clear();
+    ByteWriter writer(data);
+    writer.WriteU32(PipelineCacheMagic);
+    writer.WriteU32(PipelineCacheVersion);
+    writer.WriteU64(factory_->GetDeviceId());
+    writer.WriteU32((uint32_t) entries.size());
+    for (auto const& entry : entries)
+    {
+        writer.WriteU64(entry.first.low_);
+        writer.WriteU64(entry.first.high_);
+        writer.WriteBytes(entry.second->data(), entry.second->size());
+    }
+
+    writer.WriteU64(HashContent(data.data(), data.size()).low_);
+}
+
+unsigned PipelineCache::GetPipelineCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (unsigned) pipelines_.size();
+}
+
+unsigned PipelineCache::GetCachedBlobCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (unsigned) cachedBlobs_.size();
+}
+
+PipelineCacheStats PipelineCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PipelineCache::Compile(Pipeline& pipeline)
+{
+    // Copy the blob, Serialize may replace it while the factory works
+    std::vector<uint8_t> blob;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cachedBlobs_.find(pipeline.hash_);
+        if (it != cachedBlobs_.end())
+            blob = it->second;
+    }
+
+    PipelineStateHandle state = nullptr;
+    bool warmStarted = false;
+    if (!blob.empty())
+    {
+        state = factory_->CreatePipelineState(pipeline.desc_, blob.data(), blob.size());
+        warmStarted = state != nullptr;
+    }
+
+    // A blob from another driver version is rejected, compile from scratch then
+    if (!state)
+        state = factory_->CreatePipelineState(pipeline.desc_, nullptr, 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!state)
+        ++stats_.failed_;
+    else if (warmStarted)
+        ++stats_.warmStarted_;
+    else
+        ++stats_.compiled_;
+
+    // Bytecode is no longer needed
+    pipeline.desc_ = PipelineDesc();
+    pipeline.state_.store(state, std::memory_order_release);
+    pipeline.ready_.store(true, std::memory_order_release);
+}
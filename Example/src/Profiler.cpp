@@ -0,0 +1,259 @@
+#include "Profiler.h"
+#include "ByteStream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+
+
+/// Buffer of the calling thread with the profiler it belongs to.
+struct ThreadBufferSlot
+{
+    /// Profiler
+    Profiler* profiler_;
+    /// Buffer
+    ProfilerThreadBuffer* buffer_;
+};
+
+static thread_local ThreadBufferSlot threadBufferSlot{};
+
+static int64_t GetSteadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void AppendEscaped(std::string& json, std::string const& text)
+{
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            json += '\\';
+        if ((unsigned char) c >= 0x20)
+            json += c;
+    }
+}
+
+ProfilerThreadBuffer::ProfilerThreadBuffer(std::string const& name, unsigned track, unsigned capacity)
+    : name_(name)
+    , track_(track)
+    , events_(capacity)
+    , mask_(capacity - 1)
+{
+    assert(capacity && (capacity & (capacity - 1)) == 0);
+}
+
+uint64_t ProfilerThreadBuffer::Read(std::vector<ProfilerEvent>& events)
+{
+    uint64_t capacity = mask_ + 1;
+    uint64_t write = writeIndex_.load(std::memory_order_acquire);
+    uint64_t begin = readIndex_;
+    uint64_t lost = 0;
+
+    if (write - begin > capacity)
+    {
+        lost = write - capacity - begin;
+        begin = write - capacity;
+    }
+
+    size_t first = events.size();
+    for (uint64_t i = begin; i < write; ++i)
+        events.push_back(events_[i & mask_]);
+
+    // The writer kept going while copying, drop what it may have overwritten
+    uint64_t after = writeIndex_.load(std::memory_order_acquire);
+    if (after - begin > capacity)
+    {
+        uint64_t overwritten = std::min(after - capacity - begin, write - begin);
+        events.erase(events.begin() + first, events.begin() + first + (size_t) overwritten);
+        lost += overwritten;
+    }
+
+    readIndex_ = write;
+    return lost;
+}
+
+Profiler::Profiler()
+    : startTicks_(GetTicks())
+    , startNanoseconds_(GetSteadyNanoseconds())
+{
+}
+
+Profiler& Profiler::Get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::SetThreadName(std::string const& name)
+{
+    ProfilerThreadBuffer& buffer = GetThreadBuffer();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer.SetName(name);
+}
+
+void Profiler::SetThreadBufferCapacity(unsigned capacity)
+{
+    unsigned rounded = 1;
+    while (rounded < capacity)
+        rounded <<= 1;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    threadBufferCapacity_ = rounded;
+}
+
+ProfilerThreadBuffer& Profiler::GetThreadBuffer()
+{
+    if (threadBufferSlot.profiler_ == this)
+        return *threadBufferSlot.buffer_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned track = trackCount_++;
+    threadBuffers_.emplace_back(new ProfilerThreadBuffer("Thread " + std::to_string(track), track, threadBufferCapacity_));
+    threadBufferSlot = { this, threadBuffers_.back().get() };
+    return *threadBufferSlot.buffer_;
+}
+
+void Profiler::Counter(char const* name, int64_t value)
+{
+    if (IsEnabled())
+        GetThreadBuffer().Write({ GetTicks(), (uint64_t) value, name, PROFILER_EVENT_COUNTER, 0 });
+}
+
+void Profiler::Frame(uint64_t frameNumber)
+{
+    if (IsEnabled())
+        GetThreadBuffer().Write({ GetTicks(), frameNumber, "Frame", PROFILER_EVENT_FRAME, 0 });
+}
+
+unsigned Profiler::AddTrack(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned track = trackCount_++;
+    extraTracks_.emplace_back(track, name);
+    return track;
+}
+
+void Profiler::AddTimelineZone(unsigned track, std::string const& name, double start, double duration, unsigned depth)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeline_.push_back({ name, track, PROFILER_EVENT_ZONE, start, duration, 0.0, depth });
+}
+
+void Profiler::Collect()
+{
+    double ticksPerMicrosecond = GetTicksPerMicrosecond();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::unique_ptr<ProfilerThreadBuffer>& buffer : threadBuffers_)
+    {
+        collectScratch_.clear();
+        lostEvents_ += buffer->Read(collectScratch_);
+
+        for (ProfilerEvent const& event : collectScratch_)
+        {
+            ProfilerTimelineEvent timelineEvent;
+            timelineEvent.name_ = event.name_;
+            timelineEvent.track_ = buffer->GetTrack();
+            timelineEvent.type_ = event.type_;
+            timelineEvent.start_ = (double) (int64_t) (event.start_ - startTicks_) / ticksPerMicrosecond;
+            timelineEvent.duration_ = event.type_ == PROFILER_EVENT_ZONE ? (double) (event.value_ - event.start_) / ticksPerMicrosecond : 0.0;
+            timelineEvent.value_ = event.type_ == PROFILER_EVENT_ZONE ? 0.0 : (double) (int64_t) event.value_;
+            timelineEvent.depth_ = event.depth_;
+            timeline_.push_back(timelineEvent);
+        }
+    }
+}
+
+void Profiler::ClearTimeline()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeline_.clear();
+}
+
+std::vector<std::string> Profiler::GetTrackNames() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<std::string> names(trackCount_);
+    for (std::unique_ptr<ProfilerThreadBuffer> const& buffer : threadBuffers_)
+        names[buffer->GetTrack()] = buffer->GetName();
+    for (auto const& track : extraTracks_)
+        names[track.first] = track.second;
+    return names;
+}
+
+double Profiler::TicksToMicroseconds(uint64_t ticks) const
+{
+    return (double) (int64_t) (ticks - startTicks_) / GetTicksPerMicrosecond();
+}
+
+double Profiler::GetTicksPerMicrosecond() const
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    // The invariant TSC rate is not reported directly, measure it against the steady clock since construction.
+    // The longer the profiler runs the more precise this gets
+    int64_t elapsedNanoseconds = std::max(GetSteadyNanoseconds() - startNanoseconds_, (int64_t) 1);
+    uint64_t elapsedTicks = GetTicks() - startTicks_;
+    return (double) elapsedTicks * 1000.0 / (double) elapsedNanoseconds;
+#else
+    return (double) std::chrono::steady_clock::period::den / ((double) std::chrono::steady_clock::period::num * 1e6);
+#endif
+}
+
+void Profiler::WriteChromeTrace(std::string& json) const
+{
+    std::vector<std::string> trackNames = GetTrackNames();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    char buffer[128];
+    bool first = true;
+    for (unsigned i = 0; i < trackNames.size(); ++i)
+    {
+        snprintf(buffer, sizeof buffer, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",\n", i);
+        json += buffer;
+        AppendEscaped(json, trackNames[i]);
+        json += "\"}}";
+        first = false;
+    }
+
+    for (ProfilerTimelineEvent const& event : timeline_)
+    {
+        json += first ? "" : ",\n";
+        first = false;
+
+        switch (event.type_)
+        {
+        case PROFILER_EVENT_ZONE:
+            snprintf(buffer, sizeof buffer, "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"", event.track_, event.start_, event.duration_);
+            json += buffer;
+            AppendEscaped(json, event.name_);
+            json += "\"}";
+            break;
+
+        case PROFILER_EVENT_COUNTER:
+            snprintf(buffer, sizeof buffer, "{\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%.17g},\"name\":\"", event.track_, event.start_, event.value_);
+            json += buffer;
+            AppendEscaped(json, event.name_);
+            json += "\"}";
+            break;
+
+        case PROFILER_EVENT_FRAME:
+            snprintf(buffer, sizeof buffer, "{\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":\"Frame %.0f\"}", event.track_, event.start_, event.value_);
+            json += buffer;
+            break;
+        }
+    }
+
+    json += "\n]}\n";
+}
+
+bool Profiler::SaveChromeTrace(std::string const& fileName) const
+{
+    std::string json;
+    WriteChromeTrace(json);
+    return WriteFileBytes(fileName, json.data(), json.size());
+}
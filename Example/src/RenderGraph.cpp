@@ -0,0 +1,529 @@
+
+#include "RenderGraph.h"
+#include "GraphicsBackend.h"
+#include "ResourceStateTracker.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+static const unsigned NoPass = ~0u;
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+TransientResourceFactory::TransientResourceFactory(ResourceStateRegistry& registry)
+    : registry_(registry)
+{
+}
+
+TransientResourceFactory::~TransientResourceFactory()
+{
+    // Releasing needs the derived factory, which must call ReleaseAll itself
+    assert(textures_.empty() && !heapSize_);
+}
+
+void TransientResourceFactory::BeginFrame(uint64_t heapSize)
+{
+    ++frame_;
+
+    for (unsigned i = 0; i < textures_.size();)
+    {
+        if (textures_[i].frame_ + 1 < frame_)
+            ReleaseCachedTexture(i);
+        else
+            ++i;
+    }
+
+    if (heapSize <= heapSize_)
+        return;
+
+    // Every texture lives in the old heap, so they all go with it
+    ReleaseAll();
+    if (CreateHeap(heapSize))
+        heapSize_ = heapSize;
+}
+
+ResourceHandle TransientResourceFactory::AcquireTexture(TextureDesc const& desc, uint64_t offset, unsigned initialState)
+{
+    for (Texture& texture : textures_)
+    {
+        if (texture.offset_ == offset && texture.desc_ == desc && texture.frame_ != frame_)
+        {
+            texture.frame_ = frame_;
+            return texture.handle_;
+        }
+    }
+
+    ResourceHandle handle = CreateTexture(desc, offset, initialState);
+    if (!handle)
+        return nullptr;
+
+    registry_.RegisterResource(handle, 1, initialState);
+    textures_.push_back({ desc, offset, handle, frame_ });
+    return handle;
+}
+
+void TransientResourceFactory::ReleaseAll()
+{
+    while (!textures_.empty())
+        ReleaseCachedTexture((unsigned) textures_.size() - 1);
+
+    if (heapSize_)
+    {
+        ReleaseHeap();
+        heapSize_ = 0;
+    }
+}
+
+void TransientResourceFactory::ReleaseCachedTexture(unsigned index)
+{
+    registry_.UnregisterResource(textures_[index].handle_);
+    ReleaseTexture(textures_[index].handle_);
+
+    textures_[index] = textures_.back();
+    textures_.pop_back();
+}
+
+RenderGraphResource RenderGraphBuilder::CreateTexture(std::string const& name, TextureDesc const& desc)
+{
+    // Tier 1 heaps cannot hold render targets together with other textures
+    assert(desc.usage_ & (TEXTURE_USAGE_RENDER_TARGET | TEXTURE_USAGE_DEPTH_STENCIL));
+
+    RenderGraph::Resource resource{};
+    resource.name_ = name;
+    resource.desc_ = desc;
+    resource.transient_ = true;
+
+    graph_.resources_.push_back(resource);
+    return (RenderGraphResource) graph_.resources_.size() - 1;
+}
+
+RenderGraphResource RenderGraphBuilder::Read(RenderGraphResource resource, unsigned state)
+{
+    assert(resource < graph_.resources_.size());
+    graph_.passes_[pass_].reads_.push_back({ resource, state });
+    return resource;
+}
+
+RenderGraphResource RenderGraphBuilder::Write(RenderGraphResource resource, unsigned state)
+{
+    assert(resource < graph_.resources_.size());
+    graph_.passes_[pass_].writes_.push_back({ resource, state });
+    return resource;
+}
+
+void RenderGraphBuilder::SetSideEffect()
+{
+    graph_.passes_[pass_].sideEffect_ = true;
+}
+
+ResourceHandle RenderGraphContext::GetResource(RenderGraphResource resource) const
+{
+    return graph_.resources_[resource].handle_;
+}
+
+RenderGraph::RenderGraph() = default;
+
+void RenderGraph::Reset()
+{
+    passes_.clear();
+    resources_.clear();
+    order_.clear();
+    heapSize_ = 0;
+}
+
+RenderGraphResource RenderGraph::Import(std::string const& name, ResourceHandle handle, unsigned state)
+{
+    Resource resource{};
+    resource.name_ = name;
+    resource.handle_ = handle;
+    resource.initialState_ = state;
+
+    resources_.push_back(resource);
+    return (RenderGraphResource) resources_.size() - 1;
+}
+
+void RenderGraph::AddPass(std::string const& name, SetupFunction const& setup, ExecuteFunction const& execute)
+{
+    Pass pass{};
+    pass.name_ = name;
+    pass.execute_ = execute;
+    passes_.push_back(pass);
+
+    RenderGraphBuilder builder(*this, (unsigned) passes_.size() - 1);
+    setup(builder);
+}
+
+bool RenderGraph::Compile(TransientResourceFactory& factory)
+{
+    stats_ = RenderGraphStats();
+    stats_.passes_ = (unsigned) passes_.size();
+
+    // Dependencies follow declaration order: a pass reads the last write declared before it
+    std::vector<unsigned> lastWriters(resources_.size(), NoPass);
+    std::vector<std::vector<unsigned>> readers(resources_.size());
+
+    for (unsigned i = 0; i < passes_.size(); ++i)
+    {
+        Pass& pass = passes_[i];
+        pass.dependencies_.clear();
+        pass.producers_.clear();
+        pass.barriers_.clear();
+
+        for (Access const& read : pass.reads_)
+        {
+            unsigned writer = lastWriters[read.resource_];
+            if (writer != NoPass)
+            {
+                pass.dependencies_.push_back(writer);
+                pass.producers_.push_back(writer);
+            }
+        }
+
+        for (Access const& write : pass.writes_)
+        {
+            // Writes may keep part of the previous contents, so the previous writer is a producer as well
+            unsigned writer = lastWriters[write.resource_];
+            if (writer != NoPass && writer != i)
+            {
+                pass.dependencies_.push_back(writer);
+                pass.producers_.push_back(writer);
+            }
+
+            for (unsigned reader : readers[write.resource_])
+            {
+                if (reader != i)
+                    pass.dependencies_.push_back(reader);
+            }
+
+            lastWriters[write.resource_] = i;
+            readers[write.resource_].clear();
+        }
+
+        for (Access const& read : pass.reads_)
+            readers[read.resource_].push_back(i);
+    }
+
+    CullPasses();
+    if (!OrderPasses())
+        return false;
+
+    PlaceTransientResources(factory);
+    ComputeBarriers();
+    return true;
+}
+
+void RenderGraph::Execute(GraphicsBackend& backend, TransientResourceFactory& factory)
+{
+    factory.BeginFrame(heapSize_);
+    for (Resource& resource : resources_)
+    {
+        if (resource.transient_ && resource.firstUse_ != NoPass)
+            resource.handle_ = factory.AcquireTexture(resource.desc_, resource.offset_, resource.initialState_);
+    }
+
+    ResourceStateTracker& tracker = backend.GetStateTracker();
+    RenderGraphContext context(*this, backend);
+
+    for (unsigned index : order_)
+    {
+        Pass& pass = passes_[index];
+
+        // The tracker drops the first use transitions of textures that were just created in that state
+        for (Barrier const& barrier : pass.barriers_)
+        {
+            ResourceHandle handle = resources_[barrier.resource_].handle_;
+            if (barrier.aliasing_)
+                tracker.AliasingBarrier(nullptr, handle);
+            else
+                tracker.Transition(handle, barrier.state_);
+        }
+        tracker.FlushBarriers(backend);
+
+        if (pass.execute_)
+        {
+            PROFILE_GPU_SCOPE(backend.GetGpuProfiler(), pass.name_);
+            pass.execute_(context);
+        }
+    }
+}
+
+void RenderGraph::CullPasses()
+{
+    std::vector<unsigned> stack;
+
+    for (unsigned i = 0; i < passes_.size(); ++i)
+    {
+        Pass& pass = passes_[i];
+        pass.alive_ = pass.sideEffect_;
+
+        for (Access const& write : pass.writes_)
+        {
+            if (!resources_[write.resource_].transient_)
+                pass.alive_ = true;
+        }
+
+        if (pass.alive_)
+            stack.push_back(i);
+    }
+
+    while (!stack.empty())
+    {
+        unsigned index = stack.back();
+        stack.pop_back();
+
+        for (unsigned producer : passes_[index].producers_)
+        {
+            if (!passes_[producer].alive_)
+            {
+                passes_[producer].alive_ = true;
+                stack.push_back(producer);
+            }
+        }
+    }
+
+    for (Pass const& pass : passes_)
+    {
+        if (!pass.alive_)
+            ++stats_.culledPasses_;
+    }
+}
+
+bool RenderGraph::OrderPasses()
+{
+    unsigned passCount = (unsigned) passes_.size();
+    std::vector<unsigned> pendingCounts(passCount, 0);
+    std::vector<std::vector<unsigned>> dependents(passCount);
+    std::vector<unsigned> positions(passCount, NoPass);
+    std::vector<unsigned> ready;
+
+    unsigned aliveCount = 0;
+    for (unsigned i = 0; i < passCount; ++i)
+    {
+        Pass const& pass = passes_[i];
+        if (!pass.alive_)
+            continue;
+
+        ++aliveCount;
+        for (unsigned dependency : pass.dependencies_)
+        {
+            if (!passes_[dependency].alive_)
+                continue;
+            ++pendingCounts[i];
+            dependents[dependency].push_back(i);
+        }
+
+        if (!pendingCounts[i])
+            ready.push_back(i);
+    }
+
+    // Prefer the ready pass whose inputs were produced most recently, so transient textures are consumed
+    // soon after they are written and their lifetimes stay short enough to alias
+    order_.clear();
+    while (!ready.empty())
+    {
+        unsigned best = 0;
+        int bestLatest = -1;
+
+        for (unsigned i = 0; i < ready.size(); ++i)
+        {
+            int latest = -1;
+            for (unsigned dependency : passes_[ready[i]].dependencies_)
+            {
+                if (positions[dependency] != NoPass && (int) positions[dependency] > latest)
+                    latest = (int) positions[dependency];
+            }
+
+            if (latest > bestLatest || (latest == bestLatest && ready[i] < ready[best]))
+            {
+                best = i;
+                bestLatest = latest;
+            }
+        }
+
+        unsigned index = ready[best];
+        ready.erase(ready.begin() + best);
+
+        positions[index] = (unsigned) order_.size();
+        order_.push_back(index);
+
+        for (unsigned dependent : dependents[index])
+        {
+            if (!--pendingCounts[dependent])
+                ready.push_back(dependent);
+        }
+    }
+
+    return order_.size() == aliveCount;
+}
+
+void RenderGraph::PlaceTransientResources(TransientResourceFactory& factory)
+{
+    for (Resource& resource : resources_)
+    {
+        resource.firstUse_ = NoPass;
+        resource.lastUse_ = 0;
+    }
+
+    for (unsigned position = 0; position < order_.size(); ++position)
+    {
+        Pass const& pass = passes_[order_[position]];
+        for (std::vector<Access> const* accesses : { &pass.reads_, &pass.writes_ })
+        {
+            for (Access const& access : *accesses)
+            {
+                Resource& resource = resources_[access.resource_];
+                if (resource.firstUse_ == NoPass)
+                    resource.firstUse_ = position;
+                resource.lastUse_ = position;
+            }
+        }
+    }
+
+    placement_.clear();
+    for (unsigned i = 0; i < resources_.size(); ++i)
+    {
+        Resource& resource = resources_[i];
+        if (!resource.transient_ || resource.firstUse_ == NoPass)
+            continue;
+
+        factory.GetAllocationInfo(resource.desc_, resource.size_, resource.alignment_);
+        placement_.push_back(i);
+
+        ++stats_.transientTextures_;
+        stats_.transientSize_ += resource.size_;
+    }
+
+    // Place the largest first, each at the lowest offset not overlapping a placed texture that is alive at the same time
+    std::sort(placement_.begin(), placement_.end(), [this](RenderGraphResource lhs, RenderGraphResource rhs)
+    {
+        Resource const& left = resources_[lhs];
+        Resource const& right = resources_[rhs];
+        return left.size_ != right.size_ ? left.size_ > right.size_ : left.firstUse_ < right.firstUse_;
+    });
+
+    heapSize_ = 0;
+    for (unsigned i = 0; i < placement_.size(); ++i)
+    {
+        Resource& resource = resources_[placement_[i]];
+        uint64_t offset = 0;
+
+        for (bool moved = true; moved;)
+        {
+            moved = false;
+            offset = AlignUp(offset, resource.alignment_);
+
+            for (unsigned j = 0; j < i; ++j)
+            {
+                Resource const& placed = resources_[placement_[j]];
+                bool livesOverlap = placed.firstUse_ <= resource.lastUse_ && resource.firstUse_ <= placed.lastUse_;
+                bool memoryOverlaps = placed.offset_ < offset + resource.size_ && offset < placed.offset_ + placed.size_;
+
+                if (livesOverlap && memoryOverlaps)
+                {
+                    offset = AlignUp(placed.offset_ + placed.size_, resource.alignment_);
+                    moved = true;
+                }
+            }
+        }
+
+        resource.offset_ = offset;
+        heapSize_ = std::max(heapSize_, offset + resource.size_);
+    }
+
+    stats_.transientHeapSize_ = heapSize_;
+}
+
+void RenderGraph::ComputeBarriers()
+{
+    std::vector<unsigned> states(resources_.size());
+    for (unsigned i = 0; i < resources_.size(); ++i)
+        states[i] = resources_[i].transient_ ? ResourceStates::UnknownState : resources_[i].initialState_;
+
+    for (unsigned position = 0; position < order_.size(); ++position)
+    {
+        Pass& pass = passes_[order_[position]];
+
+        for (std::vector<Access> const* accesses : { &pass.writes_, &pass.reads_ })
+        {
+            bool writes = accesses == &pass.writes_;
+
+            for (Access const& access : *accesses)
+            {
+                Resource& resource = resources_[access.resource_];
+                unsigned& state = states[access.resource_];
+
+                // A read of a resource the same pass writes is covered by the write state
+                if (!writes && (state == ResourceStates::UnknownState || IsWritten(pass, access.resource_)))
+                    continue;
+
+                unsigned required = writes ? access.state_ : GetCombinedReadState(access.resource_, position);
+
+                if (state == ResourceStates::UnknownState)
+                {
+                    // Created in the state of its first use, but the memory may hold a texture used earlier
+                    resource.initialState_ = required;
+                    state = required;
+
+                    for (RenderGraphResource other : placement_)
+                    {
+                        Resource const& previous = resources_[other];
+                        if (other != access.resource_ && previous.lastUse_ < resource.firstUse_ &&
+                            previous.offset_ < resource.offset_ + resource.size_ && resource.offset_ < previous.offset_ + previous.size_)
+                        {
+                            pass.barriers_.push_back({ access.resource_, 0, true });
+                            ++stats_.aliasingBarriers_;
+                            break;
+                        }
+                    }
+
+                    // A texture cached from an earlier frame may have been left in another state
+                    pass.barriers_.push_back({ access.resource_, required, false });
+                    continue;
+                }
+
+                if (IsResourceStateCompatible(state, required))
+                    continue;
+
+                pass.barriers_.push_back({ access.resource_, required, false });
+                state = required;
+                ++stats_.barriers_;
+            }
+        }
+    }
+}
+
+bool RenderGraph::IsWritten(Pass const& pass, RenderGraphResource resource)
+{
+    for (Access const& write : pass.writes_)
+    {
+        if (write.resource_ == resource)
+            return true;
+    }
+
+    return false;
+}
+
+unsigned RenderGraph::GetCombinedReadState(RenderGraphResource resource, unsigned position) const
+{
+    // One barrier into every read state used until the next write instead of one per reading pass
+    unsigned combined = 0;
+
+    for (unsigned i = position; i < order_.size(); ++i)
+    {
+        Pass const& pass = passes_[order_[i]];
+        if (i > position && IsWritten(pass, resource))
+            break;
+
+        for (Access const& read : pass.reads_)
+        {
+            if (read.resource_ == resource)
+                combined |= read.state_;
+        }
+    }
+
+    return combined;
+}
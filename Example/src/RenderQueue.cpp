@@ -0,0 +1,328 @@
+#include "RenderQueue.h"
+#include "CommandList.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+/// Digits of a key
+static constexpr unsigned digitCount{8};
+/// Buckets of a digit
+static constexpr unsigned bucketCount{256};
+
+static_assert(RenderQueue::PassBits + 1 + RenderQueue::PipelineBits + RenderQueue::MaterialBits + RenderQueue::DepthBits <= 64,
+    "Sort key fields must fit 64 bits");
+
+/// Return depth quantized to the depth bits of a key.
+static uint64_t QuantizeDepth(float depth)
+{
+    // A float has fewer mantissa bits than the field, so depth 1 rounded in float would land one past the
+    // largest value and carry into the neighbouring field
+    uint64_t const maxDepth = (1u << RenderQueue::DepthBits) - 1;
+    double clamped = depth > 0.0f ? (depth < 1.0f ? (double) depth : 1.0) : 0.0;
+    return std::min((uint64_t) (clamped * (double) maxDepth + 0.5), maxDepth);
+}
+
+RenderQueue::RenderQueue() = default;
+
+uint64_t RenderQueue::MakeSortKey(unsigned pass, bool translucent, unsigned pipeline, unsigned material, float depth)
+{
+    uint64_t passField = pass & ((1u << PassBits) - 1);
+    uint64_t pipelineField = pipeline & ((1u << PipelineBits) - 1);
+    uint64_t materialField = material & ((1u << MaterialBits) - 1);
+    uint64_t depthField = QuantizeDepth(depth);
+
+    // Translucent draws sort after the opaque ones of their pass and blend furthest first
+    uint64_t key = passField << (64 - PassBits);
+    unsigned shift = 64 - PassBits - 1;
+    if (translucent)
+    {
+        key |= 1ull << shift;
+        depthField = ((1u << DepthBits) - 1) - depthField;
+        shift -= DepthBits;
+        key |= depthField << shift;
+        shift -= PipelineBits;
+        key |= pipelineField << shift;
+        shift -= MaterialBits;
+        key |= materialField << shift;
+    }
+    else
+    {
+        shift -= PipelineBits;
+        key |= pipelineField << shift;
+        shift -= MaterialBits;
+        key |= materialField << shift;
+        shift -= DepthBits;
+        key |= depthField << shift;
+    }
+    return key;
+}
+
+void RenderQueue::Clear()
+{
+    keys_.clear();
+    packets_.clear();
+    order_.clear();
+}
+
+void RenderQueue::Add(uint64_t sortKey, DrawPacket const& packet)
+{
+    keys_.push_back(sortKey);
+    packets_.push_back(packet);
+}
+
+template <class Function> void RenderQueue::ForEachChunk(unsigned count, Function const& function)
+{
+    unsigned total = GetDrawCount();
+    if (count > 1)
+    {
+        jobSystem_->ParallelFor(count, 1, [&](unsigned begin, unsigned end)
+        {
+            for (unsigned chunk = begin; chunk < end; ++chunk)
+                function(chunk, chunk * chunkSize_, std::min((chunk + 1) * chunkSize_, total));
+        });
+    }
+    else
+        function(0, 0, total);
+}
+
+void RenderQueue::Sort()
+{
+    PROFILE_SCOPE("SortDraws");
+
+    unsigned count = GetDrawCount();
+    stats_ = RenderQueueStats();
+    sortedKeys_.resize(count);
+    order_.resize(count);
+    tempKeys_.resize(count);
+    tempOrder_.resize(count);
+    if (!count)
+        return;
+
+    // One chunk per thread, unless that leaves chunks too small to be worth a job
+    unsigned chunkCount = 1;
+    if (jobSystem_)
+    {
+        chunkCount = std::min(jobSystem_->GetThreadCount(), (count + MinSortBatchSize - 1) / MinSortBatchSize);
+        chunkCount = std::max(chunkCount, 1u);
+    }
+    chunkSize_ = (count + chunkCount - 1) / chunkCount;
+    chunkCount = (count + chunkSize_ - 1) / chunkSize_;
+    if (chunkCount > 1)
+        stats_.sortJobs_ = chunkCount;
+
+    histograms_.assign(chunkCount * digitCount * bucketCount, 0);
+    ForEachChunk(chunkCount, [this](unsigned chunk, unsigned begin, unsigned end) { CountChunk(chunk, begin, end); });
+
+    for (unsigned digit = 0; digit < digitCount; ++digit)
+    {
+        // A digit every key shares would not move anything. Totals do not depend on the order, so the first
+        // counts tell
+        bool shared = false;
+        for (unsigned bucket = 0; bucket < bucketCount && !shared; ++bucket)
+        {
+            unsigned keys = 0;
+            for (unsigned chunk = 0; chunk < chunkCount; ++chunk)
+                keys += histograms_[(chunk * digitCount + digit) * bucketCount + bucket];
+            shared = keys == count;
+        }
+        if (shared)
+            continue;
+
+        // Scattering moved keys between chunks, count them again
+        if (stats_.sortPasses_ && chunkCount > 1)
+            ForEachChunk(chunkCount, [this, digit](unsigned chunk, unsigned begin, unsigned end) { CountDigit(chunk, digit, begin, end); });
+
+        // Turn the counts into offsets, bucket by bucket and within a bucket chunk by chunk
+        unsigned offset = 0;
+        for (unsigned bucket = 0; bucket < bucketCount; ++bucket)
+        {
+            for (unsigned chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                unsigned& slot = histograms_[(chunk * digitCount + digit) * bucketCount + bucket];
+                unsigned keys = slot;
+                slot = offset;
+                offset += keys;
+            }
+        }
+
+        ForEachChunk(chunkCount, [this, digit](unsigned chunk, unsigned begin, unsigned end) { ScatterChunk(chunk, digit, begin, end); });
+        sortedKeys_.swap(tempKeys_);
+        order_.swap(tempOrder_);
+        ++stats_.sortPasses_;
+    }
+}
+
+void RenderQueue::Submit(CommandList& commandList)
+{
+    PROFILE_SCOPE("SubmitDraws");
+
+    assert(order_.size() == keys_.size());
+    RenderQueueStats sortStats = stats_;
+    stats_ = Submit(commandList, 0, GetDrawCount());
+    stats_.sortPasses_ = sortStats.sortPasses_;
+    stats_.sortJobs_ = sortStats.sortJobs_;
+    stats_.commandLists_ = 1;
+}
+
+void RenderQueue::Submit(AcquireFunction const& acquire, std::vector<CommandList*>& commandLists)
+{
+    PROFILE_SCOPE("SubmitDraws");
+
+    assert(order_.size() == keys_.size());
+
+    // Every range pays for a command list and its setup, so split no further than there are threads
+    unsigned total = GetDrawCount();
+    unsigned rangeCount = 1;
+    if (jobSystem_)
+        rangeCount = std::max(1u, std::min(total / MinSubmitBatchSize, jobSystem_->GetThreadCount()));
+    unsigned rangeSize = (total + rangeCount - 1) / rangeCount;
+
+    commandLists.assign(rangeCount, nullptr);
+    rangeStats_.assign(rangeCount, RenderQueueStats());
+
+    auto recordRange = [&](unsigned range)
+    {
+        CommandList* commandList = acquire();
+        if (!commandList)
+            return;
+
+        unsigned begin = std::min(range * rangeSize, total);
+        rangeStats_[range] = Submit(*commandList, begin, std::min(begin + rangeSize, total));
+        commandLists[range] = commandList;
+    };
+
+    if (rangeCount > 1)
+    {
+        jobSystem_->ParallelFor(rangeCount, 1, [&](unsigned begin, unsigned end)
+        {
+            for (unsigned range = begin; range < end; ++range)
+                recordRange(range);
+        });
+    }
+    else
+        recordRange(0);
+
+    commandLists.erase(std::remove(commandLists.begin(), commandLists.end(), nullptr), commandLists.end());
+
+    RenderQueueStats stats;
+    stats.sortPasses_ = stats_.sortPasses_;
+    stats.sortJobs_ = stats_.sortJobs_;
+    stats.commandLists_ = (unsigned) commandLists.size();
+    for (RenderQueueStats const& range : rangeStats_)
+    {
+        stats.draws_ += range.draws_;
+        stats.pipelineStates_ += range.pipelineStates_;
+        stats.pipelineStatesSkipped_ += range.pipelineStatesSkipped_;
+        stats.rootSignatures_ += range.rootSignatures_;
+        stats.rootSignaturesSkipped_ += range.rootSignaturesSkipped_;
+        stats.descriptorTables_ += range.descriptorTables_;
+        stats.descriptorTablesSkipped_ += range.descriptorTablesSkipped_;
+        stats.vertexBuffers_ += range.vertexBuffers_;
+        stats.vertexBuffersSkipped_ += range.vertexBuffersSkipped_;
+    }
+    stats_ = stats;
+}
+
+RenderQueueStats RenderQueue::Submit(CommandList& commandList, unsigned begin, unsigned end) const
+{
+    RenderQueueStats stats;
+    PipelineStateHandle pipelineState{};
+    RootSignatureHandle rootSignature{};
+    uint64_t descriptorTables[DrawPacket::MaxDescriptorTables]{};
+    VertexBufferView vertexBuffer;
+
+    for (unsigned i = begin; i < end; ++i)
+    {
+        DrawPacket const& packet = packets_[order_[i]];
+
+        // Changing the root signature loses the root arguments
+        if (packet.rootSignature_ && packet.rootSignature_ != rootSignature)
+        {
+            commandList.SetRootSignature(packet.rootSignature_);
+            rootSignature = packet.rootSignature_;
+            for (uint64_t& table : descriptorTables)
+                table = 0;
+            ++stats.rootSignatures_;
+        }
+        else if (packet.rootSignature_)
+            ++stats.rootSignaturesSkipped_;
+
+        if (packet.pipelineState_ != pipelineState)
+        {
+            commandList.SetPipelineStateObject(packet.pipelineState_);
+            pipelineState = packet.pipelineState_;
+            ++stats.pipelineStates_;
+        }
+        else
+            ++stats.pipelineStatesSkipped_;
+
+        for (unsigned j = 0; j < DrawPacket::MaxDescriptorTables; ++j)
+        {
+            uint64_t table = packet.descriptorTables_[j];
+            if (table && table != descriptorTables[j])
+            {
+                commandList.SetDescriptorTable(j, table);
+                descriptorTables[j] = table;
+                ++stats.descriptorTables_;
+            }
+            else if (table)
+                ++stats.descriptorTablesSkipped_;
+        }
+
+        if (packet.vertexBuffer_.gpuAddress_ && packet.vertexBuffer_ != vertexBuffer)
+        {
+            commandList.SetVertexBuffer(packet.vertexBuffer_);
+            vertexBuffer = packet.vertexBuffer_;
+            ++stats.vertexBuffers_;
+        }
+        else if (packet.vertexBuffer_.gpuAddress_)
+            ++stats.vertexBuffersSkipped_;
+
+        commandList.DrawInstanced(packet.vertexCount_, packet.instanceCount_, packet.firstVertex_, packet.firstInstance_);
+        ++stats.draws_;
+    }
+
+    return stats;
+}
+
+void RenderQueue::CountChunk(unsigned chunk, unsigned begin, unsigned end)
+{
+    unsigned* histogram = histograms_.data() + chunk * digitCount * bucketCount;
+    for (unsigned i = begin; i < end; ++i)
+    {
+        uint64_t key = keys_[i];
+        sortedKeys_[i] = key;
+        order_[i] = i;
+        for (unsigned digit = 0; digit < digitCount; ++digit)
+            ++histogram[digit * bucketCount + ((key >> (digit * 8)) & (bucketCount - 1))];
+    }
+}
+
+void RenderQueue::CountDigit(unsigned chunk, unsigned digit, unsigned begin, unsigned end)
+{
+    unsigned* histogram = histograms_.data() + (chunk * digitCount + digit) * bucketCount;
+    unsigned shift = digit * 8;
+    std::fill(histogram, histogram + bucketCount, 0);
+    for (unsigned i = begin; i < end; ++i)
+        ++histogram[(sortedKeys_[i] >> shift) & (bucketCount - 1)];
+}
+
+void RenderQueue::ScatterChunk(unsigned chunk, unsigned digit, unsigned begin, unsigned end)
+{
+    unsigned* offsets = histograms_.data() + (chunk * digitCount + digit) * bucketCount;
+    unsigned shift = digit * 8;
+    uint64_t const* srcKeys = sortedKeys_.data();
+    unsigned const* srcOrder = order_.data();
+    uint64_t* destKeys = tempKeys_.data();
+    unsigned* destOrder = tempOrder_.data();
+    for (unsigned i = begin; i < end; ++i)
+    {
+        uint64_t key = srcKeys[i];
+        unsigned position = offsets[(key >> shift) & (bucketCount - 1)]++;
+        destKeys[position] = key;
+        destOrder[position] = srcOrder[i];
+    }
+}
@@ -0,0 +1,151 @@
+#include "ResidencyManager.h"
+
+#include <cassert>
+
+
+ResidencyManager::ResidencyManager() = default;
+
+ResidencyManager::~ResidencyManager()
+{
+    Shutdown();
+}
+
+void ResidencyManager::Initialize(ResidencyBackend& backend)
+{
+    backend_ = &backend;
+}
+
+void ResidencyManager::Shutdown()
+{
+    lru_.clear();
+    objects_.clear();
+    pending_.clear();
+    stats_.trackedSize_ = stats_.residentSize_ = 0;
+    backend_ = nullptr;
+}
+
+void ResidencyManager::Track(void* object, uint64_t size, bool pinned)
+{
+    assert(object && !objects_.count(object));
+
+    // Objects are resident when created, and used least recently until they are used at all
+    lru_.push_front({ { object, size }, 0, true, pinned, false });
+    objects_[object] = lru_.begin();
+    stats_.trackedSize_ += size;
+    stats_.residentSize_ += size;
+}
+
+void ResidencyManager::Untrack(void* object)
+{
+    auto it = objects_.find(object);
+    if (it == objects_.end())
+        return;
+
+    Entry const& entry = *it->second;
+    stats_.trackedSize_ -= entry.object_.size_;
+    if (entry.resident_)
+        stats_.residentSize_ -= entry.object_.size_;
+
+    lru_.erase(it->second);
+    objects_.erase(it);
+}
+
+void ResidencyManager::MarkUsed(void* object, uint64_t value)
+{
+    auto it = objects_.find(object);
+    if (it == objects_.end())
+        return;
+
+    // Values only grow, so moving the object to the back keeps the list ordered by last use
+    Entry& entry = *it->second;
+    if (value > entry.lastUse_)
+        entry.lastUse_ = value;
+    lru_.splice(lru_.end(), lru_, it->second);
+
+    if (!entry.resident_ && !entry.pending_)
+    {
+        entry.pending_ = true;
+        pending_.push_back(object);
+    }
+}
+
+bool ResidencyManager::Commit(uint64_t completedValue)
+{
+    assert(backend_);
+
+    // Work using evicted objects can not run before they are resident again
+    bool success = true;
+    if (!pending_.empty())
+    {
+        batch_.clear();
+        for (void* object : pending_)
+        {
+            auto it = objects_.find(object);
+            if (it != objects_.end() && it->second->pending_ && !it->second->resident_)
+                batch_.push_back(it->second->object_);
+        }
+
+        success = batch_.empty() || backend_->MakeResident(batch_.data(), (unsigned) batch_.size());
+        if (success && !batch_.empty())
+        {
+            ++stats_.makeResidentCalls_;
+            for (ResidencyObject const& object : batch_)
+            {
+                Entry& entry = *objects_[object.object_];
+                entry.resident_ = true;
+                entry.pending_ = false;
+                stats_.residentSize_ += object.size_;
+                ++stats_.madeResidentObjects_;
+                stats_.madeResidentSize_ += object.size_;
+            }
+            pending_.clear();
+        }
+    }
+
+    VideoMemoryInfo info;
+    if (!backend_->QueryVideoMemory(info))
+        return success;
+
+    stats_.budget_ = info.budget_;
+    stats_.usage_ = info.usage_;
+
+    uint64_t target = (uint64_t) (info.budget_ * (double) budgetTarget_);
+    if (info.usage_ <= target)
+        return success;
+
+    // Evict from the least recently used on, up to the first object the GPU may still be using
+    uint64_t excess = info.usage_ - target;
+    uint64_t evicted = 0;
+    batch_.clear();
+    for (Entry& entry : lru_)
+    {
+        if (evicted >= excess || entry.lastUse_ > completedValue)
+            break;
+        if (!entry.resident_ || entry.pinned_)
+            continue;
+
+        batch_.push_back(entry.object_);
+        entry.resident_ = false;
+        evicted += entry.object_.size_;
+    }
+
+    if (!batch_.empty())
+    {
+        backend_->Evict(batch_.data(), (unsigned) batch_.size());
+        ++stats_.evictCalls_;
+        stats_.evictedObjects_ += batch_.size();
+        stats_.evictedSize_ += evicted;
+        stats_.residentSize_ -= evicted;
+        stats_.usage_ -= evicted < stats_.usage_ ? evicted : stats_.usage_;
+    }
+    if (evicted < excess)
+        ++stats_.overBudgetCommits_;
+
+    return success;
+}
+
+bool ResidencyManager::IsResident(void* object) const
+{
+    auto it = objects_.find(object);
+    return it != objects_.end() && it->second->resident_;
+}
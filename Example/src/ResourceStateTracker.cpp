@@ -0,0 +1,340 @@
+
+#include "ResourceStateTracker.h"
+#include "CommandList.h"
+#include "GraphicsBackend.h"
+
+#include <cassert>
+
+
+bool IsResourceStateCompatible(unsigned before, unsigned after)
+{
+    if (before == after)
+        return true;
+
+    // A combined read state already covers any of its read states, write states must match exactly
+    if ((before & RESOURCE_STATE_WRITE_MASK) || (after & RESOURCE_STATE_WRITE_MASK) || after == RESOURCE_STATE_COMMON)
+        return false;
+
+    return (before & after) == after;
+}
+
+void ResourceStates::Set(unsigned subresource, unsigned state)
+{
+    if (subresource == ALL_SUBRESOURCES || subresourceCount_ == 1)
+    {
+        state_ = state;
+        subresourceStates_.clear();
+        return;
+    }
+
+    if (subresourceStates_.empty())
+    {
+        if (state == state_)
+            return;
+        subresourceStates_.assign(subresourceCount_, state_);
+    }
+
+    subresourceStates_[subresource] = state;
+
+    // Collapse back once every subresource agrees
+    for (unsigned i = 1; i < subresourceCount_; ++i)
+    {
+        if (subresourceStates_[i] != subresourceStates_[0])
+            return;
+    }
+
+    state_ = subresourceStates_[0];
+    subresourceStates_.clear();
+}
+
+ResourceStateRegistry::ResourceStateRegistry() = default;
+
+void ResourceStateRegistry::RegisterResource(ResourceHandle resource, unsigned subresourceCount, unsigned initialState)
+{
+    ResourceStates& states = states_[resource];
+    states.subresourceCount_ = subresourceCount ? subresourceCount : 1;
+    states.state_ = initialState;
+    states.subresourceStates_.clear();
+}
+
+void ResourceStateRegistry::UnregisterResource(ResourceHandle resource)
+{
+    states_.erase(resource);
+}
+
+ResourceStates const* ResourceStateRegistry::GetStates(ResourceHandle resource) const
+{
+    auto it = states_.find(resource);
+    return it != states_.end() ? &it->second : nullptr;
+}
+
+ResourceStates& ResourceStateRegistry::GetOrAddStates(ResourceHandle resource, unsigned subresourceCount)
+{
+    auto it = states_.find(resource);
+    if (it != states_.end())
+        return it->second;
+
+    ResourceStates& states = states_[resource];
+    states.subresourceCount_ = subresourceCount;
+    return states;
+}
+
+ResourceStateTracker::ResourceStateTracker(ResourceStateRegistry& registry, bool deferred)
+    : registry_(registry)
+    , deferred_(deferred)
+{
+}
+
+void ResourceStateTracker::Reset()
+{
+    assert(splits_.empty());
+
+    localStates_.clear();
+    barriers_.clear();
+    pending_.clear();
+}
+
+void ResourceStateTracker::Transition(ResourceHandle resource, unsigned after, unsigned subresource)
+{
+    ResourceStates& states = GetLocalStates(resource);
+
+    if (subresource == ALL_SUBRESOURCES && !states.IsUniform())
+    {
+        for (unsigned i = 0; i < states.subresourceCount_; ++i)
+            TransitionSubresource(resource, states, after, i);
+    }
+    else
+        TransitionSubresource(resource, states, after, subresource);
+}
+
+void ResourceStateTracker::BeginTransition(ResourceHandle resource, unsigned after, unsigned subresource)
+{
+    ResourceStates& states = GetLocalStates(resource);
+    unsigned before = states.Get(subresource == ALL_SUBRESOURCES ? 0 : subresource);
+
+    // A split needs a known uniform starting state, otherwise fall back to a regular transition
+    if (before == ResourceStates::UnknownState || (subresource == ALL_SUBRESOURCES && !states.IsUniform()))
+    {
+        Transition(resource, after, subresource);
+        return;
+    }
+
+    if (IsResourceStateCompatible(before, after))
+    {
+        ++stats_.redundant_;
+        return;
+    }
+
+    ResourceBarrierDesc barrier;
+    barrier.resource_ = resource;
+    barrier.subresource_ = subresource;
+    barrier.before_ = before;
+    barrier.after_ = after;
+    barrier.flags_ = RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+    barriers_.push_back(barrier);
+
+    splits_.push_back({ resource, subresource, after });
+}
+
+void ResourceStateTracker::EndTransition(ResourceHandle resource, unsigned subresource)
+{
+    for (unsigned i = 0; i < splits_.size(); ++i)
+    {
+        SplitTransition split = splits_[i];
+        if (split.resource_ != resource || split.subresource_ != subresource)
+            continue;
+
+        ResourceStates& states = GetLocalStates(resource);
+
+        ResourceBarrierDesc barrier;
+        barrier.resource_ = resource;
+        barrier.subresource_ = subresource;
+        barrier.before_ = states.Get(subresource == ALL_SUBRESOURCES ? 0 : subresource);
+        barrier.after_ = split.after_;
+        barrier.flags_ = RESOURCE_BARRIER_FLAG_END_ONLY;
+        barriers_.push_back(barrier);
+
+        states.Set(subresource, split.after_);
+        splits_.erase(splits_.begin() + i);
+        return;
+    }
+
+    // No split in progress: the begin was redundant or fell back to a regular transition
+}
+
+void ResourceStateTracker::AliasingBarrier(ResourceHandle before, ResourceHandle after)
+{
+    ResourceBarrierDesc barrier;
+    barrier.type_ = RESOURCE_BARRIER_TYPE_ALIASING;
+    barrier.resource_ = after;
+    barrier.aliasBefore_ = before;
+    barriers_.push_back(barrier);
+}
+
+unsigned ResourceStateTracker::FlushBarriers(GraphicsBackend& backend)
+{
+    unsigned count = (unsigned) barriers_.size();
+    if (!count)
+        return 0;
+
+    backend.ResourceBarrier(count, barriers_.data());
+    barriers_.clear();
+
+    stats_.barriers_ += count;
+    ++stats_.batches_;
+    return count;
+}
+
+unsigned ResourceStateTracker::FlushBarriers(CommandList& commandList)
+{
+    unsigned count = (unsigned) barriers_.size();
+    if (!count)
+        return 0;
+
+    commandList.ResourceBarrier(count, barriers_.data());
+    barriers_.clear();
+
+    stats_.barriers_ += count;
+    ++stats_.batches_;
+    return count;
+}
+
+void ResourceStateTracker::ResolvePendingBarriers(std::vector<ResourceBarrierDesc>& barriers) const
+{
+    for (PendingTransition const& pending : pending_)
+    {
+        ResourceStates const* states = registry_.GetStates(pending.resource_);
+        ResourceStates common;
+        if (!states)
+            states = &common;
+
+        ResourceBarrierDesc barrier;
+        barrier.resource_ = pending.resource_;
+        barrier.after_ = pending.state_;
+
+        if (pending.subresource_ == ALL_SUBRESOURCES && !states->IsUniform())
+        {
+            for (unsigned i = 0; i < states->subresourceCount_; ++i)
+            {
+                if (IsResourceStateCompatible(states->Get(i), pending.state_))
+                    continue;
+
+                barrier.subresource_ = i;
+                barrier.before_ = states->Get(i);
+                barriers.push_back(barrier);
+            }
+        }
+        else
+        {
+            unsigned before = states->Get(pending.subresource_ == ALL_SUBRESOURCES ? 0 : pending.subresource_);
+            if (IsResourceStateCompatible(before, pending.state_))
+                continue;
+
+            barrier.subresource_ = pending.subresource_;
+            barrier.before_ = before;
+            barriers.push_back(barrier);
+        }
+    }
+}
+
+void ResourceStateTracker::Commit()
+{
+    for (auto& pair : localStates_)
+    {
+        ResourceStates const& local = pair.second;
+        ResourceStates& global = registry_.GetOrAddStates(pair.first, local.subresourceCount_);
+
+        if (local.IsUniform())
+        {
+            if (local.state_ != ResourceStates::UnknownState)
+                global.Set(ALL_SUBRESOURCES, local.state_);
+            continue;
+        }
+
+        for (unsigned i = 0; i < local.subresourceCount_; ++i)
+        {
+            if (local.subresourceStates_[i] != ResourceStates::UnknownState)
+                global.Set(i, local.subresourceStates_[i]);
+        }
+    }
+}
+
+ResourceStates& ResourceStateTracker::GetLocalStates(ResourceHandle resource)
+{
+    auto it = localStates_.find(resource);
+    if (it != localStates_.end())
+        return it->second;
+
+    ResourceStates& states = localStates_[resource];
+    ResourceStates const* global = registry_.GetStates(resource);
+
+    if (deferred_)
+    {
+        states.subresourceCount_ = global ? global->subresourceCount_ : 1;
+        states.state_ = ResourceStates::UnknownState;
+    }
+    else if (global)
+        states = *global;
+
+    return states;
+}
+
+void ResourceStateTracker::TransitionSubresource(ResourceHandle resource, ResourceStates& states, unsigned after, unsigned subresource)
+{
+    unsigned before = states.Get(subresource == ALL_SUBRESOURCES ? 0 : subresource);
+
+    if (before == ResourceStates::UnknownState)
+    {
+        pending_.push_back({ resource, subresource, after });
+        states.Set(subresource, after);
+        return;
+    }
+
+    if (IsResourceStateCompatible(before, after))
+    {
+        ++stats_.redundant_;
+        return;
+    }
+
+    AddBarrier(resource, subresource, before, after);
+    states.Set(subresource, after);
+}
+
+void ResourceStateTracker::AddBarrier(ResourceHandle resource, unsigned subresource, unsigned before, unsigned after)
+{
+    // Fold A->B, B->C into A->C and drop A->B, B->A entirely, as long as no barrier in between overlaps the subresource
+    for (unsigned i = (unsigned) barriers_.size(); i-- > 0;)
+    {
+        ResourceBarrierDesc& barrier = barriers_[i];
+        if (barrier.resource_ != resource)
+            continue;
+
+        // Transitions must stay after the aliasing barrier that activates the resource
+        if (barrier.type_ != RESOURCE_BARRIER_TYPE_TRANSITION)
+            break;
+
+        if (barrier.subresource_ != subresource)
+        {
+            if (barrier.subresource_ == ALL_SUBRESOURCES || subresource == ALL_SUBRESOURCES)
+                break;
+            continue;
+        }
+
+        if (barrier.flags_ != RESOURCE_BARRIER_FLAG_NONE || barrier.after_ != before)
+            break;
+
+        ++stats_.merged_;
+        if (barrier.before_ == after)
+            barriers_.erase(barriers_.begin() + i);
+        else
+            barrier.after_ = after;
+        return;
+    }
+
+    ResourceBarrierDesc barrier;
+    barrier.resource_ = resource;
+    barrier.subresource_ = subresource;
+    barrier.before_ = before;
+    barrier.after_ = after;
+    barriers_.push_back(barrier);
+}
@@ -0,0 +1,378 @@
+#include "Scene.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+
+/// Alignment of the arrays in a chunk, a cache line so arrays do not share one
+static constexpr unsigned arrayAlignment{64};
+
+/// Return offset rounded up to the array alignment.
+static unsigned AlignArray(unsigned offset)
+{
+    return (offset + arrayAlignment - 1) & ~(arrayAlignment - 1);
+}
+
+Scene::Scene() = default;
+
+Scene::~Scene() = default;
+
+ComponentId Scene::RegisterComponent(std::string const& name, unsigned size, unsigned alignment)
+{
+    assert(componentTypes_.size() < MAX_SCENE_COMPONENTS);
+    assert(alignment <= arrayAlignment && size % (alignment ? alignment : 1) == 0);
+
+    componentTypes_.push_back({ name, size, alignment });
+    return (ComponentId) componentTypes_.size() - 1;
+}
+
+Entity Scene::CreateEntity(ComponentMask components)
+{
+    Entity entity = AllocateEntity();
+    unsigned row;
+    SceneChunk& chunk = AppendEntity(GetArchetype(components), entity, row);
+    records_[entity.index_].chunk_ = &chunk;
+    records_[entity.index_].row_ = row;
+    return entity;
+}
+
+void Scene::CreateEntities(ComponentMask components, unsigned count, std::vector<Entity>* entities)
+{
+    PROFILE_SCOPE("CreateEntities");
+
+    SceneArchetype& archetype = GetArchetype(components);
+    while (count)
+    {
+        // Fill the free rows of a chunk at once, array by array
+        SceneChunk& chunk = GetFreeChunk(archetype);
+        unsigned first = chunk.count_;
+        unsigned rows = std::min(count, archetype.capacity_ - first);
+        for (ComponentId id : archetype.components_)
+        {
+            unsigned size = componentTypes_[id].size_;
+            memset(chunk.data_ + archetype.offsets_[id] + (size_t) first * size, 0, (size_t) rows * size);
+            chunk.versions_[id] = version_;
+        }
+
+        Entity* chunkEntities = (Entity*) chunk.data_;
+        for (unsigned row = first; row < first + rows; ++row)
+        {
+            Entity entity = AllocateEntity();
+            chunkEntities[row] = entity;
+            records_[entity.index_].chunk_ = &chunk;
+            records_[entity.index_].row_ = row;
+            if (entities)
+                entities->push_back(entity);
+        }
+
+        chunk.count_ += rows;
+        count -= rows;
+    }
+}
+
+bool Scene::DestroyEntity(Entity entity)
+{
+    if (!IsAlive(entity))
+        return false;
+
+    EntityRecord& record = records_[entity.index_];
+    RemoveRow(*record.chunk_, record.row_);
+    record.chunk_ = nullptr;
+    if (!++record.generation_)
+        record.generation_ = 1;
+
+    freeIndices_.push_back(entity.index_);
+    destroyed_.push_back(entity.index_);
+    --entityCount_;
+    return true;
+}
+
+bool Scene::AddComponents(Entity entity, ComponentMask components)
+{
+    if (!IsAlive(entity))
+        return false;
+
+    ComponentMask current = GetComponents(entity);
+    if ((current | components) == current)
+        return true;
+
+    // The entity moves to the archetype with the components added, keeping the values it had
+    EntityRecord& record = records_[entity.index_];
+    SceneChunk& source = *record.chunk_;
+    unsigned sourceRow = record.row_;
+    unsigned row;
+    SceneChunk& dest = AppendEntity(GetArchetype(current | components), entity, row);
+    for (ComponentId id : source.archetype_->components_)
+    {
+        unsigned size = componentTypes_[id].size_;
+        memcpy(dest.data_ + dest.archetype_->offsets_[id] + (size_t) row * size,
+            source.data_ + source.archetype_->offsets_[id] + (size_t) sourceRow * size, size);
+    }
+
+    RemoveRow(source, sourceRow);
+    record.chunk_ = &dest;
+    record.row_ = row;
+    return true;
+}
+
+bool Scene::RemoveComponents(Entity entity, ComponentMask components)
+{
+    if (!IsAlive(entity))
+        return false;
+
+    ComponentMask current = GetComponents(entity);
+    if (!(current & components))
+        return true;
+
+    EntityRecord& record = records_[entity.index_];
+    SceneChunk& source = *record.chunk_;
+    unsigned sourceRow = record.row_;
+    unsigned row;
+    SceneChunk& dest = AppendEntity(GetArchetype(current & ~components), entity, row);
+    for (ComponentId id : dest.archetype_->components_)
+    {
+        unsigned size = componentTypes_[id].size_;
+        memcpy(dest.data_ + dest.archetype_->offsets_[id] + (size_t) row * size,
+            source.data_ + source.archetype_->offsets_[id] + (size_t) sourceRow * size, size);
+    }
+
+    RemoveRow(source, sourceRow);
+    record.chunk_ = &dest;
+    record.row_ = row;
+    return true;
+}
+
+ComponentMask Scene::GetComponents(Entity entity) const
+{
+    return IsAlive(entity) ? records_[entity.index_].chunk_->archetype_->mask_ : 0;
+}
+
+void const* Scene::GetComponent(Entity entity, ComponentId id) const
+{
+    if (!IsAlive(entity))
+        return nullptr;
+
+    EntityRecord const& record = records_[entity.index_];
+    uint8_t* components = (uint8_t*) record.chunk_->GetComponents(id);
+    return components ? components + (size_t) record.row_ * componentTypes_[id].size_ : nullptr;
+}
+
+void* Scene::WriteComponent(Entity entity, ComponentId id)
+{
+    void* component = const_cast<void*>(GetComponent(entity, id));
+    if (component)
+        records_[entity.index_].chunk_->versions_[id] = version_;
+    return component;
+}
+
+void Scene::GetChunks(SceneQuery const& query, std::vector<SceneChunk*>& chunks)
+{
+    chunks.clear();
+    for (std::unique_ptr<SceneArchetype> const& archetype : archetypes_)
+    {
+        ComponentMask mask = archetype->mask_;
+        if ((mask & query.all_) != query.all_ || (mask & query.none_))
+            continue;
+
+        for (std::unique_ptr<SceneChunk> const& chunk : archetype->chunks_)
+        {
+            if (!IsChanged(*chunk, query))
+                continue;
+
+            for (ComponentId id : archetype->components_)
+            {
+                if (query.write_ & GetMask(id))
+                    chunk->versions_[id] = version_;
+            }
+            chunks.push_back(chunk.get());
+        }
+    }
+}
+
+void Scene::ForEachChunk(SceneQuery const& query, ChunkFunction const& function)
+{
+    std::vector<SceneChunk*> chunks;
+    GetChunks(query, chunks);
+    for (SceneChunk* chunk : chunks)
+        function(*chunk);
+}
+
+void Scene::ParallelForEachChunk(SceneQuery const& query, ChunkFunction const& function)
+{
+    std::vector<SceneChunk*> chunks;
+    GetChunks(query, chunks);
+
+    unsigned count = (unsigned) chunks.size();
+    if (!jobSystem_ || count < 2)
+    {
+        for (SceneChunk* chunk : chunks)
+            function(*chunk);
+        return;
+    }
+
+    // A few batches per thread even out chunks that take longer
+    unsigned batchSize = std::max(count / (jobSystem_->GetThreadCount() * 4), 1u);
+    jobSystem_->ParallelFor(count, batchSize, [&](unsigned begin, unsigned end)
+    {
+        for (unsigned i = begin; i < end; ++i)
+            function(*chunks[i]);
+    });
+}
+
+unsigned Scene::GetEntityCount(SceneQuery const& query) const
+{
+    unsigned count = 0;
+    for (std::unique_ptr<SceneArchetype> const& archetype : archetypes_)
+    {
+        ComponentMask mask = archetype->mask_;
+        if ((mask & query.all_) != query.all_ || (mask & query.none_))
+            continue;
+
+        for (std::unique_ptr<SceneChunk> const& chunk : archetype->chunks_)
+        {
+            if (IsChanged(*chunk, query))
+                count += chunk->count_;
+        }
+    }
+    return count;
+}
+
+SceneStats Scene::GetStats() const
+{
+    SceneStats stats;
+    stats.entities_ = entityCount_;
+    stats.archetypes_ = (unsigned) archetypes_.size();
+    for (std::unique_ptr<SceneArchetype> const& archetype : archetypes_)
+        stats.chunks_ += (unsigned) archetype->chunks_.size();
+    return stats;
+}
+
+SceneArchetype& Scene::GetArchetype(ComponentMask components)
+{
+    auto it = archetypeIndices_.find(components);
+    if (it != archetypeIndices_.end())
+        return *archetypes_[it->second];
+
+    std::unique_ptr<SceneArchetype> archetype(new SceneArchetype());
+    archetype->mask_ = components;
+    unsigned rowSize = sizeof(Entity);
+    for (ComponentId id = 0; id < componentTypes_.size(); ++id)
+    {
+        if (components & GetMask(id))
+        {
+            archetype->components_.push_back(id);
+            rowSize += componentTypes_[id].size_;
+        }
+    }
+    assert(!(components >> componentTypes_.size()) || componentTypes_.size() == MAX_SCENE_COMPONENTS);
+
+    // Take as many rows as fit with every array padded to its alignment
+    unsigned padding = (unsigned) archetype->components_.size() * arrayAlignment;
+    unsigned capacity = (ChunkSize - std::min(padding, ChunkSize / 2)) / rowSize;
+    for (;; --capacity)
+    {
+        unsigned offset = AlignArray(capacity * (unsigned) sizeof(Entity));
+        for (ComponentId id : archetype->components_)
+        {
+            archetype->offsets_[id] = offset;
+            offset = AlignArray(offset + capacity * componentTypes_[id].size_);
+        }
+        if (offset <= ChunkSize)
+            break;
+    }
+    assert(capacity);
+    archetype->capacity_ = capacity;
+
+    archetypeIndices_[components] = (unsigned) archetypes_.size();
+    archetypes_.push_back(std::move(archetype));
+    return *archetypes_.back();
+}
+
+SceneChunk& Scene::GetFreeChunk(SceneArchetype& archetype)
+{
+    if (archetype.chunks_.empty() || archetype.chunks_.back()->count_ == archetype.capacity_)
+    {
+        std::unique_ptr<SceneChunk> chunk(new SceneChunk());
+        chunk->archetype_ = &archetype;
+        chunk->storage_.reset(new uint8_t[ChunkSize + arrayAlignment - 1]);
+        chunk->data_ = (uint8_t*) (((size_t) chunk->storage_.get() + arrayAlignment - 1) & ~(size_t) (arrayAlignment - 1));
+        archetype.chunks_.push_back(std::move(chunk));
+    }
+
+    return *archetype.chunks_.back();
+}
+
+SceneChunk& Scene::AppendEntity(SceneArchetype& archetype, Entity entity, unsigned& row)
+{
+    SceneChunk& chunk = GetFreeChunk(archetype);
+    row = chunk.count_++;
+    ((Entity*) chunk.data_)[row] = entity;
+    for (ComponentId id : archetype.components_)
+    {
+        unsigned size = componentTypes_[id].size_;
+        memset(chunk.data_ + archetype.offsets_[id] + (size_t) row * size, 0, size);
+        chunk.versions_[id] = version_;
+    }
+    return chunk;
+}
+
+void Scene::RemoveRow(SceneChunk& chunk, unsigned row)
+{
+    SceneArchetype& archetype = *chunk.archetype_;
+    SceneChunk& last = *archetype.chunks_.back();
+    unsigned lastRow = last.count_ - 1;
+
+    // The moved entity's values are new to its chunk
+    if (&chunk != &last || row != lastRow)
+    {
+        Entity moved = ((Entity*) last.data_)[lastRow];
+        ((Entity*) chunk.data_)[row] = moved;
+        for (ComponentId id : archetype.components_)
+        {
+            unsigned size = componentTypes_[id].size_;
+            memcpy(chunk.data_ + archetype.offsets_[id] + (size_t) row * size,
+                last.data_ + archetype.offsets_[id] + (size_t) lastRow * size, size);
+            chunk.versions_[id] = version_;
+        }
+        records_[moved.index_].chunk_ = &chunk;
+        records_[moved.index_].row_ = row;
+    }
+
+    if (!--last.count_)
+        archetype.chunks_.pop_back();
+}
+
+Entity Scene::AllocateEntity()
+{
+    Entity entity;
+    if (!freeIndices_.empty())
+    {
+        entity.index_ = freeIndices_.back();
+        freeIndices_.pop_back();
+    }
+    else
+    {
+        entity.index_ = (unsigned) records_.size();
+        records_.push_back({ nullptr, 0, 1 });
+    }
+
+    entity.generation_ = records_[entity.index_].generation_;
+    ++entityCount_;
+    return entity;
+}
+
+bool Scene::IsChanged(SceneChunk const& chunk, SceneQuery const& query)
+{
+    if (!query.changed_)
+        return true;
+
+    for (ComponentId id : chunk.archetype_->components_)
+    {
+        if ((query.changed_ & GetMask(id)) && chunk.versions_[id] > query.changedSince_)
+            return true;
+    }
+    return false;
+}
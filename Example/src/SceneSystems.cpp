@@ -0,0 +1,139 @@
+#include "SceneSystems.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+
+
+/// Set bounds no frustum contains, a sphere of negative radius, for entity slots that are not drawn.
+static void HideObject(FrustumCuller& culler, unsigned index)
+{
+    culler.SetBounds(index, BoundingSphere(Vector3(), -FLT_MAX), BoundingBox());
+}
+
+SceneComponents::SceneComponents(Scene& scene)
+    : transform_(scene.RegisterComponent<TransformComponent>("Transform"))
+    , motion_(scene.RegisterComponent<MotionComponent>("Motion"))
+    , worldTransform_(scene.RegisterComponent<WorldTransformComponent>("WorldTransform"))
+    , renderable_(scene.RegisterComponent<RenderableComponent>("Renderable"))
+{
+}
+
+void UpdateMotion(Scene& scene, SceneComponents const& components, float timeStep)
+{
+    PROFILE_SCOPE("UpdateMotion");
+
+    SceneQuery query;
+    query.all_ = Scene::GetMask(components.transform_) | Scene::GetMask(components.motion_);
+    query.write_ = Scene::GetMask(components.transform_);
+
+    scene.ParallelForEachChunk(query, [&](SceneChunk& chunk)
+    {
+        TransformComponent* transforms = chunk.GetComponents<TransformComponent>(components.transform_);
+        MotionComponent const* motions = chunk.GetComponents<MotionComponent>(components.motion_);
+        unsigned count = chunk.GetCount();
+        for (unsigned i = 0; i < count; ++i)
+        {
+            TransformComponent& transform = transforms[i];
+            MotionComponent const& motion = motions[i];
+            transform.position_ = transform.position_ + motion.velocity_ * timeStep;
+
+            float speed = motion.angularVelocity_.Length();
+            if (speed > 0.0f)
+            {
+                Quaternion step = Quaternion::FromAxisAngle(motion.angularVelocity_ * (1.0f / speed), speed * timeStep);
+                transform.rotation_ = (step * transform.rotation_).Normalized();
+            }
+        }
+    });
+}
+
+void UpdateWorldTransforms(Scene& scene, SceneComponents const& components, uint32_t& lastVersion)
+{
+    PROFILE_SCOPE("UpdateWorldTransforms");
+
+    SceneQuery query;
+    query.all_ = Scene::GetMask(components.transform_) | Scene::GetMask(components.worldTransform_);
+    query.write_ = Scene::GetMask(components.worldTransform_);
+    query.changed_ = Scene::GetMask(components.transform_);
+    query.changedSince_ = lastVersion;
+
+    scene.ParallelForEachChunk(query, [&](SceneChunk& chunk)
+    {
+        TransformComponent const* transforms = chunk.GetComponents<TransformComponent>(components.transform_);
+        WorldTransformComponent* worldTransforms = chunk.GetComponents<WorldTransformComponent>(components.worldTransform_);
+        unsigned count = chunk.GetCount();
+        for (unsigned i = 0; i < count; ++i)
+        {
+            TransformComponent const& transform = transforms[i];
+            worldTransforms[i].world_ = Matrix4::FromTRS(transform.position_, transform.rotation_, transform.scale_);
+        }
+    });
+
+    lastVersion = scene.AdvanceVersion();
+}
+
+void SyncRenderables(Scene& scene, SceneComponents const& components, uint32_t& lastVersion, FrustumCuller& culler,
+    RenderableChanges& changes)
+{
+    PROFILE_SCOPE("SyncRenderables");
+
+    // Slots the culler has not seen stay hidden unless a renderable changed into them, as do destroyed ones
+    unsigned oldCount = culler.GetObjectCount();
+    unsigned slotCount = scene.GetEntitySlotCount();
+    if (slotCount > oldCount)
+    {
+        culler.Resize(slotCount);
+        for (unsigned i = oldCount; i < slotCount; ++i)
+            HideObject(culler, i);
+    }
+    for (unsigned index : scene.GetDestroyedEntities())
+        HideObject(culler, index);
+    scene.ClearDestroyedEntities();
+
+    SceneQuery query;
+    query.all_ = Scene::GetMask(components.worldTransform_) | Scene::GetMask(components.renderable_);
+    query.changed_ = Scene::GetMask(components.worldTransform_) | Scene::GetMask(components.renderable_);
+    query.changedSince_ = lastVersion;
+
+    // Chunks write at offsets of their own, so the changes come out in chunk order without locking
+    std::vector<SceneChunk*> chunks;
+    scene.GetChunks(query, chunks);
+    std::vector<unsigned> offsets(chunks.size() + 1);
+    for (size_t i = 0; i < chunks.size(); ++i)
+        offsets[i + 1] = offsets[i] + chunks[i]->GetCount();
+    changes.objects_.resize(offsets.back());
+    changes.transforms_.resize(offsets.back());
+
+    auto syncChunks = [&](unsigned begin, unsigned end)
+    {
+        for (unsigned c = begin; c < end; ++c)
+        {
+            SceneChunk& chunk = *chunks[c];
+            Entity const* entities = chunk.GetEntities();
+            WorldTransformComponent const* worldTransforms = chunk.GetComponents<WorldTransformComponent>(components.worldTransform_);
+            RenderableComponent const* renderables = chunk.GetComponents<RenderableComponent>(components.renderable_);
+            unsigned* objects = changes.objects_.data() + offsets[c];
+            Matrix4* transforms = changes.transforms_.data() + offsets[c];
+            unsigned count = chunk.GetCount();
+            for (unsigned i = 0; i < count; ++i)
+            {
+                Matrix4 const& world = worldTransforms[i].world_;
+                culler.SetBounds(entities[i].index_, renderables[i].bounds_.Transformed(world));
+                objects[i] = entities[i].index_;
+                transforms[i] = world;
+            }
+        }
+    };
+
+    JobSystem* jobSystem = scene.GetJobSystem();
+    unsigned chunkCount = (unsigned) chunks.size();
+    if (jobSystem && chunkCount > 1)
+        jobSystem->ParallelFor(chunkCount, std::max(chunkCount / (jobSystem->GetThreadCount() * 4), 1u), syncChunks);
+    else
+        syncChunks(0, chunkCount);
+
+    lastVersion = scene.AdvanceVersion();
+}
@@ -0,0 +1,436 @@
+#include "ShaderCompiler.h"
+#include "ByteStream.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+
+/// Cache file identifier, "SHBC" little-endian.
+static const uint32_t ShaderCacheMagic = 0x43424853;
+/// Cache file format version.
+static const uint32_t ShaderCacheVersion = 1;
+/// Include nesting limit, deeper nesting is taken as a cycle.
+static const unsigned MaxIncludeDepth = 32;
+
+/// Return path with forward slashes and without "." and "dir/.." segments.
+static std::string NormalizePath(std::string const& path)
+{
+    std::string unified = path;
+    std::replace(unified.begin(), unified.end(), '\\', '/');
+
+    std::vector<std::string> segments;
+    size_t start = 0;
+    bool absolute = !unified.empty() && unified[0] == '/';
+    while (start <= unified.size())
+    {
+        size_t end = unified.find('/', start);
+        if (end == std::string::npos)
+            end = unified.size();
+
+        std::string segment = unified.substr(start, end - start);
+        if (segment == "..")
+        {
+            if (!segments.empty() && segments.back() != "..")
+                segments.pop_back();
+            else if (!absolute)
+                segments.push_back(segment);
+        }
+        else if (!segment.empty() && segment != ".")
+            segments.push_back(segment);
+
+        start = end + 1;
+    }
+
+    std::string result = absolute ? "/" : "";
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        if (i)
+            result += '/';
+        result += segments[i];
+    }
+    return result;
+}
+
+/// Return directory part of a path including the trailing slash, empty if none.
+static std::string GetDirectory(std::string const& path)
+{
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+/// Return position after a preprocessor directive keyword, npos if the line is not that directive.
+static size_t ParseDirective(std::string const& line, char const* keyword)
+{
+    size_t position = line.find_first_not_of(" \t");
+    if (position == std::string::npos || line[position] != '#')
+        return std::string::npos;
+
+    size_t length = strlen(keyword);
+    position = line.find_first_not_of(" \t", position + 1);
+    if (position == std::string::npos || line.compare(position, length, keyword) != 0)
+        return std::string::npos;
+
+    return line.find_first_not_of(" \t", position + length);
+}
+
+/// Return the file name of an #include line, empty if the line is not an include.
+static std::string ParseInclude(std::string const& line)
+{
+    size_t position = ParseDirective(line, "include");
+    if (position == std::string::npos || (line[position] != '"' && line[position] != '<'))
+        return std::string();
+
+    char terminator = line[position] == '"' ? '"' : '>';
+    size_t end = line.find(terminator, position + 1);
+    return end == std::string::npos ? std::string() : line.substr(position + 1, end - position - 1);
+}
+
+/// Return whether a line is #pragma once.
+static bool IsPragmaOnce(std::string const& line)
+{
+    size_t position = ParseDirective(line, "pragma");
+    return position != std::string::npos && line.compare(position, 4, "once") == 0;
+}
+
+ShaderCompiler::ShaderCompiler(ShaderCompilerBackend& backend, std::string const& cacheDirectory)
+    : backend_(backend)
+    , cacheDirectory_(cacheDirectory)
+{
+}
+
+void ShaderCompiler::AddIncludeDirectory(std::string const& directory)
+{
+    includeDirectories_.push_back(NormalizePath(directory));
+}
+
+void ShaderCompiler::ClearFileCache()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.clear();
+}
+
+bool ShaderCompiler::Compile(ShaderCompileDesc const& desc, ShaderCompileResult& result)
+{
+    result = ShaderCompileResult();
+
+    std::string source;
+    bool preprocessed = Preprocess(desc, source, result.dependencies_, result.messages_);
+
+    if (preprocessed)
+        result.hash_ = HashPermutation(source, desc);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++stats_.requests_;
+    if (!preprocessed)
+    {
+        ++stats_.failed_;
+        return false;
+    }
+
+    // Identical permutations in flight are compiled once, the others wait for the bytecode
+    compiledCondition_.wait(lock, [&]() { return !inProgress_.count(result.hash_); });
+
+    auto it = bytecode_.find(result.hash_);
+    if (it != bytecode_.end())
+    {
+        ++stats_.memoryHits_;
+        result.bytecode_ = it->second;
+        result.success_ = result.cached_ = true;
+        return true;
+    }
+
+    inProgress_.insert(result.hash_);
+    lock.unlock();
+
+    bool fromDisk = ReadCache(result.hash_, result.bytecode_);
+    bool compiled = fromDisk || backend_.Compile(source, desc, result.bytecode_, result.messages_);
+    if (compiled && !fromDisk)
+        WriteCache(result.hash_, result.bytecode_);
+
+    lock.lock();
+    if (fromDisk)
+        ++stats_.diskHits_;
+    else if (compiled)
+        ++stats_.compiled_;
+    else
+        ++stats_.failed_;
+
+    // Failures are not remembered, the next request retries with whatever changed
+    if (compiled)
+        bytecode_[result.hash_] = result.bytecode_;
+    inProgress_.erase(result.hash_);
+    lock.unlock();
+    compiledCondition_.notify_all();
+
+    result.success_ = compiled;
+    result.cached_ = fromDisk;
+    return compiled;
+}
+
+unsigned ShaderCompiler::CompileAll(std::vector<ShaderCompileDesc> const& descs, std::vector<ShaderCompileResult>& results, JobSystem* jobSystem)
+{
+    results.clear();
+    results.resize(descs.size());
+
+    std::vector<uint8_t> failed(descs.size());
+    auto compileRange = [&](unsigned begin, unsigned end)
+    {
+        for (unsigned i = begin; i < end; ++i)
+            failed[i] = !Compile(descs[i], results[i]);
+    };
+
+    // One permutation per job, compile times vary too much for larger batches to balance
+    if (jobSystem)
+        jobSystem->ParallelFor((unsigned) descs.size(), 1, compileRange);
+    else
+        compileRange(0, (unsigned) descs.size());
+
+    return (unsigned) std::count(failed.begin(), failed.end(), (uint8_t) 1);
+}
+
+bool ShaderCompiler::ReadManifest(std::string const& manifestFileName, std::vector<ShaderCompileDesc>& descs, std::string& messages)
+{
+    std::vector<uint8_t> data;
+    if (!ReadFileBytes(manifestFileName, data))
+    {
+        messages += "Cannot read shader manifest " + manifestFileName + "\n";
+        return false;
+    }
+
+    std::istringstream stream(std::string(data.begin(), data.end()));
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(stream, line))
+    {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream lineStream(line);
+        ShaderCompileDesc desc;
+        if (!(lineStream >> desc.fileName_))
+            continue;
+        if (!(lineStream >> desc.entryPoint_ >> desc.profile_))
+        {
+            messages += manifestFileName + "(" + std::to_string(lineNumber) + "): expected file, entry point and profile\n";
+            return false;
+        }
+
+        // Permutation files are relative to the manifest
+        desc.fileName_ = NormalizePath(GetDirectory(NormalizePath(manifestFileName)) + desc.fileName_);
+
+        std::string define;
+        while (lineStream >> define)
+        {
+            size_t equals = define.find('=');
+            ShaderDefine shaderDefine;
+            shaderDefine.name_ = define.substr(0, equals);
+            shaderDefine.value_ = equals == std::string::npos ? "1" : define.substr(equals + 1);
+            desc.defines_.push_back(shaderDefine);
+        }
+
+        descs.push_back(desc);
+    }
+
+    return true;
+}
+
+bool ShaderCompiler::Preprocess(ShaderCompileDesc const& desc, std::string& source, std::vector<std::string>& dependencies, std::string& messages)
+{
+    std::unordered_set<std::string> onceFiles;
+    source.clear();
+    dependencies.clear();
+    return ExpandIncludes(NormalizePath(desc.fileName_), source, dependencies, onceFiles, messages, 0);
+}
+
+ContentHash ShaderCompiler::HashPermutation(std::string const& source, ShaderCompileDesc const& desc) const
+{
+    std::vector<ShaderDefine> defines = desc.defines_;
+    std::sort(defines.begin(), defines.end(), [](ShaderDefine const& lhs, ShaderDefine const& rhs) { return lhs.name_ < rhs.name_; });
+
+    std::vector<uint8_t> data;
+    data.reserve(source.size() + 256);
+
+    ByteWriter writer(data);
+    writer.WriteString(source);
+    writer.WriteString(desc.entryPoint_);
+    writer.WriteString(desc.profile_);
+    writer.WriteU32((uint32_t) defines.size());
+    for (ShaderDefine const& define : defines)
+    {
+        writer.WriteString(define.name_);
+        writer.WriteString(define.value_);
+    }
+    writer.WriteU64(backend_.GetVersion());
+
+    return HashContent(data.data(), data.size());
+}
+
+std::string ShaderCompiler::GetCacheFileName(ContentHash const& hash) const
+{
+    return cacheDirectory_ + "/" + hash.ToString() + ".shader";
+}
+
+ShaderCompilerStats ShaderCompiler::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool ShaderCompiler::ReadSource(std::string const& fileName, std::string& contents)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = files_.find(fileName);
+        if (it != files_.end())
+        {
+            contents = it->second.second;
+            return it->second.first;
+        }
+    }
+
+    std::vector<uint8_t> data;
+    bool readable = ReadFileBytes(fileName, data);
+    contents.assign(data.begin(), data.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_[fileName] = std::make_pair(readable, contents);
+    return readable;
+}
+
+bool ShaderCompiler::ExpandIncludes(std::string const& fileName, std::string& source, std::vector<std::string>& dependencies,
+    std::unordered_set<std::string>& onceFiles, std::string& messages, unsigned depth)
+{
+    if (depth > MaxIncludeDepth)
+    {
+        messages += fileName + ": includes nested too deep, possibly recursive\n";
+        return false;
+    }
+
+    if (onceFiles.count(fileName))
+        return true;
+
+    std::string contents;
+    if (!ReadSource(fileName, contents))
+    {
+        messages += "Cannot read shader source " + fileName + "\n";
+        return false;
+    }
+
+    if (std::find(dependencies.begin(), dependencies.end(), fileName) == dependencies.end())
+        dependencies.push_back(fileName);
+
+    // Line directives keep compiler messages pointing at the original files
+    source += "#line 1 \"" + fileName + "\"\n";
+
+    std::istringstream stream(contents);
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(stream, line))
+    {
+        ++lineNumber;
+
+        // Expanded even inside inactive #if blocks, the directives around it still exclude the text
+        std::string include = ParseInclude(line);
+        if (!include.empty())
+        {
+            std::string resolved = ResolveInclude(include, fileName);
+            if (resolved.empty())
+            {
+                messages += fileName + "(" + std::to_string(lineNumber) + "): cannot find include " + include + "\n";
+                return false;
+            }
+
+            if (!ExpandIncludes(resolved, source, dependencies, onceFiles, messages, depth + 1))
+                return false;
+
+            source += "#line " + std::to_string(lineNumber + 1) + " \"" + fileName + "\"\n";
+            continue;
+        }
+
+        if (IsPragmaOnce(line))
+        {
+            onceFiles.insert(fileName);
+            source += "\n";
+            continue;
+        }
+
+        source += line;
+        source += '\n';
+    }
+
+    return true;
+}
+
+std::string ShaderCompiler::ResolveInclude(std::string const& name, std::string const& includingFile)
+{
+    std::string contents;
+    std::string candidate = NormalizePath(GetDirectory(includingFile) + name);
+    if (ReadSource(candidate, contents))
+        return candidate;
+
+    for (std::string const& directory : includeDirectories_)
+    {
+        candidate = NormalizePath(directory + "/" + name);
+        if (ReadSource(candidate, contents))
+            return candidate;
+    }
+
+    return std::string();
+}
+
+bool ShaderCompiler::ReadCache(ContentHash const& hash, std::vector<uint8_t>& bytecode) const
+{
+    if (cacheDirectory_.empty())
+        return false;
+
+    std::vector<uint8_t> data;
+    if (!ReadFileBytes(GetCacheFileName(hash), data) || data.size() < 8)
+        return false;
+
+    // A torn or foreign file is treated as a miss and overwritten by the compile
+    ByteReader checksumReader(data.data() + data.size() - 8, 8);
+    uint64_t checksum;
+    if (!checksumReader.ReadU64(checksum) || checksum != HashContent(data.data(), data.size() - 8).low_)
+        return false;
+
+    ByteReader reader(data.data(), data.size() - 8);
+    uint32_t magic, version;
+    ContentHash storedHash;
+    return reader.ReadU32(magic) && magic == ShaderCacheMagic && reader.ReadU32(version) && version == ShaderCacheVersion &&
+        reader.ReadU64(storedHash.low_) && reader.ReadU64(storedHash.high_) && storedHash == hash && reader.ReadBytes(bytecode);
+}
+
+void ShaderCompiler::WriteCache(ContentHash const& hash, std::vector<uint8_t> const& bytecode) const
+{
+    if (cacheDirectory_.empty())
+        return;
+
+    std::vector<uint8_t> data;
+    ByteWriter writer(data);
+    writer.WriteU32(ShaderCacheMagic);
+    writer.WriteU32(ShaderCacheVersion);
+    writer.WriteU64(hash.low_);
+    writer.WriteU64(hash.high_);
+    writer.WriteBytes(bytecode.data(), bytecode.size());
+    writer.WriteU64(HashContent(data.data(), data.size()).low_);
+
+    std::string fileName = GetCacheFileName(hash);
+    if (WriteFileBytes(fileName, data.data(), data.size()))
+        return;
+
+    // Create the cache directory on first write
+#ifdef _WIN32
+    _mkdir(cacheDirectory_.c_str());
+#else
+    mkdir(cacheDirectory_.c_str(), 0755);
+#endif
+    WriteFileBytes(fileName, data.data(), data.size());
+}
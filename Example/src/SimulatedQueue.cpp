@@ -0,0 +1,218 @@
+#include "SimulatedQueue.h"
+
+#include <algorithm>
+
+
+SimulatedQueue::SimulatedQueue(bool threaded)
+    : root_(this)
+    , threaded_(threaded)
+{
+    if (threaded_)
+        thread_ = std::thread(&SimulatedQueue::ThreadFunction, this);
+}
+
+SimulatedQueue::SimulatedQueue(SimulatedQueue& queue)
+    : root_(queue.root_)
+    , threaded_(queue.threaded_)
+{
+}
+
+SimulatedQueue::~SimulatedQueue()
+{
+    if (thread_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exiting_ = true;
+        }
+        commandCondition_.notify_all();
+        thread_.join();
+    }
+}
+
+void SimulatedQueue::Execute(std::chrono::microseconds gpuTime)
+{
+    root_->Push({ gpuTime, 0, nullptr, nullptr, 0 });
+}
+
+void SimulatedQueue::ExecuteCommandLists(CommandList* const* /*commandLists*/, unsigned count)
+{
+    Execute(commandListTime_ * count);
+}
+
+void SimulatedQueue::Wait(GpuQueue& queue, uint64_t value)
+{
+    root_->Push({ std::chrono::microseconds(0), 0, nullptr, static_cast<SimulatedQueue*>(&queue), value });
+}
+
+void SimulatedQueue::Signal(uint64_t value)
+{
+    root_->Push({ std::chrono::microseconds(0), value, this, nullptr, 0 });
+}
+
+uint64_t SimulatedQueue::GetCompletedValue() const
+{
+    return completedValue_.load(std::memory_order_acquire);
+}
+
+void SimulatedQueue::SetEventOnCompletion(uint64_t value, WaitEvent& event)
+{
+    // A manual queue acts as an immediate GPU: run commands until the value is reached
+    if (!threaded_)
+        DriveTo(value);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (completedValue_.load() < value)
+        {
+            waiters_.push_back({ value, &event });
+            return;
+        }
+    }
+
+    event.Set();
+}
+
+unsigned SimulatedQueue::ProcessCommands(unsigned count)
+{
+    if (threaded_)
+        return 0;
+    if (root_ != this)
+        return root_->ProcessCommands(count);
+
+    unsigned processed = 0;
+    while (processed < count)
+    {
+        Command command;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (commands_.empty())
+                break;
+
+            command = commands_.front();
+        }
+
+        // Only the calling thread pops, so the command is still at the front after driving the other queue
+        if (command.waitFence_ && !command.waitFence_->DriveTo(command.waitValue_))
+            break;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            commands_.pop_front();
+        }
+
+        RunCommand(command);
+        ++processed;
+    }
+
+    return processed;
+}
+
+unsigned SimulatedQueue::GetPendingCommandCount() const
+{
+    std::lock_guard<std::mutex> lock(root_->mutex_);
+    return (unsigned) root_->commands_.size();
+}
+
+std::chrono::microseconds SimulatedQueue::GetSignalTime(uint64_t value) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Values are signaled in increasing order, the first one at or past value is when it was reached
+    auto it = std::lower_bound(signalTimes_.begin(), signalTimes_.end(), std::make_pair(value, INT64_MIN));
+    return std::chrono::microseconds(it != signalTimes_.end() ? it->second : 0);
+}
+
+void SimulatedQueue::Push(Command const& command)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        commands_.push_back(command);
+    }
+    commandCondition_.notify_one();
+}
+
+void SimulatedQueue::RunCommand(Command const& command)
+{
+    if (command.waitFence_)
+    {
+        // A threaded queue blocks like the GPU would, a manual one had the other queue driven to the value
+        if (threaded_ && command.waitFence_->GetCompletedValue() < command.waitValue_)
+        {
+            WaitEvent event;
+            command.waitFence_->SetEventOnCompletion(command.waitValue_, event);
+            event.Wait();
+        }
+
+        int64_t signalTime = command.waitFence_->GetSignalTime(command.waitValue_).count();
+        if (signalTime > timelineTime_.load())
+            timelineTime_.store(signalTime);
+    }
+
+    if (command.gpuTime_.count() > 0)
+    {
+        // Only a threaded queue pretends to be busy, a manual queue completes work instantly
+        if (threaded_)
+            std::this_thread::sleep_for(command.gpuTime_);
+        busyTime_ += command.gpuTime_.count();
+        timelineTime_ += command.gpuTime_.count();
+    }
+
+    if (command.signalValue_)
+        command.signalFence_->CompleteSignal(command.signalValue_, timelineTime_.load());
+}
+
+void SimulatedQueue::CompleteSignal(uint64_t value, int64_t time)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    completedValue_.store(value, std::memory_order_release);
+
+    signalTimes_.push_back(std::make_pair(value, time));
+    if (signalTimes_.size() > SignalTimeHistory)
+        signalTimes_.pop_front();
+
+    for (unsigned i = 0; i < waiters_.size();)
+    {
+        if (waiters_[i].value_ <= value)
+        {
+            waiters_[i].event_->Set();
+            waiters_[i] = waiters_.back();
+            waiters_.pop_back();
+        }
+        else
+            ++i;
+    }
+}
+
+bool SimulatedQueue::DriveTo(uint64_t value)
+{
+    if (!threaded_)
+    {
+        while (GetCompletedValue() < value)
+        {
+            if (!root_->ProcessCommands(1))
+                break;
+        }
+    }
+
+    return GetCompletedValue() >= value;
+}
+
+void SimulatedQueue::ThreadFunction()
+{
+    for (;;)
+    {
+        Command command;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            commandCondition_.wait(lock, [this] { return exiting_ || !commands_.empty(); });
+            if (commands_.empty())
+                return;
+
+            command = commands_.front();
+            commands_.pop_front();
+        }
+
+        RunCommand(command);
+    }
+}
@@ -0,0 +1,97 @@
+#include "StagingRing.h"
+
+#include <cassert>
+
+
+StagingRing::StagingRing() = default;
+
+StagingRing::~StagingRing()
+{
+    Shutdown();
+}
+
+bool StagingRing::Initialize(UploadBufferFactory& factory, uint64_t size)
+{
+    factory_ = &factory;
+    return factory_->CreateBuffer(size, buffer_);
+}
+
+void StagingRing::Shutdown()
+{
+    if (!factory_)
+        return;
+
+    if (buffer_.resource_)
+        factory_->DestroyBuffer(buffer_);
+    buffer_ = UploadBufferInfo();
+
+    allocations_.clear();
+    head_ = usedSize_ = 0;
+}
+
+UploadAllocation StagingRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    UploadAllocation allocation;
+    if (!IsInitialized() || !size)
+        return allocation;
+
+    // Used space runs from the oldest allocation to the head, so the free space after the head is
+    // contiguous up to the end of the buffer or the oldest allocation
+    uint64_t offset = (head_ + alignment - 1) & ~(alignment - 1);
+    uint64_t required;
+    if (offset + size > buffer_.size_)
+    {
+        offset = 0;
+        required = buffer_.size_ - head_ + size;
+    }
+    else
+        required = offset - head_ + size;
+
+    if (usedSize_ + required > buffer_.size_)
+        return allocation;
+
+    allocation.cpu_ = buffer_.cpu_ + offset;
+    allocation.gpu_ = buffer_.gpu_ + offset;
+    allocation.resource_ = buffer_.resource_;
+    allocation.offset_ = offset;
+    allocation.size_ = size;
+
+    head_ = offset + size;
+    if (head_ == buffer_.size_)
+        head_ = 0;
+    usedSize_ += required;
+    allocations_.push_back({ offset, required, 0 });
+
+    return allocation;
+}
+
+void StagingRing::Retire(UploadAllocation const& allocation, uint64_t fenceValue)
+{
+    assert(fenceValue);
+
+    // Usually one of the newest
+    for (auto it = allocations_.rbegin(); it != allocations_.rend(); ++it)
+    {
+        if (it->offset_ == allocation.offset_ && !it->fenceValue_)
+        {
+            it->fenceValue_ = fenceValue;
+            return;
+        }
+    }
+
+    assert(!"Retired allocation not found");
+}
+
+void StagingRing::Reclaim(uint64_t completedValue)
+{
+    while (!allocations_.empty() && allocations_.front().fenceValue_ && allocations_.front().fenceValue_ <= completedValue)
+    {
+        usedSize_ -= allocations_.front().size_;
+        allocations_.pop_front();
+    }
+
+    if (allocations_.empty())
+        head_ = usedSize_ = 0;
+}
@@ -0,0 +1,193 @@
+#include "SubmissionScheduler.h"
+#include "Profiler.h"
+
+#include <cassert>
+
+
+SubmissionScheduler::SubmissionScheduler()
+{
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+        openBatches_[i] = ~0u;
+}
+
+SubmissionScheduler::~SubmissionScheduler() = default;
+
+void SubmissionScheduler::SetQueue(GpuQueueType type, GpuQueue* queue)
+{
+    assert(!batchCount_);
+
+    queues_[type] = queue;
+    timelines_[type].SetFence(queue);
+    lastValues_[type] = timelines_[type].GetLastSignaledValue();
+}
+
+GpuSubmission SubmissionScheduler::Submit(GpuQueueType type, CommandList* const* commandLists, unsigned count,
+    GpuSubmission const* dependencies, unsigned dependencyCount)
+{
+    assert(queues_[type]);
+    ++stats_.submissions_;
+
+    // Collect the waits the dependencies need, at most one per queue
+    uint64_t waits[MAX_GPU_QUEUES]{};
+    bool needsWait = false;
+    for (unsigned i = 0; i < dependencyCount; ++i)
+    {
+        GpuSubmission const& dependency = dependencies[i];
+        if (!NeedsWait(type, dependency))
+        {
+            ++stats_.waitsSkipped_;
+            continue;
+        }
+
+        if (dependency.value_ > waits[dependency.queue_])
+            waits[dependency.queue_] = dependency.value_;
+        needsWait = true;
+    }
+
+    // Waits go in front of a batch, so a new one keeps the work already in the open batch from waiting too.
+    // An empty open batch can take them if no batch started after it, which could be one it now waits for
+    unsigned batchIndex = openBatches_[type];
+    if (batchIndex == ~0u || (needsWait && (!batches_[batchIndex].commandLists_.empty() || batchIndex != batchCount_ - 1)))
+        batchIndex = BeginBatch(type);
+
+    Batch& batch = batches_[batchIndex];
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+    {
+        if (waits[i] > batch.waits_[i])
+            batch.waits_[i] = waits[i];
+        if (waits[i] > waitedValues_[type][i])
+            waitedValues_[type][i] = waits[i];
+    }
+
+    batch.commandLists_.insert(batch.commandLists_.end(), commandLists, commandLists + count);
+    return { type, batch.value_ };
+}
+
+void SubmissionScheduler::Flush()
+{
+    if (!batchCount_)
+        return;
+
+    PROFILE_SCOPE("FlushSubmissions");
+
+    for (unsigned i = 0; i < batchCount_; ++i)
+    {
+        Batch& batch = batches_[i];
+        GpuQueue& queue = *queues_[batch.queue_];
+
+        for (unsigned j = 0; j < MAX_GPU_QUEUES; ++j)
+        {
+            if (batch.waits_[j])
+            {
+                queue.Wait(*queues_[j], batch.waits_[j]);
+                ++stats_.waits_;
+            }
+        }
+
+        if (!batch.commandLists_.empty())
+            queue.ExecuteCommandLists(batch.commandLists_.data(), (unsigned) batch.commandLists_.size());
+        ++stats_.batches_;
+
+        // The scheduler is the only one signaling, so the value given out at submission is the one signaled
+        uint64_t value = timelines_[batch.queue_].Signal();
+        (void) value;
+        assert(value == batch.value_);
+        batch.commandLists_.clear();
+    }
+
+    batchCount_ = 0;
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+        openBatches_[i] = ~0u;
+}
+
+void SubmissionScheduler::QueueWait(GpuQueueType type, GpuSubmission const& submission)
+{
+    assert(queues_[type]);
+
+    if (!NeedsWait(type, submission))
+    {
+        ++stats_.waitsSkipped_;
+        return;
+    }
+
+    // The wait comes after everything pending, including the open batch of this queue
+    Flush();
+    queues_[type]->Wait(*queues_[submission.queue_], submission.value_);
+    waitedValues_[type][submission.queue_] = submission.value_;
+    ++stats_.waits_;
+}
+
+bool SubmissionScheduler::IsComplete(GpuSubmission const& submission)
+{
+    if (!submission.IsValid())
+        return true;
+
+    return submission.value_ <= timelines_[submission.queue_].GetLastSignaledValue() &&
+        timelines_[submission.queue_].IsComplete(submission.value_);
+}
+
+void SubmissionScheduler::WaitForCompletion(GpuSubmission const& submission)
+{
+    if (!submission.IsValid())
+        return;
+
+    if (submission.value_ > timelines_[submission.queue_].GetLastSignaledValue())
+        Flush();
+    timelines_[submission.queue_].Wait(submission.value_);
+}
+
+void SubmissionScheduler::EndFrame(unsigned frameIndex)
+{
+    assert(frameIndex < FramePacer::MaxFramesInFlight);
+
+    Flush();
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+        frameValues_[frameIndex][i] = lastValues_[i];
+}
+
+void SubmissionScheduler::BeginFrame(unsigned frameIndex)
+{
+    assert(frameIndex < FramePacer::MaxFramesInFlight);
+
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+    {
+        if (queues_[i] && frameValues_[frameIndex][i])
+            timelines_[i].Wait(frameValues_[frameIndex][i]);
+    }
+}
+
+void SubmissionScheduler::WaitIdle()
+{
+    Flush();
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+    {
+        if (queues_[i])
+            timelines_[i].Wait(lastValues_[i]);
+    }
+}
+
+unsigned SubmissionScheduler::BeginBatch(GpuQueueType type)
+{
+    if (batchCount_ == batches_.size())
+        batches_.emplace_back();
+
+    unsigned index = batchCount_++;
+    Batch& batch = batches_[index];
+    batch.queue_ = type;
+    batch.value_ = ++lastValues_[type];
+    for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+        batch.waits_[i] = 0;
+
+    openBatches_[type] = index;
+    return index;
+}
+
+bool SubmissionScheduler::NeedsWait(GpuQueueType type, GpuSubmission const& submission)
+{
+    // Queues execute in order, and a wait for a value covers every value before it
+    if (!submission.IsValid() || submission.queue_ == type || submission.value_ <= waitedValues_[type][submission.queue_])
+        return false;
+
+    // Only signaled values can be complete
+    return !IsComplete(submission);
+}
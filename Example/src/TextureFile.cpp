@@ -0,0 +1,227 @@
+#include "TextureFile.h"
+#include "ByteStream.h"
+
+#include <cstring>
+
+
+/// Block layout of a supported format.
+struct TextureFormatInfo
+{
+    /// Format, numerically a DXGI_FORMAT
+    unsigned format_;
+    /// Format of a KTX2 file, numerically a VkFormat
+    unsigned vkFormat_;
+    /// Block width and height in pixels, 1 for uncompressed formats
+    unsigned blockSize_;
+    /// Bytes per block
+    unsigned blockBytes_;
+};
+
+static const TextureFormatInfo textureFormats[] =
+{
+    { 28, 37, 1, 4 },   // R8G8B8A8_UNORM
+    { 29, 43, 1, 4 },   // R8G8B8A8_UNORM_SRGB
+    { 87, 44, 1, 4 },   // B8G8R8A8_UNORM
+    { 91, 50, 1, 4 },   // B8G8R8A8_UNORM_SRGB
+    { 71, 133, 4, 8 },  // BC1_UNORM
+    { 72, 134, 4, 8 },  // BC1_UNORM_SRGB
+    { 74, 135, 4, 16 }, // BC2_UNORM
+    { 75, 136, 4, 16 }, // BC2_UNORM_SRGB
+    { 77, 137, 4, 16 }, // BC3_UNORM
+    { 78, 138, 4, 16 }, // BC3_UNORM_SRGB
+    { 80, 139, 4, 8 },  // BC4_UNORM
+    { 81, 140, 4, 8 },  // BC4_SNORM
+    { 83, 141, 4, 16 }, // BC5_UNORM
+    { 84, 142, 4, 16 }, // BC5_SNORM
+    { 95, 143, 4, 16 }, // BC6H_UF16
+    { 96, 144, 4, 16 }, // BC6H_SF16
+    { 98, 145, 4, 16 }, // BC7_UNORM
+    { 99, 146, 4, 16 }, // BC7_UNORM_SRGB
+};
+
+static const uint8_t ktx2Identifier[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+static TextureFormatInfo const* FindFormat(unsigned format, bool vulkan)
+{
+    for (TextureFormatInfo const& info : textureFormats)
+    {
+        if ((vulkan ? info.vkFormat_ : info.format_) == format)
+            return &info;
+    }
+    return nullptr;
+}
+
+static uint32_t MakeFourCC(char a, char b, char c, char d)
+{
+    return (uint32_t) (uint8_t) a | ((uint32_t) (uint8_t) b << 8) | ((uint32_t) (uint8_t) c << 16) | ((uint32_t) (uint8_t) d << 24);
+}
+
+/// Largest width or height accepted, identical to D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION.
+static const unsigned MaxTextureDimension = 16384;
+
+/// Return number of mips of a full chain down to 1x1.
+static unsigned GetFullMipCount(unsigned width, unsigned height)
+{
+    unsigned count = 1;
+    for (unsigned size = width > height ? width : height; size > 1; size >>= 1)
+        ++count;
+    return count;
+}
+
+/// Fill the dimensions of mips, leaving their offsets. Return false if the size or mip count are out of range.
+static bool LayoutMips(TextureFileInfo& info, TextureFormatInfo const& format, unsigned width, unsigned height, unsigned mipCount)
+{
+    // Counts come from the file, so reject them before they size anything
+    if (!width || !height || width > MaxTextureDimension || height > MaxTextureDimension || mipCount > GetFullMipCount(width, height))
+        return false;
+
+    info.width_ = width;
+    info.height_ = height;
+    info.format_ = format.format_;
+    info.blockSize_ = format.blockSize_;
+    info.mips_.resize(mipCount);
+
+    for (unsigned i = 0; i < mipCount; ++i)
+    {
+        TextureMipInfo& mip = info.mips_[i];
+        mip.width_ = width >> i ? width >> i : 1;
+        mip.height_ = height >> i ? height >> i : 1;
+        mip.rowSize_ = (mip.width_ + format.blockSize_ - 1) / format.blockSize_ * format.blockBytes_;
+        mip.rowCount_ = (mip.height_ + format.blockSize_ - 1) / format.blockSize_;
+        mip.size_ = (uint64_t) mip.rowSize_ * mip.rowCount_;
+    }
+    return true;
+}
+
+static bool ParseDds(uint8_t const* data, uint64_t size, TextureFileInfo& info)
+{
+    static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    static const uint32_t DDPF_FOURCC = 0x4;
+    static const uint32_t DDPF_RGB = 0x40;
+    static const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    static const uint32_t DDSCAPS2_VOLUME = 0x200000;
+    static const uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+    ByteReader reader(data, (size_t) size);
+    uint32_t magic, headerSize, flags, height, width, pitch, depth, mipCount, reserved;
+    if (!reader.ReadU32(magic) || magic != MakeFourCC('D', 'D', 'S', ' ') || !reader.ReadU32(headerSize) || headerSize != 124)
+        return false;
+    if (!reader.ReadU32(flags) || !reader.ReadU32(height) || !reader.ReadU32(width) || !reader.ReadU32(pitch) ||
+        !reader.ReadU32(depth) || !reader.ReadU32(mipCount))
+        return false;
+    for (unsigned i = 0; i < 11; ++i)
+    {
+        if (!reader.ReadU32(reserved))
+            return false;
+    }
+
+    uint32_t pixelFormatSize, pixelFlags, fourCC, bitCount, redMask, greenMask, blueMask, alphaMask, caps, caps2;
+    if (!reader.ReadU32(pixelFormatSize) || !reader.ReadU32(pixelFlags) || !reader.ReadU32(fourCC) || !reader.ReadU32(bitCount) ||
+        !reader.ReadU32(redMask) || !reader.ReadU32(greenMask) || !reader.ReadU32(blueMask) || !reader.ReadU32(alphaMask) ||
+        !reader.ReadU32(caps) || !reader.ReadU32(caps2) || (caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)))
+        return false;
+
+    uint64_t dataOffset = 4 + 124;
+    unsigned format = 0;
+    if ((pixelFlags & DDPF_FOURCC) && fourCC == MakeFourCC('D', 'X', '1', '0'))
+    {
+        uint32_t dxgiFormat, dimension, miscFlag, arraySize;
+        if (!reader.ReadU32(dxgiFormat) || !reader.ReadU32(dimension) || !reader.ReadU32(miscFlag) || !reader.ReadU32(arraySize) ||
+            dimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D || arraySize != 1 || (miscFlag & 0x4))
+            return false;
+        format = dxgiFormat;
+        dataOffset += 20;
+    }
+    else if (pixelFlags & DDPF_FOURCC)
+    {
+        if (fourCC == MakeFourCC('D', 'X', 'T', '1'))
+            format = 71;
+        else if (fourCC == MakeFourCC('D', 'X', 'T', '3'))
+            format = 74;
+        else if (fourCC == MakeFourCC('D', 'X', 'T', '5'))
+            format = 77;
+        else if (fourCC == MakeFourCC('A', 'T', 'I', '1') || fourCC == MakeFourCC('B', 'C', '4', 'U'))
+            format = 80;
+        else if (fourCC == MakeFourCC('A', 'T', 'I', '2') || fourCC == MakeFourCC('B', 'C', '5', 'U'))
+            format = 83;
+    }
+    else if ((pixelFlags & DDPF_RGB) && bitCount == 32)
+    {
+        if (redMask == 0xff && greenMask == 0xff00 && blueMask == 0xff0000)
+            format = 28;
+        else if (redMask == 0xff0000 && greenMask == 0xff00 && blueMask == 0xff)
+            format = 87;
+    }
+
+    TextureFormatInfo const* formatInfo = FindFormat(format, false);
+    if (!formatInfo || !LayoutMips(info, *formatInfo, width, height, (flags & DDSD_MIPMAPCOUNT) && mipCount ? mipCount : 1))
+        return false;
+
+    // Mips follow the header from the largest down
+    for (TextureMipInfo& mip : info.mips_)
+    {
+        mip.offset_ = dataOffset;
+        dataOffset += mip.size_;
+    }
+    return dataOffset <= size;
+}
+
+static bool ParseKtx2(uint8_t const* data, uint64_t size, TextureFileInfo& info)
+{
+    if (size < sizeof ktx2Identifier || memcmp(data, ktx2Identifier, sizeof ktx2Identifier) != 0)
+        return false;
+
+    ByteReader reader(data + sizeof ktx2Identifier, (size_t) (size - sizeof ktx2Identifier));
+    uint32_t vkFormat, typeSize, width, height, depth, layerCount, faceCount, levelCount, supercompression;
+    if (!reader.ReadU32(vkFormat) || !reader.ReadU32(typeSize) || !reader.ReadU32(width) || !reader.ReadU32(height) ||
+        !reader.ReadU32(depth) || !reader.ReadU32(layerCount) || !reader.ReadU32(faceCount) || !reader.ReadU32(levelCount) ||
+        !reader.ReadU32(supercompression) || supercompression || depth || layerCount > 1 || faceCount != 1)
+        return false;
+
+    // Data format descriptor, key/value data and supercompression global data are not needed
+    uint32_t dfdOffset, dfdLength, kvdOffset, kvdLength;
+    uint64_t sgdOffset, sgdLength;
+    if (!reader.ReadU32(dfdOffset) || !reader.ReadU32(dfdLength) || !reader.ReadU32(kvdOffset) || !reader.ReadU32(kvdLength) ||
+        !reader.ReadU64(sgdOffset) || !reader.ReadU64(sgdLength))
+        return false;
+
+    TextureFormatInfo const* formatInfo = FindFormat(vkFormat, true);
+    if (!formatInfo || !LayoutMips(info, *formatInfo, width, height, levelCount ? levelCount : 1))
+        return false;
+
+    for (TextureMipInfo& mip : info.mips_)
+    {
+        uint64_t byteLength, uncompressedLength;
+        if (!reader.ReadU64(mip.offset_) || !reader.ReadU64(byteLength) || !reader.ReadU64(uncompressedLength) ||
+            byteLength != mip.size_ || mip.offset_ > size || size - mip.offset_ < mip.size_)
+            return false;
+    }
+    return true;
+}
+
+uint64_t TextureFileInfo::GetMipChainSize(unsigned firstMip) const
+{
+    uint64_t size = 0;
+    for (unsigned i = firstMip; i < mips_.size(); ++i)
+        size += mips_[i].size_;
+    return size;
+}
+
+bool ParseTextureFile(uint8_t const* data, uint64_t size, TextureFileInfo& info)
+{
+    info = TextureFileInfo();
+    if (ParseDds(data, size, info) || ParseKtx2(data, size, info))
+        return true;
+
+    info = TextureFileInfo();
+    return false;
+}
+
+void CopyTextureMip(uint8_t const* fileData, TextureMipInfo const& mip, uint8_t* dest)
+{
+    uint8_t const* source = fileData + mip.offset_;
+    uint64_t pitch = mip.GetUploadRowPitch();
+
+    for (unsigned i = 0; i < mip.rowCount_; ++i)
+        memcpy(dest + i * pitch, source + (uint64_t) i * mip.rowSize_, mip.rowSize_);
+}
@@ -0,0 +1,405 @@
+#include "TextureStreamer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+/// Return size of the staging memory of mips [firstMip, endMip), each at an aligned offset.
+static uint64_t GetStagingSize(TextureFileInfo const& info, unsigned firstMip, unsigned endMip)
+{
+    uint64_t size = 0;
+    for (unsigned i = firstMip; i < endMip; ++i)
+        size += (info.mips_[i].GetUploadSize() + TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+    return size;
+}
+
+TextureStreamer::TextureStreamer() = default;
+
+TextureStreamer::~TextureStreamer()
+{
+    Shutdown();
+}
+
+bool TextureStreamer::Initialize(TextureUploadSink& sink, UploadBufferFactory& factory, uint64_t stagingSize)
+{
+    sink_ = &sink;
+    return staging_.Initialize(factory, stagingSize);
+}
+
+void TextureStreamer::Shutdown()
+{
+    if (!sink_)
+        return;
+
+    // Decode jobs write the staging ring
+    if (jobSystem_)
+        jobSystem_->Wait(decodeCounter_);
+
+    for (std::unique_ptr<Texture>& texture : textures_)
+    {
+        if (!texture)
+            continue;
+        if (texture->load_ && texture->load_->texture_)
+            sink_->ReleaseTexture(texture->load_->texture_);
+        if (texture->texture_)
+            sink_->ReleaseTexture(texture->texture_);
+    }
+
+    textures_.clear();
+    freeIds_.clear();
+    staging_.Shutdown();
+    committedSize_ = 0;
+    idle_ = true;
+    sink_ = nullptr;
+}
+
+unsigned TextureStreamer::AddTexture(std::string const& fileName, float priority)
+{
+    assert(sink_);
+
+    std::unique_ptr<Texture> texture(new Texture());
+    if (!texture->file_.Open(fileName) || !ParseTextureFile(texture->file_.GetData(), texture->file_.GetSize(), texture->info_))
+        return ~0u;
+
+    // The tail is the smallest mips that fit in its size together, at least the smallest mip
+    TextureFileInfo const& info = texture->info_;
+    texture->firstMip_ = info.GetMipCount();
+    texture->tailMip_ = info.GetMipCount() - 1;
+    while (texture->tailMip_ && info.GetMipChainSize(texture->tailMip_ - 1) <= MipTailSize)
+        --texture->tailMip_;
+    texture->priority_ = std::max(priority, 1e-6f);
+
+    unsigned id;
+    if (!freeIds_.empty())
+    {
+        id = freeIds_.back();
+        freeIds_.pop_back();
+        textures_[id] = std::move(texture);
+    }
+    else
+    {
+        id = (unsigned) textures_.size();
+        textures_.push_back(std::move(texture));
+    }
+
+    idle_ = false;
+    return id;
+}
+
+void TextureStreamer::RemoveTexture(unsigned id)
+{
+    assert(id < textures_.size() && textures_[id] && !textures_[id]->removed_);
+
+    Texture& texture = *textures_[id];
+    texture.removed_ = true;
+    if (!texture.load_)
+        Release(id);
+}
+
+void TextureStreamer::SetPriority(unsigned id, float priority)
+{
+    assert(id < textures_.size() && textures_[id]);
+    textures_[id]->priority_ = std::max(priority, 1e-6f);
+}
+
+void TextureStreamer::SetWantedMip(unsigned id, unsigned mip)
+{
+    assert(id < textures_.size() && textures_[id]);
+
+    Texture& texture = *textures_[id];
+    texture.wantedMip_ = std::min(mip, texture.info_.GetMipCount() - 1);
+    idle_ = false;
+}
+
+ResourceHandle TextureStreamer::GetTexture(unsigned id) const
+{
+    assert(id < textures_.size() && textures_[id]);
+    return textures_[id]->texture_;
+}
+
+unsigned TextureStreamer::GetFirstMip(unsigned id) const
+{
+    assert(id < textures_.size() && textures_[id]);
+    return textures_[id]->firstMip_;
+}
+
+TextureFileInfo const& TextureStreamer::GetFileInfo(unsigned id) const
+{
+    assert(id < textures_.size() && textures_[id]);
+    return textures_[id]->info_;
+}
+
+void TextureStreamer::Update()
+{
+    assert(sink_);
+
+    PROFILE_SCOPE("TextureStreaming");
+
+    // Replace textures whose copies have completed
+    uint64_t completedValue = sink_->GetCompletedValue();
+    bool inFlight = false;
+    for (unsigned id = 0; id < textures_.size(); ++id)
+    {
+        Texture* texture = textures_[id].get();
+        if (!texture || !texture->load_)
+            continue;
+
+        Load& load = *texture->load_;
+        if (!load.fenceValue_ || load.fenceValue_ > completedValue)
+        {
+            inFlight = true;
+            continue;
+        }
+
+        if (texture->texture_)
+            sink_->ReleaseTexture(texture->texture_);
+        texture->texture_ = load.texture_;
+        texture->firstMip_ = load.firstMip_;
+        if (load.endMip_ > load.firstMip_)
+        {
+            ++stats_.loads_;
+            stats_.mipsLoaded_ += load.endMip_ - load.firstMip_;
+        }
+        texture->load_.reset();
+
+        if (texture->removed_)
+            Release(id);
+    }
+    staging_.Reclaim(completedValue);
+
+    // Record the uploads of decoded loads
+    for (unsigned id = 0; id < textures_.size(); ++id)
+    {
+        Texture* texture = textures_[id].get();
+        if (!texture || !texture->load_ || texture->load_->fenceValue_ || !texture->load_->decoded_.load(std::memory_order_acquire))
+            continue;
+
+        if (texture->removed_ || !RecordLoad(*texture))
+        {
+            Load& load = *texture->load_;
+            committedSize_ -= texture->info_.GetMipChainSize(load.firstMip_) - texture->info_.GetMipChainSize(texture->firstMip_);
+            dropped_.push_back(load.staging_);
+            texture->load_.reset();
+
+            if (texture->removed_)
+                Release(id);
+        }
+    }
+
+    // Evict the mips no longer wanted, collect the textures wanting more
+    candidates_.clear();
+    for (unsigned id = 0; id < textures_.size(); ++id)
+    {
+        Texture* texture = textures_[id].get();
+        if (!texture || texture->removed_ || texture->load_)
+            continue;
+
+        unsigned keepMip = std::min(texture->wantedMip_, texture->tailMip_);
+        if (texture->texture_ && texture->firstMip_ < keepMip)
+            Evict(*texture, keepMip);
+        else if (!texture->texture_ || texture->firstMip_ > texture->wantedMip_)
+            candidates_.push_back(id);
+    }
+
+    // Textures with nothing resident first, then the cheapest loads for their priority
+    auto loadCost = [this](unsigned id)
+    {
+        Texture const& texture = *textures_[id];
+        return (float) texture.info_.mips_[texture.firstMip_ - 1].size_ / texture.priority_;
+    };
+    std::sort(candidates_.begin(), candidates_.end(), [&](unsigned lhs, unsigned rhs)
+    {
+        bool lhsEmpty = !textures_[lhs]->texture_;
+        bool rhsEmpty = !textures_[rhs]->texture_;
+        if (lhsEmpty != rhsEmpty)
+            return lhsEmpty;
+        return loadCost(lhs) < loadCost(rhs);
+    });
+
+    // Start loads within the upload limit and the budget
+    uint64_t startedSize = 0;
+    for (unsigned id : candidates_)
+    {
+        Texture& texture = *textures_[id];
+        if (texture.load_)
+            continue;
+
+        unsigned firstMip = texture.texture_ ? texture.firstMip_ - 1 : texture.tailMip_;
+        unsigned endMip = texture.texture_ ? texture.firstMip_ : texture.info_.GetMipCount();
+        uint64_t size = texture.info_.GetMipChainSize(firstMip) - texture.info_.GetMipChainSize(texture.firstMip_);
+        if (startedSize && startedSize + size > uploadLimit_)
+            break;
+
+        if (committedSize_ + size > budget_ && !EvictFor(size, texture.priority_))
+        {
+            ++stats_.overBudget_;
+            continue;
+        }
+
+        // Later loads need staging memory as well
+        if (!StartLoad(texture, firstMip, endMip))
+        {
+            ++stats_.stagingFull_;
+            inFlight = true;
+            break;
+        }
+
+        startedSize += size;
+        inFlight = true;
+    }
+
+    if (!recorded_.empty() || !dropped_.empty())
+    {
+        uint64_t fenceValue = sink_->Submit();
+        for (Load* load : recorded_)
+        {
+            load->fenceValue_ = fenceValue;
+            if (load->staging_.IsValid())
+                staging_.Retire(load->staging_, fenceValue);
+        }
+        for (UploadAllocation const& staging : dropped_)
+            staging_.Retire(staging, fenceValue);
+
+        recorded_.clear();
+        dropped_.clear();
+        inFlight = true;
+    }
+
+    PROFILE_COUNTER("TextureStreamingCommitted", committedSize_);
+    idle_ = !inFlight;
+}
+
+bool TextureStreamer::StartLoad(Texture& texture, unsigned firstMip, unsigned endMip)
+{
+    TextureFileInfo const& info = texture.info_;
+    UploadAllocation staging = staging_.Allocate(GetStagingSize(info, firstMip, endMip), TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    if (!staging.IsValid())
+        return false;
+
+    texture.load_.reset(new Load());
+    Load* load = texture.load_.get();
+    load->firstMip_ = firstMip;
+    load->endMip_ = endMip;
+    load->staging_ = staging;
+    committedSize_ += info.GetMipChainSize(firstMip) - info.GetMipChainSize(texture.firstMip_);
+
+    for (unsigned i = firstMip; i < endMip; ++i)
+        stats_.bytesRead_ += info.mips_[i].size_;
+    stats_.bytesUploaded_ += staging.size_;
+
+    // The texture, its file and the load outlive the job: removal waits until the load is decoded
+    uint8_t const* fileData = texture.file_.GetData();
+    auto decode = [load, &info, fileData]()
+    {
+        uint8_t* dest = load->staging_.cpu_;
+        for (unsigned i = load->firstMip_; i < load->endMip_; ++i)
+        {
+            CopyTextureMip(fileData, info.mips_[i], dest);
+            dest += GetStagingSize(info, i, i + 1);
+        }
+        load->decoded_.store(true, std::memory_order_release);
+    };
+
+    if (jobSystem_)
+        jobSystem_->Run(decode, &decodeCounter_);
+    else
+        decode();
+
+    return true;
+}
+
+bool TextureStreamer::RecordLoad(Texture& texture)
+{
+    Load& load = *texture.load_;
+    TextureFileInfo const& info = texture.info_;
+
+    load.texture_ = sink_->CreateTexture(info, load.firstMip_, texture.texture_, texture.firstMip_);
+    if (!load.texture_)
+        return false;
+
+    uint64_t offset = 0;
+    for (unsigned i = load.firstMip_; i < load.endMip_; ++i)
+    {
+        UploadAllocation mipStaging = load.staging_;
+        mipStaging.cpu_ += offset;
+        mipStaging.gpu_ += offset;
+        mipStaging.offset_ += offset;
+        mipStaging.size_ = info.mips_[i].GetUploadSize();
+        sink_->UploadMip(load.texture_, info, load.firstMip_, i, mipStaging);
+
+        offset += GetStagingSize(info, i, i + 1);
+    }
+
+    recorded_.push_back(&load);
+    return true;
+}
+
+bool TextureStreamer::Evict(Texture& texture, unsigned firstMip)
+{
+    assert(!texture.load_ && texture.texture_ && firstMip > texture.firstMip_);
+
+    ResourceHandle evicted = sink_->CreateTexture(texture.info_, firstMip, texture.texture_, texture.firstMip_);
+    if (!evicted)
+        return false;
+
+    texture.load_.reset(new Load());
+    Load& load = *texture.load_;
+    load.firstMip_ = load.endMip_ = firstMip;
+    load.texture_ = evicted;
+    load.decoded_ = true;
+    recorded_.push_back(&load);
+
+    committedSize_ -= texture.info_.GetMipChainSize(texture.firstMip_) - texture.info_.GetMipChainSize(firstMip);
+    stats_.mipsEvicted_ += firstMip - texture.firstMip_;
+    return true;
+}
+
+bool TextureStreamer::EvictFor(uint64_t bytes, float priority)
+{
+    // Textures of lower priority with mips above their tail and no load in flight
+    std::vector<Texture*> victims;
+    uint64_t evictable = 0;
+    for (std::unique_ptr<Texture>& texture : textures_)
+    {
+        if (texture && !texture->removed_ && !texture->load_ && texture->texture_ && texture->priority_ < priority &&
+            texture->firstMip_ < texture->tailMip_)
+        {
+            victims.push_back(texture.get());
+            evictable += texture->info_.GetMipChainSize(texture->firstMip_) - texture->info_.GetMipChainSize(texture->tailMip_);
+        }
+    }
+
+    uint64_t excess = committedSize_ + bytes - budget_;
+    if (evictable < excess)
+        return false;
+
+    // Lowest priority first, the largest mips of each
+    std::sort(victims.begin(), victims.end(), [](Texture* lhs, Texture* rhs) { return lhs->priority_ < rhs->priority_; });
+    for (Texture* texture : victims)
+    {
+        if (committedSize_ + bytes <= budget_)
+            break;
+
+        unsigned firstMip = texture->firstMip_;
+        uint64_t freed = 0;
+        while (firstMip < texture->tailMip_ && committedSize_ + bytes - freed > budget_)
+            freed += texture->info_.mips_[firstMip++].size_;
+        Evict(*texture, firstMip);
+    }
+
+    return committedSize_ + bytes <= budget_;
+}
+
+void TextureStreamer::Release(unsigned id)
+{
+    Texture& texture = *textures_[id];
+    assert(texture.removed_ && !texture.load_);
+
+    if (texture.texture_)
+        sink_->ReleaseTexture(texture.texture_);
+    committedSize_ -= texture.info_.GetMipChainSize(texture.firstMip_);
+
+    textures_[id].reset();
+    freeIds_.push_back(id);
+}
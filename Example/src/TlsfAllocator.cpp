@@ -0,0 +1,319 @@
+
+#include "TlsfAllocator.h"
+
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+static unsigned HighestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (unsigned) index;
+#else
+    return 63 - (unsigned) __builtin_clzll(value);
+#endif
+}
+
+static unsigned LowestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (unsigned) index;
+#else
+    return (unsigned) __builtin_ctzll(value);
+#endif
+}
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+TlsfAllocator::TlsfAllocator(uint64_t size)
+    : size_(size & ~(MinBlockSize - 1))
+{
+    for (unsigned i = 0; i < FirstLevelCount; ++i)
+    {
+        for (unsigned j = 0; j < SecondLevelCount; ++j)
+            freeLists_[i][j] = InvalidBlock;
+    }
+
+    if (!size_)
+        return;
+
+    unsigned index = NewBlock();
+    Block& block = blocks_[index];
+    block.offset_ = 0;
+    block.size_ = size_;
+    InsertFreeBlock(index);
+}
+
+TlsfAllocation TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    TlsfAllocation allocation;
+    if (!size || size > size_)
+        return allocation;
+
+    size = AlignUp(size, MinBlockSize);
+    if (alignment < MinBlockSize)
+        alignment = MinBlockSize;
+
+    // Offsets are multiples of the minimum block size, so aligning one wastes at most this much
+    uint64_t searchSize = size + alignment - MinBlockSize;
+
+    // Round up to the next size class so that every block found is large enough without walking the list
+    unsigned firstLevel, secondLevel;
+    uint64_t roundedSize = searchSize + (1ull << (HighestBit(searchSize) - SecondLevelBits)) - 1;
+    Mapping(roundedSize, firstLevel, secondLevel);
+
+    unsigned index = FindFreeBlock(firstLevel, secondLevel);
+    if (index == InvalidBlock)
+    {
+        // The rounding skips smaller blocks that may still fit, e.g. the whole range when it is empty. Only
+        // reached when nearly full, so checking them one by one does not affect the common case
+        index = FindFittingBlock(size, alignment);
+        if (index == InvalidBlock)
+            return allocation;
+    }
+
+    RemoveFreeBlock(index);
+
+    // Give the alignment padding back as a free block of its own
+    uint64_t padding = AlignUp(blocks_[index].offset_, alignment) - blocks_[index].offset_;
+    if (padding)
+    {
+        unsigned aligned = SplitBlock(index, padding);
+        InsertFreeBlock(index);
+        index = aligned;
+    }
+
+    if (blocks_[index].size_ - size >= MinBlockSize)
+        InsertFreeBlock(SplitBlock(index, size));
+
+    Block& block = blocks_[index];
+    block.free_ = false;
+
+    allocation.offset_ = block.offset_;
+    allocation.size_ = block.size_;
+    allocation.block_ = index;
+
+    allocatedSize_ += block.size_;
+    ++allocationCount_;
+    return allocation;
+}
+
+void TlsfAllocator::Free(TlsfAllocation& allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    unsigned index = allocation.block_;
+    assert(index < blocks_.size() && !blocks_[index].free_);
+
+    allocatedSize_ -= blocks_[index].size_;
+    --allocationCount_;
+
+    unsigned next = blocks_[index].nextPhysical_;
+    if (next != InvalidBlock && blocks_[next].free_)
+    {
+        RemoveFreeBlock(next);
+        MergeBlock(index, next);
+    }
+
+    unsigned previous = blocks_[index].prevPhysical_;
+    if (previous != InvalidBlock && blocks_[previous].free_)
+    {
+        RemoveFreeBlock(previous);
+        MergeBlock(previous, index);
+        index = previous;
+    }
+
+    InsertFreeBlock(index);
+    allocation = TlsfAllocation();
+}
+
+uint64_t TlsfAllocator::GetLargestFreeRegion() const
+{
+    if (!firstLevelBitmap_)
+        return 0;
+
+    // The largest block is in the highest non-empty class
+    unsigned firstLevel = HighestBit(firstLevelBitmap_);
+    unsigned secondLevel = HighestBit(secondLevelBitmaps_[firstLevel]);
+
+    uint64_t largest = 0;
+    for (unsigned index = freeLists_[firstLevel][secondLevel]; index != InvalidBlock; index = blocks_[index].nextFree_)
+    {
+        if (blocks_[index].size_ > largest)
+            largest = blocks_[index].size_;
+    }
+
+    return largest;
+}
+
+float TlsfAllocator::GetFragmentation() const
+{
+    uint64_t freeSize = GetFreeSize();
+    return freeSize ? 1.0f - (float) GetLargestFreeRegion() / (float) freeSize : 0.0f;
+}
+
+void TlsfAllocator::Mapping(uint64_t size, unsigned& firstLevel, unsigned& secondLevel)
+{
+    firstLevel = HighestBit(size);
+    secondLevel = (unsigned) (size >> (firstLevel - SecondLevelBits)) & (SecondLevelCount - 1);
+}
+
+unsigned TlsfAllocator::FindFreeBlock(unsigned firstLevel, unsigned secondLevel) const
+{
+    uint32_t secondLevelMap = secondLevelBitmaps_[firstLevel] & (~0u << secondLevel);
+    if (!secondLevelMap)
+    {
+        uint64_t firstLevelMap = firstLevel + 1 < FirstLevelCount ? firstLevelBitmap_ & (~0ull << (firstLevel + 1)) : 0;
+        if (!firstLevelMap)
+            return InvalidBlock;
+
+        firstLevel = LowestBit(firstLevelMap);
+        secondLevelMap = secondLevelBitmaps_[firstLevel];
+    }
+
+    return freeLists_[firstLevel][LowestBit(secondLevelMap)];
+}
+
+unsigned TlsfAllocator::FindFittingBlock(uint64_t size, uint64_t alignment) const
+{
+    unsigned firstLevel, secondLevel;
+    Mapping(size, firstLevel, secondLevel);
+
+    for (;;)
+    {
+        uint32_t secondLevelMap = secondLevelBitmaps_[firstLevel] & (~0u << secondLevel);
+        if (!secondLevelMap)
+        {
+            uint64_t firstLevelMap = firstLevel + 1 < FirstLevelCount ? firstLevelBitmap_ & (~0ull << (firstLevel + 1)) : 0;
+            if (!firstLevelMap)
+                return InvalidBlock;
+
+            firstLevel = LowestBit(firstLevelMap);
+            secondLevelMap = secondLevelBitmaps_[firstLevel];
+        }
+        secondLevel = LowestBit(secondLevelMap);
+
+        for (unsigned index = freeLists_[firstLevel][secondLevel]; index != InvalidBlock; index = blocks_[index].nextFree_)
+        {
+            Block const& block = blocks_[index];
+            if (AlignUp(block.offset_, alignment) + size <= block.offset_ + block.size_)
+                return index;
+        }
+
+        if (++secondLevel == SecondLevelCount)
+        {
+            secondLevel = 0;
+            if (++firstLevel == FirstLevelCount)
+                return InvalidBlock;
+        }
+    }
+}
+
+void TlsfAllocator::InsertFreeBlock(unsigned index)
+{
+    unsigned firstLevel, secondLevel;
+    Mapping(blocks_[index].size_, firstLevel, secondLevel);
+
+    Block& block = blocks_[index];
+    unsigned& head = freeLists_[firstLevel][secondLevel];
+
+    block.free_ = true;
+    block.prevFree_ = InvalidBlock;
+    block.nextFree_ = head;
+    if (head != InvalidBlock)
+        blocks_[head].prevFree_ = index;
+    head = index;
+
+    firstLevelBitmap_ |= 1ull << firstLevel;
+    secondLevelBitmaps_[firstLevel] |= 1u << secondLevel;
+    ++freeRegionCount_;
+}
+
+void TlsfAllocator::RemoveFreeBlock(unsigned index)
+{
+    unsigned firstLevel, secondLevel;
+    Mapping(blocks_[index].size_, firstLevel, secondLevel);
+
+    Block& block = blocks_[index];
+    if (block.prevFree_ != InvalidBlock)
+        blocks_[block.prevFree_].nextFree_ = block.nextFree_;
+    else
+        freeLists_[firstLevel][secondLevel] = block.nextFree_;
+    if (block.nextFree_ != InvalidBlock)
+        blocks_[block.nextFree_].prevFree_ = block.prevFree_;
+
+    if (freeLists_[firstLevel][secondLevel] == InvalidBlock)
+    {
+        secondLevelBitmaps_[firstLevel] &= ~(1u << secondLevel);
+        if (!secondLevelBitmaps_[firstLevel])
+            firstLevelBitmap_ &= ~(1ull << firstLevel);
+    }
+
+    block.free_ = false;
+    --freeRegionCount_;
+}
+
+unsigned TlsfAllocator::SplitBlock(unsigned index, uint64_t size)
+{
+    unsigned remainder = NewBlock();
+    Block& block = blocks_[index];
+    Block& rest = blocks_[remainder];
+
+    rest.offset_ = block.offset_ + size;
+    rest.size_ = block.size_ - size;
+    rest.prevPhysical_ = index;
+    rest.nextPhysical_ = block.nextPhysical_;
+    if (rest.nextPhysical_ != InvalidBlock)
+        blocks_[rest.nextPhysical_].prevPhysical_ = remainder;
+
+    block.size_ = size;
+    block.nextPhysical_ = remainder;
+    return remainder;
+}
+
+void TlsfAllocator::MergeBlock(unsigned previous, unsigned index)
+{
+    Block& block = blocks_[index];
+    Block& merged = blocks_[previous];
+
+    merged.size_ += block.size_;
+    merged.nextPhysical_ = block.nextPhysical_;
+    if (merged.nextPhysical_ != InvalidBlock)
+        blocks_[merged.nextPhysical_].prevPhysical_ = previous;
+
+    unusedBlocks_.push_back(index);
+}
+
+unsigned TlsfAllocator::NewBlock()
+{
+    unsigned index;
+    if (!unusedBlocks_.empty())
+    {
+        index = unusedBlocks_.back();
+        unusedBlocks_.pop_back();
+    }
+    else
+    {
+        index = (unsigned) blocks_.size();
+        blocks_.emplace_back();
+    }
+
+    Block& block = blocks_[index];
+    block.prevPhysical_ = block.nextPhysical_ = InvalidBlock;
+    block.prevFree_ = block.nextFree_ = InvalidBlock;
+    block.free_ = false;
+    return index;
+}
@@ -0,0 +1,322 @@
+#include "TransformBatch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+
+/// Load the elements of transforms at an index.
+template <class F> inline void LoadTransforms(float const* const* streams, unsigned index, F* m)
+{
+    m[0] = F::Load(streams[0] + index);
+    m[1] = F::Load(streams[1] + index);
+    m[2] = F::Load(streams[2] + index);
+    m[3] = F::Load(streams[3] + index);
+    m[4] = F::Load(streams[4] + index);
+    m[5] = F::Load(streams[5] + index);
+    m[6] = F::Load(streams[6] + index);
+    m[7] = F::Load(streams[7] + index);
+    m[8] = F::Load(streams[8] + index);
+    m[9] = F::Load(streams[9] + index);
+    m[10] = F::Load(streams[10] + index);
+    m[11] = F::Load(streams[11] + index);
+}
+
+/// Return a row of three lanes transformed by the linear part of an affine transform.
+template <class F> inline F TransformRow(F x, F y, F z, F const* b, unsigned col)
+{
+    return MulAdd(z, b[6 + col], MulAdd(y, b[3 + col], x * b[col]));
+}
+
+/// Multiply a row of affine transforms loaded from streams by the transforms in b and store it at an index.
+template <class F> inline void MultiplyRow(float const* const* a, F const* b, float* const* r, unsigned index, unsigned row)
+{
+    F x = F::Load(a[row * 3] + index);
+    F y = F::Load(a[row * 3 + 1] + index);
+    F z = F::Load(a[row * 3 + 2] + index);
+    // The implicit w of 1 in the translation row picks up the translation of b
+    if (row == 3)
+    {
+        Store(r[9] + index, TransformRow(x, y, z, b, 0) + b[9]);
+        Store(r[10] + index, TransformRow(x, y, z, b, 1) + b[10]);
+        Store(r[11] + index, TransformRow(x, y, z, b, 2) + b[11]);
+    }
+    else
+    {
+        Store(r[row * 3] + index, TransformRow(x, y, z, b, 0));
+        Store(r[row * 3 + 1] + index, TransformRow(x, y, z, b, 1));
+        Store(r[row * 3 + 2] + index, TransformRow(x, y, z, b, 2));
+    }
+}
+
+/// Multiply affine transforms loaded from streams by the transforms in b and store the product at an index.
+/// Each row is loaded before it is stored, so r may be a.
+template <class F> inline void MultiplyLanes(float const* const* a, F const* b, float* const* r, unsigned index)
+{
+    MultiplyRow(a, b, r, index, 0);
+    MultiplyRow(a, b, r, index, 1);
+    MultiplyRow(a, b, r, index, 2);
+    MultiplyRow(a, b, r, index, 3);
+}
+
+FloatStreams::FloatStreams(unsigned streamCount)
+    : streamCount_(streamCount)
+{
+}
+
+void FloatStreams::Resize(unsigned size)
+{
+    if (size > capacity_)
+    {
+        // Round up to whole AVX registers so that streams start at the same alignment. Large streams are
+        // also offset by a cache line from a multiple of 4 KB, otherwise the same element of every stream
+        // falls into the same cache set and loads falsely depend on stores to other streams
+        unsigned capacity = std::max(size, capacity_ * 2);
+        capacity = capacity >= 1024 ? ((capacity + 1023) & ~1023u) + 16 : (capacity + 7) & ~7u;
+
+        std::vector<float> data((size_t) streamCount_ * capacity + 7);
+        float* streams = data.data() + ((0u - (unsigned) (uintptr_t) data.data()) & 31u) / sizeof(float);
+        for (unsigned i = 0; i < streamCount_ && size_; ++i)
+            memcpy(streams + (size_t) i * capacity, GetStream(i), size_ * sizeof(float));
+        data_.swap(data);
+        streams_ = streams;
+        capacity_ = capacity;
+    }
+    size_ = size;
+}
+
+void TransformArray::Set(unsigned index, Matrix4 const& transform)
+{
+    assert(index < GetSize());
+    for (unsigned row = 0; row < 4; ++row)
+    {
+        float const* src = &transform.rows_[row].x_;
+        for (unsigned col = 0; col < 3; ++col)
+            GetStream(row * 3 + col)[index] = src[col];
+    }
+}
+
+Matrix4 TransformArray::Get(unsigned index) const
+{
+    assert(index < GetSize());
+    Matrix4 ret;
+    for (unsigned row = 0; row < 4; ++row)
+    {
+        float* dest = &ret.rows_[row].x_;
+        for (unsigned col = 0; col < 3; ++col)
+            dest[col] = GetStream(row * 3 + col)[index];
+    }
+    return ret;
+}
+
+void BoundsArray::Set(unsigned index, BoundingBox const& box)
+{
+    assert(index < GetSize());
+    GetStream(0)[index] = box.center_.x_;
+    GetStream(1)[index] = box.center_.y_;
+    GetStream(2)[index] = box.center_.z_;
+    GetStream(3)[index] = box.extents_.x_;
+    GetStream(4)[index] = box.extents_.y_;
+    GetStream(5)[index] = box.extents_.z_;
+}
+
+BoundingBox BoundsArray::Get(unsigned index) const
+{
+    assert(index < GetSize());
+    return { Vector3(GetStream(0)[index], GetStream(1)[index], GetStream(2)[index]),
+        Vector3(GetStream(3)[index], GetStream(4)[index], GetStream(5)[index]) };
+}
+
+void SphereArray::Set(unsigned index, BoundingSphere const& sphere)
+{
+    assert(index < GetSize());
+    GetStream(0)[index] = sphere.center_.x_;
+    GetStream(1)[index] = sphere.center_.y_;
+    GetStream(2)[index] = sphere.center_.z_;
+    GetStream(3)[index] = sphere.radius_;
+}
+
+BoundingSphere SphereArray::Get(unsigned index) const
+{
+    assert(index < GetSize());
+    return { Vector3(GetStream(0)[index], GetStream(1)[index], GetStream(2)[index]), GetStream(3)[index] };
+}
+
+void MultiplyTransforms(TransformArray const& lhs, TransformArray const& rhs, TransformArray& dest, unsigned first, unsigned count)
+{
+    assert(first + count <= lhs.GetSize() && first + count <= rhs.GetSize() && first + count <= dest.GetSize());
+
+    float const* a[TransformArray::ElementCount];
+    float const* b[TransformArray::ElementCount];
+    float* r[TransformArray::ElementCount];
+    lhs.GetStreams(a);
+    rhs.GetStreams(b);
+    dest.GetStreams(r);
+
+    ForEachLanes(first, count, [&](unsigned i, auto lane)
+    {
+        typedef decltype(lane) F;
+        F mb[TransformArray::ElementCount];
+        LoadTransforms(b, i, mb);
+        MultiplyLanes(a, mb, r, i);
+    });
+}
+
+void MultiplyTransforms(Matrix4 const* lhs, Matrix4 const* rhs, Matrix4* dest, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        dest[i] = lhs[i] * rhs[i];
+}
+
+void SortTransformHierarchy(int const* parents, unsigned count, std::vector<unsigned>& order, std::vector<int>& sortedParents,
+    std::vector<unsigned>& levelOffsets)
+{
+    // Depth of each node, walking up until a node of known depth
+    std::vector<unsigned> depths(count, ~0u);
+    unsigned maxDepth = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned depth = 0;
+        int node = (int) i;
+        while (node >= 0 && depths[node] == ~0u)
+        {
+            node = parents[node];
+            ++depth;
+        }
+        if (node >= 0)
+            depth += depths[node] + 1;
+
+        // Fill in the chain walked, from i down
+        node = (int) i;
+        while (node >= 0 && depths[node] == ~0u)
+        {
+            depths[node] = --depth;
+            node = parents[node];
+        }
+        maxDepth = std::max(maxDepth, depths[i]);
+    }
+
+    // Counting sort by depth keeps siblings in their original order
+    levelOffsets.assign(count ? maxDepth + 2 : 1, 0);
+    for (unsigned i = 0; i < count; ++i)
+        ++levelOffsets[depths[i] + 1];
+    for (unsigned level = 1; level < levelOffsets.size(); ++level)
+        levelOffsets[level] += levelOffsets[level - 1];
+
+    std::vector<unsigned> positions(count);
+    std::vector<unsigned> next(levelOffsets.begin(), levelOffsets.end() - 1);
+    order.resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        positions[i] = next[depths[i]]++;
+        order[positions[i]] = i;
+    }
+
+    sortedParents.resize(count);
+    for (unsigned i = 0; i < count; ++i)
+        sortedParents[positions[i]] = parents[i] >= 0 ? (int) positions[parents[i]] : -1;
+}
+
+void PropagateTransforms(TransformArray const& local, int const* parents, unsigned const* levelOffsets, unsigned levelCount,
+    TransformArray& world)
+{
+    if (!levelCount)
+        return;
+    assert(local.GetSize() == world.GetSize() && levelOffsets[levelCount] <= local.GetSize());
+
+    float const* l[TransformArray::ElementCount];
+    float* w[TransformArray::ElementCount];
+    local.GetStreams(l);
+    world.GetStreams(w);
+
+    // Roots
+    for (unsigned e = 0; e < TransformArray::ElementCount; ++e)
+        memcpy(w[e] + levelOffsets[0], l[e] + levelOffsets[0], (levelOffsets[1] - levelOffsets[0]) * sizeof(float));
+
+    for (unsigned level = 1; level < levelCount; ++level)
+    {
+        ForEachLanes(levelOffsets[level], levelOffsets[level + 1] - levelOffsets[level], [&](unsigned i, auto lane)
+        {
+            typedef decltype(lane) F;
+            F mp[TransformArray::ElementCount];
+            for (unsigned e = 0; e < TransformArray::ElementCount; ++e)
+                mp[e] = F::Gather(w[e], parents + i);
+            MultiplyLanes(l, mp, w, i);
+        });
+    }
+}
+
+void PropagateTransforms(Matrix4 const* local, int const* parents, unsigned count, Matrix4* world)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        assert(parents[i] < (int) i);
+        world[i] = parents[i] >= 0 ? local[i] * world[parents[i]] : local[i];
+    }
+}
+
+void TransformBounds(BoundsArray const& local, TransformArray const& transforms, BoundsArray& dest, unsigned first, unsigned count)
+{
+    assert(first + count <= local.GetSize() && first + count <= transforms.GetSize() && first + count <= dest.GetSize());
+
+    float const* b[BoundsArray::ElementCount];
+    float const* t[TransformArray::ElementCount];
+    float* r[BoundsArray::ElementCount];
+    local.GetStreams(b);
+    transforms.GetStreams(t);
+    dest.GetStreams(r);
+
+    ForEachLanes(first, count, [&](unsigned i, auto lane)
+    {
+        typedef decltype(lane) F;
+        F m[TransformArray::ElementCount];
+        LoadTransforms(t, i, m);
+        F cx = F::Load(b[0] + i), cy = F::Load(b[1] + i), cz = F::Load(b[2] + i);
+        F ex = F::Load(b[3] + i), ey = F::Load(b[4] + i), ez = F::Load(b[5] + i);
+
+        // Centers transform as points, extents by the absolute linear part
+        Store(r[0] + i, TransformRow(cx, cy, cz, m, 0) + m[9]);
+        Store(r[1] + i, TransformRow(cx, cy, cz, m, 1) + m[10]);
+        Store(r[2] + i, TransformRow(cx, cy, cz, m, 2) + m[11]);
+        for (unsigned e = 0; e < 9; ++e)
+            m[e] = Abs(m[e]);
+        Store(r[3] + i, TransformRow(ex, ey, ez, m, 0));
+        Store(r[4] + i, TransformRow(ex, ey, ez, m, 1));
+        Store(r[5] + i, TransformRow(ex, ey, ez, m, 2));
+    });
+}
+
+void TransformBounds(BoundingBox const* local, Matrix4 const* transforms, BoundingBox* dest, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        dest[i] = local[i].Transformed(transforms[i]);
+}
+
+void TransformBounds(SphereArray const& local, TransformArray const& transforms, SphereArray& dest, unsigned first, unsigned count)
+{
+    assert(first + count <= local.GetSize() && first + count <= transforms.GetSize() && first + count <= dest.GetSize());
+
+    float const* b[SphereArray::ElementCount];
+    float const* t[TransformArray::ElementCount];
+    float* r[SphereArray::ElementCount];
+    local.GetStreams(b);
+    transforms.GetStreams(t);
+    dest.GetStreams(r);
+
+    ForEachLanes(first, count, [&](unsigned i, auto lane)
+    {
+        typedef decltype(lane) F;
+        F m[TransformArray::ElementCount];
+        LoadTransforms(t, i, m);
+        F cx = F::Load(b[0] + i), cy = F::Load(b[1] + i), cz = F::Load(b[2] + i);
+
+        Store(r[0] + i, TransformRow(cx, cy, cz, m, 0) + m[9]);
+        Store(r[1] + i, TransformRow(cx, cy, cz, m, 1) + m[10]);
+        Store(r[2] + i, TransformRow(cx, cy, cz, m, 2) + m[11]);
+        // The rows of the linear part are the transformed axes
+        F scale = Max(Max(MulAdd(m[0], m[0], MulAdd(m[1], m[1], m[2] * m[2])), MulAdd(m[3], m[3], MulAdd(m[4], m[4], m[5] * m[5]))),
+            MulAdd(m[6], m[6], MulAdd(m[7], m[7], m[8] * m[8])));
+        Store(r[3] + i, F::Load(b[3] + i) * Sqrt(scale));
+    });
+}
@@ -0,0 +1,144 @@
+
+#include "UploadRing.h"
+
+#include <cassert>
+#include <cstring>
+
+
+UploadRing::UploadRing() = default;
+
+UploadRing::~UploadRing()
+{
+    Shutdown();
+}
+
+bool UploadRing::Initialize(UploadBufferFactory& factory, uint64_t size)
+{
+    factory_ = &factory;
+    return factory_->CreateBuffer(size, current_);
+}
+
+void UploadRing::Shutdown()
+{
+    if (!factory_)
+        return;
+
+    for (RetiredBuffer& buffer : retired_)
+        factory_->DestroyBuffer(buffer.info_);
+    retired_.clear();
+
+    if (current_.resource_)
+        factory_->DestroyBuffer(current_);
+    current_ = UploadBufferInfo();
+
+    frames_.clear();
+    head_ = usedSize_ = frameSize_ = 0;
+}
+
+UploadAllocation UploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    UploadAllocation allocation;
+    if (!IsInitialized() || !size)
+        return allocation;
+
+    uint64_t offset = (head_ + alignment - 1) & ~(alignment - 1);
+    uint64_t required;
+
+    if (offset + size > current_.size_)
+    {
+        // Allocations must be contiguous, so skip the tail end of the buffer and start over at zero
+        offset = 0;
+        required = current_.size_ - head_ + size;
+    }
+    else
+        required = offset - head_ + size;
+
+    if (usedSize_ + required > current_.size_)
+    {
+        if (!Grow(size + alignment))
+            return allocation;
+
+        offset = 0;
+        required = size;
+    }
+
+    allocation.cpu_ = current_.cpu_ + offset;
+    allocation.gpu_ = current_.gpu_ + offset;
+    allocation.resource_ = current_.resource_;
+    allocation.offset_ = offset;
+    allocation.size_ = size;
+
+    head_ = offset + size;
+    if (head_ == current_.size_)
+        head_ = 0;
+    usedSize_ += required;
+    frameSize_ += required;
+
+    return allocation;
+}
+
+UploadAllocation UploadRing::Upload(void const* data, uint64_t size, uint64_t alignment)
+{
+    UploadAllocation allocation = Allocate(size, alignment);
+    if (allocation.IsValid())
+        memcpy(allocation.cpu_, data, (size_t) size);
+
+    return allocation;
+}
+
+void UploadRing::BeginFrame(uint64_t completedValue)
+{
+    while (!frames_.empty() && frames_.front().fenceValue_ <= completedValue)
+    {
+        usedSize_ -= frames_.front().size_;
+        frames_.pop_front();
+    }
+
+    for (unsigned i = 0; i < retired_.size();)
+    {
+        if (retired_[i].fenceValue_ && retired_[i].fenceValue_ <= completedValue)
+        {
+            factory_->DestroyBuffer(retired_[i].info_);
+            retired_[i] = retired_.back();
+            retired_.pop_back();
+        }
+        else
+            ++i;
+    }
+}
+
+void UploadRing::EndFrame(uint64_t fenceValue)
+{
+    if (frameSize_)
+        frames_.push_back({ fenceValue, frameSize_ });
+    frameSize_ = 0;
+
+    // Buffers replaced during this frame were last used by it
+    for (RetiredBuffer& buffer : retired_)
+    {
+        if (!buffer.fenceValue_)
+            buffer.fenceValue_ = fenceValue;
+    }
+}
+
+bool UploadRing::Grow(uint64_t size)
+{
+    uint64_t newSize = current_.size_ * 2;
+    while (newSize < size)
+        newSize *= 2;
+
+    UploadBufferInfo info;
+    if (!factory_->CreateBuffer(newSize, info))
+        return false;
+
+    // Frames in flight keep reading the old buffer, it goes once the current frame completes
+    retired_.push_back({ current_, 0 });
+    current_ = info;
+
+    frames_.clear();
+    head_ = usedSize_ = frameSize_ = 0;
+    ++growCount_;
+    return true;
+}
@@ -0,0 +1,53 @@
+
+#include "WaitEvent.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+
+#if defined(_WIN32)
+
+WaitEvent::WaitEvent()
+    : handle_(CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS))
+{
+}
+
+WaitEvent::~WaitEvent()
+{
+    CloseHandle(handle_);
+}
+
+void WaitEvent::Set()
+{
+    SetEvent(handle_);
+}
+
+void WaitEvent::Wait()
+{
+    WaitForSingleObject(handle_, INFINITE);
+}
+
+#else
+
+WaitEvent::WaitEvent() = default;
+
+WaitEvent::~WaitEvent() = default;
+
+void WaitEvent::Set()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        signaled_ = true;
+    }
+    condition_.notify_one();
+}
+
+void WaitEvent::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return signaled_; });
+    signaled_ = false;
+}
+
+#endif
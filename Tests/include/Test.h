@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+
+/// Test function.
+typedef void (*TestFunction)();
+
+/// Registers a test with the runner at static initialization.
+class TestRegistrar
+{
+public:
+    /// Register a test of a suite. Suites are named after their source files, one CTest test each.
+    TestRegistrar(char const* suite, char const* name, TestFunction function);
+};
+
+/// Report a failed check of the running test.
+void ReportFailure(char const* file, int line, char const* expression);
+
+/// Define a test of a suite.
+#define TEST(suite, name) \
+    static void suite##_##name(); \
+    static TestRegistrar suite##_##name##_registrar(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+/// Check a condition, continuing the test if it fails.
+#define CHECK(expression) \
+    do { if (!(expression)) ReportFailure(__FILE__, __LINE__, #expression); } while (0)
+
+/// Check a condition, ending the test if it fails.
+#define REQUIRE(expression) \
+    do { if (!(expression)) { ReportFailure(__FILE__, __LINE__, #expression); return; } } while (0)
+
+/// Check two floats are within a tolerance.
+#define CHECK_NEAR(actual, expected, tolerance) \
+    CHECK(std::fabs((double) (actual) - (double) (expected)) <= (double) (tolerance))
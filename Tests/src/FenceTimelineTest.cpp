@@ -0,0 +1,170 @@
+#include "FenceTimeline.h"
+#include "SimulatedQueue.h"
+#include "Test.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+TEST(FenceTimelineTest, SignalsIncreasingValues)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+
+    uint64_t last = 0;
+    for (unsigned i = 0; i < 10; ++i)
+    {
+        uint64_t value = timeline.Signal();
+        CHECK(value == last + 1);
+        last = value;
+    }
+    CHECK(timeline.GetLastSignaledValue() == 10);
+}
+
+TEST(FenceTimelineTest, ContinuesFromFenceValue)
+{
+    SimulatedQueue queue(false);
+    queue.Signal(7);
+    queue.ProcessCommands();
+
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+    CHECK(timeline.GetCompletedValue() == 7);
+    CHECK(timeline.Signal() == 8);
+}
+
+TEST(FenceTimelineTest, PollsWithoutBlocking)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+
+    uint64_t first = timeline.Signal();
+    uint64_t second = timeline.Signal();
+    CHECK(!timeline.IsComplete(first));
+    CHECK(queue.GetPendingCommandCount() == 2);
+
+    queue.ProcessCommands(1);
+    CHECK(timeline.IsComplete(first));
+    CHECK(!timeline.IsComplete(second));
+    CHECK(timeline.GetBlockingWaitCount() == 0);
+}
+
+TEST(FenceTimelineTest, WaitBlocksOnlyWhenIncomplete)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+
+    uint64_t value = timeline.Signal();
+    timeline.Wait(value);
+    CHECK(timeline.IsComplete(value));
+    CHECK(timeline.GetBlockingWaitCount() == 1);
+
+    timeline.Wait(value);
+    CHECK(timeline.GetBlockingWaitCount() == 1);
+
+    timeline.Flush();
+    CHECK(timeline.GetCompletedValue() == 2);
+    CHECK(timeline.GetBlockingWaitCount() == 2);
+}
+
+TEST(FenceTimelineTest, ReusesWaitEvents)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+
+    for (unsigned i = 0; i < 100; ++i)
+        timeline.Flush();
+    CHECK(timeline.GetBlockingWaitCount() == 100);
+    CHECK(timeline.GetWaitEventCount() == 1);
+}
+
+TEST(FenceTimelineTest, PoolHoldsPeakConcurrentWaiters)
+{
+    SimulatedQueue queue(true);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+
+    for (unsigned round = 0; round < 10; ++round)
+    {
+        queue.Execute(std::chrono::microseconds(2000));
+        uint64_t value = timeline.Signal();
+
+        std::vector<std::thread> waiters;
+        for (unsigned i = 0; i < 4; ++i)
+            waiters.emplace_back([&timeline, value]() { timeline.Wait(value); });
+        for (std::thread& waiter : waiters)
+            waiter.join();
+        CHECK(timeline.IsComplete(value));
+    }
+    CHECK(timeline.GetWaitEventCount() >= 1);
+    CHECK(timeline.GetWaitEventCount() <= 4);
+}
+
+TEST(FenceTimelineTest, RunsCallbacksInValueOrder)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+
+    uint64_t first = timeline.Signal();
+    uint64_t second = timeline.Signal();
+    uint64_t third = timeline.Signal();
+
+    std::vector<int> order;
+    timeline.OnCompletion(third, [&]() { order.push_back(3); });
+    timeline.OnCompletion(first, [&]() { order.push_back(1); });
+    timeline.OnCompletion(second, [&]() { order.push_back(2); });
+    CHECK(timeline.GetPendingCallbackCount() == 3);
+    CHECK(timeline.Poll() == 0);
+
+    queue.ProcessCommands(2);
+    CHECK(timeline.Poll() == 2);
+    REQUIRE(order.size() == 2);
+    CHECK(order[0] == 1 && order[1] == 2);
+    CHECK(timeline.GetPendingCallbackCount() == 1);
+
+    // Waiting runs the callbacks that became due
+    timeline.Wait(third);
+    REQUIRE(order.size() == 3);
+    CHECK(order[2] == 3);
+    CHECK(timeline.GetPendingCallbackCount() == 0);
+}
+
+TEST(FenceTimelineTest, CallbacksMayRegisterCallbacks)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+
+    uint64_t value = timeline.Signal();
+    unsigned runs = 0;
+    timeline.OnCompletion(value, [&]()
+    {
+        ++runs;
+        timeline.OnCompletion(value, [&]() { ++runs; });
+    });
+
+    timeline.Wait(value);
+    CHECK(runs == 1);
+    CHECK(timeline.Poll() == 1);
+    CHECK(runs == 2);
+}
+
+TEST(FenceTimelineTest, CompletedCallbackRunsOnNextPoll)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+
+    timeline.Flush();
+    bool ran = false;
+    timeline.OnCompletion(timeline.GetLastSignaledValue(), [&]() { ran = true; });
+    CHECK(!ran);
+    CHECK(timeline.Poll() == 1);
+    CHECK(ran);
+}
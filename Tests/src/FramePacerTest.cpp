@@ -0,0 +1,146 @@
+#include "FenceTimeline.h"
+#include "FramePacer.h"
+#include "SimulatedQueue.h"
+#include "Test.h"
+
+#include <chrono>
+
+
+/// Submit a frame of simulated work and end it with a signal.
+static void SubmitFrame(FramePacer& pacer, SimulatedQueue& queue, FenceTimeline& timeline)
+{
+    queue.Execute(std::chrono::microseconds(100));
+    pacer.EndFrame(timeline.Signal());
+}
+
+TEST(FramePacerTest, ClampsFramesInFlight)
+{
+    FramePacer pacer(0);
+    CHECK(pacer.GetFramesInFlight() == 1);
+    pacer.SetFramesInFlight(FramePacer::MaxFramesInFlight + 5);
+    CHECK(pacer.GetFramesInFlight() == FramePacer::MaxFramesInFlight);
+    pacer.SetFramesInFlight(2);
+    CHECK(pacer.GetFramesInFlight() == 2);
+}
+
+TEST(FramePacerTest, CyclesFrameSlots)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+    FramePacer pacer(3);
+
+    for (unsigned frame = 0; frame < 10; ++frame)
+    {
+        CHECK(pacer.BeginFrame(timeline) == frame % 3);
+        CHECK(pacer.GetFrameIndex() == frame % 3);
+        SubmitFrame(pacer, queue, timeline);
+        CHECK(pacer.GetFrameFenceValue(frame % 3) == frame + 1);
+    }
+    CHECK(pacer.GetFrameNumber() == 10);
+}
+
+TEST(FramePacerTest, WaitsOnlyForReusedSlot)
+{
+    // A manual queue executes nothing until waited on, so the completed value shows exactly how far each wait drove it
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+    FramePacer pacer(2);
+
+    pacer.BeginFrame(timeline);
+    SubmitFrame(pacer, queue, timeline);
+    pacer.BeginFrame(timeline);
+    SubmitFrame(pacer, queue, timeline);
+    CHECK(pacer.GetStallCount() == 0);
+    CHECK(queue.GetCompletedValue() == 0);
+
+    // The third frame reuses the first slot and waits for the first frame, not the second
+    CHECK(pacer.BeginFrame(timeline) == 0);
+    CHECK(pacer.GetStallCount() == 1);
+    CHECK(queue.GetCompletedValue() == 1);
+    CHECK(queue.GetPendingCommandCount() > 0);
+    SubmitFrame(pacer, queue, timeline);
+
+    // Frames the GPU already finished do not stall
+    queue.ProcessCommands();
+    CHECK(pacer.BeginFrame(timeline) == 1);
+    CHECK(pacer.GetStallCount() == 1);
+}
+
+TEST(FramePacerTest, SingleFrameInFlightWaitsForPreviousFrame)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+    FramePacer pacer(1);
+
+    for (unsigned frame = 0; frame < 5; ++frame)
+    {
+        pacer.BeginFrame(timeline);
+        CHECK(queue.GetCompletedValue() == frame);
+        SubmitFrame(pacer, queue, timeline);
+    }
+    CHECK(pacer.GetStallCount() == 4);
+}
+
+TEST(FramePacerTest, ExtendFrameDelaysSlotReuse)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+    FramePacer pacer(2);
+
+    pacer.BeginFrame(timeline);
+    SubmitFrame(pacer, queue, timeline);
+    pacer.BeginFrame(timeline);
+    SubmitFrame(pacer, queue, timeline);
+
+    // Work submitted from the first slot's allocator after its frame ended
+    pacer.BeginFrame(timeline);
+    queue.Execute(std::chrono::microseconds(100));
+    uint64_t extended = timeline.Signal();
+    pacer.ExtendFrame(extended);
+    CHECK(pacer.GetFrameFenceValue(0) == extended);
+    pacer.EndFrame(timeline.Signal());
+    CHECK(pacer.GetFrameFenceValue(0) == extended + 1);
+}
+
+TEST(FramePacerTest, ChangingCountWaitsForNewestFrame)
+{
+    SimulatedQueue queue(false);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+    FramePacer pacer(3);
+
+    for (unsigned frame = 0; frame < 3; ++frame)
+    {
+        pacer.BeginFrame(timeline);
+        SubmitFrame(pacer, queue, timeline);
+    }
+
+    // Slots map to frames differently after the change, so the next frame waits for every one submitted
+    pacer.SetFramesInFlight(2);
+    for (unsigned i = 0; i < FramePacer::MaxFramesInFlight; ++i)
+        CHECK(pacer.GetFrameFenceValue(i) == 3);
+    pacer.BeginFrame(timeline);
+    CHECK(queue.GetCompletedValue() == 3);
+}
+
+TEST(FramePacerTest, WaitIdleCompletesAllFrames)
+{
+    SimulatedQueue queue(true);
+    FenceTimeline timeline;
+    timeline.SetFence(&queue);
+    FramePacer pacer(3);
+
+    for (unsigned frame = 0; frame < 20; ++frame)
+    {
+        pacer.BeginFrame(timeline);
+        SubmitFrame(pacer, queue, timeline);
+        // Never more than the frames in flight are outstanding
+        CHECK(timeline.GetLastSignaledValue() - queue.GetCompletedValue() <= 3);
+    }
+    pacer.WaitIdle(timeline);
+    CHECK(queue.GetCompletedValue() == 20);
+}
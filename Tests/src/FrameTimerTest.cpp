@@ -0,0 +1,106 @@
+#include "FrameTimer.h"
+#include "Test.h"
+
+
+TEST(FrameTimerTest, AccumulatesFixedSteps)
+{
+    VirtualFrameClock clock;
+    FrameTimer timer(clock);
+    timer.SetTimestep(10000);
+
+    clock.Advance(25000);
+    CHECK(timer.BeginFrame() == 2);
+    CHECK(timer.GetFrameTime() == 25000);
+    CHECK_NEAR(timer.GetInterpolation(), 0.5, 1e-9);
+
+    // The remainder carries over into the next frame
+    clock.Advance(5000);
+    CHECK(timer.BeginFrame() == 1);
+    CHECK_NEAR(timer.GetInterpolation(), 0.0, 1e-9);
+    CHECK(timer.GetStepCount() == 3);
+    CHECK(timer.GetFrameCount() == 2);
+}
+
+TEST(FrameTimerTest, SimulationIndependentOfFrameRate)
+{
+    // One simulated second takes the same number of steps at 30, 144 and an uneven frame rate
+    int64_t const frameTimes[] = { 33333, 6944, 17000 };
+    for (int64_t frameTime : frameTimes)
+    {
+        VirtualFrameClock clock;
+        FrameTimer timer(clock);
+        timer.SetTimestep(1000000 / 60);
+        for (int64_t elapsed = 0; elapsed + frameTime <= 1000000; elapsed += frameTime)
+        {
+            clock.Advance(frameTime);
+            timer.BeginFrame();
+            CHECK(timer.GetInterpolation() >= 0.0 && timer.GetInterpolation() < 1.0);
+        }
+        clock.Advance(1000000 - clock.GetMicroseconds());
+        timer.BeginFrame();
+        CHECK(timer.GetStepCount() == 60);
+    }
+}
+
+TEST(FrameTimerTest, DropsTimeBeyondMaxSteps)
+{
+    VirtualFrameClock clock;
+    FrameTimer timer(clock);
+    timer.SetTimestep(10000);
+    timer.SetMaxSteps(4);
+
+    // A long stall does not make the next frames catch up
+    clock.Advance(100000);
+    CHECK(timer.BeginFrame() == 4);
+    CHECK(timer.GetDroppedTime() == 60000);
+    clock.Advance(10000);
+    CHECK(timer.BeginFrame() == 1);
+}
+
+TEST(FrameTimerTest, CapsFrameRate)
+{
+    VirtualFrameClock clock;
+    FrameTimer timer(clock);
+    timer.SetFrameRateLimit(100);
+
+    // Frames that take 2 ms sleep until the next 10 ms boundary
+    for (unsigned frame = 0; frame < 10; ++frame)
+    {
+        timer.BeginFrame();
+        clock.Advance(2000);
+    }
+    CHECK(clock.GetMicroseconds() == 9 * 10000 + 2000);
+    CHECK(clock.GetSleepCount() == 9);
+    CHECK(clock.GetSleepTime() == 9 * 8000);
+}
+
+TEST(FrameTimerTest, RestartsCadenceAfterLongFrame)
+{
+    VirtualFrameClock clock;
+    FrameTimer timer(clock);
+    timer.SetFrameRateLimit(100);
+
+    timer.BeginFrame();
+    clock.Advance(35000);
+    timer.BeginFrame();
+    CHECK(clock.GetSleepCount() == 0);
+
+    // The next frame is due one interval later instead of immediately to catch up
+    clock.Advance(1000);
+    timer.BeginFrame();
+    CHECK(clock.GetMicroseconds() == 45000);
+    CHECK(clock.GetSleepTime() == 9000);
+}
+
+TEST(FrameTimerTest, UncappedNeverSleeps)
+{
+    VirtualFrameClock clock;
+    FrameTimer timer(clock);
+    for (unsigned frame = 0; frame < 100; ++frame)
+    {
+        clock.Advance(100);
+        timer.BeginFrame();
+    }
+    CHECK(clock.GetSleepCount() == 0);
+    CHECK(timer.GetFrameTime() == 100);
+}
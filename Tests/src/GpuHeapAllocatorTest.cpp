@@ -0,0 +1,77 @@
+#include "GpuHeapAllocator.h"
+#include "NullGpuHeapFactory.h"
+#include "Test.h"
+
+
+TEST(GpuHeapAllocatorTest, PlacesResourcesInSharedHeap)
+{
+    NullGpuHeapFactory factory;
+    GpuHeapAllocator allocator;
+    allocator.Initialize(factory, 1 << 20);
+
+    GpuAllocation first = allocator.Allocate(GPU_HEAP_BUFFERS, 4096, 65536);
+    GpuAllocation second = allocator.Allocate(GPU_HEAP_BUFFERS, 4096, 65536);
+    REQUIRE(first.IsValid() && second.IsValid());
+    CHECK(first.heap_ == second.heap_);
+    CHECK(second.offset_ % 65536 == 0);
+    CHECK(factory.GetHeapCount() == 1);
+
+    // Categories never share a heap
+    GpuAllocation texture = allocator.Allocate(GPU_HEAP_TEXTURES, 4096, 65536);
+    REQUIRE(texture.IsValid());
+    CHECK(texture.heap_ != first.heap_);
+    CHECK(factory.GetHeapCount() == 2);
+
+    GpuHeapStats stats = allocator.GetStats(GPU_HEAP_BUFFERS);
+    CHECK(stats.blocks_ == 1);
+    CHECK(stats.allocations_ == 2);
+    CHECK(stats.allocatedSize_ == 8192);
+    CHECK(allocator.GetTotalStats().allocations_ == 3);
+}
+
+TEST(GpuHeapAllocatorTest, DedicatedBlockForLargeRequest)
+{
+    NullGpuHeapFactory factory;
+    GpuHeapAllocator allocator;
+    allocator.Initialize(factory, 1 << 20);
+
+    GpuAllocation small = allocator.Allocate(GPU_HEAP_TEXTURES, 4096, 65536);
+    GpuAllocation large = allocator.Allocate(GPU_HEAP_TEXTURES, 4 << 20, 65536);
+    REQUIRE(small.IsValid() && large.IsValid());
+    CHECK(large.heap_ != small.heap_);
+    CHECK(factory.GetHeapCount() == 2);
+
+    // Empty blocks go, except the last of the category
+    allocator.Free(large);
+    CHECK(factory.GetHeapCount() == 1);
+    allocator.Free(small);
+    CHECK(factory.GetHeapCount() == 1);
+    CHECK(allocator.GetStats(GPU_HEAP_TEXTURES).allocations_ == 0);
+
+    allocator.Shutdown();
+    CHECK(factory.GetHeapCount() == 0);
+}
+
+TEST(GpuHeapAllocatorTest, DedicatedBlockOfUnalignedSize)
+{
+    NullGpuHeapFactory factory;
+    GpuHeapAllocator allocator;
+    allocator.Initialize(factory, 1 << 20);
+
+    // The heap is rounded up to the allocator granularity rather than truncated below the request
+    GpuAllocation large = allocator.Allocate(GPU_HEAP_BUFFERS, (4 << 20) + 100, 256);
+    REQUIRE(large.IsValid());
+    CHECK(large.size_ >= (4 << 20) + 100);
+    CHECK(factory.GetHeapCount() == 1);
+    CHECK(factory.GetHeapBytes() == (4 << 20) + 256);
+
+    // A request nothing can hold fails without leaving a heap behind
+    GpuAllocation empty = allocator.Allocate(GPU_HEAP_TEXTURES, 0, 256);
+    CHECK(!empty.IsValid());
+    CHECK(factory.GetHeapCount() == 1);
+    CHECK(allocator.GetStats(GPU_HEAP_TEXTURES).blocks_ == 0);
+
+    allocator.Free(large);
+    allocator.Shutdown();
+    CHECK(factory.GetHeapCount() == 0);
+}
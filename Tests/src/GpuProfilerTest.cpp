@@ -0,0 +1,132 @@
+#include "GpuProfiler.h"
+#include "NullTimestampQuerySource.h"
+#include "Test.h"
+
+
+TEST(GpuProfilerTest, ReadsFrameOnceFenceCompletes)
+{
+    // One tick per nanosecond on a clock that only moves when advanced
+    NullTimestampQuerySource source;
+    source.SetManualClock(true);
+    GpuProfiler profiler;
+    REQUIRE(profiler.Initialize(source, 16));
+    CHECK(source.GetQueryCount() == 16 * 2 * GpuProfiler::FrameCount);
+
+    profiler.BeginFrame(0);
+    unsigned outer = profiler.BeginZone("Frame");
+    source.AdvanceClock(1000);
+    unsigned inner = profiler.BeginZone("Draw");
+    source.AdvanceClock(3000);
+    profiler.EndZone(inner);
+    source.AdvanceClock(1000);
+    profiler.EndZone(outer);
+    profiler.EndFrame(1);
+    CHECK(source.GetResolvedQueryCount() == 4);
+
+    // Nothing is read while the GPU has not passed the frame's fence
+    profiler.BeginFrame(0);
+    CHECK(profiler.GetLastFrameZones().empty());
+    CHECK(profiler.GetPendingFrameCount() == 1);
+    CHECK(source.GetReadQueryCount() == 0);
+    profiler.EndFrame(2);
+
+    profiler.BeginFrame(1);
+    CHECK(profiler.GetStats().framesRead_ == 1);
+    CHECK(profiler.GetPendingFrameCount() == 1);
+    std::vector<GpuZoneTiming> const& zones = profiler.GetLastFrameZones();
+    REQUIRE(zones.size() == 2);
+    CHECK(zones[0].name_ == "Frame");
+    CHECK(zones[0].depth_ == 0);
+    CHECK_NEAR(zones[0].duration_, 5.0, 0.001);
+    CHECK(zones[1].name_ == "Draw");
+    CHECK(zones[1].depth_ == 1);
+    CHECK_NEAR(zones[1].duration_, 3.0, 0.001);
+    CHECK_NEAR(zones[1].start_ - zones[0].start_, 1.0, 0.001);
+}
+
+TEST(GpuProfilerTest, ConvertsToCpuTimeline)
+{
+    NullTimestampQuerySource source(10000000);
+    source.SetManualClock(true);
+    GpuProfiler profiler;
+    REQUIRE(profiler.Initialize(source));
+
+    uint64_t timestamp = source.GetTimestamp();
+    CHECK_NEAR(profiler.TimestampToMicroseconds(timestamp + 10) - profiler.TimestampToMicroseconds(timestamp), 1.0, 0.001);
+    CHECK_NEAR(profiler.TimestampToMicroseconds(timestamp + 10000000) - profiler.TimestampToMicroseconds(timestamp), 1000000.0, 0.01);
+}
+
+TEST(GpuProfilerTest, DropsFrameWhenRingIsFull)
+{
+    NullTimestampQuerySource source;
+    GpuProfiler profiler;
+    REQUIRE(profiler.Initialize(source, 4));
+
+    // More frames queued than slots: the next frame has nowhere to write and is dropped instead of stalling
+    for (unsigned frame = 0; frame < GpuProfiler::FrameCount; ++frame)
+    {
+        profiler.BeginFrame(0);
+        profiler.EndZone(profiler.BeginZone("Pass"));
+        profiler.EndFrame(frame + 1);
+    }
+    CHECK(profiler.GetPendingFrameCount() == GpuProfiler::FrameCount);
+
+    uint64_t queries = source.GetEndQueryCount();
+    profiler.BeginFrame(0);
+    CHECK(profiler.BeginZone("Pass") == ~0u);
+    profiler.EndFrame(GpuProfiler::FrameCount + 1);
+    CHECK(profiler.GetStats().framesDropped_ == 1);
+    CHECK(source.GetEndQueryCount() == queries);
+
+    // Once the GPU catches up every pending frame is read, oldest first
+    profiler.BeginFrame(GpuProfiler::FrameCount);
+    CHECK(profiler.GetStats().framesRead_ == GpuProfiler::FrameCount);
+    CHECK(profiler.GetPendingFrameCount() == 0);
+    CHECK(profiler.BeginZone("Pass") != ~0u);
+}
+
+TEST(GpuProfilerTest, DropsZonesOverMaximum)
+{
+    NullTimestampQuerySource source;
+    GpuProfiler profiler;
+    REQUIRE(profiler.Initialize(source, 2));
+
+    profiler.BeginFrame(0);
+    for (unsigned i = 0; i < 3; ++i)
+        profiler.EndZone(profiler.BeginZone("Pass"));
+    profiler.EndFrame(1);
+    CHECK(profiler.GetStats().zonesDropped_ == 1);
+
+    profiler.BeginFrame(1);
+    CHECK(profiler.GetLastFrameZones().size() == 2);
+}
+
+TEST(GpuProfilerTest, ClosesOpenZonesAtFrameEnd)
+{
+    NullTimestampQuerySource source;
+    source.SetManualClock(true);
+    GpuProfiler profiler;
+    REQUIRE(profiler.Initialize(source));
+
+    profiler.BeginFrame(0);
+    profiler.BeginZone("Outer");
+    profiler.BeginZone("Inner");
+    source.AdvanceClock(2000);
+    profiler.EndFrame(1);
+    CHECK(source.GetEndQueryCount() == 4);
+
+    profiler.BeginFrame(1);
+    std::vector<GpuZoneTiming> const& zones = profiler.GetLastFrameZones();
+    REQUIRE(zones.size() == 2);
+    CHECK_NEAR(zones[0].duration_, 2.0, 0.001);
+    CHECK_NEAR(zones[1].duration_, 2.0, 0.001);
+}
+
+TEST(GpuProfilerTest, ScopeIsInertWhenUninitialized)
+{
+    GpuProfiler profiler;
+    {
+        GpuProfileScope scope(profiler, "Pass");
+    }
+    CHECK(!profiler.IsInitialized());
+}
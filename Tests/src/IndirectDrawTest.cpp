@@ -0,0 +1,222 @@
+#include "IndirectDraw.h"
+#include "NullGraphicsBackend.h"
+#include "NullUploadBufferFactory.h"
+#include "ObjectBuffer.h"
+#include "Test.h"
+
+#include <vector>
+
+
+/// Object data of the object buffer tests.
+struct TestObject
+{
+    uint32_t values_[4];
+};
+
+/// Return copies recorded into a command list, their sizes in recording order.
+static std::vector<uint64_t> GetCopies(NullCommandList const& commandList)
+{
+    std::vector<uint64_t> copies;
+    for (RecordedCommand const& command : commandList.GetRecordedCommands())
+    {
+        if (command.type_ == RECORD_COPY_BUFFER)
+            copies.push_back(command.value_);
+    }
+    return copies;
+}
+
+/// Upload an object buffer in a frame of the backend. Return whether it succeeded.
+static bool UploadFrame(NullGraphicsBackend& backend, NullCommandList& commandList, ObjectBuffer& objects)
+{
+    backend.Begin();
+    commandList.Reset(0);
+    bool uploaded = objects.Upload(commandList);
+    commandList.Close();
+    backend.End();
+    return uploaded;
+}
+
+/// Set an object to a value in all its elements.
+static void SetObject(ObjectBuffer& objects, unsigned index, uint32_t value)
+{
+    TestObject object{ { value, value, value, value } };
+    objects.Set(index, &object);
+}
+
+/// Return the first element of an object in the GPU buffer, which the null factory backs with memory.
+static uint32_t GetGpuObject(ObjectBuffer const& objects, unsigned index)
+{
+    return ((TestObject const*) (size_t) objects.GetGpuAddress())[index].values_[0];
+}
+
+TEST(IndirectDrawTest, PacksArgumentsOfDrawnObjects)
+{
+    NullUploadBufferFactory factory;
+    UploadRing ring;
+    REQUIRE(ring.Initialize(factory, 4096));
+
+    IndirectDrawBatch batch;
+    batch.SetMesh(0, { 36, 0, 0 });
+    batch.SetMesh(3, { 6, 36, 24 });
+    batch.SetMesh(5, { 0, 42, 0 });
+    batch.SetMesh(7, { 12, 48, -4 });
+
+    // Objects without indices or beyond the meshes are skipped, the rest packed in the given order
+    std::vector<unsigned> objects = { 7, 0, 5, 3, 99 };
+    REQUIRE(batch.Build(objects, ring));
+    REQUIRE(batch.GetDrawCount() == 3);
+    CHECK(batch.GetArguments().size_ >= 3 * sizeof(IndirectDrawArguments));
+
+    IndirectDrawArguments const* arguments = (IndirectDrawArguments const*) batch.GetArguments().cpu_;
+    CHECK(arguments[0].objectIndex_ == 7);
+    CHECK(arguments[0].indexCount_ == 12);
+    CHECK(arguments[0].firstIndex_ == 48);
+    CHECK(arguments[0].baseVertex_ == -4);
+    CHECK(arguments[1].objectIndex_ == 0);
+    CHECK(arguments[1].indexCount_ == 36);
+    CHECK(arguments[1].firstIndex_ == 0);
+    CHECK(arguments[2].objectIndex_ == 3);
+    CHECK(arguments[2].indexCount_ == 6);
+    CHECK(arguments[2].firstIndex_ == 36);
+    CHECK(arguments[2].baseVertex_ == 24);
+    for (unsigned i = 0; i < 3; ++i)
+        CHECK(arguments[i].instanceCount_ == 1 && arguments[i].firstInstance_ == 0);
+
+    CHECK(batch.Build(std::vector<unsigned>(), ring));
+    CHECK(batch.GetDrawCount() == 0);
+}
+
+TEST(IndirectDrawTest, ExecutesOnceWithSignature)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullCommandList commandList(backend);
+    NullUploadBufferFactory factory;
+    UploadRing ring;
+    REQUIRE(ring.Initialize(factory, 4096));
+
+    IndirectDrawBatch batch;
+    for (unsigned i = 0; i < 10; ++i)
+        batch.SetMesh(i, { 3, i * 3, 0 });
+    std::vector<unsigned> objects = { 1, 2, 4, 8 };
+    REQUIRE(batch.Build(objects, ring));
+
+    // Without a command signature nothing is drawn
+    commandList.Reset(0);
+    batch.Execute(commandList, 0x1000);
+    CHECK(commandList.GetRecordedCommands().size() == 1);
+    CHECK(!batch.IsDrawable());
+    commandList.Close();
+
+    IndirectDrawState state;
+    state.commandSignature_ = (CommandSignatureHandle) (uintptr_t) 0x100;
+    batch.SetState(state);
+    CHECK(batch.IsDrawable());
+    commandList.Reset(0);
+    batch.Execute(commandList, 0x1000);
+    commandList.Close();
+
+    unsigned executes = 0;
+    for (RecordedCommand const& command : commandList.GetRecordedCommands())
+    {
+        if (command.type_ == RECORD_EXECUTE_INDIRECT)
+        {
+            ++executes;
+            CHECK(command.value_ == 4);
+        }
+    }
+    CHECK(executes == 1);
+}
+
+TEST(IndirectDrawTest, UploadsOnlyDirtyRuns)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullCommandList commandList(backend);
+    ObjectBuffer objects;
+    REQUIRE(objects.Initialize(backend, sizeof(TestObject)));
+
+    // A new buffer takes every object in one copy
+    for (unsigned i = 0; i < 1024; ++i)
+        SetObject(objects, i, i);
+    REQUIRE(UploadFrame(backend, commandList, objects));
+    CHECK(objects.GetStats().fullUpload_);
+    CHECK(objects.GetStats().bytes_ == 1024 * sizeof(TestObject));
+    CHECK(GetCopies(commandList).size() == 1);
+    CHECK(GetGpuObject(objects, 1000) == 1000);
+
+    // Gaps of up to MaxRunGap clean objects are bridged, longer ones start another copy
+    unsigned const dirty[] = { 10, 12, 14, 100, 101, 200, 200 + 1 + ObjectBuffer::MaxRunGap, 300, 301 + ObjectBuffer::MaxRunGap + 1 };
+    for (unsigned index : dirty)
+        SetObject(objects, index, 5000 + index);
+    REQUIRE(UploadFrame(backend, commandList, objects));
+
+    ObjectBufferStats const& stats = objects.GetStats();
+    CHECK(!stats.fullUpload_);
+    CHECK(stats.dirtyObjects_ == 9);
+    CHECK(stats.copies_ == 5);
+    uint64_t const runs[] = { 5, 2, 2 + ObjectBuffer::MaxRunGap, 1, 1 };
+    std::vector<uint64_t> copies = GetCopies(commandList);
+    REQUIRE(copies.size() == 5);
+    uint64_t bytes = 0;
+    for (unsigned i = 0; i < 5; ++i)
+    {
+        CHECK(copies[i] == runs[i] * sizeof(TestObject));
+        bytes += copies[i];
+    }
+    CHECK(stats.bytes_ == bytes);
+
+    // Bridged clean objects are copied unchanged
+    CHECK(GetGpuObject(objects, 12) == 5012);
+    CHECK(GetGpuObject(objects, 11) == 11);
+    CHECK(GetGpuObject(objects, 306) == 5306);
+    CHECK(GetGpuObject(objects, 303) == 303);
+}
+
+TEST(IndirectDrawTest, FallsBackToFullUpload)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullCommandList commandList(backend);
+    ObjectBuffer objects;
+    REQUIRE(objects.Initialize(backend, sizeof(TestObject)));
+    for (unsigned i = 0; i < 1024; ++i)
+        SetObject(objects, i, i);
+    REQUIRE(UploadFrame(backend, commandList, objects));
+
+    // Isolated objects cost a copy each: the whole buffer is 16 KB, so 15 copies are still cheaper and 16 are not
+    uint64_t const size = 1024 * sizeof(TestObject);
+    unsigned const limit = (unsigned) (size / (ObjectBuffer::CopyCost + sizeof(TestObject)));
+    for (unsigned i = 0; i < limit; ++i)
+        SetObject(objects, i * 64, 1);
+    REQUIRE(UploadFrame(backend, commandList, objects));
+    CHECK(!objects.GetStats().fullUpload_);
+    CHECK(objects.GetStats().copies_ == limit);
+
+    for (unsigned i = 0; i <= limit; ++i)
+        SetObject(objects, i * 64, 2);
+    REQUIRE(UploadFrame(backend, commandList, objects));
+    CHECK(objects.GetStats().fullUpload_);
+    CHECK(objects.GetStats().copies_ == 1);
+    CHECK(objects.GetStats().bytes_ == size);
+    CHECK(GetGpuObject(objects, limit * 64) == 2);
+}
+
+TEST(IndirectDrawTest, UnchangedFrameUploadsNothing)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullCommandList commandList(backend);
+    ObjectBuffer objects;
+    REQUIRE(objects.Initialize(backend, sizeof(TestObject)));
+    SetObject(objects, 3, 3);
+    REQUIRE(UploadFrame(backend, commandList, objects));
+    CHECK(!objects.IsDirty());
+
+    REQUIRE(UploadFrame(backend, commandList, objects));
+    CHECK(objects.GetStats().dirtyObjects_ == 0);
+    CHECK(objects.GetStats().copies_ == 0);
+    CHECK(objects.GetStats().bytes_ == 0);
+    CHECK(GetCopies(commandList).empty());
+
+    // Setting an object to its current value still uploads it
+    SetObject(objects, 3, 3);
+    REQUIRE(UploadFrame(backend, commandList, objects));
+    CHECK(objects.GetStats().copies_ == 1);
+}
@@ -0,0 +1,153 @@
+#include "JobSystem.h"
+#include "Test.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+TEST(JobSystemTest, RunsEveryJobOnce)
+{
+    JobSystem jobSystem(3);
+    CHECK(jobSystem.GetThreadCount() == 4);
+
+    const unsigned jobCount = 10000;
+    std::unique_ptr<std::atomic<unsigned>[]> runs(new std::atomic<unsigned>[jobCount]);
+    for (unsigned i = 0; i < jobCount; ++i)
+        runs[i] = 0;
+
+    JobCounter counter;
+    CHECK(counter.IsDone());
+    for (unsigned i = 0; i < jobCount; ++i)
+        jobSystem.Run([&runs, i]() { runs[i].fetch_add(1); }, &counter);
+    jobSystem.Wait(counter);
+    CHECK(counter.IsDone());
+
+    unsigned wrong = 0;
+    for (unsigned i = 0; i < jobCount; ++i)
+        wrong += runs[i] != 1;
+    CHECK(wrong == 0);
+}
+
+TEST(JobSystemTest, ParallelForCoversRangeOnce)
+{
+    JobSystem jobSystem(3);
+
+    // Batch sizes that divide the range, leave a remainder, exceed it, and the zero that means one
+    const unsigned count = 1000;
+    const unsigned batchSizes[] = { 1, 7, 100, 5000, 0 };
+    for (unsigned batchSize : batchSizes)
+    {
+        std::unique_ptr<std::atomic<unsigned>[]> runs(new std::atomic<unsigned>[count]);
+        for (unsigned i = 0; i < count; ++i)
+            runs[i] = 0;
+
+        std::atomic<unsigned> batches{};
+        jobSystem.ParallelFor(count, batchSize, [&runs, &batches](unsigned begin, unsigned end)
+        {
+            batches.fetch_add(1);
+            for (unsigned i = begin; i < end; ++i)
+                runs[i].fetch_add(1);
+        });
+
+        unsigned wrong = 0;
+        for (unsigned i = 0; i < count; ++i)
+            wrong += runs[i] != 1;
+        CHECK(wrong == 0);
+        unsigned size = batchSize ? batchSize : 1;
+        CHECK(batches == (count + size - 1) / size);
+    }
+
+    // An empty range runs nothing
+    bool ran = false;
+    jobSystem.ParallelFor(0, 16, [&ran](unsigned, unsigned) { ran = true; });
+    CHECK(!ran);
+}
+
+TEST(JobSystemTest, ChildCountersGateParent)
+{
+    JobSystem jobSystem(3);
+
+    // Each parent waits for its children, so it must see all of them finished, and the grandchildren of each
+    // child before the child itself
+    const unsigned parentCount = 16;
+    const unsigned childCount = 32;
+    const unsigned grandchildCount = 4;
+    std::atomic<unsigned> finishedChildren[parentCount];
+    unsigned seenChildren[parentCount];
+    std::atomic<unsigned> earlyChildren{};
+    std::atomic<unsigned> jobs{};
+    for (unsigned i = 0; i < parentCount; ++i)
+    {
+        finishedChildren[i] = 0;
+        seenChildren[i] = 0;
+    }
+
+    JobCounter parents;
+    for (unsigned i = 0; i < parentCount; ++i)
+    {
+        jobSystem.Run([&, i]()
+        {
+            JobCounter children;
+            for (unsigned j = 0; j < childCount; ++j)
+            {
+                jobSystem.Run([&, i]()
+                {
+                    std::atomic<unsigned> finishedGrandchildren{};
+                    JobCounter grandchildren;
+                    for (unsigned k = 0; k < grandchildCount; ++k)
+                    {
+                        jobSystem.Run([&]()
+                        {
+                            finishedGrandchildren.fetch_add(1);
+                            jobs.fetch_add(1);
+                        }, &grandchildren);
+                    }
+                    jobSystem.Wait(grandchildren);
+
+                    if (finishedGrandchildren != grandchildCount)
+                        earlyChildren.fetch_add(1);
+                    finishedChildren[i].fetch_add(1);
+                    jobs.fetch_add(1);
+                }, &children);
+            }
+            jobSystem.Wait(children);
+
+            seenChildren[i] = finishedChildren[i];
+            jobs.fetch_add(1);
+        }, &parents);
+    }
+    jobSystem.Wait(parents);
+
+    CHECK(earlyChildren == 0);
+    for (unsigned i = 0; i < parentCount; ++i)
+        CHECK(seenChildren[i] == childCount);
+    CHECK(jobs == parentCount * (1 + childCount * (1 + grandchildCount)));
+}
+
+TEST(JobSystemTest, WorkersStealQueuedJobs)
+{
+    JobSystem jobSystem(3);
+
+    // Jobs queued by the calling thread are on its own queue, so any worker that runs one has stolen it. The jobs
+    // sleep to let the workers be scheduled even on a single core
+    const unsigned jobCount = 32;
+    std::atomic<unsigned> workerJobs{};
+    JobCounter counter;
+    for (unsigned i = 0; i < jobCount; ++i)
+    {
+        jobSystem.Run([&workerJobs]()
+        {
+            if (JobSystem::GetThreadIndex())
+                workerJobs.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }, &counter);
+    }
+    jobSystem.Wait(counter);
+
+    CHECK(workerJobs > 0);
+    CHECK(jobSystem.GetStealCount() >= workerJobs);
+    CHECK(JobSystem::GetThreadIndex() == 0);
+}
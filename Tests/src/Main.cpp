@@ -0,0 +1,62 @@
+#include "Test.h"
+
+#include <cstring>
+#include <vector>
+
+
+/// Registered test
+struct TestCase
+{
+    /// Suite
+    char const* suite_;
+    /// Name
+    char const* name_;
+    /// Function
+    TestFunction function_;
+};
+
+/// Return the registered tests, constructed on first use as registrars run before main.
+static std::vector<TestCase>& GetTests()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+/// Failed checks of the running test
+static unsigned failures = 0;
+
+TestRegistrar::TestRegistrar(char const* suite, char const* name, TestFunction function)
+{
+    GetTests().push_back({ suite, name, function });
+}
+
+void ReportFailure(char const* file, int line, char const* expression)
+{
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++failures;
+}
+
+/// Run the tests of the suites named on the command line, all without arguments. Return the number that failed.
+int main(int argc, char** argv)
+{
+    unsigned run = 0;
+    unsigned failed = 0;
+    for (TestCase const& test : GetTests())
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            selected |= !strcmp(argv[i], test.suite_);
+        if (!selected)
+            continue;
+
+        failures = 0;
+        test.function_();
+        ++run;
+        if (failures)
+            ++failed;
+        printf("%s %s.%s\n", failures ? "FAILED" : "passed", test.suite_, test.name_);
+    }
+
+    printf("%u tests, %u failed\n", run, failed);
+    return run ? (int) failed : 1;
+}
@@ -0,0 +1,187 @@
+#include "JobSystem.h"
+#include "OcclusionBuffer.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+
+/// Half size of the wall occluder.
+static const float WallHalfSize = 5.0f;
+/// Distance of the wall from the camera.
+static const float WallDistance = 10.0f;
+
+/// Return the view-projection of a camera at the origin looking along +Z, matching the default buffer aspect.
+static Matrix4 GetViewProjection()
+{
+    Matrix4 view = Matrix4::LookAt(Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 1.0f, 0.0f));
+    return view * Matrix4::Perspective(1.0f, 2.0f, 0.1f, 100.0f);
+}
+
+/// Add a square wall facing the camera.
+static void AddWall(OcclusionBuffer& buffer)
+{
+    std::vector<Vector3> vertices{
+        Vector3(-WallHalfSize, -WallHalfSize, WallDistance),
+        Vector3(WallHalfSize, -WallHalfSize, WallDistance),
+        Vector3(WallHalfSize, WallHalfSize, WallDistance),
+        Vector3(-WallHalfSize, WallHalfSize, WallDistance) };
+    buffer.AddOccluder(vertices, std::vector<unsigned>{ 0, 1, 2, 0, 2, 3 });
+}
+
+/// Return whether a point is hidden by the wall: behind it and on a ray from the camera through it.
+static bool IsBehindWall(Vector3 const& point)
+{
+    float scale = WallDistance / point.z_;
+    return point.z_ >= WallDistance && std::abs(point.x_ * scale) <= WallHalfSize && std::abs(point.y_ * scale) <= WallHalfSize;
+}
+
+/// Return whether a box is hidden by the wall. The hidden region is convex, so it holds when all corners are.
+static bool IsBoxBehindWall(BoundingBox const& box)
+{
+    Vector3 min = box.GetMin();
+    Vector3 max = box.GetMax();
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        Vector3 corner((i & 1) ? max.x_ : min.x_, (i & 2) ? max.y_ : min.y_, (i & 4) ? max.z_ : min.z_);
+        if (!IsBehindWall(corner))
+            return false;
+    }
+    return true;
+}
+
+/// Return a random float in a range.
+static float Random(float min, float max)
+{
+    return min + (max - min) * (float) rand() / (float) RAND_MAX;
+}
+
+TEST(OcclusionBufferTest, CullsBoxesBehindOccluder)
+{
+    OcclusionBuffer buffer;
+    AddWall(buffer);
+    buffer.Render(GetViewProjection());
+    CHECK(buffer.GetStats().occluders_ == 1);
+    CHECK(buffer.GetStats().triangles_ == 2);
+
+    CHECK(!buffer.IsVisible(BoundingBox(Vector3(0.0f, 0.0f, 20.0f), Vector3(1.0f, 1.0f, 1.0f))));
+    // In front of the wall, beside it, and straddling its silhouette
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(0.0f, 0.0f, 5.0f), Vector3(1.0f, 1.0f, 1.0f))));
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(30.0f, 0.0f, 20.0f), Vector3(1.0f, 1.0f, 1.0f))));
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(10.0f, 0.0f, 20.0f), Vector3(1.0f, 1.0f, 1.0f))));
+    // Crossing the wall plane, and around the camera
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(0.0f, 0.0f, 10.0f), Vector3(1.0f, 1.0f, 1.0f))));
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f))));
+}
+
+TEST(OcclusionBufferTest, EverythingVisibleWithoutOccluders)
+{
+    OcclusionBuffer buffer;
+    buffer.Render(GetViewProjection());
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(0.0f, 0.0f, 50.0f), Vector3(1.0f, 1.0f, 1.0f))));
+}
+
+TEST(OcclusionBufferTest, PyramidKeepsFurthestDepth)
+{
+    OcclusionBuffer buffer;
+    AddWall(buffer);
+    buffer.Render(GetViewProjection());
+    REQUIRE(buffer.GetLevelCount() > 1);
+
+    for (unsigned level = 1; level < buffer.GetLevelCount(); ++level)
+    {
+        unsigned width = buffer.GetWidth() >> level;
+        unsigned height = buffer.GetHeight() >> level;
+        unsigned parentWidth = width * 2;
+        float const* depth = buffer.GetDepth(level);
+        float const* parent = buffer.GetDepth(level - 1);
+
+        for (unsigned y = 0; y < height; ++y)
+        {
+            for (unsigned x = 0; x < width; ++x)
+            {
+                float furthest = std::max(std::max(parent[(y * 2) * parentWidth + x * 2], parent[(y * 2) * parentWidth + x * 2 + 1]),
+                    std::max(parent[(y * 2 + 1) * parentWidth + x * 2], parent[(y * 2 + 1) * parentWidth + x * 2 + 1]));
+                REQUIRE(depth[y * width + x] == furthest);
+            }
+        }
+    }
+}
+
+TEST(OcclusionBufferTest, NeverCullsVisibleBoxes)
+{
+    // Compare against the exact region the wall hides: culling must be a subset of it, and catch most of it
+    OcclusionBuffer buffer;
+    AddWall(buffer);
+    buffer.Render(GetViewProjection());
+
+    unsigned const count = 4000;
+    BoundsArray boxes;
+    boxes.Resize(count);
+    std::vector<unsigned> ids(count);
+    srand(2024);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        Vector3 center(Random(-15.0f, 15.0f), Random(-10.0f, 10.0f), Random(-5.0f, 60.0f));
+        Vector3 extents(Random(0.05f, 3.0f), Random(0.05f, 3.0f), Random(0.05f, 3.0f));
+        boxes.Set(i, BoundingBox(center, extents));
+        ids[i] = i;
+    }
+
+    std::vector<unsigned> visible;
+    buffer.Cull(boxes, ids, visible);
+    std::vector<bool> isVisible(count, false);
+    for (unsigned id : visible)
+        isVisible[id] = true;
+
+    unsigned hidden = 0;
+    unsigned culled = 0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        BoundingBox box = boxes.Get(i);
+        bool behindWall = IsBoxBehindWall(box);
+        REQUIRE(isVisible[i] || behindWall);
+        CHECK(isVisible[i] == buffer.IsVisible(box));
+        if (behindWall)
+            ++hidden;
+        if (!isVisible[i])
+            ++culled;
+    }
+    CHECK(hidden > 100);
+    CHECK(culled * 4 >= hidden * 3);
+    CHECK(buffer.GetStats().occluded_ == culled);
+}
+
+TEST(OcclusionBufferTest, JobsMatchSingleThread)
+{
+    OcclusionBuffer single;
+    OcclusionBuffer threaded;
+    JobSystem jobSystem(3);
+    threaded.SetJobSystem(&jobSystem);
+    AddWall(single);
+    AddWall(threaded);
+    // A second occluder crossing the near plane exercises clipping
+    std::vector<Vector3> floor{ Vector3(-20.0f, -2.0f, -5.0f), Vector3(20.0f, -2.0f, -5.0f), Vector3(0.0f, -2.0f, 40.0f) };
+    single.AddOccluder(floor, std::vector<unsigned>{ 0, 2, 1 });
+    threaded.AddOccluder(floor, std::vector<unsigned>{ 0, 2, 1 });
+
+    single.Render(GetViewProjection());
+    threaded.Render(GetViewProjection());
+    CHECK(single.GetStats().clippedTriangles_ == 1);
+    CHECK(threaded.GetStats().triangles_ == single.GetStats().triangles_);
+
+    for (unsigned level = 0; level < single.GetLevelCount(); ++level)
+    {
+        unsigned size = (single.GetWidth() >> level) * (single.GetHeight() >> level);
+        REQUIRE(std::equal(single.GetDepth(level), single.GetDepth(level) + size, threaded.GetDepth(level)));
+    }
+}
+
+TEST(OcclusionBufferTest, RejectsInvalidSize)
+{
+    OcclusionBuffer buffer;
+    CHECK(!buffer.SetSize(100, 128));
+    CHECK(!buffer.SetSize(16, 16));
+    CHECK(buffer.SetSize(512, 256));
+    CHECK(buffer.GetWidth() == 512);
+}
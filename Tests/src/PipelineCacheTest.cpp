@@ -0,0 +1,299 @@
+#include "ByteStream.h"
+#include "JobSystem.h"
+#include "NullPipelineStateFactory.h"
+#include "PipelineCache.h"
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+
+
+/// Cache file written by the tests, in the working directory.
+static const char* cacheFileName = "PipelineCacheTest.cache";
+
+/// Fill in a pipeline description. Variant changes the vertex shader.
+static void SetupDesc(PipelineDesc& desc, uint8_t variant)
+{
+    desc.rootSignature_ = { 1, 2, 3, 4 };
+    desc.vertexShader_ = { 0x44, 0x58, 0x42, 0x43, variant };
+    desc.pixelShader_ = { 0x44, 0x58, 0x42, 0x43, 0xff };
+    desc.inputLayout_.resize(2);
+    desc.inputLayout_[0].semantic_ = "POSITION";
+    desc.inputLayout_[0].format_ = 6;
+    desc.inputLayout_[1].semantic_ = "TEXCOORD";
+    desc.inputLayout_[1].format_ = 16;
+    desc.inputLayout_[1].offset_ = 12;
+    desc.renderTargetFormats_[0] = 28;
+    desc.renderTargetCount_ = 1;
+    desc.depthStencilFormat_ = 40;
+    desc.blendMode_ = PIPELINE_BLEND_ALPHA;
+    desc.depthWrite_ = false;
+}
+
+/// Return a pipeline description.
+static PipelineDesc MakeDesc(uint8_t variant)
+{
+    PipelineDesc desc;
+    SetupDesc(desc, variant);
+    return desc;
+}
+
+/// Return a serialized cache of a few compiled pipelines.
+static std::vector<uint8_t> MakeCacheData(NullPipelineStateFactory& factory)
+{
+    PipelineCache cache;
+    cache.Initialize(factory);
+    for (uint8_t i = 0; i < 3; ++i)
+        cache.Request(MakeDesc(i));
+
+    std::vector<uint8_t> data;
+    cache.Serialize(data);
+    return data;
+}
+
+/// Return whether a fresh cache accepts serialized data.
+static bool Accepts(NullPipelineStateFactory& factory, std::vector<uint8_t> const& data)
+{
+    PipelineCache cache;
+    cache.Initialize(factory);
+    bool accepted = cache.Deserialize(data.data(), data.size());
+    CHECK(accepted || cache.GetCachedBlobCount() == 0);
+    return accepted;
+}
+
+/// Replace the checksum at the end of serialized data to match its contents.
+static void UpdateChecksum(std::vector<uint8_t>& data)
+{
+    data.resize(data.size() - 8);
+    uint64_t checksum = HashContent(data.data(), data.size()).low_;
+    ByteWriter writer(data);
+    writer.WriteU64(checksum);
+}
+
+TEST(PipelineCacheTest, KeyIsStable)
+{
+    // The key of a fixed description must not change between builds, hosts or compilers, or every saved cache
+    // goes stale. Update the expected value only together with PipelineCacheVersion
+    ContentHash hash = PipelineCache::HashDesc(MakeDesc(0));
+    CHECK(hash.ToString() == "482ca2a12e486184d33d20aea92b5047");
+    CHECK(PipelineCache::HashDesc(MakeDesc(0)) == hash);
+
+    // Copies live at other addresses with other capacities
+    PipelineDesc copy = MakeDesc(0);
+    copy.vertexShader_.reserve(1024);
+    copy.inputLayout_.reserve(16);
+    PipelineDesc moved(std::move(copy));
+    CHECK(PipelineCache::HashDesc(moved) == hash);
+}
+
+TEST(PipelineCacheTest, KeyIgnoresPaddingAndUnusedFormats)
+{
+    // The same description built over memory of different contents, so any padding differs
+    alignas(PipelineDesc) unsigned char zeros[sizeof(PipelineDesc)];
+    alignas(PipelineDesc) unsigned char ones[sizeof(PipelineDesc)];
+    memset(zeros, 0, sizeof zeros);
+    memset(ones, 0xff, sizeof ones);
+    PipelineDesc* lhs = new (zeros) PipelineDesc();
+    PipelineDesc* rhs = new (ones) PipelineDesc();
+    SetupDesc(*lhs, 0);
+    SetupDesc(*rhs, 0);
+    CHECK(PipelineCache::HashDesc(*lhs) == PipelineCache::HashDesc(*rhs));
+
+    // Formats past the render target count are not used
+    rhs->renderTargetFormats_[5] = 2;
+    CHECK(PipelineCache::HashDesc(*lhs) == PipelineCache::HashDesc(*rhs));
+    lhs->~PipelineDesc();
+    rhs->~PipelineDesc();
+}
+
+TEST(PipelineCacheTest, KeyCoversEveryField)
+{
+    ContentHash hash = PipelineCache::HashDesc(MakeDesc(0));
+    PipelineDesc desc;
+
+    desc = MakeDesc(1);
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+    desc = MakeDesc(0);
+    desc.rootSignature_.clear();
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+    desc = MakeDesc(0);
+    desc.inputLayout_[1].semantic_ = "NORMAL";
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+    desc = MakeDesc(0);
+    desc.inputLayout_[1].offset_ = 16;
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+    desc = MakeDesc(0);
+    desc.renderTargetFormats_[0] = 29;
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+    desc = MakeDesc(0);
+    desc.renderTargetCount_ = 2;
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+    desc = MakeDesc(0);
+    desc.blendMode_ = PIPELINE_BLEND_ADD;
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+    desc = MakeDesc(0);
+    desc.cullMode_ = 1;
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+    desc = MakeDesc(0);
+    desc.depthWrite_ = true;
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+
+    // Bytes moved from one shader to the next must not collide
+    desc = MakeDesc(0);
+    desc.vertexShader_.push_back(desc.pixelShader_.front());
+    desc.pixelShader_.erase(desc.pixelShader_.begin());
+    CHECK(PipelineCache::HashDesc(desc) != hash);
+}
+
+TEST(PipelineCacheTest, DeduplicatesIdenticalRequests)
+{
+    NullPipelineStateFactory factory;
+    PipelineCache cache;
+    cache.Initialize(factory);
+
+    PipelineCache::PipelineId first = cache.Request(MakeDesc(0));
+    PipelineCache::PipelineId second = cache.Request(MakeDesc(1));
+    CHECK(first != second);
+    CHECK(cache.Request(MakeDesc(0)) == first);
+    CHECK(cache.Request(MakeDesc(1)) == second);
+    CHECK(cache.GetPipelineCount() == 2);
+    CHECK(factory.GetCompileCount() == 2);
+    CHECK(cache.GetStats().requests_ == 4);
+    CHECK(cache.GetStats().deduplicated_ == 2);
+    CHECK(cache.IsReady(first));
+    CHECK(cache.GetPipelineState(first) != nullptr);
+    CHECK(cache.GetPipelineState(first) != cache.GetPipelineState(second));
+
+    cache.Shutdown();
+    CHECK(factory.GetPipelineStateCount() == 0);
+}
+
+TEST(PipelineCacheTest, DeduplicatesConcurrentRequests)
+{
+    NullPipelineStateFactory factory;
+    factory.SetCompileTime(std::chrono::microseconds(200));
+    JobSystem jobSystem(3);
+    PipelineCache cache;
+    cache.Initialize(factory, &jobSystem);
+
+    // Requests from several threads at once, each description many times
+    const unsigned requestCount = 256;
+    std::vector<PipelineCache::PipelineId> ids(requestCount);
+    jobSystem.ParallelFor(requestCount, 1, [&cache, &ids](unsigned begin, unsigned end)
+    {
+        for (unsigned i = begin; i < end; ++i)
+            ids[i] = cache.Request(MakeDesc((uint8_t) (i % 8)));
+    });
+
+    for (unsigned i = 0; i < requestCount; ++i)
+    {
+        CHECK(ids[i] == ids[i % 8]);
+        CHECK(cache.WaitPipelineState(ids[i]) != nullptr);
+    }
+    CHECK(cache.GetPipelineCount() == 8);
+    CHECK(factory.GetCompileCount() == 8);
+    CHECK(cache.GetStats().deduplicated_ == requestCount - 8);
+}
+
+TEST(PipelineCacheTest, WarmRunCompilesNothing)
+{
+    NullPipelineStateFactory factory;
+    {
+        PipelineCache cache;
+        cache.Initialize(factory);
+        for (uint8_t i = 0; i < 4; ++i)
+            cache.Request(MakeDesc(i));
+        CHECK(cache.GetStats().compiled_ == 4);
+        REQUIRE(cache.Save(cacheFileName));
+    }
+
+    unsigned compiles = factory.GetCompileCount();
+    {
+        PipelineCache cache;
+        cache.Initialize(factory);
+        REQUIRE(cache.Load(cacheFileName));
+        CHECK(cache.GetCachedBlobCount() == 4);
+        for (uint8_t i = 0; i < 4; ++i)
+            CHECK(cache.GetPipelineState(cache.Request(MakeDesc(i))) != nullptr);
+
+        CHECK(factory.GetCompileCount() == compiles);
+        CHECK(factory.GetCachedCreateCount() == 4);
+        CHECK(cache.GetStats().warmStarted_ == 4);
+        CHECK(cache.GetStats().compiled_ == 0);
+
+        // A new description still compiles, and loaded blobs that were not requested are saved again
+        cache.Request(MakeDesc(9));
+        CHECK(factory.GetCompileCount() == compiles + 1);
+        std::vector<uint8_t> data;
+        cache.Serialize(data);
+
+        PipelineCache reloaded;
+        reloaded.Initialize(factory);
+        REQUIRE(reloaded.Deserialize(data.data(), data.size()));
+        CHECK(reloaded.GetCachedBlobCount() == 5);
+    }
+
+    remove(cacheFileName);
+}
+
+TEST(PipelineCacheTest, SerializationIsDeterministic)
+{
+    NullPipelineStateFactory factory;
+    std::vector<uint8_t> data = MakeCacheData(factory);
+    CHECK(MakeCacheData(factory) == data);
+}
+
+TEST(PipelineCacheTest, RejectsBadFiles)
+{
+    NullPipelineStateFactory factory;
+    std::vector<uint8_t> data = MakeCacheData(factory);
+    CHECK(Accepts(factory, data));
+
+    // Magic and version, with a valid checksum so only the header check can fail
+    std::vector<uint8_t> badMagic = data;
+    badMagic[0] ^= 1;
+    UpdateChecksum(badMagic);
+    CHECK(!Accepts(factory, badMagic));
+
+    std::vector<uint8_t> badVersion = data;
+    badVersion[4] += 1;
+    UpdateChecksum(badVersion);
+    CHECK(!Accepts(factory, badVersion));
+
+    // Blobs of another device or driver
+    NullPipelineStateFactory otherDevice;
+    otherDevice.SetDeviceId(2);
+    CHECK(!Accepts(otherDevice, data));
+
+    // Any flipped byte breaks the checksum
+    unsigned accepted = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        std::vector<uint8_t> corrupt = data;
+        corrupt[i] ^= 0x10;
+        accepted += Accepts(factory, corrupt);
+    }
+    CHECK(accepted == 0);
+
+    // A file cut short anywhere, also with the checksum fixed up so the reader meets the end
+    unsigned truncatedAccepted = 0;
+    for (size_t size = 0; size < data.size(); ++size)
+    {
+        std::vector<uint8_t> truncated(data.begin(), data.begin() + size);
+        truncatedAccepted += Accepts(factory, truncated);
+        if (size >= 8)
+        {
+            UpdateChecksum(truncated);
+            truncatedAccepted += Accepts(factory, truncated);
+        }
+    }
+    CHECK(truncatedAccepted == 0);
+
+    // Missing file
+    PipelineCache cache;
+    cache.Initialize(factory);
+    remove(cacheFileName);
+    CHECK(!cache.Load(cacheFileName));
+}
@@ -0,0 +1,211 @@
+#include "NullGraphicsBackend.h"
+#include "NullTransientResourceFactory.h"
+#include "RenderGraph.h"
+#include "Test.h"
+
+#include <string>
+#include <vector>
+
+
+/// Description of a 256x256 render target.
+static TextureDesc MakeDesc()
+{
+    TextureDesc desc;
+    desc.width_ = 256;
+    desc.height_ = 256;
+    return desc;
+}
+
+/// Build a chain of three transient textures ending in an imported back buffer, plus a pass nobody reads.
+static void BuildChain(RenderGraph& graph, ResourceHandle backBuffer, std::vector<std::string>& executed)
+{
+    RenderGraphResource output = graph.Import("BackBuffer", backBuffer, RESOURCE_STATE_PRESENT);
+    RenderGraphResource gbuffer = INVALID_RENDER_GRAPH_RESOURCE;
+    RenderGraphResource lit = INVALID_RENDER_GRAPH_RESOURCE;
+    RenderGraphResource post = INVALID_RENDER_GRAPH_RESOURCE;
+
+    auto record = [&executed](std::string const& name) { return [&executed, name](RenderGraphContext&) { executed.push_back(name); }; };
+
+    graph.AddPass("GBuffer", [&](RenderGraphBuilder& builder)
+    {
+        gbuffer = builder.Write(builder.CreateTexture("GBuffer", MakeDesc()));
+    }, record("GBuffer"));
+    graph.AddPass("Unused", [&](RenderGraphBuilder& builder)
+    {
+        RenderGraphResource unused = builder.Write(builder.CreateTexture("Unused", MakeDesc()));
+        builder.Read(gbuffer);
+        (void) unused;
+    }, record("Unused"));
+    graph.AddPass("Lighting", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(gbuffer);
+        lit = builder.Write(builder.CreateTexture("Lit", MakeDesc()));
+    }, record("Lighting"));
+    graph.AddPass("Post", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(lit);
+        post = builder.Write(builder.CreateTexture("Post", MakeDesc()));
+    }, record("Post"));
+    graph.AddPass("Final", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(post);
+        builder.Write(output);
+    }, record("Final"));
+}
+
+TEST(RenderGraphTest, CullsUnusedPasses)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullTransientResourceFactory factory(backend.GetStateRegistry());
+    std::vector<std::string> executed;
+    RenderGraph graph;
+    BuildChain(graph, (ResourceHandle) (uintptr_t) 0x100, executed);
+
+    REQUIRE(graph.Compile(factory));
+    CHECK(graph.GetStats().passes_ == 5);
+    CHECK(graph.GetStats().culledPasses_ == 1);
+    REQUIRE(graph.GetPassOrder().size() == 4);
+    CHECK(graph.GetPassName(graph.GetPassOrder()[0]) == "GBuffer");
+    CHECK(graph.GetPassName(graph.GetPassOrder()[3]) == "Final");
+}
+
+TEST(RenderGraphTest, KeepsSideEffectPasses)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullTransientResourceFactory factory(backend.GetStateRegistry());
+    RenderGraph graph;
+    graph.AddPass("Readback", [](RenderGraphBuilder& builder)
+    {
+        builder.Write(builder.CreateTexture("Scratch", MakeDesc()));
+        builder.SetSideEffect();
+    }, nullptr);
+    graph.AddPass("Dead", [](RenderGraphBuilder& builder)
+    {
+        builder.Write(builder.CreateTexture("Dead", MakeDesc()));
+    }, nullptr);
+
+    REQUIRE(graph.Compile(factory));
+    CHECK(graph.GetStats().culledPasses_ == 1);
+    REQUIRE(graph.GetPassOrder().size() == 1);
+    CHECK(graph.GetPassName(graph.GetPassOrder()[0]) == "Readback");
+}
+
+TEST(RenderGraphTest, OrdersByDependencies)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullTransientResourceFactory factory(backend.GetStateRegistry());
+    RenderGraph graph;
+    RenderGraphResource output = graph.Import("Output", (ResourceHandle) (uintptr_t) 0x100, RESOURCE_STATE_COMMON);
+    RenderGraphResource shadow = INVALID_RENDER_GRAPH_RESOURCE;
+
+    // The consumer reads what the producer declared before it, and a later write waits for the read
+    graph.AddPass("Shadow", [&](RenderGraphBuilder& builder)
+    {
+        shadow = builder.Write(builder.CreateTexture("Shadow", MakeDesc()), RESOURCE_STATE_DEPTH_WRITE);
+    }, nullptr);
+    graph.AddPass("Scene", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(shadow);
+        builder.Write(output);
+    }, nullptr);
+    graph.AddPass("Overwrite", [&](RenderGraphBuilder& builder)
+    {
+        builder.Write(shadow, RESOURCE_STATE_DEPTH_WRITE);
+        builder.Write(output);
+    }, nullptr);
+
+    REQUIRE(graph.Compile(factory));
+    std::vector<unsigned> const& order = graph.GetPassOrder();
+    REQUIRE(order.size() == 3);
+    CHECK(graph.GetPassName(order[0]) == "Shadow");
+    CHECK(graph.GetPassName(order[1]) == "Scene");
+    CHECK(graph.GetPassName(order[2]) == "Overwrite");
+}
+
+TEST(RenderGraphTest, AliasesDisjointLifetimes)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullTransientResourceFactory factory(backend.GetStateRegistry());
+    std::vector<std::string> executed;
+    RenderGraph graph;
+    BuildChain(graph, (ResourceHandle) (uintptr_t) 0x100, executed);
+    REQUIRE(graph.Compile(factory));
+
+    uint64_t size;
+    uint64_t alignment;
+    factory.GetAllocationInfo(MakeDesc(), size, alignment);
+
+    // GBuffer and Post are never alive at the same time, Lit overlaps both
+    RenderGraphStats const& stats = graph.GetStats();
+    CHECK(stats.transientTextures_ == 3);
+    CHECK(stats.transientSize_ == 3 * size);
+    CHECK(stats.transientHeapSize_ == 2 * size);
+    CHECK(stats.aliasingBarriers_ == 1);
+}
+
+TEST(RenderGraphTest, ExecutesWithMinimalBarriers)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullTransientResourceFactory factory(backend.GetStateRegistry());
+    ResourceHandle backBuffer = (ResourceHandle) (uintptr_t) 0x100;
+    backend.GetStateRegistry().RegisterResource(backBuffer, 1, RESOURCE_STATE_PRESENT);
+
+    std::vector<std::string> executed;
+    RenderGraph graph;
+    BuildChain(graph, backBuffer, executed);
+    REQUIRE(graph.Compile(factory));
+
+    // Each transient texture goes from render target to shader resource once, and the back buffer to render target
+    CHECK(graph.GetStats().barriers_ == 4);
+
+    backend.Begin();
+    backend.ClearRecording();
+    graph.Execute(backend, factory);
+    REQUIRE(executed.size() == 4);
+    CHECK(executed[0] == "GBuffer");
+    CHECK(executed[1] == "Lighting");
+    CHECK(executed[2] == "Post");
+    CHECK(executed[3] == "Final");
+    CHECK(factory.GetCreatedTextureCount() == 3);
+    // The textures are created in the state of their first use, so only the compiled barriers and the aliasing one remain
+    CHECK(backend.GetCommandCount(RECORD_RESOURCE_BARRIER) == 5);
+    backend.End();
+
+    // Textures are cached across frames
+    RenderGraph next;
+    executed.clear();
+    BuildChain(next, backBuffer, executed);
+    REQUIRE(next.Compile(factory));
+    backend.Begin();
+    next.Execute(backend, factory);
+    backend.End();
+    CHECK(factory.GetCreatedTextureCount() == 3);
+}
+
+TEST(RenderGraphTest, CombinesReadStates)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullTransientResourceFactory factory(backend.GetStateRegistry());
+    RenderGraph graph;
+    RenderGraphResource output = graph.Import("Output", (ResourceHandle) (uintptr_t) 0x100, RESOURCE_STATE_RENDER_TARGET);
+    RenderGraphResource depth = INVALID_RENDER_GRAPH_RESOURCE;
+
+    graph.AddPass("Depth", [&](RenderGraphBuilder& builder)
+    {
+        depth = builder.Write(builder.CreateTexture("Depth", MakeDesc()), RESOURCE_STATE_DEPTH_WRITE);
+    }, nullptr);
+    graph.AddPass("Compute", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(depth, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        builder.Write(output);
+    }, nullptr);
+    graph.AddPass("Pixel", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(depth, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        builder.Write(output);
+    }, nullptr);
+
+    // Both readers are served by one barrier into the combined read state
+    REQUIRE(graph.Compile(factory));
+    CHECK(graph.GetStats().barriers_ == 1);
+}
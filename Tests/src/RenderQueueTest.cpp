@@ -0,0 +1,252 @@
+#include "JobSystem.h"
+#include "NullGraphicsBackend.h"
+#include "RenderQueue.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+
+/// Largest value of the depth field.
+static const uint64_t maxDepthField = (1ull << RenderQueue::DepthBits) - 1;
+
+/// Return the depth field of a key.
+static uint64_t GetDepthField(uint64_t key, bool translucent)
+{
+    unsigned shift = translucent ? 64 - RenderQueue::PassBits - 1 - RenderQueue::DepthBits : 3;
+    return (key >> shift) & maxDepthField;
+}
+
+/// Return a key with its depth field cleared.
+static uint64_t ClearDepthField(uint64_t key, bool translucent)
+{
+    unsigned shift = translucent ? 64 - RenderQueue::PassBits - 1 - RenderQueue::DepthBits : 3;
+    return key & ~(maxDepthField << shift);
+}
+
+TEST(RenderQueueTest, KeyDepthStaysInField)
+{
+    float const nan = std::numeric_limits<float>::quiet_NaN();
+    float const inf = std::numeric_limits<float>::infinity();
+
+    for (bool translucent : { false, true })
+    {
+        uint64_t reference = ClearDepthField(RenderQueue::MakeSortKey(5, translucent, 40, 7, 0.5f), translucent);
+        CHECK(reference == ClearDepthField(RenderQueue::MakeSortKey(5, translucent, 40, 7, 0.0f), translucent));
+
+        // Opaque depth maps onto the field directly, translucent depth reversed
+        uint64_t nearField = translucent ? maxDepthField : 0;
+        uint64_t farField = translucent ? 0 : maxDepthField;
+        CHECK(GetDepthField(RenderQueue::MakeSortKey(5, translucent, 40, 7, 0.0f), translucent) == nearField);
+        CHECK(GetDepthField(RenderQueue::MakeSortKey(5, translucent, 40, 7, 1.0f), translucent) == farField);
+
+        // Depth at and beyond the far end must never carry into or borrow from the other fields
+        float const depths[] = { 1.0f, 0.99999994f, 1.5f, 1e30f, inf, -0.0f, -1.0f, -inf, nan };
+        for (float depth : depths)
+        {
+            uint64_t key = RenderQueue::MakeSortKey(5, translucent, 40, 7, depth);
+            CHECK(ClearDepthField(key, translucent) == reference);
+        }
+        CHECK(GetDepthField(RenderQueue::MakeSortKey(5, translucent, 40, 7, 2.0f), translucent) == farField);
+        CHECK(GetDepthField(RenderQueue::MakeSortKey(5, translucent, 40, 7, -2.0f), translucent) == nearField);
+        CHECK((RenderQueue::MakeSortKey(5, translucent, 40, 7, 1.0f) & 7) == 0);
+    }
+}
+
+TEST(RenderQueueTest, KeysOrderDraws)
+{
+    // Passes first, then opaque before translucent
+    CHECK(RenderQueue::MakeSortKey(0, true, 99, 99, 1.0f) < RenderQueue::MakeSortKey(1, false, 0, 0, 0.0f));
+    CHECK(RenderQueue::MakeSortKey(0, false, 99, 99, 1.0f) < RenderQueue::MakeSortKey(0, true, 0, 0, 0.0f));
+    // Opaque by pipeline, material, then front to back
+    CHECK(RenderQueue::MakeSortKey(0, false, 1, 99, 1.0f) < RenderQueue::MakeSortKey(0, false, 2, 0, 0.0f));
+    CHECK(RenderQueue::MakeSortKey(0, false, 1, 1, 1.0f) < RenderQueue::MakeSortKey(0, false, 1, 2, 0.0f));
+    CHECK(RenderQueue::MakeSortKey(0, false, 1, 1, 0.25f) < RenderQueue::MakeSortKey(0, false, 1, 1, 0.75f));
+    // Translucent back to front regardless of state
+    CHECK(RenderQueue::MakeSortKey(0, true, 9, 9, 0.75f) < RenderQueue::MakeSortKey(0, true, 1, 1, 0.25f));
+    CHECK(RenderQueue::MakeSortKey(0, true, 9, 9, 1.0f) < RenderQueue::MakeSortKey(0, true, 1, 1, 0.99f));
+}
+
+/// Fill a queue with random keys and return them.
+static std::vector<uint64_t> AddRandomDraws(RenderQueue& queue, unsigned count)
+{
+    std::vector<uint64_t> keys(count);
+    srand(77);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        // Few distinct keys so stability matters
+        keys[i] = RenderQueue::MakeSortKey(rand() % 4, (rand() & 1) != 0, rand() % 8, rand() % 8, (float) (rand() % 16) / 15.0f);
+        queue.Add(keys[i], DrawPacket());
+    }
+    return keys;
+}
+
+/// Check that an order sorts keys stably.
+static void CheckSorted(std::vector<uint64_t> const& keys, std::vector<unsigned> const& order)
+{
+    std::vector<unsigned> expected(keys.size());
+    for (unsigned i = 0; i < expected.size(); ++i)
+        expected[i] = i;
+    std::stable_sort(expected.begin(), expected.end(), [&keys](unsigned lhs, unsigned rhs) { return keys[lhs] < keys[rhs]; });
+    CHECK(order == expected);
+}
+
+TEST(RenderQueueTest, SortsStably)
+{
+    RenderQueue queue;
+    std::vector<uint64_t> keys = AddRandomDraws(queue, 5000);
+    queue.Sort();
+    CheckSorted(keys, queue.GetOrder());
+    CHECK(queue.GetStats().sortJobs_ == 0);
+}
+
+TEST(RenderQueueTest, SkipsSharedDigits)
+{
+    // Opaque draws of one pass at one depth differ only in the digits holding the low pipeline and material bits
+    RenderQueue queue;
+    std::vector<uint64_t> keys;
+    srand(5);
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        keys.push_back(RenderQueue::MakeSortKey(0, false, rand() % 8, rand() % 8, 0.0f));
+        queue.Add(keys.back(), DrawPacket());
+    }
+    queue.Sort();
+    CheckSorted(keys, queue.GetOrder());
+    CHECK(queue.GetStats().sortPasses_ == 2);
+}
+
+TEST(RenderQueueTest, SortsWithJobs)
+{
+    JobSystem jobSystem(3);
+    RenderQueue queue;
+    queue.SetJobSystem(&jobSystem);
+    std::vector<uint64_t> keys = AddRandomDraws(queue, RenderQueue::MinSortBatchSize * 4 + 123);
+    queue.Sort();
+    CheckSorted(keys, queue.GetOrder());
+    CHECK(queue.GetStats().sortJobs_ > 1);
+}
+
+TEST(RenderQueueTest, SkipsRedundantBindings)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    NullCommandList commandList(backend);
+    commandList.Reset(0);
+
+    RenderQueue queue;
+    DrawPacket packet;
+    packet.pipelineState_ = (PipelineStateHandle) (uintptr_t) 0x100;
+    packet.descriptorTables_[0] = 0x1000;
+    packet.vertexBuffer_.gpuAddress_ = 0x2000;
+    packet.vertexCount_ = 3;
+
+    // Two pipelines, added interleaved; sorting groups them so each is bound once
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        DrawPacket draw = packet;
+        unsigned pipeline = i & 1;
+        draw.pipelineState_ = (PipelineStateHandle) (uintptr_t) (0x100 + pipeline * 0x100);
+        queue.Add(RenderQueue::MakeSortKey(0, false, pipeline, 0, (float) i / 8.0f), draw);
+    }
+    queue.Sort();
+    queue.Submit(commandList);
+
+    RenderQueueStats const& stats = queue.GetStats();
+    CHECK(stats.draws_ == 8);
+    CHECK(stats.pipelineStates_ == 2);
+    CHECK(stats.pipelineStatesSkipped_ == 6);
+    CHECK(stats.descriptorTables_ == 1);
+    CHECK(stats.vertexBuffers_ == 1);
+
+    unsigned draws = 0;
+    unsigned pipelineBinds = 0;
+    for (RecordedCommand const& command : commandList.GetRecordedCommands())
+    {
+        if (command.type_ == RECORD_DRAW)
+            ++draws;
+        else if (command.type_ == RECORD_SET_PIPELINE_STATE || command.type_ == RECORD_SET_ROOT_SIGNATURE)
+            ++pipelineBinds;
+    }
+    CHECK(draws == 8);
+    CHECK(pipelineBinds >= 2 && pipelineBinds <= 4);
+}
+
+/// Return draws recorded into a command list.
+static unsigned CountDraws(NullCommandList const& commandList)
+{
+    unsigned draws = 0;
+    for (RecordedCommand const& command : commandList.GetRecordedCommands())
+    {
+        if (command.type_ == RECORD_DRAW)
+            ++draws;
+    }
+    return draws;
+}
+
+TEST(RenderQueueTest, SubmitsRangesIntoCommandLists)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    JobSystem jobSystem(3);
+    RenderQueue queue;
+    queue.SetJobSystem(&jobSystem);
+
+    DrawPacket packet;
+    packet.pipelineState_ = (PipelineStateHandle) (uintptr_t) 0x100;
+    packet.vertexCount_ = 3;
+    unsigned const drawCount = RenderQueue::MinSubmitBatchSize * 3 + 5;
+    for (unsigned i = 0; i < drawCount; ++i)
+        queue.Add(RenderQueue::MakeSortKey(0, false, 0, 0, (float) i / drawCount), packet);
+    queue.Sort();
+
+    // Acquire runs on the recording threads
+    std::mutex mutex;
+    std::vector<std::unique_ptr<NullCommandList> > owned;
+    std::vector<CommandList*> commandLists;
+    queue.Submit([&]() -> CommandList*
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        owned.emplace_back(new NullCommandList(backend));
+        owned.back()->Reset(0);
+        return owned.back().get();
+    }, commandLists);
+
+    RenderQueueStats const& stats = queue.GetStats();
+    REQUIRE(commandLists.size() == 3);
+    CHECK(stats.commandLists_ == 3);
+    CHECK(stats.draws_ == drawCount);
+    // Every list starts with nothing bound, so binds the pipeline once
+    CHECK(stats.pipelineStates_ == 3);
+
+    // Lists come back in draw order, ranges rounded up so the last is shortest
+    unsigned const rangeSize = (drawCount + 2) / 3;
+    for (unsigned i = 0; i < commandLists.size(); ++i)
+    {
+        unsigned draws = CountDraws(*static_cast<NullCommandList*>(commandLists[i]));
+        CHECK(draws == (i < 2 ? rangeSize : drawCount - 2 * rangeSize));
+    }
+}
+
+TEST(RenderQueueTest, SubmitLeavesOutFailedAcquires)
+{
+    NullGraphicsBackend backend(64, 64, false);
+    RenderQueue queue;
+    queue.Add(RenderQueue::MakeSortKey(0, false, 0, 0, 0.0f), DrawPacket());
+    queue.Sort();
+
+    std::vector<CommandList*> commandLists;
+    queue.Submit([]() -> CommandList* { return nullptr; }, commandLists);
+    CHECK(commandLists.empty());
+    CHECK(queue.GetStats().commandLists_ == 0);
+    CHECK(queue.GetStats().draws_ == 0);
+
+    // Without a job system everything records into one list
+    NullCommandList commandList(backend);
+    commandList.Reset(0);
+    queue.Submit([&]() -> CommandList* { return &commandList; }, commandLists);
+    REQUIRE(commandLists.size() == 1);
+    CHECK(commandLists[0] == &commandList);
+    CHECK(CountDraws(commandList) == 1);
+}
@@ -0,0 +1,133 @@
+#include "NullResidencyBackend.h"
+#include "ResidencyManager.h"
+#include "Test.h"
+
+
+/// Return a distinct fake pageable object. The manager never dereferences objects.
+static void* FakeObject(unsigned index)
+{
+    return (void*) (uintptr_t) (0x1000 + index * 0x100);
+}
+
+TEST(ResidencyManagerTest, StaysWithinBudget)
+{
+    NullResidencyBackend backend;
+    backend.SetUsage(400);
+    backend.SetBudget(1000);
+    ResidencyManager manager;
+    manager.Initialize(backend);
+    for (unsigned i = 0; i < 4; ++i)
+        manager.Track(FakeObject(i), 100);
+
+    CHECK(manager.Commit(0));
+    CHECK(manager.GetStats().evictedObjects_ == 0);
+    CHECK(manager.GetStats().trackedSize_ == 400);
+    CHECK_NEAR(manager.GetStats().GetPressure(), 0.4f, 0.001f);
+}
+
+TEST(ResidencyManagerTest, EvictsLeastRecentlyUsed)
+{
+    NullResidencyBackend backend;
+    backend.SetUsage(400);
+    backend.SetBudget(300);
+    ResidencyManager manager;
+    manager.Initialize(backend);
+    for (unsigned i = 0; i < 4; ++i)
+        manager.Track(FakeObject(i), 100);
+
+    // Used in the order 2, 0, 3, 1 by work that has completed
+    manager.MarkUsed(FakeObject(2), 1);
+    manager.MarkUsed(FakeObject(0), 2);
+    manager.MarkUsed(FakeObject(3), 3);
+    manager.MarkUsed(FakeObject(1), 4);
+
+    // Down to 90% of the budget takes two evictions, in one call
+    CHECK(manager.Commit(4));
+    CHECK(!manager.IsResident(FakeObject(2)));
+    CHECK(!manager.IsResident(FakeObject(0)));
+    CHECK(manager.IsResident(FakeObject(3)));
+    CHECK(manager.IsResident(FakeObject(1)));
+    CHECK(manager.GetStats().evictedSize_ == 200);
+    CHECK(manager.GetStats().evictCalls_ == 1);
+    CHECK(backend.GetEvictedBytes() == 200);
+    CHECK(manager.GetStats().residentSize_ == 200);
+}
+
+TEST(ResidencyManagerTest, KeepsObjectsInUseByGpu)
+{
+    NullResidencyBackend backend;
+    backend.SetUsage(400);
+    backend.SetBudget(300);
+    ResidencyManager manager;
+    manager.Initialize(backend);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        manager.Track(FakeObject(i), 100);
+        manager.MarkUsed(FakeObject(i), 10 + i);
+    }
+
+    // Only the first frame's object has completed, so the commit stays over budget instead of evicting in-flight memory
+    CHECK(manager.Commit(10));
+    CHECK(!manager.IsResident(FakeObject(0)));
+    CHECK(manager.IsResident(FakeObject(1)));
+    CHECK(manager.GetStats().evictedObjects_ == 1);
+    CHECK(manager.GetStats().overBudgetCommits_ == 1);
+}
+
+TEST(ResidencyManagerTest, NeverEvictsPinned)
+{
+    NullResidencyBackend backend;
+    backend.SetUsage(400);
+    backend.SetBudget(100);
+    ResidencyManager manager;
+    manager.Initialize(backend);
+    manager.Track(FakeObject(0), 200, true);
+    manager.Track(FakeObject(1), 200);
+
+    CHECK(manager.Commit(0));
+    CHECK(manager.IsResident(FakeObject(0)));
+    CHECK(!manager.IsResident(FakeObject(1)));
+    CHECK(manager.GetStats().overBudgetCommits_ == 1);
+}
+
+TEST(ResidencyManagerTest, MakesUsedObjectsResidentAgain)
+{
+    NullResidencyBackend backend;
+    backend.SetUsage(400);
+    backend.SetBudget(300);
+    ResidencyManager manager;
+    manager.Initialize(backend);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        manager.Track(FakeObject(i), 100);
+        manager.MarkUsed(FakeObject(i), i + 1);
+    }
+    CHECK(manager.Commit(4));
+    CHECK(!manager.IsResident(FakeObject(0)));
+    CHECK(!manager.IsResident(FakeObject(1)));
+
+    // Using evicted objects brings them back in one call, and evicts the now least recently used instead
+    manager.MarkUsed(FakeObject(0), 5);
+    manager.MarkUsed(FakeObject(1), 5);
+    CHECK(manager.Commit(4));
+    CHECK(manager.IsResident(FakeObject(0)));
+    CHECK(manager.IsResident(FakeObject(1)));
+    CHECK(!manager.IsResident(FakeObject(2)));
+    CHECK(!manager.IsResident(FakeObject(3)));
+    CHECK(manager.GetStats().madeResidentObjects_ == 2);
+    CHECK(manager.GetStats().makeResidentCalls_ == 1);
+    CHECK(backend.GetEvictedBytes() == 200);
+}
+
+TEST(ResidencyManagerTest, UntrackForgetsObject)
+{
+    NullResidencyBackend backend;
+    ResidencyManager manager;
+    manager.Initialize(backend);
+    manager.Track(FakeObject(0), 100);
+    manager.Track(FakeObject(1), 100);
+    manager.Untrack(FakeObject(0));
+    CHECK(manager.GetObjectCount() == 1);
+    CHECK(manager.Commit(0));
+    CHECK(manager.GetStats().trackedSize_ == 100);
+}
@@ -0,0 +1,237 @@
+#include "NullGraphicsBackend.h"
+#include "ResourceStateTracker.h"
+#include "Test.h"
+
+#include <vector>
+
+
+/// Return a distinct fake resource handle. The tracker never dereferences handles.
+static ResourceHandle FakeResource(unsigned index)
+{
+    return (ResourceHandle) (uintptr_t) (0x1000 + index * 0x100);
+}
+
+TEST(ResourceStateTrackerTest, StateCompatibility)
+{
+    CHECK(IsResourceStateCompatible(RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_RENDER_TARGET));
+    CHECK(IsResourceStateCompatible(RESOURCE_STATE_GENERIC_READ, RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+    CHECK(!IsResourceStateCompatible(RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_GENERIC_READ));
+    CHECK(!IsResourceStateCompatible(RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_RENDER_TARGET | RESOURCE_STATE_COPY_SOURCE));
+    CHECK(!IsResourceStateCompatible(RESOURCE_STATE_GENERIC_READ, RESOURCE_STATE_COMMON));
+}
+
+TEST(ResourceStateTrackerTest, EmitsTransitionFromRegistryState)
+{
+    ResourceStateRegistry registry;
+    ResourceHandle texture = FakeResource(0);
+    registry.RegisterResource(texture, 1, RESOURCE_STATE_PRESENT);
+
+    ResourceStateTracker tracker(registry);
+    tracker.Transition(texture, RESOURCE_STATE_RENDER_TARGET);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    ResourceBarrierDesc const& barrier = tracker.GetBarriers()[0];
+    CHECK(barrier.resource_ == texture);
+    CHECK(barrier.before_ == RESOURCE_STATE_PRESENT);
+    CHECK(barrier.after_ == RESOURCE_STATE_RENDER_TARGET);
+    CHECK(barrier.subresource_ == ALL_SUBRESOURCES);
+
+    // The registry only changes once the list is committed
+    CHECK(registry.GetStates(texture)->state_ == RESOURCE_STATE_PRESENT);
+    tracker.Commit();
+    CHECK(registry.GetStates(texture)->state_ == RESOURCE_STATE_RENDER_TARGET);
+}
+
+TEST(ResourceStateTrackerTest, DropsRedundantTransitions)
+{
+    ResourceStateRegistry registry;
+    ResourceHandle buffer = FakeResource(0);
+    registry.RegisterResource(buffer, 1, RESOURCE_STATE_GENERIC_READ);
+
+    ResourceStateTracker tracker(registry);
+    tracker.Transition(buffer, RESOURCE_STATE_GENERIC_READ);
+    tracker.Transition(buffer, RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+    tracker.Transition(buffer, RESOURCE_STATE_INDEX_BUFFER);
+    CHECK(tracker.GetBarriers().empty());
+    CHECK(tracker.GetStats().redundant_ == 3);
+}
+
+TEST(ResourceStateTrackerTest, MergesChainedTransitions)
+{
+    ResourceStateRegistry registry;
+    ResourceHandle texture = FakeResource(0);
+    ResourceHandle other = FakeResource(1);
+    registry.RegisterResource(texture, 1, RESOURCE_STATE_COMMON);
+    registry.RegisterResource(other, 1, RESOURCE_STATE_COMMON);
+
+    // A->B then B->C becomes A->C, even with a barrier of another resource in between
+    ResourceStateTracker tracker(registry);
+    tracker.Transition(texture, RESOURCE_STATE_COPY_DEST);
+    tracker.Transition(other, RESOURCE_STATE_RENDER_TARGET);
+    tracker.Transition(texture, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    REQUIRE(tracker.GetBarriers().size() == 2);
+    CHECK(tracker.GetBarriers()[0].before_ == RESOURCE_STATE_COMMON);
+    CHECK(tracker.GetBarriers()[0].after_ == RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    CHECK(tracker.GetStats().merged_ == 1);
+}
+
+TEST(ResourceStateTrackerTest, CancelsRoundTrip)
+{
+    ResourceStateRegistry registry;
+    ResourceHandle texture = FakeResource(0);
+    registry.RegisterResource(texture, 1, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    ResourceStateTracker tracker(registry);
+    tracker.Transition(texture, RESOURCE_STATE_RENDER_TARGET);
+    tracker.Transition(texture, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    CHECK(tracker.GetBarriers().empty());
+    CHECK(tracker.GetStats().merged_ == 1);
+}
+
+TEST(ResourceStateTrackerTest, FlushesOneBatch)
+{
+    ResourceStateRegistry registry;
+    NullGraphicsBackend backend(64, 64, false);
+    backend.Begin();
+    backend.ClearRecording();
+
+    ResourceStateTracker tracker(registry);
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        registry.RegisterResource(FakeResource(i), 1, RESOURCE_STATE_COMMON);
+        tracker.Transition(FakeResource(i), RESOURCE_STATE_COPY_DEST);
+    }
+    CHECK(tracker.FlushBarriers(backend) == 8);
+    CHECK(tracker.GetBarriers().empty());
+    CHECK(tracker.FlushBarriers(backend) == 0);
+    CHECK(tracker.GetStats().barriers_ == 8);
+    CHECK(tracker.GetStats().batches_ == 1);
+    CHECK(backend.GetCommandCount(RECORD_RESOURCE_BARRIER) == 8);
+    backend.End();
+}
+
+TEST(ResourceStateTrackerTest, TracksSubresources)
+{
+    ResourceStateRegistry registry;
+    ResourceHandle texture = FakeResource(0);
+    registry.RegisterResource(texture, 4, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    ResourceStateTracker tracker(registry);
+    tracker.Transition(texture, RESOURCE_STATE_RENDER_TARGET, 2);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].subresource_ == 2);
+
+    // The whole resource then needs one barrier per subresource not already in the state
+    tracker.Transition(texture, RESOURCE_STATE_COPY_SOURCE);
+    CHECK(tracker.GetBarriers().size() == 4);
+    tracker.Commit();
+    ResourceStates const* states = registry.GetStates(texture);
+    REQUIRE(states);
+    CHECK(states->IsUniform());
+    CHECK(states->state_ == RESOURCE_STATE_COPY_SOURCE);
+}
+
+TEST(ResourceStateTrackerTest, CollapsesWhenSubresourcesAgree)
+{
+    ResourceStates states;
+    states.subresourceCount_ = 3;
+    states.state_ = RESOURCE_STATE_COMMON;
+    states.Set(1, RESOURCE_STATE_COPY_DEST);
+    CHECK(!states.IsUniform());
+    CHECK(states.Get(0) == RESOURCE_STATE_COMMON);
+    CHECK(states.Get(1) == RESOURCE_STATE_COPY_DEST);
+    states.Set(0, RESOURCE_STATE_COPY_DEST);
+    states.Set(2, RESOURCE_STATE_COPY_DEST);
+    CHECK(states.IsUniform());
+    CHECK(states.state_ == RESOURCE_STATE_COPY_DEST);
+}
+
+TEST(ResourceStateTrackerTest, SplitsTransitions)
+{
+    ResourceStateRegistry registry;
+    ResourceHandle texture = FakeResource(0);
+    registry.RegisterResource(texture, 1, RESOURCE_STATE_RENDER_TARGET);
+
+    ResourceStateTracker tracker(registry);
+    tracker.BeginTransition(texture, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].flags_ == RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+    tracker.EndTransition(texture);
+    REQUIRE(tracker.GetBarriers().size() == 2);
+    ResourceBarrierDesc const& end = tracker.GetBarriers()[1];
+    CHECK(end.flags_ == RESOURCE_BARRIER_FLAG_END_ONLY);
+    CHECK(end.before_ == RESOURCE_STATE_RENDER_TARGET);
+    CHECK(end.after_ == RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    // Split barriers are never folded
+    tracker.Transition(texture, RESOURCE_STATE_RENDER_TARGET);
+    CHECK(tracker.GetBarriers().size() == 3);
+
+    // A redundant split emits nothing at either end
+    tracker.BeginTransition(texture, RESOURCE_STATE_RENDER_TARGET);
+    tracker.EndTransition(texture);
+    CHECK(tracker.GetBarriers().size() == 3);
+}
+
+TEST(ResourceStateTrackerTest, KeepsTransitionsAfterAliasingBarrier)
+{
+    ResourceStateRegistry registry;
+    ResourceHandle first = FakeResource(0);
+    ResourceHandle second = FakeResource(1);
+    registry.RegisterResource(second, 1, RESOURCE_STATE_COMMON);
+
+    ResourceStateTracker tracker(registry);
+    tracker.Transition(second, RESOURCE_STATE_COPY_DEST);
+    tracker.AliasingBarrier(first, second);
+    tracker.Transition(second, RESOURCE_STATE_RENDER_TARGET);
+    REQUIRE(tracker.GetBarriers().size() == 3);
+    CHECK(tracker.GetBarriers()[1].type_ == RESOURCE_BARRIER_TYPE_ALIASING);
+    CHECK(tracker.GetBarriers()[1].aliasBefore_ == first);
+    CHECK(tracker.GetBarriers()[2].before_ == RESOURCE_STATE_COPY_DEST);
+}
+
+TEST(ResourceStateTrackerTest, DeferredTrackerResolvesFirstUse)
+{
+    ResourceStateRegistry registry;
+    ResourceHandle texture = FakeResource(0);
+    ResourceHandle buffer = FakeResource(1);
+    registry.RegisterResource(texture, 1, RESOURCE_STATE_PRESENT);
+    registry.RegisterResource(buffer, 1, RESOURCE_STATE_GENERIC_READ);
+
+    // Recorded without knowing the states other lists leave behind
+    ResourceStateTracker tracker(registry, true);
+    tracker.Transition(texture, RESOURCE_STATE_RENDER_TARGET);
+    tracker.Transition(buffer, RESOURCE_STATE_INDEX_BUFFER);
+    tracker.Transition(texture, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].before_ == RESOURCE_STATE_RENDER_TARGET);
+
+    // An earlier list changed the texture before this one is submitted
+    registry.RegisterResource(texture, 1, RESOURCE_STATE_COPY_DEST);
+    std::vector<ResourceBarrierDesc> pending;
+    tracker.ResolvePendingBarriers(pending);
+    REQUIRE(pending.size() == 1);
+    CHECK(pending[0].resource_ == texture);
+    CHECK(pending[0].before_ == RESOURCE_STATE_COPY_DEST);
+    CHECK(pending[0].after_ == RESOURCE_STATE_RENDER_TARGET);
+
+    tracker.Commit();
+    CHECK(registry.GetStates(texture)->state_ == RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    CHECK(registry.GetStates(buffer)->state_ == RESOURCE_STATE_INDEX_BUFFER);
+}
+
+TEST(ResourceStateTrackerTest, ResetForgetsLocalStates)
+{
+    ResourceStateRegistry registry;
+    ResourceHandle texture = FakeResource(0);
+    registry.RegisterResource(texture, 1, RESOURCE_STATE_COMMON);
+
+    ResourceStateTracker tracker(registry);
+    tracker.Transition(texture, RESOURCE_STATE_COPY_DEST);
+    tracker.Reset();
+    CHECK(tracker.GetBarriers().empty());
+
+    // Without a commit the registry state still applies
+    tracker.Transition(texture, RESOURCE_STATE_COPY_DEST);
+    REQUIRE(tracker.GetBarriers().size() == 1);
+    CHECK(tracker.GetBarriers()[0].before_ == RESOURCE_STATE_COMMON);
+}
@@ -0,0 +1,365 @@
+#include "ByteStream.h"
+#include "JobSystem.h"
+#include "NullShaderCompilerBackend.h"
+#include "ShaderCompiler.h"
+#include "Test.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/// Shader sources and a cache directory in the working directory, removed with their files when destroyed.
+class ShaderTestFiles
+{
+public:
+    /// Create the directories.
+    explicit ShaderTestFiles(std::string const& name)
+        : directory_(name + ".tmp")
+        , cacheDirectory_(directory_ + "/cache")
+    {
+        MakeDirectory(directory_);
+        MakeDirectory(cacheDirectory_);
+    }
+
+    /// Remove the files and directories.
+    ~ShaderTestFiles()
+    {
+        for (std::string const& fileName : fileNames_)
+            remove(fileName.c_str());
+        RemoveDirectory(cacheDirectory_);
+        RemoveDirectory(directory_);
+    }
+
+    /// Write a source file. Return its path.
+    std::string Write(std::string const& name, std::string const& contents)
+    {
+        std::string fileName = directory_ + "/" + name;
+        WriteFileBytes(fileName, contents.data(), contents.size());
+        fileNames_.push_back(fileName);
+        return fileName;
+    }
+
+    /// Compile a permutation, remembering its cache file for removal. Return success.
+    bool Compile(ShaderCompiler& compiler, ShaderCompileDesc const& desc, ShaderCompileResult& result)
+    {
+        bool success = compiler.Compile(desc, result);
+        if (success)
+            fileNames_.push_back(compiler.GetCacheFileName(result.hash_));
+        return success;
+    }
+
+    /// Return cache directory.
+    std::string const& GetCacheDirectory() const { return cacheDirectory_; }
+
+private:
+    /// Create a directory.
+    static void MakeDirectory(std::string const& directory)
+    {
+#ifdef _WIN32
+        _mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(), 0755);
+#endif
+    }
+
+    /// Remove an empty directory.
+    static void RemoveDirectory(std::string const& directory)
+    {
+#ifdef _WIN32
+        _rmdir(directory.c_str());
+#else
+        rmdir(directory.c_str());
+#endif
+    }
+
+    /// Source directory
+    std::string directory_;
+    /// Cache directory
+    std::string cacheDirectory_;
+    /// Files to remove
+    std::vector<std::string> fileNames_;
+};
+
+/// Give a backend a version that differs from earlier runs, so cache files a crashed run left behind are never hit.
+static void SetUniqueVersion(NullShaderCompilerBackend& backend)
+{
+    backend.SetVersion((uint64_t) std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+/// Return a permutation.
+static ShaderCompileDesc MakeDesc(std::string const& fileName)
+{
+    ShaderCompileDesc desc;
+    desc.fileName_ = fileName;
+    desc.entryPoint_ = "main";
+    desc.profile_ = "ps_5_1";
+    return desc;
+}
+
+/// Return number of occurrences of a string in another.
+static unsigned CountOccurrences(std::string const& text, std::string const& pattern)
+{
+    unsigned count = 0;
+    for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1))
+        ++count;
+    return count;
+}
+
+TEST(ShaderCompilerTest, RerunIsServedFromCache)
+{
+    ShaderTestFiles files("ShaderCompilerTest_Rerun");
+    NullShaderCompilerBackend backend;
+    SetUniqueVersion(backend);
+    files.Write("Common.hlsli", "float4 Tint;\n");
+    ShaderCompileDesc desc = MakeDesc(files.Write("Main.hlsl", "#include \"Common.hlsli\"\nfloat4 main() : SV_Target { return Tint; }\n"));
+
+    ShaderCompileResult first;
+    {
+        ShaderCompiler compiler(backend, files.GetCacheDirectory());
+        REQUIRE(files.Compile(compiler, desc, first));
+        CHECK(!first.cached_);
+        CHECK(first.dependencies_.size() == 2);
+        CHECK(backend.GetCompileCount() == 1);
+
+        // The same compiler answers from memory
+        ShaderCompileResult again;
+        REQUIRE(files.Compile(compiler, desc, again));
+        CHECK(again.cached_);
+        CHECK(again.bytecode_ == first.bytecode_);
+        CHECK(compiler.GetStats().memoryHits_ == 1);
+    }
+
+    // A later run reads the cache directory
+    ShaderCompiler compiler(backend, files.GetCacheDirectory());
+    ShaderCompileResult rerun;
+    REQUIRE(files.Compile(compiler, desc, rerun));
+    CHECK(rerun.cached_);
+    CHECK(rerun.hash_ == first.hash_);
+    CHECK(rerun.bytecode_ == first.bytecode_);
+    CHECK(compiler.GetStats().diskHits_ == 1);
+    CHECK(compiler.GetStats().compiled_ == 0);
+    CHECK(backend.GetCompileCount() == 1);
+}
+
+TEST(ShaderCompilerTest, ChangedInputsMissCache)
+{
+    ShaderTestFiles files("ShaderCompilerTest_Changed");
+    NullShaderCompilerBackend backend;
+    SetUniqueVersion(backend);
+    files.Write("Common.hlsli", "float4 Tint;\n");
+    ShaderCompileDesc desc = MakeDesc(files.Write("Main.hlsl", "#include \"Common.hlsli\"\nfloat4 main() : SV_Target { return Tint; }\n"));
+    desc.defines_ = { { "SHADOWS", "1" }, { "FOG", "0" } };
+
+    ShaderCompiler compiler(backend, files.GetCacheDirectory());
+    ShaderCompileResult base;
+    REQUIRE(files.Compile(compiler, desc, base));
+
+    // Define order does not matter
+    ShaderCompileDesc reordered = desc;
+    reordered.defines_ = { { "FOG", "0" }, { "SHADOWS", "1" } };
+    ShaderCompileResult result;
+    REQUIRE(files.Compile(compiler, reordered, result));
+    CHECK(result.cached_ && result.hash_ == base.hash_);
+
+    // A define value, an added define, the profile and the entry point each make another permutation
+    ShaderCompileDesc changed = desc;
+    changed.defines_[1].value_ = "1";
+    REQUIRE(files.Compile(compiler, changed, result));
+    CHECK(!result.cached_ && result.hash_ != base.hash_);
+
+    changed = desc;
+    changed.defines_.push_back({ "SKINNED", "1" });
+    REQUIRE(files.Compile(compiler, changed, result));
+    CHECK(!result.cached_ && result.hash_ != base.hash_);
+
+    changed = desc;
+    changed.profile_ = "ps_6_0";
+    REQUIRE(files.Compile(compiler, changed, result));
+    CHECK(!result.cached_ && result.hash_ != base.hash_);
+
+    changed = desc;
+    changed.entryPoint_ = "alternate";
+    REQUIRE(files.Compile(compiler, changed, result));
+    CHECK(!result.cached_ && result.hash_ != base.hash_);
+    CHECK(backend.GetCompileCount() == 5);
+
+    // Editing an included file changes the hash once the file cache is cleared
+    files.Write("Common.hlsli", "float4 Tint;\nfloat Exposure;\n");
+    REQUIRE(files.Compile(compiler, desc, result));
+    CHECK(result.cached_);
+    compiler.ClearFileCache();
+    REQUIRE(files.Compile(compiler, desc, result));
+    CHECK(!result.cached_ && result.hash_ != base.hash_);
+
+    // Another compiler version does not reuse the bytecode
+    backend.SetVersion(backend.GetVersion() + 1);
+    ShaderCompileResult newVersion;
+    REQUIRE(files.Compile(compiler, desc, newVersion));
+    CHECK(!newVersion.cached_ && newVersion.hash_ != result.hash_);
+    CHECK(backend.GetCompileCount() == 7);
+}
+
+TEST(ShaderCompilerTest, PragmaOnceIncludesOnce)
+{
+    ShaderTestFiles files("ShaderCompilerTest_Once");
+    NullShaderCompilerBackend backend;
+    ShaderCompiler compiler(backend, std::string());
+    files.Write("Once.hlsli", "#pragma once\nfloat OnceMarker;\n");
+    files.Write("Twice.hlsli", "float TwiceMarker;\n");
+    files.Write("Nested.hlsli", "#include \"Once.hlsli\"\n#include \"Twice.hlsli\"\n");
+    ShaderCompileDesc desc = MakeDesc(files.Write("Main.hlsl",
+        "#include \"Once.hlsli\"\n#include \"Nested.hlsli\"\n  #  include \"Once.hlsli\"\n#include \"Twice.hlsli\"\n"));
+
+    std::string source;
+    std::vector<std::string> dependencies;
+    std::string messages;
+    REQUIRE(compiler.Preprocess(desc, source, dependencies, messages));
+    CHECK(CountOccurrences(source, "OnceMarker") == 1);
+    CHECK(CountOccurrences(source, "TwiceMarker") == 2);
+    CHECK(dependencies.size() == 4);
+    CHECK(messages.empty());
+}
+
+TEST(ShaderCompilerTest, SearchesIncludeDirectories)
+{
+    ShaderTestFiles files("ShaderCompilerTest_Directories");
+    NullShaderCompilerBackend backend;
+    ShaderCompiler compiler(backend, std::string());
+    files.Write("Lighting.hlsli", "float LightingMarker;\n");
+    ShaderCompileDesc desc = MakeDesc(files.Write("Main.hlsl", "#include <Lighting.hlsli>\n"));
+
+    // Found next to the including file, and through ".." relative to it
+    std::string source;
+    std::vector<std::string> dependencies;
+    std::string messages;
+    REQUIRE(compiler.Preprocess(desc, source, dependencies, messages));
+    CHECK(CountOccurrences(source, "LightingMarker") == 1);
+
+    ShaderTestFiles nested("ShaderCompilerTest_Directories.tmp/Nested");
+    ShaderCompileDesc nestedDesc = MakeDesc(nested.Write("Main.hlsl", "#include \"../Lighting.hlsli\"\n"));
+    REQUIRE(compiler.Preprocess(nestedDesc, source, dependencies, messages));
+    CHECK(CountOccurrences(source, "LightingMarker") == 1);
+
+    // Elsewhere only through an include directory
+    ShaderCompileDesc otherDesc = MakeDesc(nested.Write("Other.hlsl", "#include \"Lighting.hlsli\"\n"));
+    CHECK(!compiler.Preprocess(otherDesc, source, dependencies, messages));
+    compiler.AddIncludeDirectory("ShaderCompilerTest_Directories.tmp");
+    compiler.ClearFileCache();
+    messages.clear();
+    REQUIRE(compiler.Preprocess(otherDesc, source, dependencies, messages));
+    CHECK(CountOccurrences(source, "LightingMarker") == 1);
+}
+
+TEST(ShaderCompilerTest, BadIncludesFailWithMessages)
+{
+    ShaderTestFiles files("ShaderCompilerTest_Bad");
+    NullShaderCompilerBackend backend;
+    ShaderCompiler compiler(backend, std::string());
+
+    ShaderCompileResult result;
+    CHECK(!compiler.Compile(MakeDesc(files.Write("Missing.hlsl", "float Value;\n#include \"Absent.hlsli\"\n")), result));
+    CHECK(!result.success_);
+    CHECK(result.messages_.find("Missing.hlsl(2): cannot find include Absent.hlsli") != std::string::npos);
+
+    CHECK(!compiler.Compile(MakeDesc("ShaderCompilerTest_Bad.tmp/Nowhere.hlsl"), result));
+    CHECK(result.messages_.find("Cannot read shader source ShaderCompilerTest_Bad.tmp/Nowhere.hlsl") != std::string::npos);
+
+    // Recursion without #pragma once ends at the nesting limit
+    files.Write("A.hlsli", "#include \"B.hlsli\"\n");
+    files.Write("B.hlsli", "#include \"A.hlsli\"\n");
+    CHECK(!compiler.Compile(MakeDesc(files.Write("Recursive.hlsl", "#include \"A.hlsli\"\n")), result));
+    CHECK(result.messages_.find("nested too deep, possibly recursive") != std::string::npos);
+
+    // Compile errors carry the compiler's message
+    CHECK(!compiler.Compile(MakeDesc(files.Write("Error.hlsl", "#error Unsupported\n")), result));
+    CHECK(result.messages_.find("#error Unsupported") != std::string::npos);
+
+    CHECK(compiler.GetStats().failed_ == 4);
+    CHECK(backend.GetCompileCount() == 1);
+}
+
+TEST(ShaderCompilerTest, TornCacheFileIsMiss)
+{
+    ShaderTestFiles files("ShaderCompilerTest_Torn");
+    NullShaderCompilerBackend backend;
+    SetUniqueVersion(backend);
+    ShaderCompileDesc desc = MakeDesc(files.Write("Main.hlsl", "float4 main() : SV_Target { return 1; }\n"));
+
+    ShaderCompileResult first;
+    {
+        ShaderCompiler compiler(backend, files.GetCacheDirectory());
+        REQUIRE(files.Compile(compiler, desc, first));
+    }
+
+    std::string cacheFileName = ShaderCompiler(backend, files.GetCacheDirectory()).GetCacheFileName(first.hash_);
+    std::vector<uint8_t> data;
+    REQUIRE(ReadFileBytes(cacheFileName, data));
+
+    // Cut short, and whole but with a flipped byte
+    std::vector<std::vector<uint8_t>> damaged = { std::vector<uint8_t>(data.begin(), data.begin() + data.size() / 2), data };
+    damaged[1][data.size() / 2] ^= 1;
+    for (std::vector<uint8_t> const& contents : damaged)
+    {
+        REQUIRE(WriteFileBytes(cacheFileName, contents.data(), contents.size()));
+        unsigned compiles = backend.GetCompileCount();
+
+        ShaderCompiler compiler(backend, files.GetCacheDirectory());
+        ShaderCompileResult result;
+        REQUIRE(files.Compile(compiler, desc, result));
+        CHECK(!result.cached_);
+        CHECK(result.bytecode_ == first.bytecode_);
+        CHECK(compiler.GetStats().diskHits_ == 0);
+        CHECK(backend.GetCompileCount() == compiles + 1);
+    }
+
+    // The compile replaced the damaged file
+    ShaderCompiler compiler(backend, files.GetCacheDirectory());
+    ShaderCompileResult result;
+    REQUIRE(files.Compile(compiler, desc, result));
+    CHECK(result.cached_);
+    CHECK(compiler.GetStats().diskHits_ == 1);
+}
+
+TEST(ShaderCompilerTest, IdenticalPermutationsCompileOnce)
+{
+    ShaderTestFiles files("ShaderCompilerTest_InFlight");
+    NullShaderCompilerBackend backend;
+    SetUniqueVersion(backend);
+    backend.SetCompileTime(std::chrono::milliseconds(2));
+    ShaderCompileDesc desc = MakeDesc(files.Write("Main.hlsl", "float4 main() : SV_Target { return 1; }\n"));
+
+    // Four permutations requested eight times each, all at once
+    std::vector<ShaderCompileDesc> descs;
+    for (unsigned i = 0; i < 32; ++i)
+    {
+        ShaderCompileDesc permutation = desc;
+        permutation.defines_.push_back({ "VARIANT", std::to_string(i % 4) });
+        descs.push_back(permutation);
+    }
+
+    JobSystem jobSystem(3);
+    ShaderCompiler compiler(backend, std::string());
+    std::vector<ShaderCompileResult> results;
+    CHECK(compiler.CompileAll(descs, results, &jobSystem) == 0);
+    REQUIRE(results.size() == descs.size());
+
+    CHECK(backend.GetCompileCount() == 4);
+    CHECK(compiler.GetStats().compiled_ == 4);
+    CHECK(compiler.GetStats().memoryHits_ == 28);
+    for (unsigned i = 0; i < 32; ++i)
+    {
+        CHECK(results[i].success_);
+        CHECK(results[i].hash_ == results[i % 4].hash_);
+        CHECK(results[i].bytecode_ == results[i % 4].bytecode_);
+    }
+    CHECK(results[0].hash_ != results[1].hash_);
+}
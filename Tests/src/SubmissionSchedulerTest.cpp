@@ -0,0 +1,178 @@
+#include "SimulatedQueue.h"
+#include "SubmissionScheduler.h"
+#include "Test.h"
+
+#include <chrono>
+
+
+/// Direct, compute and copy queues executing only when processed or waited on.
+struct ManualQueues
+{
+    /// Construct and attach to a scheduler.
+    explicit ManualQueues(SubmissionScheduler& scheduler)
+    {
+        for (unsigned i = 0; i < MAX_GPU_QUEUES; ++i)
+        {
+            queues_[i]->SetCommandListTime(std::chrono::microseconds(1000));
+            scheduler.SetQueue((GpuQueueType) i, queues_[i]);
+        }
+    }
+
+    /// Direct queue
+    SimulatedQueue direct_{false};
+    /// Compute queue
+    SimulatedQueue compute_{false};
+    /// Copy queue
+    SimulatedQueue copy_{false};
+    /// Queues by type
+    SimulatedQueue* queues_[MAX_GPU_QUEUES]{ &direct_, &compute_, &copy_ };
+};
+
+/// Placeholder command lists, the simulated queues only count them.
+static CommandList* const commandLists[4]{};
+
+TEST(SubmissionSchedulerTest, BatchesConsecutiveSubmissions)
+{
+    SubmissionScheduler scheduler;
+    ManualQueues manual(scheduler);
+    SimulatedQueue& direct = manual.direct_;
+
+    GpuSubmission first = scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 2);
+    GpuSubmission second = scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 1);
+    CHECK(first.value_ == second.value_);
+    CHECK(scheduler.GetPendingBatchCount() == 1);
+    CHECK(direct.GetPendingCommandCount() == 0);
+
+    // One execute of three lists and one signal
+    scheduler.Flush();
+    CHECK(scheduler.GetStats().batches_ == 1);
+    CHECK(scheduler.GetStats().submissions_ == 2);
+    CHECK(direct.GetPendingCommandCount() == 2);
+    CHECK(!scheduler.IsComplete(first));
+    direct.ProcessCommands();
+    CHECK(scheduler.IsComplete(second));
+    CHECK(direct.GetBusyTime() == std::chrono::microseconds(3000));
+}
+
+TEST(SubmissionSchedulerTest, WaitsAcrossQueues)
+{
+    SubmissionScheduler scheduler;
+    ManualQueues manual(scheduler);
+    SimulatedQueue& direct = manual.direct_;
+    SimulatedQueue& copy = manual.copy_;
+
+    GpuSubmission upload = scheduler.Submit(GPU_QUEUE_COPY, commandLists, 1);
+    GpuSubmission draw = scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 1, &upload, 1);
+    scheduler.Flush();
+    CHECK(scheduler.GetStats().waits_ == 1);
+
+    // The manual direct queue reaching the wait drives the copy queue to the awaited value first
+    CHECK(copy.GetPendingCommandCount() == 2);
+    direct.ProcessCommands();
+    CHECK(copy.GetPendingCommandCount() == 0);
+    CHECK(scheduler.IsComplete(upload));
+    CHECK(scheduler.IsComplete(draw));
+
+    // On the simulated timeline the draw starts once the upload ended
+    CHECK(copy.GetTimelineTime() == std::chrono::microseconds(1000));
+    CHECK(direct.GetTimelineTime() == std::chrono::microseconds(2000));
+}
+
+TEST(SubmissionSchedulerTest, IndependentQueuesOverlap)
+{
+    SubmissionScheduler scheduler;
+    ManualQueues manual(scheduler);
+
+    scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 2);
+    scheduler.Submit(GPU_QUEUE_COMPUTE, commandLists, 2);
+    scheduler.WaitIdle();
+    CHECK(scheduler.GetStats().waits_ == 0);
+    CHECK(manual.direct_.GetTimelineTime() == std::chrono::microseconds(2000));
+    CHECK(manual.compute_.GetTimelineTime() == std::chrono::microseconds(2000));
+}
+
+TEST(SubmissionSchedulerTest, SkipsRedundantWaits)
+{
+    SubmissionScheduler scheduler;
+    ManualQueues manual(scheduler);
+
+    GpuSubmission compute = scheduler.Submit(GPU_QUEUE_COMPUTE, commandLists, 1);
+    scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 1, &compute, 1);
+
+    // Already waited for, on the same queue, and no submission at all
+    GpuSubmission const dependencies[] = { compute, scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 1), GpuSubmission() };
+    scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 1, dependencies, 3);
+    CHECK(scheduler.GetStats().waitsSkipped_ == 3);
+    scheduler.Flush();
+    CHECK(scheduler.GetStats().waits_ == 1);
+
+    // Completed work needs no wait either
+    scheduler.WaitIdle();
+    GpuSubmission copy = scheduler.Submit(GPU_QUEUE_COPY, commandLists, 1);
+    scheduler.WaitForCompletion(copy);
+    scheduler.Submit(GPU_QUEUE_COMPUTE, commandLists, 1, &copy, 1);
+    CHECK(scheduler.GetStats().waitsSkipped_ == 4);
+}
+
+TEST(SubmissionSchedulerTest, NewBatchForNewWait)
+{
+    SubmissionScheduler scheduler;
+    ManualQueues manual(scheduler);
+    SimulatedQueue& direct = manual.direct_;
+
+    // Work already batched is not held back by a wait a later submission needs
+    GpuSubmission early = scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 1);
+    GpuSubmission compute = scheduler.Submit(GPU_QUEUE_COMPUTE, commandLists, 1);
+    GpuSubmission late = scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 1, &compute, 1);
+    CHECK(late.value_ == early.value_ + 1);
+    CHECK(scheduler.GetPendingBatchCount() == 3);
+    scheduler.Flush();
+
+    // The first batch executes and signals before the wait in front of the second
+    direct.ProcessCommands(2);
+    CHECK(scheduler.IsComplete(early));
+    CHECK(!scheduler.IsComplete(compute));
+    CHECK(!scheduler.IsComplete(late));
+    direct.ProcessCommands();
+    CHECK(scheduler.IsComplete(late));
+    CHECK(direct.GetTimelineTime() == std::chrono::microseconds(2000));
+}
+
+TEST(SubmissionSchedulerTest, QueueWaitCoversLaterWork)
+{
+    SubmissionScheduler scheduler;
+    ManualQueues manual(scheduler);
+    SimulatedQueue& direct = manual.direct_;
+
+    GpuSubmission compute = scheduler.Submit(GPU_QUEUE_COMPUTE, commandLists, 1);
+    scheduler.QueueWait(GPU_QUEUE_DIRECT, compute);
+    CHECK(scheduler.GetPendingBatchCount() == 0);
+    CHECK(scheduler.GetStats().waits_ == 1);
+
+    // Work submitted past the scheduler runs after the wait, and a second wait for the same value is skipped
+    direct.Execute(std::chrono::microseconds(500));
+    scheduler.QueueWait(GPU_QUEUE_DIRECT, compute);
+    CHECK(scheduler.GetStats().waitsSkipped_ == 1);
+    direct.ProcessCommands();
+    CHECK(scheduler.IsComplete(compute));
+    CHECK(direct.GetTimelineTime() == std::chrono::microseconds(1500));
+}
+
+TEST(SubmissionSchedulerTest, FrameSlotWaitsForEveryQueue)
+{
+    SubmissionScheduler scheduler;
+    ManualQueues manual(scheduler);
+
+    GpuSubmission direct = scheduler.Submit(GPU_QUEUE_DIRECT, commandLists, 1);
+    GpuSubmission copy = scheduler.Submit(GPU_QUEUE_COPY, commandLists, 1);
+    scheduler.EndFrame(0);
+    CHECK(scheduler.GetPendingBatchCount() == 0);
+    CHECK(!scheduler.IsComplete(direct));
+
+    // Reusing the slot waits for the work of both queues, another slot waits for nothing
+    scheduler.BeginFrame(1);
+    CHECK(!scheduler.IsComplete(copy));
+    scheduler.BeginFrame(0);
+    CHECK(scheduler.IsComplete(direct));
+    CHECK(scheduler.IsComplete(copy));
+}
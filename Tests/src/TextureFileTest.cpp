@@ -0,0 +1,173 @@
+#include "ByteStream.h"
+#include "Test.h"
+#include "TextureFile.h"
+
+#include <cstring>
+
+
+/// Write a DDS file of an RGBA8 texture with a mip count field and the data of a full mip chain.
+static std::vector<uint8_t> MakeDds(unsigned width, unsigned height, uint32_t mipCount)
+{
+    std::vector<uint8_t> data;
+    ByteWriter writer(data);
+    writer.WriteU32(0x20534444);
+    writer.WriteU32(124);
+    writer.WriteU32(0x20000);
+    writer.WriteU32(height);
+    writer.WriteU32(width);
+    writer.WriteU32(width * 4);
+    writer.WriteU32(0);
+    writer.WriteU32(mipCount);
+    for (unsigned i = 0; i < 11; ++i)
+        writer.WriteU32(0);
+
+    // Pixel format: 32-bit RGB with red in the low byte
+    uint32_t const pixelFormat[] = { 32, 0x41, 0, 32, 0xff, 0xff00, 0xff0000, 0xff000000 };
+    for (uint32_t value : pixelFormat)
+        writer.WriteU32(value);
+    for (unsigned i = 0; i < 5; ++i)
+        writer.WriteU32(0);
+
+    for (unsigned w = width, h = height; ; w = w > 1 ? w / 2 : 1, h = h > 1 ? h / 2 : 1)
+    {
+        data.resize(data.size() + w * h * 4, (uint8_t) w);
+        if (w == 1 && h == 1)
+            break;
+    }
+    return data;
+}
+
+/// Write a KTX2 file of an RGBA8 texture with a level count field and levelCount level index entries.
+static std::vector<uint8_t> MakeKtx2(unsigned width, unsigned height, uint32_t levelCount, unsigned indexCount)
+{
+    static const uint8_t identifier[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+    std::vector<uint8_t> data(identifier, identifier + sizeof identifier);
+    ByteWriter writer(data);
+    uint32_t const header[] = { 37, 1, width, height, 0, 0, 1, levelCount, 0, 0, 0, 0, 0 };
+    for (uint32_t value : header)
+        writer.WriteU32(value);
+    writer.WriteU64(0);
+    writer.WriteU64(0);
+
+    uint64_t offset = data.size() + indexCount * 24;
+    for (unsigned i = 0; i < indexCount; ++i)
+    {
+        uint64_t mipSize = (uint64_t) (width >> i ? width >> i : 1) * (height >> i ? height >> i : 1) * 4;
+        writer.WriteU64(offset);
+        writer.WriteU64(mipSize);
+        writer.WriteU64(mipSize);
+        offset += mipSize;
+    }
+    data.resize((size_t) offset);
+    return data;
+}
+
+/// Overwrite a 32-bit field.
+static void Patch(std::vector<uint8_t>& data, size_t offset, uint32_t value)
+{
+    for (unsigned i = 0; i < 4; ++i)
+        data[offset + i] = (uint8_t) (value >> (i * 8));
+}
+
+TEST(TextureFileTest, ParsesDds)
+{
+    std::vector<uint8_t> data = MakeDds(8, 4, 4);
+    TextureFileInfo info;
+    REQUIRE(ParseTextureFile(data.data(), data.size(), info));
+    CHECK(info.width_ == 8);
+    CHECK(info.height_ == 4);
+    CHECK(info.format_ == 28);
+    REQUIRE(info.GetMipCount() == 4);
+    CHECK(info.mips_[0].offset_ == 128);
+    CHECK(info.mips_[1].offset_ == 128 + 8 * 4 * 4);
+    CHECK(info.mips_[3].width_ == 1);
+    CHECK(info.mips_[3].height_ == 1);
+    CHECK(info.GetMipChainSize(1) == (4 * 2 + 2 * 1 + 1) * 4);
+}
+
+TEST(TextureFileTest, ParsesKtx2)
+{
+    std::vector<uint8_t> data = MakeKtx2(16, 16, 5, 5);
+    TextureFileInfo info;
+    REQUIRE(ParseTextureFile(data.data(), data.size(), info));
+    CHECK(info.format_ == 28);
+    REQUIRE(info.GetMipCount() == 5);
+    CHECK(info.mips_[4].size_ == 4);
+}
+
+TEST(TextureFileTest, RejectsMipCountBeyondFullChain)
+{
+    TextureFileInfo info;
+    std::vector<uint8_t> dds = MakeDds(8, 4, 5);
+    CHECK(!ParseTextureFile(dds.data(), dds.size(), info));
+    CHECK(info.GetMipCount() == 0);
+
+    // Counts that would size a huge mip vector or shift by 32 and more
+    dds = MakeDds(8, 4, 0xffffffff);
+    CHECK(!ParseTextureFile(dds.data(), dds.size(), info));
+    dds = MakeDds(8, 4, 40);
+    CHECK(!ParseTextureFile(dds.data(), dds.size(), info));
+
+    std::vector<uint8_t> ktx2 = MakeKtx2(16, 16, 6, 5);
+    CHECK(!ParseTextureFile(ktx2.data(), ktx2.size(), info));
+    ktx2 = MakeKtx2(16, 16, 0xffffffff, 5);
+    CHECK(!ParseTextureFile(ktx2.data(), ktx2.size(), info));
+}
+
+TEST(TextureFileTest, RejectsOversizedDimensions)
+{
+    TextureFileInfo info;
+    std::vector<uint8_t> dds = MakeDds(8, 4, 1);
+    Patch(dds, 16, 0x40000000);
+    CHECK(!ParseTextureFile(dds.data(), dds.size(), info));
+    Patch(dds, 16, 0);
+    CHECK(!ParseTextureFile(dds.data(), dds.size(), info));
+
+    std::vector<uint8_t> ktx2 = MakeKtx2(16, 16, 1, 1);
+    Patch(ktx2, 12 + 8, 0xffffffff);
+    CHECK(!ParseTextureFile(ktx2.data(), ktx2.size(), info));
+}
+
+TEST(TextureFileTest, RejectsTruncatedFiles)
+{
+    // Every prefix ends inside the header, the level index or the mip data
+    std::vector<uint8_t> dds = MakeDds(4, 4, 3);
+    std::vector<uint8_t> ktx2 = MakeKtx2(4, 4, 3, 3);
+    TextureFileInfo info;
+    for (size_t size = 0; size < dds.size(); ++size)
+        REQUIRE(!ParseTextureFile(dds.data(), size, info));
+    for (size_t size = 0; size < ktx2.size(); ++size)
+        REQUIRE(!ParseTextureFile(ktx2.data(), size, info));
+}
+
+TEST(TextureFileTest, RejectsMismatchedLevelIndex)
+{
+    std::vector<uint8_t> ktx2 = MakeKtx2(16, 16, 2, 2);
+    TextureFileInfo info;
+    // A level pointing past the end of the file
+    std::vector<uint8_t> data = ktx2;
+    Patch(data, 80 + 24, 0xfffffff0);
+    CHECK(!ParseTextureFile(data.data(), data.size(), info));
+    // A level whose length does not match its dimensions
+    data = ktx2;
+    Patch(data, 80 + 8, 12);
+    CHECK(!ParseTextureFile(data.data(), data.size(), info));
+}
+
+TEST(TextureFileTest, CopiesMipWithAlignedPitch)
+{
+    std::vector<uint8_t> data = MakeDds(8, 4, 1);
+    TextureFileInfo info;
+    REQUIRE(ParseTextureFile(data.data(), data.size(), info));
+    TextureMipInfo const& mip = info.mips_[0];
+    CHECK(mip.GetUploadRowPitch() == TEXTURE_DATA_PITCH_ALIGNMENT);
+
+    std::vector<uint8_t> upload((size_t) mip.GetUploadSize(), 0);
+    CopyTextureMip(data.data(), mip, upload.data());
+    for (unsigned row = 0; row < mip.rowCount_; ++row)
+    {
+        CHECK(memcmp(upload.data() + row * mip.GetUploadRowPitch(), data.data() + mip.offset_ + row * mip.rowSize_, mip.rowSize_) == 0);
+        CHECK(upload[row * mip.GetUploadRowPitch() + mip.rowSize_] == 0);
+    }
+}
@@ -0,0 +1,269 @@
+#include "ByteStream.h"
+#include "NullTextureUploadSink.h"
+#include "NullUploadBufferFactory.h"
+#include "Test.h"
+#include "TextureStreamer.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+/// Square RGBA8 DDS file with a full mip chain in the working directory, removed when destroyed.
+class TestTextureFile
+{
+public:
+    /// Write the file.
+    TestTextureFile(std::string const& fileName, unsigned size)
+        : fileName_(fileName)
+    {
+        std::vector<uint8_t> data;
+        ByteWriter writer(data);
+        uint32_t const header[] = { 0x20534444, 124, 0x20000, size, size, size * 4, 0, 0 };
+        for (uint32_t value : header)
+            writer.WriteU32(value);
+        for (unsigned i = 0; i < 11; ++i)
+            writer.WriteU32(0);
+        uint32_t const pixelFormat[] = { 32, 0x41, 0, 32, 0xff, 0xff00, 0xff0000, 0xff000000, 0, 0, 0, 0, 0 };
+        for (uint32_t value : pixelFormat)
+            writer.WriteU32(value);
+
+        unsigned mipCount = 0;
+        for (unsigned mip = size; ; mip /= 2)
+        {
+            data.resize(data.size() + (size_t) mip * mip * 4, (uint8_t) mip);
+            ++mipCount;
+            if (mip == 1)
+                break;
+        }
+        data[28] = (uint8_t) mipCount;
+        WriteFileBytes(fileName_, data.data(), data.size());
+    }
+
+    /// Remove the file.
+    ~TestTextureFile() { remove(fileName_.c_str()); }
+
+    /// Return file name.
+    std::string const& GetFileName() const { return fileName_; }
+
+private:
+    /// File name
+    std::string fileName_;
+};
+
+/// Run a frame: update the streamer, then let the simulated copy queue finish what was submitted.
+static void RunFrame(TextureStreamer& streamer, NullTextureUploadSink& sink)
+{
+    streamer.Update();
+    sink.GetQueue().ProcessCommands();
+}
+
+/// Run frames until the streamer is idle. Return the number of frames, or ~0u if it does not get there.
+static unsigned RunUntilIdle(TextureStreamer& streamer, NullTextureUploadSink& sink)
+{
+    for (unsigned frame = 0; frame < 1000; ++frame)
+    {
+        RunFrame(streamer, sink);
+        if (streamer.IsIdle())
+            return frame;
+    }
+    return ~0u;
+}
+
+TEST(TextureStreamerTest, LoadsTailThenOneMipAtATime)
+{
+    TestTextureFile file("TextureStreamerTest_Load.dds", 256);
+    NullTextureUploadSink sink(false);
+    NullUploadBufferFactory factory;
+    TextureStreamer streamer;
+    REQUIRE(streamer.Initialize(sink, factory));
+
+    unsigned id = streamer.AddTexture(file.GetFileName());
+    REQUIRE(id != ~0u);
+    TextureFileInfo const& info = streamer.GetFileInfo(id);
+    REQUIRE(info.GetMipCount() == 9);
+    CHECK(streamer.GetTexture(id) == nullptr);
+    CHECK(streamer.GetFirstMip(id) == 9);
+
+    // The first load brings in every mip up to 64 KB together, 64x64 down, then each larger mip follows alone
+    std::vector<unsigned> firstMips;
+    for (unsigned frame = 0; frame < 100 && !streamer.IsIdle(); ++frame)
+    {
+        RunFrame(streamer, sink);
+        if (firstMips.empty() || firstMips.back() != streamer.GetFirstMip(id))
+            firstMips.push_back(streamer.GetFirstMip(id));
+        CHECK(streamer.GetCommittedSize() >= info.GetMipChainSize(streamer.GetFirstMip(id)));
+    }
+    CHECK(streamer.IsIdle());
+    CHECK((firstMips == std::vector<unsigned>{ 9, 2, 1, 0 }));
+    CHECK(streamer.GetTexture(id) != nullptr);
+
+    TextureStreamerStats const& stats = streamer.GetStats();
+    CHECK(stats.loads_ == 3);
+    CHECK(stats.mipsLoaded_ == 9);
+    CHECK(stats.mipsEvicted_ == 0);
+    CHECK(sink.GetUploadedMipCount() == 9);
+    CHECK(streamer.GetCommittedSize() == info.GetMipChainSize(0));
+
+    // Each load went into a new texture, and only the last one is alive
+    CHECK(sink.GetCreatedTextureCount() == 3);
+    CHECK(sink.GetTextureCount() == 1);
+    CHECK(sink.GetTextureBytes() == info.GetMipChainSize(0));
+
+    streamer.RemoveTexture(id);
+    CHECK(sink.GetTextureCount() == 0);
+    CHECK(streamer.GetCommittedSize() == 0);
+}
+
+TEST(TextureStreamerTest, LoadsTailsFirstThenByPriority)
+{
+    TestTextureFile file("TextureStreamerTest_Order.dds", 256);
+    NullTextureUploadSink sink(false);
+    NullUploadBufferFactory factory;
+    TextureStreamer streamer;
+    REQUIRE(streamer.Initialize(sink, factory));
+
+    // One load per frame, so the order is visible
+    streamer.SetUploadLimit(1);
+    unsigned low = streamer.AddTexture(file.GetFileName(), 1.0f);
+    unsigned high = streamer.AddTexture(file.GetFileName(), 4.0f);
+    unsigned third = streamer.AddTexture(file.GetFileName(), 1.0f);
+    REQUIRE(low != ~0u && high != ~0u && third != ~0u);
+    unsigned ids[] = { low, high, third };
+
+    bool allResident = false;
+    bool highFinishedFirst = false;
+    for (unsigned frame = 0; frame < 100 && !streamer.IsIdle(); ++frame)
+    {
+        RunFrame(streamer, sink);
+
+        // No texture gets detail while another still has nothing
+        bool anyEmpty = false;
+        bool anyDetail = false;
+        for (unsigned id : ids)
+        {
+            anyEmpty |= streamer.GetTexture(id) == nullptr;
+            anyDetail |= streamer.GetFirstMip(id) < 2;
+        }
+        CHECK(!(anyEmpty && anyDetail));
+        allResident |= !anyEmpty;
+
+        // The high priority texture is never behind the others
+        if (!anyEmpty)
+        {
+            CHECK(streamer.GetFirstMip(high) <= streamer.GetFirstMip(low));
+            CHECK(streamer.GetFirstMip(high) <= streamer.GetFirstMip(third));
+            if (streamer.GetFirstMip(high) == 0 && streamer.GetFirstMip(low) > 0 && streamer.GetFirstMip(third) > 0)
+                highFinishedFirst = true;
+        }
+    }
+    CHECK(allResident);
+    CHECK(highFinishedFirst);
+    for (unsigned id : ids)
+        CHECK(streamer.GetFirstMip(id) == 0);
+}
+
+TEST(TextureStreamerTest, EvictsLowerPriorityWithinBudget)
+{
+    TestTextureFile file("TextureStreamerTest_Budget.dds", 256);
+    NullTextureUploadSink sink(false);
+    NullUploadBufferFactory factory;
+    TextureStreamer streamer;
+    REQUIRE(streamer.Initialize(sink, factory));
+
+    unsigned low = streamer.AddTexture(file.GetFileName(), 1.0f);
+    REQUIRE(low != ~0u);
+    REQUIRE(RunUntilIdle(streamer, sink) != ~0u);
+    TextureFileInfo const& info = streamer.GetFileInfo(low);
+    REQUIRE(streamer.GetFirstMip(low) == 0);
+
+    // Room for one whole texture and another's tail
+    uint64_t budget = info.GetMipChainSize(0) + info.GetMipChainSize(2);
+    streamer.SetBudget(budget);
+    unsigned high = streamer.AddTexture(file.GetFileName(), 2.0f);
+    REQUIRE(high != ~0u);
+    for (unsigned frame = 0; frame < 100 && !streamer.IsIdle(); ++frame)
+    {
+        RunFrame(streamer, sink);
+        CHECK(streamer.GetCommittedSize() <= budget);
+
+        // Eviction never goes past the tail
+        CHECK(streamer.GetTexture(low) != nullptr);
+        CHECK(streamer.GetFirstMip(low) <= 2);
+    }
+
+    CHECK(streamer.IsIdle());
+    CHECK(streamer.GetFirstMip(high) == 0);
+    CHECK(streamer.GetFirstMip(low) == 2);
+    CHECK(streamer.GetStats().mipsEvicted_ == 2);
+    CHECK(sink.GetTextureBytes() == budget);
+}
+
+TEST(TextureStreamerTest, DoesNotEvictEqualPriority)
+{
+    TestTextureFile file("TextureStreamerTest_Equal.dds", 256);
+    NullTextureUploadSink sink(false);
+    NullUploadBufferFactory factory;
+    TextureStreamer streamer;
+    REQUIRE(streamer.Initialize(sink, factory));
+
+    unsigned first = streamer.AddTexture(file.GetFileName());
+    REQUIRE(first != ~0u);
+    REQUIRE(RunUntilIdle(streamer, sink) != ~0u);
+    TextureFileInfo const& info = streamer.GetFileInfo(first);
+
+    // The second texture fits its tail and its next mip, but not the largest one
+    uint64_t budget = info.GetMipChainSize(0) + info.GetMipChainSize(1);
+    streamer.SetBudget(budget);
+    unsigned second = streamer.AddTexture(file.GetFileName());
+    REQUIRE(second != ~0u);
+    for (unsigned frame = 0; frame < 20; ++frame)
+    {
+        RunFrame(streamer, sink);
+        CHECK(streamer.GetCommittedSize() <= budget);
+    }
+
+    CHECK(streamer.GetFirstMip(first) == 0);
+    CHECK(streamer.GetFirstMip(second) == 1);
+    CHECK(streamer.GetStats().mipsEvicted_ == 0);
+    CHECK(streamer.GetStats().overBudget_ > 0);
+
+    // Raising the priority lets it take the mips it needs from the other
+    streamer.SetPriority(second, 2.0f);
+    REQUIRE(RunUntilIdle(streamer, sink) != ~0u);
+    CHECK(streamer.GetFirstMip(second) == 0);
+    CHECK(streamer.GetFirstMip(first) == 1);
+    CHECK(streamer.GetCommittedSize() <= budget);
+}
+
+TEST(TextureStreamerTest, EvictsUnwantedMips)
+{
+    TestTextureFile file("TextureStreamerTest_Wanted.dds", 256);
+    NullTextureUploadSink sink(false);
+    NullUploadBufferFactory factory;
+    TextureStreamer streamer;
+    REQUIRE(streamer.Initialize(sink, factory));
+
+    unsigned id = streamer.AddTexture(file.GetFileName());
+    REQUIRE(id != ~0u);
+    REQUIRE(RunUntilIdle(streamer, sink) != ~0u);
+    TextureFileInfo const& info = streamer.GetFileInfo(id);
+
+    // Mips below the wanted one go, the tail stays even when not wanted
+    streamer.SetWantedMip(id, 1);
+    REQUIRE(RunUntilIdle(streamer, sink) != ~0u);
+    CHECK(streamer.GetFirstMip(id) == 1);
+    CHECK(streamer.GetCommittedSize() == info.GetMipChainSize(1));
+    CHECK(sink.GetTextureBytes() == info.GetMipChainSize(1));
+
+    streamer.SetWantedMip(id, 8);
+    REQUIRE(RunUntilIdle(streamer, sink) != ~0u);
+    CHECK(streamer.GetFirstMip(id) == 2);
+    CHECK(streamer.GetStats().mipsEvicted_ == 2);
+
+    // Wanting detail again loads it back
+    streamer.SetWantedMip(id, 0);
+    REQUIRE(RunUntilIdle(streamer, sink) != ~0u);
+    CHECK(streamer.GetFirstMip(id) == 0);
+    CHECK(sink.GetTextureCount() == 1);
+}
@@ -0,0 +1,131 @@
+#include "Test.h"
+#include "TlsfAllocator.h"
+
+#include <cstdlib>
+#include <vector>
+
+
+TEST(TlsfAllocatorTest, SplitsFreeBlock)
+{
+    TlsfAllocator allocator(1 << 20);
+    CHECK(allocator.GetFreeRegionCount() == 1);
+
+    TlsfAllocation first = allocator.Allocate(1000);
+    TlsfAllocation second = allocator.Allocate(4096);
+    REQUIRE(first.IsValid() && second.IsValid());
+    CHECK(first.offset_ == 0);
+    CHECK(first.size_ == 1024);
+    CHECK(second.offset_ == 1024);
+    CHECK(allocator.GetAllocatedSize() == 1024 + 4096);
+    CHECK(allocator.GetAllocationCount() == 2);
+    // The remainder stays one free block
+    CHECK(allocator.GetFreeRegionCount() == 1);
+    CHECK(allocator.GetLargestFreeRegion() == (1 << 20) - 1024 - 4096);
+}
+
+TEST(TlsfAllocatorTest, MergesNeighboursOnFree)
+{
+    TlsfAllocator allocator(1 << 20);
+    TlsfAllocation blocks[4];
+    for (TlsfAllocation& block : blocks)
+        block = allocator.Allocate(4096);
+
+    // Freeing every other block leaves holes that cannot merge
+    allocator.Free(blocks[0]);
+    allocator.Free(blocks[2]);
+    CHECK(!blocks[0].IsValid());
+    CHECK(allocator.GetFreeRegionCount() == 3);
+    CHECK(allocator.GetFragmentation() > 0.0f);
+
+    // The block between two free ones merges with both, and the last one with the tail
+    allocator.Free(blocks[1]);
+    CHECK(allocator.GetFreeRegionCount() == 2);
+    allocator.Free(blocks[3]);
+    CHECK(allocator.GetFreeRegionCount() == 1);
+    CHECK(allocator.IsEmpty());
+    CHECK(allocator.GetLargestFreeRegion() == allocator.GetSize());
+    CHECK(allocator.GetFragmentation() == 0.0f);
+}
+
+TEST(TlsfAllocatorTest, ReusesFreedBlock)
+{
+    TlsfAllocator allocator(1 << 20);
+    TlsfAllocation first = allocator.Allocate(8192);
+    TlsfAllocation second = allocator.Allocate(8192);
+    allocator.Free(first);
+
+    TlsfAllocation third = allocator.Allocate(8192);
+    REQUIRE(third.IsValid());
+    CHECK(third.offset_ == 0);
+    allocator.Free(second);
+    allocator.Free(third);
+    CHECK(allocator.GetFreeRegionCount() == 1);
+}
+
+TEST(TlsfAllocatorTest, HonoursAlignment)
+{
+    TlsfAllocator allocator(1 << 22);
+    TlsfAllocation small = allocator.Allocate(256);
+    TlsfAllocation aligned = allocator.Allocate(65536, 65536);
+    REQUIRE(small.IsValid() && aligned.IsValid());
+    CHECK(aligned.offset_ % 65536 == 0);
+    CHECK(aligned.offset_ >= small.offset_ + small.size_);
+
+    // The padding in front of the aligned block stays allocatable
+    TlsfAllocation padding = allocator.Allocate(1024);
+    REQUIRE(padding.IsValid());
+    CHECK(padding.offset_ < aligned.offset_);
+}
+
+TEST(TlsfAllocatorTest, FailsWhenFull)
+{
+    TlsfAllocator allocator(4096);
+    TlsfAllocation all = allocator.Allocate(4096);
+    REQUIRE(all.IsValid());
+    CHECK(!allocator.Allocate(256).IsValid());
+    CHECK(!TlsfAllocator(4096).Allocate(8192).IsValid());
+    allocator.Free(all);
+    CHECK(allocator.Allocate(4096).IsValid());
+}
+
+TEST(TlsfAllocatorTest, RandomAllocationsNeverOverlap)
+{
+    TlsfAllocator allocator(16 << 20);
+    std::vector<TlsfAllocation> live;
+    srand(1234);
+
+    for (unsigned i = 0; i < 5000; ++i)
+    {
+        if (live.empty() || rand() % 3)
+        {
+            TlsfAllocation allocation = allocator.Allocate(256 + (uint64_t) (rand() % 65536), (uint64_t) 256 << (rand() % 4));
+            if (allocation.IsValid())
+                live.push_back(allocation);
+        }
+        else
+        {
+            size_t index = (size_t) rand() % live.size();
+            allocator.Free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+
+    uint64_t allocated = 0;
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        allocated += live[i].size_;
+        CHECK(live[i].offset_ + live[i].size_ <= allocator.GetSize());
+        for (size_t j = i + 1; j < live.size(); ++j)
+        {
+            bool disjoint = live[i].offset_ + live[i].size_ <= live[j].offset_ || live[j].offset_ + live[j].size_ <= live[i].offset_;
+            REQUIRE(disjoint);
+        }
+    }
+    CHECK(allocated == allocator.GetAllocatedSize());
+
+    for (TlsfAllocation& allocation : live)
+        allocator.Free(allocation);
+    CHECK(allocator.IsEmpty());
+    CHECK(allocator.GetFreeRegionCount() == 1);
+}
@@ -0,0 +1,231 @@
+#include "Quaternion.h"
+#include "Test.h"
+#include "TransformBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+/// Items per test, not a multiple of any backend's lanes so the remainder is covered.
+static const unsigned itemCount = 101;
+/// Tolerance relative to the magnitude of the expected value.
+static const float tolerance = 1e-5f;
+
+/// Return random affine transforms.
+static std::vector<Matrix4> MakeTransforms(unsigned count, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    std::vector<Matrix4> transforms(count);
+    for (Matrix4& transform : transforms)
+    {
+        Vector3 axis = Vector3(position(random), position(random), position(random)).Normalized();
+        transform = Matrix4::FromTRS(Vector3(position(random), position(random), position(random)),
+            Quaternion::FromAxisAngle(axis, angle(random)), Vector3(scale(random), scale(random), scale(random)));
+    }
+    return transforms;
+}
+
+/// Return transforms in structure of arrays layout.
+static void CopyTransforms(std::vector<Matrix4> const& source, TransformArray& dest)
+{
+    dest.Resize((unsigned) source.size());
+    for (unsigned i = 0; i < source.size(); ++i)
+        dest.Set(i, source[i]);
+}
+
+/// Check two floats agree within the tolerance relative to the expected value.
+static bool IsNear(float actual, float expected)
+{
+    return std::fabs(actual - expected) <= tolerance * std::fmax(1.0f, std::fabs(expected));
+}
+
+/// Check two vectors agree.
+static bool IsNear(Vector3 const& actual, Vector3 const& expected)
+{
+    return IsNear(actual.x_, expected.x_) && IsNear(actual.y_, expected.y_) && IsNear(actual.z_, expected.z_);
+}
+
+/// Check two matrices agree.
+static bool IsNear(Matrix4 const& actual, Matrix4 const& expected)
+{
+    for (unsigned row = 0; row < 4; ++row)
+    {
+        float const* a = &actual.rows_[row].x_;
+        float const* e = &expected.rows_[row].x_;
+        for (unsigned col = 0; col < 4; ++col)
+        {
+            if (!IsNear(a[col], e[col]))
+                return false;
+        }
+    }
+    return true;
+}
+
+TEST(TransformBatchTest, MatrixMathMatchesDefinition)
+{
+    std::vector<Matrix4> lhs = MakeTransforms(itemCount, 1);
+    std::vector<Matrix4> rhs = MakeTransforms(itemCount, 2);
+    for (unsigned i = 0; i < itemCount; ++i)
+    {
+        // The product and point transform one float at a time, as the scalar backend computes them
+        Matrix4 expected;
+        for (unsigned row = 0; row < 4; ++row)
+        {
+            float const* a = &lhs[i].rows_[row].x_;
+            float const* b = &rhs[i].rows_[0].x_;
+            float* r = &expected.rows_[row].x_;
+            for (unsigned col = 0; col < 4; ++col)
+                r[col] = a[0] * b[col] + a[1] * b[4 + col] + a[2] * b[8 + col] + a[3] * b[12 + col];
+        }
+        CHECK(IsNear(lhs[i] * rhs[i], expected));
+
+        Vector3 point(1.0f, -2.0f, 3.0f);
+        Vector3 const& t = expected.GetTranslation();
+        Vector3 expectedPoint(point.x_ * expected.rows_[0].x_ + point.y_ * expected.rows_[1].x_ + point.z_ * expected.rows_[2].x_ + t.x_,
+            point.x_ * expected.rows_[0].y_ + point.y_ * expected.rows_[1].y_ + point.z_ * expected.rows_[2].y_ + t.y_,
+            point.x_ * expected.rows_[0].z_ + point.y_ * expected.rows_[1].z_ + point.z_ * expected.rows_[2].z_ + t.z_);
+        CHECK(IsNear(expected.TransformPoint(point), expectedPoint));
+    }
+}
+
+TEST(TransformBatchTest, MultiplyMatchesMatrix4)
+{
+    std::vector<Matrix4> lhs = MakeTransforms(itemCount, 3);
+    std::vector<Matrix4> rhs = MakeTransforms(itemCount, 4);
+    TransformArray lhsArray, rhsArray, destArray;
+    CopyTransforms(lhs, lhsArray);
+    CopyTransforms(rhs, rhsArray);
+    destArray.Resize(itemCount);
+
+    // A range starting off the lane alignment, leaving the items around it alone
+    unsigned first = 3;
+    unsigned count = itemCount - 5;
+    CopyTransforms(lhs, destArray);
+    MultiplyTransforms(lhsArray, rhsArray, destArray, first, count);
+    for (unsigned i = 0; i < itemCount; ++i)
+    {
+        bool inRange = i >= first && i < first + count;
+        CHECK(IsNear(destArray.Get(i), inRange ? lhs[i] * rhs[i] : lhs[i]));
+    }
+
+    std::vector<Matrix4> dest(itemCount);
+    MultiplyTransforms(lhs.data(), rhs.data(), dest.data(), itemCount);
+    for (unsigned i = 0; i < itemCount; ++i)
+        CHECK(IsNear(dest[i], lhs[i] * rhs[i]));
+
+    // In place
+    MultiplyTransforms(lhsArray, rhsArray, lhsArray, 0, itemCount);
+    for (unsigned i = 0; i < itemCount; ++i)
+        CHECK(IsNear(lhsArray.Get(i), lhs[i] * rhs[i]));
+}
+
+TEST(TransformBatchTest, PropagateMatchesMatrix4)
+{
+    // A few roots, every other node parented to a random earlier one
+    std::mt19937 random(5);
+    std::vector<int> parents(itemCount);
+    for (unsigned i = 0; i < itemCount; ++i)
+        parents[i] = i < 3 ? -1 : (int) (random() % i);
+
+    std::vector<unsigned> order;
+    std::vector<int> sortedParents;
+    std::vector<unsigned> levelOffsets;
+    SortTransformHierarchy(parents.data(), itemCount, order, sortedParents, levelOffsets);
+    REQUIRE(order.size() == itemCount);
+    REQUIRE(levelOffsets.size() > 2);
+    CHECK(levelOffsets.front() == 0 && levelOffsets.back() == itemCount);
+    for (unsigned i = 0; i < itemCount; ++i)
+    {
+        int parent = parents[order[i]];
+        CHECK(sortedParents[i] == (parent >= 0 ? (int) (std::find(order.begin(), order.end(), (unsigned) parent) - order.begin()) : -1));
+        CHECK(sortedParents[i] < (int) i);
+    }
+
+    // Expected world transforms walking up to the root
+    std::vector<Matrix4> local = MakeTransforms(itemCount, 6);
+    std::vector<Matrix4> expected(itemCount);
+    for (unsigned i = 0; i < itemCount; ++i)
+    {
+        expected[i] = local[i];
+        for (int parent = parents[i]; parent >= 0; parent = parents[parent])
+            expected[i] = expected[i] * local[parent];
+    }
+
+    std::vector<Matrix4> world(itemCount);
+    PropagateTransforms(local.data(), parents.data(), itemCount, world.data());
+    for (unsigned i = 0; i < itemCount; ++i)
+        CHECK(IsNear(world[i], expected[i]));
+
+    TransformArray localArray, worldArray;
+    localArray.Resize(itemCount);
+    worldArray.Resize(itemCount);
+    for (unsigned i = 0; i < itemCount; ++i)
+        localArray.Set(i, local[order[i]]);
+    PropagateTransforms(localArray, sortedParents.data(), levelOffsets.data(), (unsigned) levelOffsets.size() - 1, worldArray);
+    for (unsigned i = 0; i < itemCount; ++i)
+        CHECK(IsNear(worldArray.Get(i), expected[order[i]]));
+}
+
+TEST(TransformBatchTest, BoundsMatchMatrix4)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> value(-5.0f, 5.0f);
+    std::uniform_real_distribution<float> extent(0.1f, 5.0f);
+    std::vector<Matrix4> transforms = MakeTransforms(itemCount, 8);
+    TransformArray transformArray;
+    CopyTransforms(transforms, transformArray);
+
+    std::vector<BoundingBox> boxes(itemCount);
+    BoundsArray boxArray, boxDest;
+    boxArray.Resize(itemCount);
+    boxDest.Resize(itemCount);
+    std::vector<BoundingSphere> spheres(itemCount);
+    SphereArray sphereArray, sphereDest;
+    sphereArray.Resize(itemCount);
+    sphereDest.Resize(itemCount);
+    for (unsigned i = 0; i < itemCount; ++i)
+    {
+        boxes[i] = BoundingBox(Vector3(value(random), value(random), value(random)), Vector3(extent(random), extent(random), extent(random)));
+        boxArray.Set(i, boxes[i]);
+        spheres[i] = BoundingSphere(Vector3(value(random), value(random), value(random)), extent(random));
+        sphereArray.Set(i, spheres[i]);
+    }
+
+    // The transformed box holds the transformed corners and touches the extremes of them
+    std::vector<BoundingBox> dest(itemCount);
+    TransformBounds(boxes.data(), transforms.data(), dest.data(), itemCount);
+    TransformBounds(boxArray, transformArray, boxDest, 0, itemCount);
+    for (unsigned i = 0; i < itemCount; ++i)
+    {
+        Vector3 min = boxes[i].GetMin();
+        Vector3 max = boxes[i].GetMax();
+        BoundingBox expected;
+        for (unsigned corner = 0; corner < 8; ++corner)
+        {
+            Vector3 point = transforms[i].TransformPoint(Vector3((corner & 1) ? max.x_ : min.x_, (corner & 2) ? max.y_ : min.y_,
+                (corner & 4) ? max.z_ : min.z_));
+            expected = corner ? expected.Merged(BoundingBox(point, Vector3(0.0f, 0.0f, 0.0f))) : BoundingBox(point, Vector3(0.0f, 0.0f, 0.0f));
+        }
+        CHECK(IsNear(dest[i].center_, expected.center_));
+        CHECK(IsNear(dest[i].extents_, expected.extents_));
+
+        BoundingBox box = boxDest.Get(i);
+        CHECK(IsNear(box.center_, dest[i].center_));
+        CHECK(IsNear(box.extents_, dest[i].extents_));
+    }
+
+    TransformBounds(sphereArray, transformArray, sphereDest, 0, itemCount);
+    for (unsigned i = 0; i < itemCount; ++i)
+    {
+        BoundingSphere expected = spheres[i].Transformed(transforms[i]);
+        BoundingSphere sphere = sphereDest.Get(i);
+        CHECK(IsNear(sphere.center_, expected.center_));
+        CHECK(IsNear(sphere.radius_, expected.radius_));
+    }
+}
@@ -0,0 +1,134 @@
+#include "NullUploadBufferFactory.h"
+#include "Test.h"
+#include "UploadRing.h"
+
+
+TEST(UploadRingTest, AlignsAllocations)
+{
+    NullUploadBufferFactory factory;
+    UploadRing ring;
+    REQUIRE(ring.Initialize(factory, 4096));
+
+    UploadAllocation first = ring.Allocate(20);
+    UploadAllocation constants = ring.AllocateConstants(64);
+    UploadAllocation vertices = ring.Allocate(12, 4);
+    REQUIRE(first.IsValid() && constants.IsValid() && vertices.IsValid());
+    CHECK(first.offset_ == 0);
+    CHECK(constants.offset_ == CONSTANT_BUFFER_ALIGNMENT);
+    CHECK(constants.gpu_ % CONSTANT_BUFFER_ALIGNMENT == 0);
+    CHECK(vertices.offset_ == CONSTANT_BUFFER_ALIGNMENT + 64);
+    CHECK(constants.cpu_ == first.cpu_ + constants.offset_);
+    // Padding counts as used space
+    CHECK(ring.GetFrameSize() == CONSTANT_BUFFER_ALIGNMENT + 64 + 12);
+    CHECK(!ring.Allocate(0).IsValid());
+}
+
+TEST(UploadRingTest, CopiesUploadedData)
+{
+    NullUploadBufferFactory factory;
+    UploadRing ring;
+    REQUIRE(ring.Initialize(factory, 1024));
+
+    float const data[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    UploadAllocation allocation = ring.Upload(data, sizeof data);
+    REQUIRE(allocation.IsValid());
+    CHECK(((float*) allocation.cpu_)[3] == 4.0f);
+}
+
+TEST(UploadRingTest, ReclaimsCompletedFrames)
+{
+    NullUploadBufferFactory factory;
+    UploadRing ring;
+    REQUIRE(ring.Initialize(factory, 1024));
+
+    ring.BeginFrame(0);
+    ring.Allocate(256);
+    ring.EndFrame(1);
+    ring.BeginFrame(0);
+    ring.Allocate(256);
+    ring.EndFrame(2);
+    CHECK(ring.GetUsedSize() == 512);
+
+    // Only frames the GPU has passed give their space back
+    ring.BeginFrame(1);
+    CHECK(ring.GetUsedSize() == 256);
+    ring.EndFrame(3);
+    ring.BeginFrame(3);
+    CHECK(ring.GetUsedSize() == 0);
+    CHECK(ring.GetGrowCount() == 0);
+}
+
+TEST(UploadRingTest, WrapsAroundWithoutSplitting)
+{
+    NullUploadBufferFactory factory;
+    UploadRing ring;
+    REQUIRE(ring.Initialize(factory, 1024));
+
+    ring.BeginFrame(0);
+    ring.Allocate(768);
+    ring.EndFrame(1);
+    ring.BeginFrame(1);
+    CHECK(ring.GetUsedSize() == 0);
+
+    // The tail after 768 is too short, so the allocation starts at zero and the tail counts as used
+    UploadAllocation allocation = ring.Allocate(512);
+    REQUIRE(allocation.IsValid());
+    CHECK(allocation.offset_ == 0);
+    CHECK(ring.GetUsedSize() == 256 + 512);
+    CHECK(ring.GetGrowCount() == 0);
+    ring.EndFrame(2);
+}
+
+TEST(UploadRingTest, NeverOverwritesFramesInFlight)
+{
+    NullUploadBufferFactory factory;
+    UploadRing ring;
+    REQUIRE(ring.Initialize(factory, 1024));
+
+    ring.BeginFrame(0);
+    UploadAllocation first = ring.Allocate(512);
+    ring.EndFrame(1);
+    ring.BeginFrame(0);
+    UploadAllocation second = ring.Allocate(256);
+    REQUIRE(first.IsValid() && second.IsValid());
+    CHECK(second.offset_ >= first.offset_ + first.size_);
+    ring.EndFrame(2);
+
+    // The first frame is still in flight, so filling the ring must not wrap onto it
+    ring.BeginFrame(0);
+    UploadAllocation third = ring.Allocate(512);
+    REQUIRE(third.IsValid());
+    CHECK(third.resource_ != first.resource_);
+    CHECK(ring.GetGrowCount() == 1);
+    ring.EndFrame(3);
+}
+
+TEST(UploadRingTest, GrowsAndRetiresOldBuffer)
+{
+    NullUploadBufferFactory factory;
+    UploadRing ring;
+    REQUIRE(ring.Initialize(factory, 256));
+
+    ring.BeginFrame(0);
+    UploadAllocation small = ring.Allocate(128);
+    UploadAllocation large = ring.Allocate(1000);
+    REQUIRE(small.IsValid() && large.IsValid());
+    CHECK(large.resource_ != small.resource_);
+    CHECK(ring.GetSize() >= 1000);
+    CHECK(ring.GetGrowCount() == 1);
+    CHECK(ring.GetRetiredBufferCount() == 1);
+    CHECK(factory.GetBufferCount() == 2);
+    ring.EndFrame(1);
+
+    // The old buffer lives until the frame that last used it completes
+    ring.BeginFrame(0);
+    CHECK(factory.GetBufferCount() == 2);
+    ring.EndFrame(2);
+    ring.BeginFrame(1);
+    CHECK(ring.GetRetiredBufferCount() == 0);
+    CHECK(factory.GetBufferCount() == 1);
+    CHECK(factory.GetBufferBytes() == ring.GetSize());
+
+    ring.Shutdown();
+    CHECK(factory.GetBufferCount() == 0);
+}
@@ -48,12 +48,55 @@ macro (check_source_files)
     endif ()
 endmacro ()
 
+# Macro for setting the include directories and instruction set of a target
+macro (setup_compile_options)
+    if (MATH_SIMD STREQUAL AVX2)
+        if (MSVC)
+            target_compile_options (${TARGET_NAME} PRIVATE /arch:AVX2)
+        else ()
+            target_compile_options (${TARGET_NAME} PRIVATE -mavx2 -mfma)
+        endif ()
+    elseif (MATH_SIMD STREQUAL AVX)
+        if (MSVC)
+            target_compile_options (${TARGET_NAME} PRIVATE /arch:AVX)
+        else ()
+            target_compile_options (${TARGET_NAME} PRIVATE -mavx)
+        endif ()
+    endif ()
+
+    if (NOT MSVC)
+        target_compile_options (${TARGET_NAME} PRIVATE -Wall -Wextra)
+    endif ()
+endmacro ()
+
+# Macro for setting up a static library whose include directories carry over to the targets linking it
+macro (setup_library)
+    check_source_files ()
+    add_library (${TARGET_NAME} STATIC ${SOURCE_FILES})
+
+    target_include_directories (${TARGET_NAME} PUBLIC ${INCLUDE_DIRS})
+    setup_compile_options ()
+
+    find_package (Threads REQUIRED)
+    target_link_libraries (${TARGET_NAME} PUBLIC Threads::Threads ${LIBS})
+endmacro ()
+
+# Macro for setting up an executable, a windowed one on Windows unless CONSOLE is given
 macro (setup_executable)
+    cmake_parse_arguments (ARG "CONSOLE" "" "" ${ARGN})
     check_source_files ()
-    add_executable (${TARGET_NAME} WIN32  ${SOURCE_FILES})
+    if (ARG_CONSOLE)
+        add_executable (${TARGET_NAME} ${SOURCE_FILES})
+    else ()
+        add_executable (${TARGET_NAME} WIN32  ${SOURCE_FILES})
+    endif ()
 
     include_directories (${INCLUDE_DIRS})
+    setup_compile_options ()
 
-    set (D3D12_LIBS d3dcompiler d3d12 dxgi dxguid)
+    # Only Windows has Direct3D12, elsewhere the executable runs headless on the null backend
+    if (WIN32)
+        set (D3D12_LIBS d3dcompiler d3d12 dxgi dxguid)
+    endif ()
     target_link_libraries (${TARGET_NAME} ${D3D12_LIBS} ${LIBS})
 endmacro()